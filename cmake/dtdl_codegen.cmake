@@ -0,0 +1,61 @@
+# Copyright (c) Microsoft Corporation. All rights reserved.
+# SPDX-License-Identifier: MIT
+
+# Generates C serializers from DTDL models, see tools/dtdl_codegen.py.
+#
+# The generated sources are added to the INTERFACE IMPORTED sample targets,
+# which are built by executables defined in the board directories. Outputs
+# of add_custom_command are only known to the directory declaring them, so
+# the generator runs while configuring instead, and the model and the
+# generator are configure dependencies: editing either regenerates the code
+# on the next build.
+#
+# Toolchains without Python build the serializers committed under
+# demos/common/models/generated/<model name>. Regenerate them after editing a
+# model or the generator with:
+#   python3 tools/dtdl_codegen.py demos/common/models/<model>.json demos/common/models/generated/<model>
+
+if(NOT Python3_EXECUTABLE)
+    find_package(Python3 COMPONENTS Interpreter)
+endif()
+
+set(DTDL_CODEGEN_SCRIPT ${CMAKE_CURRENT_LIST_DIR}/../tools/dtdl_codegen.py)
+set(DTDL_GENERATED_DIR ${CMAKE_CURRENT_LIST_DIR}/../demos/common/models/generated)
+
+# dtdl_generate(<model> <output directory> <sources variable>)
+#
+# Generates the serializers of <model> in <output directory>, which holds
+# the generated header, and appends the generated source to <sources variable>.
+function(dtdl_generate MODEL OUTPUT_DIR SOURCES_VAR)
+    if(NOT Python3_EXECUTABLE)
+        get_filename_component(DTDL_MODEL_NAME ${MODEL} NAME_WE)
+        set(DTDL_COMMITTED_DIR ${DTDL_GENERATED_DIR}/${DTDL_MODEL_NAME})
+
+        if(NOT EXISTS ${DTDL_COMMITTED_DIR})
+            message(FATAL_ERROR "Python is needed to generate the serializers of ${MODEL}.")
+        endif()
+
+        message(STATUS "Python not found, using the serializers committed in ${DTDL_COMMITTED_DIR}.")
+        file(GLOB DTDL_COMMITTED_FILES ${DTDL_COMMITTED_DIR}/*.c ${DTDL_COMMITTED_DIR}/*.h)
+        file(COPY ${DTDL_COMMITTED_FILES} DESTINATION ${OUTPUT_DIR})
+        file(GLOB DTDL_SOURCE ${DTDL_COMMITTED_DIR}/*.c)
+        get_filename_component(DTDL_SOURCE ${DTDL_SOURCE} NAME)
+
+        set(${SOURCES_VAR} ${${SOURCES_VAR}} ${OUTPUT_DIR}/${DTDL_SOURCE} PARENT_SCOPE)
+        return()
+    endif()
+
+    execute_process(
+        COMMAND ${Python3_EXECUTABLE} ${DTDL_CODEGEN_SCRIPT} ${MODEL} ${OUTPUT_DIR}
+        RESULT_VARIABLE DTDL_RESULT
+        OUTPUT_VARIABLE DTDL_SOURCE
+        OUTPUT_STRIP_TRAILING_WHITESPACE)
+
+    if(NOT DTDL_RESULT EQUAL 0)
+        message(FATAL_ERROR "Generating the serializers of ${MODEL} failed.")
+    endif()
+
+    set_property(DIRECTORY APPEND PROPERTY CMAKE_CONFIGURE_DEPENDS ${MODEL} ${DTDL_CODEGEN_SCRIPT})
+
+    set(${SOURCES_VAR} ${${SOURCES_VAR}} ${DTDL_SOURCE} PARENT_SCOPE)
+endfunction()
@@ -0,0 +1,104 @@
+/* Copyright (c) Microsoft Corporation.
+ * Licensed under the MIT License. */
+
+/* Generated by tools/dtdl_codegen.py from deviceinformation-1.json, do not edit. */
+
+#include "device_information_model.h"
+
+/*-----------------------------------------------------------*/
+
+AzureIoTResult_t DeviceInformation_AppendReportedProperties( AzureIoTJSONWriter_t * pxWriter,
+                                                             const DeviceInformationReportedProperties_t * pxProperties )
+{
+    AzureIoTResult_t xResult;
+
+    if( ( pxProperties->ulManufacturerLength > deviceinformationSTRING_MAX_LENGTH ) ||
+        ( pxProperties->ulModelLength > deviceinformationSTRING_MAX_LENGTH ) ||
+        ( pxProperties->ulSwVersionLength > deviceinformationSTRING_MAX_LENGTH ) ||
+        ( pxProperties->ulOsNameLength > deviceinformationSTRING_MAX_LENGTH ) ||
+        ( pxProperties->ulProcessorArchitectureLength > deviceinformationSTRING_MAX_LENGTH ) ||
+        ( pxProperties->ulProcessorManufacturerLength > deviceinformationSTRING_MAX_LENGTH ) )
+    {
+        return eAzureIoTErrorInvalidArgument;
+    }
+
+    xResult = AzureIoTJSONWriter_AppendPropertyName( pxWriter, ( const uint8_t * ) deviceinformationMANUFACTURER_NAME, sizeof( deviceinformationMANUFACTURER_NAME ) - 1 );
+
+    if( xResult == eAzureIoTSuccess )
+    {
+        xResult = AzureIoTJSONWriter_AppendString( pxWriter, pxProperties->pucManufacturer, pxProperties->ulManufacturerLength );
+    }
+
+    if( xResult == eAzureIoTSuccess )
+    {
+        xResult = AzureIoTJSONWriter_AppendPropertyName( pxWriter, ( const uint8_t * ) deviceinformationMODEL_NAME, sizeof( deviceinformationMODEL_NAME ) - 1 );
+    }
+
+    if( xResult == eAzureIoTSuccess )
+    {
+        xResult = AzureIoTJSONWriter_AppendString( pxWriter, pxProperties->pucModel, pxProperties->ulModelLength );
+    }
+
+    if( xResult == eAzureIoTSuccess )
+    {
+        xResult = AzureIoTJSONWriter_AppendPropertyName( pxWriter, ( const uint8_t * ) deviceinformationSW_VERSION_NAME, sizeof( deviceinformationSW_VERSION_NAME ) - 1 );
+    }
+
+    if( xResult == eAzureIoTSuccess )
+    {
+        xResult = AzureIoTJSONWriter_AppendString( pxWriter, pxProperties->pucSwVersion, pxProperties->ulSwVersionLength );
+    }
+
+    if( xResult == eAzureIoTSuccess )
+    {
+        xResult = AzureIoTJSONWriter_AppendPropertyName( pxWriter, ( const uint8_t * ) deviceinformationOS_NAME_NAME, sizeof( deviceinformationOS_NAME_NAME ) - 1 );
+    }
+
+    if( xResult == eAzureIoTSuccess )
+    {
+        xResult = AzureIoTJSONWriter_AppendString( pxWriter, pxProperties->pucOsName, pxProperties->ulOsNameLength );
+    }
+
+    if( xResult == eAzureIoTSuccess )
+    {
+        xResult = AzureIoTJSONWriter_AppendPropertyName( pxWriter, ( const uint8_t * ) deviceinformationPROCESSOR_ARCHITECTURE_NAME, sizeof( deviceinformationPROCESSOR_ARCHITECTURE_NAME ) - 1 );
+    }
+
+    if( xResult == eAzureIoTSuccess )
+    {
+        xResult = AzureIoTJSONWriter_AppendString( pxWriter, pxProperties->pucProcessorArchitecture, pxProperties->ulProcessorArchitectureLength );
+    }
+
+    if( xResult == eAzureIoTSuccess )
+    {
+        xResult = AzureIoTJSONWriter_AppendPropertyName( pxWriter, ( const uint8_t * ) deviceinformationPROCESSOR_MANUFACTURER_NAME, sizeof( deviceinformationPROCESSOR_MANUFACTURER_NAME ) - 1 );
+    }
+
+    if( xResult == eAzureIoTSuccess )
+    {
+        xResult = AzureIoTJSONWriter_AppendString( pxWriter, pxProperties->pucProcessorManufacturer, pxProperties->ulProcessorManufacturerLength );
+    }
+
+    if( xResult == eAzureIoTSuccess )
+    {
+        xResult = AzureIoTJSONWriter_AppendPropertyName( pxWriter, ( const uint8_t * ) deviceinformationTOTAL_STORAGE_NAME, sizeof( deviceinformationTOTAL_STORAGE_NAME ) - 1 );
+    }
+
+    if( xResult == eAzureIoTSuccess )
+    {
+        xResult = AzureIoTJSONWriter_AppendDouble( pxWriter, pxProperties->xTotalStorage, deviceinformationDOUBLE_FRACTIONAL_DIGITS );
+    }
+
+    if( xResult == eAzureIoTSuccess )
+    {
+        xResult = AzureIoTJSONWriter_AppendPropertyName( pxWriter, ( const uint8_t * ) deviceinformationTOTAL_MEMORY_NAME, sizeof( deviceinformationTOTAL_MEMORY_NAME ) - 1 );
+    }
+
+    if( xResult == eAzureIoTSuccess )
+    {
+        xResult = AzureIoTJSONWriter_AppendDouble( pxWriter, pxProperties->xTotalMemory, deviceinformationDOUBLE_FRACTIONAL_DIGITS );
+    }
+
+    return xResult;
+}
+/*-----------------------------------------------------------*/
@@ -0,0 +1,87 @@
+/* Copyright (c) Microsoft Corporation.
+ * Licensed under the MIT License. */
+
+/**
+ * @file device_information_model.h
+ * @brief Serializers of dtmi:azure:DeviceManagement:DeviceInformation;1.
+ *
+ * Generated by tools/dtdl_codegen.py from deviceinformation-1.json, do not edit.
+ */
+
+#ifndef DEVICE_INFORMATION_MODEL_H
+#define DEVICE_INFORMATION_MODEL_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "azure_iot_json_reader.h"
+#include "azure_iot_json_writer.h"
+
+/**
+ * @brief Model id of the interface.
+ */
+#define deviceinformationMODEL_ID                               "dtmi:azure:DeviceManagement:DeviceInformation;1"
+
+/**
+ * @brief Longest string value, without the escaping.
+ */
+#ifndef deviceinformationSTRING_MAX_LENGTH
+    #define deviceinformationSTRING_MAX_LENGTH                      ( 64U )
+#endif
+
+/**
+ * @brief Digits after the decimal point of double values.
+ */
+#ifndef deviceinformationDOUBLE_FRACTIONAL_DIGITS
+    #define deviceinformationDOUBLE_FRACTIONAL_DIGITS               ( 2U )
+#endif
+
+/**
+ * @brief Names of the telemetry, properties and commands.
+ */
+#define deviceinformationMANUFACTURER_NAME                      "manufacturer"
+#define deviceinformationMODEL_NAME                             "model"
+#define deviceinformationSW_VERSION_NAME                        "swVersion"
+#define deviceinformationOS_NAME_NAME                           "osName"
+#define deviceinformationPROCESSOR_ARCHITECTURE_NAME            "processorArchitecture"
+#define deviceinformationPROCESSOR_MANUFACTURER_NAME            "processorManufacturer"
+#define deviceinformationTOTAL_STORAGE_NAME                     "totalStorage"
+#define deviceinformationTOTAL_MEMORY_NAME                      "totalMemory"
+
+/**
+ * @brief Read-only properties of the interface.
+ */
+typedef struct DeviceInformationReportedProperties
+{
+    const uint8_t * pucManufacturer;
+    uint32_t ulManufacturerLength;
+    const uint8_t * pucModel;
+    uint32_t ulModelLength;
+    const uint8_t * pucSwVersion;
+    uint32_t ulSwVersionLength;
+    const uint8_t * pucOsName;
+    uint32_t ulOsNameLength;
+    const uint8_t * pucProcessorArchitecture;
+    uint32_t ulProcessorArchitectureLength;
+    const uint8_t * pucProcessorManufacturer;
+    uint32_t ulProcessorManufacturerLength;
+    double xTotalStorage;
+    double xTotalMemory;
+} DeviceInformationReportedProperties_t;
+
+/**
+ * @brief Space the reported properties take in a document, at most.
+ */
+#define deviceinformationREPORTED_PROPERTIES_MAX_LENGTH         ( 662U + 6 * ( 6 * deviceinformationSTRING_MAX_LENGTH + 2U ) )
+
+/**
+ * @brief Append the read-only properties to the object, or component, open in a writer.
+ *
+ * @param[in] pxWriter The writer.
+ * @param[in] pxProperties The properties.
+ * @return An #AzureIoTResult_t with the result of the operation.
+ */
+AzureIoTResult_t DeviceInformation_AppendReportedProperties( AzureIoTJSONWriter_t * pxWriter,
+                                                             const DeviceInformationReportedProperties_t * pxProperties );
+
+#endif /* DEVICE_INFORMATION_MODEL_H */
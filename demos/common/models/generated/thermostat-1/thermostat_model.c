@@ -0,0 +1,177 @@
+/* Copyright (c) Microsoft Corporation.
+ * Licensed under the MIT License. */
+
+/* Generated by tools/dtdl_codegen.py from thermostat-1.json, do not edit. */
+
+#include "thermostat_model.h"
+
+/*-----------------------------------------------------------*/
+
+AzureIoTResult_t Thermostat_SerializeTelemetry( const ThermostatTelemetry_t * pxTelemetry,
+                                                uint8_t * pucBuffer,
+                                                uint32_t ulBufferSize,
+                                                uint32_t * pulLength )
+{
+    AzureIoTResult_t xResult;
+    AzureIoTJSONWriter_t xWriter;
+    AzureIoTJSONWriter_t * pxWriter = &xWriter;
+
+    xResult = AzureIoTJSONWriter_Init( pxWriter, pucBuffer, ulBufferSize );
+
+    if( xResult == eAzureIoTSuccess )
+    {
+        xResult = AzureIoTJSONWriter_AppendBeginObject( pxWriter );
+    }
+
+    if( xResult == eAzureIoTSuccess )
+    {
+        xResult = AzureIoTJSONWriter_AppendPropertyName( pxWriter, ( const uint8_t * ) thermostatTEMPERATURE_NAME, sizeof( thermostatTEMPERATURE_NAME ) - 1 );
+    }
+
+    if( xResult == eAzureIoTSuccess )
+    {
+        xResult = AzureIoTJSONWriter_AppendDouble( pxWriter, pxTelemetry->xTemperature, thermostatDOUBLE_FRACTIONAL_DIGITS );
+    }
+
+    if( xResult == eAzureIoTSuccess )
+    {
+        xResult = AzureIoTJSONWriter_AppendEndObject( pxWriter );
+    }
+
+    if( xResult == eAzureIoTSuccess )
+    {
+        *pulLength = ( uint32_t ) AzureIoTJSONWriter_GetBytesUsed( pxWriter );
+    }
+
+    return xResult;
+}
+/*-----------------------------------------------------------*/
+
+AzureIoTResult_t Thermostat_AppendReportedProperties( AzureIoTJSONWriter_t * pxWriter,
+                                                      const ThermostatReportedProperties_t * pxProperties )
+{
+    AzureIoTResult_t xResult;
+
+    xResult = AzureIoTJSONWriter_AppendPropertyName( pxWriter, ( const uint8_t * ) thermostatMAX_TEMP_SINCE_LAST_REBOOT_NAME, sizeof( thermostatMAX_TEMP_SINCE_LAST_REBOOT_NAME ) - 1 );
+
+    if( xResult == eAzureIoTSuccess )
+    {
+        xResult = AzureIoTJSONWriter_AppendDouble( pxWriter, pxProperties->xMaxTempSinceLastReboot, thermostatDOUBLE_FRACTIONAL_DIGITS );
+    }
+
+    return xResult;
+}
+/*-----------------------------------------------------------*/
+
+AzureIoTResult_t Thermostat_ParseWritableProperty( AzureIoTJSONReader_t * pxReader,
+                                                   ThermostatWritableProperties_t * pxProperties,
+                                                   uint32_t * pulFlags )
+{
+    AzureIoTResult_t xResult;
+
+    if( AzureIoTJSONReader_TokenIsTextEqual( pxReader, ( const uint8_t * ) thermostatTARGET_TEMPERATURE_NAME, sizeof( thermostatTARGET_TEMPERATURE_NAME ) - 1 ) )
+    {
+        xResult = AzureIoTJSONReader_NextToken( pxReader );
+
+        if( xResult == eAzureIoTSuccess )
+        {
+            xResult = AzureIoTJSONReader_GetTokenDouble( pxReader, &pxProperties->xTargetTemperature );
+        }
+
+        if( xResult == eAzureIoTSuccess )
+        {
+            *pulFlags |= thermostatTARGET_TEMPERATURE_FLAG;
+        }
+
+        return xResult;
+    }
+
+    return eAzureIoTErrorItemNotFound;
+}
+/*-----------------------------------------------------------*/
+
+AzureIoTResult_t Thermostat_SerializeGetMaxMinReportResponse( const ThermostatGetMaxMinReportResponse_t * pxResponse,
+                                                              uint8_t * pucBuffer,
+                                                              uint32_t ulBufferSize,
+                                                              uint32_t * pulLength )
+{
+    AzureIoTResult_t xResult;
+    AzureIoTJSONWriter_t xWriter;
+    AzureIoTJSONWriter_t * pxWriter = &xWriter;
+
+    if( ( pxResponse->ulStartTimeLength > thermostatSTRING_MAX_LENGTH ) ||
+        ( pxResponse->ulEndTimeLength > thermostatSTRING_MAX_LENGTH ) )
+    {
+        return eAzureIoTErrorInvalidArgument;
+    }
+
+    xResult = AzureIoTJSONWriter_Init( pxWriter, pucBuffer, ulBufferSize );
+
+    if( xResult == eAzureIoTSuccess )
+    {
+        xResult = AzureIoTJSONWriter_AppendBeginObject( pxWriter );
+    }
+
+    if( xResult == eAzureIoTSuccess )
+    {
+        xResult = AzureIoTJSONWriter_AppendPropertyName( pxWriter, ( const uint8_t * ) thermostatGET_MAX_MIN_REPORT_MAX_TEMP_NAME, sizeof( thermostatGET_MAX_MIN_REPORT_MAX_TEMP_NAME ) - 1 );
+    }
+
+    if( xResult == eAzureIoTSuccess )
+    {
+        xResult = AzureIoTJSONWriter_AppendDouble( pxWriter, pxResponse->xMaxTemp, thermostatDOUBLE_FRACTIONAL_DIGITS );
+    }
+
+    if( xResult == eAzureIoTSuccess )
+    {
+        xResult = AzureIoTJSONWriter_AppendPropertyName( pxWriter, ( const uint8_t * ) thermostatGET_MAX_MIN_REPORT_MIN_TEMP_NAME, sizeof( thermostatGET_MAX_MIN_REPORT_MIN_TEMP_NAME ) - 1 );
+    }
+
+    if( xResult == eAzureIoTSuccess )
+    {
+        xResult = AzureIoTJSONWriter_AppendDouble( pxWriter, pxResponse->xMinTemp, thermostatDOUBLE_FRACTIONAL_DIGITS );
+    }
+
+    if( xResult == eAzureIoTSuccess )
+    {
+        xResult = AzureIoTJSONWriter_AppendPropertyName( pxWriter, ( const uint8_t * ) thermostatGET_MAX_MIN_REPORT_AVG_TEMP_NAME, sizeof( thermostatGET_MAX_MIN_REPORT_AVG_TEMP_NAME ) - 1 );
+    }
+
+    if( xResult == eAzureIoTSuccess )
+    {
+        xResult = AzureIoTJSONWriter_AppendDouble( pxWriter, pxResponse->xAvgTemp, thermostatDOUBLE_FRACTIONAL_DIGITS );
+    }
+
+    if( xResult == eAzureIoTSuccess )
+    {
+        xResult = AzureIoTJSONWriter_AppendPropertyName( pxWriter, ( const uint8_t * ) thermostatGET_MAX_MIN_REPORT_START_TIME_NAME, sizeof( thermostatGET_MAX_MIN_REPORT_START_TIME_NAME ) - 1 );
+    }
+
+    if( xResult == eAzureIoTSuccess )
+    {
+        xResult = AzureIoTJSONWriter_AppendString( pxWriter, pxResponse->pucStartTime, pxResponse->ulStartTimeLength );
+    }
+
+    if( xResult == eAzureIoTSuccess )
+    {
+        xResult = AzureIoTJSONWriter_AppendPropertyName( pxWriter, ( const uint8_t * ) thermostatGET_MAX_MIN_REPORT_END_TIME_NAME, sizeof( thermostatGET_MAX_MIN_REPORT_END_TIME_NAME ) - 1 );
+    }
+
+    if( xResult == eAzureIoTSuccess )
+    {
+        xResult = AzureIoTJSONWriter_AppendString( pxWriter, pxResponse->pucEndTime, pxResponse->ulEndTimeLength );
+    }
+
+    if( xResult == eAzureIoTSuccess )
+    {
+        xResult = AzureIoTJSONWriter_AppendEndObject( pxWriter );
+    }
+
+    if( xResult == eAzureIoTSuccess )
+    {
+        *pulLength = ( uint32_t ) AzureIoTJSONWriter_GetBytesUsed( pxWriter );
+    }
+
+    return xResult;
+}
+/*-----------------------------------------------------------*/
@@ -0,0 +1,164 @@
+/* Copyright (c) Microsoft Corporation.
+ * Licensed under the MIT License. */
+
+/**
+ * @file thermostat_model.h
+ * @brief Serializers of dtmi:com:example:Thermostat;1.
+ *
+ * Generated by tools/dtdl_codegen.py from thermostat-1.json, do not edit.
+ */
+
+#ifndef THERMOSTAT_MODEL_H
+#define THERMOSTAT_MODEL_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "azure_iot_json_reader.h"
+#include "azure_iot_json_writer.h"
+
+/**
+ * @brief Model id of the interface.
+ */
+#define thermostatMODEL_ID                                      "dtmi:com:example:Thermostat;1"
+
+/**
+ * @brief Longest string value, without the escaping.
+ */
+#ifndef thermostatSTRING_MAX_LENGTH
+    #define thermostatSTRING_MAX_LENGTH                             ( 64U )
+#endif
+
+/**
+ * @brief Digits after the decimal point of double values.
+ */
+#ifndef thermostatDOUBLE_FRACTIONAL_DIGITS
+    #define thermostatDOUBLE_FRACTIONAL_DIGITS                      ( 2U )
+#endif
+
+/**
+ * @brief Names of the telemetry, properties and commands.
+ */
+#define thermostatTEMPERATURE_NAME                              "temperature"
+#define thermostatMAX_TEMP_SINCE_LAST_REBOOT_NAME               "maxTempSinceLastReboot"
+#define thermostatTARGET_TEMPERATURE_NAME                       "targetTemperature"
+#define thermostatGET_MAX_MIN_REPORT_NAME                       "getMaxMinReport"
+#define thermostatGET_MAX_MIN_REPORT_MAX_TEMP_NAME              "maxTemp"
+#define thermostatGET_MAX_MIN_REPORT_MIN_TEMP_NAME              "minTemp"
+#define thermostatGET_MAX_MIN_REPORT_AVG_TEMP_NAME              "avgTemp"
+#define thermostatGET_MAX_MIN_REPORT_START_TIME_NAME            "startTime"
+#define thermostatGET_MAX_MIN_REPORT_END_TIME_NAME              "endTime"
+
+/**
+ * @brief Telemetry of the interface, sent in one message.
+ */
+typedef struct ThermostatTelemetry
+{
+    double xTemperature;
+} ThermostatTelemetry_t;
+
+/**
+ * @brief Size of a buffer always large enough for the telemetry message.
+ */
+#define thermostatTELEMETRY_MAX_LENGTH                          ( 96U )
+
+/**
+ * @brief Read-only properties of the interface.
+ */
+typedef struct ThermostatReportedProperties
+{
+    double xMaxTempSinceLastReboot;
+} ThermostatReportedProperties_t;
+
+/**
+ * @brief Space the reported properties take in a document, at most.
+ */
+#define thermostatREPORTED_PROPERTIES_MAX_LENGTH                ( 160U )
+
+/**
+ * @brief Writable properties of the interface.
+ */
+typedef struct ThermostatWritableProperties
+{
+    double xTargetTemperature;
+} ThermostatWritableProperties_t;
+
+/**
+ * @brief Flags of the writable properties, set by Thermostat_ParseWritableProperty().
+ */
+#define thermostatTARGET_TEMPERATURE_FLAG                       ( 1U << 0 )
+
+/**
+ * @brief Response payload of the getMaxMinReport command.
+ */
+typedef struct ThermostatGetMaxMinReportResponse
+{
+    double xMaxTemp;
+    double xMinTemp;
+    double xAvgTemp;
+    const uint8_t * pucStartTime;
+    uint32_t ulStartTimeLength;
+    const uint8_t * pucEndTime;
+    uint32_t ulEndTimeLength;
+} ThermostatGetMaxMinReportResponse_t;
+
+/**
+ * @brief Size of a buffer always large enough for the getMaxMinReport response.
+ */
+#define thermostatGET_MAX_MIN_REPORT_RESPONSE_MAX_LENGTH        ( 316U + 2 * ( 6 * thermostatSTRING_MAX_LENGTH + 2U ) )
+
+/**
+ * @brief Write the telemetry message.
+ *
+ * @param[in] pxTelemetry The telemetry.
+ * @param[out] pucBuffer Buffer receiving the message, #thermostatTELEMETRY_MAX_LENGTH long
+ *             is always enough.
+ * @param[in] ulBufferSize Size of @p pucBuffer.
+ * @param[out] pulLength Length of the message.
+ * @return An #AzureIoTResult_t with the result of the operation.
+ */
+AzureIoTResult_t Thermostat_SerializeTelemetry( const ThermostatTelemetry_t * pxTelemetry,
+                                                uint8_t * pucBuffer,
+                                                uint32_t ulBufferSize,
+                                                uint32_t * pulLength );
+
+/**
+ * @brief Append the read-only properties to the object, or component, open in a writer.
+ *
+ * @param[in] pxWriter The writer.
+ * @param[in] pxProperties The properties.
+ * @return An #AzureIoTResult_t with the result of the operation.
+ */
+AzureIoTResult_t Thermostat_AppendReportedProperties( AzureIoTJSONWriter_t * pxWriter,
+                                                      const ThermostatReportedProperties_t * pxProperties );
+
+/**
+ * @brief Read the value of a writable property.
+ *
+ * @param[in] pxReader Reader on the property name, left on the value when it is read.
+ * @param[out] pxProperties The properties, only the one read is written.
+ * @param[in,out] pulFlags The flag of the property read is set.
+ * @return An #AzureIoTResult_t with the result of the operation.
+ *         - `eAzureIoTErrorItemNotFound` if the name is not a writable property
+ *           of the interface, the reader is left on the name.
+ */
+AzureIoTResult_t Thermostat_ParseWritableProperty( AzureIoTJSONReader_t * pxReader,
+                                                   ThermostatWritableProperties_t * pxProperties,
+                                                   uint32_t * pulFlags );
+
+/**
+ * @brief Write the response payload of the getMaxMinReport command.
+ *
+ * @param[in] pxResponse The response.
+ * @param[out] pucBuffer Buffer receiving the payload, #thermostatGET_MAX_MIN_REPORT_RESPONSE_MAX_LENGTH
+ *             long is always enough.
+ * @param[in] ulBufferSize Size of @p pucBuffer.
+ * @param[out] pulLength Length of the payload.
+ * @return An #AzureIoTResult_t with the result of the operation.
+ */
+AzureIoTResult_t Thermostat_SerializeGetMaxMinReportResponse( const ThermostatGetMaxMinReportResponse_t * pxResponse,
+                                                              uint8_t * pucBuffer,
+                                                              uint32_t ulBufferSize,
+                                                              uint32_t * pulLength );
+
+#endif /* THERMOSTAT_MODEL_H */
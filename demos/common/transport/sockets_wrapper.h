@@ -88,6 +88,27 @@ BaseType_t Sockets_Connect( SocketHandle xSocket,
                             const char * pcHostName,
                             uint16_t usPort );
 
+/**
+ * @brief Connect the socket to hostname and port within a timeout, and measure
+ * the time the connection took, without the name resolution.
+ *
+ * The socket is left connected on success, and its timeouts are changed.
+ * The Inventek WiFi module of the ST boards connects within its own timeout.
+ *
+ * @param[in] xSocket The #SocketHandle used for this call.
+ * @param[in] pcHostName `NULL` terminated hostname
+ * @param[in] usPort Connecting port.
+ * @param[in] ulTimeoutMs Longest wait for the connection, once the hostname is resolved, at least 1.
+ * @param[out] pulConnectTimeMs Time the connection took, in milliseconds.
+ * @return A #BaseType_t with the result of the operation.
+ *        - On success returns SOCKETS_ERROR_NONE
+ */
+BaseType_t Sockets_Probe( SocketHandle xSocket,
+                          const char * pcHostName,
+                          uint16_t usPort,
+                          uint32_t ulTimeoutMs,
+                          uint32_t * pulConnectTimeMs );
+
 /**
  * @brief Disconnect socket handle.
  *
@@ -109,6 +130,24 @@ BaseType_t Sockets_Recv( SocketHandle xSocket,
                          uint8_t * pucReceiveBuffer,
                          size_t xReceiveBufferLength );
 
+/**
+ * @brief Wait until data can be received from socket handle.
+ *
+ * Where the platform cannot wait without receiving, this returns 1 at once
+ * and the receive timeout of Sockets_Recv() does the waiting: the STM32L475
+ * WiFi module port always returns 1, as does FreeRTOS+TCP built without
+ * `ipconfigSUPPORT_SELECT_FUNCTION`.
+ *
+ * @param[in] xSocket The #SocketHandle used for this call.
+ * @param[in] ulTimeoutMs Longest wait, in milliseconds.
+ * @return A #BaseType_t with the result of the operation.
+ *        - 1 if data can be received, or if the platform cannot tell.
+ *        - 0 if the wait timed out.
+ *        - On failure returns negative error code.
+ */
+BaseType_t Sockets_WaitForData( SocketHandle xSocket,
+                                uint32_t ulTimeoutMs );
+
 /**
  * @brief Send data to socket handle.
  *
@@ -13,6 +13,7 @@
 
 /* FreeRTOS includes. */
 #include "FreeRTOS.h"
+#include "task.h"
 
 /* FreeRTOS+TCP includes. */
 #include "FreeRTOS_IP.h"
@@ -98,6 +99,48 @@ BaseType_t Sockets_Connect( SocketHandle xSocket,
 }
 /*-----------------------------------------------------------*/
 
+BaseType_t Sockets_Probe( SocketHandle xSocket,
+                          const char * pcHostName,
+                          uint16_t usPort,
+                          uint32_t ulTimeoutMs,
+                          uint32_t * pulConnectTimeMs )
+{
+    Socket_t xTcpSocket = ( Socket_t ) xSocket;
+    struct freertos_sockaddr xServerAddress = { 0 };
+    TickType_t xTimeout = pdMS_TO_TICKS( ulTimeoutMs );
+    TickType_t xStart;
+    uint32_t ulIPAddres;
+
+    if( ( ulIPAddres = ( uint32_t ) FreeRTOS_gethostbyname( pcHostName ) ) == 0 )
+    {
+        return SOCKETS_SOCKET_ERROR;
+    }
+
+    /* FreeRTOS_connect() waits for the handshake as long as the receive timeout. */
+    if( ( FreeRTOS_setsockopt( xTcpSocket, 0, FREERTOS_SO_RCVTIMEO, &xTimeout, sizeof( xTimeout ) ) != 0 ) ||
+        ( FreeRTOS_setsockopt( xTcpSocket, 0, FREERTOS_SO_SNDTIMEO, &xTimeout, sizeof( xTimeout ) ) != 0 ) )
+    {
+        return SOCKETS_EINVAL;
+    }
+
+    xServerAddress.sin_family = FREERTOS_AF_INET;
+    xServerAddress.sin_port = FreeRTOS_htons( usPort );
+    xServerAddress.sin_addr = ulIPAddres;
+    xServerAddress.sin_len = ( uint8_t ) sizeof( xServerAddress );
+
+    xStart = xTaskGetTickCount();
+
+    if( FreeRTOS_connect( xTcpSocket, &xServerAddress, sizeof( xServerAddress ) ) != 0 )
+    {
+        return SOCKETS_SOCKET_ERROR;
+    }
+
+    *pulConnectTimeMs = ( uint32_t ) ( ( xTaskGetTickCount() - xStart ) * portTICK_PERIOD_MS );
+
+    return SOCKETS_ERROR_NONE;
+}
+/*-----------------------------------------------------------*/
+
 void Sockets_Disconnect( SocketHandle xSocket )
 {
     BaseType_t xWaitForShutdownLoopCount = 0;
@@ -133,6 +176,48 @@ BaseType_t Sockets_Recv( SocketHandle xSocket,
 }
 /*-----------------------------------------------------------*/
 
+BaseType_t Sockets_WaitForData( SocketHandle xSocket,
+                                uint32_t ulTimeoutMs )
+{
+    #if ( ipconfigSUPPORT_SELECT_FUNCTION == 1 )
+        Socket_t xTcpSocket = ( Socket_t ) xSocket;
+        SocketSet_t xSocketSet;
+        BaseType_t xRetVal;
+
+        /* A set of its own for each call, so tasks waiting on different
+         * sockets do not share the set or the event group behind it. */
+        xSocketSet = FreeRTOS_CreateSocketSet();
+
+        if( xSocketSet == NULL )
+        {
+            return SOCKETS_ENOMEM;
+        }
+
+        FreeRTOS_FD_SET( xTcpSocket, xSocketSet, eSELECT_READ | eSELECT_EXCEPT );
+        xRetVal = FreeRTOS_select( xSocketSet, pdMS_TO_TICKS( ulTimeoutMs ) );
+        FreeRTOS_FD_CLR( xTcpSocket, xSocketSet, eSELECT_ALL );
+        FreeRTOS_DeleteSocketSet( xSocketSet );
+
+        if( xRetVal < 0 )
+        {
+            xRetVal = SOCKETS_SOCKET_ERROR;
+        }
+        else if( xRetVal > 0 )
+        {
+            xRetVal = 1;
+        }
+
+        return xRetVal;
+    #else /* ipconfigSUPPORT_SELECT_FUNCTION */
+        ( void ) xSocket;
+        ( void ) ulTimeoutMs;
+
+        /* Without FreeRTOS_select() the receive timeout does the waiting. */
+        return 1;
+    #endif /* ipconfigSUPPORT_SELECT_FUNCTION */
+}
+/*-----------------------------------------------------------*/
+
 BaseType_t Sockets_Send( SocketHandle xSocket,
                          const uint8_t * pucData,
                          size_t xDataLength )
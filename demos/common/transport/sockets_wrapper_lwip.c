@@ -192,6 +192,71 @@ BaseType_t Sockets_Connect( SocketHandle xSocket,
 }
 /*-----------------------------------------------------------*/
 
+BaseType_t Sockets_Probe( SocketHandle xSocket,
+                          const char * pcHostName,
+                          uint16_t usPort,
+                          uint32_t ulTimeoutMs,
+                          uint32_t * pulConnectTimeMs )
+{
+    uint32_t ulSocketNumber = ( uint32_t ) xSocket;
+    int32_t lRetVal = SOCKETS_ERROR_NONE;
+    uint32_t ulIPAddres = 0;
+    struct sockaddr_in xSockAddr = { 0 };
+    struct timeval xTV;
+    fd_set xWriteSet;
+    fd_set xErrorSet;
+    int lFlags;
+    int lError = 0;
+    socklen_t xErrorLength = sizeof( lError );
+    TickType_t xStart;
+
+    if( ( ulIPAddres = prvGetHostByName( pcHostName ) ) == 0 )
+    {
+        return SOCKETS_SOCKET_ERROR;
+    }
+
+    xSockAddr.sin_family = AF_INET;
+    xSockAddr.sin_addr.s_addr = ulIPAddres;
+    xSockAddr.sin_port = lwip_htons( usPort );
+
+    /* lwip_connect() ignores the socket timeouts, so the handshake is waited
+     * for with lwip_select(). */
+    lFlags = lwip_fcntl( ulSocketNumber, F_GETFL, 0 );
+    ( void ) lwip_fcntl( ulSocketNumber, F_SETFL, lFlags | O_NONBLOCK );
+    xStart = xTaskGetTickCount();
+
+    if( lwip_connect( ulSocketNumber, ( struct sockaddr * ) &xSockAddr, sizeof( xSockAddr ) ) < 0 )
+    {
+        if( errno != EINPROGRESS )
+        {
+            lRetVal = SOCKETS_SOCKET_ERROR;
+        }
+        else
+        {
+            xTV.tv_sec = ulTimeoutMs / 1000U;
+            xTV.tv_usec = ( ulTimeoutMs % 1000U ) * 1000U;
+
+            FD_ZERO( &xWriteSet );
+            FD_SET( ulSocketNumber, &xWriteSet );
+            FD_ZERO( &xErrorSet );
+            FD_SET( ulSocketNumber, &xErrorSet );
+
+            if( ( lwip_select( ulSocketNumber + 1, NULL, &xWriteSet, &xErrorSet, &xTV ) <= 0 ) ||
+                ( lwip_getsockopt( ulSocketNumber, SOL_SOCKET, SO_ERROR, &lError, &xErrorLength ) != 0 ) ||
+                ( lError != 0 ) )
+            {
+                lRetVal = SOCKETS_SOCKET_ERROR;
+            }
+        }
+    }
+
+    *pulConnectTimeMs = ( uint32_t ) ( ( xTaskGetTickCount() - xStart ) * portTICK_PERIOD_MS );
+    ( void ) lwip_fcntl( ulSocketNumber, F_SETFL, lFlags );
+
+    return lRetVal;
+}
+/*-----------------------------------------------------------*/
+
 void Sockets_Disconnect( SocketHandle xSocket )
 {
     lwip_close( ( uint32_t ) xSocket );
@@ -239,6 +304,34 @@ BaseType_t Sockets_Recv( SocketHandle xSocket,
 }
 /*-----------------------------------------------------------*/
 
+BaseType_t Sockets_WaitForData( SocketHandle xSocket,
+                                uint32_t ulTimeoutMs )
+{
+    uint32_t ulSocketNumber = ( uint32_t ) xSocket;
+    struct timeval xTV;
+    fd_set xReadSet;
+    fd_set xErrorSet;
+    int lRetVal;
+
+    xTV.tv_sec = ulTimeoutMs / 1000U;
+    xTV.tv_usec = ( ulTimeoutMs % 1000U ) * 1000U;
+
+    FD_ZERO( &xReadSet );
+    FD_SET( ulSocketNumber, &xReadSet );
+    FD_ZERO( &xErrorSet );
+    FD_SET( ulSocketNumber, &xErrorSet );
+
+    lRetVal = lwip_select( ulSocketNumber + 1, &xReadSet, NULL, &xErrorSet, &xTV );
+
+    if( lRetVal < 0 )
+    {
+        return SOCKETS_SOCKET_ERROR;
+    }
+
+    return ( lRetVal > 0 ) ? 1 : 0;
+}
+/*-----------------------------------------------------------*/
+
 BaseType_t Sockets_Send( SocketHandle xSocket,
                          const uint8_t * pucData,
                          size_t xDataLength )
@@ -91,6 +91,19 @@ int32_t TLS_Socket_Recv( NetworkContext_t * pxNetworkContext,
                          void * pvBuffer,
                          size_t xBytesToRecv );
 
+/**
+ * @brief Wait until data can be received from TLS.
+ *
+ * Data already decrypted but not read yet counts as received.
+ *
+ * @param pxNetworkContext Pointer to the Network context.
+ * @param ulTimeoutMs Longest wait, in milliseconds.
+ * @return 1 if data can be received, or if the platform cannot tell,
+ *         0 if the wait timed out, or a negative error code.
+ */
+int32_t TLS_Socket_WaitForData( NetworkContext_t * pxNetworkContext,
+                                uint32_t ulTimeoutMs );
+
 /**
  * @brief Send data using TLS.
  *
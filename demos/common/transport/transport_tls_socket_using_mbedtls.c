@@ -855,6 +855,27 @@ int32_t TLS_Socket_Recv( NetworkContext_t * pxNetworkContext,
 }
 /*-----------------------------------------------------------*/
 
+int32_t TLS_Socket_WaitForData( NetworkContext_t * pxNetworkContext,
+                                uint32_t ulTimeoutMs )
+{
+    MbedSSLContext_t * pxSSLContext;
+
+    configASSERT( ( pxNetworkContext != NULL ) &&
+                  ( pxNetworkContext->pParams != NULL ) &&
+                  ( pxNetworkContext->pParams->xSSLContext != NULL ) );
+
+    pxSSLContext = ( MbedSSLContext_t * ) pxNetworkContext->pParams->xSSLContext;
+
+    /* A record may have been read from the socket and not fully returned yet. */
+    if( mbedtls_ssl_get_bytes_avail( &( pxSSLContext->context ) ) > 0 )
+    {
+        return 1;
+    }
+
+    return ( int32_t ) Sockets_WaitForData( pxNetworkContext->pParams->xTCPSocket, ulTimeoutMs );
+}
+/*-----------------------------------------------------------*/
+
 int32_t TLS_Socket_Send( NetworkContext_t * pxNetworkContext,
                          const void * pvBuffer,
                          size_t xBytesToSend )
@@ -0,0 +1,109 @@
+/* Copyright (c) Microsoft Corporation.
+ * Licensed under the MIT License. */
+
+#include "backoff_policy.h"
+
+/* Kernel includes. */
+#include "FreeRTOS.h"
+
+/*-----------------------------------------------------------*/
+
+/**
+ * @brief Base delay doubled for each attempt, up to the cap.
+ */
+static uint32_t prvExponentialCeiling( const BackoffPolicy_t * pxPolicy )
+{
+    uint32_t ulCeiling = pxPolicy->ulBaseMs;
+    uint32_t ulAttempt;
+
+    for( ulAttempt = 0; ( ulAttempt < pxPolicy->ulAttempt ) && ( ulCeiling < pxPolicy->ulCapMs ); ulAttempt++ )
+    {
+        ulCeiling = ( ulCeiling > ( pxPolicy->ulCapMs / 2 ) ) ? pxPolicy->ulCapMs : ( ulCeiling * 2 );
+    }
+
+    return ulCeiling;
+}
+/*-----------------------------------------------------------*/
+
+void BackoffPolicy_Init( BackoffPolicy_t * pxPolicy,
+                         BackoffPolicyType_t xType,
+                         uint32_t ulBaseMs,
+                         uint32_t ulCapMs )
+{
+    configASSERT( pxPolicy != NULL );
+    configASSERT( ulBaseMs > 0 );
+    configASSERT( ulCapMs >= ulBaseMs );
+    configASSERT( ulCapMs < UINT32_MAX );
+
+    pxPolicy->xType = xType;
+    pxPolicy->ulBaseMs = ulBaseMs;
+    pxPolicy->ulCapMs = ulCapMs;
+    BackoffPolicy_Reset( pxPolicy );
+}
+/*-----------------------------------------------------------*/
+
+void BackoffPolicy_Reset( BackoffPolicy_t * pxPolicy )
+{
+    pxPolicy->ulAttempt = 0;
+    pxPolicy->ulPreviousDelayMs = pxPolicy->ulBaseMs;
+    pxPolicy->ulRetryAfterMs = 0;
+}
+/*-----------------------------------------------------------*/
+
+void BackoffPolicy_SetRetryAfter( BackoffPolicy_t * pxPolicy,
+                                  uint32_t ulRetryAfterMs )
+{
+    pxPolicy->ulRetryAfterMs = ulRetryAfterMs;
+}
+/*-----------------------------------------------------------*/
+
+uint32_t BackoffPolicy_NextDelay( BackoffPolicy_t * pxPolicy,
+                                  uint32_t ulRandom )
+{
+    uint32_t ulCeiling;
+    uint32_t ulDelay;
+
+    switch( pxPolicy->xType )
+    {
+        case eBackoffPolicyEqualJitter:
+            ulCeiling = prvExponentialCeiling( pxPolicy );
+            ulDelay = ( ulCeiling / 2 ) + ( ulRandom % ( ( ulCeiling - ( ulCeiling / 2 ) ) + 1 ) );
+            break;
+
+        case eBackoffPolicyDecorrelatedJitter:
+            /* Three times the previous delay cannot overflow once capped. */
+            ulCeiling = ( pxPolicy->ulPreviousDelayMs > ( pxPolicy->ulCapMs / 3 ) ) ?
+                        pxPolicy->ulCapMs : ( pxPolicy->ulPreviousDelayMs * 3 );
+            ulDelay = pxPolicy->ulBaseMs + ( ulRandom % ( ( ulCeiling - pxPolicy->ulBaseMs ) + 1 ) );
+            break;
+
+        case eBackoffPolicyFullJitter:
+        default:
+            ulCeiling = prvExponentialCeiling( pxPolicy );
+            ulDelay = ulRandom % ( ulCeiling + 1 );
+            break;
+    }
+
+    if( ulDelay > pxPolicy->ulCapMs )
+    {
+        ulDelay = pxPolicy->ulCapMs;
+    }
+
+    pxPolicy->ulPreviousDelayMs = ulDelay;
+
+    if( pxPolicy->ulAttempt < UINT32_MAX )
+    {
+        pxPolicy->ulAttempt++;
+    }
+
+    /* The service knows its load better than any jitter. */
+    if( ulDelay < pxPolicy->ulRetryAfterMs )
+    {
+        ulDelay = pxPolicy->ulRetryAfterMs;
+    }
+
+    pxPolicy->ulRetryAfterMs = 0;
+
+    return ulDelay;
+}
+/*-----------------------------------------------------------*/
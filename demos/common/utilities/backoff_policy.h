@@ -0,0 +1,88 @@
+/* Copyright (c) Microsoft Corporation.
+ * Licensed under the MIT License. */
+
+/**
+ * @file backoff_policy.h
+ * @brief Delays between the attempts of an operation that keeps failing.
+ *
+ * When a service comes back after an outage, every device that lost it
+ * retries at once. The jitter of the policies spreads those retries:
+ * - full jitter picks a delay anywhere below an exponentially growing ceiling;
+ * - equal jitter keeps half of the ceiling and picks the other half;
+ * - decorrelated jitter picks between the base delay and three times the
+ *   previous delay, so devices that started together drift apart.
+ *
+ * Every delay is capped, and a retry-after hint from the service sets a
+ * floor on the next one.
+ */
+
+#ifndef BACKOFF_POLICY_H
+#define BACKOFF_POLICY_H
+
+#include <stdint.h>
+
+/**
+ * @brief How the delays grow and are randomized.
+ */
+typedef enum BackoffPolicyType
+{
+    eBackoffPolicyFullJitter = 0,
+    eBackoffPolicyEqualJitter,
+    eBackoffPolicyDecorrelatedJitter
+} BackoffPolicyType_t;
+
+/**
+ * @brief Policy state. Initialize with BackoffPolicy_Init().
+ */
+typedef struct BackoffPolicy
+{
+    BackoffPolicyType_t xType;
+    uint32_t ulBaseMs;
+    uint32_t ulCapMs;
+    uint32_t ulAttempt;
+    uint32_t ulPreviousDelayMs;
+    uint32_t ulRetryAfterMs; /**< Floor of the next delay, 0 for none. */
+} BackoffPolicy_t;
+
+/**
+ * @brief Initialize a policy, for the first attempt.
+ *
+ * @param[out] pxPolicy The policy.
+ * @param[in] xType How the delays grow and are randomized.
+ * @param[in] ulBaseMs Delay before the first retry, before jitter, at least 1.
+ * @param[in] ulCapMs Longest delay, at least @p ulBaseMs.
+ */
+void BackoffPolicy_Init( BackoffPolicy_t * pxPolicy,
+                         BackoffPolicyType_t xType,
+                         uint32_t ulBaseMs,
+                         uint32_t ulCapMs );
+
+/**
+ * @brief Go back to the first attempt, once the operation succeeded.
+ *
+ * @param[in,out] pxPolicy The policy.
+ */
+void BackoffPolicy_Reset( BackoffPolicy_t * pxPolicy );
+
+/**
+ * @brief Set the time the service asked to wait before the next attempt.
+ *
+ * The hint is used by the next delay only, and may exceed the cap.
+ *
+ * @param[in,out] pxPolicy The policy.
+ * @param[in] ulRetryAfterMs Time to wait, in milliseconds.
+ */
+void BackoffPolicy_SetRetryAfter( BackoffPolicy_t * pxPolicy,
+                                  uint32_t ulRetryAfterMs );
+
+/**
+ * @brief Delay before the next attempt.
+ *
+ * @param[in,out] pxPolicy The policy.
+ * @param[in] ulRandom Random number, such as configRAND32().
+ * @return The delay in milliseconds.
+ */
+uint32_t BackoffPolicy_NextDelay( BackoffPolicy_t * pxPolicy,
+                                  uint32_t ulRandom );
+
+#endif /* BACKOFF_POLICY_H */
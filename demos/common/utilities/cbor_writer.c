@@ -0,0 +1,450 @@
+/* Copyright (c) Microsoft Corporation.
+ * Licensed under the MIT License. */
+
+#include "cbor_writer.h"
+
+/* Standard includes. */
+#include <string.h>
+
+/*-----------------------------------------------------------*/
+
+/* Major types, in the 3 high bits of the first byte of an item. */
+#define cborwriterMAJOR_UNSIGNED        ( 0U )
+#define cborwriterMAJOR_NEGATIVE        ( 1U )
+#define cborwriterMAJOR_BYTES           ( 2U )
+#define cborwriterMAJOR_TEXT            ( 3U )
+#define cborwriterMAJOR_ARRAY           ( 4U )
+#define cborwriterMAJOR_MAP             ( 5U )
+#define cborwriterMAJOR_TAG             ( 6U )
+#define cborwriterMAJOR_SIMPLE          ( 7U )
+
+/* Additional information, in the 5 low bits of the first byte of an item. */
+#define cborwriterINFO_ONE_BYTE         ( 24U )
+#define cborwriterINFO_TWO_BYTES        ( 25U )
+#define cborwriterINFO_FOUR_BYTES       ( 26U )
+#define cborwriterINFO_EIGHT_BYTES      ( 27U )
+#define cborwriterINFO_INDEFINITE       ( 31U )
+
+#define cborwriterSIMPLE_FALSE          ( 20U )
+#define cborwriterSIMPLE_TRUE           ( 21U )
+#define cborwriterSIMPLE_NULL           ( 22U )
+
+#define cborwriterHALF_NAN              ( 0x7E00U )
+/*-----------------------------------------------------------*/
+
+/**
+ * @brief Write the head of an item, and the @p ulPayloadLength bytes of @p pucPayload after it.
+ */
+static AzureIoTResult_t prvAppendItem( CBORWriter_t * pxWriter,
+                                       uint32_t ulMajorType,
+                                       uint32_t ulInfo,
+                                       uint64_t ullArgument,
+                                       uint32_t ulArgumentLength,
+                                       const uint8_t * pucPayload,
+                                       uint32_t ulPayloadLength )
+{
+    uint8_t * pucOutput;
+
+    if( pxWriter == NULL )
+    {
+        return eAzureIoTErrorInvalidArgument;
+    }
+
+    if( ( ( pxWriter->ulBufferSize - pxWriter->ulLength ) < ( 1U + ulArgumentLength ) ) ||
+        ( ( pxWriter->ulBufferSize - pxWriter->ulLength - 1U - ulArgumentLength ) < ulPayloadLength ) )
+    {
+        return eAzureIoTErrorOutOfMemory;
+    }
+
+    pucOutput = &pxWriter->pucBuffer[ pxWriter->ulLength ];
+    *pucOutput++ = ( uint8_t ) ( ( ulMajorType << 5 ) | ulInfo );
+
+    while( ulArgumentLength > 0 )
+    {
+        ulArgumentLength--;
+        *pucOutput++ = ( uint8_t ) ( ullArgument >> ( 8U * ulArgumentLength ) );
+    }
+
+    if( ulPayloadLength > 0 )
+    {
+        ( void ) memcpy( pucOutput, pucPayload, ulPayloadLength );
+        pucOutput += ulPayloadLength;
+    }
+
+    pxWriter->ulLength = ( uint32_t ) ( pucOutput - pxWriter->pucBuffer );
+
+    return eAzureIoTSuccess;
+}
+/*-----------------------------------------------------------*/
+
+/**
+ * @brief Write an item whose argument takes as few bytes as it needs.
+ */
+static AzureIoTResult_t prvAppendHead( CBORWriter_t * pxWriter,
+                                       uint32_t ulMajorType,
+                                       uint64_t ullArgument,
+                                       const uint8_t * pucPayload,
+                                       uint32_t ulPayloadLength )
+{
+    if( ullArgument < cborwriterINFO_ONE_BYTE )
+    {
+        return prvAppendItem( pxWriter, ulMajorType, ( uint32_t ) ullArgument, 0, 0, pucPayload, ulPayloadLength );
+    }
+    else if( ullArgument <= 0xFFU )
+    {
+        return prvAppendItem( pxWriter, ulMajorType, cborwriterINFO_ONE_BYTE, ullArgument, 1, pucPayload, ulPayloadLength );
+    }
+    else if( ullArgument <= 0xFFFFU )
+    {
+        return prvAppendItem( pxWriter, ulMajorType, cborwriterINFO_TWO_BYTES, ullArgument, 2, pucPayload, ulPayloadLength );
+    }
+    else if( ullArgument <= 0xFFFFFFFFU )
+    {
+        return prvAppendItem( pxWriter, ulMajorType, cborwriterINFO_FOUR_BYTES, ullArgument, 4, pucPayload, ulPayloadLength );
+    }
+    else
+    {
+        return prvAppendItem( pxWriter, ulMajorType, cborwriterINFO_EIGHT_BYTES, ullArgument, 8, pucPayload, ulPayloadLength );
+    }
+}
+/*-----------------------------------------------------------*/
+
+static AzureIoTResult_t prvAppendBegin( CBORWriter_t * pxWriter,
+                                        uint32_t ulMajorType,
+                                        uint32_t ulCount )
+{
+    AzureIoTResult_t xResult;
+    bool xIndefinite = ( ulCount == cborwriterINDEFINITE_LENGTH );
+
+    if( ( pxWriter == NULL ) || ( pxWriter->ulDepth >= cborwriterMAX_NESTING ) )
+    {
+        return eAzureIoTErrorInvalidArgument;
+    }
+
+    if( xIndefinite )
+    {
+        xResult = prvAppendItem( pxWriter, ulMajorType, cborwriterINFO_INDEFINITE, 0, 0, NULL, 0 );
+    }
+    else
+    {
+        xResult = prvAppendHead( pxWriter, ulMajorType, ulCount, NULL, 0 );
+    }
+
+    if( xResult == eAzureIoTSuccess )
+    {
+        if( xIndefinite )
+        {
+            pxWriter->ulIndefiniteMask |= ( 1U << pxWriter->ulDepth );
+        }
+        else
+        {
+            pxWriter->ulIndefiniteMask &= ~( 1U << pxWriter->ulDepth );
+        }
+
+        pxWriter->ulDepth++;
+    }
+
+    return xResult;
+}
+/*-----------------------------------------------------------*/
+
+static AzureIoTResult_t prvAppendEnd( CBORWriter_t * pxWriter )
+{
+    AzureIoTResult_t xResult = eAzureIoTSuccess;
+
+    if( ( pxWriter == NULL ) || ( pxWriter->ulDepth == 0 ) )
+    {
+        return eAzureIoTErrorInvalidArgument;
+    }
+
+    /* Definite containers end by their count, indefinite ones with a break byte. */
+    if( ( pxWriter->ulIndefiniteMask & ( 1U << ( pxWriter->ulDepth - 1 ) ) ) != 0 )
+    {
+        xResult = prvAppendItem( pxWriter, cborwriterMAJOR_SIMPLE, cborwriterINFO_INDEFINITE, 0, 0, NULL, 0 );
+    }
+
+    if( xResult == eAzureIoTSuccess )
+    {
+        pxWriter->ulDepth--;
+    }
+
+    return xResult;
+}
+/*-----------------------------------------------------------*/
+
+static uint32_t prvFloatBits( float xValue )
+{
+    uint32_t ulBits;
+
+    ( void ) memcpy( &ulBits, &xValue, sizeof( ulBits ) );
+
+    return ulBits;
+}
+/*-----------------------------------------------------------*/
+
+/**
+ * @brief Round the bits of a single precision float to the nearest half, ties to even.
+ */
+static uint32_t prvFloatToHalf( uint32_t ulBits )
+{
+    uint32_t ulSign = ( ulBits >> 16 ) & 0x8000U;
+    int32_t lExponent = ( int32_t ) ( ( ulBits >> 23 ) & 0xFFU ) - 127 + 15;
+    uint32_t ulMantissa = ulBits & 0x7FFFFFU;
+    uint32_t ulShift;
+    uint32_t ulHalf;
+    uint32_t ulRemainder;
+    uint32_t ulMidpoint;
+
+    if( ( ( ulBits >> 23 ) & 0xFFU ) == 0xFFU )
+    {
+        /* Infinity keeps its sign, NaN loses its payload. */
+        return ( ulMantissa == 0 ) ? ( ulSign | 0x7C00U ) : cborwriterHALF_NAN;
+    }
+
+    if( lExponent >= 31 )
+    {
+        return ulSign | 0x7C00U;
+    }
+
+    if( lExponent <= 0 )
+    {
+        /* Subnormal half, or zero below half of its smallest step. */
+        if( lExponent < -10 )
+        {
+            return ulSign;
+        }
+
+        ulMantissa |= 0x800000U;
+        ulShift = ( uint32_t ) ( 14 - lExponent );
+    }
+    else
+    {
+        ulMantissa |= ( uint32_t ) lExponent << 23;
+        ulShift = 13;
+    }
+
+    ulHalf = ulMantissa >> ulShift;
+    ulRemainder = ulMantissa & ( ( 1U << ulShift ) - 1U );
+    ulMidpoint = 1U << ( ulShift - 1U );
+
+    /* A carry out of the mantissa moves to the next exponent, or to infinity, as it should. */
+    if( ( ulRemainder > ulMidpoint ) || ( ( ulRemainder == ulMidpoint ) && ( ( ulHalf & 1U ) != 0 ) ) )
+    {
+        ulHalf++;
+    }
+
+    return ulSign | ulHalf;
+}
+/*-----------------------------------------------------------*/
+
+/**
+ * @brief Bits of the single precision float equal to a half.
+ */
+static uint32_t prvHalfToFloat( uint32_t ulHalf )
+{
+    uint32_t ulSign = ( ulHalf & 0x8000U ) << 16;
+    uint32_t ulExponent = ( ulHalf >> 10 ) & 0x1FU;
+    uint32_t ulMantissa = ulHalf & 0x3FFU;
+
+    if( ulExponent == 0x1FU )
+    {
+        return ulSign | 0x7F800000U | ( ulMantissa << 13 );
+    }
+
+    if( ulExponent == 0 )
+    {
+        if( ulMantissa == 0 )
+        {
+            return ulSign;
+        }
+
+        /* Normalize the subnormal half. */
+        ulExponent = 1;
+
+        while( ( ulMantissa & 0x400U ) == 0 )
+        {
+            ulMantissa <<= 1;
+            ulExponent--;
+        }
+
+        ulMantissa &= 0x3FFU;
+    }
+
+    return ulSign | ( ( ulExponent + 127U - 15U ) << 23 ) | ( ulMantissa << 13 );
+}
+/*-----------------------------------------------------------*/
+
+AzureIoTResult_t CBORWriter_Init( CBORWriter_t * pxWriter,
+                                  uint8_t * pucBuffer,
+                                  uint32_t ulBufferSize )
+{
+    if( ( pxWriter == NULL ) || ( ( pucBuffer == NULL ) && ( ulBufferSize != 0 ) ) )
+    {
+        return eAzureIoTErrorInvalidArgument;
+    }
+
+    pxWriter->pucBuffer = pucBuffer;
+    pxWriter->ulBufferSize = ulBufferSize;
+    pxWriter->ulLength = 0;
+    pxWriter->ulIndefiniteMask = 0;
+    pxWriter->ulDepth = 0;
+
+    return eAzureIoTSuccess;
+}
+/*-----------------------------------------------------------*/
+
+AzureIoTResult_t CBORWriter_AppendBeginMap( CBORWriter_t * pxWriter,
+                                            uint32_t ulPairCount )
+{
+    return prvAppendBegin( pxWriter, cborwriterMAJOR_MAP, ulPairCount );
+}
+/*-----------------------------------------------------------*/
+
+AzureIoTResult_t CBORWriter_AppendEndMap( CBORWriter_t * pxWriter )
+{
+    return prvAppendEnd( pxWriter );
+}
+/*-----------------------------------------------------------*/
+
+AzureIoTResult_t CBORWriter_AppendBeginArray( CBORWriter_t * pxWriter,
+                                              uint32_t ulItemCount )
+{
+    return prvAppendBegin( pxWriter, cborwriterMAJOR_ARRAY, ulItemCount );
+}
+/*-----------------------------------------------------------*/
+
+AzureIoTResult_t CBORWriter_AppendEndArray( CBORWriter_t * pxWriter )
+{
+    return prvAppendEnd( pxWriter );
+}
+/*-----------------------------------------------------------*/
+
+AzureIoTResult_t CBORWriter_AppendText( CBORWriter_t * pxWriter,
+                                        const uint8_t * pucText,
+                                        uint32_t ulTextLength )
+{
+    if( ( pucText == NULL ) && ( ulTextLength != 0 ) )
+    {
+        return eAzureIoTErrorInvalidArgument;
+    }
+
+    return prvAppendHead( pxWriter, cborwriterMAJOR_TEXT, ulTextLength, pucText, ulTextLength );
+}
+/*-----------------------------------------------------------*/
+
+AzureIoTResult_t CBORWriter_AppendBytes( CBORWriter_t * pxWriter,
+                                         const uint8_t * pucBytes,
+                                         uint32_t ulBytesLength )
+{
+    if( ( pucBytes == NULL ) && ( ulBytesLength != 0 ) )
+    {
+        return eAzureIoTErrorInvalidArgument;
+    }
+
+    return prvAppendHead( pxWriter, cborwriterMAJOR_BYTES, ulBytesLength, pucBytes, ulBytesLength );
+}
+/*-----------------------------------------------------------*/
+
+AzureIoTResult_t CBORWriter_AppendUnsigned( CBORWriter_t * pxWriter,
+                                            uint64_t ullValue )
+{
+    return prvAppendHead( pxWriter, cborwriterMAJOR_UNSIGNED, ullValue, NULL, 0 );
+}
+/*-----------------------------------------------------------*/
+
+AzureIoTResult_t CBORWriter_AppendInt( CBORWriter_t * pxWriter,
+                                       int64_t llValue )
+{
+    /* A negative N is written as -1 - N, computed without overflow for INT64_MIN. */
+    if( llValue < 0 )
+    {
+        return prvAppendHead( pxWriter, cborwriterMAJOR_NEGATIVE, ~( uint64_t ) llValue, NULL, 0 );
+    }
+
+    return prvAppendHead( pxWriter, cborwriterMAJOR_UNSIGNED, ( uint64_t ) llValue, NULL, 0 );
+}
+/*-----------------------------------------------------------*/
+
+AzureIoTResult_t CBORWriter_AppendTag( CBORWriter_t * pxWriter,
+                                       uint64_t ullTag )
+{
+    return prvAppendHead( pxWriter, cborwriterMAJOR_TAG, ullTag, NULL, 0 );
+}
+/*-----------------------------------------------------------*/
+
+AzureIoTResult_t CBORWriter_AppendBool( CBORWriter_t * pxWriter,
+                                        bool xValue )
+{
+    return prvAppendItem( pxWriter, cborwriterMAJOR_SIMPLE,
+                          xValue ? cborwriterSIMPLE_TRUE : cborwriterSIMPLE_FALSE, 0, 0, NULL, 0 );
+}
+/*-----------------------------------------------------------*/
+
+AzureIoTResult_t CBORWriter_AppendNull( CBORWriter_t * pxWriter )
+{
+    return prvAppendItem( pxWriter, cborwriterMAJOR_SIMPLE, cborwriterSIMPLE_NULL, 0, 0, NULL, 0 );
+}
+/*-----------------------------------------------------------*/
+
+AzureIoTResult_t CBORWriter_AppendHalf( CBORWriter_t * pxWriter,
+                                        float xValue )
+{
+    return prvAppendItem( pxWriter, cborwriterMAJOR_SIMPLE, cborwriterINFO_TWO_BYTES,
+                          prvFloatToHalf( prvFloatBits( xValue ) ), 2, NULL, 0 );
+}
+/*-----------------------------------------------------------*/
+
+AzureIoTResult_t CBORWriter_AppendFloat( CBORWriter_t * pxWriter,
+                                         float xValue )
+{
+    return prvAppendItem( pxWriter, cborwriterMAJOR_SIMPLE, cborwriterINFO_FOUR_BYTES,
+                          prvFloatBits( xValue ), 4, NULL, 0 );
+}
+/*-----------------------------------------------------------*/
+
+AzureIoTResult_t CBORWriter_AppendDouble( CBORWriter_t * pxWriter,
+                                          double xValue )
+{
+    uint64_t ullBits;
+
+    ( void ) memcpy( &ullBits, &xValue, sizeof( ullBits ) );
+
+    return prvAppendItem( pxWriter, cborwriterMAJOR_SIMPLE, cborwriterINFO_EIGHT_BYTES, ullBits, 8, NULL, 0 );
+}
+/*-----------------------------------------------------------*/
+
+AzureIoTResult_t CBORWriter_AppendFloatingPoint( CBORWriter_t * pxWriter,
+                                                 double xValue )
+{
+    float xSingle = ( float ) xValue;
+    uint32_t ulBits;
+    uint32_t ulHalf;
+
+    if( xValue != xValue )
+    {
+        return prvAppendItem( pxWriter, cborwriterMAJOR_SIMPLE, cborwriterINFO_TWO_BYTES,
+                              cborwriterHALF_NAN, 2, NULL, 0 );
+    }
+
+    if( ( double ) xSingle != xValue )
+    {
+        return CBORWriter_AppendDouble( pxWriter, xValue );
+    }
+
+    ulBits = prvFloatBits( xSingle );
+    ulHalf = prvFloatToHalf( ulBits );
+
+    if( prvHalfToFloat( ulHalf ) != ulBits )
+    {
+        return CBORWriter_AppendFloat( pxWriter, xSingle );
+    }
+
+    return prvAppendItem( pxWriter, cborwriterMAJOR_SIMPLE, cborwriterINFO_TWO_BYTES, ulHalf, 2, NULL, 0 );
+}
+/*-----------------------------------------------------------*/
+
+uint32_t CBORWriter_GetBytesUsed( const CBORWriter_t * pxWriter )
+{
+    return ( pxWriter == NULL ) ? 0 : pxWriter->ulLength;
+}
+/*-----------------------------------------------------------*/
@@ -0,0 +1,224 @@
+/* Copyright (c) Microsoft Corporation.
+ * Licensed under the MIT License. */
+
+/**
+ * @file cbor_writer.h
+ * @brief Append-style CBOR (RFC 8949) encoder, shaped like the JSON writer.
+ *
+ * Items are written straight into the caller's buffer, in the order they are
+ * appended. A map is a sequence of key and value pairs, the keys usually text
+ * strings. Maps and arrays are opened with their item count, or with
+ * #cborwriterINDEFINITE_LENGTH when it is not known up front, at the cost of
+ * one byte to close them. Every call that fails leaves the output unchanged.
+ *
+ * Messages carrying CBOR are tagged with the content type `application/cbor`.
+ */
+
+#ifndef CBOR_WRITER_H
+#define CBOR_WRITER_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "azure_iot_result.h"
+
+/**
+ * @brief Item count of a map or an array closed by its end rather than announced.
+ */
+#define cborwriterINDEFINITE_LENGTH    ( 0xFFFFFFFFU )
+
+/**
+ * @brief Deepest nesting of maps and arrays.
+ */
+#define cborwriterMAX_NESTING          ( 32U )
+
+/**
+ * @brief Most bytes the head of an item takes.
+ */
+#define cborwriterMAX_HEAD_LENGTH      ( 9U )
+
+/**
+ * @brief Writer state. Initialize with CBORWriter_Init().
+ */
+typedef struct CBORWriter
+{
+    uint8_t * pucBuffer;
+    uint32_t ulBufferSize;
+    uint32_t ulLength;
+    uint32_t ulIndefiniteMask; /**< Bit N set if the container at depth N is indefinite. */
+    uint32_t ulDepth;
+} CBORWriter_t;
+
+/**
+ * @brief Initialize a writer over an empty buffer.
+ *
+ * @param[out] pxWriter The writer.
+ * @param[out] pucBuffer Buffer receiving the encoding, referenced.
+ * @param[in] ulBufferSize Size of @p pucBuffer.
+ * @return An #AzureIoTResult_t with the result of the operation.
+ */
+AzureIoTResult_t CBORWriter_Init( CBORWriter_t * pxWriter,
+                                  uint8_t * pucBuffer,
+                                  uint32_t ulBufferSize );
+
+/**
+ * @brief Open a map, to be closed with CBORWriter_AppendEndMap().
+ *
+ * @param[in,out] pxWriter The writer.
+ * @param[in] ulPairCount Number of key and value pairs, or #cborwriterINDEFINITE_LENGTH.
+ * @return An #AzureIoTResult_t with the result of the operation.
+ */
+AzureIoTResult_t CBORWriter_AppendBeginMap( CBORWriter_t * pxWriter,
+                                            uint32_t ulPairCount );
+
+/**
+ * @brief Close the map opened last.
+ *
+ * @param[in,out] pxWriter The writer.
+ * @return An #AzureIoTResult_t with the result of the operation.
+ */
+AzureIoTResult_t CBORWriter_AppendEndMap( CBORWriter_t * pxWriter );
+
+/**
+ * @brief Open an array, to be closed with CBORWriter_AppendEndArray().
+ *
+ * @param[in,out] pxWriter The writer.
+ * @param[in] ulItemCount Number of items, or #cborwriterINDEFINITE_LENGTH.
+ * @return An #AzureIoTResult_t with the result of the operation.
+ */
+AzureIoTResult_t CBORWriter_AppendBeginArray( CBORWriter_t * pxWriter,
+                                              uint32_t ulItemCount );
+
+/**
+ * @brief Close the array opened last.
+ *
+ * @param[in,out] pxWriter The writer.
+ * @return An #AzureIoTResult_t with the result of the operation.
+ */
+AzureIoTResult_t CBORWriter_AppendEndArray( CBORWriter_t * pxWriter );
+
+/**
+ * @brief Append a text string, UTF-8 encoded.
+ *
+ * @param[in,out] pxWriter The writer.
+ * @param[in] pucText The text, copied.
+ * @param[in] ulTextLength Length of @p pucText in bytes.
+ * @return An #AzureIoTResult_t with the result of the operation.
+ */
+AzureIoTResult_t CBORWriter_AppendText( CBORWriter_t * pxWriter,
+                                        const uint8_t * pucText,
+                                        uint32_t ulTextLength );
+
+/**
+ * @brief Append a byte string.
+ *
+ * @param[in,out] pxWriter The writer.
+ * @param[in] pucBytes The bytes, copied.
+ * @param[in] ulBytesLength Length of @p pucBytes.
+ * @return An #AzureIoTResult_t with the result of the operation.
+ */
+AzureIoTResult_t CBORWriter_AppendBytes( CBORWriter_t * pxWriter,
+                                         const uint8_t * pucBytes,
+                                         uint32_t ulBytesLength );
+
+/**
+ * @brief Append an unsigned integer, in as few bytes as it needs.
+ *
+ * @param[in,out] pxWriter The writer.
+ * @param[in] ullValue The value.
+ * @return An #AzureIoTResult_t with the result of the operation.
+ */
+AzureIoTResult_t CBORWriter_AppendUnsigned( CBORWriter_t * pxWriter,
+                                            uint64_t ullValue );
+
+/**
+ * @brief Append a signed integer, in as few bytes as it needs.
+ *
+ * @param[in,out] pxWriter The writer.
+ * @param[in] llValue The value.
+ * @return An #AzureIoTResult_t with the result of the operation.
+ */
+AzureIoTResult_t CBORWriter_AppendInt( CBORWriter_t * pxWriter,
+                                       int64_t llValue );
+
+/**
+ * @brief Append a tag, giving a meaning to the item appended next.
+ *
+ * @param[in,out] pxWriter The writer.
+ * @param[in] ullTag The tag number, such as 1 for a time in seconds since the epoch.
+ * @return An #AzureIoTResult_t with the result of the operation.
+ */
+AzureIoTResult_t CBORWriter_AppendTag( CBORWriter_t * pxWriter,
+                                       uint64_t ullTag );
+
+/**
+ * @brief Append `true` or `false`.
+ *
+ * @param[in,out] pxWriter The writer.
+ * @param[in] xValue The value.
+ * @return An #AzureIoTResult_t with the result of the operation.
+ */
+AzureIoTResult_t CBORWriter_AppendBool( CBORWriter_t * pxWriter,
+                                        bool xValue );
+
+/**
+ * @brief Append `null`.
+ *
+ * @param[in,out] pxWriter The writer.
+ * @return An #AzureIoTResult_t with the result of the operation.
+ */
+AzureIoTResult_t CBORWriter_AppendNull( CBORWriter_t * pxWriter );
+
+/**
+ * @brief Append a half precision float, 3 bytes, rounding @p xValue to the nearest half.
+ *
+ * Halfs hold 3 significant digits, up to 65504.
+ *
+ * @param[in,out] pxWriter The writer.
+ * @param[in] xValue The value.
+ * @return An #AzureIoTResult_t with the result of the operation.
+ */
+AzureIoTResult_t CBORWriter_AppendHalf( CBORWriter_t * pxWriter,
+                                        float xValue );
+
+/**
+ * @brief Append a single precision float, 5 bytes.
+ *
+ * @param[in,out] pxWriter The writer.
+ * @param[in] xValue The value.
+ * @return An #AzureIoTResult_t with the result of the operation.
+ */
+AzureIoTResult_t CBORWriter_AppendFloat( CBORWriter_t * pxWriter,
+                                         float xValue );
+
+/**
+ * @brief Append a double precision float, 9 bytes.
+ *
+ * @param[in,out] pxWriter The writer.
+ * @param[in] xValue The value.
+ * @return An #AzureIoTResult_t with the result of the operation.
+ */
+AzureIoTResult_t CBORWriter_AppendDouble( CBORWriter_t * pxWriter,
+                                          double xValue );
+
+/**
+ * @brief Append a double as the shortest float holding it exactly.
+ *
+ * This is the preferred serialization of RFC 8949: 21.5 takes 3 bytes, 0.1 takes 9.
+ *
+ * @param[in,out] pxWriter The writer.
+ * @param[in] xValue The value.
+ * @return An #AzureIoTResult_t with the result of the operation.
+ */
+AzureIoTResult_t CBORWriter_AppendFloatingPoint( CBORWriter_t * pxWriter,
+                                                 double xValue );
+
+/**
+ * @brief Number of bytes written so far.
+ *
+ * @param[in] pxWriter The writer.
+ * @return The length of the encoding.
+ */
+uint32_t CBORWriter_GetBytesUsed( const CBORWriter_t * pxWriter );
+
+#endif /* CBOR_WRITER_H */
@@ -0,0 +1,324 @@
+/* Copyright (c) Microsoft Corporation.
+ * Licensed under the MIT License. */
+
+#include "command_dispatcher.h"
+
+/* Standard includes. */
+#include <stdbool.h>
+#include <string.h>
+
+/* Kernel includes. */
+#include "task.h"
+
+/*-----------------------------------------------------------*/
+
+/**
+ * @brief Slots hold the entry index plus one, 0 marks an empty slot.
+ */
+#define commanddispatcherEMPTY_SLOT      ( 0U )
+
+#if ( commanddispatcherMAX_COMMANDS > 255U )
+    #error "commanddispatcherMAX_COMMANDS must fit in a slot."
+#endif
+
+#if ( ( commanddispatcherSLOT_COUNT & ( commanddispatcherSLOT_COUNT - 1U ) ) != 0U ) || \
+    ( commanddispatcherSLOT_COUNT < 4U )
+    #error "commanddispatcherSLOT_COUNT must be a power of 2, at least 4."
+#endif
+/*-----------------------------------------------------------*/
+
+/**
+ * @brief FNV-1a of the component and command names, joined by the separator of the
+ *  command topic, which cannot appear in either.
+ */
+static uint32_t prvHashNames( const uint8_t * pucComponentName,
+                              uint32_t ulComponentNameLength,
+                              const uint8_t * pucCommandName,
+                              uint32_t ulCommandNameLength )
+{
+    uint32_t ulHash = 2166136261UL;
+    uint32_t ulIndex;
+
+    for( ulIndex = 0; ulIndex < ulComponentNameLength; ulIndex++ )
+    {
+        ulHash = ( ulHash ^ pucComponentName[ ulIndex ] ) * 16777619UL;
+    }
+
+    ulHash = ( ulHash ^ ( uint8_t ) '*' ) * 16777619UL;
+
+    for( ulIndex = 0; ulIndex < ulCommandNameLength; ulIndex++ )
+    {
+        ulHash = ( ulHash ^ pucCommandName[ ulIndex ] ) * 16777619UL;
+    }
+
+    return ulHash;
+}
+/*-----------------------------------------------------------*/
+
+static uint32_t prvBucket( uint32_t ulHash )
+{
+    return ( ulHash >> 16 ) & ( commanddispatcherBUCKET_COUNT - 1U );
+}
+/*-----------------------------------------------------------*/
+
+/**
+ * @brief Slot of a name hash for the seed of its bucket, through the finalizer of MurmurHash3.
+ */
+static uint32_t prvSlot( uint32_t ulHash,
+                         uint8_t ucSeed )
+{
+    ulHash ^= ( uint32_t ) ucSeed * 0x9E3779B9UL;
+    ulHash ^= ulHash >> 16;
+    ulHash *= 0x85EBCA6BUL;
+    ulHash ^= ulHash >> 13;
+    ulHash *= 0xC2B2AE35UL;
+    ulHash ^= ulHash >> 16;
+
+    return ulHash & ( commanddispatcherSLOT_COUNT - 1U );
+}
+/*-----------------------------------------------------------*/
+
+/**
+ * @brief Find a seed sending every entry of a bucket to a free slot, and take those slots.
+ */
+static bool prvPlaceBucket( CommandDispatcher_t * pxDispatcher,
+                            uint32_t ulBucket )
+{
+    uint32_t ulSeed;
+    uint32_t ulIndex;
+    uint32_t ulSlot;
+    const CommandDispatcherEntry_t * pxEntry;
+
+    for( ulSeed = 0; ulSeed <= UINT8_MAX; ulSeed++ )
+    {
+        for( ulIndex = 0; ulIndex < pxDispatcher->ulEntryCount; ulIndex++ )
+        {
+            pxEntry = &pxDispatcher->xEntries[ ulIndex ];
+
+            if( prvBucket( pxEntry->ulHash ) == ulBucket )
+            {
+                ulSlot = prvSlot( pxEntry->ulHash, ( uint8_t ) ulSeed );
+
+                if( pxDispatcher->ucSlots[ ulSlot ] != commanddispatcherEMPTY_SLOT )
+                {
+                    break;
+                }
+
+                pxDispatcher->ucSlots[ ulSlot ] = ( uint8_t ) ( ulIndex + 1U );
+            }
+        }
+
+        if( ulIndex == pxDispatcher->ulEntryCount )
+        {
+            pxDispatcher->ucBucketSeeds[ ulBucket ] = ( uint8_t ) ulSeed;
+
+            return true;
+        }
+
+        /* Give back the slots taken with this seed. */
+        while( ulIndex-- > 0 )
+        {
+            pxEntry = &pxDispatcher->xEntries[ ulIndex ];
+
+            if( prvBucket( pxEntry->ulHash ) == ulBucket )
+            {
+                pxDispatcher->ucSlots[ prvSlot( pxEntry->ulHash, ( uint8_t ) ulSeed ) ] = commanddispatcherEMPTY_SLOT;
+            }
+        }
+    }
+
+    return false;
+}
+/*-----------------------------------------------------------*/
+
+/**
+ * @brief Build the perfect hash: buckets are placed from the fullest down, each with
+ *  the first seed that sends all its entries to free slots.
+ */
+static bool prvBuildSlots( CommandDispatcher_t * pxDispatcher )
+{
+    uint8_t ucBucketSizes[ commanddispatcherBUCKET_COUNT ] = { 0 };
+    uint32_t ulSize;
+    uint32_t ulBucket;
+    uint32_t ulIndex;
+
+    memset( pxDispatcher->ucSlots, commanddispatcherEMPTY_SLOT, sizeof( pxDispatcher->ucSlots ) );
+    memset( pxDispatcher->ucBucketSeeds, 0, sizeof( pxDispatcher->ucBucketSeeds ) );
+
+    for( ulIndex = 0; ulIndex < pxDispatcher->ulEntryCount; ulIndex++ )
+    {
+        ucBucketSizes[ prvBucket( pxDispatcher->xEntries[ ulIndex ].ulHash ) ]++;
+    }
+
+    for( ulSize = pxDispatcher->ulEntryCount; ulSize > 0; ulSize-- )
+    {
+        for( ulBucket = 0; ulBucket < commanddispatcherBUCKET_COUNT; ulBucket++ )
+        {
+            if( ( ucBucketSizes[ ulBucket ] == ulSize ) &&
+                !prvPlaceBucket( pxDispatcher, ulBucket ) )
+            {
+                return false;
+            }
+        }
+    }
+
+    return true;
+}
+/*-----------------------------------------------------------*/
+
+void CommandDispatcher_Init( CommandDispatcher_t * pxDispatcher )
+{
+    memset( pxDispatcher, 0, sizeof( *pxDispatcher ) );
+}
+/*-----------------------------------------------------------*/
+
+AzureIoTResult_t CommandDispatcher_Register( CommandDispatcher_t * pxDispatcher,
+                                             const uint8_t * pucComponentName,
+                                             uint32_t ulComponentNameLength,
+                                             const uint8_t * pucCommandName,
+                                             uint32_t ulCommandNameLength,
+                                             CommandDispatcherHandler_t xHandler,
+                                             void * pvContext )
+{
+    CommandDispatcherEntry_t * pxEntry;
+    uint32_t ulIndex;
+    bool xBuilt;
+
+    if( ( pxDispatcher == NULL ) || ( pucCommandName == NULL ) || ( ulCommandNameLength == 0 ) ||
+        ( ( pucComponentName == NULL ) && ( ulComponentNameLength != 0 ) ) || ( xHandler == NULL ) )
+    {
+        return eAzureIoTErrorInvalidArgument;
+    }
+
+    if( pxDispatcher->ulEntryCount == commanddispatcherMAX_COMMANDS )
+    {
+        return eAzureIoTErrorOutOfMemory;
+    }
+
+    if( CommandDispatcher_Find( pxDispatcher, pucComponentName, ulComponentNameLength,
+                                pucCommandName, ulCommandNameLength ) != NULL )
+    {
+        return eAzureIoTErrorFailed;
+    }
+
+    pxEntry = &pxDispatcher->xEntries[ pxDispatcher->ulEntryCount++ ];
+    memset( pxEntry, 0, sizeof( *pxEntry ) );
+    pxEntry->pucComponentName = pucComponentName;
+    pxEntry->ulComponentNameLength = ulComponentNameLength;
+    pxEntry->pucCommandName = pucCommandName;
+    pxEntry->ulCommandNameLength = ulCommandNameLength;
+    pxEntry->xHandler = xHandler;
+    pxEntry->pvContext = pvContext;
+    pxEntry->ulHash = prvHashNames( pucComponentName, ulComponentNameLength,
+                                    pucCommandName, ulCommandNameLength );
+
+    /* Two names with the same hash can never be told apart by a slot. */
+    for( ulIndex = 0; ulIndex < ( pxDispatcher->ulEntryCount - 1U ); ulIndex++ )
+    {
+        if( pxDispatcher->xEntries[ ulIndex ].ulHash == pxEntry->ulHash )
+        {
+            break;
+        }
+    }
+
+    if( ulIndex != ( pxDispatcher->ulEntryCount - 1U ) )
+    {
+        pxDispatcher->ulEntryCount--;
+
+        return eAzureIoTErrorFailed;
+    }
+
+    if( !prvBuildSlots( pxDispatcher ) )
+    {
+        /* Drop the new entry and restore the slots of the remaining ones. */
+        pxDispatcher->ulEntryCount--;
+        xBuilt = prvBuildSlots( pxDispatcher );
+        configASSERT( xBuilt );
+        ( void ) xBuilt;
+
+        return eAzureIoTErrorFailed;
+    }
+
+    return eAzureIoTSuccess;
+}
+/*-----------------------------------------------------------*/
+
+const CommandDispatcherEntry_t * CommandDispatcher_Find( const CommandDispatcher_t * pxDispatcher,
+                                                         const uint8_t * pucComponentName,
+                                                         uint32_t ulComponentNameLength,
+                                                         const uint8_t * pucCommandName,
+                                                         uint32_t ulCommandNameLength )
+{
+    const CommandDispatcherEntry_t * pxEntry;
+    uint32_t ulHash;
+    uint8_t ucSlot;
+
+    if( pucComponentName == NULL )
+    {
+        ulComponentNameLength = 0;
+    }
+
+    ulHash = prvHashNames( pucComponentName, ulComponentNameLength,
+                           pucCommandName, ulCommandNameLength );
+    ucSlot = pxDispatcher->ucSlots[ prvSlot( ulHash, pxDispatcher->ucBucketSeeds[ prvBucket( ulHash ) ] ) ];
+
+    if( ucSlot == commanddispatcherEMPTY_SLOT )
+    {
+        return NULL;
+    }
+
+    pxEntry = &pxDispatcher->xEntries[ ucSlot - 1U ];
+
+    if( ( pxEntry->ulComponentNameLength != ulComponentNameLength ) ||
+        ( pxEntry->ulCommandNameLength != ulCommandNameLength ) ||
+        ( memcmp( pxEntry->pucCommandName, pucCommandName, ulCommandNameLength ) != 0 ) ||
+        ( ( ulComponentNameLength != 0 ) &&
+          ( memcmp( pxEntry->pucComponentName, pucComponentName, ulComponentNameLength ) != 0 ) ) )
+    {
+        return NULL;
+    }
+
+    return pxEntry;
+}
+/*-----------------------------------------------------------*/
+
+AzureIoTResult_t CommandDispatcher_Dispatch( CommandDispatcher_t * pxDispatcher,
+                                             const AzureIoTHubClientCommandRequest_t * pxMessage,
+                                             uint8_t * pucResponsePayload,
+                                             uint32_t ulResponsePayloadSize,
+                                             uint32_t * pulResponseStatus,
+                                             uint32_t * pulResponsePayloadLength )
+{
+    CommandDispatcherEntry_t * pxEntry;
+    uint32_t ulStartUs;
+    uint32_t ulElapsedUs;
+
+    pxEntry = ( CommandDispatcherEntry_t * ) CommandDispatcher_Find( pxDispatcher,
+                                                                     pxMessage->pucComponentName,
+                                                                     pxMessage->usComponentNameLength,
+                                                                     pxMessage->pucCommandName,
+                                                                     pxMessage->usCommandNameLength );
+
+    if( pxEntry == NULL )
+    {
+        return eAzureIoTErrorItemNotFound;
+    }
+
+    *pulResponsePayloadLength = 0;
+
+    ulStartUs = commanddispatcherGET_TIME_US();
+    *pulResponseStatus = pxEntry->xHandler( pxMessage, pucResponsePayload, ulResponsePayloadSize,
+                                            pulResponsePayloadLength, pxEntry->pvContext );
+    ulElapsedUs = commanddispatcherGET_TIME_US() - ulStartUs;
+
+    pxEntry->ulInvocationCount++;
+    pxEntry->ullTotalLatencyUs += ulElapsedUs;
+
+    if( ulElapsedUs > pxEntry->ulMaxLatencyUs )
+    {
+        pxEntry->ulMaxLatencyUs = ulElapsedUs;
+    }
+
+    return eAzureIoTSuccess;
+}
+/*-----------------------------------------------------------*/
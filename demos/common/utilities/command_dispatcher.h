@@ -0,0 +1,172 @@
+/* Copyright (c) Microsoft Corporation.
+ * Licensed under the MIT License. */
+
+/**
+ * @file command_dispatcher.h
+ * @brief Table driven dispatch of Azure IoT Hub commands.
+ *
+ * Handlers are registered as (component, command) pairs. Every registration
+ * rebuilds a perfect hash of the registered names (hash and displace: names
+ * are grouped in buckets, and each bucket gets the seed that sends its names
+ * to free slots). A lookup hashes the names of the request once, reads one
+ * seed and one slot and confirms the match with one comparison, whatever the
+ * number of commands. Names are used in place, straight from the request.
+ *
+ * The dispatcher also keeps invocation count and latency, in microseconds,
+ * of each handler.
+ */
+
+#ifndef COMMAND_DISPATCHER_H
+#define COMMAND_DISPATCHER_H
+
+#include <stdint.h>
+
+#include "FreeRTOS.h"
+
+#include "azure_iot_hub_client.h"
+
+/**
+ * @brief Maximum number of commands registered with one dispatcher.
+ * Raise #commanddispatcherSLOT_COUNT with it, such as 128 slots for 64 commands.
+ */
+#ifndef commanddispatcherMAX_COMMANDS
+    #define commanddispatcherMAX_COMMANDS    ( 8U )
+#endif
+
+/**
+ * @brief Number of hash slots, a power of 2 at least twice #commanddispatcherMAX_COMMANDS.
+ */
+#ifndef commanddispatcherSLOT_COUNT
+    #define commanddispatcherSLOT_COUNT      ( 16U )
+#endif
+
+/**
+ * @brief Number of buckets of the perfect hash, each holding a one byte seed.
+ */
+#define commanddispatcherBUCKET_COUNT        ( commanddispatcherSLOT_COUNT / 4U )
+
+/**
+ * @brief Current time in microseconds, for the latency of the handlers.
+ *
+ * Define it, for instance in FreeRTOSConfig.h, to a cycle counter or a
+ * microsecond timer of the platform. By default it follows the tick count,
+ * too coarse for most handlers.
+ */
+#ifndef commanddispatcherGET_TIME_US
+    #define commanddispatcherGET_TIME_US()    ( ( uint32_t ) ( xTaskGetTickCount() * ( 1000000UL / configTICK_RATE_HZ ) ) )
+#endif
+
+/**
+ * @brief Handler of one command.
+ *
+ * @param[in] pxMessage The command request.
+ * @param[out] pucResponsePayload Buffer receiving the response payload.
+ * @param[in] ulResponsePayloadSize Size of @p pucResponsePayload.
+ * @param[out] pulResponsePayloadLength Length of the response payload written.
+ * @param[in] pvContext Context given at registration.
+ * @return The status code of the command response.
+ */
+typedef uint32_t ( * CommandDispatcherHandler_t )( const AzureIoTHubClientCommandRequest_t * pxMessage,
+                                                   uint8_t * pucResponsePayload,
+                                                   uint32_t ulResponsePayloadSize,
+                                                   uint32_t * pulResponsePayloadLength,
+                                                   void * pvContext );
+
+/**
+ * @brief A registered command and its statistics.
+ */
+typedef struct CommandDispatcherEntry
+{
+    const uint8_t * pucComponentName;
+    uint32_t ulComponentNameLength;
+    const uint8_t * pucCommandName;
+    uint32_t ulCommandNameLength;
+    CommandDispatcherHandler_t xHandler;
+    void * pvContext;
+    uint32_t ulHash;
+
+    uint32_t ulInvocationCount;
+    uint64_t ullTotalLatencyUs;
+    uint32_t ulMaxLatencyUs;
+} CommandDispatcherEntry_t;
+
+/**
+ * @brief Dispatcher state. Initialize with CommandDispatcher_Init().
+ */
+typedef struct CommandDispatcher
+{
+    CommandDispatcherEntry_t xEntries[ commanddispatcherMAX_COMMANDS ];
+    uint32_t ulEntryCount;
+    uint8_t ucBucketSeeds[ commanddispatcherBUCKET_COUNT ];
+    uint8_t ucSlots[ commanddispatcherSLOT_COUNT ];
+} CommandDispatcher_t;
+
+/**
+ * @brief Initialize an empty dispatcher.
+ *
+ * @param[out] pxDispatcher The dispatcher.
+ */
+void CommandDispatcher_Init( CommandDispatcher_t * pxDispatcher );
+
+/**
+ * @brief Register the handler of a command.
+ *
+ * The names are referenced, not copied, and must outlive the dispatcher.
+ *
+ * @param[in,out] pxDispatcher The dispatcher.
+ * @param[in] pucComponentName Component of the command, or `NULL` for commands of the root interface.
+ * @param[in] ulComponentNameLength Length of @p pucComponentName.
+ * @param[in] pucCommandName Name of the command.
+ * @param[in] ulCommandNameLength Length of @p pucCommandName.
+ * @param[in] xHandler Handler of the command.
+ * @param[in] pvContext Context passed to @p xHandler.
+ * @return An #AzureIoTResult_t with the result of the operation.
+ *         - `eAzureIoTErrorOutOfMemory` if the table is full.
+ *         - `eAzureIoTErrorFailed` if the command is already registered, or no perfect hash
+ *           was found, in which case #commanddispatcherSLOT_COUNT should be raised.
+ */
+AzureIoTResult_t CommandDispatcher_Register( CommandDispatcher_t * pxDispatcher,
+                                             const uint8_t * pucComponentName,
+                                             uint32_t ulComponentNameLength,
+                                             const uint8_t * pucCommandName,
+                                             uint32_t ulCommandNameLength,
+                                             CommandDispatcherHandler_t xHandler,
+                                             void * pvContext );
+
+/**
+ * @brief Find the entry of a command.
+ *
+ * @param[in] pxDispatcher The dispatcher.
+ * @param[in] pucComponentName Component of the command, `NULL` or empty for the root interface.
+ * @param[in] ulComponentNameLength Length of @p pucComponentName.
+ * @param[in] pucCommandName Name of the command.
+ * @param[in] ulCommandNameLength Length of @p pucCommandName.
+ * @return The entry, or `NULL` if the command is not registered.
+ */
+const CommandDispatcherEntry_t * CommandDispatcher_Find( const CommandDispatcher_t * pxDispatcher,
+                                                         const uint8_t * pucComponentName,
+                                                         uint32_t ulComponentNameLength,
+                                                         const uint8_t * pucCommandName,
+                                                         uint32_t ulCommandNameLength );
+
+/**
+ * @brief Run the handler registered for a command request.
+ *
+ * @param[in,out] pxDispatcher The dispatcher.
+ * @param[in] pxMessage The command request.
+ * @param[out] pucResponsePayload Buffer receiving the response payload.
+ * @param[in] ulResponsePayloadSize Size of @p pucResponsePayload.
+ * @param[out] pulResponseStatus Status code returned by the handler.
+ * @param[out] pulResponsePayloadLength Length of the response payload written by the handler.
+ * @return An #AzureIoTResult_t with the result of the operation.
+ *         - `eAzureIoTErrorItemNotFound` if no handler is registered for the command,
+ *           in which case nothing is written.
+ */
+AzureIoTResult_t CommandDispatcher_Dispatch( CommandDispatcher_t * pxDispatcher,
+                                             const AzureIoTHubClientCommandRequest_t * pxMessage,
+                                             uint8_t * pucResponsePayload,
+                                             uint32_t ulResponsePayloadSize,
+                                             uint32_t * pulResponseStatus,
+                                             uint32_t * pulResponsePayloadLength );
+
+#endif /* COMMAND_DISPATCHER_H */
@@ -0,0 +1,175 @@
+/* Copyright (c) Microsoft Corporation.
+ * Licensed under the MIT License. */
+
+#include "connection_supervisor.h"
+
+/* Kernel includes. */
+#include "FreeRTOS.h"
+
+/* Demo Specific configs. */
+#include "demo_config.h"
+
+/*-----------------------------------------------------------*/
+
+static const char * const pcErrorClassNames[ eConnectionSupervisorErrorClassCount ] =
+{
+    "transient",
+    "auth",
+    "fatal"
+};
+/*-----------------------------------------------------------*/
+
+void ConnectionSupervisor_Init( ConnectionSupervisor_t * pxSupervisor,
+                                bool xCanReprovision )
+{
+    uint32_t ulIndex;
+
+    configASSERT( pxSupervisor != NULL );
+
+    pxSupervisor->xCanReprovision = xCanReprovision;
+    pxSupervisor->xRecovering = false;
+    pxSupervisor->ulRetryCount = 0;
+    pxSupervisor->ulAuthFailureCount = 0;
+
+    for( ulIndex = 0; ulIndex < eConnectionSupervisorErrorClassCount; ulIndex++ )
+    {
+        pxSupervisor->xMetrics[ ulIndex ].ulRecoveryCount = 0;
+        pxSupervisor->xMetrics[ ulIndex ].ullTotalTimeToRecoverMs = 0;
+        pxSupervisor->xMetrics[ ulIndex ].ulMaxTimeToRecoverMs = 0;
+    }
+}
+/*-----------------------------------------------------------*/
+
+ConnectionSupervisorErrorClass_t ConnectionSupervisor_Classify( ConnectionSupervisorStage_t xStage,
+                                                                AzureIoTResult_t xResult )
+{
+    /* Invalid arguments or buffers too small come from the configuration,
+     * they fail the same way on every connection. */
+    if( ( xResult == eAzureIoTErrorInvalidArgument ) ||
+        ( xResult == eAzureIoTErrorOutOfMemory ) ||
+        ( xResult == eAzureIoTErrorInitFailed ) )
+    {
+        return eConnectionSupervisorErrorFatal;
+    }
+
+    /* The IoT Hub refuses the MQTT connection for its credentials, or
+     * because the device was disabled or moved to another IoT Hub, and the
+     * Provisioning service refuses the registration, with a server error.
+     * Timeouts and network errors while connecting are transient. */
+    if( ( ( xStage == eConnectionSupervisorStageConnect ) || ( xStage == eConnectionSupervisorStageProvision ) ) &&
+        ( xResult == eAzureIoTErrorServerError ) )
+    {
+        return eConnectionSupervisorErrorAuth;
+    }
+
+    return eConnectionSupervisorErrorTransient;
+}
+/*-----------------------------------------------------------*/
+
+ConnectionSupervisorAction_t ConnectionSupervisor_ReportFailure( ConnectionSupervisor_t * pxSupervisor,
+                                                                 ConnectionSupervisorStage_t xStage,
+                                                                 AzureIoTResult_t xResult,
+                                                                 uint64_t ullNowMs )
+{
+    ConnectionSupervisorErrorClass_t xClass = ConnectionSupervisor_Classify( xStage, xResult );
+
+    if( !pxSupervisor->xRecovering )
+    {
+        pxSupervisor->xRecovering = true;
+        pxSupervisor->xOutageClass = xClass;
+        pxSupervisor->ullOutageStartMs = ullNowMs;
+        pxSupervisor->ulRetryCount = 0;
+        pxSupervisor->ulAuthFailureCount = 0;
+    }
+    else if( xClass > pxSupervisor->xOutageClass )
+    {
+        pxSupervisor->xOutageClass = xClass;
+    }
+
+    LogWarn( ( "%s failure at stage %d: result 0x%08x", pcErrorClassNames[ xClass ], xStage, xResult ) );
+
+    if( xClass == eConnectionSupervisorErrorFatal )
+    {
+        return eConnectionSupervisorActionHalt;
+    }
+
+    if( xStage == eConnectionSupervisorStageProvision )
+    {
+        return eConnectionSupervisorActionReprovision;
+    }
+
+    if( xClass == eConnectionSupervisorErrorAuth )
+    {
+        pxSupervisor->ulAuthFailureCount++;
+
+        return ( pxSupervisor->xCanReprovision &&
+                 ( pxSupervisor->ulAuthFailureCount >= connectionsupervisorAUTH_FAILURES_BEFORE_REPROVISION ) ) ?
+               eConnectionSupervisorActionReprovision : eConnectionSupervisorActionReconnect;
+    }
+
+    /* A publish that failed on its own may go through on a second try,
+     * other failures leave the connection in an unknown state. */
+    if( ( xStage == eConnectionSupervisorStagePublish ) &&
+        ( pxSupervisor->ulRetryCount < connectionsupervisorMAX_RETRIES ) )
+    {
+        pxSupervisor->ulRetryCount++;
+
+        return eConnectionSupervisorActionRetry;
+    }
+
+    return eConnectionSupervisorActionReconnect;
+}
+/*-----------------------------------------------------------*/
+
+void ConnectionSupervisor_ReportRecovered( ConnectionSupervisor_t * pxSupervisor,
+                                           uint64_t ullNowMs )
+{
+    ConnectionSupervisorMetrics_t * pxMetrics;
+    uint32_t ulTimeToRecoverMs;
+
+    if( !pxSupervisor->xRecovering )
+    {
+        return;
+    }
+
+    ulTimeToRecoverMs = ( uint32_t ) ( ullNowMs - pxSupervisor->ullOutageStartMs );
+    pxMetrics = &pxSupervisor->xMetrics[ pxSupervisor->xOutageClass ];
+    pxMetrics->ulRecoveryCount++;
+    pxMetrics->ullTotalTimeToRecoverMs += ulTimeToRecoverMs;
+
+    if( ulTimeToRecoverMs > pxMetrics->ulMaxTimeToRecoverMs )
+    {
+        pxMetrics->ulMaxTimeToRecoverMs = ulTimeToRecoverMs;
+    }
+
+    pxSupervisor->xRecovering = false;
+
+    LogInfo( ( "Recovered from %s failure in %u ms, mean %u ms over %u recoveries.",
+               pcErrorClassNames[ pxSupervisor->xOutageClass ], ulTimeToRecoverMs,
+               ConnectionSupervisor_GetMeanTimeToRecover( pxSupervisor, pxSupervisor->xOutageClass ),
+               pxMetrics->ulRecoveryCount ) );
+}
+/*-----------------------------------------------------------*/
+
+const ConnectionSupervisorMetrics_t * ConnectionSupervisor_GetMetrics( const ConnectionSupervisor_t * pxSupervisor,
+                                                                        ConnectionSupervisorErrorClass_t xClass )
+{
+    configASSERT( xClass < eConnectionSupervisorErrorClassCount );
+
+    return &pxSupervisor->xMetrics[ xClass ];
+}
+/*-----------------------------------------------------------*/
+
+uint32_t ConnectionSupervisor_GetMeanTimeToRecover( const ConnectionSupervisor_t * pxSupervisor,
+                                                    ConnectionSupervisorErrorClass_t xClass )
+{
+    const ConnectionSupervisorMetrics_t * pxMetrics = ConnectionSupervisor_GetMetrics( pxSupervisor, xClass );
+
+    if( pxMetrics->ulRecoveryCount == 0 )
+    {
+        return 0;
+    }
+
+    return ( uint32_t ) ( pxMetrics->ullTotalTimeToRecoverMs / pxMetrics->ulRecoveryCount );
+}
+/*-----------------------------------------------------------*/
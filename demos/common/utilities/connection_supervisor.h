@@ -0,0 +1,164 @@
+/* Copyright (c) Microsoft Corporation.
+ * Licensed under the MIT License. */
+
+/**
+ * @file connection_supervisor.h
+ * @brief Recovery decisions for the failures of a sample connected to Azure IoT.
+ *
+ * Each failure is classified by the stage it happened in and its result:
+ * - transient, such as a lost connection, fixed by doing the operation again
+ *   or by reconnecting;
+ * - auth, the IoT Hub refusing the device, fixed by reconnecting with a new
+ *   token, then by asking the Provisioning service for the IoT Hub again;
+ * - fatal, such as an invalid configuration, that no reconnection fixes.
+ *
+ * The supervisor picks the least disruptive recovery that has not failed yet
+ * during the current outage. Once the sample reports that it is back to
+ * normal, the outage ends and its duration is added to the time to recover
+ * of its class.
+ */
+
+#ifndef CONNECTION_SUPERVISOR_H
+#define CONNECTION_SUPERVISOR_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "azure_iot_result.h"
+
+/**
+ * @brief Number of times an operation is repeated on the same connection before reconnecting.
+ */
+#ifndef connectionsupervisorMAX_RETRIES
+    #define connectionsupervisorMAX_RETRIES                         ( 1U )
+#endif
+
+/**
+ * @brief Number of refused connections before provisioning again.
+ */
+#ifndef connectionsupervisorAUTH_FAILURES_BEFORE_REPROVISION
+    #define connectionsupervisorAUTH_FAILURES_BEFORE_REPROVISION    ( 2U )
+#endif
+
+/**
+ * @brief Operation that failed.
+ */
+typedef enum ConnectionSupervisorStage
+{
+    eConnectionSupervisorStageProvision = 0, /**< Registration with the Provisioning service. */
+    eConnectionSupervisorStageTransport,     /**< TLS connection. */
+    eConnectionSupervisorStageConnect,       /**< MQTT connection. */
+    eConnectionSupervisorStageSubscribe,
+    eConnectionSupervisorStagePublish,       /**< Telemetry or reported properties. */
+    eConnectionSupervisorStageProcessLoop
+} ConnectionSupervisorStage_t;
+
+/**
+ * @brief Class of a failure.
+ */
+typedef enum ConnectionSupervisorErrorClass
+{
+    eConnectionSupervisorErrorTransient = 0,
+    eConnectionSupervisorErrorAuth,
+    eConnectionSupervisorErrorFatal,
+    eConnectionSupervisorErrorClassCount
+} ConnectionSupervisorErrorClass_t;
+
+/**
+ * @brief Recovery to perform, from the least to the most disruptive.
+ */
+typedef enum ConnectionSupervisorAction
+{
+    eConnectionSupervisorActionRetry = 0,   /**< Do the operation again, on the same connection. */
+    eConnectionSupervisorActionReconnect,   /**< Close the connection and open a new one. */
+    eConnectionSupervisorActionReprovision, /**< Register with the Provisioning service, then connect. */
+    eConnectionSupervisorActionHalt         /**< Stop, nothing can be recovered. */
+} ConnectionSupervisorAction_t;
+
+/**
+ * @brief Time to recover from the outages of one class.
+ */
+typedef struct ConnectionSupervisorMetrics
+{
+    uint32_t ulRecoveryCount;
+    uint64_t ullTotalTimeToRecoverMs;
+    uint32_t ulMaxTimeToRecoverMs;
+} ConnectionSupervisorMetrics_t;
+
+/**
+ * @brief Supervisor state. Initialize with ConnectionSupervisor_Init().
+ */
+typedef struct ConnectionSupervisor
+{
+    bool xCanReprovision;
+    bool xRecovering;
+    ConnectionSupervisorErrorClass_t xOutageClass; /**< Worst class of the current outage. */
+    uint64_t ullOutageStartMs;
+    uint32_t ulRetryCount;
+    uint32_t ulAuthFailureCount;
+    ConnectionSupervisorMetrics_t xMetrics[ eConnectionSupervisorErrorClassCount ];
+} ConnectionSupervisor_t;
+
+/**
+ * @brief Initialize a supervisor, with no outage and empty metrics.
+ *
+ * @param[out] pxSupervisor The supervisor.
+ * @param[in] xCanReprovision Whether the sample gets its IoT Hub from the Provisioning service.
+ */
+void ConnectionSupervisor_Init( ConnectionSupervisor_t * pxSupervisor,
+                                bool xCanReprovision );
+
+/**
+ * @brief Class of a failure.
+ *
+ * @param[in] xStage Operation that failed.
+ * @param[in] xResult Result of the operation.
+ * @return The class of the failure.
+ */
+ConnectionSupervisorErrorClass_t ConnectionSupervisor_Classify( ConnectionSupervisorStage_t xStage,
+                                                                AzureIoTResult_t xResult );
+
+/**
+ * @brief Report a failure, starting an outage if none is going on, and get the recovery to perform.
+ *
+ * @param[in,out] pxSupervisor The supervisor.
+ * @param[in] xStage Operation that failed.
+ * @param[in] xResult Result of the operation.
+ * @param[in] ullNowMs Current time in milliseconds.
+ * @return The recovery to perform.
+ */
+ConnectionSupervisorAction_t ConnectionSupervisor_ReportFailure( ConnectionSupervisor_t * pxSupervisor,
+                                                                 ConnectionSupervisorStage_t xStage,
+                                                                 AzureIoTResult_t xResult,
+                                                                 uint64_t ullNowMs );
+
+/**
+ * @brief Report that the sample is back to normal, ending the current outage if any.
+ *
+ * @param[in,out] pxSupervisor The supervisor.
+ * @param[in] ullNowMs Current time in milliseconds.
+ */
+void ConnectionSupervisor_ReportRecovered( ConnectionSupervisor_t * pxSupervisor,
+                                           uint64_t ullNowMs );
+
+/**
+ * @brief Time to recover from the outages of one class.
+ *
+ * @param[in] pxSupervisor The supervisor.
+ * @param[in] xClass Class of the outages.
+ * @return The metrics of the class.
+ */
+const ConnectionSupervisorMetrics_t * ConnectionSupervisor_GetMetrics( const ConnectionSupervisor_t * pxSupervisor,
+                                                                        ConnectionSupervisorErrorClass_t xClass );
+
+/**
+ * @brief Mean time to recover from the outages of one class.
+ *
+ * @param[in] pxSupervisor The supervisor.
+ * @param[in] xClass Class of the outages.
+ * @return The mean time in milliseconds, 0 if none ended yet.
+ */
+uint32_t ConnectionSupervisor_GetMeanTimeToRecover( const ConnectionSupervisor_t * pxSupervisor,
+                                                    ConnectionSupervisorErrorClass_t xClass );
+
+#endif /* CONNECTION_SUPERVISOR_H */
@@ -0,0 +1,128 @@
+/* Copyright (c) Microsoft Corporation.
+ * Licensed under the MIT License. */
+
+#include "deadline_scheduler.h"
+
+/* Kernel includes. */
+#include "FreeRTOS.h"
+#include "task.h"
+
+/*-----------------------------------------------------------*/
+
+void DeadlineScheduler_Init( DeadlineScheduler_t * pxScheduler,
+                             DeadlineSchedulerEntry_t * pxEntries,
+                             uint32_t ulEntryCount )
+{
+    uint32_t ulIndex;
+
+    configASSERT( ( pxScheduler != NULL ) && ( ( pxEntries != NULL ) || ( ulEntryCount == 0 ) ) );
+
+    pxScheduler->pxEntries = pxEntries;
+    pxScheduler->ulEntryCount = ulEntryCount;
+
+    for( ulIndex = 0; ulIndex < ulEntryCount; ulIndex++ )
+    {
+        pxEntries[ ulIndex ].xArmed = false;
+    }
+}
+/*-----------------------------------------------------------*/
+
+void DeadlineScheduler_Arm( DeadlineScheduler_t * pxScheduler,
+                            uint32_t ulEntry,
+                            uint64_t ullDeadline,
+                            uint64_t ullPeriod )
+{
+    DeadlineSchedulerEntry_t * pxEntry;
+
+    configASSERT( ulEntry < pxScheduler->ulEntryCount );
+
+    pxEntry = &pxScheduler->pxEntries[ ulEntry ];
+    pxEntry->ullDeadline = ullDeadline;
+    pxEntry->ullPeriod = ullPeriod;
+    pxEntry->xArmed = true;
+}
+/*-----------------------------------------------------------*/
+
+void DeadlineScheduler_Disarm( DeadlineScheduler_t * pxScheduler,
+                               uint32_t ulEntry )
+{
+    configASSERT( ulEntry < pxScheduler->ulEntryCount );
+
+    pxScheduler->pxEntries[ ulEntry ].xArmed = false;
+}
+/*-----------------------------------------------------------*/
+
+bool DeadlineScheduler_Due( DeadlineScheduler_t * pxScheduler,
+                            uint32_t ulEntry,
+                            uint64_t ullNow )
+{
+    DeadlineSchedulerEntry_t * pxEntry;
+
+    configASSERT( ulEntry < pxScheduler->ulEntryCount );
+
+    pxEntry = &pxScheduler->pxEntries[ ulEntry ];
+
+    if( !pxEntry->xArmed || ( pxEntry->ullDeadline > ullNow ) )
+    {
+        return false;
+    }
+
+    if( pxEntry->ullPeriod == 0 )
+    {
+        pxEntry->xArmed = false;
+    }
+    else
+    {
+        /* Skip the periods missed, keeping to the original phase. */
+        pxEntry->ullDeadline += pxEntry->ullPeriod * ( ( ullNow - pxEntry->ullDeadline ) / pxEntry->ullPeriod + 1 );
+    }
+
+    return true;
+}
+/*-----------------------------------------------------------*/
+
+uint64_t DeadlineScheduler_TimeToNext( const DeadlineScheduler_t * pxScheduler,
+                                       uint64_t ullNow,
+                                       uint64_t ullMaxWait )
+{
+    const DeadlineSchedulerEntry_t * pxEntry;
+    uint64_t ullWait = ullMaxWait;
+    uint32_t ulIndex;
+
+    for( ulIndex = 0; ulIndex < pxScheduler->ulEntryCount; ulIndex++ )
+    {
+        pxEntry = &pxScheduler->pxEntries[ ulIndex ];
+
+        if( !pxEntry->xArmed )
+        {
+            continue;
+        }
+
+        if( pxEntry->ullDeadline <= ullNow )
+        {
+            return 0;
+        }
+
+        if( ( pxEntry->ullDeadline - ullNow ) < ullWait )
+        {
+            ullWait = pxEntry->ullDeadline - ullNow;
+        }
+    }
+
+    return ullWait;
+}
+/*-----------------------------------------------------------*/
+
+uint64_t DeadlineScheduler_GetTimeMs( void )
+{
+    static TickType_t xLastTickCount = 0;
+    static uint64_t ullTicks = 0;
+    TickType_t xTickCount = xTaskGetTickCount();
+
+    /* Unsigned subtraction gives the ticks elapsed across a wrap around. */
+    ullTicks += ( TickType_t ) ( xTickCount - xLastTickCount );
+    xLastTickCount = xTickCount;
+
+    return ( ullTicks * 1000U ) / configTICK_RATE_HZ;
+}
+/*-----------------------------------------------------------*/
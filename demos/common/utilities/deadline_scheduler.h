@@ -0,0 +1,112 @@
+/* Copyright (c) Microsoft Corporation.
+ * Licensed under the MIT License. */
+
+/**
+ * @file deadline_scheduler.h
+ * @brief Earliest-deadline bookkeeping for the main loop of a sample.
+ *
+ * Each piece of periodic or delayed work, such as sending telemetry or
+ * renewing a token, is an entry with a deadline. The loop runs the entries
+ * that are due, then blocks until the earliest deadline left, or until the
+ * network has data, rather than polling at a fixed pace.
+ */
+
+#ifndef DEADLINE_SCHEDULER_H
+#define DEADLINE_SCHEDULER_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+/**
+ * @brief Deadline of a piece of work.
+ */
+typedef struct DeadlineSchedulerEntry
+{
+    uint64_t ullDeadline;
+    uint64_t ullPeriod; /**< Time between deadlines, 0 for a single one. */
+    bool xArmed;
+} DeadlineSchedulerEntry_t;
+
+/**
+ * @brief Scheduler state. Initialize with DeadlineScheduler_Init().
+ */
+typedef struct DeadlineScheduler
+{
+    DeadlineSchedulerEntry_t * pxEntries;
+    uint32_t ulEntryCount;
+} DeadlineScheduler_t;
+
+/**
+ * @brief Initialize a scheduler, with no entry armed.
+ *
+ * Times are in any unit, as long as every call uses the same one.
+ *
+ * @param[out] pxScheduler The scheduler.
+ * @param[in] pxEntries Memory of the entries, @p ulEntryCount of them.
+ * @param[in] ulEntryCount Number of entries.
+ */
+void DeadlineScheduler_Init( DeadlineScheduler_t * pxScheduler,
+                             DeadlineSchedulerEntry_t * pxEntries,
+                             uint32_t ulEntryCount );
+
+/**
+ * @brief Set the deadline of an entry.
+ *
+ * @param[in,out] pxScheduler The scheduler.
+ * @param[in] ulEntry Index of the entry.
+ * @param[in] ullDeadline First deadline.
+ * @param[in] ullPeriod Time between the next deadlines, 0 for none.
+ */
+void DeadlineScheduler_Arm( DeadlineScheduler_t * pxScheduler,
+                            uint32_t ulEntry,
+                            uint64_t ullDeadline,
+                            uint64_t ullPeriod );
+
+/**
+ * @brief Remove the deadline of an entry.
+ *
+ * @param[in,out] pxScheduler The scheduler.
+ * @param[in] ulEntry Index of the entry.
+ */
+void DeadlineScheduler_Disarm( DeadlineScheduler_t * pxScheduler,
+                               uint32_t ulEntry );
+
+/**
+ * @brief Tell whether an entry is due, and if so move it to its next deadline.
+ *
+ * A periodic entry moves to its first deadline after @p ullNow, so deadlines
+ * missed while the loop was busy run once rather than in a burst. A single
+ * deadline is disarmed.
+ *
+ * @param[in,out] pxScheduler The scheduler.
+ * @param[in] ulEntry Index of the entry.
+ * @param[in] ullNow Current time.
+ * @return `true` if the entry is armed and its deadline has passed.
+ */
+bool DeadlineScheduler_Due( DeadlineScheduler_t * pxScheduler,
+                            uint32_t ulEntry,
+                            uint64_t ullNow );
+
+/**
+ * @brief Time left until the earliest deadline.
+ *
+ * @param[in] pxScheduler The scheduler.
+ * @param[in] ullNow Current time.
+ * @param[in] ullMaxWait Value returned if no entry is armed, or if the deadline is further.
+ * @return The time left, 0 if an entry is due.
+ */
+uint64_t DeadlineScheduler_TimeToNext( const DeadlineScheduler_t * pxScheduler,
+                                       uint64_t ullNow,
+                                       uint64_t ullMaxWait );
+
+/**
+ * @brief Milliseconds elapsed since the scheduler of FreeRTOS started, from the tick count.
+ *
+ * The tick count wraps around, so this must be called more often than it
+ * does, from a single task.
+ *
+ * @return Time in milliseconds.
+ */
+uint64_t DeadlineScheduler_GetTimeMs( void );
+
+#endif /* DEADLINE_SCHEDULER_H */
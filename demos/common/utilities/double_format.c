@@ -0,0 +1,223 @@
+/* Copyright (c) Microsoft Corporation.
+ * Licensed under the MIT License. */
+
+#include "double_format.h"
+
+/* Standard includes. */
+#include <math.h>
+#include <stdbool.h>
+
+/*-----------------------------------------------------------*/
+
+/**
+ * @brief Magnitudes from 2^53 on are not formatted, as doubles no longer hold
+ *  every integer there.
+ */
+#define doubleformatMAGNITUDE_LIMIT    ( 9007199254740992.0 )
+
+/**
+ * @brief Fractions below 2^-32 round to zero at any supported number of digits.
+ */
+#define doubleformatFRACTION_FLOOR     ( 2.3283064365386962890625e-10 )
+
+/**
+ * @brief Fractions are split in limbs of 28 bits, whose products by a power of
+ *  10 fit in 64 bits.
+ */
+#define doubleformatLIMB_BITS          ( 28U )
+#define doubleformatLIMB_SCALE         ( 268435456.0 )
+#define doubleformatLIMB_MASK          ( ( 1ULL << doubleformatLIMB_BITS ) - 1U )
+#define doubleformatLIMB_COUNT         ( 3U )
+/*-----------------------------------------------------------*/
+
+static const uint32_t ulPowersOf10[ doubleformatMAX_FRACTIONAL_DIGITS + 1 ] =
+{
+    1UL,
+    10UL,
+    100UL,
+    1000UL,
+    10000UL,
+    100000UL,
+    1000000UL,
+    10000000UL,
+    100000000UL,
+    1000000000UL
+};
+/*-----------------------------------------------------------*/
+
+/**
+ * @brief Write the decimal digits of @p ullValue, right aligned in @p ulWidth characters
+ *  padded with zeros, or with no padding when @p ulWidth is 0.
+ *
+ * @return Number of characters written, 0 if they do not fit.
+ */
+static uint32_t prvWriteDigits( uint64_t ullValue,
+                                uint32_t ulWidth,
+                                uint8_t * pucBuffer,
+                                uint32_t ulBufferLength )
+{
+    uint8_t ucDigits[ 20 ];
+    uint32_t ulCount = 0;
+    uint32_t ulIndex;
+
+    do
+    {
+        ucDigits[ ulCount++ ] = ( uint8_t ) ( '0' + ( ullValue % 10 ) );
+        ullValue /= 10;
+    } while( ullValue != 0 );
+
+    while( ulCount < ulWidth )
+    {
+        ucDigits[ ulCount++ ] = '0';
+    }
+
+    if( ulCount > ulBufferLength )
+    {
+        return 0;
+    }
+
+    for( ulIndex = 0; ulIndex < ulCount; ulIndex++ )
+    {
+        pucBuffer[ ulIndex ] = ucDigits[ ulCount - 1 - ulIndex ];
+    }
+
+    return ulCount;
+}
+/*-----------------------------------------------------------*/
+
+/**
+ * @brief Round @p xFraction times @p ulPower to nearest, ties to even.
+ *
+ * A fraction of at least 2^-32 is exactly three limbs of 28 bits, so the
+ * product and its rounding are computed exactly, with integers only.
+ *
+ * @param[in] xFraction Fraction, in [0, 1).
+ * @param[in] ulPower Power of 10 to scale by.
+ * @param[in] ullIntegerPart Integer part of the value, which decides ties when @p ulPower is 1.
+ * @return The rounded product, up to @p ulPower.
+ */
+static uint64_t prvRoundFraction( double xFraction,
+                                  uint32_t ulPower,
+                                  uint64_t ullIntegerPart )
+{
+    uint64_t ullLimbs[ doubleformatLIMB_COUNT ];
+    uint64_t ullProduct = 0;
+    uint64_t ullScaled;
+    uint64_t ullHalf = 1ULL << ( doubleformatLIMB_BITS - 1U );
+    bool xLowerBitsZero = true;
+    uint32_t ulIndex;
+
+    if( xFraction < doubleformatFRACTION_FLOOR )
+    {
+        return 0;
+    }
+
+    /* Scaling by powers of 2 and removing the integer part are exact. */
+    for( ulIndex = 0; ulIndex < doubleformatLIMB_COUNT; ulIndex++ )
+    {
+        xFraction *= doubleformatLIMB_SCALE;
+        ullLimbs[ ulIndex ] = ( uint64_t ) xFraction;
+        xFraction -= ( double ) ullLimbs[ ulIndex ];
+    }
+
+    /* Multiply from the lowest limb, the highest one ends with the integer
+     * part of the product above its 28 most significant fractional bits. */
+    for( ulIndex = doubleformatLIMB_COUNT; ulIndex-- > 0; )
+    {
+        ullProduct = ullLimbs[ ulIndex ] * ulPower + ( ullProduct >> doubleformatLIMB_BITS );
+
+        if( ( ulIndex > 0 ) && ( ( ullProduct & doubleformatLIMB_MASK ) != 0 ) )
+        {
+            xLowerBitsZero = false;
+        }
+    }
+
+    ullScaled = ullProduct >> doubleformatLIMB_BITS;
+    ullProduct &= doubleformatLIMB_MASK;
+
+    if( ( ullProduct > ullHalf ) ||
+        ( ( ullProduct == ullHalf ) &&
+          ( !xLowerBitsZero || ( ( ( ( ulPower == 1 ) ? ullIntegerPart : ullScaled ) & 1U ) != 0 ) ) ) )
+    {
+        ullScaled++;
+    }
+
+    return ullScaled;
+}
+/*-----------------------------------------------------------*/
+
+uint32_t DoubleFormat_Fixed( double xValue,
+                             uint32_t ulFractionalDigits,
+                             uint8_t * pucBuffer,
+                             uint32_t ulBufferLength )
+{
+    bool xNegative = signbit( xValue ) != 0;
+    double xMagnitude = xNegative ? -xValue : xValue;
+    uint64_t ullIntegerPart;
+    uint64_t ullFractionalPart;
+    uint32_t ulLength = 0;
+    uint32_t ulWritten;
+
+    if( ulFractionalDigits > doubleformatMAX_FRACTIONAL_DIGITS )
+    {
+        return 0;
+    }
+
+    /* Also false for NaN and infinities. */
+    if( !( xMagnitude < doubleformatMAGNITUDE_LIMIT ) )
+    {
+        return 0;
+    }
+
+    /* Below 2^53 the integer part and the fraction are exact, so the digits
+     * are those of the exact value. */
+    ullIntegerPart = ( uint64_t ) xMagnitude;
+    ullFractionalPart = prvRoundFraction( xMagnitude - ( double ) ullIntegerPart,
+                                          ulPowersOf10[ ulFractionalDigits ], ullIntegerPart );
+
+    if( ullFractionalPart == ulPowersOf10[ ulFractionalDigits ] )
+    {
+        ullIntegerPart++;
+        ullFractionalPart = 0;
+    }
+
+    /* As printf does, negative values keep their sign when they round to zero. */
+    if( xNegative )
+    {
+        if( ulBufferLength == 0 )
+        {
+            return 0;
+        }
+
+        pucBuffer[ ulLength++ ] = '-';
+    }
+
+    if( ( ulWritten = prvWriteDigits( ullIntegerPart, 0,
+                                      pucBuffer + ulLength, ulBufferLength - ulLength ) ) == 0 )
+    {
+        return 0;
+    }
+
+    ulLength += ulWritten;
+
+    if( ulFractionalDigits > 0 )
+    {
+        if( ulLength == ulBufferLength )
+        {
+            return 0;
+        }
+
+        pucBuffer[ ulLength++ ] = '.';
+
+        if( ( ulWritten = prvWriteDigits( ullFractionalPart, ulFractionalDigits,
+                                          pucBuffer + ulLength, ulBufferLength - ulLength ) ) == 0 )
+        {
+            return 0;
+        }
+
+        ulLength += ulWritten;
+    }
+
+    return ulLength;
+}
+/*-----------------------------------------------------------*/
@@ -0,0 +1,50 @@
+/* Copyright (c) Microsoft Corporation.
+ * Licensed under the MIT License. */
+
+/**
+ * @file double_format.h
+ * @brief Locale independent, allocation free formatting of doubles.
+ *
+ * Formats with a fixed number of fractional digits using integer arithmetic
+ * only, so telemetry payloads can be built without pulling the floating point
+ * support of printf, and its stack usage, into the image.
+ */
+
+#ifndef DOUBLE_FORMAT_H
+#define DOUBLE_FORMAT_H
+
+#include <stdint.h>
+
+/**
+ * @brief Maximum number of fractional digits supported.
+ */
+#define doubleformatMAX_FRACTIONAL_DIGITS    ( 9U )
+
+/**
+ * @brief Buffer size large enough for any value accepted by DoubleFormat_Fixed().
+ *
+ * Sign, 16 integer digits, decimal point and the fractional digits.
+ */
+#define doubleformatMAX_LENGTH               ( 1U + 16U + 1U + doubleformatMAX_FRACTIONAL_DIGITS )
+
+/**
+ * @brief Format @p xValue with @p ulFractionalDigits digits after the decimal point.
+ *
+ * The exact value is rounded to nearest, ties to even, giving the same text as
+ * "%.*f", including the sign of negative values that round to zero. The output
+ * is not NULL terminated.
+ *
+ * @param[in] xValue Value to format.
+ * @param[in] ulFractionalDigits Digits after the decimal point, up to #doubleformatMAX_FRACTIONAL_DIGITS.
+ *            With 0 no decimal point is written.
+ * @param[out] pucBuffer Buffer receiving the text.
+ * @param[in] ulBufferLength Size of @p pucBuffer.
+ * @return Number of characters written, or 0 if @p xValue is not finite, its
+ *         magnitude is 2^53 or more, or @p pucBuffer is too small.
+ */
+uint32_t DoubleFormat_Fixed( double xValue,
+                             uint32_t ulFractionalDigits,
+                             uint8_t * pucBuffer,
+                             uint32_t ulBufferLength );
+
+#endif /* DOUBLE_FORMAT_H */
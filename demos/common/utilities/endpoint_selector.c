@@ -0,0 +1,154 @@
+/* Copyright (c) Microsoft Corporation.
+ * Licensed under the MIT License. */
+
+#include "endpoint_selector.h"
+
+/* Kernel includes. */
+#include "FreeRTOS.h"
+
+/* Demo Specific configs. */
+#include "demo_config.h"
+
+/*-----------------------------------------------------------*/
+
+/**
+ * @brief Whether an endpoint is healthier than another: fewer failures,
+ *  then reachable, then a lower round-trip time, a measured one being lower than none.
+ */
+static bool prvIsHealthier( const EndpointSelectorEntry_t * pxEntry,
+                            const EndpointSelectorEntry_t * pxOther )
+{
+    if( pxEntry->ulConsecutiveFailures != pxOther->ulConsecutiveFailures )
+    {
+        return pxEntry->ulConsecutiveFailures < pxOther->ulConsecutiveFailures;
+    }
+
+    if( pxEntry->xUnreachable != pxOther->xUnreachable )
+    {
+        return pxOther->xUnreachable;
+    }
+
+    if( pxEntry->xProbed != pxOther->xProbed )
+    {
+        return pxEntry->xProbed;
+    }
+
+    return pxEntry->xProbed && ( pxEntry->ulSmoothedRttMs < pxOther->ulSmoothedRttMs );
+}
+/*-----------------------------------------------------------*/
+
+void EndpointSelector_Init( EndpointSelector_t * pxSelector,
+                            EndpointSelectorEntry_t * pxEntries,
+                            uint32_t ulEntryCount )
+{
+    uint32_t ulIndex;
+
+    configASSERT( pxSelector != NULL );
+    configASSERT( pxEntries != NULL );
+    configASSERT( ulEntryCount > 0 );
+
+    for( ulIndex = 0; ulIndex < ulEntryCount; ulIndex++ )
+    {
+        pxEntries[ ulIndex ].ulConsecutiveFailures = 0;
+        pxEntries[ ulIndex ].ulSmoothedRttMs = 0;
+        pxEntries[ ulIndex ].xProbed = false;
+        pxEntries[ ulIndex ].xUnreachable = false;
+    }
+
+    pxSelector->pxEntries = pxEntries;
+    pxSelector->ulEntryCount = ulEntryCount;
+    pxSelector->ulCurrent = 0;
+    pxSelector->ulFailoverCount = 0;
+}
+/*-----------------------------------------------------------*/
+
+const EndpointSelectorEntry_t * EndpointSelector_Select( EndpointSelector_t * pxSelector )
+{
+    const EndpointSelectorEntry_t * pxCurrent = &pxSelector->pxEntries[ pxSelector->ulCurrent ];
+    const EndpointSelectorEntry_t * pxEntry;
+    uint32_t ulBest = pxSelector->ulCurrent;
+    uint32_t ulIndex;
+
+    for( ulIndex = 0; ulIndex < pxSelector->ulEntryCount; ulIndex++ )
+    {
+        pxEntry = &pxSelector->pxEntries[ ulIndex ];
+
+        if( ( ulIndex == pxSelector->ulCurrent ) || pxEntry->xUnreachable ||
+            ( ( ulBest != pxSelector->ulCurrent ) && !prvIsHealthier( pxEntry, &pxSelector->pxEntries[ ulBest ] ) ) )
+        {
+            continue;
+        }
+
+        if( pxCurrent->ulConsecutiveFailures >= endpointselectorFAILOVER_THRESHOLD )
+        {
+            /* Leave a failing endpoint for any that failed less, there is
+             * nothing to gain moving between endpoints that all fail. */
+            if( pxEntry->ulConsecutiveFailures < pxCurrent->ulConsecutiveFailures )
+            {
+                ulBest = ulIndex;
+            }
+        }
+        else if( ( pxEntry->ulConsecutiveFailures == 0 ) && pxEntry->xProbed && pxCurrent->xProbed &&
+                 ( ( pxEntry->ulSmoothedRttMs + endpointselectorRTT_HYSTERESIS_MS ) < pxCurrent->ulSmoothedRttMs ) )
+        {
+            ulBest = ulIndex;
+        }
+    }
+
+    if( ulBest != pxSelector->ulCurrent )
+    {
+        pxSelector->ulFailoverCount++;
+        LogWarn( ( "Moving from %s (%u failures, %u ms) to %s (%u failures, %u ms), move %u.",
+                   pxCurrent->pucHostName, pxCurrent->ulConsecutiveFailures, pxCurrent->ulSmoothedRttMs,
+                   pxSelector->pxEntries[ ulBest ].pucHostName,
+                   pxSelector->pxEntries[ ulBest ].ulConsecutiveFailures,
+                   pxSelector->pxEntries[ ulBest ].ulSmoothedRttMs,
+                   pxSelector->ulFailoverCount ) );
+        pxSelector->ulCurrent = ulBest;
+    }
+
+    return &pxSelector->pxEntries[ pxSelector->ulCurrent ];
+}
+/*-----------------------------------------------------------*/
+
+void EndpointSelector_ReportConnection( EndpointSelector_t * pxSelector,
+                                        bool xSuccess )
+{
+    EndpointSelectorEntry_t * pxCurrent = &pxSelector->pxEntries[ pxSelector->ulCurrent ];
+
+    if( xSuccess )
+    {
+        pxCurrent->ulConsecutiveFailures = 0;
+    }
+    else if( pxCurrent->ulConsecutiveFailures < UINT32_MAX )
+    {
+        pxCurrent->ulConsecutiveFailures++;
+    }
+}
+/*-----------------------------------------------------------*/
+
+void EndpointSelector_ReportProbe( EndpointSelector_t * pxSelector,
+                                   uint32_t ulEntry,
+                                   bool xSuccess,
+                                   uint32_t ulRttMs )
+{
+    EndpointSelectorEntry_t * pxEntry;
+
+    configASSERT( ulEntry < pxSelector->ulEntryCount );
+
+    pxEntry = &pxSelector->pxEntries[ ulEntry ];
+
+    pxEntry->xUnreachable = !xSuccess;
+
+    if( !xSuccess )
+    {
+        return;
+    }
+
+    /* Smooth the measures by 1/8, as TCP does its round-trip time,
+     * so one slow probe does not move the device. */
+    pxEntry->ulSmoothedRttMs = pxEntry->xProbed ?
+                               ( ( pxEntry->ulSmoothedRttMs * 7U ) + ulRttMs ) / 8U : ulRttMs;
+    pxEntry->xProbed = true;
+}
+/*-----------------------------------------------------------*/
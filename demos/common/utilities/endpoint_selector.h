@@ -0,0 +1,107 @@
+/* Copyright (c) Microsoft Corporation.
+ * Licensed under the MIT License. */
+
+/**
+ * @file endpoint_selector.h
+ * @brief Choice of the IoT Hub endpoint to connect to, among geo-redundant ones.
+ *
+ * Each endpoint keeps its count of consecutive failed connections, and a
+ * smoothed round-trip time measured by probes such as a TCP connect. Only
+ * connections count as failures or successes: an endpoint that accepts TCP
+ * connections may still refuse the device. A probe that gets no answer only
+ * marks the endpoint unreachable until the next one does.
+ * The selector stays on the current endpoint until it fails
+ * endpointselectorFAILOVER_THRESHOLD times in a row, or until another healthy
+ * endpoint answers faster by more than endpointselectorRTT_HYSTERESIS_MS, so
+ * close endpoints do not take turns.
+ */
+
+#ifndef ENDPOINT_SELECTOR_H
+#define ENDPOINT_SELECTOR_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+/**
+ * @brief Number of consecutive failures after which the current endpoint is left.
+ */
+#ifndef endpointselectorFAILOVER_THRESHOLD
+    #define endpointselectorFAILOVER_THRESHOLD    ( 2U )
+#endif
+
+/**
+ * @brief Round-trip time in milliseconds another endpoint must gain to be chosen
+ * over a healthy current one.
+ */
+#ifndef endpointselectorRTT_HYSTERESIS_MS
+    #define endpointselectorRTT_HYSTERESIS_MS     ( 100U )
+#endif
+
+/**
+ * @brief An endpoint and its health.
+ */
+typedef struct EndpointSelectorEntry
+{
+    const uint8_t * pucHostName; /**< Null terminated. */
+    uint32_t ulHostNameLength;
+    uint32_t ulConsecutiveFailures;
+    uint32_t ulSmoothedRttMs;
+    bool xProbed;                /**< Whether ulSmoothedRttMs holds a measure. */
+    bool xUnreachable;           /**< Whether the last probe got no answer. */
+} EndpointSelectorEntry_t;
+
+/**
+ * @brief Selector state. Initialize with EndpointSelector_Init().
+ */
+typedef struct EndpointSelector
+{
+    EndpointSelectorEntry_t * pxEntries;
+    uint32_t ulEntryCount;
+    uint32_t ulCurrent;
+    uint32_t ulFailoverCount;
+} EndpointSelector_t;
+
+/**
+ * @brief Initialize a selector on its first endpoint, with every endpoint healthy and not probed.
+ *
+ * @param[out] pxSelector The selector.
+ * @param[in] pxEntries The endpoints, with their host names set, in order of preference.
+ * @param[in] ulEntryCount Number of endpoints, at least 1.
+ */
+void EndpointSelector_Init( EndpointSelector_t * pxSelector,
+                            EndpointSelectorEntry_t * pxEntries,
+                            uint32_t ulEntryCount );
+
+/**
+ * @brief Choose the endpoint of the next connection.
+ *
+ * @param[in,out] pxSelector The selector.
+ * @return The endpoint.
+ */
+const EndpointSelectorEntry_t * EndpointSelector_Select( EndpointSelector_t * pxSelector );
+
+/**
+ * @brief Report the result of a connection to the current endpoint.
+ *
+ * @param[in,out] pxSelector The selector.
+ * @param[in] xSuccess Whether the connection succeeded.
+ */
+void EndpointSelector_ReportConnection( EndpointSelector_t * pxSelector,
+                                        bool xSuccess );
+
+/**
+ * @brief Report the result of a probe of an endpoint.
+ *
+ * A probe measures the endpoint, it leaves its count of failed connections alone.
+ *
+ * @param[in,out] pxSelector The selector.
+ * @param[in] ulEntry Index of the endpoint.
+ * @param[in] xSuccess Whether the endpoint answered.
+ * @param[in] ulRttMs Time the endpoint took to answer, ignored if it did not.
+ */
+void EndpointSelector_ReportProbe( EndpointSelector_t * pxSelector,
+                                   uint32_t ulEntry,
+                                   bool xSuccess,
+                                   uint32_t ulRttMs );
+
+#endif /* ENDPOINT_SELECTOR_H */
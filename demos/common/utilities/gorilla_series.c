@@ -0,0 +1,515 @@
+/* Copyright (c) Microsoft Corporation.
+ * Licensed under the MIT License. */
+
+#include "gorilla_series.h"
+
+/* Standard includes. */
+#include <string.h>
+
+/*-----------------------------------------------------------*/
+
+#define gorillaseriesMAX_RECORD_COUNT    ( 0xFFFFU )
+#define gorillaseriesMAX_LEADING_ZEROS   ( 31U )
+/*-----------------------------------------------------------*/
+
+/**
+ * @brief Leading zero bits of a non zero value.
+ */
+static uint32_t prvLeadingZeros( uint64_t ullValue )
+{
+    uint32_t ulCount = 0;
+    uint32_t ulShift;
+
+    for( ulShift = 32; ulShift > 0; ulShift >>= 1 )
+    {
+        if( ( ullValue >> ( 64 - ulShift ) ) == 0 )
+        {
+            ulCount += ulShift;
+            ullValue <<= ulShift;
+        }
+    }
+
+    return ulCount;
+}
+/*-----------------------------------------------------------*/
+
+/**
+ * @brief Trailing zero bits of a non zero value.
+ */
+static uint32_t prvTrailingZeros( uint64_t ullValue )
+{
+    uint32_t ulCount = 0;
+    uint32_t ulShift;
+
+    for( ulShift = 32; ulShift > 0; ulShift >>= 1 )
+    {
+        if( ( ullValue & ( ( 1ULL << ulShift ) - 1 ) ) == 0 )
+        {
+            ulCount += ulShift;
+            ullValue >>= ulShift;
+        }
+    }
+
+    return ulCount;
+}
+/*-----------------------------------------------------------*/
+
+/**
+ * @brief Write the @p ulBitCount low bits of @p ullValue, or only count them if @p xWrite is `false`.
+ *
+ * @return @p ulBitCount.
+ */
+static uint32_t prvPut( GorillaSeriesEncoder_t * pxEncoder,
+                        bool xWrite,
+                        uint64_t ullValue,
+                        uint32_t ulBitCount )
+{
+    uint32_t ulRemaining = ulBitCount;
+    uint32_t ulFree;
+    uint32_t ulChunk;
+    uint8_t * pucByte;
+
+    while( xWrite && ( ulRemaining > 0 ) )
+    {
+        pucByte = &pxEncoder->pucBuffer[ pxEncoder->xState.ulBitOffset / 8 ];
+        ulFree = 8 - ( pxEncoder->xState.ulBitOffset % 8 );
+
+        if( ulFree == 8 )
+        {
+            *pucByte = 0;
+        }
+
+        ulChunk = ( ulRemaining < ulFree ) ? ulRemaining : ulFree;
+        *pucByte |= ( uint8_t ) ( ( ( ullValue >> ( ulRemaining - ulChunk ) ) & ( ( 1U << ulChunk ) - 1 ) ) << ( ulFree - ulChunk ) );
+        ulRemaining -= ulChunk;
+        pxEncoder->xState.ulBitOffset += ulChunk;
+    }
+
+    return ulBitCount;
+}
+/*-----------------------------------------------------------*/
+
+static bool prvGet( GorillaSeriesDecoder_t * pxDecoder,
+                    uint32_t ulBitCount,
+                    uint64_t * pullValue )
+{
+    uint32_t ulFree;
+    uint32_t ulChunk;
+    uint8_t ucByte;
+
+    if( ( ( uint64_t ) pxDecoder->xState.ulBitOffset + ulBitCount ) > ( ( uint64_t ) pxDecoder->ulBufferLength * 8 ) )
+    {
+        return false;
+    }
+
+    *pullValue = 0;
+
+    while( ulBitCount > 0 )
+    {
+        ucByte = pxDecoder->pucBuffer[ pxDecoder->xState.ulBitOffset / 8 ];
+        ulFree = 8 - ( pxDecoder->xState.ulBitOffset % 8 );
+        ulChunk = ( ulBitCount < ulFree ) ? ulBitCount : ulFree;
+        *pullValue = ( *pullValue << ulChunk ) | ( ( ucByte >> ( ulFree - ulChunk ) ) & ( ( 1U << ulChunk ) - 1 ) );
+        ulBitCount -= ulChunk;
+        pxDecoder->xState.ulBitOffset += ulChunk;
+    }
+
+    return true;
+}
+/*-----------------------------------------------------------*/
+
+static uint32_t prvPutTime( GorillaSeriesEncoder_t * pxEncoder,
+                            bool xWrite,
+                            uint64_t ullTime )
+{
+    GorillaSeriesState_t * pxState = &pxEncoder->xState;
+    int64_t llDelta = 0;
+    int64_t llDeltaOfDelta;
+    uint32_t ulBits;
+
+    if( pxState->ulRecordCount == 0 )
+    {
+        ulBits = prvPut( pxEncoder, xWrite, ullTime, 64 );
+    }
+    else
+    {
+        llDelta = ( int64_t ) ( ullTime - pxState->ullLastTime );
+        llDeltaOfDelta = llDelta - pxState->llLastDelta;
+
+        if( llDeltaOfDelta == 0 )
+        {
+            ulBits = prvPut( pxEncoder, xWrite, 0x0, 1 );
+        }
+        else if( ( llDeltaOfDelta >= -63 ) && ( llDeltaOfDelta <= 64 ) )
+        {
+            ulBits = prvPut( pxEncoder, xWrite, 0x2, 2 );
+            ulBits += prvPut( pxEncoder, xWrite, ( uint64_t ) ( llDeltaOfDelta + 63 ), 7 );
+        }
+        else if( ( llDeltaOfDelta >= -255 ) && ( llDeltaOfDelta <= 256 ) )
+        {
+            ulBits = prvPut( pxEncoder, xWrite, 0x6, 3 );
+            ulBits += prvPut( pxEncoder, xWrite, ( uint64_t ) ( llDeltaOfDelta + 255 ), 9 );
+        }
+        else if( ( llDeltaOfDelta >= -2047 ) && ( llDeltaOfDelta <= 2048 ) )
+        {
+            ulBits = prvPut( pxEncoder, xWrite, 0xE, 4 );
+            ulBits += prvPut( pxEncoder, xWrite, ( uint64_t ) ( llDeltaOfDelta + 2047 ), 12 );
+        }
+        else
+        {
+            ulBits = prvPut( pxEncoder, xWrite, 0xF, 4 );
+            ulBits += prvPut( pxEncoder, xWrite, ( uint64_t ) llDeltaOfDelta, 64 );
+        }
+    }
+
+    if( xWrite )
+    {
+        pxState->ullLastTime = ullTime;
+        pxState->llLastDelta = llDelta;
+    }
+
+    return ulBits;
+}
+/*-----------------------------------------------------------*/
+
+static uint32_t prvPutValue( GorillaSeriesEncoder_t * pxEncoder,
+                             bool xWrite,
+                             GorillaSeriesSignal_t * pxSignal,
+                             double xValue )
+{
+    uint64_t ullBits;
+    uint64_t ullXor;
+    uint32_t ulLeadingZeros;
+    uint32_t ulTrailingZeros;
+    uint32_t ulMeaningfulBits;
+    uint32_t ulBits;
+
+    ( void ) memcpy( &ullBits, &xValue, sizeof( ullBits ) );
+    ullXor = ullBits ^ pxSignal->ullLastBits;
+
+    if( pxEncoder->xState.ulRecordCount == 0 )
+    {
+        ulBits = prvPut( pxEncoder, xWrite, ullBits, 64 );
+    }
+    else if( ullXor == 0 )
+    {
+        ulBits = prvPut( pxEncoder, xWrite, 0x0, 1 );
+    }
+    else
+    {
+        ulLeadingZeros = prvLeadingZeros( ullXor );
+        ulTrailingZeros = prvTrailingZeros( ullXor );
+
+        if( ulLeadingZeros > gorillaseriesMAX_LEADING_ZEROS )
+        {
+            ulLeadingZeros = gorillaseriesMAX_LEADING_ZEROS;
+        }
+
+        if( ( pxSignal->ucMeaningfulBits != 0 ) &&
+            ( ulLeadingZeros >= pxSignal->ucLeadingZeros ) &&
+            ( ulTrailingZeros >= ( 64U - pxSignal->ucLeadingZeros - pxSignal->ucMeaningfulBits ) ) )
+        {
+            ulBits = prvPut( pxEncoder, xWrite, 0x2, 2 );
+            ulBits += prvPut( pxEncoder, xWrite,
+                              ullXor >> ( 64U - pxSignal->ucLeadingZeros - pxSignal->ucMeaningfulBits ),
+                              pxSignal->ucMeaningfulBits );
+        }
+        else
+        {
+            ulMeaningfulBits = 64 - ulLeadingZeros - ulTrailingZeros;
+            ulBits = prvPut( pxEncoder, xWrite, 0x3, 2 );
+            ulBits += prvPut( pxEncoder, xWrite, ulLeadingZeros, 5 );
+            ulBits += prvPut( pxEncoder, xWrite, ulMeaningfulBits & 0x3F, 6 );
+            ulBits += prvPut( pxEncoder, xWrite, ullXor >> ulTrailingZeros, ulMeaningfulBits );
+
+            if( xWrite )
+            {
+                pxSignal->ucLeadingZeros = ( uint8_t ) ulLeadingZeros;
+                pxSignal->ucMeaningfulBits = ( uint8_t ) ulMeaningfulBits;
+            }
+        }
+    }
+
+    if( xWrite )
+    {
+        pxSignal->ullLastBits = ullBits;
+    }
+
+    return ulBits;
+}
+/*-----------------------------------------------------------*/
+
+/**
+ * @brief Write a record, or only count its bits if @p xWrite is `false`.
+ */
+static uint32_t prvPutRecord( GorillaSeriesEncoder_t * pxEncoder,
+                              bool xWrite,
+                              uint64_t ullTime,
+                              const double * pxValues )
+{
+    uint32_t ulBits;
+    uint32_t ulSignal;
+
+    ulBits = prvPutTime( pxEncoder, xWrite, ullTime );
+
+    for( ulSignal = 0; ulSignal < pxEncoder->xState.ulSignalCount; ulSignal++ )
+    {
+        ulBits += prvPutValue( pxEncoder, xWrite, &pxEncoder->xState.pxSignals[ ulSignal ], pxValues[ ulSignal ] );
+    }
+
+    return ulBits;
+}
+/*-----------------------------------------------------------*/
+
+static void prvStateInit( GorillaSeriesState_t * pxState,
+                          GorillaSeriesSignal_t * pxSignals,
+                          uint32_t ulSignalCount )
+{
+    pxState->pxSignals = pxSignals;
+    pxState->ulSignalCount = ulSignalCount;
+    pxState->ulRecordCount = 0;
+    pxState->ulBitOffset = gorillaseriesHEADER_LENGTH * 8;
+    pxState->ullLastTime = 0;
+    pxState->llLastDelta = 0;
+
+    memset( pxSignals, 0, sizeof( GorillaSeriesSignal_t ) * ulSignalCount );
+}
+/*-----------------------------------------------------------*/
+
+bool GorillaSeries_EncoderInit( GorillaSeriesEncoder_t * pxEncoder,
+                                GorillaSeriesSignal_t * pxSignals,
+                                uint32_t ulSignalCount,
+                                uint8_t * pucBuffer,
+                                uint32_t ulBufferSize )
+{
+    if( ( ulSignalCount == 0 ) || ( ulSignalCount > 0xFF ) || ( ulBufferSize < gorillaseriesHEADER_LENGTH ) ||
+        ( ulBufferSize > ( UINT32_MAX / 8 ) ) )
+    {
+        return false;
+    }
+
+    prvStateInit( &pxEncoder->xState, pxSignals, ulSignalCount );
+    pxEncoder->pucBuffer = pucBuffer;
+    pxEncoder->ulBufferSize = ulBufferSize;
+
+    pucBuffer[ 0 ] = gorillaseriesVERSION;
+    pucBuffer[ 1 ] = ( uint8_t ) ulSignalCount;
+    pucBuffer[ 2 ] = 0;
+    pucBuffer[ 3 ] = 0;
+
+    return true;
+}
+/*-----------------------------------------------------------*/
+
+bool GorillaSeries_Append( GorillaSeriesEncoder_t * pxEncoder,
+                           uint64_t ullTime,
+                           const double * pxValues )
+{
+    GorillaSeriesState_t * pxState = &pxEncoder->xState;
+    uint32_t ulFreeBits = pxEncoder->ulBufferSize * 8 - pxState->ulBitOffset;
+
+    if( pxState->ulRecordCount == gorillaseriesMAX_RECORD_COUNT )
+    {
+        return false;
+    }
+
+    /* Only near the end of the buffer is the record measured before it is written. */
+    if( ( ulFreeBits < ( gorillaseriesRECORD_MAX_LENGTH( pxState->ulSignalCount ) * 8 ) ) &&
+        ( prvPutRecord( pxEncoder, false, ullTime, pxValues ) > ulFreeBits ) )
+    {
+        return false;
+    }
+
+    ( void ) prvPutRecord( pxEncoder, true, ullTime, pxValues );
+
+    pxState->ulRecordCount++;
+    pxEncoder->pucBuffer[ 2 ] = ( uint8_t ) ( pxState->ulRecordCount >> 8 );
+    pxEncoder->pucBuffer[ 3 ] = ( uint8_t ) pxState->ulRecordCount;
+
+    return true;
+}
+/*-----------------------------------------------------------*/
+
+uint32_t GorillaSeries_Length( const GorillaSeriesEncoder_t * pxEncoder )
+{
+    return ( pxEncoder->xState.ulBitOffset + 7 ) / 8;
+}
+/*-----------------------------------------------------------*/
+
+uint32_t GorillaSeries_RecordCount( const GorillaSeriesEncoder_t * pxEncoder )
+{
+    return pxEncoder->xState.ulRecordCount;
+}
+/*-----------------------------------------------------------*/
+
+bool GorillaSeries_DecoderInit( GorillaSeriesDecoder_t * pxDecoder,
+                                GorillaSeriesSignal_t * pxSignals,
+                                uint32_t ulMaxSignalCount,
+                                const uint8_t * pucBuffer,
+                                uint32_t ulBufferLength )
+{
+    if( ( ulBufferLength < gorillaseriesHEADER_LENGTH ) || ( ulBufferLength > ( UINT32_MAX / 8 ) ) ||
+        ( pucBuffer[ 0 ] != gorillaseriesVERSION ) || ( pucBuffer[ 1 ] == 0 ) || ( pucBuffer[ 1 ] > ulMaxSignalCount ) )
+    {
+        return false;
+    }
+
+    prvStateInit( &pxDecoder->xState, pxSignals, pucBuffer[ 1 ] );
+    pxDecoder->pucBuffer = pucBuffer;
+    pxDecoder->ulBufferLength = ulBufferLength;
+    pxDecoder->ulTotalRecordCount = ( ( uint32_t ) pucBuffer[ 2 ] << 8 ) | pucBuffer[ 3 ];
+
+    return true;
+}
+/*-----------------------------------------------------------*/
+
+static bool prvGetTime( GorillaSeriesDecoder_t * pxDecoder,
+                        uint64_t * pullTime )
+{
+    GorillaSeriesState_t * pxState = &pxDecoder->xState;
+    uint64_t ullBits;
+    uint32_t ulPrefixBits;
+    int64_t llDeltaOfDelta;
+    static const uint32_t ulWidths[ 4 ] = { 7, 9, 12, 64 };
+    static const int64_t llOffsets[ 4 ] = { 63, 255, 2047, 0 };
+
+    if( pxState->ulRecordCount == 0 )
+    {
+        if( !prvGet( pxDecoder, 64, pullTime ) )
+        {
+            return false;
+        }
+
+        pxState->llLastDelta = 0;
+    }
+    else
+    {
+        /* Count the leading ones of the prefix, up to four. */
+        for( ulPrefixBits = 0; ulPrefixBits < 4; ulPrefixBits++ )
+        {
+            if( !prvGet( pxDecoder, 1, &ullBits ) )
+            {
+                return false;
+            }
+
+            if( ullBits == 0 )
+            {
+                break;
+            }
+        }
+
+        if( ulPrefixBits == 0 )
+        {
+            llDeltaOfDelta = 0;
+        }
+        else if( !prvGet( pxDecoder, ulWidths[ ulPrefixBits - 1 ], &ullBits ) )
+        {
+            return false;
+        }
+        else
+        {
+            llDeltaOfDelta = ( int64_t ) ullBits - llOffsets[ ulPrefixBits - 1 ];
+        }
+
+        pxState->llLastDelta += llDeltaOfDelta;
+        *pullTime = pxState->ullLastTime + ( uint64_t ) pxState->llLastDelta;
+    }
+
+    pxState->ullLastTime = *pullTime;
+
+    return true;
+}
+/*-----------------------------------------------------------*/
+
+static bool prvGetValue( GorillaSeriesDecoder_t * pxDecoder,
+                         GorillaSeriesSignal_t * pxSignal,
+                         double * pxValue )
+{
+    uint64_t ullBits;
+    uint64_t ullLeadingZeros;
+    uint64_t ullMeaningfulBits;
+
+    if( pxDecoder->xState.ulRecordCount == 0 )
+    {
+        if( !prvGet( pxDecoder, 64, &pxSignal->ullLastBits ) )
+        {
+            return false;
+        }
+    }
+    else
+    {
+        if( !prvGet( pxDecoder, 1, &ullBits ) )
+        {
+            return false;
+        }
+
+        if( ullBits != 0 )
+        {
+            if( !prvGet( pxDecoder, 1, &ullBits ) )
+            {
+                return false;
+            }
+
+            if( ullBits != 0 )
+            {
+                if( !prvGet( pxDecoder, 5, &ullLeadingZeros ) ||
+                    !prvGet( pxDecoder, 6, &ullMeaningfulBits ) )
+                {
+                    return false;
+                }
+
+                ullMeaningfulBits = ( ullMeaningfulBits == 0 ) ? 64 : ullMeaningfulBits;
+
+                if( ( ullLeadingZeros + ullMeaningfulBits ) > 64 )
+                {
+                    return false;
+                }
+
+                pxSignal->ucLeadingZeros = ( uint8_t ) ullLeadingZeros;
+                pxSignal->ucMeaningfulBits = ( uint8_t ) ullMeaningfulBits;
+            }
+            else if( pxSignal->ucMeaningfulBits == 0 )
+            {
+                return false;
+            }
+
+            if( !prvGet( pxDecoder, pxSignal->ucMeaningfulBits, &ullBits ) )
+            {
+                return false;
+            }
+
+            pxSignal->ullLastBits ^= ullBits << ( 64U - pxSignal->ucLeadingZeros - pxSignal->ucMeaningfulBits );
+        }
+    }
+
+    ( void ) memcpy( pxValue, &pxSignal->ullLastBits, sizeof( *pxValue ) );
+
+    return true;
+}
+/*-----------------------------------------------------------*/
+
+bool GorillaSeries_Next( GorillaSeriesDecoder_t * pxDecoder,
+                         uint64_t * pullTime,
+                         double * pxValues )
+{
+    uint32_t ulSignal;
+
+    if( ( pxDecoder->xState.ulRecordCount == pxDecoder->ulTotalRecordCount ) ||
+        !prvGetTime( pxDecoder, pullTime ) )
+    {
+        return false;
+    }
+
+    for( ulSignal = 0; ulSignal < pxDecoder->xState.ulSignalCount; ulSignal++ )
+    {
+        if( !prvGetValue( pxDecoder, &pxDecoder->xState.pxSignals[ ulSignal ], &pxValues[ ulSignal ] ) )
+        {
+            return false;
+        }
+    }
+
+    pxDecoder->xState.ulRecordCount++;
+
+    return true;
+}
+/*-----------------------------------------------------------*/
@@ -0,0 +1,167 @@
+/* Copyright (c) Microsoft Corporation.
+ * Licensed under the MIT License. */
+
+/**
+ * @file gorilla_series.h
+ * @brief Compact binary encoding of numeric time series, after Facebook's Gorilla.
+ *
+ * A series is a sequence of records, each holding a timestamp and one double
+ * per signal. Timestamps are written as the difference between consecutive
+ * deltas, so a regular period costs one bit. Values are XORed with the
+ * previous value of their signal, and only the bits that differ are written,
+ * so an unchanged value costs one bit as well.
+ *
+ * Layout, bits written most significant first:
+ *  - Byte 0: format version, #gorillaseriesVERSION.
+ *  - Byte 1: number of signals.
+ *  - Bytes 2-3: number of records, big endian.
+ *  - First record: the timestamp and each value in 64 bits.
+ *  - Next records: the timestamp, as the delta of delta D:
+ *    `0` if D is 0, `10` and D + 63 in 7 bits, `110` and D + 255 in 9 bits,
+ *    `1110` and D + 2047 in 12 bits, or `1111` and D in 64 bits.
+ *    Then each value, as the XOR X with the previous one:
+ *    `0` if X is 0, `10` and the bits of X between the leading and trailing
+ *    zeros of the last `11` of the signal when they hold them all, or `11`,
+ *    the leading zeros L in 5 bits, the length N of the bits between the
+ *    leading and trailing zeros in 6 bits, 0 for 64, and these N bits.
+ *  - Zero bits up to the end of the last byte.
+ */
+
+#ifndef GORILLA_SERIES_H
+#define GORILLA_SERIES_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+/**
+ * @brief Version of the layout, first byte of a series.
+ */
+#define gorillaseriesVERSION        ( 1U )
+
+/**
+ * @brief Size of the header of a series.
+ */
+#define gorillaseriesHEADER_LENGTH  ( 4U )
+
+/**
+ * @brief Most bytes a record of @p ulSignalCount values may need.
+ */
+#define gorillaseriesRECORD_MAX_LENGTH( ulSignalCount )    ( ( 68U + 77U * ( ulSignalCount ) + 7U ) / 8U )
+
+/**
+ * @brief Encoding state of a signal.
+ */
+typedef struct GorillaSeriesSignal
+{
+    uint64_t ullLastBits;
+    uint8_t ucLeadingZeros;
+    uint8_t ucMeaningfulBits; /**< 0 until the first value written with its leading zeros. */
+} GorillaSeriesSignal_t;
+
+/**
+ * @brief State shared by the encoder and the decoder.
+ */
+typedef struct GorillaSeriesState
+{
+    GorillaSeriesSignal_t * pxSignals;
+    uint32_t ulSignalCount;
+    uint32_t ulRecordCount;
+    uint32_t ulBitOffset;
+    uint64_t ullLastTime;
+    int64_t llLastDelta;
+} GorillaSeriesState_t;
+
+/**
+ * @brief Encoder of a series. Initialize with GorillaSeries_EncoderInit().
+ */
+typedef struct GorillaSeriesEncoder
+{
+    GorillaSeriesState_t xState;
+    uint8_t * pucBuffer;
+    uint32_t ulBufferSize;
+} GorillaSeriesEncoder_t;
+
+/**
+ * @brief Decoder of a series. Initialize with GorillaSeries_DecoderInit().
+ */
+typedef struct GorillaSeriesDecoder
+{
+    GorillaSeriesState_t xState;
+    const uint8_t * pucBuffer;
+    uint32_t ulBufferLength;
+    uint32_t ulTotalRecordCount;
+} GorillaSeriesDecoder_t;
+
+/**
+ * @brief Start an empty series.
+ *
+ * @param[out] pxEncoder The encoder.
+ * @param[in] pxSignals State of each signal, @p ulSignalCount entries, referenced.
+ * @param[in] ulSignalCount Number of values of a record, 1 to 255.
+ * @param[out] pucBuffer Buffer receiving the series, referenced.
+ * @param[in] ulBufferSize Size of @p pucBuffer.
+ * @return `false` if the signal count is out of range or the header does not fit.
+ */
+bool GorillaSeries_EncoderInit( GorillaSeriesEncoder_t * pxEncoder,
+                                GorillaSeriesSignal_t * pxSignals,
+                                uint32_t ulSignalCount,
+                                uint8_t * pucBuffer,
+                                uint32_t ulBufferSize );
+
+/**
+ * @brief Append a record to a series.
+ *
+ * @param[in,out] pxEncoder The encoder.
+ * @param[in] ullTime Timestamp of the record, in any unit.
+ * @param[in] pxValues The values of the record, one per signal.
+ * @return `false`, with the series unchanged, if the record does not fit or the series has 65535 records.
+ */
+bool GorillaSeries_Append( GorillaSeriesEncoder_t * pxEncoder,
+                           uint64_t ullTime,
+                           const double * pxValues );
+
+/**
+ * @brief Number of bytes of the series written so far.
+ *
+ * @param[in] pxEncoder The encoder.
+ * @return The length of the series.
+ */
+uint32_t GorillaSeries_Length( const GorillaSeriesEncoder_t * pxEncoder );
+
+/**
+ * @brief Number of records of the series written so far.
+ *
+ * @param[in] pxEncoder The encoder.
+ * @return The record count.
+ */
+uint32_t GorillaSeries_RecordCount( const GorillaSeriesEncoder_t * pxEncoder );
+
+/**
+ * @brief Start decoding a series.
+ *
+ * @param[out] pxDecoder The decoder.
+ * @param[in] pxSignals State of each signal, @p ulMaxSignalCount entries, referenced.
+ * @param[in] ulMaxSignalCount Number of entries of @p pxSignals.
+ * @param[in] pucBuffer The series, referenced.
+ * @param[in] ulBufferLength Length of the series.
+ * @return `false` if the header is invalid or has more signals than @p ulMaxSignalCount.
+ */
+bool GorillaSeries_DecoderInit( GorillaSeriesDecoder_t * pxDecoder,
+                                GorillaSeriesSignal_t * pxSignals,
+                                uint32_t ulMaxSignalCount,
+                                const uint8_t * pucBuffer,
+                                uint32_t ulBufferLength );
+
+/**
+ * @brief Decode the next record of a series.
+ *
+ * @param[in,out] pxDecoder The decoder.
+ * @param[out] pullTime Timestamp of the record.
+ * @param[out] pxValues Values of the record, as many as the signals of the series.
+ * @return `false` after the last record, or if the series is truncated.
+ */
+bool GorillaSeries_Next( GorillaSeriesDecoder_t * pxDecoder,
+                         uint64_t * pullTime,
+                         double * pxValues );
+
+#endif /* GORILLA_SERIES_H */
@@ -0,0 +1,221 @@
+/* Copyright (c) Microsoft Corporation.
+ * Licensed under the MIT License. */
+
+#include "iso8601_time.h"
+
+/*-----------------------------------------------------------*/
+
+#define iso8601timeSECONDS_PER_DAY    ( 86400U )
+
+/**
+ * @brief Days from 0000-03-01 to 1970-01-01.
+ */
+#define iso8601timeEPOCH_DAYS         ( 719468 )
+
+/**
+ * @brief Days in a 400 years era of the Gregorian calendar.
+ */
+#define iso8601timeDAYS_PER_ERA       ( 146097 )
+/*-----------------------------------------------------------*/
+
+/**
+ * @brief Days from 1970-01-01 to a date, counting years from March so leap days come last.
+ */
+static int64_t prvDaysFromCivil( int64_t llYear,
+                                 uint32_t ulMonth,
+                                 uint32_t ulDay )
+{
+    int64_t llEra;
+    uint32_t ulYearOfEra;
+    uint32_t ulDayOfYear;
+    uint32_t ulDayOfEra;
+
+    llYear -= ( ulMonth <= 2 ) ? 1 : 0;
+    llEra = ( llYear >= 0 ? llYear : llYear - 399 ) / 400;
+    ulYearOfEra = ( uint32_t ) ( llYear - llEra * 400 );
+    ulDayOfYear = ( 153 * ( ulMonth > 2 ? ulMonth - 3 : ulMonth + 9 ) + 2 ) / 5 + ulDay - 1;
+    ulDayOfEra = ulYearOfEra * 365 + ulYearOfEra / 4 - ulYearOfEra / 100 + ulDayOfYear;
+
+    return llEra * iso8601timeDAYS_PER_ERA + ( int64_t ) ulDayOfEra - iso8601timeEPOCH_DAYS;
+}
+/*-----------------------------------------------------------*/
+
+/**
+ * @brief Date of a number of days since 1970-01-01, the inverse of prvDaysFromCivil().
+ */
+static void prvCivilFromDays( uint64_t ullDays,
+                              uint64_t * pullYear,
+                              uint32_t * pulMonth,
+                              uint32_t * pulDay )
+{
+    uint64_t ullEra;
+    uint32_t ulDayOfEra;
+    uint32_t ulYearOfEra;
+    uint32_t ulDayOfYear;
+    uint32_t ulMonthFromMarch;
+
+    ullDays += iso8601timeEPOCH_DAYS;
+    ullEra = ullDays / iso8601timeDAYS_PER_ERA;
+    ulDayOfEra = ( uint32_t ) ( ullDays - ullEra * iso8601timeDAYS_PER_ERA );
+    ulYearOfEra = ( ulDayOfEra - ulDayOfEra / 1460 + ulDayOfEra / 36524 - ulDayOfEra / 146096 ) / 365;
+    ulDayOfYear = ulDayOfEra - ( 365 * ulYearOfEra + ulYearOfEra / 4 - ulYearOfEra / 100 );
+    ulMonthFromMarch = ( 5 * ulDayOfYear + 2 ) / 153;
+
+    *pulDay = ulDayOfYear - ( 153 * ulMonthFromMarch + 2 ) / 5 + 1;
+    *pulMonth = ulMonthFromMarch < 10 ? ulMonthFromMarch + 3 : ulMonthFromMarch - 9;
+    *pullYear = ulYearOfEra + ullEra * 400 + ( *pulMonth <= 2 ? 1 : 0 );
+}
+/*-----------------------------------------------------------*/
+
+static void prvWriteDigits( uint32_t ulValue,
+                            uint32_t ulWidth,
+                            uint8_t * pucBuffer )
+{
+    while( ulWidth-- > 0 )
+    {
+        pucBuffer[ ulWidth ] = ( uint8_t ) ( '0' + ( ulValue % 10 ) );
+        ulValue /= 10;
+    }
+}
+/*-----------------------------------------------------------*/
+
+/**
+ * @brief Read exactly @p ulWidth decimal digits.
+ */
+static bool prvReadDigits( const uint8_t * pucText,
+                           uint32_t ulWidth,
+                           uint32_t * pulValue )
+{
+    uint32_t ulIndex;
+
+    *pulValue = 0;
+
+    for( ulIndex = 0; ulIndex < ulWidth; ulIndex++ )
+    {
+        if( ( pucText[ ulIndex ] < '0' ) || ( pucText[ ulIndex ] > '9' ) )
+        {
+            return false;
+        }
+
+        *pulValue = *pulValue * 10 + ( uint32_t ) ( pucText[ ulIndex ] - '0' );
+    }
+
+    return true;
+}
+/*-----------------------------------------------------------*/
+
+static bool prvIsLeapYear( uint32_t ulYear )
+{
+    return ( ( ulYear % 4 ) == 0 ) && ( ( ( ulYear % 100 ) != 0 ) || ( ( ulYear % 400 ) == 0 ) );
+}
+/*-----------------------------------------------------------*/
+
+uint32_t Iso8601Time_Format( uint64_t ullUnixTime,
+                             uint8_t * pucBuffer,
+                             uint32_t ulBufferLength )
+{
+    uint64_t ullYear;
+    uint32_t ulMonth;
+    uint32_t ulDay;
+    uint32_t ulSeconds = ( uint32_t ) ( ullUnixTime % iso8601timeSECONDS_PER_DAY );
+
+    prvCivilFromDays( ullUnixTime / iso8601timeSECONDS_PER_DAY, &ullYear, &ulMonth, &ulDay );
+
+    if( ( ulBufferLength < iso8601timeLENGTH ) || ( ullYear > 9999 ) )
+    {
+        return 0;
+    }
+
+    prvWriteDigits( ( uint32_t ) ullYear, 4, pucBuffer );
+    pucBuffer[ 4 ] = '-';
+    prvWriteDigits( ulMonth, 2, pucBuffer + 5 );
+    pucBuffer[ 7 ] = '-';
+    prvWriteDigits( ulDay, 2, pucBuffer + 8 );
+    pucBuffer[ 10 ] = 'T';
+    prvWriteDigits( ulSeconds / 3600, 2, pucBuffer + 11 );
+    pucBuffer[ 13 ] = ':';
+    prvWriteDigits( ( ulSeconds / 60 ) % 60, 2, pucBuffer + 14 );
+    pucBuffer[ 16 ] = ':';
+    prvWriteDigits( ulSeconds % 60, 2, pucBuffer + 17 );
+    pucBuffer[ 19 ] = 'Z';
+
+    return iso8601timeLENGTH;
+}
+/*-----------------------------------------------------------*/
+
+bool Iso8601Time_Parse( const uint8_t * pucText,
+                        uint32_t ulTextLength,
+                        uint64_t * pullUnixTime )
+{
+    static const uint8_t ucDaysInMonth[ 12 ] = { 31, 28, 31, 30, 31, 30, 31, 31, 30, 31, 30, 31 };
+    uint32_t ulYear, ulMonth, ulDay, ulHour, ulMinute, ulSecond;
+    uint32_t ulOffsetHour = 0;
+    uint32_t ulOffsetMinute = 0;
+    uint32_t ulIndex = 19;
+    int64_t llTime;
+    int64_t llOffset = 0;
+
+    if( ( ulTextLength < 19 ) ||
+        !prvReadDigits( pucText, 4, &ulYear ) || ( pucText[ 4 ] != '-' ) ||
+        !prvReadDigits( pucText + 5, 2, &ulMonth ) || ( pucText[ 7 ] != '-' ) ||
+        !prvReadDigits( pucText + 8, 2, &ulDay ) ||
+        ( ( pucText[ 10 ] != 'T' ) && ( pucText[ 10 ] != 't' ) ) ||
+        !prvReadDigits( pucText + 11, 2, &ulHour ) || ( pucText[ 13 ] != ':' ) ||
+        !prvReadDigits( pucText + 14, 2, &ulMinute ) || ( pucText[ 16 ] != ':' ) ||
+        !prvReadDigits( pucText + 17, 2, &ulSecond ) )
+    {
+        return false;
+    }
+
+    /* Unix time has no leap seconds, so second 60 is rejected. */
+    if( ( ulMonth < 1 ) || ( ulMonth > 12 ) || ( ulDay < 1 ) ||
+        ( ulDay > ( uint32_t ) ( ucDaysInMonth[ ulMonth - 1 ] + ( ( ulMonth == 2 ) && prvIsLeapYear( ulYear ) ? 1 : 0 ) ) ) ||
+        ( ulHour > 23 ) || ( ulMinute > 59 ) || ( ulSecond > 59 ) )
+    {
+        return false;
+    }
+
+    if( ( ulIndex < ulTextLength ) && ( pucText[ ulIndex ] == '.' ) )
+    {
+        for( ulIndex++; ( ulIndex < ulTextLength ) && ( pucText[ ulIndex ] >= '0' ) && ( pucText[ ulIndex ] <= '9' ); ulIndex++ )
+        {
+        }
+    }
+
+    if( ( ulIndex < ulTextLength ) && ( ( pucText[ ulIndex ] == 'Z' ) || ( pucText[ ulIndex ] == 'z' ) ) )
+    {
+        ulIndex++;
+    }
+    else if( ( ulIndex < ulTextLength ) && ( ( pucText[ ulIndex ] == '+' ) || ( pucText[ ulIndex ] == '-' ) ) )
+    {
+        if( ( ( ulTextLength - ulIndex ) < 6 ) ||
+            !prvReadDigits( pucText + ulIndex + 1, 2, &ulOffsetHour ) || ( pucText[ ulIndex + 3 ] != ':' ) ||
+            !prvReadDigits( pucText + ulIndex + 4, 2, &ulOffsetMinute ) ||
+            ( ulOffsetHour > 23 ) || ( ulOffsetMinute > 59 ) )
+        {
+            return false;
+        }
+
+        llOffset = ( int64_t ) ( ulOffsetHour * 3600 + ulOffsetMinute * 60 );
+        llOffset = ( pucText[ ulIndex ] == '+' ) ? llOffset : -llOffset;
+        ulIndex += 6;
+    }
+
+    if( ulIndex != ulTextLength )
+    {
+        return false;
+    }
+
+    llTime = prvDaysFromCivil( ulYear, ulMonth, ulDay ) * iso8601timeSECONDS_PER_DAY +
+             ( int64_t ) ( ulHour * 3600 + ulMinute * 60 + ulSecond ) - llOffset;
+
+    if( llTime < 0 )
+    {
+        return false;
+    }
+
+    *pullUnixTime = ( uint64_t ) llTime;
+
+    return true;
+}
+/*-----------------------------------------------------------*/
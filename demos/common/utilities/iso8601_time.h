@@ -0,0 +1,54 @@
+/* Copyright (c) Microsoft Corporation.
+ * Licensed under the MIT License. */
+
+/**
+ * @file iso8601_time.h
+ * @brief Conversion between Unix time and ISO 8601 UTC date-times.
+ *
+ * Works on the proleptic Gregorian calendar with integer arithmetic only,
+ * without the time zone support of the C library.
+ */
+
+#ifndef ISO8601_TIME_H
+#define ISO8601_TIME_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+/**
+ * @brief Length of the text written by Iso8601Time_Format(), `YYYY-MM-DDTHH:MM:SSZ`.
+ */
+#define iso8601timeLENGTH    ( 20U )
+
+/**
+ * @brief Format a Unix time as `YYYY-MM-DDTHH:MM:SSZ`.
+ *
+ * The output is not NULL terminated.
+ *
+ * @param[in] ullUnixTime Seconds since 1970-01-01T00:00:00Z, before year 10000.
+ * @param[out] pucBuffer Buffer receiving the text.
+ * @param[in] ulBufferLength Size of @p pucBuffer.
+ * @return #iso8601timeLENGTH, or 0 if @p pucBuffer is too small or the year has more than 4 digits.
+ */
+uint32_t Iso8601Time_Format( uint64_t ullUnixTime,
+                             uint8_t * pucBuffer,
+                             uint32_t ulBufferLength );
+
+/**
+ * @brief Parse an ISO 8601 date-time, `YYYY-MM-DDTHH:MM:SS`, into a Unix time.
+ *
+ * Fractional seconds are accepted and truncated. The time may end with `Z`,
+ * an offset `+HH:MM` or `-HH:MM`, or nothing, in which case it is taken as UTC.
+ * The date and time are separated by `T`, and leap seconds (second 60) are
+ * rejected.
+ *
+ * @param[in] pucText The date-time.
+ * @param[in] ulTextLength Length of @p pucText.
+ * @param[out] pullUnixTime Seconds since 1970-01-01T00:00:00Z.
+ * @return `true` if @p pucText is a valid date-time at or after 1970-01-01T00:00:00Z.
+ */
+bool Iso8601Time_Parse( const uint8_t * pucText,
+                        uint32_t ulTextLength,
+                        uint64_t * pullUnixTime );
+
+#endif /* ISO8601_TIME_H */
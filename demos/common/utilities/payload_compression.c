@@ -0,0 +1,294 @@
+/* Copyright (c) Microsoft Corporation.
+ * Licensed under the MIT License. */
+
+#include "payload_compression.h"
+
+/* Standard includes. */
+#include <stdbool.h>
+#include <string.h>
+
+/*-----------------------------------------------------------*/
+
+#if ( ( payloadcompressionWINDOW_SIZE & ( payloadcompressionWINDOW_SIZE - 1U ) ) != 0U ) || \
+    ( payloadcompressionWINDOW_SIZE > 32768U )
+    #error "payloadcompressionWINDOW_SIZE must be a power of 2 up to 32768."
+#endif
+
+#if ( payloadcompressionHASH_BITS < 4U ) || ( payloadcompressionHASH_BITS > 16U )
+    #error "payloadcompressionHASH_BITS out of range."
+#endif
+
+#define payloadcompressionMIN_MATCH         ( 3U )
+#define payloadcompressionMAX_MATCH         ( 258U )
+#define payloadcompressionEND_OF_BLOCK      ( 256U )
+
+/**
+ * @brief zlib header: deflate with a 32K window, fastest compression level, no dictionary.
+ */
+#define payloadcompressionZLIB_CMF          ( 0x78U )
+#define payloadcompressionZLIB_FLG          ( 0x01U )
+
+#define payloadcompressionADLER_MODULO      ( 65521U )
+
+/**
+ * @brief Most bytes summed before the Adler-32 sums must be reduced to fit 32 bits.
+ */
+#define payloadcompressionADLER_CHUNK       ( 5552U )
+/*-----------------------------------------------------------*/
+
+/**
+ * @brief Output bit stream, filled from the least significant bit of each byte.
+ */
+typedef struct BitWriter
+{
+    uint8_t * pucOutput;
+    uint32_t ulOutputSize;
+    uint32_t ulLength;
+    uint32_t ulBits;
+    uint32_t ulBitCount;
+    bool xOverflow;
+} BitWriter_t;
+
+/* Base and extra bits of the length codes 257 to 285, and of the distance codes. */
+static const uint16_t usLengthBase[ 29 ] =
+{
+    3,  4,  5,  6,  7,  8,  9,  10, 11,  13,  15,  17,  19,  23, 27,
+    31, 35, 43, 51, 59, 67, 83, 99, 115, 131, 163, 195, 227, 258
+};
+static const uint8_t ucLengthExtraBits[ 29 ] =
+{
+    0, 0, 0, 0, 0, 0, 0, 0, 1, 1, 1, 1, 2, 2, 2, 2, 3, 3, 3, 3, 4, 4, 4, 4, 5, 5, 5, 5, 0
+};
+static const uint16_t usDistanceBase[ 30 ] =
+{
+    1,   2,   3,   4,   5,   7,    9,    13,   17,   25,   33,   49,   65,    97,    129,
+    193, 257, 385, 513, 769, 1025, 1537, 2049, 3073, 4097, 6145, 8193, 12289, 16385, 24577
+};
+static const uint8_t ucDistanceExtraBits[ 30 ] =
+{
+    0, 0, 0, 0, 1, 1, 2, 2, 3, 3, 4, 4, 5, 5, 6, 6, 7, 7, 8, 8, 9, 9, 10, 10, 11, 11, 12, 12, 13, 13
+};
+/*-----------------------------------------------------------*/
+
+/**
+ * @brief Write up to 16 bits, least significant first.
+ */
+static void prvPutBits( BitWriter_t * pxWriter,
+                        uint32_t ulValue,
+                        uint32_t ulBitCount )
+{
+    pxWriter->ulBits |= ulValue << pxWriter->ulBitCount;
+    pxWriter->ulBitCount += ulBitCount;
+
+    while( pxWriter->ulBitCount >= 8 )
+    {
+        if( pxWriter->ulLength < pxWriter->ulOutputSize )
+        {
+            pxWriter->pucOutput[ pxWriter->ulLength++ ] = ( uint8_t ) pxWriter->ulBits;
+        }
+        else
+        {
+            pxWriter->xOverflow = true;
+        }
+
+        pxWriter->ulBits >>= 8;
+        pxWriter->ulBitCount -= 8;
+    }
+}
+/*-----------------------------------------------------------*/
+
+/**
+ * @brief Write a Huffman code, which DEFLATE packs most significant bit first.
+ */
+static void prvPutCode( BitWriter_t * pxWriter,
+                        uint32_t ulCode,
+                        uint32_t ulBitCount )
+{
+    uint32_t ulReversed = 0;
+    uint32_t ulIndex;
+
+    for( ulIndex = 0; ulIndex < ulBitCount; ulIndex++ )
+    {
+        ulReversed = ( ulReversed << 1 ) | ( ( ulCode >> ulIndex ) & 1U );
+    }
+
+    prvPutBits( pxWriter, ulReversed, ulBitCount );
+}
+/*-----------------------------------------------------------*/
+
+/**
+ * @brief Write a literal or length symbol with the fixed Huffman code.
+ */
+static void prvPutSymbol( BitWriter_t * pxWriter,
+                          uint32_t ulSymbol )
+{
+    if( ulSymbol < 144 )
+    {
+        prvPutCode( pxWriter, 0x30 + ulSymbol, 8 );
+    }
+    else if( ulSymbol < 256 )
+    {
+        prvPutCode( pxWriter, 0x190 + ulSymbol - 144, 9 );
+    }
+    else if( ulSymbol < 280 )
+    {
+        prvPutCode( pxWriter, ulSymbol - 256, 7 );
+    }
+    else
+    {
+        prvPutCode( pxWriter, 0xC0 + ulSymbol - 280, 8 );
+    }
+}
+/*-----------------------------------------------------------*/
+
+static void prvPutMatch( BitWriter_t * pxWriter,
+                         uint32_t ulLength,
+                         uint32_t ulDistance )
+{
+    uint32_t ulCode = 28;
+
+    while( usLengthBase[ ulCode ] > ulLength )
+    {
+        ulCode--;
+    }
+
+    prvPutSymbol( pxWriter, 257 + ulCode );
+    prvPutBits( pxWriter, ulLength - usLengthBase[ ulCode ], ucLengthExtraBits[ ulCode ] );
+
+    ulCode = 29;
+
+    while( usDistanceBase[ ulCode ] > ulDistance )
+    {
+        ulCode--;
+    }
+
+    /* Distance codes are 5 bits long in the fixed code. */
+    prvPutCode( pxWriter, ulCode, 5 );
+    prvPutBits( pxWriter, ulDistance - usDistanceBase[ ulCode ], ucDistanceExtraBits[ ulCode ] );
+}
+/*-----------------------------------------------------------*/
+
+static uint32_t prvHash( const uint8_t * pucBytes )
+{
+    uint32_t ulKey = ( ( uint32_t ) pucBytes[ 0 ] << 16 ) | ( ( uint32_t ) pucBytes[ 1 ] << 8 ) | pucBytes[ 2 ];
+
+    return ( ulKey * 2654435761U ) >> ( 32U - payloadcompressionHASH_BITS );
+}
+/*-----------------------------------------------------------*/
+
+static uint32_t prvAdler32( const uint8_t * pucInput,
+                            uint32_t ulInputLength )
+{
+    uint32_t ulA = 1;
+    uint32_t ulB = 0;
+    uint32_t ulChunk;
+
+    while( ulInputLength > 0 )
+    {
+        ulChunk = ( ulInputLength < payloadcompressionADLER_CHUNK ) ? ulInputLength : payloadcompressionADLER_CHUNK;
+        ulInputLength -= ulChunk;
+
+        while( ulChunk-- > 0 )
+        {
+            ulA += *pucInput++;
+            ulB += ulA;
+        }
+
+        ulA %= payloadcompressionADLER_MODULO;
+        ulB %= payloadcompressionADLER_MODULO;
+    }
+
+    return ( ulB << 16 ) | ulA;
+}
+/*-----------------------------------------------------------*/
+
+uint32_t PayloadCompression_Deflate( PayloadCompressionContext_t * pxContext,
+                                     const uint8_t * pucInput,
+                                     uint32_t ulInputLength,
+                                     uint8_t * pucOutput,
+                                     uint32_t ulOutputSize )
+{
+    BitWriter_t xWriter = { pucOutput, ulOutputSize, 0, 0, 0, false };
+    uint32_t ulPosition = 0;
+    uint32_t ulCandidate;
+    uint32_t ulMaxLength;
+    uint32_t ulLength;
+    uint32_t ulDistance;
+    uint32_t ulHash;
+    uint32_t ulChecksum;
+
+    if( ulInputLength > payloadcompressionMAX_INPUT_LENGTH )
+    {
+        return 0;
+    }
+
+    memset( pxContext->usHead, 0, sizeof( pxContext->usHead ) );
+
+    prvPutBits( &xWriter, payloadcompressionZLIB_CMF, 8 );
+    prvPutBits( &xWriter, payloadcompressionZLIB_FLG, 8 );
+
+    /* A single final block with the fixed Huffman codes. */
+    prvPutBits( &xWriter, 0x3, 3 );
+
+    while( ( ulPosition < ulInputLength ) && !xWriter.xOverflow )
+    {
+        ulLength = 0;
+        ulDistance = 0;
+
+        if( ( ulPosition + payloadcompressionMIN_MATCH ) <= ulInputLength )
+        {
+            ulHash = prvHash( &pucInput[ ulPosition ] );
+            ulCandidate = pxContext->usHead[ ulHash ];
+            pxContext->usHead[ ulHash ] = ( uint16_t ) ( ulPosition + 1 );
+
+            if( ( ulCandidate != 0 ) && ( ( ulPosition - ( ulCandidate - 1 ) ) <= payloadcompressionWINDOW_SIZE ) )
+            {
+                ulDistance = ulPosition - ( ulCandidate - 1 );
+                ulMaxLength = ulInputLength - ulPosition;
+                ulMaxLength = ( ulMaxLength < payloadcompressionMAX_MATCH ) ? ulMaxLength : payloadcompressionMAX_MATCH;
+
+                while( ( ulLength < ulMaxLength ) &&
+                       ( pucInput[ ulPosition + ulLength ] == pucInput[ ulPosition + ulLength - ulDistance ] ) )
+                {
+                    ulLength++;
+                }
+            }
+        }
+
+        if( ulLength >= payloadcompressionMIN_MATCH )
+        {
+            prvPutMatch( &xWriter, ulLength, ulDistance );
+
+            /* Index the positions the match covers, so later matches can start there. */
+            for( ulLength--, ulPosition++; ulLength > 0; ulLength--, ulPosition++ )
+            {
+                if( ( ulPosition + payloadcompressionMIN_MATCH ) <= ulInputLength )
+                {
+                    pxContext->usHead[ prvHash( &pucInput[ ulPosition ] ) ] = ( uint16_t ) ( ulPosition + 1 );
+                }
+            }
+        }
+        else
+        {
+            prvPutSymbol( &xWriter, pucInput[ ulPosition++ ] );
+        }
+    }
+
+    prvPutSymbol( &xWriter, payloadcompressionEND_OF_BLOCK );
+
+    /* Pad the last byte, then append the checksum, most significant byte first. */
+    prvPutBits( &xWriter, 0, ( 8 - xWriter.ulBitCount ) % 8 );
+    ulChecksum = prvAdler32( pucInput, ulInputLength );
+    prvPutBits( &xWriter, ( ulChecksum >> 24 ) & 0xFF, 8 );
+    prvPutBits( &xWriter, ( ulChecksum >> 16 ) & 0xFF, 8 );
+    prvPutBits( &xWriter, ( ulChecksum >> 8 ) & 0xFF, 8 );
+    prvPutBits( &xWriter, ulChecksum & 0xFF, 8 );
+
+    if( xWriter.xOverflow || ( xWriter.ulLength >= ulInputLength ) )
+    {
+        return 0;
+    }
+
+    return xWriter.ulLength;
+}
+/*-----------------------------------------------------------*/
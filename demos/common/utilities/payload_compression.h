@@ -0,0 +1,70 @@
+/* Copyright (c) Microsoft Corporation.
+ * Licensed under the MIT License. */
+
+/**
+ * @file payload_compression.h
+ * @brief Compression of message payloads in the zlib format (RFC 1950 and 1951).
+ *
+ * The output is what HTTP calls the `deflate` content encoding, so any zlib
+ * inflate reads it back. Matches are searched with a single entry hash table
+ * over a bounded window and coded with the fixed Huffman codes of DEFLATE,
+ * which needs no code tables in RAM. The payload is compressed from where it
+ * lies, so the window costs no memory: the only state is the hash table, held
+ * by the caller in a PayloadCompressionContext_t.
+ */
+
+#ifndef PAYLOAD_COMPRESSION_H
+#define PAYLOAD_COMPRESSION_H
+
+#include <stdint.h>
+
+/**
+ * @brief Farthest back a match may start, a power of 2 up to 32768.
+ */
+#ifndef payloadcompressionWINDOW_SIZE
+    #define payloadcompressionWINDOW_SIZE     ( 1024U )
+#endif
+
+/**
+ * @brief Hash table of 2^payloadcompressionHASH_BITS entries of 2 bytes.
+ */
+#ifndef payloadcompressionHASH_BITS
+    #define payloadcompressionHASH_BITS       ( 8U )
+#endif
+
+/**
+ * @brief Value of the content encoding message property of compressed payloads.
+ */
+#define payloadcompressionCONTENT_ENCODING    "deflate"
+
+/**
+ * @brief Largest payload compressed.
+ */
+#define payloadcompressionMAX_INPUT_LENGTH    ( 0xFFFFU )
+
+/**
+ * @brief Memory of the compressor.
+ */
+typedef struct PayloadCompressionContext
+{
+    uint16_t usHead[ 1U << payloadcompressionHASH_BITS ]; /**< Latest position plus 1 of each hash, 0 for none. */
+} PayloadCompressionContext_t;
+
+/**
+ * @brief Compress a payload.
+ *
+ * @param[in] pxContext Memory of the compressor, needing no initialization.
+ * @param[in] pucInput The payload, up to #payloadcompressionMAX_INPUT_LENGTH bytes.
+ * @param[in] ulInputLength Length of @p pucInput.
+ * @param[out] pucOutput Buffer receiving the compressed payload, distinct from @p pucInput.
+ * @param[in] ulOutputSize Size of @p pucOutput.
+ * @return Length of the compressed payload, or 0 if it is not shorter than the
+ *         payload, does not fit in @p pucOutput or the payload is too long.
+ */
+uint32_t PayloadCompression_Deflate( PayloadCompressionContext_t * pxContext,
+                                     const uint8_t * pucInput,
+                                     uint32_t ulInputLength,
+                                     uint8_t * pucOutput,
+                                     uint32_t ulOutputSize );
+
+#endif /* PAYLOAD_COMPRESSION_H */
@@ -0,0 +1,253 @@
+/* Copyright (c) Microsoft Corporation.
+ * Licensed under the MIT License. */
+
+#include "properties_parser.h"
+
+/* Standard includes. */
+#include <string.h>
+
+/* Kernel includes. */
+#include "FreeRTOS.h"
+
+/* Demo Specific configs. */
+#include "demo_config.h"
+
+/*-----------------------------------------------------------*/
+
+#define propertiesparserVERSION_NAME          "$version"
+#define propertiesparserDESIRED_NAME          "desired"
+#define propertiesparserREPORTED_NAME         "reported"
+#define propertiesparserCOMPONENT_MARKER      "__t"
+/*-----------------------------------------------------------*/
+
+AzureIoTResult_t PropertiesParser_SkipValue( AzureIoTJSONReader_t * pxReader )
+{
+    AzureIoTResult_t xResult;
+
+    if( ( xResult = AzureIoTJSONReader_NextToken( pxReader ) ) == eAzureIoTSuccess )
+    {
+        xResult = AzureIoTJSONReader_SkipChildren( pxReader );
+    }
+
+    return xResult;
+}
+/*-----------------------------------------------------------*/
+
+static bool prvIsPropertyName( AzureIoTJSONReader_t * pxReader )
+{
+    AzureIoTJSONTokenType_t xTokenType;
+
+    return ( AzureIoTJSONReader_TokenType( pxReader, &xTokenType ) == eAzureIoTSuccess ) &&
+           ( xTokenType == eAzureIoTJSONTokenPROPERTY_NAME );
+}
+/*-----------------------------------------------------------*/
+
+static const PropertiesParserComponent_t * prvFindComponent( AzureIoTJSONReader_t * pxReader,
+                                                             const PropertiesParserComponent_t * pxComponents,
+                                                             uint32_t ulComponentCount )
+{
+    uint32_t ulIndex;
+
+    for( ulIndex = 0; ulIndex < ulComponentCount; ulIndex++ )
+    {
+        if( AzureIoTJSONReader_TokenIsTextEqual( pxReader,
+                                                 pxComponents[ ulIndex ].pucName,
+                                                 pxComponents[ ulIndex ].ulNameLength ) )
+        {
+            return &pxComponents[ ulIndex ];
+        }
+    }
+
+    return NULL;
+}
+/*-----------------------------------------------------------*/
+
+/**
+ * @brief Walk the properties of a component object.
+ *
+ * Entered with the reader on the component's begin object token,
+ * returns with the reader on its end object token.
+ */
+static AzureIoTResult_t prvParseComponent( AzureIoTJSONReader_t * pxReader,
+                                           const PropertiesParserComponent_t * pxComponent,
+                                           PropertiesParserCallback_t xCallback,
+                                           void * pvContext )
+{
+    AzureIoTResult_t xResult = AzureIoTJSONReader_NextToken( pxReader );
+
+    while( ( xResult == eAzureIoTSuccess ) && prvIsPropertyName( pxReader ) )
+    {
+        if( AzureIoTJSONReader_TokenIsTextEqual( pxReader,
+                                                 ( const uint8_t * ) propertiesparserCOMPONENT_MARKER,
+                                                 sizeof( propertiesparserCOMPONENT_MARKER ) - 1 ) )
+        {
+            xResult = PropertiesParser_SkipValue( pxReader );
+        }
+        else
+        {
+            xResult = xCallback( pxComponent->pucName, pxComponent->ulNameLength, pxReader, pvContext );
+        }
+
+        if( xResult == eAzureIoTSuccess )
+        {
+            xResult = AzureIoTJSONReader_NextToken( pxReader );
+        }
+    }
+
+    return xResult;
+}
+/*-----------------------------------------------------------*/
+
+/**
+ * @brief Walk a properties section (a writable patch, or the desired/reported object of a GET response).
+ *
+ * Entered with the reader on the section's begin object token,
+ * returns with the reader on its end object token.
+ */
+static AzureIoTResult_t prvParseSection( AzureIoTJSONReader_t * pxReader,
+                                         const PropertiesParserComponent_t * pxComponents,
+                                         uint32_t ulComponentCount,
+                                         PropertiesParserCallback_t xCallback,
+                                         void * pvContext,
+                                         uint32_t * pulVersion,
+                                         bool * pxVersionFound )
+{
+    AzureIoTResult_t xResult = AzureIoTJSONReader_NextToken( pxReader );
+    const PropertiesParserComponent_t * pxComponent;
+    AzureIoTJSONTokenType_t xTokenType;
+
+    while( ( xResult == eAzureIoTSuccess ) && prvIsPropertyName( pxReader ) )
+    {
+        if( AzureIoTJSONReader_TokenIsTextEqual( pxReader,
+                                                 ( const uint8_t * ) propertiesparserVERSION_NAME,
+                                                 sizeof( propertiesparserVERSION_NAME ) - 1 ) )
+        {
+            if( ( xResult = AzureIoTJSONReader_NextToken( pxReader ) ) == eAzureIoTSuccess )
+            {
+                xResult = AzureIoTJSONReader_GetTokenUInt32( pxReader, pulVersion );
+                *pxVersionFound = ( xResult == eAzureIoTSuccess );
+            }
+        }
+        else if( ( pxComponent = prvFindComponent( pxReader, pxComponents, ulComponentCount ) ) != NULL )
+        {
+            if( ( xResult = AzureIoTJSONReader_NextToken( pxReader ) ) != eAzureIoTSuccess )
+            {
+                LogError( ( "Error reading component value: result 0x%08x", xResult ) );
+            }
+            else if( ( ( xResult = AzureIoTJSONReader_TokenType( pxReader, &xTokenType ) ) == eAzureIoTSuccess ) &&
+                     ( xTokenType == eAzureIoTJSONTokenBEGIN_OBJECT ) )
+            {
+                xResult = prvParseComponent( pxReader, pxComponent, xCallback, pvContext );
+            }
+            else
+            {
+                LogInfo( ( "Component %.*s is not an object: skipping over it.",
+                           pxComponent->ulNameLength, pxComponent->pucName ) );
+                xResult = AzureIoTJSONReader_SkipChildren( pxReader );
+            }
+        }
+        else
+        {
+            xResult = xCallback( NULL, 0, pxReader, pvContext );
+        }
+
+        if( xResult == eAzureIoTSuccess )
+        {
+            xResult = AzureIoTJSONReader_NextToken( pxReader );
+        }
+    }
+
+    return xResult;
+}
+/*-----------------------------------------------------------*/
+
+AzureIoTResult_t PropertiesParser_Parse( const uint8_t * pucPayload,
+                                         uint32_t ulPayloadLength,
+                                         AzureIoTHubPropertiesMessageType_t xMessageType,
+                                         AzureIoTHubClientPropertyType_t xPropertyType,
+                                         const PropertiesParserComponent_t * pxComponents,
+                                         uint32_t ulComponentCount,
+                                         PropertiesParserCallback_t xCallback,
+                                         void * pvContext,
+                                         uint32_t * pulVersion )
+{
+    AzureIoTResult_t xResult;
+    AzureIoTJSONReader_t xReader;
+    bool xVersionFound = false;
+    bool xSectionFound = false;
+    const char * pcSectionName;
+    uint32_t ulSectionNameLength;
+
+    if( ( pucPayload == NULL ) || ( xCallback == NULL ) || ( pulVersion == NULL ) ||
+        ( ( pxComponents == NULL ) && ( ulComponentCount > 0 ) ) )
+    {
+        LogError( ( "Invalid argument passed to PropertiesParser_Parse" ) );
+        return eAzureIoTErrorInvalidArgument;
+    }
+
+    if( ( xMessageType == eAzureIoTHubPropertiesWritablePropertyMessage ) &&
+        ( xPropertyType != eAzureIoTHubClientPropertyWritable ) )
+    {
+        LogError( ( "Writable property messages only carry writable properties" ) );
+        return eAzureIoTErrorInvalidArgument;
+    }
+
+    if( xPropertyType == eAzureIoTHubClientPropertyWritable )
+    {
+        pcSectionName = propertiesparserDESIRED_NAME;
+        ulSectionNameLength = sizeof( propertiesparserDESIRED_NAME ) - 1;
+    }
+    else
+    {
+        pcSectionName = propertiesparserREPORTED_NAME;
+        ulSectionNameLength = sizeof( propertiesparserREPORTED_NAME ) - 1;
+    }
+
+    if( ( xResult = AzureIoTJSONReader_Init( &xReader, pucPayload, ulPayloadLength ) ) != eAzureIoTSuccess )
+    {
+        LogError( ( "Error initializing the JSON reader: result 0x%08x", xResult ) );
+    }
+    else if( ( xResult = AzureIoTJSONReader_NextToken( &xReader ) ) != eAzureIoTSuccess )
+    {
+        LogError( ( "Error reading the properties document: result 0x%08x", xResult ) );
+    }
+    else if( xMessageType == eAzureIoTHubPropertiesWritablePropertyMessage )
+    {
+        /* A writable patch is itself the section. */
+        xResult = prvParseSection( &xReader, pxComponents, ulComponentCount,
+                                   xCallback, pvContext, pulVersion, &xVersionFound );
+    }
+    else
+    {
+        /* A GET response holds "desired" and "reported". Only the requested one is walked
+         * and parsing stops as soon as it has been read. */
+        xResult = AzureIoTJSONReader_NextToken( &xReader );
+
+        while( ( xResult == eAzureIoTSuccess ) && !xSectionFound && prvIsPropertyName( &xReader ) )
+        {
+            if( AzureIoTJSONReader_TokenIsTextEqual( &xReader, ( const uint8_t * ) pcSectionName, ulSectionNameLength ) )
+            {
+                if( ( xResult = AzureIoTJSONReader_NextToken( &xReader ) ) == eAzureIoTSuccess )
+                {
+                    xResult = prvParseSection( &xReader, pxComponents, ulComponentCount,
+                                               xCallback, pvContext, pulVersion, &xVersionFound );
+                }
+
+                xSectionFound = true;
+            }
+            else if( ( xResult = PropertiesParser_SkipValue( &xReader ) ) == eAzureIoTSuccess )
+            {
+                xResult = AzureIoTJSONReader_NextToken( &xReader );
+            }
+        }
+    }
+
+    if( ( xResult == eAzureIoTSuccess ) && !xVersionFound )
+    {
+        LogError( ( "Properties document does not contain a version" ) );
+        xResult = eAzureIoTErrorItemNotFound;
+    }
+
+    return xResult;
+}
+/*-----------------------------------------------------------*/
@@ -0,0 +1,90 @@
+/* Copyright (c) Microsoft Corporation.
+ * Licensed under the MIT License. */
+
+/**
+ * @file properties_parser.h
+ * @brief Single pass iterator over an Azure IoT Hub properties document.
+ *
+ * `AzureIoTHubClientProperties_GetPropertiesVersion` and
+ * `AzureIoTHubClientProperties_GetNextComponentProperty` each tokenize the
+ * document, so using both costs two full scans. This parser walks the
+ * document once, reporting every component/property pair to a callback and
+ * returning the `$version` found along the way.
+ */
+
+#ifndef PROPERTIES_PARSER_H
+#define PROPERTIES_PARSER_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "azure_iot_hub_client.h"
+#include "azure_iot_hub_client_properties.h"
+#include "azure_iot_json_reader.h"
+
+/**
+ * @brief Component name and its length.
+ */
+typedef struct PropertiesParserComponent
+{
+    const uint8_t * pucName;
+    uint32_t ulNameLength;
+} PropertiesParserComponent_t;
+
+/**
+ * @brief Callback invoked for every property found in the document.
+ *
+ * On entry @p pxReader is positioned on the property name, so the callback can match it
+ * with `AzureIoTJSONReader_TokenIsTextEqual`. Before returning the callback must leave the
+ * reader on the last token of the property value, either by reading the value or by calling
+ * `PropertiesParser_SkipValue`. The parser advances past the value.
+ *
+ * @param[in] pucComponentName Name of the component, or `NULL` for root properties.
+ * @param[in] ulComponentNameLength Length of @p pucComponentName.
+ * @param[in] pxReader Reader positioned on the property name.
+ * @param[in] pvContext Context passed to `PropertiesParser_Parse`.
+ * @return An #AzureIoTResult_t. Anything other than `eAzureIoTSuccess` stops the parse.
+ */
+typedef AzureIoTResult_t ( * PropertiesParserCallback_t )( const uint8_t * pucComponentName,
+                                                           uint32_t ulComponentNameLength,
+                                                           AzureIoTJSONReader_t * pxReader,
+                                                           void * pvContext );
+
+/**
+ * @brief Parse a properties document in a single pass.
+ *
+ * For `eAzureIoTHubPropertiesRequestedMessage` documents the `desired` section is walked
+ * when @p xPropertyType is `eAzureIoTHubClientPropertyWritable`, and the `reported` section
+ * otherwise. Writable property patches only carry writable properties.
+ *
+ * @param[in] pucPayload The properties document.
+ * @param[in] ulPayloadLength Length of @p pucPayload.
+ * @param[in] xMessageType Type of the properties message.
+ * @param[in] xPropertyType Which properties to iterate.
+ * @param[in] pxComponents Components of the device model, may be `NULL`.
+ * @param[in] ulComponentCount Number of entries in @p pxComponents.
+ * @param[in] xCallback Callback invoked for each property.
+ * @param[in] pvContext Context passed to @p xCallback.
+ * @param[out] pulVersion The `$version` of the document.
+ * @return An #AzureIoTResult_t with the result of the operation.
+ *         - `eAzureIoTErrorItemNotFound` if the document carries no `$version`.
+ */
+AzureIoTResult_t PropertiesParser_Parse( const uint8_t * pucPayload,
+                                         uint32_t ulPayloadLength,
+                                         AzureIoTHubPropertiesMessageType_t xMessageType,
+                                         AzureIoTHubClientPropertyType_t xPropertyType,
+                                         const PropertiesParserComponent_t * pxComponents,
+                                         uint32_t ulComponentCount,
+                                         PropertiesParserCallback_t xCallback,
+                                         void * pvContext,
+                                         uint32_t * pulVersion );
+
+/**
+ * @brief Move the reader from a property name to the last token of its value.
+ *
+ * @param[in] pxReader Reader positioned on the property name.
+ * @return An #AzureIoTResult_t with the result of the operation.
+ */
+AzureIoTResult_t PropertiesParser_SkipValue( AzureIoTJSONReader_t * pxReader );
+
+#endif /* PROPERTIES_PARSER_H */
@@ -0,0 +1,508 @@
+/* Copyright (c) Microsoft Corporation.
+ * Licensed under the MIT License. */
+
+#include "property_router.h"
+
+/* Standard includes. */
+#include <stdbool.h>
+#include <string.h>
+
+/* Kernel includes. */
+#include "FreeRTOS.h"
+
+/* Demo Specific configs. */
+#include "demo_config.h"
+
+/* Azure JSON includes */
+#include "azure_iot_json_reader.h"
+#include "azure_iot_json_writer.h"
+
+/*-----------------------------------------------------------*/
+
+#define propertyrouterSTATUS_SUCCESS          ( 200 )
+#define propertyrouterSTATUS_INVALID_VALUE    ( 400 )
+
+#define propertyrouterSUCCESS_TEXT            "success"
+#define propertyrouterINVALID_VALUE_TEXT      "invalid value"
+
+/**
+ * @brief Slots hold the route index plus one, 0 marks an empty slot.
+ */
+#define propertyrouterEMPTY_SLOT              ( 0U )
+
+#if ( propertyrouterMAX_ROUTES > 255U ) || ( propertyrouterSLOT_COUNT <= propertyrouterMAX_ROUTES )
+    #error "propertyrouterMAX_ROUTES must fit in a slot, and leave free slots."
+#endif
+
+#if ( ( propertyrouterSLOT_COUNT & ( propertyrouterSLOT_COUNT - 1U ) ) != 0U )
+    #error "propertyrouterSLOT_COUNT must be a power of 2."
+#endif
+/*-----------------------------------------------------------*/
+
+/**
+ * @brief State of one PropertyRouter_Process() call.
+ */
+typedef struct PropertyRouterContext
+{
+    const PropertyRouter_t * pxRouter;
+    uint16_t usStatus[ propertyrouterMAX_ROUTES ]; /* 0 until the property is received. */
+    bool xReceived;
+} PropertyRouterContext_t;
+/*-----------------------------------------------------------*/
+
+/**
+ * @brief FNV-1a of the component and property names.
+ */
+static uint32_t prvHashNames( const uint8_t * pucComponentName,
+                              uint32_t ulComponentNameLength,
+                              const uint8_t * pucPropertyName,
+                              uint32_t ulPropertyNameLength )
+{
+    uint32_t ulHash = 2166136261UL;
+    uint32_t ulIndex;
+
+    for( ulIndex = 0; ulIndex < ulComponentNameLength; ulIndex++ )
+    {
+        ulHash = ( ulHash ^ pucComponentName[ ulIndex ] ) * 16777619UL;
+    }
+
+    ulHash = ( ulHash ^ 0U ) * 16777619UL;
+
+    for( ulIndex = 0; ulIndex < ulPropertyNameLength; ulIndex++ )
+    {
+        ulHash = ( ulHash ^ pucPropertyName[ ulIndex ] ) * 16777619UL;
+    }
+
+    return ulHash;
+}
+/*-----------------------------------------------------------*/
+
+static bool prvNameEqual( const uint8_t * pucName,
+                          uint32_t ulNameLength,
+                          const uint8_t * pucOtherName,
+                          uint32_t ulOtherNameLength )
+{
+    return ( ulNameLength == ulOtherNameLength ) &&
+           ( ( ulNameLength == 0 ) || ( memcmp( pucName, pucOtherName, ulNameLength ) == 0 ) );
+}
+/*-----------------------------------------------------------*/
+
+/**
+ * @brief Index of the route of a property, -1 if it is not routed.
+ */
+static int32_t prvFindRoute( const PropertyRouter_t * pxRouter,
+                             const uint8_t * pucComponentName,
+                             uint32_t ulComponentNameLength,
+                             const uint8_t * pucPropertyName,
+                             uint32_t ulPropertyNameLength )
+{
+    uint32_t ulSlot = prvHashNames( pucComponentName, ulComponentNameLength,
+                                    pucPropertyName, ulPropertyNameLength ) & ( propertyrouterSLOT_COUNT - 1U );
+    const PropertyRoute_t * pxRoute;
+
+    /* Linear probing, the table always has free slots. */
+    while( pxRouter->ucSlots[ ulSlot ] != propertyrouterEMPTY_SLOT )
+    {
+        pxRoute = &pxRouter->pxRoutes[ pxRouter->ucSlots[ ulSlot ] - 1U ];
+
+        if( prvNameEqual( pxRoute->pucPropertyName, pxRoute->ulPropertyNameLength,
+                          pucPropertyName, ulPropertyNameLength ) &&
+            prvNameEqual( pxRoute->pucComponentName, pxRoute->ulComponentNameLength,
+                          pucComponentName, ulComponentNameLength ) )
+        {
+            return ( int32_t ) pxRouter->ucSlots[ ulSlot ] - 1;
+        }
+
+        ulSlot = ( ulSlot + 1U ) & ( propertyrouterSLOT_COUNT - 1U );
+    }
+
+    return -1;
+}
+/*-----------------------------------------------------------*/
+
+/**
+ * @brief Index of the route of the property name under the reader, -1 if it is not routed.
+ */
+static int32_t prvFindRouteOfToken( const PropertyRouter_t * pxRouter,
+                                    const uint8_t * pucComponentName,
+                                    uint32_t ulComponentNameLength,
+                                    AzureIoTJSONReader_t * pxReader )
+{
+    uint8_t ucPropertyName[ propertyrouterMAX_NAME_LENGTH ];
+    uint32_t ulPropertyNameLength;
+    const PropertyRoute_t * pxRoute;
+    uint32_t ulIndex;
+
+    if( AzureIoTJSONReader_GetTokenString( pxReader, ucPropertyName, sizeof( ucPropertyName ),
+                                           &ulPropertyNameLength ) == eAzureIoTSuccess )
+    {
+        return prvFindRoute( pxRouter, pucComponentName, ulComponentNameLength,
+                             ucPropertyName, ulPropertyNameLength );
+    }
+
+    /* The name could not be copied, too long or escaped beyond the buffer: compare in place. */
+    for( ulIndex = 0; ulIndex < pxRouter->ulRouteCount; ulIndex++ )
+    {
+        pxRoute = &pxRouter->pxRoutes[ ulIndex ];
+
+        if( prvNameEqual( pxRoute->pucComponentName, pxRoute->ulComponentNameLength,
+                          pucComponentName, ulComponentNameLength ) &&
+            AzureIoTJSONReader_TokenIsTextEqual( pxReader, pxRoute->pucPropertyName, pxRoute->ulPropertyNameLength ) )
+        {
+            return ( int32_t ) ulIndex;
+        }
+    }
+
+    return -1;
+}
+/*-----------------------------------------------------------*/
+
+/**
+ * @brief Read the value of a route from the reader, validate it and store it.
+ *
+ * @return The status of the acknowledgement.
+ */
+static uint16_t prvApplyValue( const PropertyRoute_t * pxRoute,
+                               AzureIoTJSONReader_t * pxReader )
+{
+    AzureIoTResult_t xResult;
+    int32_t lValue = 0;
+    double xValue = 0;
+    bool xBoolValue = false;
+
+    switch( pxRoute->xType )
+    {
+        case ePropertyRouterValueInt32:
+            xResult = AzureIoTJSONReader_GetTokenInt32( pxReader, &lValue );
+            xValue = ( double ) lValue;
+            break;
+
+        case ePropertyRouterValueDouble:
+            xResult = AzureIoTJSONReader_GetTokenDouble( pxReader, &xValue );
+            break;
+
+        case ePropertyRouterValueBool:
+            xResult = AzureIoTJSONReader_GetTokenBool( pxReader, &xBoolValue );
+            break;
+
+        default:
+            xResult = eAzureIoTErrorInvalidArgument;
+            break;
+    }
+
+    if( xResult != eAzureIoTSuccess )
+    {
+        LogError( ( "Property %.*s has an invalid type: result 0x%08x",
+                    pxRoute->ulPropertyNameLength, pxRoute->pucPropertyName, xResult ) );
+
+        return propertyrouterSTATUS_INVALID_VALUE;
+    }
+
+    if( ( pxRoute->xType != ePropertyRouterValueBool ) &&
+        ( ( xValue < pxRoute->xMinimum ) || ( xValue > pxRoute->xMaximum ) ) )
+    {
+        LogError( ( "Property %.*s is out of range",
+                    pxRoute->ulPropertyNameLength, pxRoute->pucPropertyName ) );
+
+        return propertyrouterSTATUS_INVALID_VALUE;
+    }
+
+    switch( pxRoute->xType )
+    {
+        case ePropertyRouterValueInt32:
+            *( int32_t * ) pxRoute->pvValue = lValue;
+            break;
+
+        case ePropertyRouterValueDouble:
+            *( double * ) pxRoute->pvValue = xValue;
+            break;
+
+        default:
+            *( bool * ) pxRoute->pvValue = xBoolValue;
+            break;
+    }
+
+    if( pxRoute->xApplied != NULL )
+    {
+        pxRoute->xApplied( pxRoute );
+    }
+
+    return propertyrouterSTATUS_SUCCESS;
+}
+/*-----------------------------------------------------------*/
+
+/**
+ * @brief Called by the properties parser for every property in the document.
+ */
+static AzureIoTResult_t prvOnProperty( const uint8_t * pucComponentName,
+                                       uint32_t ulComponentNameLength,
+                                       AzureIoTJSONReader_t * pxReader,
+                                       void * pvContext )
+{
+    PropertyRouterContext_t * pxContext = ( PropertyRouterContext_t * ) pvContext;
+    int32_t lRoute = prvFindRouteOfToken( pxContext->pxRouter, pucComponentName, ulComponentNameLength, pxReader );
+    AzureIoTResult_t xResult;
+
+    if( lRoute < 0 )
+    {
+        LogInfo( ( "Unknown property arrived: skipping over it." ) );
+
+        /* Unknown property arrived. We have to skip over the property and value to continue iterating. */
+        xResult = PropertiesParser_SkipValue( pxReader );
+    }
+    else if( ( xResult = AzureIoTJSONReader_NextToken( pxReader ) ) != eAzureIoTSuccess )
+    {
+        LogError( ( "Error getting next token: result 0x%08x", xResult ) );
+    }
+    else
+    {
+        pxContext->usStatus[ lRoute ] = prvApplyValue( &pxContext->pxRouter->pxRoutes[ lRoute ], pxReader );
+        pxContext->xReceived = true;
+
+        /* Values of the wrong type may be objects or arrays. */
+        xResult = AzureIoTJSONReader_SkipChildren( pxReader );
+    }
+
+    return xResult;
+}
+/*-----------------------------------------------------------*/
+
+static AzureIoTResult_t prvAppendAck( AzureIoTHubClient_t * pxAzureIoTHubClient,
+                                      AzureIoTJSONWriter_t * pxWriter,
+                                      const PropertyRoute_t * pxRoute,
+                                      uint16_t usStatus,
+                                      uint32_t ulVersion )
+{
+    AzureIoTResult_t xResult;
+    bool xSuccess = ( usStatus == propertyrouterSTATUS_SUCCESS );
+
+    xResult = AzureIoTHubClientProperties_BuilderBeginResponseStatus( pxAzureIoTHubClient,
+                                                                      pxWriter,
+                                                                      pxRoute->pucPropertyName,
+                                                                      pxRoute->ulPropertyNameLength,
+                                                                      usStatus,
+                                                                      ulVersion,
+                                                                      ( const uint8_t * ) ( xSuccess ? propertyrouterSUCCESS_TEXT : propertyrouterINVALID_VALUE_TEXT ),
+                                                                      xSuccess ? sizeof( propertyrouterSUCCESS_TEXT ) - 1 : sizeof( propertyrouterINVALID_VALUE_TEXT ) - 1 );
+
+    if( xResult == eAzureIoTSuccess )
+    {
+        switch( pxRoute->xType )
+        {
+            case ePropertyRouterValueInt32:
+                xResult = AzureIoTJSONWriter_AppendInt32( pxWriter, *( const int32_t * ) pxRoute->pvValue );
+                break;
+
+            case ePropertyRouterValueDouble:
+                xResult = AzureIoTJSONWriter_AppendDouble( pxWriter, *( const double * ) pxRoute->pvValue,
+                                                           propertyrouterDOUBLE_FRACTIONAL_DIGITS );
+                break;
+
+            default:
+                xResult = AzureIoTJSONWriter_AppendBool( pxWriter, *( const bool * ) pxRoute->pvValue );
+                break;
+        }
+    }
+
+    if( xResult == eAzureIoTSuccess )
+    {
+        xResult = AzureIoTHubClientProperties_BuilderEndResponseStatus( pxAzureIoTHubClient, pxWriter );
+    }
+
+    return xResult;
+}
+/*-----------------------------------------------------------*/
+
+/**
+ * @brief Append the acknowledgements of the received properties of one component.
+ */
+static AzureIoTResult_t prvAppendComponentAcks( AzureIoTHubClient_t * pxAzureIoTHubClient,
+                                                AzureIoTJSONWriter_t * pxWriter,
+                                                const PropertyRouterContext_t * pxContext,
+                                                const uint8_t * pucComponentName,
+                                                uint32_t ulComponentNameLength,
+                                                uint32_t ulVersion )
+{
+    const PropertyRouter_t * pxRouter = pxContext->pxRouter;
+    const PropertyRoute_t * pxRoute;
+    AzureIoTResult_t xResult = eAzureIoTSuccess;
+    bool xComponentStarted = false;
+    uint32_t ulIndex;
+
+    for( ulIndex = 0; ( ulIndex < pxRouter->ulRouteCount ) && ( xResult == eAzureIoTSuccess ); ulIndex++ )
+    {
+        pxRoute = &pxRouter->pxRoutes[ ulIndex ];
+
+        if( ( pxContext->usStatus[ ulIndex ] == 0 ) ||
+            !prvNameEqual( pxRoute->pucComponentName, pxRoute->ulComponentNameLength,
+                           pucComponentName, ulComponentNameLength ) )
+        {
+            continue;
+        }
+
+        if( ( ulComponentNameLength > 0 ) && !xComponentStarted )
+        {
+            xResult = AzureIoTHubClientProperties_BuilderBeginComponent( pxAzureIoTHubClient, pxWriter,
+                                                                         pucComponentName, ulComponentNameLength );
+            xComponentStarted = true;
+        }
+
+        if( xResult == eAzureIoTSuccess )
+        {
+            xResult = prvAppendAck( pxAzureIoTHubClient, pxWriter, pxRoute, pxContext->usStatus[ ulIndex ], ulVersion );
+        }
+    }
+
+    if( ( xResult == eAzureIoTSuccess ) && xComponentStarted )
+    {
+        xResult = AzureIoTHubClientProperties_BuilderEndComponent( pxAzureIoTHubClient, pxWriter );
+    }
+
+    return xResult;
+}
+/*-----------------------------------------------------------*/
+
+AzureIoTResult_t PropertyRouter_Init( PropertyRouter_t * pxRouter,
+                                      const PropertyRoute_t * pxRoutes,
+                                      uint32_t ulRouteCount )
+{
+    const PropertyRoute_t * pxRoute;
+    uint32_t ulIndex;
+    uint32_t ulComponent;
+    uint32_t ulSlot;
+
+    if( ( pxRouter == NULL ) || ( ( pxRoutes == NULL ) && ( ulRouteCount > 0 ) ) )
+    {
+        return eAzureIoTErrorInvalidArgument;
+    }
+
+    if( ulRouteCount > propertyrouterMAX_ROUTES )
+    {
+        return eAzureIoTErrorOutOfMemory;
+    }
+
+    memset( pxRouter, 0, sizeof( *pxRouter ) );
+    pxRouter->pxRoutes = pxRoutes;
+
+    for( ulIndex = 0; ulIndex < ulRouteCount; ulIndex++ )
+    {
+        pxRoute = &pxRoutes[ ulIndex ];
+
+        if( prvFindRoute( pxRouter, pxRoute->pucComponentName, pxRoute->ulComponentNameLength,
+                          pxRoute->pucPropertyName, pxRoute->ulPropertyNameLength ) >= 0 )
+        {
+            LogError( ( "Property %.*s is routed twice", pxRoute->ulPropertyNameLength, pxRoute->pucPropertyName ) );
+            return eAzureIoTErrorFailed;
+        }
+
+        ulSlot = prvHashNames( pxRoute->pucComponentName, pxRoute->ulComponentNameLength,
+                               pxRoute->pucPropertyName, pxRoute->ulPropertyNameLength ) & ( propertyrouterSLOT_COUNT - 1U );
+
+        while( pxRouter->ucSlots[ ulSlot ] != propertyrouterEMPTY_SLOT )
+        {
+            ulSlot = ( ulSlot + 1U ) & ( propertyrouterSLOT_COUNT - 1U );
+        }
+
+        pxRouter->ucSlots[ ulSlot ] = ( uint8_t ) ( ulIndex + 1U );
+        pxRouter->ulRouteCount = ulIndex + 1U;
+
+        if( pxRoute->ulComponentNameLength == 0 )
+        {
+            continue;
+        }
+
+        for( ulComponent = 0; ulComponent < pxRouter->ulComponentCount; ulComponent++ )
+        {
+            if( prvNameEqual( pxRouter->xComponents[ ulComponent ].pucName, pxRouter->xComponents[ ulComponent ].ulNameLength,
+                              pxRoute->pucComponentName, pxRoute->ulComponentNameLength ) )
+            {
+                break;
+            }
+        }
+
+        if( ulComponent == pxRouter->ulComponentCount )
+        {
+            if( ulComponent == propertyrouterMAX_COMPONENTS )
+            {
+                return eAzureIoTErrorOutOfMemory;
+            }
+
+            pxRouter->xComponents[ ulComponent ].pucName = pxRoute->pucComponentName;
+            pxRouter->xComponents[ ulComponent ].ulNameLength = pxRoute->ulComponentNameLength;
+            pxRouter->ulComponentCount++;
+        }
+    }
+
+    return eAzureIoTSuccess;
+}
+/*-----------------------------------------------------------*/
+
+AzureIoTResult_t PropertyRouter_Process( const PropertyRouter_t * pxRouter,
+                                         AzureIoTHubClient_t * pxAzureIoTHubClient,
+                                         const AzureIoTHubClientPropertiesResponse_t * pxMessage,
+                                         uint8_t * pucAckBuffer,
+                                         uint32_t ulAckBufferSize,
+                                         uint32_t * pulAckLength )
+{
+    PropertyRouterContext_t xContext = { 0 };
+    AzureIoTJSONWriter_t xWriter;
+    AzureIoTResult_t xResult;
+    uint32_t ulVersion;
+    uint32_t ulComponent;
+    int32_t lBytesWritten;
+
+    *pulAckLength = 0;
+    xContext.pxRouter = pxRouter;
+
+    xResult = PropertiesParser_Parse( pxMessage->pvMessagePayload, pxMessage->ulPayloadLength,
+                                      pxMessage->xMessageType, eAzureIoTHubClientPropertyWritable,
+                                      pxRouter->xComponents, pxRouter->ulComponentCount,
+                                      prvOnProperty, &xContext,
+                                      &ulVersion );
+
+    if( ( xResult != eAzureIoTSuccess ) || !xContext.xReceived )
+    {
+        return xResult;
+    }
+
+    /* All the acknowledgements go in one patch, root properties first. */
+    if( ( xResult = AzureIoTJSONWriter_Init( &xWriter, pucAckBuffer, ulAckBufferSize ) ) == eAzureIoTSuccess )
+    {
+        xResult = AzureIoTJSONWriter_AppendBeginObject( &xWriter );
+    }
+
+    if( xResult == eAzureIoTSuccess )
+    {
+        xResult = prvAppendComponentAcks( pxAzureIoTHubClient, &xWriter, &xContext, NULL, 0, ulVersion );
+    }
+
+    for( ulComponent = 0; ( ulComponent < pxRouter->ulComponentCount ) && ( xResult == eAzureIoTSuccess ); ulComponent++ )
+    {
+        xResult = prvAppendComponentAcks( pxAzureIoTHubClient, &xWriter, &xContext,
+                                          pxRouter->xComponents[ ulComponent ].pucName,
+                                          pxRouter->xComponents[ ulComponent ].ulNameLength,
+                                          ulVersion );
+    }
+
+    if( xResult == eAzureIoTSuccess )
+    {
+        xResult = AzureIoTJSONWriter_AppendEndObject( &xWriter );
+    }
+
+    if( xResult != eAzureIoTSuccess )
+    {
+        LogError( ( "Error building the properties acknowledgement: result 0x%08x", xResult ) );
+    }
+    else if( ( lBytesWritten = AzureIoTJSONWriter_GetBytesUsed( &xWriter ) ) < 0 )
+    {
+        LogError( ( "Error getting the bytes written for the properties acknowledgement" ) );
+        xResult = eAzureIoTErrorFailed;
+    }
+    else
+    {
+        *pulAckLength = ( uint32_t ) lBytesWritten;
+    }
+
+    return xResult;
+}
+/*-----------------------------------------------------------*/
@@ -0,0 +1,153 @@
+/* Copyright (c) Microsoft Corporation.
+ * Licensed under the MIT License. */
+
+/**
+ * @file property_router.h
+ * @brief Table driven handling of writable property updates.
+ *
+ * A sample describes its writable properties once, as a table of routes
+ * binding a (component, property) name to a typed variable, the range of
+ * accepted values and an optional notification. PropertyRouter_Process()
+ * walks the properties document in a single pass, looks every property up
+ * in a hash index of the routes, validates and stores the value, and writes
+ * the acknowledgements of all the properties received into one reported
+ * properties patch.
+ */
+
+#ifndef PROPERTY_ROUTER_H
+#define PROPERTY_ROUTER_H
+
+#include <stdint.h>
+
+#include "azure_iot_hub_client.h"
+#include "azure_iot_hub_client_properties.h"
+
+#include "properties_parser.h"
+
+/**
+ * @brief Maximum number of routes of a router.
+ */
+#ifndef propertyrouterMAX_ROUTES
+    #define propertyrouterMAX_ROUTES                    ( 16U )
+#endif
+
+/**
+ * @brief Number of slots of the hash index, a power of 2 larger than #propertyrouterMAX_ROUTES.
+ */
+#ifndef propertyrouterSLOT_COUNT
+    #define propertyrouterSLOT_COUNT                    ( 32U )
+#endif
+
+/**
+ * @brief Maximum number of distinct components named by the routes.
+ */
+#ifndef propertyrouterMAX_COMPONENTS
+    #define propertyrouterMAX_COMPONENTS                ( 4U )
+#endif
+
+/**
+ * @brief Longest property name looked up through the hash index; longer names are
+ *  compared with every route.
+ */
+#ifndef propertyrouterMAX_NAME_LENGTH
+    #define propertyrouterMAX_NAME_LENGTH               ( 64U )
+#endif
+
+/**
+ * @brief Digits after the decimal point of double values in acknowledgements.
+ */
+#ifndef propertyrouterDOUBLE_FRACTIONAL_DIGITS
+    #define propertyrouterDOUBLE_FRACTIONAL_DIGITS      ( 2U )
+#endif
+
+/**
+ * @brief Expands to the pointer and length initializers of a name given as a string literal.
+ */
+#define propertyrouterNAME( x )    ( const uint8_t * ) ( x ), ( sizeof( x ) - 1 )
+
+/**
+ * @brief Type of the variable bound to a route.
+ */
+typedef enum PropertyRouterValueType
+{
+    ePropertyRouterValueInt32, /**< `int32_t`, read with `AzureIoTJSONReader_GetTokenInt32`. */
+    ePropertyRouterValueDouble, /**< `double`, read with `AzureIoTJSONReader_GetTokenDouble`. */
+    ePropertyRouterValueBool /**< `bool`, read with `AzureIoTJSONReader_GetTokenBool`. */
+} PropertyRouterValueType_t;
+
+struct PropertyRoute;
+
+/**
+ * @brief Notification that a route's variable has been updated.
+ *
+ * @param[in] pxRoute The route.
+ */
+typedef void ( * PropertyRouterApplied_t )( const struct PropertyRoute * pxRoute );
+
+/**
+ * @brief A writable property of the device.
+ */
+typedef struct PropertyRoute
+{
+    const uint8_t * pucComponentName; /**< Component of the property, `NULL` for root properties. */
+    uint32_t ulComponentNameLength;
+    const uint8_t * pucPropertyName;
+    uint32_t ulPropertyNameLength;
+    PropertyRouterValueType_t xType;
+    void * pvValue;                   /**< Variable holding the current value, of type #xType. */
+    double xMinimum;                  /**< Smallest accepted value, for numeric types. */
+    double xMaximum;                  /**< Largest accepted value, for numeric types. */
+    PropertyRouterApplied_t xApplied; /**< Called after the variable was updated, may be `NULL`. */
+} PropertyRoute_t;
+
+/**
+ * @brief Router state. Initialize with PropertyRouter_Init().
+ */
+typedef struct PropertyRouter
+{
+    const PropertyRoute_t * pxRoutes;
+    uint32_t ulRouteCount;
+    PropertiesParserComponent_t xComponents[ propertyrouterMAX_COMPONENTS ];
+    uint32_t ulComponentCount;
+    uint8_t ucSlots[ propertyrouterSLOT_COUNT ];
+} PropertyRouter_t;
+
+/**
+ * @brief Initialize a router over a table of routes.
+ *
+ * The table is referenced, not copied, and must outlive the router.
+ *
+ * @param[out] pxRouter The router.
+ * @param[in] pxRoutes The routes.
+ * @param[in] ulRouteCount Number of entries in @p pxRoutes.
+ * @return An #AzureIoTResult_t with the result of the operation.
+ *         - `eAzureIoTErrorOutOfMemory` if the routes exceed #propertyrouterMAX_ROUTES
+ *           or #propertyrouterMAX_COMPONENTS.
+ *         - `eAzureIoTErrorFailed` if a property is routed twice.
+ */
+AzureIoTResult_t PropertyRouter_Init( PropertyRouter_t * pxRouter,
+                                      const PropertyRoute_t * pxRoutes,
+                                      uint32_t ulRouteCount );
+
+/**
+ * @brief Apply the writable properties of a document and build their acknowledgement.
+ *
+ * Values of the wrong type or out of range are rejected with status 400, and
+ * acknowledged with the current value of the variable. Unknown properties are skipped.
+ *
+ * @param[in] pxRouter The router.
+ * @param[in] pxAzureIoTHubClient The client, used to format the acknowledgements.
+ * @param[in] pxMessage The properties document, a writable patch or a GET response.
+ * @param[out] pucAckBuffer Buffer receiving the reported properties patch.
+ * @param[in] ulAckBufferSize Size of @p pucAckBuffer.
+ * @param[out] pulAckLength Length of the patch, 0 if no routed property was received.
+ * @return An #AzureIoTResult_t with the result of the operation.
+ */
+AzureIoTResult_t PropertyRouter_Process( const PropertyRouter_t * pxRouter,
+                                         AzureIoTHubClient_t * pxAzureIoTHubClient,
+                                         const AzureIoTHubClientPropertiesResponse_t * pxMessage,
+                                         uint8_t * pucAckBuffer,
+                                         uint32_t ulAckBufferSize,
+                                         uint32_t * pulAckLength );
+
+#endif /* PROPERTY_ROUTER_H */
@@ -0,0 +1,94 @@
+/* Copyright (c) Microsoft Corporation.
+ * Licensed under the MIT License. */
+
+#include "provisioning_cache.h"
+
+/* Standard includes. */
+#include <stddef.h>
+#include <string.h>
+
+/*-----------------------------------------------------------*/
+
+/**
+ * @brief Marks storage that holds a cache entry, bumped whenever the layout changes.
+ */
+#define provisioningcacheMAGIC                 ( 0x44505301UL )
+
+#define provisioningcacheFINGERPRINT_PRIME     ( 16777619UL )
+/*-----------------------------------------------------------*/
+
+static uint32_t prvEntryChecksum( const ProvisioningCacheEntry_t * pxEntry )
+{
+    return ProvisioningCache_Fingerprint( provisioningcacheFINGERPRINT_SEED,
+                                          ( const uint8_t * ) pxEntry,
+                                          offsetof( ProvisioningCacheEntry_t, ulChecksum ) );
+}
+/*-----------------------------------------------------------*/
+
+uint32_t ProvisioningCache_Fingerprint( uint32_t ulFingerprint,
+                                        const uint8_t * pucData,
+                                        uint32_t ulDataLength )
+{
+    uint32_t ulIndex;
+
+    /* FNV-1a. The length is folded in as well so that inputs
+     * cannot shift from one field into the next. */
+    for( ulIndex = 0; ulIndex < ulDataLength; ulIndex++ )
+    {
+        ulFingerprint = ( ulFingerprint ^ pucData[ ulIndex ] ) * provisioningcacheFINGERPRINT_PRIME;
+    }
+
+    for( ulIndex = 0; ulIndex < sizeof( ulDataLength ); ulIndex++ )
+    {
+        ulFingerprint = ( ulFingerprint ^ ( ( ulDataLength >> ( ulIndex * 8 ) ) & 0xFF ) ) *
+                        provisioningcacheFINGERPRINT_PRIME;
+    }
+
+    return ulFingerprint;
+}
+/*-----------------------------------------------------------*/
+
+uint32_t ProvisioningCache_EntryInit( ProvisioningCacheEntry_t * pxEntry,
+                                      uint32_t ulFingerprint,
+                                      const uint8_t * pucHostname,
+                                      uint32_t ulHostnameLength,
+                                      const uint8_t * pucDeviceId,
+                                      uint32_t ulDeviceIdLength )
+{
+    /* Keep one byte for the terminating NULL, the hostname is used as a C string. */
+    if( ( ulHostnameLength >= sizeof( pxEntry->ucHostname ) ) ||
+        ( ulDeviceIdLength >= sizeof( pxEntry->ucDeviceId ) ) )
+    {
+        return 1;
+    }
+
+    memset( pxEntry, 0, sizeof( *pxEntry ) );
+    pxEntry->ulMagic = provisioningcacheMAGIC;
+    pxEntry->ulFingerprint = ulFingerprint;
+    pxEntry->ulHostnameLength = ulHostnameLength;
+    pxEntry->ulDeviceIdLength = ulDeviceIdLength;
+    memcpy( pxEntry->ucHostname, pucHostname, ulHostnameLength );
+    memcpy( pxEntry->ucDeviceId, pucDeviceId, ulDeviceIdLength );
+    pxEntry->ulChecksum = prvEntryChecksum( pxEntry );
+
+    return 0;
+}
+/*-----------------------------------------------------------*/
+
+uint32_t ProvisioningCache_EntryValidate( const ProvisioningCacheEntry_t * pxEntry,
+                                          uint32_t ulFingerprint )
+{
+    if( ( pxEntry->ulMagic != provisioningcacheMAGIC ) ||
+        ( pxEntry->ulChecksum != prvEntryChecksum( pxEntry ) ) ||
+        ( pxEntry->ulFingerprint != ulFingerprint ) ||
+        ( pxEntry->ulHostnameLength == 0 ) ||
+        ( pxEntry->ulHostnameLength >= sizeof( pxEntry->ucHostname ) ) ||
+        ( pxEntry->ulDeviceIdLength == 0 ) ||
+        ( pxEntry->ulDeviceIdLength >= sizeof( pxEntry->ucDeviceId ) ) )
+    {
+        return 1;
+    }
+
+    return 0;
+}
+/*-----------------------------------------------------------*/
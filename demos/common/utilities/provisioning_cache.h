@@ -0,0 +1,114 @@
+/* Copyright (c) Microsoft Corporation.
+ * Licensed under the MIT License. */
+
+/**
+ * @file provisioning_cache.h
+ * @brief Persisted result of a Device Provisioning Service registration.
+ *
+ * The entry holds the assigned IoT Hub hostname and device ID together with a
+ * fingerprint of the inputs used to register (endpoint, ID scope, registration
+ * ID, payload and credentials). An entry is only accepted back when its
+ * fingerprint matches the current inputs, so changing any of them forces a new
+ * registration.
+ *
+ * This module only builds and validates entries; reading and writing them is
+ * left to the platform.
+ */
+
+#ifndef PROVISIONING_CACHE_H
+#define PROVISIONING_CACHE_H
+
+#include <stdint.h>
+
+/**
+ * @brief Maximum length of the cached IoT Hub hostname.
+ */
+#define provisioningcacheHOSTNAME_MAX_LENGTH     ( 128U )
+
+/**
+ * @brief Maximum length of the cached device ID.
+ */
+#define provisioningcacheDEVICE_ID_MAX_LENGTH    ( 128U )
+
+/**
+ * @brief Initial value to pass to ProvisioningCache_Fingerprint().
+ */
+#define provisioningcacheFINGERPRINT_SEED        ( 2166136261UL )
+
+/**
+ * @brief A cached registration result, stored as is by the platform.
+ */
+typedef struct ProvisioningCacheEntry
+{
+    uint32_t ulMagic;
+    uint32_t ulFingerprint;
+    uint32_t ulHostnameLength;
+    uint32_t ulDeviceIdLength;
+    uint8_t ucHostname[ provisioningcacheHOSTNAME_MAX_LENGTH ];
+    uint8_t ucDeviceId[ provisioningcacheDEVICE_ID_MAX_LENGTH ];
+    uint32_t ulChecksum;
+} ProvisioningCacheEntry_t;
+
+/**
+ * @brief Fold @p pucData into a registration fingerprint.
+ *
+ * Call once per registration input, starting from #provisioningcacheFINGERPRINT_SEED.
+ *
+ * @param[in] ulFingerprint Fingerprint of the inputs folded so far.
+ * @param[in] pucData Input to fold in.
+ * @param[in] ulDataLength Length of @p pucData.
+ * @return The updated fingerprint.
+ */
+uint32_t ProvisioningCache_Fingerprint( uint32_t ulFingerprint,
+                                        const uint8_t * pucData,
+                                        uint32_t ulDataLength );
+
+/**
+ * @brief Fill a cache entry with a registration result.
+ *
+ * @param[out] pxEntry Entry to fill.
+ * @param[in] ulFingerprint Fingerprint of the registration inputs.
+ * @param[in] pucHostname Assigned IoT Hub hostname.
+ * @param[in] ulHostnameLength Length of @p pucHostname.
+ * @param[in] pucDeviceId Assigned device ID.
+ * @param[in] ulDeviceIdLength Length of @p pucDeviceId.
+ * @return 0 on success, 1 if the hostname or device ID does not fit.
+ */
+uint32_t ProvisioningCache_EntryInit( ProvisioningCacheEntry_t * pxEntry,
+                                      uint32_t ulFingerprint,
+                                      const uint8_t * pucHostname,
+                                      uint32_t ulHostnameLength,
+                                      const uint8_t * pucDeviceId,
+                                      uint32_t ulDeviceIdLength );
+
+/**
+ * @brief Check that an entry read back from storage is intact and belongs to the current inputs.
+ *
+ * @param[in] pxEntry Entry to check.
+ * @param[in] ulFingerprint Fingerprint of the current registration inputs.
+ * @return 0 if the entry can be used, 1 otherwise.
+ */
+uint32_t ProvisioningCache_EntryValidate( const ProvisioningCacheEntry_t * pxEntry,
+                                          uint32_t ulFingerprint );
+
+/**
+ * @brief Read the stored cache entry. Implemented by the platform.
+ *
+ * @param[out] pucBuffer Buffer receiving the entry.
+ * @param[in] ulBufferLength Size of the entry.
+ * @return 0 if exactly @p ulBufferLength bytes were read, non-zero otherwise.
+ */
+uint32_t ulProvisioningCacheRead( uint8_t * pucBuffer,
+                                  uint32_t ulBufferLength );
+
+/**
+ * @brief Store the cache entry, replacing any previous one. Implemented by the platform.
+ *
+ * @param[in] pucBuffer The entry.
+ * @param[in] ulBufferLength Size of the entry.
+ * @return 0 on success, non-zero otherwise.
+ */
+uint32_t ulProvisioningCacheWrite( const uint8_t * pucBuffer,
+                                   uint32_t ulBufferLength );
+
+#endif /* PROVISIONING_CACHE_H */
@@ -0,0 +1,70 @@
+/* Copyright (c) Microsoft Corporation.
+ * Licensed under the MIT License. */
+
+#include "provisioning_poll.h"
+
+/* Kernel includes. */
+#include "FreeRTOS.h"
+#include "task.h"
+
+#include "backoff_policy.h"
+#include "deadline_scheduler.h"
+
+/*-----------------------------------------------------------*/
+
+AzureIoTResult_t ProvisioningPoll_Register( const ProvisioningPollConfig_t * pxConfig,
+                                            ProvisioningPollRegisterFunc_t xRegister,
+                                            ProvisioningPollRetryAfterFunc_t xRetryAfter,
+                                            void * pvContext,
+                                            ProvisioningPollStats_t * pxStats )
+{
+    BackoffPolicy_t xJitter;
+    AzureIoTResult_t xResult;
+    uint64_t ullStart;
+    uint32_t ulDelayMs;
+
+    configASSERT( ( pxConfig != NULL ) && ( xRegister != NULL ) && ( xRetryAfter != NULL ) && ( pxStats != NULL ) );
+
+    BackoffPolicy_Init( &xJitter, eBackoffPolicyDecorrelatedJitter,
+                        pxConfig->ulJitterFloorMs, pxConfig->ulJitterCeilingMs );
+    pxStats->ulRegisterCalls = 0;
+    pxStats->ulRetryAfterWaits = 0;
+    pxStats->ulJitterWaits = 0;
+    ullStart = DeadlineScheduler_GetTimeMs();
+
+    for( ; ; )
+    {
+        xResult = xRegister( pvContext, pxConfig->ulRegisterTimeoutMs );
+        pxStats->ulRegisterCalls++;
+        pxStats->ulElapsedMs = ( uint32_t ) ( DeadlineScheduler_GetTimeMs() - ullStart );
+
+        if( ( xResult != eAzureIoTErrorPending ) || ( pxStats->ulElapsedMs >= pxConfig->ulTimeoutMs ) )
+        {
+            break;
+        }
+
+        /* The service paces its clients with retry-after; jitter is only
+         * for when it does not. */
+        ulDelayMs = xRetryAfter( pvContext );
+
+        if( ulDelayMs != 0 )
+        {
+            pxStats->ulRetryAfterWaits++;
+        }
+        else
+        {
+            ulDelayMs = BackoffPolicy_NextDelay( &xJitter, configRAND32() );
+            pxStats->ulJitterWaits++;
+        }
+
+        if( ulDelayMs > pxConfig->ulTimeoutMs - pxStats->ulElapsedMs )
+        {
+            ulDelayMs = pxConfig->ulTimeoutMs - pxStats->ulElapsedMs;
+        }
+
+        vTaskDelay( pdMS_TO_TICKS( ulDelayMs ) );
+    }
+
+    return xResult;
+}
+/*-----------------------------------------------------------*/
@@ -0,0 +1,81 @@
+/* Copyright (c) Microsoft Corporation.
+ * Licensed under the MIT License. */
+
+/**
+ * @file provisioning_poll.h
+ * @brief Polling of a pending registration with the Device Provisioning Service.
+ *
+ * Registering calls a register function, which waits for progress for a
+ * while, until it ends or the registration times out. Between two calls of a
+ * pending registration, the poll waits for the retry-after the service sent
+ * with its last status, and only when it sent none, for a delay with
+ * decorrelated jitter, so devices that register together do not query the
+ * service together.
+ */
+
+#ifndef PROVISIONING_POLL_H
+#define PROVISIONING_POLL_H
+
+#include <stdint.h>
+
+#include "azure_iot_result.h"
+
+/**
+ * @brief Register, or query the status of a pending registration.
+ *
+ * @param[in] pvContext Context given to ProvisioningPoll_Register().
+ * @param[in] ulTimeoutMs Time to wait for progress, in milliseconds.
+ * @return #eAzureIoTErrorPending while the registration is pending, or its result.
+ */
+typedef AzureIoTResult_t ( * ProvisioningPollRegisterFunc_t )( void * pvContext,
+                                                                uint32_t ulTimeoutMs );
+
+/**
+ * @brief Time left before the retry-after of the service elapses.
+ *
+ * @param[in] pvContext Context given to ProvisioningPoll_Register().
+ * @return Time in milliseconds, 0 when the service sent no retry-after or it elapsed.
+ */
+typedef uint32_t ( * ProvisioningPollRetryAfterFunc_t )( void * pvContext );
+
+/**
+ * @brief Limits of a registration.
+ */
+typedef struct ProvisioningPollConfig
+{
+    uint32_t ulRegisterTimeoutMs; /**< Time each call to the register function waits for progress. */
+    uint32_t ulJitterFloorMs;     /**< Shortest delay without retry-after. */
+    uint32_t ulJitterCeilingMs;   /**< Longest delay without retry-after. */
+    uint32_t ulTimeoutMs;         /**< Time after which a pending registration is given up. */
+} ProvisioningPollConfig_t;
+
+/**
+ * @brief What a registration took.
+ */
+typedef struct ProvisioningPollStats
+{
+    uint32_t ulElapsedMs;       /**< Time from the first call to the end. */
+    uint32_t ulRegisterCalls;   /**< Calls to the register function. */
+    uint32_t ulRetryAfterWaits; /**< Waits for the retry-after of the service. */
+    uint32_t ulJitterWaits;     /**< Waits for a jittered delay, without retry-after. */
+} ProvisioningPollStats_t;
+
+/**
+ * @brief Register, waiting between the calls of a pending registration.
+ *
+ * Time is read with DeadlineScheduler_GetTimeMs() and waited with vTaskDelay().
+ *
+ * @param[in] pxConfig Limits of the registration.
+ * @param[in] xRegister Register function.
+ * @param[in] xRetryAfter Retry-after function.
+ * @param[in] pvContext Context of both functions.
+ * @param[out] pxStats What the registration took.
+ * @return The result of the last call, #eAzureIoTErrorPending when the registration timed out.
+ */
+AzureIoTResult_t ProvisioningPoll_Register( const ProvisioningPollConfig_t * pxConfig,
+                                            ProvisioningPollRegisterFunc_t xRegister,
+                                            ProvisioningPollRetryAfterFunc_t xRetryAfter,
+                                            void * pvContext,
+                                            ProvisioningPollStats_t * pxStats );
+
+#endif /* PROVISIONING_POLL_H */
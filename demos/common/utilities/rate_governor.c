@@ -0,0 +1,401 @@
+/* Copyright (c) Microsoft Corporation.
+ * Licensed under the MIT License. */
+
+#include "rate_governor.h"
+
+/* Standard includes. */
+#include <string.h>
+
+/* Kernel includes. */
+#include "FreeRTOS.h"
+
+/*-----------------------------------------------------------*/
+
+#define rategovernorMS_PER_DAY      ( 24U * 60U * 60U * 1000U )
+
+/**
+ * @brief Nesting of the objects merged member by member, deeper ones are replaced.
+ */
+#define rategovernorMAX_MERGE_DEPTH    ( 8U )
+/*-----------------------------------------------------------*/
+
+/**
+ * @brief Index just after the JSON value starting at @p ulIndex.
+ */
+static uint32_t prvSkipValue( const uint8_t * pucJson,
+                              uint32_t ulLength,
+                              uint32_t ulIndex )
+{
+    uint32_t ulDepth = 0;
+    bool xInString = false;
+
+    for( ; ulIndex < ulLength; ulIndex++ )
+    {
+        if( xInString )
+        {
+            if( pucJson[ ulIndex ] == '\\' )
+            {
+                ulIndex++;
+            }
+            else if( pucJson[ ulIndex ] == '"' )
+            {
+                xInString = false;
+
+                if( ulDepth == 0 )
+                {
+                    return ulIndex + 1;
+                }
+            }
+        }
+        else if( pucJson[ ulIndex ] == '"' )
+        {
+            xInString = true;
+        }
+        else if( ( pucJson[ ulIndex ] == '{' ) || ( pucJson[ ulIndex ] == '[' ) )
+        {
+            ulDepth++;
+        }
+        else if( ( pucJson[ ulIndex ] == '}' ) || ( pucJson[ ulIndex ] == ']' ) )
+        {
+            if( ulDepth == 0 )
+            {
+                /* End of the enclosing value, after a scalar. */
+                return ulIndex;
+            }
+
+            if( --ulDepth == 0 )
+            {
+                return ulIndex + 1;
+            }
+        }
+        else if( ( pucJson[ ulIndex ] == ',' ) && ( ulDepth == 0 ) )
+        {
+            return ulIndex;
+        }
+    }
+
+    return ulLength;
+}
+/*-----------------------------------------------------------*/
+
+/**
+ * @brief Read the member of an object starting at @p ulIndex, `"name":value`.
+ *
+ * @return Index just after the value, where "," or "}" follows.
+ */
+static uint32_t prvReadMember( const uint8_t * pucJson,
+                               uint32_t ulLength,
+                               uint32_t ulIndex,
+                               uint32_t * pulNameEnd,
+                               uint32_t * pulValueStart )
+{
+    *pulNameEnd = prvSkipValue( pucJson, ulLength, ulIndex );
+    *pulValueStart = *pulNameEnd + 1;
+
+    return prvSkipValue( pucJson, ulLength, *pulValueStart );
+}
+/*-----------------------------------------------------------*/
+
+/**
+ * @brief Merge the members of a patch into an object of the batch, as the
+ *  IoT Hub applies reported properties patches: a member of the patch replaces
+ *  the member of the same name, objects being merged member by member.
+ *
+ * The batch must have room for the whole patch, which a merge never exceeds.
+ * Both are scanned within their length: a member running into the end of
+ * the patch is dropped, and one running into the end of the batch ends its
+ * object there.
+ *
+ * @param[in,out] pxGovernor The governor.
+ * @param[in] ulObjectStart Index of the "{" of the object in the batch.
+ * @param[in] pucPatch The patch.
+ * @param[in] ulPatchLength Length of @p pucPatch.
+ * @param[in] ulPatchStart Index of the "{" of the object in the patch.
+ * @param[in] ulDepth Nesting of the object.
+ */
+static void prvMergeObject( RateGovernor_t * pxGovernor,
+                            uint32_t ulObjectStart,
+                            const uint8_t * pucPatch,
+                            uint32_t ulPatchLength,
+                            uint32_t ulPatchStart,
+                            uint32_t ulDepth )
+{
+    uint8_t * pucBatch = pxGovernor->pucBatchBuffer;
+    uint32_t ulPatchIndex = ulPatchStart + 1;
+    uint32_t ulPatchNameEnd, ulPatchValueStart, ulPatchValueEnd;
+    uint32_t ulIndex, ulNameEnd, ulValueStart, ulValueEnd;
+    uint32_t ulInsertLength;
+    bool xFound;
+
+    while( ( ulPatchIndex < ulPatchLength ) && ( pucPatch[ ulPatchIndex ] != '}' ) )
+    {
+        ulPatchValueEnd = prvReadMember( pucPatch, ulPatchLength, ulPatchIndex, &ulPatchNameEnd, &ulPatchValueStart );
+
+        /* A complete member is followed by at least the "}" of the patch. */
+        if( ulPatchValueEnd >= ulPatchLength )
+        {
+            break;
+        }
+
+        /* Look for the member in the object of the batch. */
+        xFound = false;
+        ulIndex = ulObjectStart + 1;
+
+        while( ( ulIndex < pxGovernor->ulBatchLength ) && ( pucBatch[ ulIndex ] != '}' ) )
+        {
+            ulValueEnd = prvReadMember( pucBatch, pxGovernor->ulBatchLength, ulIndex, &ulNameEnd, &ulValueStart );
+
+            if( ulValueEnd >= pxGovernor->ulBatchLength )
+            {
+                ulIndex = pxGovernor->ulBatchLength;
+                break;
+            }
+
+            if( ( ( ulNameEnd - ulIndex ) == ( ulPatchNameEnd - ulPatchIndex ) ) &&
+                ( memcmp( &pucBatch[ ulIndex ], &pucPatch[ ulPatchIndex ], ulNameEnd - ulIndex ) == 0 ) )
+            {
+                xFound = true;
+                break;
+            }
+
+            ulIndex = ( pucBatch[ ulValueEnd ] == ',' ) ? ulValueEnd + 1 : ulValueEnd;
+        }
+
+        if( xFound && ( pucBatch[ ulValueStart ] == '{' ) && ( pucPatch[ ulPatchValueStart ] == '{' ) &&
+            ( ulDepth < rategovernorMAX_MERGE_DEPTH ) )
+        {
+            prvMergeObject( pxGovernor, ulValueStart, pucPatch, ulPatchLength, ulPatchValueStart, ulDepth + 1 );
+        }
+        else if( xFound )
+        {
+            /* Replace the value. */
+            memmove( &pucBatch[ ulValueStart + ( ulPatchValueEnd - ulPatchValueStart ) ], &pucBatch[ ulValueEnd ],
+                     pxGovernor->ulBatchLength - ulValueEnd );
+            memcpy( &pucBatch[ ulValueStart ], &pucPatch[ ulPatchValueStart ], ulPatchValueEnd - ulPatchValueStart );
+            pxGovernor->ulBatchLength = pxGovernor->ulBatchLength + ( ulPatchValueEnd - ulPatchValueStart ) -
+                                        ( ulValueEnd - ulValueStart );
+        }
+        else
+        {
+            /* Add the member before the "}" of the object, ulIndex. */
+            ulInsertLength = ( ulPatchValueEnd - ulPatchIndex ) + ( ( ulIndex > ulObjectStart + 1 ) ? 1 : 0 );
+            memmove( &pucBatch[ ulIndex + ulInsertLength ], &pucBatch[ ulIndex ], pxGovernor->ulBatchLength - ulIndex );
+
+            if( ulIndex > ulObjectStart + 1 )
+            {
+                pucBatch[ ulIndex++ ] = ',';
+            }
+
+            memcpy( &pucBatch[ ulIndex ], &pucPatch[ ulPatchIndex ], ulPatchValueEnd - ulPatchIndex );
+            pxGovernor->ulBatchLength += ulInsertLength;
+        }
+
+        ulPatchIndex = ( pucPatch[ ulPatchValueEnd ] == ',' ) ? ulPatchValueEnd + 1 : ulPatchValueEnd;
+    }
+}
+/*-----------------------------------------------------------*/
+
+/**
+ * @brief Add a payload to the batch, if it fits.
+ */
+static AzureIoTResult_t prvAppend( RateGovernor_t * pxGovernor,
+                                   const uint8_t * pucPayload,
+                                   uint32_t ulPayloadLength )
+{
+    uint8_t * pucEnd = pxGovernor->pucBatchBuffer + pxGovernor->ulBatchLength;
+    uint32_t ulSpace = pxGovernor->ulBatchBufferSize - pxGovernor->ulBatchLength;
+
+    if( pxGovernor->xBatch == eRateGovernorBatchArray )
+    {
+        /* "[" or the "]" of the batch becomes ",", followed by the payload and "]". */
+        if( ( pxGovernor->ulBatchCount == 0 ) ? ( ulSpace < ulPayloadLength + 2 ) : ( ulSpace < ulPayloadLength + 1 ) )
+        {
+            return eAzureIoTErrorOutOfMemory;
+        }
+
+        if( pxGovernor->ulBatchCount == 0 )
+        {
+            *pucEnd++ = '[';
+        }
+        else
+        {
+            *( pucEnd - 1 ) = ',';
+        }
+
+        memcpy( pucEnd, pucPayload, ulPayloadLength );
+        pucEnd[ ulPayloadLength ] = ']';
+        pxGovernor->ulBatchLength = ( uint32_t ) ( pucEnd + ulPayloadLength + 1 - pxGovernor->pucBatchBuffer );
+    }
+    else
+    {
+        configASSERT( ( ulPayloadLength >= 2 ) && ( pucPayload[ 0 ] == '{' ) && ( pucPayload[ ulPayloadLength - 1 ] == '}' ) );
+
+        /* An empty patch adds nothing. */
+        if( ulPayloadLength == 2 )
+        {
+            return eAzureIoTSuccess;
+        }
+
+        if( pxGovernor->ulBatchCount == 0 )
+        {
+            if( ulSpace < ulPayloadLength )
+            {
+                return eAzureIoTErrorOutOfMemory;
+            }
+
+            memcpy( pucEnd, pucPayload, ulPayloadLength );
+            pxGovernor->ulBatchLength = ulPayloadLength;
+        }
+        else
+        {
+            /* Adding every member of the patch, each after a ",", is the longest a merge can get. */
+            if( ulSpace < ulPayloadLength - 1 )
+            {
+                return eAzureIoTErrorOutOfMemory;
+            }
+
+            prvMergeObject( pxGovernor, 0, pucPayload, ulPayloadLength, 0, 0 );
+        }
+    }
+
+    pxGovernor->ulBatchCount++;
+
+    return eAzureIoTSuccess;
+}
+/*-----------------------------------------------------------*/
+
+void RateGovernor_Init( RateGovernor_t * pxGovernor,
+                        RateGovernorBatch_t xBatch,
+                        uint32_t ulMessagesPerDay,
+                        uint32_t ulBurst,
+                        uint8_t * pucBatchBuffer,
+                        uint32_t ulBatchBufferSize,
+                        uint64_t ullNowMs )
+{
+    uint32_t ulRefillIntervalMs;
+
+    configASSERT( pxGovernor != NULL );
+    configASSERT( ulMessagesPerDay > 0 );
+    configASSERT( pucBatchBuffer != NULL );
+
+    /* Budgets above a message per millisecond are not bounded any further. */
+    ulRefillIntervalMs = rategovernorMS_PER_DAY / ulMessagesPerDay;
+    TokenBucket_Init( &pxGovernor->xBucket, ulBurst,
+                      ( ulRefillIntervalMs > 0 ) ? ulRefillIntervalMs : 1, ullNowMs );
+
+    pxGovernor->xBatch = xBatch;
+    pxGovernor->pucBatchBuffer = pucBatchBuffer;
+    pxGovernor->ulBatchBufferSize = ulBatchBufferSize;
+    pxGovernor->ulBatchLength = 0;
+    pxGovernor->ulBatchCount = 0;
+    pxGovernor->ulBatchedCount = 0;
+    pxGovernor->ulUrgentCount = 0;
+}
+/*-----------------------------------------------------------*/
+
+AzureIoTResult_t RateGovernor_Submit( RateGovernor_t * pxGovernor,
+                                      RateGovernorPriority_t xPriority,
+                                      const uint8_t * pucPayload,
+                                      uint32_t ulPayloadLength,
+                                      uint64_t ullNowMs,
+                                      const uint8_t ** ppucMessage,
+                                      uint32_t * pulMessageLength )
+{
+    AzureIoTResult_t xResult;
+
+    if( xPriority == eRateGovernorPriorityUrgent )
+    {
+        pxGovernor->ulUrgentCount++;
+
+        if( pxGovernor->ulBatchCount == 0 )
+        {
+            TokenBucket_Borrow( &pxGovernor->xBucket, ullNowMs );
+            *ppucMessage = pucPayload;
+            *pulMessageLength = ulPayloadLength;
+
+            return eAzureIoTSuccess;
+        }
+
+        /* The batch goes out with the payload in it, or ahead of it when
+         * the payload does not fit. */
+        xResult = prvAppend( pxGovernor, pucPayload, ulPayloadLength );
+        TokenBucket_Borrow( &pxGovernor->xBucket, ullNowMs );
+        *ppucMessage = pxGovernor->pucBatchBuffer;
+        *pulMessageLength = pxGovernor->ulBatchLength;
+        pxGovernor->ulBatchedCount += pxGovernor->ulBatchCount;
+        pxGovernor->ulBatchCount = 0;
+        pxGovernor->ulBatchLength = 0;
+
+        if( xResult != eAzureIoTSuccess )
+        {
+            pxGovernor->ulUrgentCount--;
+        }
+
+        return xResult;
+    }
+
+    /* Within budget, payloads go out as they come. A payload never overtakes
+     * the batch, it joins it. */
+    if( ( pxGovernor->ulBatchCount == 0 ) && TokenBucket_TryTake( &pxGovernor->xBucket, ullNowMs ) )
+    {
+        *ppucMessage = pucPayload;
+        *pulMessageLength = ulPayloadLength;
+
+        return eAzureIoTSuccess;
+    }
+
+    *ppucMessage = NULL;
+    *pulMessageLength = 0;
+
+    if( ( xResult = prvAppend( pxGovernor, pucPayload, ulPayloadLength ) ) != eAzureIoTSuccess )
+    {
+        return xResult;
+    }
+
+    ( void ) RateGovernor_Flush( pxGovernor, ullNowMs, ppucMessage, pulMessageLength );
+
+    return eAzureIoTSuccess;
+}
+/*-----------------------------------------------------------*/
+
+bool RateGovernor_Flush( RateGovernor_t * pxGovernor,
+                         uint64_t ullNowMs,
+                         const uint8_t ** ppucMessage,
+                         uint32_t * pulMessageLength )
+{
+    if( ( pxGovernor->ulBatchCount == 0 ) || !TokenBucket_TryTake( &pxGovernor->xBucket, ullNowMs ) )
+    {
+        return false;
+    }
+
+    *ppucMessage = pxGovernor->pucBatchBuffer;
+    *pulMessageLength = pxGovernor->ulBatchLength;
+
+    /* The content stays in the buffer until the next payload is batched. */
+    pxGovernor->ulBatchedCount += pxGovernor->ulBatchCount;
+    pxGovernor->ulBatchCount = 0;
+    pxGovernor->ulBatchLength = 0;
+
+    return true;
+}
+/*-----------------------------------------------------------*/
+
+void RateGovernor_Charge( RateGovernor_t * pxGovernor,
+                          uint64_t ullNowMs )
+{
+    pxGovernor->ulUrgentCount++;
+    TokenBucket_Borrow( &pxGovernor->xBucket, ullNowMs );
+}
+/*-----------------------------------------------------------*/
+
+uint32_t RateGovernor_TimeToFlush( RateGovernor_t * pxGovernor,
+                                   uint64_t ullNowMs )
+{
+    if( pxGovernor->ulBatchCount == 0 )
+    {
+        return UINT32_MAX;
+    }
+
+    return TokenBucket_TimeToToken( &pxGovernor->xBucket, ullNowMs );
+}
+/*-----------------------------------------------------------*/
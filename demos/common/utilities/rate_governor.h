@@ -0,0 +1,159 @@
+/* Copyright (c) Microsoft Corporation.
+ * Licensed under the MIT License. */
+
+/**
+ * @file rate_governor.h
+ * @brief Bound on the messages a device sends to its IoT Hub.
+ *
+ * The IoT Hub meters the messages of each tier per day, and throttles or
+ * disconnects devices that go over. A governor spreads a daily budget of
+ * messages with a token bucket. While the budget is spent, payloads are not
+ * dropped but batched, and the batch goes out as one message once a token is
+ * available:
+ * - telemetry payloads become the elements of a JSON array;
+ * - reported properties patches are merged into one object, as the IoT Hub
+ *   applies them: a property of a later patch replaces the one of an earlier
+ *   patch, and objects, such as components, are merged member by member.
+ *
+ * Urgent payloads, such as alerts or the state a command changed, do not wait
+ * for the budget: they borrow from it, taking any batch with them so they do
+ * not overtake it, and the routine payloads after them wait longer.
+ *
+ * Payloads are JSON objects without leading or trailing whitespace, as written
+ * by the JSON writer.
+ */
+
+#ifndef RATE_GOVERNOR_H
+#define RATE_GOVERNOR_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "azure_iot_result.h"
+
+#include "token_bucket.h"
+
+/**
+ * @brief Messages per day of one unit of each IoT Hub tier, shared by the devices of the hub.
+ */
+#define rategovernorDAILY_QUOTA_F1    ( 8000U )
+#define rategovernorDAILY_QUOTA_S1    ( 400000U )
+#define rategovernorDAILY_QUOTA_S2    ( 6000000U )
+#define rategovernorDAILY_QUOTA_S3    ( 300000000U )
+
+/**
+ * @brief How payloads are batched while the budget is spent.
+ */
+typedef enum RateGovernorBatch
+{
+    eRateGovernorBatchArray = 0, /**< Telemetry, as the elements of an array. */
+    eRateGovernorBatchObject     /**< Reported properties, as the members of one object. */
+} RateGovernorBatch_t;
+
+/**
+ * @brief Priority of a payload.
+ */
+typedef enum RateGovernorPriority
+{
+    eRateGovernorPriorityRoutine = 0, /**< Sent within the budget, batched otherwise. */
+    eRateGovernorPriorityUrgent       /**< Sent now, borrowing from the budget. */
+} RateGovernorPriority_t;
+
+/**
+ * @brief Governor state. Initialize with RateGovernor_Init().
+ */
+typedef struct RateGovernor
+{
+    TokenBucket_t xBucket;
+    RateGovernorBatch_t xBatch;
+    uint8_t * pucBatchBuffer;
+    uint32_t ulBatchBufferSize;
+    uint32_t ulBatchLength;
+    uint32_t ulBatchCount;   /**< Payloads in the batch. */
+    uint32_t ulBatchedCount; /**< Payloads sent in a batch so far. */
+    uint32_t ulUrgentCount;  /**< Urgent payloads and charged messages so far. */
+} RateGovernor_t;
+
+/**
+ * @brief Initialize a governor, with its burst available.
+ *
+ * @param[out] pxGovernor The governor.
+ * @param[in] xBatch How payloads are batched.
+ * @param[in] ulMessagesPerDay Daily budget of messages, at least 1.
+ * @param[in] ulBurst Messages that may be sent back to back, at least 1.
+ * @param[in] pucBatchBuffer Memory of the batch.
+ * @param[in] ulBatchBufferSize Size of @p pucBatchBuffer, and of the largest batch.
+ * @param[in] ullNowMs Current time in milliseconds.
+ */
+void RateGovernor_Init( RateGovernor_t * pxGovernor,
+                        RateGovernorBatch_t xBatch,
+                        uint32_t ulMessagesPerDay,
+                        uint32_t ulBurst,
+                        uint8_t * pucBatchBuffer,
+                        uint32_t ulBatchBufferSize,
+                        uint64_t ullNowMs );
+
+/**
+ * @brief Submit a payload, and get the message to send now if any.
+ *
+ * The message is either the payload itself, or the batch it was added to.
+ * It stays valid until the next call on the governor. An urgent payload
+ * always gives a message to send.
+ *
+ * @param[in,out] pxGovernor The governor.
+ * @param[in] xPriority Priority of the payload.
+ * @param[in] pucPayload The payload.
+ * @param[in] ulPayloadLength Length of @p pucPayload.
+ * @param[in] ullNowMs Current time in milliseconds.
+ * @param[out] ppucMessage The message to send, NULL if the payload was batched.
+ * @param[out] pulMessageLength Length of the message.
+ * @return eAzureIoTSuccess, or eAzureIoTErrorOutOfMemory if the payload was
+ *         neither sent nor batched, the batch being full. An urgent payload
+ *         that does not fit in the batch is then to be submitted again, once
+ *         the batch it flushed is sent.
+ */
+AzureIoTResult_t RateGovernor_Submit( RateGovernor_t * pxGovernor,
+                                      RateGovernorPriority_t xPriority,
+                                      const uint8_t * pucPayload,
+                                      uint32_t ulPayloadLength,
+                                      uint64_t ullNowMs,
+                                      const uint8_t ** ppucMessage,
+                                      uint32_t * pulMessageLength );
+
+/**
+ * @brief Get the batch to send, once the budget allows it.
+ *
+ * The batch stays valid until the next call on the governor.
+ *
+ * @param[in,out] pxGovernor The governor.
+ * @param[in] ullNowMs Current time in milliseconds.
+ * @param[out] ppucMessage The batch to send.
+ * @param[out] pulMessageLength Length of the batch.
+ * @return true if there is a batch to send now.
+ */
+bool RateGovernor_Flush( RateGovernor_t * pxGovernor,
+                         uint64_t ullNowMs,
+                         const uint8_t ** ppucMessage,
+                         uint32_t * pulMessageLength );
+
+/**
+ * @brief Count a message sent outside of the governor, such as a command
+ *        response, against the budget, borrowing if it is spent.
+ *
+ * @param[in,out] pxGovernor The governor.
+ * @param[in] ullNowMs Current time in milliseconds.
+ */
+void RateGovernor_Charge( RateGovernor_t * pxGovernor,
+                          uint64_t ullNowMs );
+
+/**
+ * @brief Time until the batch can be sent.
+ *
+ * @param[in,out] pxGovernor The governor.
+ * @param[in] ullNowMs Current time in milliseconds.
+ * @return The time in milliseconds, UINT32_MAX if nothing is batched.
+ */
+uint32_t RateGovernor_TimeToFlush( RateGovernor_t * pxGovernor,
+                                   uint64_t ullNowMs );
+
+#endif /* RATE_GOVERNOR_H */
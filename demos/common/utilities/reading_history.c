@@ -0,0 +1,176 @@
+/* Copyright (c) Microsoft Corporation.
+ * Licensed under the MIT License. */
+
+#include "reading_history.h"
+
+/* Standard includes. */
+#include <float.h>
+#include <string.h>
+
+/*-----------------------------------------------------------*/
+
+#if ( readinghistoryCAPACITY == 0U ) || ( readinghistoryCAPACITY > ( UINT32_MAX / 2U ) )
+    #error "readinghistoryCAPACITY out of range."
+#endif
+/*-----------------------------------------------------------*/
+
+static void prvMerge( ReadingHistoryNode_t * pxInto,
+                      const ReadingHistoryNode_t * pxNode )
+{
+    if( pxNode->xMinimum < pxInto->xMinimum )
+    {
+        pxInto->xMinimum = pxNode->xMinimum;
+    }
+
+    if( pxNode->xMaximum > pxInto->xMaximum )
+    {
+        pxInto->xMaximum = pxNode->xMaximum;
+    }
+
+    pxInto->xSum += pxNode->xSum;
+}
+/*-----------------------------------------------------------*/
+
+/**
+ * @brief Summary of the slots [ulFirst, ulEnd), merged into @p pxInto.
+ */
+static void prvQuerySlots( const ReadingHistory_t * pxHistory,
+                           uint32_t ulFirst,
+                           uint32_t ulEnd,
+                           ReadingHistoryNode_t * pxInto )
+{
+    uint32_t ulLeft = ulFirst + readinghistoryCAPACITY;
+    uint32_t ulRight = ulEnd + readinghistoryCAPACITY;
+
+    while( ulLeft < ulRight )
+    {
+        if( ( ulLeft & 1U ) != 0U )
+        {
+            prvMerge( pxInto, &pxHistory->xNodes[ ulLeft++ ] );
+        }
+
+        if( ( ulRight & 1U ) != 0U )
+        {
+            prvMerge( pxInto, &pxHistory->xNodes[ --ulRight ] );
+        }
+
+        ulLeft >>= 1;
+        ulRight >>= 1;
+    }
+}
+/*-----------------------------------------------------------*/
+
+static uint32_t prvSlot( const ReadingHistory_t * pxHistory,
+                         uint32_t ulIndex )
+{
+    return ( pxHistory->ulOldest + ulIndex ) % readinghistoryCAPACITY;
+}
+/*-----------------------------------------------------------*/
+
+void ReadingHistory_Init( ReadingHistory_t * pxHistory )
+{
+    memset( pxHistory, 0, sizeof( *pxHistory ) );
+}
+/*-----------------------------------------------------------*/
+
+void ReadingHistory_Add( ReadingHistory_t * pxHistory,
+                         uint64_t ullTime,
+                         double xValue )
+{
+    ReadingHistoryNode_t * pxNode;
+    uint32_t ulSlot;
+    uint32_t ulNode;
+
+    if( pxHistory->ulCount > 0 )
+    {
+        ulSlot = prvSlot( pxHistory, pxHistory->ulCount - 1 );
+
+        if( ullTime < pxHistory->ullTimes[ ulSlot ] )
+        {
+            ullTime = pxHistory->ullTimes[ ulSlot ];
+        }
+    }
+
+    if( pxHistory->ulCount < readinghistoryCAPACITY )
+    {
+        ulSlot = prvSlot( pxHistory, pxHistory->ulCount++ );
+    }
+    else
+    {
+        ulSlot = pxHistory->ulOldest;
+        pxHistory->ulOldest = ( pxHistory->ulOldest + 1 ) % readinghistoryCAPACITY;
+    }
+
+    pxHistory->ullTimes[ ulSlot ] = ullTime;
+
+    ulNode = readinghistoryCAPACITY + ulSlot;
+    pxNode = &pxHistory->xNodes[ ulNode ];
+    pxNode->xMinimum = xValue;
+    pxNode->xMaximum = xValue;
+    pxNode->xSum = xValue;
+
+    /* Slots not yet written are never part of a query, whatever their nodes hold. */
+    for( ulNode >>= 1; ulNode > 0; ulNode >>= 1 )
+    {
+        pxNode = &pxHistory->xNodes[ ulNode ];
+        *pxNode = pxHistory->xNodes[ 2 * ulNode ];
+        prvMerge( pxNode, &pxHistory->xNodes[ 2 * ulNode + 1 ] );
+    }
+}
+/*-----------------------------------------------------------*/
+
+bool ReadingHistory_Query( const ReadingHistory_t * pxHistory,
+                           uint64_t ullSince,
+                           ReadingHistoryStats_t * pxStats )
+{
+    ReadingHistoryNode_t xSummary = { DBL_MAX, -DBL_MAX, 0.0 };
+    uint32_t ulLow = 0;
+    uint32_t ulHigh = pxHistory->ulCount;
+    uint32_t ulMiddle;
+    uint32_t ulFirst;
+    uint32_t ulLast;
+
+    /* Index of the first reading at or after ullSince. */
+    while( ulLow < ulHigh )
+    {
+        ulMiddle = ulLow + ( ulHigh - ulLow ) / 2;
+
+        if( pxHistory->ullTimes[ prvSlot( pxHistory, ulMiddle ) ] < ullSince )
+        {
+            ulLow = ulMiddle + 1;
+        }
+        else
+        {
+            ulHigh = ulMiddle;
+        }
+    }
+
+    if( ulLow == pxHistory->ulCount )
+    {
+        return false;
+    }
+
+    ulFirst = prvSlot( pxHistory, ulLow );
+    ulLast = prvSlot( pxHistory, pxHistory->ulCount - 1 );
+
+    if( ulFirst <= ulLast )
+    {
+        prvQuerySlots( pxHistory, ulFirst, ulLast + 1, &xSummary );
+    }
+    else
+    {
+        /* The window wraps around the end of the ring. */
+        prvQuerySlots( pxHistory, ulFirst, readinghistoryCAPACITY, &xSummary );
+        prvQuerySlots( pxHistory, 0, ulLast + 1, &xSummary );
+    }
+
+    pxStats->ulCount = pxHistory->ulCount - ulLow;
+    pxStats->xMinimum = xSummary.xMinimum;
+    pxStats->xMaximum = xSummary.xMaximum;
+    pxStats->xAverage = xSummary.xSum / pxStats->ulCount;
+    pxStats->ullStartTime = pxHistory->ullTimes[ ulFirst ];
+    pxStats->ullEndTime = pxHistory->ullTimes[ ulLast ];
+
+    return true;
+}
+/*-----------------------------------------------------------*/
@@ -0,0 +1,98 @@
+/* Copyright (c) Microsoft Corporation.
+ * Licensed under the MIT License. */
+
+/**
+ * @file reading_history.h
+ * @brief Fixed memory history of timestamped readings with windowed statistics.
+ *
+ * The last #readinghistoryCAPACITY readings are kept in a ring, in time order.
+ * A segment tree over the slots of the ring holds the minimum, maximum and sum
+ * of every range of slots, so adding a reading and computing the statistics
+ * of the readings taken since any time both take a logarithmic number of steps,
+ * whatever the number of readings retained.
+ */
+
+#ifndef READING_HISTORY_H
+#define READING_HISTORY_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+/**
+ * @brief Number of readings retained, the oldest are dropped first.
+ */
+#ifndef readinghistoryCAPACITY
+    #define readinghistoryCAPACITY    ( 128U )
+#endif
+
+/**
+ * @brief Statistics of the readings of a window.
+ */
+typedef struct ReadingHistoryStats
+{
+    double xMinimum;
+    double xMaximum;
+    double xAverage;
+    uint32_t ulCount;
+    uint64_t ullStartTime; /**< Time of the first reading of the window. */
+    uint64_t ullEndTime;   /**< Time of the last reading of the window. */
+} ReadingHistoryStats_t;
+
+/**
+ * @brief Summary of a range of slots, a node of the segment tree.
+ */
+typedef struct ReadingHistoryNode
+{
+    double xMinimum;
+    double xMaximum;
+    double xSum;
+} ReadingHistoryNode_t;
+
+/**
+ * @brief History state. Initialize with ReadingHistory_Init().
+ */
+typedef struct ReadingHistory
+{
+    uint64_t ullTimes[ readinghistoryCAPACITY ];
+
+    /* Node 1 covers all the slots, node i has children 2i and 2i+1,
+     * and slot s is the leaf readinghistoryCAPACITY + s. */
+    ReadingHistoryNode_t xNodes[ 2 * readinghistoryCAPACITY ];
+    uint32_t ulOldest; /**< Slot of the oldest reading. */
+    uint32_t ulCount;  /**< Number of readings retained. */
+} ReadingHistory_t;
+
+/**
+ * @brief Initialize an empty history.
+ *
+ * @param[out] pxHistory The history.
+ */
+void ReadingHistory_Init( ReadingHistory_t * pxHistory );
+
+/**
+ * @brief Add a reading, dropping the oldest one when the history is full.
+ *
+ * Readings must be added in time order, an earlier time is taken as the time
+ * of the last reading.
+ *
+ * @param[in,out] pxHistory The history.
+ * @param[in] ullTime Time of the reading.
+ * @param[in] xValue Value of the reading.
+ */
+void ReadingHistory_Add( ReadingHistory_t * pxHistory,
+                         uint64_t ullTime,
+                         double xValue );
+
+/**
+ * @brief Compute the statistics of the readings taken at or after a time.
+ *
+ * @param[in] pxHistory The history.
+ * @param[in] ullSince Start of the window.
+ * @param[out] pxStats The statistics, only written if the window holds readings.
+ * @return `true` if the window holds at least one reading.
+ */
+bool ReadingHistory_Query( const ReadingHistory_t * pxHistory,
+                           uint64_t ullSince,
+                           ReadingHistoryStats_t * pxStats );
+
+#endif /* READING_HISTORY_H */
@@ -0,0 +1,79 @@
+/* Copyright (c) Microsoft Corporation.
+ * Licensed under the MIT License. */
+
+#include "report_filter.h"
+
+/* Standard includes. */
+#include <string.h>
+
+/*-----------------------------------------------------------*/
+
+static double prvMagnitude( double xValue )
+{
+    return ( xValue < 0 ) ? -xValue : xValue;
+}
+/*-----------------------------------------------------------*/
+
+void ReportFilter_Init( ReportFilter_t * pxFilter,
+                        const ReportFilterRule_t * pxRules,
+                        ReportFilterField_t * pxFields,
+                        uint32_t ulFieldCount )
+{
+    pxFilter->pxRules = pxRules;
+    pxFilter->pxFields = pxFields;
+    pxFilter->ulFieldCount = ulFieldCount;
+
+    memset( pxFields, 0, sizeof( ReportFilterField_t ) * ulFieldCount );
+}
+/*-----------------------------------------------------------*/
+
+bool ReportFilter_Update( ReportFilter_t * pxFilter,
+                          uint32_t ulField,
+                          uint64_t ullTime,
+                          double xValue )
+{
+    const ReportFilterRule_t * pxRule = &pxFilter->pxRules[ ulField ];
+    ReportFilterField_t * pxField = &pxFilter->pxFields[ ulField ];
+    uint64_t ullElapsed;
+    double xDeadband;
+    bool xReport;
+
+    if( !pxField->xReported )
+    {
+        xReport = true;
+    }
+    else
+    {
+        ullElapsed = ( ullTime > pxField->ullTime ) ? ullTime - pxField->ullTime : 0;
+        xDeadband = pxRule->xRelativeDeadband * prvMagnitude( pxField->xValue );
+
+        if( xDeadband < pxRule->xAbsoluteDeadband )
+        {
+            xDeadband = pxRule->xAbsoluteDeadband;
+        }
+
+        if( ullElapsed < pxRule->ullMinimumInterval )
+        {
+            xReport = false;
+        }
+        else if( ( pxRule->ullMaximumSilence != 0 ) && ( ullElapsed >= pxRule->ullMaximumSilence ) )
+        {
+            xReport = true;
+        }
+        else
+        {
+            /* Written so that a NaN, on either side, is always reported. */
+            xReport = !( prvMagnitude( xValue - pxField->xValue ) <= xDeadband );
+        }
+    }
+
+    if( xReport )
+    {
+        pxField->xValue = xValue;
+        pxField->ullTime = ullTime;
+        pxField->xReported = true;
+    }
+
+    return xReport;
+}
+/*-----------------------------------------------------------*/
@@ -0,0 +1,86 @@
+/* Copyright (c) Microsoft Corporation.
+ * Licensed under the MIT License. */
+
+/**
+ * @file report_filter.h
+ * @brief Report-on-change rules for telemetry fields.
+ *
+ * A field is reported when its value leaves the dead-band around the value
+ * last reported, but never sooner than a minimum interval after the last
+ * report. A heartbeat reports it anyway once it has been silent for too long,
+ * so the cloud can tell a steady value from a silent device.
+ */
+
+#ifndef REPORT_FILTER_H
+#define REPORT_FILTER_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+/**
+ * @brief Report rule of a field.
+ *
+ * The dead-band is the larger of @p xAbsoluteDeadband and @p xRelativeDeadband
+ * times the magnitude of the value last reported. With both 0 any change is reported.
+ */
+typedef struct ReportFilterRule
+{
+    double xAbsoluteDeadband;
+    double xRelativeDeadband;
+    uint64_t ullMinimumInterval; /**< Least time between two reports, 0 for none. */
+    uint64_t ullMaximumSilence;  /**< Time after which the field is reported even if unchanged, 0 for never. */
+} ReportFilterRule_t;
+
+/**
+ * @brief Last report of a field.
+ */
+typedef struct ReportFilterField
+{
+    double xValue;
+    uint64_t ullTime;
+    bool xReported;
+} ReportFilterField_t;
+
+/**
+ * @brief Filter state. Initialize with ReportFilter_Init().
+ */
+typedef struct ReportFilter
+{
+    const ReportFilterRule_t * pxRules;
+    ReportFilterField_t * pxFields;
+    uint32_t ulFieldCount;
+} ReportFilter_t;
+
+/**
+ * @brief Initialize a filter, with no field reported yet.
+ *
+ * Times are in any unit, as long as the rules and ReportFilter_Update() use the same one.
+ *
+ * @param[out] pxFilter The filter.
+ * @param[in] pxRules Rule of each field, referenced, not copied.
+ * @param[in] pxFields Memory of the last reports, @p ulFieldCount entries.
+ * @param[in] ulFieldCount Number of fields.
+ */
+void ReportFilter_Init( ReportFilter_t * pxFilter,
+                        const ReportFilterRule_t * pxRules,
+                        ReportFilterField_t * pxFields,
+                        uint32_t ulFieldCount );
+
+/**
+ * @brief Decide whether to report a new value of a field, and record it as reported if so.
+ *
+ * A field never reported is always reported. A time earlier than the last
+ * report is taken as equal to it.
+ *
+ * @param[in,out] pxFilter The filter.
+ * @param[in] ulField Index of the field.
+ * @param[in] ullTime Time of the value.
+ * @param[in] xValue The value.
+ * @return `true` if the value is to be reported.
+ */
+bool ReportFilter_Update( ReportFilter_t * pxFilter,
+                          uint32_t ulField,
+                          uint64_t ullTime,
+                          double xValue );
+
+#endif /* REPORT_FILTER_H */
@@ -0,0 +1,138 @@
+/* Copyright (c) Microsoft Corporation.
+ * Licensed under the MIT License. */
+
+#include "sas_token_cache.h"
+
+/* Standard includes. */
+#include <stdbool.h>
+#include <string.h>
+
+/* Crypto helper header. */
+#include "crypto.h"
+
+/*-----------------------------------------------------------*/
+
+/**
+ * @brief Length of an HMAC SHA256 signature.
+ */
+#define sastokencacheHMAC_LENGTH    ( 32U )
+
+#if ( sastokencacheTIME_QUANTUM_SEC * 100U ) >= ( sastokencacheTOKEN_LIFETIME_SEC * ( 100U - sastokencacheRENEWAL_PERCENT ) )
+    #error "sastokencacheTIME_QUANTUM_SEC must be shorter than the time left between renewal and expiry."
+#endif
+/*-----------------------------------------------------------*/
+
+typedef struct SASTokenCacheEntry
+{
+    bool xValid;
+    uint32_t ulKeyLength;
+    uint8_t ucKey[ sastokencacheMAX_KEY_LENGTH ];
+    uint32_t ulDataLength;
+    uint8_t ucData[ sastokencacheMAX_DATA_LENGTH ];
+    uint32_t ulHMACLength;
+    uint8_t ucHMAC[ sastokencacheHMAC_LENGTH ];
+} SASTokenCacheEntry_t;
+/*-----------------------------------------------------------*/
+
+/**
+ * @brief Unix time, provided by the platform.
+ */
+uint64_t ullGetUnixTime( void );
+/*-----------------------------------------------------------*/
+
+static SASTokenCacheEntry_t xSASTokenCacheEntries[ sastokencacheENTRY_COUNT ];
+
+/* Entry replaced by the next miss. */
+static uint32_t ulSASTokenCacheNextEntry = 0;
+/*-----------------------------------------------------------*/
+
+static SASTokenCacheEntry_t * prvFindEntry( const uint8_t * pucKey,
+                                            uint32_t ulKeyLength,
+                                            const uint8_t * pucData,
+                                            uint32_t ulDataLength )
+{
+    uint32_t ulIndex;
+    SASTokenCacheEntry_t * pxEntry;
+
+    for( ulIndex = 0; ulIndex < sastokencacheENTRY_COUNT; ulIndex++ )
+    {
+        pxEntry = &xSASTokenCacheEntries[ ulIndex ];
+
+        if( pxEntry->xValid &&
+            ( pxEntry->ulKeyLength == ulKeyLength ) &&
+            ( pxEntry->ulDataLength == ulDataLength ) &&
+            ( memcmp( pxEntry->ucData, pucData, ulDataLength ) == 0 ) &&
+            ( memcmp( pxEntry->ucKey, pucKey, ulKeyLength ) == 0 ) )
+        {
+            return pxEntry;
+        }
+    }
+
+    return NULL;
+}
+/*-----------------------------------------------------------*/
+
+uint32_t SASTokenCache_HMAC( const uint8_t * pucKey,
+                             uint32_t ulKeyLength,
+                             const uint8_t * pucData,
+                             uint32_t ulDataLength,
+                             uint8_t * pucOutput,
+                             uint32_t ulOutputLength,
+                             uint32_t * pulBytesCopied )
+{
+    SASTokenCacheEntry_t * pxEntry;
+    uint32_t ulStatus;
+    bool xCacheable = ( ulKeyLength <= sastokencacheMAX_KEY_LENGTH ) &&
+                      ( ulDataLength <= sastokencacheMAX_DATA_LENGTH );
+
+    if( xCacheable &&
+        ( ( pxEntry = prvFindEntry( pucKey, ulKeyLength, pucData, ulDataLength ) ) != NULL ) &&
+        ( pxEntry->ulHMACLength <= ulOutputLength ) )
+    {
+        memcpy( pucOutput, pxEntry->ucHMAC, pxEntry->ulHMACLength );
+        *pulBytesCopied = pxEntry->ulHMACLength;
+
+        return 0;
+    }
+
+    ulStatus = Crypto_HMAC( pucKey, ulKeyLength, pucData, ulDataLength,
+                            pucOutput, ulOutputLength, pulBytesCopied );
+
+    if( ( ulStatus == 0 ) && xCacheable && ( *pulBytesCopied <= sastokencacheHMAC_LENGTH ) )
+    {
+        pxEntry = &xSASTokenCacheEntries[ ulSASTokenCacheNextEntry ];
+        ulSASTokenCacheNextEntry = ( ulSASTokenCacheNextEntry + 1 ) % sastokencacheENTRY_COUNT;
+
+        pxEntry->ulKeyLength = ulKeyLength;
+        memcpy( pxEntry->ucKey, pucKey, ulKeyLength );
+        pxEntry->ulDataLength = ulDataLength;
+        memcpy( pxEntry->ucData, pucData, ulDataLength );
+        pxEntry->ulHMACLength = *pulBytesCopied;
+        memcpy( pxEntry->ucHMAC, pucOutput, *pulBytesCopied );
+        pxEntry->xValid = true;
+    }
+
+    return ulStatus;
+}
+/*-----------------------------------------------------------*/
+
+uint64_t SASTokenCache_GetTime( void )
+{
+    uint64_t ullTime = ullGetUnixTime();
+
+    return ullTime - ( ullTime % sastokencacheTIME_QUANTUM_SEC );
+}
+/*-----------------------------------------------------------*/
+
+uint64_t SASTokenCache_RenewalTime( uint64_t ullIssueTime )
+{
+    return ullIssueTime + ( ( uint64_t ) sastokencacheTOKEN_LIFETIME_SEC * sastokencacheRENEWAL_PERCENT ) / 100U;
+}
+/*-----------------------------------------------------------*/
+
+void SASTokenCache_Clear( void )
+{
+    memset( xSASTokenCacheEntries, 0, sizeof( xSASTokenCacheEntries ) );
+    ulSASTokenCacheNextEntry = 0;
+}
+/*-----------------------------------------------------------*/
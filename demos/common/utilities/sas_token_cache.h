@@ -0,0 +1,104 @@
+/* Copyright (c) Microsoft Corporation.
+ * Licensed under the MIT License. */
+
+/**
+ * @file sas_token_cache.h
+ * @brief Reuse of SAS token signatures and planning of token renewal.
+ *
+ * The middleware signs "<resource URI>\n<expiry>" with the device key every
+ * time it connects. SASTokenCache_HMAC() is a drop-in for Crypto_HMAC() that
+ * remembers recent signatures, and SASTokenCache_GetTime() rounds the clock
+ * down to #sastokencacheTIME_QUANTUM_SEC so that connection retries within the
+ * same quantum produce the same expiry, and therefore hit the cache.
+ *
+ * Rounding the clock down shortens the token lifetime by less than one quantum.
+ * SASTokenCache_RenewalTime() tells when a connection should be re-established
+ * so that the token is renewed before it lapses.
+ */
+
+#ifndef SAS_TOKEN_CACHE_H
+#define SAS_TOKEN_CACHE_H
+
+#include <stdint.h>
+
+/**
+ * @brief Lifetime of the SAS tokens generated by the middleware, in seconds.
+ *
+ * @note Must match azureiotconfigDEFAULT_TOKEN_TIMEOUT_IN_SEC of the middleware.
+ */
+#ifndef sastokencacheTOKEN_LIFETIME_SEC
+    #define sastokencacheTOKEN_LIFETIME_SEC    ( 60U * 60U )
+#endif
+
+/**
+ * @brief Granularity, in seconds, of the time handed to the middleware.
+ */
+#ifndef sastokencacheTIME_QUANTUM_SEC
+    #define sastokencacheTIME_QUANTUM_SEC      ( 5U * 60U )
+#endif
+
+/**
+ * @brief Percentage of the token lifetime after which the token is renewed.
+ */
+#ifndef sastokencacheRENEWAL_PERCENT
+    #define sastokencacheRENEWAL_PERCENT       ( 80U )
+#endif
+
+/**
+ * @brief Number of signatures remembered, one per key and resource URI in use.
+ */
+#ifndef sastokencacheENTRY_COUNT
+    #define sastokencacheENTRY_COUNT           ( 2U )
+#endif
+
+/**
+ * @brief Longest key and signed data that are cached; longer ones are always signed.
+ */
+#define sastokencacheMAX_KEY_LENGTH            ( 64U )
+#define sastokencacheMAX_DATA_LENGTH           ( 256U )
+
+/**
+ * @brief Compute HMAC SHA256, reusing the result of an identical earlier call.
+ *
+ * Same contract as Crypto_HMAC(), which computes the signature on a cache miss.
+ *
+ * @param[in] pucKey Pointer to key.
+ * @param[in] ulKeyLength Length of Key.
+ * @param[in] pucData Pointer to data for HMAC
+ * @param[in] ulDataLength Length of data.
+ * @param[in,out] pucOutput Buffer to place computed HMAC.
+ * @param[out] ulOutputLength Length of output buffer.
+ * @param[in] pulBytesCopied Number of bytes copied to out buffer.
+ * @return An #uint32_t with result of operation.
+ */
+uint32_t SASTokenCache_HMAC( const uint8_t * pucKey,
+                             uint32_t ulKeyLength,
+                             const uint8_t * pucData,
+                             uint32_t ulDataLength,
+                             uint8_t * pucOutput,
+                             uint32_t ulOutputLength,
+                             uint32_t * pulBytesCopied );
+
+/**
+ * @brief Unix time rounded down to #sastokencacheTIME_QUANTUM_SEC.
+ *
+ * To be given to the middleware in place of the platform time function.
+ *
+ * @return Time in seconds.
+ */
+uint64_t SASTokenCache_GetTime( void );
+
+/**
+ * @brief Time at which a token issued at @p ullIssueTime should be renewed.
+ *
+ * @param[in] ullIssueTime Value of SASTokenCache_GetTime() when the connection was made.
+ * @return Time in seconds.
+ */
+uint64_t SASTokenCache_RenewalTime( uint64_t ullIssueTime );
+
+/**
+ * @brief Forget every cached signature, for instance after the key changed.
+ */
+void SASTokenCache_Clear( void );
+
+#endif /* SAS_TOKEN_CACHE_H */
@@ -0,0 +1,200 @@
+/* Copyright (c) Microsoft Corporation.
+ * Licensed under the MIT License. */
+
+#include "telemetry_outbox.h"
+
+/* Standard includes. */
+#include <string.h>
+
+/* Kernel includes. */
+#include "FreeRTOS.h"
+
+/*-----------------------------------------------------------*/
+
+#if ( telemetryoutboxROUTINE_SLOT_LIMIT < 1 ) || ( telemetryoutboxROUTINE_SLOT_LIMIT > telemetryoutboxSLOT_COUNT )
+    #error "telemetryoutboxROUTINE_SLOT_LIMIT must be between 1 and telemetryoutboxSLOT_COUNT"
+#endif
+
+#if ( telemetryoutboxURGENT_SLOT_LIMIT < 1 ) || ( telemetryoutboxURGENT_SLOT_LIMIT > telemetryoutboxSLOT_COUNT )
+    #error "telemetryoutboxURGENT_SLOT_LIMIT must be between 1 and telemetryoutboxSLOT_COUNT"
+#endif
+
+static const uint32_t ulClassLimits[ eTelemetryOutboxClassCount ] =
+{
+    telemetryoutboxROUTINE_SLOT_LIMIT,
+    telemetryoutboxURGENT_SLOT_LIMIT
+};
+
+/*-----------------------------------------------------------*/
+
+/**
+ * @brief Index of the oldest pending message of a class not sent again yet,
+ * telemetryoutboxSLOT_COUNT if none.
+ */
+static uint32_t prvOldestNotResent( const TelemetryOutbox_t * pxOutbox,
+                                    TelemetryOutboxClass_t xClass,
+                                    const bool * pxResent )
+{
+    const TelemetryOutboxSlot_t * pxSlot;
+    uint32_t ulOldest = telemetryoutboxSLOT_COUNT;
+    uint32_t ulIndex;
+
+    for( ulIndex = 0; ulIndex < telemetryoutboxSLOT_COUNT; ulIndex++ )
+    {
+        pxSlot = &pxOutbox->xSlots[ ulIndex ];
+
+        /* Sequence numbers are compared as a difference, across their wrap around. */
+        if( pxSlot->xPending && !pxResent[ ulIndex ] && ( pxSlot->xClass == xClass ) &&
+            ( ( ulOldest == telemetryoutboxSLOT_COUNT ) ||
+              ( ( int32_t ) ( pxSlot->ulSequence - pxOutbox->xSlots[ ulOldest ].ulSequence ) < 0 ) ) )
+        {
+            ulOldest = ulIndex;
+        }
+    }
+
+    return ulOldest;
+}
+/*-----------------------------------------------------------*/
+
+void TelemetryOutbox_Init( TelemetryOutbox_t * pxOutbox )
+{
+    uint32_t ulIndex;
+
+    for( ulIndex = 0; ulIndex < telemetryoutboxSLOT_COUNT; ulIndex++ )
+    {
+        pxOutbox->xSlots[ ulIndex ].xPending = false;
+    }
+
+    pxOutbox->ulNextSequence = 0;
+}
+/*-----------------------------------------------------------*/
+
+AzureIoTResult_t TelemetryOutbox_Add( TelemetryOutbox_t * pxOutbox,
+                                      TelemetryOutboxClass_t xClass,
+                                      uint16_t usPacketID,
+                                      const uint8_t * pucPayload,
+                                      uint32_t ulPayloadLength,
+                                      AzureIoTMessageProperties_t * pxProperties )
+{
+    TelemetryOutboxSlot_t * pxSlot;
+    uint32_t ulIndex;
+
+    configASSERT( xClass < eTelemetryOutboxClassCount );
+
+    if( ( ulPayloadLength > telemetryoutboxSLOT_SIZE ) ||
+        ( TelemetryOutbox_GetClassCount( pxOutbox, xClass ) >= ulClassLimits[ xClass ] ) )
+    {
+        return eAzureIoTErrorOutOfMemory;
+    }
+
+    for( ulIndex = 0; ulIndex < telemetryoutboxSLOT_COUNT; ulIndex++ )
+    {
+        pxSlot = &pxOutbox->xSlots[ ulIndex ];
+
+        if( !pxSlot->xPending )
+        {
+            memcpy( pxSlot->ucPayload, pucPayload, ulPayloadLength );
+            pxSlot->ulPayloadLength = ulPayloadLength;
+            pxSlot->pxProperties = pxProperties;
+            pxSlot->ulSequence = pxOutbox->ulNextSequence++;
+            pxSlot->usPacketID = usPacketID;
+            pxSlot->xClass = xClass;
+            pxSlot->xPending = true;
+
+            return eAzureIoTSuccess;
+        }
+    }
+
+    return eAzureIoTErrorOutOfMemory;
+}
+/*-----------------------------------------------------------*/
+
+void TelemetryOutbox_Acknowledge( TelemetryOutbox_t * pxOutbox,
+                                  uint16_t usPacketID )
+{
+    uint32_t ulIndex;
+
+    for( ulIndex = 0; ulIndex < telemetryoutboxSLOT_COUNT; ulIndex++ )
+    {
+        if( pxOutbox->xSlots[ ulIndex ].xPending &&
+            ( pxOutbox->xSlots[ ulIndex ].usPacketID == usPacketID ) )
+        {
+            pxOutbox->xSlots[ ulIndex ].xPending = false;
+            break;
+        }
+    }
+}
+/*-----------------------------------------------------------*/
+
+uint32_t TelemetryOutbox_GetPendingCount( const TelemetryOutbox_t * pxOutbox )
+{
+    uint32_t ulIndex;
+    uint32_t ulCount = 0;
+
+    for( ulIndex = 0; ulIndex < telemetryoutboxSLOT_COUNT; ulIndex++ )
+    {
+        if( pxOutbox->xSlots[ ulIndex ].xPending )
+        {
+            ulCount++;
+        }
+    }
+
+    return ulCount;
+}
+/*-----------------------------------------------------------*/
+
+uint32_t TelemetryOutbox_GetClassCount( const TelemetryOutbox_t * pxOutbox,
+                                        TelemetryOutboxClass_t xClass )
+{
+    uint32_t ulIndex;
+    uint32_t ulCount = 0;
+
+    for( ulIndex = 0; ulIndex < telemetryoutboxSLOT_COUNT; ulIndex++ )
+    {
+        if( pxOutbox->xSlots[ ulIndex ].xPending && ( pxOutbox->xSlots[ ulIndex ].xClass == xClass ) )
+        {
+            ulCount++;
+        }
+    }
+
+    return ulCount;
+}
+/*-----------------------------------------------------------*/
+
+AzureIoTResult_t TelemetryOutbox_Resend( TelemetryOutbox_t * pxOutbox,
+                                         AzureIoTHubClient_t * pxAzureIoTHubClient )
+{
+    static const TelemetryOutboxClass_t xOrder[ eTelemetryOutboxClassCount ] =
+    {
+        eTelemetryOutboxClassUrgent,
+        eTelemetryOutboxClassRoutine
+    };
+    bool xResent[ telemetryoutboxSLOT_COUNT ] = { false };
+    TelemetryOutboxSlot_t * pxSlot;
+    AzureIoTResult_t xResult;
+    uint32_t ulClass;
+    uint32_t ulIndex;
+
+    for( ulClass = 0; ulClass < eTelemetryOutboxClassCount; ulClass++ )
+    {
+        while( ( ulIndex = prvOldestNotResent( pxOutbox, xOrder[ ulClass ], xResent ) ) < telemetryoutboxSLOT_COUNT )
+        {
+            pxSlot = &pxOutbox->xSlots[ ulIndex ];
+            xResent[ ulIndex ] = true;
+
+            /* The packet ID of the previous connection means nothing to this one. */
+            xResult = AzureIoTHubClient_SendTelemetry( pxAzureIoTHubClient,
+                                                       pxSlot->ucPayload, pxSlot->ulPayloadLength,
+                                                       pxSlot->pxProperties, eAzureIoTHubMessageQoS1,
+                                                       &pxSlot->usPacketID );
+
+            if( xResult != eAzureIoTSuccess )
+            {
+                return xResult;
+            }
+        }
+    }
+
+    return eAzureIoTSuccess;
+}
+/*-----------------------------------------------------------*/
@@ -0,0 +1,158 @@
+/* Copyright (c) Microsoft Corporation.
+ * Licensed under the MIT License. */
+
+/**
+ * @file telemetry_outbox.h
+ * @brief Copies of QoS1 telemetry kept until the IoT Hub acknowledges them.
+ *
+ * The MQTT client forgets the messages in flight when it is initialized
+ * again for a new connection. Keeping a copy of each message until its PUBACK
+ * arrives lets the sample send again, after reconnecting, the messages the
+ * IoT Hub may not have received.
+ *
+ * Each message has a class. Routine messages may take only some of the
+ * slots, so a backlog of them never leaves an urgent message, such as an
+ * alert, without a slot, and urgent messages are sent again first.
+ */
+
+#ifndef TELEMETRY_OUTBOX_H
+#define TELEMETRY_OUTBOX_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "azure_iot_hub_client.h"
+
+/**
+ * @brief Number of messages kept at once.
+ */
+#ifndef telemetryoutboxSLOT_COUNT
+    #define telemetryoutboxSLOT_COUNT    ( 4U )
+#endif
+
+/**
+ * @brief Largest message kept, in bytes.
+ */
+#ifndef telemetryoutboxSLOT_SIZE
+    #define telemetryoutboxSLOT_SIZE     ( 256U )
+#endif
+
+/**
+ * @brief Most routine messages kept at once, the other slots being for urgent ones.
+ */
+#ifndef telemetryoutboxROUTINE_SLOT_LIMIT
+    #define telemetryoutboxROUTINE_SLOT_LIMIT    ( telemetryoutboxSLOT_COUNT - 1U )
+#endif
+
+/**
+ * @brief Most urgent messages kept at once.
+ */
+#ifndef telemetryoutboxURGENT_SLOT_LIMIT
+    #define telemetryoutboxURGENT_SLOT_LIMIT     ( telemetryoutboxSLOT_COUNT )
+#endif
+
+/**
+ * @brief Class of a message.
+ */
+typedef enum TelemetryOutboxClass
+{
+    eTelemetryOutboxClassRoutine = 0, /**< Periodic telemetry, kept within telemetryoutboxROUTINE_SLOT_LIMIT. */
+    eTelemetryOutboxClassUrgent,      /**< Alerts, kept within telemetryoutboxURGENT_SLOT_LIMIT and sent again first. */
+    eTelemetryOutboxClassCount
+} TelemetryOutboxClass_t;
+
+/**
+ * @brief A message waiting for its PUBACK.
+ */
+typedef struct TelemetryOutboxSlot
+{
+    uint8_t ucPayload[ telemetryoutboxSLOT_SIZE ];
+    uint32_t ulPayloadLength;
+    AzureIoTMessageProperties_t * pxProperties;
+    uint32_t ulSequence; /**< Order in which the messages were kept. */
+    uint16_t usPacketID;
+    TelemetryOutboxClass_t xClass;
+    bool xPending;
+} TelemetryOutboxSlot_t;
+
+/**
+ * @brief Outbox state. Initialize with TelemetryOutbox_Init().
+ */
+typedef struct TelemetryOutbox
+{
+    TelemetryOutboxSlot_t xSlots[ telemetryoutboxSLOT_COUNT ];
+    uint32_t ulNextSequence;
+} TelemetryOutbox_t;
+
+/**
+ * @brief Initialize an empty outbox.
+ *
+ * @param[out] pxOutbox The outbox.
+ */
+void TelemetryOutbox_Init( TelemetryOutbox_t * pxOutbox );
+
+/**
+ * @brief Keep a copy of a message just sent.
+ *
+ * @param[in,out] pxOutbox The outbox.
+ * @param[in] xClass Class of the message.
+ * @param[in] usPacketID Packet ID the message was sent with.
+ * @param[in] pucPayload The payload, copied.
+ * @param[in] ulPayloadLength Length of @p pucPayload.
+ * @param[in] pxProperties Properties of the message, referenced. They must
+ * stay valid until the message is acknowledged.
+ * @return An #AzureIoTResult_t with the result of the operation.
+ *         eAzureIoTErrorOutOfMemory if every slot is in use, the class has
+ *         reached its limit or the payload is larger than a slot, in which
+ *         case the message is not kept.
+ */
+AzureIoTResult_t TelemetryOutbox_Add( TelemetryOutbox_t * pxOutbox,
+                                      TelemetryOutboxClass_t xClass,
+                                      uint16_t usPacketID,
+                                      const uint8_t * pucPayload,
+                                      uint32_t ulPayloadLength,
+                                      AzureIoTMessageProperties_t * pxProperties );
+
+/**
+ * @brief Release the message of a PUBACK.
+ *
+ * @param[in,out] pxOutbox The outbox.
+ * @param[in] usPacketID Packet ID of the PUBACK. Unknown IDs are ignored.
+ */
+void TelemetryOutbox_Acknowledge( TelemetryOutbox_t * pxOutbox,
+                                  uint16_t usPacketID );
+
+/**
+ * @brief Number of messages waiting for their PUBACK.
+ *
+ * @param[in] pxOutbox The outbox.
+ * @return The number of messages kept.
+ */
+uint32_t TelemetryOutbox_GetPendingCount( const TelemetryOutbox_t * pxOutbox );
+
+/**
+ * @brief Number of messages of a class waiting for their PUBACK.
+ *
+ * @param[in] pxOutbox The outbox.
+ * @param[in] xClass The class.
+ * @return The number of messages of @p xClass kept.
+ */
+uint32_t TelemetryOutbox_GetClassCount( const TelemetryOutbox_t * pxOutbox,
+                                        TelemetryOutboxClass_t xClass );
+
+/**
+ * @brief Send again, with QoS1, every message waiting for its PUBACK.
+ *
+ * Call once connected. Urgent messages are sent first, then routine ones,
+ * each class in the order they were kept. The messages keep their slots under
+ * their new packet IDs.
+ *
+ * @param[in,out] pxOutbox The outbox.
+ * @param[in] pxAzureIoTHubClient The connected #AzureIoTHubClient_t.
+ * @return An #AzureIoTResult_t with the result of the first send that failed,
+ *         or eAzureIoTSuccess.
+ */
+AzureIoTResult_t TelemetryOutbox_Resend( TelemetryOutbox_t * pxOutbox,
+                                         AzureIoTHubClient_t * pxAzureIoTHubClient );
+
+#endif /* TELEMETRY_OUTBOX_H */
@@ -0,0 +1,115 @@
+/* Copyright (c) Microsoft Corporation.
+ * Licensed under the MIT License. */
+
+#include "token_bucket.h"
+
+/* Kernel includes. */
+#include "FreeRTOS.h"
+
+/*-----------------------------------------------------------*/
+
+/**
+ * @brief Add the tokens gained since the last refill.
+ */
+static void prvRefill( TokenBucket_t * pxBucket,
+                       uint64_t ullNowMs )
+{
+    uint64_t ullGained;
+
+    if( pxBucket->ulTokens == pxBucket->ulCapacity )
+    {
+        /* A full bucket gains nothing, the next token is an interval after
+         * the first one is taken. */
+        pxBucket->ullLastRefillMs = ullNowMs;
+        return;
+    }
+
+    ullGained = ( ullNowMs - pxBucket->ullLastRefillMs ) / pxBucket->ulRefillIntervalMs;
+
+    /* Borrowed tokens are repaid first. */
+    if( ullGained <= pxBucket->ulDebt )
+    {
+        pxBucket->ulDebt -= ( uint32_t ) ullGained;
+        pxBucket->ullLastRefillMs += ullGained * pxBucket->ulRefillIntervalMs;
+        return;
+    }
+
+    ullGained -= pxBucket->ulDebt;
+    pxBucket->ullLastRefillMs += ( uint64_t ) pxBucket->ulDebt * pxBucket->ulRefillIntervalMs;
+    pxBucket->ulDebt = 0;
+
+    if( ullGained >= ( uint64_t ) ( pxBucket->ulCapacity - pxBucket->ulTokens ) )
+    {
+        pxBucket->ulTokens = pxBucket->ulCapacity;
+        pxBucket->ullLastRefillMs = ullNowMs;
+    }
+    else
+    {
+        /* Keep the part of the interval already elapsed for the next token. */
+        pxBucket->ulTokens += ( uint32_t ) ullGained;
+        pxBucket->ullLastRefillMs += ullGained * pxBucket->ulRefillIntervalMs;
+    }
+}
+/*-----------------------------------------------------------*/
+
+void TokenBucket_Init( TokenBucket_t * pxBucket,
+                       uint32_t ulCapacity,
+                       uint32_t ulRefillIntervalMs,
+                       uint64_t ullNowMs )
+{
+    configASSERT( pxBucket != NULL );
+    configASSERT( ulCapacity > 0 );
+    configASSERT( ulRefillIntervalMs > 0 );
+
+    pxBucket->ulCapacity = ulCapacity;
+    pxBucket->ulRefillIntervalMs = ulRefillIntervalMs;
+    pxBucket->ulTokens = ulCapacity;
+    pxBucket->ulDebt = 0;
+    pxBucket->ullLastRefillMs = ullNowMs;
+}
+/*-----------------------------------------------------------*/
+
+bool TokenBucket_TryTake( TokenBucket_t * pxBucket,
+                          uint64_t ullNowMs )
+{
+    prvRefill( pxBucket, ullNowMs );
+
+    if( pxBucket->ulTokens == 0 )
+    {
+        return false;
+    }
+
+    pxBucket->ulTokens--;
+
+    return true;
+}
+/*-----------------------------------------------------------*/
+
+void TokenBucket_Borrow( TokenBucket_t * pxBucket,
+                         uint64_t ullNowMs )
+{
+    if( !TokenBucket_TryTake( pxBucket, ullNowMs ) && ( pxBucket->ulDebt < UINT32_MAX ) )
+    {
+        pxBucket->ulDebt++;
+    }
+}
+/*-----------------------------------------------------------*/
+
+uint32_t TokenBucket_TimeToToken( TokenBucket_t * pxBucket,
+                                  uint64_t ullNowMs )
+{
+    uint64_t ullWait;
+
+    prvRefill( pxBucket, ullNowMs );
+
+    if( pxBucket->ulTokens > 0 )
+    {
+        return 0;
+    }
+
+    ullWait = ( ( uint64_t ) pxBucket->ulDebt + 1 ) * pxBucket->ulRefillIntervalMs -
+              ( ullNowMs - pxBucket->ullLastRefillMs );
+
+    return ( ullWait < UINT32_MAX ) ? ( uint32_t ) ullWait : UINT32_MAX;
+}
+/*-----------------------------------------------------------*/
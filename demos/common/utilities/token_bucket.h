@@ -0,0 +1,75 @@
+/* Copyright (c) Microsoft Corporation.
+ * Licensed under the MIT License. */
+
+/**
+ * @file token_bucket.h
+ * @brief Token bucket bounding how often an operation may run.
+ *
+ * The bucket holds up to a capacity of tokens and gains one each refill
+ * interval. Each run of the operation takes a token, so short bursts up to
+ * the capacity go through, while the sustained rate is one run per interval.
+ * A run that cannot wait borrows a token, and the tokens gained next repay
+ * the debt before any can be taken again.
+ */
+
+#ifndef TOKEN_BUCKET_H
+#define TOKEN_BUCKET_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+/**
+ * @brief Bucket state. Initialize with TokenBucket_Init().
+ */
+typedef struct TokenBucket
+{
+    uint32_t ulCapacity;
+    uint32_t ulRefillIntervalMs;
+    uint32_t ulTokens;
+    uint32_t ulDebt;          /**< Tokens borrowed and not repaid yet. */
+    uint64_t ullLastRefillMs; /**< Time the last token was added, or the bucket was last full. */
+} TokenBucket_t;
+
+/**
+ * @brief Initialize a full bucket.
+ *
+ * @param[out] pxBucket The bucket.
+ * @param[in] ulCapacity Maximum number of tokens, at least 1.
+ * @param[in] ulRefillIntervalMs Time to gain a token, at least 1.
+ * @param[in] ullNowMs Current time in milliseconds.
+ */
+void TokenBucket_Init( TokenBucket_t * pxBucket,
+                       uint32_t ulCapacity,
+                       uint32_t ulRefillIntervalMs,
+                       uint64_t ullNowMs );
+
+/**
+ * @brief Take a token if there is one.
+ *
+ * @param[in,out] pxBucket The bucket.
+ * @param[in] ullNowMs Current time in milliseconds.
+ * @return true if a token was taken, false if the bucket is empty.
+ */
+bool TokenBucket_TryTake( TokenBucket_t * pxBucket,
+                          uint64_t ullNowMs );
+
+/**
+ * @brief Take a token, borrowing it if the bucket is empty.
+ *
+ * @param[in,out] pxBucket The bucket.
+ * @param[in] ullNowMs Current time in milliseconds.
+ */
+void TokenBucket_Borrow( TokenBucket_t * pxBucket,
+                         uint64_t ullNowMs );
+
+/**
+ * @brief Time until a token can be taken.
+ *
+ * @param[in,out] pxBucket The bucket.
+ * @param[in] ullNowMs Current time in milliseconds.
+ * @return The time in milliseconds, 0 if a token is available now.
+ */
+uint32_t TokenBucket_TimeToToken( TokenBucket_t * pxBucket,
+                                  uint64_t ullNowMs );
+
+#endif /* TOKEN_BUCKET_H */
@@ -0,0 +1,208 @@
+/* Copyright (c) Microsoft Corporation.
+ * Licensed under the MIT License. */
+
+#include "window_aggregator.h"
+
+/* Standard includes. */
+#include <stddef.h>
+
+/*-----------------------------------------------------------*/
+
+static WindowAggregatorStats_t * prvPane( const WindowAggregator_t * pxAggregator,
+                                          uint64_t ullPane )
+{
+    return &pxAggregator->pxPanes[ ( ullPane % pxAggregator->ulPaneCount ) * pxAggregator->ulSignalCount ];
+}
+/*-----------------------------------------------------------*/
+
+void WindowAggregator_StatsReset( WindowAggregatorStats_t * pxStats )
+{
+    pxStats->ulCount = 0;
+    pxStats->xMinimum = 0.0;
+    pxStats->xMaximum = 0.0;
+    pxStats->xMean = 0.0;
+    pxStats->xM2 = 0.0;
+    pxStats->xLast = 0.0;
+}
+/*-----------------------------------------------------------*/
+
+void WindowAggregator_StatsAdd( WindowAggregatorStats_t * pxStats,
+                                double xValue )
+{
+    double xDelta;
+
+    if( pxStats->ulCount == 0 )
+    {
+        pxStats->xMinimum = xValue;
+        pxStats->xMaximum = xValue;
+    }
+    else if( xValue < pxStats->xMinimum )
+    {
+        pxStats->xMinimum = xValue;
+    }
+    else if( xValue > pxStats->xMaximum )
+    {
+        pxStats->xMaximum = xValue;
+    }
+
+    pxStats->ulCount++;
+    xDelta = xValue - pxStats->xMean;
+    pxStats->xMean += xDelta / pxStats->ulCount;
+    pxStats->xM2 += xDelta * ( xValue - pxStats->xMean );
+    pxStats->xLast = xValue;
+}
+/*-----------------------------------------------------------*/
+
+void WindowAggregator_StatsMerge( WindowAggregatorStats_t * pxStats,
+                                  const WindowAggregatorStats_t * pxLater )
+{
+    double xDelta;
+    double xCount;
+
+    if( pxLater->ulCount == 0 )
+    {
+        return;
+    }
+
+    if( pxStats->ulCount == 0 )
+    {
+        *pxStats = *pxLater;
+
+        return;
+    }
+
+    /* Chan et al. pairwise update of the mean and of the sum of squared differences. */
+    xCount = ( double ) pxStats->ulCount + ( double ) pxLater->ulCount;
+    xDelta = pxLater->xMean - pxStats->xMean;
+    pxStats->xMean += xDelta * ( pxLater->ulCount / xCount );
+    pxStats->xM2 += pxLater->xM2 + xDelta * xDelta * ( ( double ) pxStats->ulCount * pxLater->ulCount / xCount );
+    pxStats->ulCount += pxLater->ulCount;
+
+    if( pxLater->xMinimum < pxStats->xMinimum )
+    {
+        pxStats->xMinimum = pxLater->xMinimum;
+    }
+
+    if( pxLater->xMaximum > pxStats->xMaximum )
+    {
+        pxStats->xMaximum = pxLater->xMaximum;
+    }
+
+    pxStats->xLast = pxLater->xLast;
+}
+/*-----------------------------------------------------------*/
+
+double WindowAggregator_StatsVariance( const WindowAggregatorStats_t * pxStats )
+{
+    return ( pxStats->ulCount < 2 ) ? 0.0 : pxStats->xM2 / ( pxStats->ulCount - 1 );
+}
+/*-----------------------------------------------------------*/
+
+bool WindowAggregator_Init( WindowAggregator_t * pxAggregator,
+                            WindowAggregatorStats_t * pxPanes,
+                            uint32_t ulSignalCount,
+                            uint32_t ulPaneCount,
+                            uint64_t ullWindowDuration )
+{
+    uint32_t ulIndex;
+
+    if( ( pxPanes == NULL ) || ( ulSignalCount == 0 ) || ( ulPaneCount == 0 ) ||
+        ( ullWindowDuration == 0 ) || ( ( ullWindowDuration % ulPaneCount ) != 0 ) )
+    {
+        return false;
+    }
+
+    pxAggregator->pxPanes = pxPanes;
+    pxAggregator->ulSignalCount = ulSignalCount;
+    pxAggregator->ulPaneCount = ulPaneCount;
+    pxAggregator->ullPaneDuration = ullWindowDuration / ulPaneCount;
+    pxAggregator->ullPane = 0;
+    pxAggregator->xStarted = false;
+
+    for( ulIndex = 0; ulIndex < ( ulSignalCount * ulPaneCount ); ulIndex++ )
+    {
+        WindowAggregator_StatsReset( &pxPanes[ ulIndex ] );
+    }
+
+    return true;
+}
+/*-----------------------------------------------------------*/
+
+bool WindowAggregator_Advance( WindowAggregator_t * pxAggregator,
+                               uint64_t ullTime,
+                               WindowAggregatorStats_t * pxClosed )
+{
+    WindowAggregatorStats_t xStats;
+    WindowAggregatorStats_t * pxPane;
+    uint64_t ullPane = ullTime / pxAggregator->ullPaneDuration;
+    uint64_t ullCleared;
+    uint32_t ulSignal;
+    bool xHasSamples = false;
+
+    if( !pxAggregator->xStarted )
+    {
+        pxAggregator->ullPane = ullPane;
+        pxAggregator->xStarted = true;
+
+        return false;
+    }
+
+    if( ullPane <= pxAggregator->ullPane )
+    {
+        return false;
+    }
+
+    for( ulSignal = 0; ulSignal < pxAggregator->ulSignalCount; ulSignal++ )
+    {
+        WindowAggregator_Get( pxAggregator, ulSignal, &xStats );
+        xHasSamples = xHasSamples || ( xStats.ulCount > 0 );
+
+        if( pxClosed != NULL )
+        {
+            pxClosed[ ulSignal ] = xStats;
+        }
+    }
+
+    /* Empty the panes entering the window, at most all of them. */
+    for( ullCleared = 1;
+         ( ullCleared <= ( ullPane - pxAggregator->ullPane ) ) && ( ullCleared <= pxAggregator->ulPaneCount );
+         ullCleared++ )
+    {
+        pxPane = prvPane( pxAggregator, pxAggregator->ullPane + ullCleared );
+
+        for( ulSignal = 0; ulSignal < pxAggregator->ulSignalCount; ulSignal++ )
+        {
+            WindowAggregator_StatsReset( &pxPane[ ulSignal ] );
+        }
+    }
+
+    pxAggregator->ullPane = ullPane;
+
+    return xHasSamples;
+}
+/*-----------------------------------------------------------*/
+
+void WindowAggregator_Add( WindowAggregator_t * pxAggregator,
+                           uint32_t ulSignal,
+                           double xValue )
+{
+    WindowAggregator_StatsAdd( &prvPane( pxAggregator, pxAggregator->ullPane )[ ulSignal ], xValue );
+}
+/*-----------------------------------------------------------*/
+
+void WindowAggregator_Get( const WindowAggregator_t * pxAggregator,
+                           uint32_t ulSignal,
+                           WindowAggregatorStats_t * pxStats )
+{
+    uint32_t ulIndex;
+
+    WindowAggregator_StatsReset( pxStats );
+
+    /* Oldest pane first, so the last value comes from the most recent pane. */
+    for( ulIndex = pxAggregator->ulPaneCount; ulIndex > 0; ulIndex-- )
+    {
+        WindowAggregator_StatsMerge( pxStats,
+                                     &prvPane( pxAggregator, pxAggregator->ullPane + 1 - ulIndex + pxAggregator->ulPaneCount )[ ulSignal ] );
+    }
+}
+/*-----------------------------------------------------------*/
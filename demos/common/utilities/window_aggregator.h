@@ -0,0 +1,143 @@
+/* Copyright (c) Microsoft Corporation.
+ * Licensed under the MIT License. */
+
+/**
+ * @file window_aggregator.h
+ * @brief Streaming statistics of telemetry signals over time windows.
+ *
+ * Every signal gets count, minimum, maximum, mean, variance and last value,
+ * updated in constant time per sample with Welford's method, which stays
+ * accurate where the sum of squares would cancel out.
+ *
+ * A window is split in panes of equal duration. The statistics of a pane are
+ * kept apart, and the statistics of a window are merged from its panes. With
+ * one pane the windows are tumbling: they follow each other without overlap.
+ * With more panes the window slides by one pane at a time. The caller provides
+ * the memory of the panes, nothing is allocated.
+ */
+
+#ifndef WINDOW_AGGREGATOR_H
+#define WINDOW_AGGREGATOR_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+/**
+ * @brief Statistics of a signal.
+ */
+typedef struct WindowAggregatorStats
+{
+    uint32_t ulCount;
+    double xMinimum;
+    double xMaximum;
+    double xMean;
+    double xM2;   /**< Sum of the squared differences to the mean. */
+    double xLast; /**< Most recent sample. */
+} WindowAggregatorStats_t;
+
+/**
+ * @brief Aggregator state. Initialize with WindowAggregator_Init().
+ */
+typedef struct WindowAggregator
+{
+    WindowAggregatorStats_t * pxPanes; /**< ulPaneCount rows of ulSignalCount statistics. */
+    uint32_t ulSignalCount;
+    uint32_t ulPaneCount;
+    uint64_t ullPaneDuration;
+    uint64_t ullPane;                  /**< Index of the current pane, time divided by ullPaneDuration. */
+    bool xStarted;
+} WindowAggregator_t;
+
+/**
+ * @brief Reset statistics to no sample.
+ *
+ * @param[out] pxStats The statistics.
+ */
+void WindowAggregator_StatsReset( WindowAggregatorStats_t * pxStats );
+
+/**
+ * @brief Add a sample to statistics.
+ *
+ * @param[in,out] pxStats The statistics.
+ * @param[in] xValue The sample.
+ */
+void WindowAggregator_StatsAdd( WindowAggregatorStats_t * pxStats,
+                                double xValue );
+
+/**
+ * @brief Merge the statistics of a later period into statistics.
+ *
+ * @param[in,out] pxStats The statistics of the earlier period, receiving the merge.
+ * @param[in] pxLater The statistics of the later period.
+ */
+void WindowAggregator_StatsMerge( WindowAggregatorStats_t * pxStats,
+                                  const WindowAggregatorStats_t * pxLater );
+
+/**
+ * @brief Sample variance of statistics.
+ *
+ * @param[in] pxStats The statistics.
+ * @return The variance, 0 with less than two samples.
+ */
+double WindowAggregator_StatsVariance( const WindowAggregatorStats_t * pxStats );
+
+/**
+ * @brief Initialize an aggregator.
+ *
+ * Times are in any unit, as long as the same one is used with WindowAggregator_Advance().
+ * Windows are aligned on multiples of the pane duration.
+ *
+ * @param[out] pxAggregator The aggregator.
+ * @param[in] pxPanes Memory of the panes, @p ulPaneCount times @p ulSignalCount statistics.
+ *            It is referenced, not copied, and must outlive the aggregator.
+ * @param[in] ulSignalCount Number of signals.
+ * @param[in] ulPaneCount Number of panes of a window, 1 for tumbling windows.
+ * @param[in] ullWindowDuration Duration of a window, a multiple of @p ulPaneCount.
+ * @return `false` if a count is 0 or the duration is not a multiple of the pane count.
+ */
+bool WindowAggregator_Init( WindowAggregator_t * pxAggregator,
+                            WindowAggregatorStats_t * pxPanes,
+                            uint32_t ulSignalCount,
+                            uint32_t ulPaneCount,
+                            uint64_t ullWindowDuration );
+
+/**
+ * @brief Move the aggregator to a time, closing the window in progress when a pane ends.
+ *
+ * Call it before adding the samples taken at @p ullTime. When several pane
+ * boundaries are crossed at once, the window ending at the first one is reported.
+ * A time before the current pane is taken as part of it.
+ *
+ * @param[in,out] pxAggregator The aggregator.
+ * @param[in] ullTime The time.
+ * @param[out] pxClosed Receives the statistics of every signal over the window that ended,
+ *             an array of ulSignalCount entries. May be `NULL`.
+ * @return `true` if a window holding samples ended.
+ */
+bool WindowAggregator_Advance( WindowAggregator_t * pxAggregator,
+                               uint64_t ullTime,
+                               WindowAggregatorStats_t * pxClosed );
+
+/**
+ * @brief Add a sample of a signal to the current pane.
+ *
+ * @param[in,out] pxAggregator The aggregator.
+ * @param[in] ulSignal Index of the signal.
+ * @param[in] xValue The sample.
+ */
+void WindowAggregator_Add( WindowAggregator_t * pxAggregator,
+                           uint32_t ulSignal,
+                           double xValue );
+
+/**
+ * @brief Statistics of a signal over the window in progress.
+ *
+ * @param[in] pxAggregator The aggregator.
+ * @param[in] ulSignal Index of the signal.
+ * @param[out] pxStats The statistics.
+ */
+void WindowAggregator_Get( const WindowAggregator_t * pxAggregator,
+                           uint32_t ulSignal,
+                           WindowAggregatorStats_t * pxStats );
+
+#endif /* WINDOW_AGGREGATOR_H */
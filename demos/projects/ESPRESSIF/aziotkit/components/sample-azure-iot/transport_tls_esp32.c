@@ -173,6 +173,29 @@ int32_t TLS_Socket_Recv( NetworkContext_t * pNetworkContext,
 }
 /*-----------------------------------------------------------*/
 
+int32_t TLS_Socket_WaitForData( NetworkContext_t * pNetworkContext,
+                                uint32_t ulTimeoutMs )
+{
+    int32_t tlsStatus = 0;
+
+    if ( pNetworkContext == NULL )
+    {
+        ESP_LOGE( TAG, "Invalid input parameter(s): Arguments cannot be NULL. pNetworkContext=%p.", pNetworkContext );
+        return ESP_FAIL;
+    }
+
+    /* Also reports data esp-tls has decrypted but not returned yet. */
+    tlsStatus = esp_transport_poll_read( pNetworkContext->xTransport, ulTimeoutMs );
+    if ( tlsStatus < 0 )
+    {
+        ESP_LOGE( TAG, "Polling failed, errno= %d", errno );
+        return ESP_FAIL;
+    }
+
+    return ( tlsStatus > 0 ) ? 1 : 0;
+}
+/*-----------------------------------------------------------*/
+
 int32_t TLS_Socket_Send( NetworkContext_t * pNetworkContext,
                            const void * pBuffer,
                            size_t xBytesToSend )
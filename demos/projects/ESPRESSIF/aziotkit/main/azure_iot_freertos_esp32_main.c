@@ -305,9 +305,11 @@ uint32_t ulHandleCommand( AzureIoTHubClientCommandRequest_t * pxMessage,
 
 uint32_t ulCreateTelemetry( uint8_t * pucTelemetryData,
                             uint32_t ulTelemetryDataSize,
-                            uint32_t * ulTelemetryDataLength )
+                            uint32_t * ulTelemetryDataLength,
+                            AzureIoTMessageProperties_t ** ppxTelemetryProperties )
 {
     *ulTelemetryDataLength = ulSampleCreateTelemetry( pucTelemetryData, ulTelemetryDataSize );
+    *ppxTelemetryProperties = NULL;
 
     return 0;
 }
@@ -13,6 +13,10 @@
 
 #include "sample_azure_iot_pnp_data_if.h"
 #include "sensor_manager.h"
+#include "command_dispatcher.h"
+#include "property_router.h"
+#include "window_aggregator.h"
+#include "report_filter.h"
 /*-----------------------------------------------------------*/
 
 #define INDEFINITE_TIME                            ( ( time_t ) - 1 )
@@ -65,8 +69,68 @@ static const char *TAG = "sample_azureiotkit";
 #define sampleazureiotTELEMETRY_ACCELEROMETERX     ( "accelerometerX" )
 #define sampleazureiotTELEMETRY_ACCELEROMETERY     ( "accelerometerY" )
 #define sampleazureiotTELEMETRY_ACCELEROMETERZ     ( "accelerometerZ" )
+#define sampleazureiotTELEMETRY_SIGNAL_COUNT       ( 13 )
 
-static time_t xLastTelemetrySendTime = INDEFINITE_TIME;
+/**
+ * @brief Telemetry signals, in the order prvReadSensors() samples them.
+ */
+typedef struct TelemetrySignal
+{
+    const char * pcName;
+    uint32_t ulNameLength;
+    bool xIsInteger;
+} TelemetrySignal_t;
+
+static const TelemetrySignal_t xTelemetrySignals[ sampleazureiotTELEMETRY_SIGNAL_COUNT ] =
+{
+    { sampleazureiotTELEMETRY_TEMPERATURE,    lengthof( sampleazureiotTELEMETRY_TEMPERATURE ),    false },
+    { sampleazureiotTELEMETRY_HUMIDITY,       lengthof( sampleazureiotTELEMETRY_HUMIDITY ),       false },
+    { sampleazureiotTELEMETRY_LIGHT,          lengthof( sampleazureiotTELEMETRY_LIGHT ),          false },
+    { sampleazureiotTELEMETRY_PRESSURE,       lengthof( sampleazureiotTELEMETRY_PRESSURE ),       false },
+    { sampleazureiotTELEMETRY_ALTITUDE,       lengthof( sampleazureiotTELEMETRY_ALTITUDE ),       false },
+    { sampleazureiotTELEMETRY_MAGNETOMETERX,  lengthof( sampleazureiotTELEMETRY_MAGNETOMETERX ),  true  },
+    { sampleazureiotTELEMETRY_MAGNETOMETERY,  lengthof( sampleazureiotTELEMETRY_MAGNETOMETERY ),  true  },
+    { sampleazureiotTELEMETRY_MAGNETOMETERZ,  lengthof( sampleazureiotTELEMETRY_MAGNETOMETERZ ),  true  },
+    { sampleazureiotTELEMETRY_PITCH,          lengthof( sampleazureiotTELEMETRY_PITCH ),          true  },
+    { sampleazureiotTELEMETRY_ROLL,           lengthof( sampleazureiotTELEMETRY_ROLL ),           true  },
+    { sampleazureiotTELEMETRY_ACCELEROMETERX, lengthof( sampleazureiotTELEMETRY_ACCELEROMETERX ), true  },
+    { sampleazureiotTELEMETRY_ACCELEROMETERY, lengthof( sampleazureiotTELEMETRY_ACCELEROMETERY ), true  },
+    { sampleazureiotTELEMETRY_ACCELEROMETERZ, lengthof( sampleazureiotTELEMETRY_ACCELEROMETERZ ), true  }
+};
+
+/**
+ * @brief Report-on-change rules of xTelemetrySignals, in seconds.
+ *
+ * Fields are sent when they move past their dead-band, and at least every
+ * sampleazureiotTELEMETRY_HEARTBEAT_SECS seconds.
+ */
+#define sampleazureiotTELEMETRY_HEARTBEAT_SECS     ( 300 )
+
+static const ReportFilterRule_t xTelemetryRules[ sampleazureiotTELEMETRY_SIGNAL_COUNT ] =
+{
+    { 0.2,  0.0,  0, sampleazureiotTELEMETRY_HEARTBEAT_SECS }, /* Temperature, degrees Celsius. */
+    { 1.0,  0.0,  0, sampleazureiotTELEMETRY_HEARTBEAT_SECS }, /* Humidity, percent. */
+    { 1.0,  0.05, 0, sampleazureiotTELEMETRY_HEARTBEAT_SECS }, /* Light, lux. */
+    { 0.5,  0.0,  0, sampleazureiotTELEMETRY_HEARTBEAT_SECS }, /* Pressure, hectopascals. */
+    { 2.0,  0.0,  0, sampleazureiotTELEMETRY_HEARTBEAT_SECS }, /* Altitude, meters. */
+    { 10.0, 0.0,  0, sampleazureiotTELEMETRY_HEARTBEAT_SECS }, /* Magnetometer. */
+    { 10.0, 0.0,  0, sampleazureiotTELEMETRY_HEARTBEAT_SECS },
+    { 10.0, 0.0,  0, sampleazureiotTELEMETRY_HEARTBEAT_SECS },
+    { 2.0,  0.0,  0, sampleazureiotTELEMETRY_HEARTBEAT_SECS }, /* Pitch and roll, degrees. */
+    { 2.0,  0.0,  0, sampleazureiotTELEMETRY_HEARTBEAT_SECS },
+    { 50.0, 0.0,  0, sampleazureiotTELEMETRY_HEARTBEAT_SECS }, /* Accelerometer. */
+    { 50.0, 0.0,  0, sampleazureiotTELEMETRY_HEARTBEAT_SECS },
+    { 50.0, 0.0,  0, sampleazureiotTELEMETRY_HEARTBEAT_SECS }
+};
+
+static ReportFilterField_t xTelemetryReports[ sampleazureiotTELEMETRY_SIGNAL_COUNT ];
+static ReportFilter_t xTelemetryFilter;
+static bool xTelemetryFilterReady = false;
+
+/* Samples are averaged over tumbling windows of lTelemetryFrequencySecs seconds. */
+static WindowAggregatorStats_t xTelemetryPanes[ sampleazureiotTELEMETRY_SIGNAL_COUNT ];
+static WindowAggregator_t xTelemetryAggregator;
+static int32_t lTelemetryWindowSecs = 0;
 
 /**
  * @brief Command Values
@@ -87,7 +151,7 @@ static bool xLed2State = false;
 #define sampleazureiotPROPERTY_SUCCESS             "success"
 #define sampleazureiotPROPERTY_TELEMETRY_FREQUENCY ( "telemetryFrequencySecs" )
 
-static int lTelemetryFrequencySecs = 2;
+static int32_t lTelemetryFrequencySecs = 2;
 /*-----------------------------------------------------------*/
 
 int32_t lGenerateDeviceInfo( uint8_t * pucPropertiesData,
@@ -157,220 +221,331 @@ int32_t lGenerateDeviceInfo( uint8_t * pucPropertiesData,
 }
 /*-----------------------------------------------------------*/
 
-/**
- * @brief Command message callback handler
- */
-uint32_t ulSampleHandleCommand( AzureIoTHubClientCommandRequest_t * pxMessage,
-                                uint32_t * pulResponseStatus,
-                                uint8_t * pucCommandResponsePayloadBuffer,
-                                uint32_t ulCommandResponsePayloadBufferSize)
+static uint32_t prvWriteEmptyPayload( uint8_t * pucResponsePayload,
+                                      uint32_t ulResponsePayloadSize,
+                                      uint32_t * pulResponsePayloadLength )
 {
-    uint32_t ulCommandResponsePayloadLength;
+    *pulResponsePayloadLength = lengthof( sampleazureiotCOMMAND_EMPTY_PAYLOAD );
+    configASSERT( ulResponsePayloadSize >= *pulResponsePayloadLength );
+    (void)memcpy( pucResponsePayload, sampleazureiotCOMMAND_EMPTY_PAYLOAD, *pulResponsePayloadLength );
 
-    ESP_LOGI( TAG, "Command payload : %.*s \r\n",
-              pxMessage->ulPayloadLength,
-              ( const char * ) pxMessage->pvMessagePayload );
-
-    if ( strncmp( ( const char * ) pxMessage->pucCommandName, sampleazureiotCOMMAND_TOGGLE_LED1, pxMessage->usCommandNameLength ) == 0)
-    {
-        xLed1State = !xLed1State;
-        led1_set_state( xLed1State ? LED_STATE_ON : LED_STATE_OFF );
+    return AZ_IOT_STATUS_OK;
+}
+/*-----------------------------------------------------------*/
 
-        *pulResponseStatus = AZ_IOT_STATUS_OK;
-        ulCommandResponsePayloadLength = lengthof( sampleazureiotCOMMAND_EMPTY_PAYLOAD );
-        (void)memcpy( pucCommandResponsePayloadBuffer, sampleazureiotCOMMAND_EMPTY_PAYLOAD, ulCommandResponsePayloadLength );
-    }
-    else if ( strncmp( ( const char * ) pxMessage->pucCommandName, sampleazureiotCOMMAND_TOGGLE_LED2, pxMessage->usCommandNameLength ) == 0)
-    {
-        xLed2State = !xLed2State;
-        led2_set_state( xLed2State ? LED_STATE_ON : LED_STATE_OFF );
+static uint32_t prvToggleLed1Command( const AzureIoTHubClientCommandRequest_t * pxMessage,
+                                      uint8_t * pucResponsePayload,
+                                      uint32_t ulResponsePayloadSize,
+                                      uint32_t * pulResponsePayloadLength,
+                                      void * pvContext )
+{
+    ( void ) pxMessage;
+    ( void ) pvContext;
 
-        *pulResponseStatus = AZ_IOT_STATUS_OK;
-        ulCommandResponsePayloadLength = lengthof( sampleazureiotCOMMAND_EMPTY_PAYLOAD );
-        configASSERT( ulCommandResponsePayloadBufferSize >= ulCommandResponsePayloadLength );
-        (void)memcpy( pucCommandResponsePayloadBuffer, sampleazureiotCOMMAND_EMPTY_PAYLOAD, ulCommandResponsePayloadLength );
-    }
-    else if ( strncmp( ( const char * ) pxMessage->pucCommandName, sampleazureiotCOMMAND_DISPLAY_TEXT, pxMessage->usCommandNameLength ) == 0)
-    {
-        oled_clean_screen();
-        uint32_t ulStringLength = UNQUOTED_STRING_LENGTH( pxMessage->ulPayloadLength );
-        
-        oled_show_message( ( const uint8_t * ) UNQUOTE_STRING( pxMessage->pvMessagePayload ),
-                            ulStringLength <= OLED_DISPLAY_MAX_STRING_LENGTH ? ulStringLength : OLED_DISPLAY_MAX_STRING_LENGTH );
-
-        *pulResponseStatus = AZ_IOT_STATUS_OK;
-        ulCommandResponsePayloadLength = lengthof( sampleazureiotCOMMAND_EMPTY_PAYLOAD );
-        configASSERT( ulCommandResponsePayloadBufferSize >= ulCommandResponsePayloadLength );
-        (void)memcpy( pucCommandResponsePayloadBuffer, sampleazureiotCOMMAND_EMPTY_PAYLOAD, ulCommandResponsePayloadLength );
-    }
-    else
-    {
-        *pulResponseStatus = AZ_IOT_STATUS_NOT_FOUND;
-        ulCommandResponsePayloadLength = lengthof( sampleazureiotCOMMAND_EMPTY_PAYLOAD );
-        configASSERT( ulCommandResponsePayloadBufferSize >= ulCommandResponsePayloadLength );
-        (void)memcpy( pucCommandResponsePayloadBuffer, sampleazureiotCOMMAND_EMPTY_PAYLOAD, ulCommandResponsePayloadLength );
-    }
+    xLed1State = !xLed1State;
+    led1_set_state( xLed1State ? LED_STATE_ON : LED_STATE_OFF );
 
-    return ulCommandResponsePayloadLength;
+    return prvWriteEmptyPayload( pucResponsePayload, ulResponsePayloadSize, pulResponsePayloadLength );
 }
 /*-----------------------------------------------------------*/
 
-uint32_t ulSampleCreateTelemetry( uint8_t * pucTelemetryData,
-                                  uint32_t ulTelemetryDataLength )
+static uint32_t prvToggleLed2Command( const AzureIoTHubClientCommandRequest_t * pxMessage,
+                                      uint8_t * pucResponsePayload,
+                                      uint32_t ulResponsePayloadSize,
+                                      uint32_t * pulResponsePayloadLength,
+                                      void * pvContext )
 {
-    int32_t lBytesWritten = 0;
-    time_t xNow = time( NULL );
+    ( void ) pxMessage;
+    ( void ) pvContext;
 
-    if ( xNow == INDEFINITE_TIME )
-    {
-        ESP_LOGE( TAG, "Failed obtaining current time.\r\n" );
-    }
-
-    if ( xLastTelemetrySendTime == INDEFINITE_TIME || xNow == INDEFINITE_TIME ||
-         difftime( xNow , xLastTelemetrySendTime ) > lTelemetryFrequencySecs )
-    {
-        AzureIoTResult_t xAzIoTResult;
-        AzureIoTJSONWriter_t xWriter;
-
-        float xPressure;
-        float xAltitude;
-        int lMagnetometerX;
-        int lMagnetometerY;
-        int lMagnetometerZ;
-        int lPitch;
-        int lRoll;
-        int lAccelerometerX;
-        int lAccelerometerY;
-        int lAccelerometerZ;
-
-        // Collect sensor data
-        float xTemperature = get_temperature();
-        float xHumidity = get_humidity();
-        float xLight = get_ambientLight();
-        get_pressure_altitude( &xPressure, &xAltitude );
-        get_magnetometer( &lMagnetometerX, &lMagnetometerY, &lMagnetometerZ );
-        get_pitch_roll_accel( &lPitch, &lRoll, &lAccelerometerX, &lAccelerometerY, &lAccelerometerZ );
-
-        // Initialize Json Writer
-        xAzIoTResult = AzureIoTJSONWriter_Init( &xWriter, pucTelemetryData, ulTelemetryDataLength );
-        configASSERT( xAzIoTResult == eAzureIoTSuccess );
+    xLed2State = !xLed2State;
+    led2_set_state( xLed2State ? LED_STATE_ON : LED_STATE_OFF );
 
-        xAzIoTResult = AzureIoTJSONWriter_AppendBeginObject( &xWriter );
-        configASSERT( xAzIoTResult == eAzureIoTSuccess );
-        
-        // Temperature, Humidity, Light Intensity
-        xAzIoTResult = AzureIoTJSONWriter_AppendPropertyWithDoubleValue( &xWriter, ( uint8_t * )sampleazureiotTELEMETRY_TEMPERATURE, lengthof( sampleazureiotTELEMETRY_TEMPERATURE ), xTemperature, 2 );
-        configASSERT( xAzIoTResult == eAzureIoTSuccess );
+    return prvWriteEmptyPayload( pucResponsePayload, ulResponsePayloadSize, pulResponsePayloadLength );
+}
+/*-----------------------------------------------------------*/
 
-        xAzIoTResult = AzureIoTJSONWriter_AppendPropertyWithDoubleValue( &xWriter, ( uint8_t * )sampleazureiotTELEMETRY_HUMIDITY, lengthof( sampleazureiotTELEMETRY_HUMIDITY ), xHumidity, 2 );
-        configASSERT( xAzIoTResult == eAzureIoTSuccess );
+static uint32_t prvDisplayTextCommand( const AzureIoTHubClientCommandRequest_t * pxMessage,
+                                       uint8_t * pucResponsePayload,
+                                       uint32_t ulResponsePayloadSize,
+                                       uint32_t * pulResponsePayloadLength,
+                                       void * pvContext )
+{
+    uint32_t ulStringLength = UNQUOTED_STRING_LENGTH( pxMessage->ulPayloadLength );
 
-        xAzIoTResult = AzureIoTJSONWriter_AppendPropertyWithDoubleValue( &xWriter, ( uint8_t * )sampleazureiotTELEMETRY_LIGHT, lengthof( sampleazureiotTELEMETRY_LIGHT ), xLight, 2 );
-        configASSERT( xAzIoTResult == eAzureIoTSuccess );
+    ( void ) pvContext;
 
-        // Pressure, Altitude
-        xAzIoTResult = AzureIoTJSONWriter_AppendPropertyWithDoubleValue( &xWriter, ( uint8_t * )sampleazureiotTELEMETRY_PRESSURE, lengthof( sampleazureiotTELEMETRY_PRESSURE ), xPressure, 2 );
-        configASSERT( xAzIoTResult == eAzureIoTSuccess );
+    oled_clean_screen();
 
-        xAzIoTResult = AzureIoTJSONWriter_AppendPropertyWithDoubleValue( &xWriter, ( uint8_t * )sampleazureiotTELEMETRY_ALTITUDE, lengthof( sampleazureiotTELEMETRY_ALTITUDE ), xAltitude, 2 );
-        configASSERT( xAzIoTResult == eAzureIoTSuccess );
+    oled_show_message( ( const uint8_t * ) UNQUOTE_STRING( pxMessage->pvMessagePayload ),
+                        ulStringLength <= OLED_DISPLAY_MAX_STRING_LENGTH ? ulStringLength : OLED_DISPLAY_MAX_STRING_LENGTH );
 
-        // Magnetometer
-        xAzIoTResult = AzureIoTJSONWriter_AppendPropertyWithInt32Value( &xWriter, ( uint8_t * )sampleazureiotTELEMETRY_MAGNETOMETERX, lengthof( sampleazureiotTELEMETRY_MAGNETOMETERX ), lMagnetometerX );
-        configASSERT( xAzIoTResult == eAzureIoTSuccess );
+    return prvWriteEmptyPayload( pucResponsePayload, ulResponsePayloadSize, pulResponsePayloadLength );
+}
+/*-----------------------------------------------------------*/
 
-        xAzIoTResult = AzureIoTJSONWriter_AppendPropertyWithInt32Value( &xWriter, ( uint8_t * )sampleazureiotTELEMETRY_MAGNETOMETERY, lengthof( sampleazureiotTELEMETRY_MAGNETOMETERY ), lMagnetometerY );
-        configASSERT( xAzIoTResult == eAzureIoTSuccess );
+/**
+ * @brief Dispatcher of the commands of the kit, registered on first use.
+ */
+static CommandDispatcher_t * prvGetCommandDispatcher( void )
+{
+    static CommandDispatcher_t xCommandDispatcher;
+    static bool xCommandDispatcherReady = false;
+    AzureIoTResult_t xAzIoTResult;
 
-        xAzIoTResult = AzureIoTJSONWriter_AppendPropertyWithInt32Value( &xWriter, ( uint8_t * )sampleazureiotTELEMETRY_MAGNETOMETERZ, lengthof( sampleazureiotTELEMETRY_MAGNETOMETERZ ), lMagnetometerZ );
-        configASSERT( xAzIoTResult == eAzureIoTSuccess );
+    if ( !xCommandDispatcherReady )
+    {
+        CommandDispatcher_Init( &xCommandDispatcher );
 
-        // Pitch, Roll, Accelleration
-        xAzIoTResult = AzureIoTJSONWriter_AppendPropertyWithInt32Value( &xWriter, ( uint8_t * )sampleazureiotTELEMETRY_PITCH, lengthof( sampleazureiotTELEMETRY_PITCH ), lPitch );
+        xAzIoTResult = CommandDispatcher_Register( &xCommandDispatcher, NULL, 0,
+                                                   ( const uint8_t * ) sampleazureiotCOMMAND_TOGGLE_LED1, lengthof( sampleazureiotCOMMAND_TOGGLE_LED1 ),
+                                                   prvToggleLed1Command, NULL );
         configASSERT( xAzIoTResult == eAzureIoTSuccess );
 
-        xAzIoTResult = AzureIoTJSONWriter_AppendPropertyWithInt32Value( &xWriter, ( uint8_t * )sampleazureiotTELEMETRY_ROLL, lengthof( sampleazureiotTELEMETRY_ROLL ), lRoll );
+        xAzIoTResult = CommandDispatcher_Register( &xCommandDispatcher, NULL, 0,
+                                                   ( const uint8_t * ) sampleazureiotCOMMAND_TOGGLE_LED2, lengthof( sampleazureiotCOMMAND_TOGGLE_LED2 ),
+                                                   prvToggleLed2Command, NULL );
         configASSERT( xAzIoTResult == eAzureIoTSuccess );
 
-        xAzIoTResult = AzureIoTJSONWriter_AppendPropertyWithInt32Value( &xWriter, ( uint8_t * )sampleazureiotTELEMETRY_ACCELEROMETERX, lengthof( sampleazureiotTELEMETRY_ACCELEROMETERX ), lAccelerometerX );
+        xAzIoTResult = CommandDispatcher_Register( &xCommandDispatcher, NULL, 0,
+                                                   ( const uint8_t * ) sampleazureiotCOMMAND_DISPLAY_TEXT, lengthof( sampleazureiotCOMMAND_DISPLAY_TEXT ),
+                                                   prvDisplayTextCommand, NULL );
         configASSERT( xAzIoTResult == eAzureIoTSuccess );
 
-        xAzIoTResult = AzureIoTJSONWriter_AppendPropertyWithInt32Value( &xWriter, ( uint8_t * )sampleazureiotTELEMETRY_ACCELEROMETERY, lengthof( sampleazureiotTELEMETRY_ACCELEROMETERY ), lAccelerometerY );
-        configASSERT( xAzIoTResult == eAzureIoTSuccess );
+        xCommandDispatcherReady = true;
+    }
 
-        xAzIoTResult = AzureIoTJSONWriter_AppendPropertyWithInt32Value( &xWriter, ( uint8_t * )sampleazureiotTELEMETRY_ACCELEROMETERZ, lengthof( sampleazureiotTELEMETRY_ACCELEROMETERZ ), lAccelerometerZ );
-        configASSERT( xAzIoTResult == eAzureIoTSuccess );
+    return &xCommandDispatcher;
+}
+/*-----------------------------------------------------------*/
 
-        // Complete Json Content
-        xAzIoTResult = AzureIoTJSONWriter_AppendEndObject( &xWriter );
-        configASSERT( xAzIoTResult == eAzureIoTSuccess );
+/**
+ * @brief Command message callback handler
+ */
+uint32_t ulSampleHandleCommand( AzureIoTHubClientCommandRequest_t * pxMessage,
+                                uint32_t * pulResponseStatus,
+                                uint8_t * pucCommandResponsePayloadBuffer,
+                                uint32_t ulCommandResponsePayloadBufferSize)
+{
+    uint32_t ulCommandResponsePayloadLength;
 
-        lBytesWritten = AzureIoTJSONWriter_GetBytesUsed( &xWriter );
-        configASSERT( lBytesWritten > 0 );
+    ESP_LOGI( TAG, "Command payload : %.*s \r\n",
+              pxMessage->ulPayloadLength,
+              ( const char * ) pxMessage->pvMessagePayload );
 
-        xLastTelemetrySendTime = xNow;
+    if ( CommandDispatcher_Dispatch( prvGetCommandDispatcher(), pxMessage,
+                                     pucCommandResponsePayloadBuffer, ulCommandResponsePayloadBufferSize,
+                                     pulResponseStatus, &ulCommandResponsePayloadLength ) != eAzureIoTSuccess )
+    {
+        ( void ) prvWriteEmptyPayload( pucCommandResponsePayloadBuffer, ulCommandResponsePayloadBufferSize, &ulCommandResponsePayloadLength );
+        *pulResponseStatus = AZ_IOT_STATUS_NOT_FOUND;
     }
 
-    return lBytesWritten;
+    return ulCommandResponsePayloadLength;
 }
 /*-----------------------------------------------------------*/
 
+/**
+ * @brief Sample every sensor, in the order of xTelemetrySignals.
+ */
+static void prvReadSensors( double * pxSamples )
+{
+    float xPressure;
+    float xAltitude;
+    int lMagnetometerX;
+    int lMagnetometerY;
+    int lMagnetometerZ;
+    int lPitch;
+    int lRoll;
+    int lAccelerometerX;
+    int lAccelerometerY;
+    int lAccelerometerZ;
+
+    pxSamples[ 0 ] = get_temperature();
+    pxSamples[ 1 ] = get_humidity();
+    pxSamples[ 2 ] = get_ambientLight();
+    get_pressure_altitude( &xPressure, &xAltitude );
+    get_magnetometer( &lMagnetometerX, &lMagnetometerY, &lMagnetometerZ );
+    get_pitch_roll_accel( &lPitch, &lRoll, &lAccelerometerX, &lAccelerometerY, &lAccelerometerZ );
+
+    pxSamples[ 3 ] = xPressure;
+    pxSamples[ 4 ] = xAltitude;
+    pxSamples[ 5 ] = lMagnetometerX;
+    pxSamples[ 6 ] = lMagnetometerY;
+    pxSamples[ 7 ] = lMagnetometerZ;
+    pxSamples[ 8 ] = lPitch;
+    pxSamples[ 9 ] = lRoll;
+    pxSamples[ 10 ] = lAccelerometerX;
+    pxSamples[ 11 ] = lAccelerometerY;
+    pxSamples[ 12 ] = lAccelerometerZ;
+}
+/*-----------------------------------------------------------*/
 
 /**
- * @brief Acknowledges the update of Telemetry Frequency property.
+ * @brief Write a telemetry message with the values of the selected xTelemetrySignals.
+ *
+ * @p pxSelected tells which signals to write, all of them if `NULL`.
  */
-static uint32_t prvGenerateAckForTelemetryFrequencyPropertyUpdate( uint8_t * pucPropertiesData,
-                                                                   uint32_t ulPropertiesDataSize,
-                                                                   uint32_t ulVersion )
+static int32_t prvWriteTelemetry( const double * pxValues,
+                                  const bool * pxSelected,
+                                  uint8_t * pucTelemetryData,
+                                  uint32_t ulTelemetryDataLength )
 {
     AzureIoTResult_t xAzIoTResult;
     AzureIoTJSONWriter_t xWriter;
+    const TelemetrySignal_t * pxSignal;
     int32_t lBytesWritten;
+    uint32_t ulIndex;
 
-    xAzIoTResult = AzureIoTJSONWriter_Init( &xWriter, pucPropertiesData, ulPropertiesDataSize );
+    // Initialize Json Writer
+    xAzIoTResult = AzureIoTJSONWriter_Init( &xWriter, pucTelemetryData, ulTelemetryDataLength );
     configASSERT( xAzIoTResult == eAzureIoTSuccess );
 
     xAzIoTResult = AzureIoTJSONWriter_AppendBeginObject( &xWriter );
     configASSERT( xAzIoTResult == eAzureIoTSuccess );
 
-    xAzIoTResult = AzureIoTHubClientProperties_BuilderBeginResponseStatus( &xAzureIoTHubClient,
-                                                                           &xWriter,
-                                                                           ( const uint8_t * ) sampleazureiotPROPERTY_TELEMETRY_FREQUENCY,
-                                                                           lengthof( sampleazureiotPROPERTY_TELEMETRY_FREQUENCY ),
-                                                                           sampleazureiotPROPERTY_STATUS_SUCCESS,
-                                                                           ulVersion,
-                                                                           ( const uint8_t * ) sampleazureiotPROPERTY_SUCCESS,
-                                                                           lengthof( sampleazureiotPROPERTY_SUCCESS ) );
-    configASSERT( xAzIoTResult == eAzureIoTSuccess );
+    for( ulIndex = 0; ulIndex < sampleazureiotTELEMETRY_SIGNAL_COUNT; ulIndex++ )
+    {
+        if( ( pxSelected != NULL ) && !pxSelected[ ulIndex ] )
+        {
+            continue;
+        }
 
-    xAzIoTResult = AzureIoTJSONWriter_AppendInt32( &xWriter, lTelemetryFrequencySecs );
-    configASSERT( xAzIoTResult == eAzureIoTSuccess );
+        pxSignal = &xTelemetrySignals[ ulIndex ];
 
-    xAzIoTResult = AzureIoTHubClientProperties_BuilderEndResponseStatus( &xAzureIoTHubClient, &xWriter );
-    configASSERT( xAzIoTResult == eAzureIoTSuccess );
+        if( pxSignal->xIsInteger )
+        {
+            xAzIoTResult = AzureIoTJSONWriter_AppendPropertyWithInt32Value( &xWriter, ( const uint8_t * ) pxSignal->pcName, pxSignal->ulNameLength,
+                                                                            ( int32_t ) ( pxValues[ ulIndex ] + ( pxValues[ ulIndex ] < 0 ? -0.5 : 0.5 ) ) );
+        }
+        else
+        {
+            xAzIoTResult = AzureIoTJSONWriter_AppendPropertyWithDoubleValue( &xWriter, ( const uint8_t * ) pxSignal->pcName, pxSignal->ulNameLength,
+                                                                             pxValues[ ulIndex ], 2 );
+        }
+
+        configASSERT( xAzIoTResult == eAzureIoTSuccess );
+    }
 
+    // Complete Json Content
     xAzIoTResult = AzureIoTJSONWriter_AppendEndObject( &xWriter );
     configASSERT( xAzIoTResult == eAzureIoTSuccess );
 
     lBytesWritten = AzureIoTJSONWriter_GetBytesUsed( &xWriter );
     configASSERT( lBytesWritten > 0 );
 
-    return ( uint32_t ) lBytesWritten;
+    return lBytesWritten;
+}
+/*-----------------------------------------------------------*/
+
+/**
+ * @brief Sample the sensors, and send the averages of the samples once per telemetry period.
+ *
+ * Only the averages that changed enough since they were last sent are part of
+ * the message, and no message is sent if none did. Without a valid time the
+ * samples are all sent as they are, at every call.
+ */
+uint32_t ulSampleCreateTelemetry( uint8_t * pucTelemetryData,
+                                  uint32_t ulTelemetryDataLength )
+{
+    WindowAggregatorStats_t xWindow[ sampleazureiotTELEMETRY_SIGNAL_COUNT ];
+    double xSamples[ sampleazureiotTELEMETRY_SIGNAL_COUNT ];
+    double xMeans[ sampleazureiotTELEMETRY_SIGNAL_COUNT ];
+    bool xSelected[ sampleazureiotTELEMETRY_SIGNAL_COUNT ];
+    bool xAnySelected = false;
+    int32_t lBytesWritten = 0;
+    uint32_t ulIndex;
+    time_t xNow = time( NULL );
+
+    prvReadSensors( xSamples );
+
+    if ( xNow == INDEFINITE_TIME )
+    {
+        ESP_LOGE( TAG, "Failed obtaining current time.\r\n" );
+
+        return prvWriteTelemetry( xSamples, NULL, pucTelemetryData, ulTelemetryDataLength );
+    }
+
+    if ( !xTelemetryFilterReady )
+    {
+        ReportFilter_Init( &xTelemetryFilter, xTelemetryRules, xTelemetryReports, sampleazureiotTELEMETRY_SIGNAL_COUNT );
+        xTelemetryFilterReady = true;
+    }
+
+    /* A new period starts a new window, dropping the samples of the current one. */
+    if ( lTelemetryWindowSecs != lTelemetryFrequencySecs )
+    {
+        ( void ) WindowAggregator_Init( &xTelemetryAggregator, xTelemetryPanes, sampleazureiotTELEMETRY_SIGNAL_COUNT,
+                                        1, ( uint64_t ) lTelemetryFrequencySecs );
+        lTelemetryWindowSecs = lTelemetryFrequencySecs;
+    }
+
+    if ( WindowAggregator_Advance( &xTelemetryAggregator, ( uint64_t ) xNow, xWindow ) )
+    {
+        for( ulIndex = 0; ulIndex < sampleazureiotTELEMETRY_SIGNAL_COUNT; ulIndex++ )
+        {
+            xMeans[ ulIndex ] = xWindow[ ulIndex ].xMean;
+            xSelected[ ulIndex ] = ReportFilter_Update( &xTelemetryFilter, ulIndex, ( uint64_t ) xNow, xMeans[ ulIndex ] );
+            xAnySelected = xAnySelected || xSelected[ ulIndex ];
+        }
+
+        if ( xAnySelected )
+        {
+            lBytesWritten = prvWriteTelemetry( xMeans, xSelected, pucTelemetryData, ulTelemetryDataLength );
+        }
+    }
+
+    for( ulIndex = 0; ulIndex < sampleazureiotTELEMETRY_SIGNAL_COUNT; ulIndex++ )
+    {
+        WindowAggregator_Add( &xTelemetryAggregator, ulIndex, xSamples[ ulIndex ] );
+    }
+
+    return lBytesWritten;
 }
 /*-----------------------------------------------------------*/
 
-static void prvSkipPropertyAndValue( AzureIoTJSONReader_t * pxReader )
+
+static void prvOnTelemetryFrequencyApplied( const PropertyRoute_t * pxRoute )
+{
+    ( void ) pxRoute;
+
+    ESP_LOGI( TAG, "Telemetry frequency set to once every %d seconds.\r\n", ( int ) lTelemetryFrequencySecs );
+}
+/*-----------------------------------------------------------*/
+
+/**
+ * @brief Writable properties of the kit.
+ */
+static const PropertyRoute_t xPropertyRoutes[] =
+{
+    {
+        NULL, 0,
+        propertyrouterNAME( sampleazureiotPROPERTY_TELEMETRY_FREQUENCY ),
+        ePropertyRouterValueInt32, &lTelemetryFrequencySecs,
+        1, INT32_MAX,
+        prvOnTelemetryFrequencyApplied
+    }
+};
+/*-----------------------------------------------------------*/
+
+/**
+ * @brief Router of the writable properties of the kit, initialized on first use.
+ */
+static PropertyRouter_t * prvGetPropertyRouter( void )
 {
-    AzureIoTResult_t xResult;
+    static PropertyRouter_t xPropertyRouter;
+    static bool xPropertyRouterReady = false;
+    AzureIoTResult_t xAzIoTResult;
 
-    xResult = AzureIoTJSONReader_NextToken( pxReader );
-    configASSERT( xResult == eAzureIoTSuccess );
+    if ( !xPropertyRouterReady )
+    {
+        xAzIoTResult = PropertyRouter_Init( &xPropertyRouter, xPropertyRoutes, sizeof( xPropertyRoutes ) / sizeof( xPropertyRoutes[ 0 ] ) );
+        configASSERT( xAzIoTResult == eAzureIoTSuccess );
 
-    xResult = AzureIoTJSONReader_SkipChildren( pxReader );
-    configASSERT( xResult == eAzureIoTSuccess );
+        xPropertyRouterReady = true;
+    }
 
-    xResult = AzureIoTJSONReader_NextToken( pxReader );
-    configASSERT( xResult == eAzureIoTSuccess );
+    return &xPropertyRouter;
 }
 /*-----------------------------------------------------------*/
 
@@ -383,55 +558,12 @@ void vHandleWritableProperties( AzureIoTHubClientPropertiesResponse_t * pxMessag
                                 uint32_t * pulWritablePropertyResponseBufferLength )
 {
     AzureIoTResult_t xAzIoTResult;
-    AzureIoTJSONReader_t xJsonReader;
-    const uint8_t * pucComponentName = NULL;
-    uint32_t ulComponentNameLength = 0;
-    uint32_t ulPropertyVersion;
-
-    xAzIoTResult = AzureIoTJSONReader_Init( &xJsonReader, pxMessage->pvMessagePayload, pxMessage->ulPayloadLength );
-    configASSERT( xAzIoTResult == eAzureIoTSuccess );
-
-    xAzIoTResult = AzureIoTHubClientProperties_GetPropertiesVersion( &xAzureIoTHubClient, &xJsonReader, pxMessage->xMessageType, &ulPropertyVersion );
-    configASSERT( xAzIoTResult == eAzureIoTSuccess );
 
-    /* Reset JSON reader to the beginning */
-    xAzIoTResult = AzureIoTJSONReader_Init( &xJsonReader, pxMessage->pvMessagePayload, pxMessage->ulPayloadLength );
-    configASSERT( xAzIoTResult == eAzureIoTSuccess );
-
-    while( ( xAzIoTResult = AzureIoTHubClientProperties_GetNextComponentProperty( &xAzureIoTHubClient, &xJsonReader,
-                                                                                  pxMessage->xMessageType, eAzureIoTHubClientPropertyWritable,
-                                                                                  &pucComponentName, &ulComponentNameLength ) ) == eAzureIoTSuccess )
-    {
-        if( AzureIoTJSONReader_TokenIsTextEqual( &xJsonReader,
-                                                 ( const uint8_t * ) sampleazureiotPROPERTY_TELEMETRY_FREQUENCY,
-                                                 lengthof( sampleazureiotPROPERTY_TELEMETRY_FREQUENCY ) ) )
-        {
-            xAzIoTResult = AzureIoTJSONReader_NextToken( &xJsonReader );
-            configASSERT( xAzIoTResult == eAzureIoTSuccess );
-
-            xAzIoTResult = AzureIoTJSONReader_GetTokenInt32( &xJsonReader, &lTelemetryFrequencySecs );
-            configASSERT( xAzIoTResult == eAzureIoTSuccess );
-
-            *pulWritablePropertyResponseBufferLength = prvGenerateAckForTelemetryFrequencyPropertyUpdate(
-                                                            pucWritablePropertyResponseBuffer,
-                                                            ulWritablePropertyResponseBufferSize,
-                                                            ulPropertyVersion );
-
-            ESP_LOGI( TAG, "Telemetry frequency set to once every %d seconds.\r\n", lTelemetryFrequencySecs );
-
-            xAzIoTResult = AzureIoTJSONReader_NextToken( &xJsonReader );
-            configASSERT( xAzIoTResult == eAzureIoTSuccess );
-        }
-        else
-        {
-            LogInfo( ( "Unknown property arrived: skipping over it." ) );
-
-            /* Unknown property arrived. We have to skip over the property and value to continue iterating. */
-            prvSkipPropertyAndValue( &xJsonReader );
-        }
-    }
+    xAzIoTResult = PropertyRouter_Process( prvGetPropertyRouter(), &xAzureIoTHubClient, pxMessage,
+                                           pucWritablePropertyResponseBuffer, ulWritablePropertyResponseBufferSize,
+                                           pulWritablePropertyResponseBufferLength );
 
-    if( xAzIoTResult != eAzureIoTErrorEndOfProperties )
+    if( xAzIoTResult != eAzureIoTSuccess )
     {
         LogError( ( "There was an error parsing the properties: result 0x%08x", xAzIoTResult ) );
     }
@@ -83,6 +83,15 @@
  */
 #define democonfigREGISTRATION_ID CONFIG_AZURE_DPS_REGISTRATION_ID
 
+/**
+ * @brief Cache the IoT Hub and device ID assigned by the provisioning service (PnP sample).
+ *
+ * @note The entry is kept in NVS and reused on the next boot. If the cached
+ * IoT Hub rejects the device, the device is provisioned again.
+ */
+#ifdef CONFIG_ENABLE_DPS_CACHE
+    #define democonfigENABLE_DPS_CACHE
+#endif
 
 #endif // democonfigENABLE_DPS_SAMPLE
 
@@ -18,6 +18,10 @@
 #include "freertos/task.h"
 #include "freertos/semphr.h"
 #include "nvs_flash.h"
+
+#ifdef CONFIG_ENABLE_DPS_CACHE
+#include "provisioning_cache.h"
+#endif
 /*-----------------------------------------------------------*/
 
 #define NR_OF_IP_ADDRESSES_TO_WAIT_FOR 1
@@ -295,3 +299,58 @@ uint64_t ullGetUnixTime( void )
     return now;
 }
 /*-----------------------------------------------------------*/
+
+#ifdef CONFIG_ENABLE_DPS_CACHE
+
+#define NVS_DPS_CACHE_NAMESPACE "azure_iot"
+#define NVS_DPS_CACHE_KEY "dps_cache"
+
+uint32_t ulProvisioningCacheRead( uint8_t * pucBuffer,
+                                  uint32_t ulBufferLength )
+{
+    nvs_handle_t handle;
+    size_t length = ulBufferLength;
+    esp_err_t err;
+
+    if (nvs_open(NVS_DPS_CACHE_NAMESPACE, NVS_READONLY, &handle) != ESP_OK)
+    {
+        return 1;
+    }
+
+    err = nvs_get_blob(handle, NVS_DPS_CACHE_KEY, pucBuffer, &length);
+    nvs_close(handle);
+
+    return (err == ESP_OK && length == ulBufferLength) ? 0 : 1;
+}
+/*-----------------------------------------------------------*/
+
+uint32_t ulProvisioningCacheWrite( const uint8_t * pucBuffer,
+                                   uint32_t ulBufferLength )
+{
+    nvs_handle_t handle;
+    esp_err_t err;
+
+    if (nvs_open(NVS_DPS_CACHE_NAMESPACE, NVS_READWRITE, &handle) != ESP_OK)
+    {
+        return 1;
+    }
+
+    err = nvs_set_blob(handle, NVS_DPS_CACHE_KEY, pucBuffer, ulBufferLength);
+
+    if (err == ESP_OK)
+    {
+        err = nvs_commit(handle);
+    }
+
+    nvs_close(handle);
+
+    if (err != ESP_OK)
+    {
+        ESP_LOGE(TAG, "Failed storing the provisioning cache: %s", esp_err_to_name(err));
+    }
+
+    return err == ESP_OK ? 0 : 1;
+}
+/*-----------------------------------------------------------*/
+
+#endif /* CONFIG_ENABLE_DPS_CACHE */
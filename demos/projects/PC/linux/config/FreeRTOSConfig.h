@@ -185,4 +185,8 @@ extern void vLoggingPrintf( const char * pcFormatString,
 extern int iMainRand32( void );
 #define configRAND32()    iMainRand32()
 
+/* Monotonic clock in microseconds, for the latency of the command handlers. */
+extern uint32_t ulMainGetTimeUs( void );
+#define commanddispatcherGET_TIME_US()    ulMainGetTimeUs()
+
 #endif /* FREERTOS_CONFIG_H */
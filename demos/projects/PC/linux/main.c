@@ -24,6 +24,10 @@
 /* Demo Specific configs. */
 #include "demo_config.h"
 
+#ifdef democonfigENABLE_DPS_CACHE
+    #include "provisioning_cache.h"
+#endif
+
 #define mainHOST_NAME           "RTOSDemo"
 #define mainDEVICE_NICK_NAME    "linux_demo"
 
@@ -383,6 +387,54 @@ uint64_t ullGetUnixTime( void )
 }
 /*-----------------------------------------------------------*/
 
+#ifdef democonfigENABLE_DPS_CACHE
+
+uint32_t ulProvisioningCacheRead( uint8_t * pucBuffer,
+                                  uint32_t ulBufferLength )
+{
+    FILE * file;
+    size_t read_len;
+
+    file = fopen( democonfigDPS_CACHE_FILE, "rb" );
+
+    if( file == NULL )
+    {
+        return 1;
+    }
+
+    read_len = fread( pucBuffer, 1, ulBufferLength, file );
+    fclose( file );
+
+    return read_len == ulBufferLength ? 0 : 1;
+}
+/*-----------------------------------------------------------*/
+
+uint32_t ulProvisioningCacheWrite( const uint8_t * pucBuffer,
+                                   uint32_t ulBufferLength )
+{
+    FILE * file;
+    size_t write_len;
+
+    file = fopen( democonfigDPS_CACHE_FILE, "wb" );
+
+    if( file == NULL )
+    {
+        return 1;
+    }
+
+    write_len = fwrite( pucBuffer, 1, ulBufferLength, file );
+
+    if( fclose( file ) != 0 )
+    {
+        return 1;
+    }
+
+    return write_len == ulBufferLength ? 0 : 1;
+}
+/*-----------------------------------------------------------*/
+
+#endif /* democonfigENABLE_DPS_CACHE */
+
 /**
  * @brief Function to generate a random number.
  *
@@ -443,3 +495,13 @@ int iMainRand32( void )
     return( ( int ) ( uxlNextRand >> 16UL ) & 0x7fffUL );
 }
 /*-----------------------------------------------------------*/
+
+uint32_t ulMainGetTimeUs( void )
+{
+    struct timespec xNow;
+
+    ( void ) clock_gettime( CLOCK_MONOTONIC, &xNow );
+
+    return ( uint32_t ) ( ( ( uint64_t ) xNow.tv_sec * 1000000U ) + ( ( uint64_t ) xNow.tv_nsec / 1000U ) );
+}
+/*-----------------------------------------------------------*/
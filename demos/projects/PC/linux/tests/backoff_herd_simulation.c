@@ -0,0 +1,256 @@
+/* Copyright (c) Microsoft Corporation.
+ * Licensed under the MIT License. */
+
+/**
+ * @file backoff_herd_simulation.c
+ * @brief Discrete-event simulation of a fleet reconnecting after an outage.
+ *
+ * Every device loses the IoT Hub at time 0 and retries as the PnP sample does:
+ * each failure waits a delay of its backoff policy, and each retry spends a
+ * token of a retry budget, waiting for one once it is spent. The hub comes
+ * back after the outage and accepts a limited number of connections per
+ * second, refusing the others, with a retry-after hint when enabled.
+ *
+ * For each policy it prints the time for half, 99% and all of the fleet to
+ * be connected again, the connection attempts, and the peak attempts in a
+ * second. It fails if a policy leaves a device disconnected.
+ *
+ * Usage: backoff_herd_simulation [devices [connections per second [outage seconds]]]
+ */
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "FreeRTOS.h"
+
+#include "backoff_policy.h"
+#include "token_bucket.h"
+
+/*-----------------------------------------------------------*/
+
+/* Recovery settings of the PnP sample for a transient outage. */
+#define simulationBACKOFF_BASE_MS          ( 1000U )
+#define simulationBACKOFF_CAP_MS           ( 5U * 60U * 1000U )
+#define simulationRETRY_BUDGET_TOKENS      ( 10U )
+#define simulationRETRY_BUDGET_REFILL_MS   ( 60U * 1000U )
+
+/* Longest simulated time, after which the devices left are reported. */
+#define simulationHORIZON_MS               ( 4ULL * 60U * 60U * 1000U )
+
+/**
+ * @brief A device of the fleet.
+ */
+typedef struct SimulationDevice
+{
+    BackoffPolicy_t xBackoff;
+    TokenBucket_t xRetryBudget;
+    uint64_t ullNextAttemptMs;
+} SimulationDevice_t;
+
+/**
+ * @brief A policy to simulate.
+ */
+typedef struct SimulationPolicy
+{
+    const char * pcName;
+    BackoffPolicyType_t xType;
+    bool xRetryAfter; /**< Whether the hub sends a retry-after hint when it refuses a device. */
+} SimulationPolicy_t;
+
+static SimulationDevice_t * pxDevices;
+static uint32_t * pulHeap; /**< Devices ordered by their next attempt. */
+static uint32_t ulHeapLength;
+/*-----------------------------------------------------------*/
+
+static bool prvEarlier( uint32_t ulA,
+                        uint32_t ulB )
+{
+    return pxDevices[ pulHeap[ ulA ] ].ullNextAttemptMs < pxDevices[ pulHeap[ ulB ] ].ullNextAttemptMs;
+}
+/*-----------------------------------------------------------*/
+
+static void prvSwap( uint32_t ulA,
+                     uint32_t ulB )
+{
+    uint32_t ulDevice = pulHeap[ ulA ];
+
+    pulHeap[ ulA ] = pulHeap[ ulB ];
+    pulHeap[ ulB ] = ulDevice;
+}
+/*-----------------------------------------------------------*/
+
+static void prvHeapPush( uint32_t ulDevice )
+{
+    uint32_t ulIndex = ulHeapLength++;
+
+    pulHeap[ ulIndex ] = ulDevice;
+
+    while( ( ulIndex > 0 ) && prvEarlier( ulIndex, ( ulIndex - 1 ) / 2 ) )
+    {
+        prvSwap( ulIndex, ( ulIndex - 1 ) / 2 );
+        ulIndex = ( ulIndex - 1 ) / 2;
+    }
+}
+/*-----------------------------------------------------------*/
+
+static uint32_t prvHeapPop( void )
+{
+    uint32_t ulDevice = pulHeap[ 0 ];
+    uint32_t ulIndex = 0;
+    uint32_t ulChild;
+
+    pulHeap[ 0 ] = pulHeap[ --ulHeapLength ];
+
+    while( ( ulChild = ulIndex * 2 + 1 ) < ulHeapLength )
+    {
+        if( ( ( ulChild + 1 ) < ulHeapLength ) && prvEarlier( ulChild + 1, ulChild ) )
+        {
+            ulChild++;
+        }
+
+        if( !prvEarlier( ulChild, ulIndex ) )
+        {
+            break;
+        }
+
+        prvSwap( ulChild, ulIndex );
+        ulIndex = ulChild;
+    }
+
+    return ulDevice;
+}
+/*-----------------------------------------------------------*/
+
+/**
+ * @brief Simulate the recovery of the fleet with a policy and print it.
+ *
+ * @return The number of devices still disconnected at the horizon.
+ */
+static uint32_t prvSimulate( const SimulationPolicy_t * pxPolicy,
+                             uint32_t ulDeviceCount,
+                             uint32_t ulCapacityPerSecond,
+                             uint64_t ullOutageMs )
+{
+    SimulationDevice_t * pxDevice;
+    uint64_t ullSecond = UINT64_MAX;
+    uint64_t ullHalfMs = 0, ullMostMs = 0, ullAllMs = 0;
+    uint64_t ullNowMs;
+    uint64_t ullAttempts = 0;
+    uint32_t ulAcceptedInSecond = 0;
+    uint32_t ulAttemptsInSecond = 0;
+    uint32_t ulPeakAttempts = 0;
+    uint64_t ullSlotMs = 0;
+    uint32_t ulConnected = 0;
+    uint32_t ulDevice;
+    uint32_t ulDelayMs;
+
+    srand( 1 );
+    ulHeapLength = 0;
+
+    for( ulDevice = 0; ulDevice < ulDeviceCount; ulDevice++ )
+    {
+        pxDevice = &pxDevices[ ulDevice ];
+        BackoffPolicy_Init( &pxDevice->xBackoff, pxPolicy->xType, simulationBACKOFF_BASE_MS, simulationBACKOFF_CAP_MS );
+        TokenBucket_Init( &pxDevice->xRetryBudget, simulationRETRY_BUDGET_TOKENS, simulationRETRY_BUDGET_REFILL_MS, 0 );
+
+        /* The devices notice the outage within a keep-alive of 60 seconds. */
+        pxDevice->ullNextAttemptMs = configRAND32() % 60000U;
+        prvHeapPush( ulDevice );
+    }
+
+    while( ( ulHeapLength > 0 ) && ( pxDevices[ pulHeap[ 0 ] ].ullNextAttemptMs < simulationHORIZON_MS ) )
+    {
+        ulDevice = prvHeapPop();
+        pxDevice = &pxDevices[ ulDevice ];
+        ullNowMs = pxDevice->ullNextAttemptMs;
+        ullAttempts++;
+
+        if( ( ullNowMs / 1000U ) != ullSecond )
+        {
+            ullSecond = ullNowMs / 1000U;
+            ulAcceptedInSecond = 0;
+            ulAttemptsInSecond = 0;
+        }
+
+        if( ++ulAttemptsInSecond > ulPeakAttempts )
+        {
+            ulPeakAttempts = ulAttemptsInSecond;
+        }
+
+        if( ( ullNowMs >= ullOutageMs ) && ( ulAcceptedInSecond < ulCapacityPerSecond ) )
+        {
+            ulAcceptedInSecond++;
+            ulConnected++;
+            ullHalfMs = ( ulConnected == ( ulDeviceCount + 1 ) / 2 ) ? ullNowMs : ullHalfMs;
+            ullMostMs = ( ulConnected == ( ulDeviceCount * 99U + 99U ) / 100U ) ? ullNowMs : ullMostMs;
+            ullAllMs = ( ulConnected == ulDeviceCount ) ? ullNowMs : ullAllMs;
+            continue;
+        }
+
+        /* Once up, a hub over capacity gives each refused device the next free slot at its rate. */
+        if( ( ullNowMs >= ullOutageMs ) && pxPolicy->xRetryAfter )
+        {
+            ullSlotMs = ( ( ullSlotMs > ullNowMs ) ? ullSlotMs : ullNowMs ) + 1000U / ulCapacityPerSecond;
+            BackoffPolicy_SetRetryAfter( &pxDevice->xBackoff, ( uint32_t ) ( ullSlotMs - ullNowMs ) );
+        }
+
+        /* Wait as the sample does: the backoff delay, then a token of the retry budget. */
+        ulDelayMs = BackoffPolicy_NextDelay( &pxDevice->xBackoff, configRAND32() );
+        pxDevice->ullNextAttemptMs = ullNowMs + ulDelayMs;
+        pxDevice->ullNextAttemptMs += TokenBucket_TimeToToken( &pxDevice->xRetryBudget, pxDevice->ullNextAttemptMs );
+        ( void ) TokenBucket_TryTake( &pxDevice->xRetryBudget, pxDevice->ullNextAttemptMs );
+        prvHeapPush( ulDevice );
+    }
+
+    printf( "%-34s %9.1f %9.1f %9.1f %11llu %9u\n", pxPolicy->pcName,
+            ullHalfMs / 1000.0, ullMostMs / 1000.0, ( ulConnected == ulDeviceCount ) ? ullAllMs / 1000.0 : -1.0,
+            ( unsigned long long ) ullAttempts, ulPeakAttempts );
+
+    return ulDeviceCount - ulConnected;
+}
+/*-----------------------------------------------------------*/
+
+int main( int argc,
+          char ** argv )
+{
+    const SimulationPolicy_t xPolicies[] =
+    {
+        { "full jitter",                      eBackoffPolicyFullJitter,          false },
+        { "equal jitter",                     eBackoffPolicyEqualJitter,         false },
+        { "decorrelated jitter",              eBackoffPolicyDecorrelatedJitter,  false },
+        { "decorrelated jitter, retry-after", eBackoffPolicyDecorrelatedJitter,  true  }
+    };
+    uint32_t ulDeviceCount = ( argc > 1 ) ? ( uint32_t ) strtoul( argv[ 1 ], NULL, 10 ) : 10000U;
+    uint32_t ulCapacityPerSecond = ( argc > 2 ) ? ( uint32_t ) strtoul( argv[ 2 ], NULL, 10 ) : 50U;
+    uint64_t ullOutageMs = ( ( argc > 3 ) ? strtoull( argv[ 3 ], NULL, 10 ) : 120U ) * 1000U;
+    uint32_t ulDisconnected = 0;
+    uint32_t ulPolicy;
+
+    if( ( ulDeviceCount == 0 ) || ( ulCapacityPerSecond == 0 ) )
+    {
+        fprintf( stderr, "Usage: %s [devices [connections per second [outage seconds]]]\n", argv[ 0 ] );
+
+        return 2;
+    }
+
+    pxDevices = calloc( ulDeviceCount, sizeof( *pxDevices ) );
+    pulHeap = calloc( ulDeviceCount, sizeof( *pulHeap ) );
+    configASSERT( ( pxDevices != NULL ) && ( pulHeap != NULL ) );
+
+    printf( "%u devices, hub accepting %u connections/s after a %llu s outage\n\n",
+            ulDeviceCount, ulCapacityPerSecond, ( unsigned long long ) ( ullOutageMs / 1000U ) );
+    printf( "%-34s %9s %9s %9s %11s %9s\n", "policy", "50% (s)", "99% (s)", "100% (s)", "attempts", "peak/s" );
+
+    for( ulPolicy = 0; ulPolicy < sizeof( xPolicies ) / sizeof( xPolicies[ 0 ] ); ulPolicy++ )
+    {
+        ulDisconnected += prvSimulate( &xPolicies[ ulPolicy ], ulDeviceCount, ulCapacityPerSecond, ullOutageMs );
+    }
+
+    free( pxDevices );
+    free( pulHeap );
+
+    return ( ulDisconnected == 0 ) ? 0 : 1;
+}
+/*-----------------------------------------------------------*/
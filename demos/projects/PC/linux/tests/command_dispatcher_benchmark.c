@@ -0,0 +1,231 @@
+/* Copyright (c) Microsoft Corporation.
+ * Licensed under the MIT License. */
+
+/**
+ * @file command_dispatcher_benchmark.c
+ * @brief Lookup time of the command dispatcher, from 8 to 64 commands.
+ *
+ * Built with room for 64 commands. For each table size it registers the
+ * commands, spread over three components and the root interface, checks that
+ * each is dispatched to its handler, and times the lookups against a linear
+ * scan of the same table. It also checks the latency the dispatcher records,
+ * with a tick count the handlers move.
+ *
+ * Usage: command_dispatcher_benchmark [lookups]
+ */
+
+#include <stdbool.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "command_dispatcher.h"
+
+#include "unit_test.h"
+
+/*-----------------------------------------------------------*/
+
+#define benchmarkNAME_LENGTH    ( 8U )
+
+static const char * const pcComponents[] = { NULL, "thermostat1", "thermostat2", "deviceInformation" };
+
+static char cCommandNames[ commanddispatcherMAX_COMMANDS ][ benchmarkNAME_LENGTH ];
+static AzureIoTHubClientCommandRequest_t xRequests[ commanddispatcherMAX_COMMANDS ];
+
+/* Fake tick count, moved by the handlers to give them a latency. */
+static TickType_t xTickCount;
+/*-----------------------------------------------------------*/
+
+TickType_t xTaskGetTickCount( void )
+{
+    return xTickCount;
+}
+/*-----------------------------------------------------------*/
+
+static uint64_t prvGetTimeNs( void )
+{
+    struct timespec xNow;
+
+    ( void ) clock_gettime( CLOCK_MONOTONIC, &xNow );
+
+    return ( ( uint64_t ) xNow.tv_sec * 1000000000U ) + ( uint64_t ) xNow.tv_nsec;
+}
+/*-----------------------------------------------------------*/
+
+/**
+ * @brief Handler answering with the index of its command, taking its index modulo 3 in ticks.
+ */
+static uint32_t prvHandler( const AzureIoTHubClientCommandRequest_t * pxMessage,
+                            uint8_t * pucResponsePayload,
+                            uint32_t ulResponsePayloadSize,
+                            uint32_t * pulResponsePayloadLength,
+                            void * pvContext )
+{
+    uint32_t ulIndex = ( uint32_t ) ( uintptr_t ) pvContext;
+
+    ( void ) pxMessage;
+    ( void ) pucResponsePayload;
+    ( void ) ulResponsePayloadSize;
+    *pulResponsePayloadLength = 0;
+    xTickCount += ulIndex % 3U;
+
+    return 200U + ulIndex;
+}
+/*-----------------------------------------------------------*/
+
+/**
+ * @brief The lookup of a dispatcher without hashing, for comparison.
+ */
+static const CommandDispatcherEntry_t * prvLinearFind( const CommandDispatcher_t * pxDispatcher,
+                                                       const AzureIoTHubClientCommandRequest_t * pxRequest )
+{
+    const CommandDispatcherEntry_t * pxEntry;
+    uint32_t ulIndex;
+
+    for( ulIndex = 0; ulIndex < pxDispatcher->ulEntryCount; ulIndex++ )
+    {
+        pxEntry = &pxDispatcher->xEntries[ ulIndex ];
+
+        if( ( pxEntry->ulComponentNameLength == pxRequest->usComponentNameLength ) &&
+            ( pxEntry->ulCommandNameLength == pxRequest->usCommandNameLength ) &&
+            ( memcmp( pxEntry->pucCommandName, pxRequest->pucCommandName, pxEntry->ulCommandNameLength ) == 0 ) &&
+            ( ( pxEntry->ulComponentNameLength == 0 ) ||
+              ( memcmp( pxEntry->pucComponentName, pxRequest->pucComponentName, pxEntry->ulComponentNameLength ) == 0 ) ) )
+        {
+            return pxEntry;
+        }
+    }
+
+    return NULL;
+}
+/*-----------------------------------------------------------*/
+
+static void prvBenchmark( uint32_t ulCommandCount,
+                          uint32_t ulLookups )
+{
+    static CommandDispatcher_t xDispatcher;
+    AzureIoTHubClientCommandRequest_t xUnknown;
+    uint32_t ulStatus;
+    uint32_t ulLength;
+    uint32_t ulIndex;
+    uint32_t ulFound = 0;
+    uint64_t ullStart;
+    uint64_t ullRegisterNs;
+    uint64_t ullHashNs;
+    uint64_t ullLinearNs;
+
+    CommandDispatcher_Init( &xDispatcher );
+    xTickCount = 0;
+
+    ullStart = prvGetTimeNs();
+
+    for( ulIndex = 0; ulIndex < ulCommandCount; ulIndex++ )
+    {
+        unittestCHECK( CommandDispatcher_Register( &xDispatcher, xRequests[ ulIndex ].pucComponentName,
+                                                   xRequests[ ulIndex ].usComponentNameLength,
+                                                   xRequests[ ulIndex ].pucCommandName,
+                                                   xRequests[ ulIndex ].usCommandNameLength,
+                                                   prvHandler, ( void * ) ( uintptr_t ) ulIndex ) == eAzureIoTSuccess );
+    }
+
+    ullRegisterNs = prvGetTimeNs() - ullStart;
+
+    /* Every command reaches its own handler, and its latency is recorded. */
+    for( ulIndex = 0; ulIndex < ulCommandCount; ulIndex++ )
+    {
+        unittestCHECK( CommandDispatcher_Dispatch( &xDispatcher, &xRequests[ ulIndex ], NULL, 0,
+                                                   &ulStatus, &ulLength ) == eAzureIoTSuccess );
+        unittestCHECK( ulStatus == 200U + ulIndex );
+        unittestCHECK( CommandDispatcher_Find( &xDispatcher, xRequests[ ulIndex ].pucComponentName,
+                                               xRequests[ ulIndex ].usComponentNameLength,
+                                               xRequests[ ulIndex ].pucCommandName,
+                                               xRequests[ ulIndex ].usCommandNameLength )->ulMaxLatencyUs ==
+                       ( ulIndex % 3U ) * ( 1000000U / configTICK_RATE_HZ ) );
+    }
+
+    /* A command of another component, or not registered, is not found. */
+    xUnknown = xRequests[ 0 ];
+    xUnknown.pucComponentName = ( const uint8_t * ) pcComponents[ 1 ];
+    xUnknown.usComponentNameLength = ( uint16_t ) strlen( pcComponents[ 1 ] );
+    unittestCHECK( CommandDispatcher_Dispatch( &xDispatcher, &xUnknown, NULL, 0,
+                                               &ulStatus, &ulLength ) == eAzureIoTErrorItemNotFound );
+    xUnknown = xRequests[ commanddispatcherMAX_COMMANDS - 1 ];
+    unittestCHECK( ( ulCommandCount == commanddispatcherMAX_COMMANDS ) ||
+                   ( CommandDispatcher_Dispatch( &xDispatcher, &xUnknown, NULL, 0,
+                                                 &ulStatus, &ulLength ) == eAzureIoTErrorItemNotFound ) );
+
+    ullStart = prvGetTimeNs();
+
+    for( ulIndex = 0; ulIndex < ulLookups; ulIndex++ )
+    {
+        const AzureIoTHubClientCommandRequest_t * pxRequest = &xRequests[ ulIndex % ulCommandCount ];
+
+        ulFound += ( CommandDispatcher_Find( &xDispatcher, pxRequest->pucComponentName, pxRequest->usComponentNameLength,
+                                             pxRequest->pucCommandName, pxRequest->usCommandNameLength ) != NULL );
+    }
+
+    ullHashNs = prvGetTimeNs() - ullStart;
+    ullStart = prvGetTimeNs();
+
+    for( ulIndex = 0; ulIndex < ulLookups; ulIndex++ )
+    {
+        ulFound += ( prvLinearFind( &xDispatcher, &xRequests[ ulIndex % ulCommandCount ] ) != NULL );
+    }
+
+    ullLinearNs = prvGetTimeNs() - ullStart;
+    unittestCHECK( ulFound == 2U * ulLookups );
+
+    printf( "%8u %14.1f %14.1f %14.1f\n", ulCommandCount, ullRegisterNs / 1000.0 / ulCommandCount,
+            ( double ) ullHashNs / ulLookups, ( double ) ullLinearNs / ulLookups );
+}
+/*-----------------------------------------------------------*/
+
+int main( int argc,
+          char ** argv )
+{
+    static const uint32_t ulCommandCounts[] = { 8, 16, 32, commanddispatcherMAX_COMMANDS };
+    CommandDispatcher_t xFull;
+    uint32_t ulLookups = ( argc > 1 ) ? ( uint32_t ) strtoul( argv[ 1 ], NULL, 10 ) : 1000000U;
+    uint32_t ulIndex;
+    const char * pcComponent;
+
+    if( ulLookups == 0 )
+    {
+        fprintf( stderr, "Usage: %s [lookups]\n", argv[ 0 ] );
+
+        return 2;
+    }
+
+    for( ulIndex = 0; ulIndex < commanddispatcherMAX_COMMANDS; ulIndex++ )
+    {
+        pcComponent = pcComponents[ ulIndex % ( sizeof( pcComponents ) / sizeof( pcComponents[ 0 ] ) ) ];
+        ( void ) snprintf( cCommandNames[ ulIndex ], benchmarkNAME_LENGTH, "cmd%02u", ulIndex );
+        xRequests[ ulIndex ].pucComponentName = ( const uint8_t * ) pcComponent;
+        xRequests[ ulIndex ].usComponentNameLength = ( uint16_t ) ( ( pcComponent != NULL ) ? strlen( pcComponent ) : 0 );
+        xRequests[ ulIndex ].pucCommandName = ( const uint8_t * ) cCommandNames[ ulIndex ];
+        xRequests[ ulIndex ].usCommandNameLength = ( uint16_t ) strlen( cCommandNames[ ulIndex ] );
+    }
+
+    printf( "%8s %14s %14s %14s\n", "commands", "register (us)", "hash (ns)", "linear (ns)" );
+
+    for( ulIndex = 0; ulIndex < sizeof( ulCommandCounts ) / sizeof( ulCommandCounts[ 0 ] ); ulIndex++ )
+    {
+        prvBenchmark( ulCommandCounts[ ulIndex ], ulLookups );
+    }
+
+    /* A full table refuses one more command. */
+    CommandDispatcher_Init( &xFull );
+
+    for( ulIndex = 0; ulIndex < commanddispatcherMAX_COMMANDS; ulIndex++ )
+    {
+        ( void ) CommandDispatcher_Register( &xFull, NULL, 0, xRequests[ ulIndex ].pucCommandName,
+                                             xRequests[ ulIndex ].usCommandNameLength, prvHandler, NULL );
+    }
+
+    unittestCHECK( xFull.ulEntryCount == commanddispatcherMAX_COMMANDS );
+    unittestCHECK( CommandDispatcher_Register( &xFull, ( const uint8_t * ) "more", 4, ( const uint8_t * ) "cmd", 3,
+                                               prvHandler, NULL ) == eAzureIoTErrorOutOfMemory );
+
+    return UnitTest_Result();
+}
+/*-----------------------------------------------------------*/
@@ -0,0 +1,42 @@
+/* Copyright (c) Microsoft Corporation.
+ * Licensed under the MIT License. */
+
+/**
+ * @file FreeRTOS.h
+ * @brief Kernel definitions the utilities use, for their host unit tests.
+ *
+ * A failed configASSERT() aborts the test, and configRAND32() is the C
+ * library generator, so every run draws the same numbers.
+ */
+
+#ifndef INC_FREERTOS_H
+#define INC_FREERTOS_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+typedef long            BaseType_t;
+typedef unsigned long   UBaseType_t;
+typedef uint32_t        TickType_t;
+
+#define pdFALSE                     ( ( BaseType_t ) 0 )
+#define pdTRUE                      ( ( BaseType_t ) 1 )
+
+#define configTICK_RATE_HZ          ( ( TickType_t ) 1000 )
+#define pdMS_TO_TICKS( xTimeInMs )    ( ( TickType_t ) ( ( ( uint64_t ) ( xTimeInMs ) * configTICK_RATE_HZ ) / 1000U ) )
+#define pdTICKS_TO_MS( xTimeInTicks ) ( ( TickType_t ) ( ( ( uint64_t ) ( xTimeInTicks ) * 1000U ) / configTICK_RATE_HZ ) )
+
+#define configASSERT( x )                                                               \
+    do {                                                                                \
+        if( !( x ) )                                                                    \
+        {                                                                               \
+            fprintf( stderr, "%s:%d: configASSERT( %s ) failed\n", __FILE__, __LINE__, #x ); \
+            abort();                                                                    \
+        }                                                                               \
+    } while( 0 )
+
+#define configRAND32()              ( ( ( uint32_t ) rand() << 16 ) ^ ( uint32_t ) rand() )
+
+#endif /* INC_FREERTOS_H */
@@ -0,0 +1,80 @@
+/* Copyright (c) Microsoft Corporation.
+ * Licensed under the MIT License. */
+
+/**
+ * @file azure_iot_hub_client.h
+ * @brief IoT Hub client types and calls the utilities use, for their host unit tests.
+ *
+ * The middleware header pulls in the Azure SDK for C and coreMQTT, which the
+ * tests do not build. The fields used by the utilities keep their names, and
+ * a test that sends messages defines the send functions.
+ */
+
+#ifndef AZURE_IOT_HUB_CLIENT_H
+#define AZURE_IOT_HUB_CLIENT_H
+
+#include <stdint.h>
+
+#include "azure_iot_result.h"
+
+typedef struct AzureIoTHubClientComponent
+{
+    const uint8_t * pucComponentName;
+    uint32_t ulComponentNameLength;
+} AzureIoTHubClientComponent_t;
+
+typedef struct AzureIoTHubClient
+{
+    void * pvTestContext;
+
+    /* Components of the model, given in the client options by the middleware. */
+    const AzureIoTHubClientComponent_t * pxComponentList;
+    uint32_t ulComponentListLength;
+} AzureIoTHubClient_t;
+
+typedef struct AzureIoTMessageProperties
+{
+    void * pvTestContext;
+} AzureIoTMessageProperties_t;
+
+typedef enum AzureIoTHubMessageQoS
+{
+    eAzureIoTHubMessageQoS0 = 0,
+    eAzureIoTHubMessageQoS1
+} AzureIoTHubMessageQoS_t;
+
+typedef enum AzureIoTHubPropertiesMessageType
+{
+    eAzureIoTHubPropertiesRequestedMessage = 1,
+    eAzureIoTHubPropertiesReportedResponseMessage,
+    eAzureIoTHubPropertiesWritablePropertyMessage
+} AzureIoTHubPropertiesMessageType_t;
+
+typedef struct AzureIoTHubClientPropertiesResponse
+{
+    const void * pvMessagePayload;
+    uint32_t ulPayloadLength;
+    AzureIoTHubPropertiesMessageType_t xMessageType;
+    uint32_t ulRequestID;
+} AzureIoTHubClientPropertiesResponse_t;
+
+typedef struct AzureIoTHubClientCommandRequest
+{
+    const void * pvMessagePayload;
+    uint32_t ulPayloadLength;
+    const uint8_t * pucRequestID;
+    uint16_t usRequestIDLength;
+    const uint8_t * pucComponentName;
+    uint16_t usComponentNameLength;
+    const uint8_t * pucCommandName;
+    uint16_t usCommandNameLength;
+} AzureIoTHubClientCommandRequest_t;
+
+AzureIoTResult_t AzureIoTHubClient_SendTelemetry( AzureIoTHubClient_t * pxAzureIoTHubClient,
+                                                  const uint8_t * pucTelemetryData,
+                                                  uint32_t ulTelemetryDataLength,
+                                                  AzureIoTMessageProperties_t * pxProperties,
+                                                  AzureIoTHubMessageQoS_t xQOS,
+                                                  uint16_t * pusTelemetryPacketID );
+
+#endif /* AZURE_IOT_HUB_CLIENT_H */
@@ -0,0 +1,282 @@
+/* Copyright (c) Microsoft Corporation.
+ * Licensed under the MIT License. */
+
+#include "azure_iot_hub_client_properties.h"
+
+#include <stdbool.h>
+#include <stddef.h>
+
+/*-----------------------------------------------------------*/
+
+#define propertiesNAME( x )    ( const uint8_t * ) ( x ), ( sizeof( x ) - 1 )
+/*-----------------------------------------------------------*/
+
+static AzureIoTResult_t prvSkipPropertyAndValue( AzureIoTJSONReader_t * pxReader )
+{
+    AzureIoTResult_t xResult = AzureIoTJSONReader_SkipChildren( pxReader );
+
+    if( xResult == eAzureIoTSuccess )
+    {
+        xResult = AzureIoTJSONReader_NextToken( pxReader );
+    }
+
+    return xResult;
+}
+/*-----------------------------------------------------------*/
+
+/**
+ * @brief Move a reader at the start of a document to the first token of the section of properties.
+ */
+static AzureIoTResult_t prvEnterSection( AzureIoTJSONReader_t * pxReader,
+                                         AzureIoTHubPropertiesMessageType_t xResponseType,
+                                         AzureIoTHubClientPropertyType_t xPropertyType )
+{
+    AzureIoTResult_t xResult = AzureIoTJSONReader_NextToken( pxReader );
+
+    if( xResult == eAzureIoTSuccess )
+    {
+        xResult = AzureIoTJSONReader_NextToken( pxReader );
+    }
+
+    if( xResponseType != eAzureIoTHubPropertiesRequestedMessage )
+    {
+        return xResult;
+    }
+
+    while( ( xResult == eAzureIoTSuccess ) && ( pxReader->xTokenType == eAzureIoTJSONTokenPROPERTY_NAME ) )
+    {
+        if( ( xPropertyType == eAzureIoTHubClientPropertyWritable ) ?
+            AzureIoTJSONReader_TokenIsTextEqual( pxReader, propertiesNAME( "desired" ) ) :
+            AzureIoTJSONReader_TokenIsTextEqual( pxReader, propertiesNAME( "reported" ) ) )
+        {
+            if( ( xResult = AzureIoTJSONReader_NextToken( pxReader ) ) == eAzureIoTSuccess )
+            {
+                xResult = AzureIoTJSONReader_NextToken( pxReader );
+            }
+
+            return xResult;
+        }
+
+        xResult = prvSkipPropertyAndValue( pxReader );
+    }
+
+    return ( xResult == eAzureIoTSuccess ) ? eAzureIoTErrorItemNotFound : xResult;
+}
+/*-----------------------------------------------------------*/
+
+static bool prvIsComponent( const AzureIoTHubClient_t * pxAzureIoTHubClient,
+                            AzureIoTJSONReader_t * pxReader )
+{
+    uint32_t ulIndex;
+
+    for( ulIndex = 0; ulIndex < pxAzureIoTHubClient->ulComponentListLength; ulIndex++ )
+    {
+        if( AzureIoTJSONReader_TokenIsTextEqual( pxReader,
+                                                 pxAzureIoTHubClient->pxComponentList[ ulIndex ].pucComponentName,
+                                                 pxAzureIoTHubClient->pxComponentList[ ulIndex ].ulComponentNameLength ) )
+        {
+            return true;
+        }
+    }
+
+    return false;
+}
+/*-----------------------------------------------------------*/
+
+AzureIoTResult_t AzureIoTHubClientProperties_BuilderBeginComponent( AzureIoTHubClient_t * pxAzureIoTHubClient,
+                                                                    AzureIoTJSONWriter_t * pxJSONWriter,
+                                                                    const uint8_t * pucComponentName,
+                                                                    uint16_t usComponentNameLength )
+{
+    AzureIoTResult_t xResult = AzureIoTJSONWriter_AppendPropertyName( pxJSONWriter, pucComponentName, usComponentNameLength );
+
+    ( void ) pxAzureIoTHubClient;
+
+    if( xResult == eAzureIoTSuccess )
+    {
+        xResult = AzureIoTJSONWriter_AppendBeginObject( pxJSONWriter );
+    }
+
+    if( xResult == eAzureIoTSuccess )
+    {
+        xResult = AzureIoTJSONWriter_AppendPropertyName( pxJSONWriter, propertiesNAME( "__t" ) );
+    }
+
+    if( xResult == eAzureIoTSuccess )
+    {
+        xResult = AzureIoTJSONWriter_AppendString( pxJSONWriter, propertiesNAME( "c" ) );
+    }
+
+    return xResult;
+}
+/*-----------------------------------------------------------*/
+
+AzureIoTResult_t AzureIoTHubClientProperties_BuilderEndComponent( AzureIoTHubClient_t * pxAzureIoTHubClient,
+                                                                  AzureIoTJSONWriter_t * pxJSONWriter )
+{
+    ( void ) pxAzureIoTHubClient;
+
+    return AzureIoTJSONWriter_AppendEndObject( pxJSONWriter );
+}
+/*-----------------------------------------------------------*/
+
+AzureIoTResult_t AzureIoTHubClientProperties_BuilderBeginResponseStatus( AzureIoTHubClient_t * pxAzureIoTHubClient,
+                                                                         AzureIoTJSONWriter_t * pxJSONWriter,
+                                                                         const uint8_t * pucPropertyName,
+                                                                         uint16_t usPropertyNameLength,
+                                                                         int32_t lAckCode,
+                                                                         int32_t lAckVersion,
+                                                                         const uint8_t * pucAckDescription,
+                                                                         uint16_t usAckDescriptionLength )
+{
+    AzureIoTResult_t xResult = AzureIoTJSONWriter_AppendPropertyName( pxJSONWriter, pucPropertyName, usPropertyNameLength );
+
+    ( void ) pxAzureIoTHubClient;
+
+    if( xResult == eAzureIoTSuccess )
+    {
+        xResult = AzureIoTJSONWriter_AppendBeginObject( pxJSONWriter );
+    }
+
+    if( ( xResult == eAzureIoTSuccess ) &&
+        ( ( xResult = AzureIoTJSONWriter_AppendPropertyName( pxJSONWriter, propertiesNAME( "ac" ) ) ) == eAzureIoTSuccess ) )
+    {
+        xResult = AzureIoTJSONWriter_AppendInt32( pxJSONWriter, lAckCode );
+    }
+
+    if( ( xResult == eAzureIoTSuccess ) &&
+        ( ( xResult = AzureIoTJSONWriter_AppendPropertyName( pxJSONWriter, propertiesNAME( "av" ) ) ) == eAzureIoTSuccess ) )
+    {
+        xResult = AzureIoTJSONWriter_AppendInt32( pxJSONWriter, lAckVersion );
+    }
+
+    if( ( xResult == eAzureIoTSuccess ) && ( pucAckDescription != NULL ) &&
+        ( ( xResult = AzureIoTJSONWriter_AppendPropertyName( pxJSONWriter, propertiesNAME( "ad" ) ) ) == eAzureIoTSuccess ) )
+    {
+        xResult = AzureIoTJSONWriter_AppendString( pxJSONWriter, pucAckDescription, usAckDescriptionLength );
+    }
+
+    if( xResult == eAzureIoTSuccess )
+    {
+        xResult = AzureIoTJSONWriter_AppendPropertyName( pxJSONWriter, propertiesNAME( "value" ) );
+    }
+
+    return xResult;
+}
+/*-----------------------------------------------------------*/
+
+AzureIoTResult_t AzureIoTHubClientProperties_BuilderEndResponseStatus( AzureIoTHubClient_t * pxAzureIoTHubClient,
+                                                                       AzureIoTJSONWriter_t * pxJSONWriter )
+{
+    ( void ) pxAzureIoTHubClient;
+
+    return AzureIoTJSONWriter_AppendEndObject( pxJSONWriter );
+}
+/*-----------------------------------------------------------*/
+
+AzureIoTResult_t AzureIoTHubClientProperties_GetPropertiesVersion( AzureIoTHubClient_t * pxAzureIoTHubClient,
+                                                                   AzureIoTJSONReader_t * pxJSONReader,
+                                                                   AzureIoTHubPropertiesMessageType_t xResponseType,
+                                                                   uint32_t * ulVersion )
+{
+    AzureIoTResult_t xResult = prvEnterSection( pxJSONReader, xResponseType, eAzureIoTHubClientPropertyWritable );
+
+    ( void ) pxAzureIoTHubClient;
+
+    while( ( xResult == eAzureIoTSuccess ) && ( pxJSONReader->xTokenType == eAzureIoTJSONTokenPROPERTY_NAME ) )
+    {
+        if( AzureIoTJSONReader_TokenIsTextEqual( pxJSONReader, propertiesNAME( "$version" ) ) )
+        {
+            if( ( xResult = AzureIoTJSONReader_NextToken( pxJSONReader ) ) == eAzureIoTSuccess )
+            {
+                xResult = AzureIoTJSONReader_GetTokenUInt32( pxJSONReader, ulVersion );
+            }
+
+            return xResult;
+        }
+
+        xResult = prvSkipPropertyAndValue( pxJSONReader );
+    }
+
+    return ( xResult == eAzureIoTSuccess ) ? eAzureIoTErrorItemNotFound : xResult;
+}
+/*-----------------------------------------------------------*/
+
+AzureIoTResult_t AzureIoTHubClientProperties_GetNextComponentProperty( AzureIoTHubClient_t * pxAzureIoTHubClient,
+                                                                       AzureIoTJSONReader_t * pxJSONReader,
+                                                                       AzureIoTHubPropertiesMessageType_t xResponseType,
+                                                                       AzureIoTHubClientPropertyType_t xPropertyType,
+                                                                       const uint8_t ** ppucComponentName,
+                                                                       uint32_t * pulComponentNameLength )
+{
+    uint32_t ulSectionDepth = ( xResponseType == eAzureIoTHubPropertiesRequestedMessage ) ? 2U : 1U;
+    AzureIoTResult_t xResult = eAzureIoTSuccess;
+    const uint8_t * pucName;
+    uint32_t ulNameLength;
+
+    if( ( xResponseType == eAzureIoTHubPropertiesReportedResponseMessage ) ||
+        ( ( xResponseType == eAzureIoTHubPropertiesWritablePropertyMessage ) &&
+          ( xPropertyType != eAzureIoTHubClientPropertyWritable ) ) )
+    {
+        return eAzureIoTErrorInvalidArgument;
+    }
+
+    if( pxJSONReader->xTokenType == eAzureIoTJSONTokenNONE )
+    {
+        xResult = prvEnterSection( pxJSONReader, xResponseType, xPropertyType );
+        *ppucComponentName = NULL;
+        *pulComponentNameLength = 0;
+    }
+
+    while( xResult == eAzureIoTSuccess )
+    {
+        if( pxJSONReader->xTokenType != eAzureIoTJSONTokenPROPERTY_NAME )
+        {
+            /* The end of a component goes back to the root properties, the end of the section stops. */
+            if( ( pxJSONReader->xTokenType != eAzureIoTJSONTokenEND_OBJECT ) ||
+                ( pxJSONReader->ulDepth != ulSectionDepth ) )
+            {
+                return eAzureIoTErrorEndOfProperties;
+            }
+
+            *ppucComponentName = NULL;
+            *pulComponentNameLength = 0;
+            xResult = AzureIoTJSONReader_NextToken( pxJSONReader );
+        }
+        else if( ( ( pxJSONReader->ulDepth == ulSectionDepth ) &&
+                   AzureIoTJSONReader_TokenIsTextEqual( pxJSONReader, propertiesNAME( "$version" ) ) ) ||
+                 ( ( pxJSONReader->ulDepth > ulSectionDepth ) &&
+                   AzureIoTJSONReader_TokenIsTextEqual( pxJSONReader, propertiesNAME( "__t" ) ) ) )
+        {
+            xResult = prvSkipPropertyAndValue( pxJSONReader );
+        }
+        else if( ( pxJSONReader->ulDepth == ulSectionDepth ) && prvIsComponent( pxAzureIoTHubClient, pxJSONReader ) )
+        {
+            pucName = pxJSONReader->pucToken;
+            ulNameLength = pxJSONReader->ulTokenLength;
+
+            if( ( xResult = AzureIoTJSONReader_NextToken( pxJSONReader ) ) != eAzureIoTSuccess )
+            {
+                break;
+            }
+
+            if( pxJSONReader->xTokenType == eAzureIoTJSONTokenBEGIN_OBJECT )
+            {
+                *ppucComponentName = pucName;
+                *pulComponentNameLength = ulNameLength;
+                xResult = AzureIoTJSONReader_NextToken( pxJSONReader );
+            }
+            else
+            {
+                xResult = prvSkipPropertyAndValue( pxJSONReader );
+            }
+        }
+        else
+        {
+            return eAzureIoTSuccess;
+        }
+    }
+
+    return xResult;
+}
+/*-----------------------------------------------------------*/
@@ -0,0 +1,62 @@
+/* Copyright (c) Microsoft Corporation.
+ * Licensed under the MIT License. */
+
+/**
+ * @file azure_iot_hub_client_properties.h
+ * @brief Properties calls the utilities use, for their host unit tests and benchmarks.
+ *
+ * They follow the middleware: the components are those of the client,
+ * `$version` and the `__t` component markers are skipped, and the reader is
+ * left on the name of each property returned. The component name is only
+ * written when entering or leaving a component, so the caller keeps it
+ * between calls.
+ */
+
+#ifndef AZURE_IOT_HUB_CLIENT_PROPERTIES_H
+#define AZURE_IOT_HUB_CLIENT_PROPERTIES_H
+
+#include <stdint.h>
+
+#include "azure_iot_hub_client.h"
+#include "azure_iot_json_reader.h"
+#include "azure_iot_json_writer.h"
+
+typedef enum AzureIoTHubClientPropertyType
+{
+    eAzureIoTHubClientReportedFromDevice = 1,
+    eAzureIoTHubClientPropertyWritable = 2
+} AzureIoTHubClientPropertyType_t;
+
+AzureIoTResult_t AzureIoTHubClientProperties_BuilderBeginComponent( AzureIoTHubClient_t * pxAzureIoTHubClient,
+                                                                    AzureIoTJSONWriter_t * pxJSONWriter,
+                                                                    const uint8_t * pucComponentName,
+                                                                    uint16_t usComponentNameLength );
+
+AzureIoTResult_t AzureIoTHubClientProperties_BuilderEndComponent( AzureIoTHubClient_t * pxAzureIoTHubClient,
+                                                                  AzureIoTJSONWriter_t * pxJSONWriter );
+
+AzureIoTResult_t AzureIoTHubClientProperties_BuilderBeginResponseStatus( AzureIoTHubClient_t * pxAzureIoTHubClient,
+                                                                         AzureIoTJSONWriter_t * pxJSONWriter,
+                                                                         const uint8_t * pucPropertyName,
+                                                                         uint16_t usPropertyNameLength,
+                                                                         int32_t lAckCode,
+                                                                         int32_t lAckVersion,
+                                                                         const uint8_t * pucAckDescription,
+                                                                         uint16_t usAckDescriptionLength );
+
+AzureIoTResult_t AzureIoTHubClientProperties_BuilderEndResponseStatus( AzureIoTHubClient_t * pxAzureIoTHubClient,
+                                                                       AzureIoTJSONWriter_t * pxJSONWriter );
+
+AzureIoTResult_t AzureIoTHubClientProperties_GetPropertiesVersion( AzureIoTHubClient_t * pxAzureIoTHubClient,
+                                                                   AzureIoTJSONReader_t * pxJSONReader,
+                                                                   AzureIoTHubPropertiesMessageType_t xResponseType,
+                                                                   uint32_t * ulVersion );
+
+AzureIoTResult_t AzureIoTHubClientProperties_GetNextComponentProperty( AzureIoTHubClient_t * pxAzureIoTHubClient,
+                                                                       AzureIoTJSONReader_t * pxJSONReader,
+                                                                       AzureIoTHubPropertiesMessageType_t xResponseType,
+                                                                       AzureIoTHubClientPropertyType_t xPropertyType,
+                                                                       const uint8_t ** ppucComponentName,
+                                                                       uint32_t * pulComponentNameLength );
+
+#endif /* AZURE_IOT_HUB_CLIENT_PROPERTIES_H */
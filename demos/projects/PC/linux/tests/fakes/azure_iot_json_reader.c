@@ -0,0 +1,362 @@
+/* Copyright (c) Microsoft Corporation.
+ * Licensed under the MIT License. */
+
+#include "azure_iot_json_reader.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+/*-----------------------------------------------------------*/
+
+#define jsonreaderMAX_DEPTH          ( 64U )
+#define jsonreaderMAX_NUMBER_TEXT    ( 32U )
+/*-----------------------------------------------------------*/
+
+static bool prvIsWhitespaceOrSeparator( uint8_t ucChar )
+{
+    return ( ucChar == ' ' ) || ( ucChar == '\t' ) || ( ucChar == '\r' ) || ( ucChar == '\n' ) ||
+           ( ucChar == ',' ) || ( ucChar == ':' );
+}
+/*-----------------------------------------------------------*/
+
+static bool prvIsNumberChar( uint8_t ucChar )
+{
+    return ( ( ucChar >= '0' ) && ( ucChar <= '9' ) ) || ( ucChar == '-' ) || ( ucChar == '+' ) ||
+           ( ucChar == '.' ) || ( ucChar == 'e' ) || ( ucChar == 'E' );
+}
+/*-----------------------------------------------------------*/
+
+static bool prvInObject( const AzureIoTJSONReader_t * pxReader )
+{
+    return ( pxReader->ulDepth > 0 ) && ( ( pxReader->ullObjectBits >> ( pxReader->ulDepth - 1 ) ) & 1U );
+}
+/*-----------------------------------------------------------*/
+
+static AzureIoTResult_t prvReadLiteral( AzureIoTJSONReader_t * pxReader,
+                                        const char * pcLiteral,
+                                        AzureIoTJSONTokenType_t xTokenType )
+{
+    uint32_t ulLength = ( uint32_t ) strlen( pcLiteral );
+
+    if( ( ( pxReader->ulBufferLength - pxReader->ulPosition ) < ulLength ) ||
+        ( memcmp( pxReader->pucBuffer + pxReader->ulPosition, pcLiteral, ulLength ) != 0 ) )
+    {
+        return eAzureIoTErrorUnexpectedChar;
+    }
+
+    pxReader->xTokenType = xTokenType;
+    pxReader->pucToken = pxReader->pucBuffer + pxReader->ulPosition;
+    pxReader->ulTokenLength = ulLength;
+    pxReader->ulPosition += ulLength;
+
+    return eAzureIoTSuccess;
+}
+/*-----------------------------------------------------------*/
+
+/**
+ * @brief Copy a number token and NULL terminate it, for strtod() and friends.
+ */
+static bool prvNumberText( const AzureIoTJSONReader_t * pxReader,
+                           char * pcText )
+{
+    if( ( pxReader->xTokenType != eAzureIoTJSONTokenNUMBER ) ||
+        ( pxReader->ulTokenLength >= jsonreaderMAX_NUMBER_TEXT ) )
+    {
+        return false;
+    }
+
+    memcpy( pcText, pxReader->pucToken, pxReader->ulTokenLength );
+    pcText[ pxReader->ulTokenLength ] = '\0';
+
+    return true;
+}
+/*-----------------------------------------------------------*/
+
+AzureIoTResult_t AzureIoTJSONReader_Init( AzureIoTJSONReader_t * pxReader,
+                                          const uint8_t * pucBuffer,
+                                          uint32_t ulBufferSize )
+{
+    if( ( pxReader == NULL ) || ( pucBuffer == NULL ) )
+    {
+        return eAzureIoTErrorInvalidArgument;
+    }
+
+    memset( pxReader, 0, sizeof( *pxReader ) );
+    pxReader->pucBuffer = pucBuffer;
+    pxReader->ulBufferLength = ulBufferSize;
+
+    return eAzureIoTSuccess;
+}
+/*-----------------------------------------------------------*/
+
+AzureIoTResult_t AzureIoTJSONReader_NextToken( AzureIoTJSONReader_t * pxReader )
+{
+    const uint8_t * pucBuffer = pxReader->pucBuffer;
+    uint32_t ulStart;
+    uint8_t ucChar;
+
+    while( ( pxReader->ulPosition < pxReader->ulBufferLength ) &&
+           prvIsWhitespaceOrSeparator( pucBuffer[ pxReader->ulPosition ] ) )
+    {
+        pxReader->ulPosition++;
+    }
+
+    if( pxReader->ulPosition == pxReader->ulBufferLength )
+    {
+        return eAzureIoTErrorFailed;
+    }
+
+    ulStart = pxReader->ulPosition;
+    ucChar = pucBuffer[ ulStart ];
+
+    switch( ucChar )
+    {
+        case '{':
+        case '[':
+
+            if( pxReader->ulDepth == jsonreaderMAX_DEPTH )
+            {
+                return eAzureIoTErrorUnexpectedChar;
+            }
+
+            pxReader->ullObjectBits &= ~( 1ULL << pxReader->ulDepth );
+            pxReader->ullObjectBits |= ( uint64_t ) ( ucChar == '{' ) << pxReader->ulDepth;
+            pxReader->ulDepth++;
+            pxReader->xTokenType = ( ucChar == '{' ) ? eAzureIoTJSONTokenBEGIN_OBJECT : eAzureIoTJSONTokenBEGIN_ARRAY;
+            break;
+
+        case '}':
+        case ']':
+
+            if( ( pxReader->ulDepth == 0 ) || ( prvInObject( pxReader ) != ( ucChar == '}' ) ) )
+            {
+                return eAzureIoTErrorUnexpectedChar;
+            }
+
+            pxReader->ulDepth--;
+            pxReader->xTokenType = ( ucChar == '}' ) ? eAzureIoTJSONTokenEND_OBJECT : eAzureIoTJSONTokenEND_ARRAY;
+            break;
+
+        case '"':
+
+            for( pxReader->ulPosition++; pxReader->ulPosition < pxReader->ulBufferLength; pxReader->ulPosition++ )
+            {
+                if( pucBuffer[ pxReader->ulPosition ] == '\\' )
+                {
+                    pxReader->ulPosition++;
+                }
+                else if( pucBuffer[ pxReader->ulPosition ] == '"' )
+                {
+                    break;
+                }
+            }
+
+            if( pxReader->ulPosition >= pxReader->ulBufferLength )
+            {
+                return eAzureIoTErrorUnexpectedChar;
+            }
+
+            /* In an object, a string is a name unless it follows one. */
+            pxReader->xTokenType = ( prvInObject( pxReader ) &&
+                                     ( pxReader->xTokenType != eAzureIoTJSONTokenPROPERTY_NAME ) ) ?
+                                   eAzureIoTJSONTokenPROPERTY_NAME : eAzureIoTJSONTokenSTRING;
+            pxReader->pucToken = pucBuffer + ulStart + 1;
+            pxReader->ulTokenLength = pxReader->ulPosition - ulStart - 1;
+            pxReader->ulPosition++;
+
+            return eAzureIoTSuccess;
+
+        case 't':
+            return prvReadLiteral( pxReader, "true", eAzureIoTJSONTokenTRUE );
+
+        case 'f':
+            return prvReadLiteral( pxReader, "false", eAzureIoTJSONTokenFALSE );
+
+        case 'n':
+            return prvReadLiteral( pxReader, "null", eAzureIoTJSONTokenNULL );
+
+        default:
+
+            if( !prvIsNumberChar( ucChar ) )
+            {
+                return eAzureIoTErrorUnexpectedChar;
+            }
+
+            while( ( pxReader->ulPosition < pxReader->ulBufferLength ) &&
+                   prvIsNumberChar( pucBuffer[ pxReader->ulPosition ] ) )
+            {
+                pxReader->ulPosition++;
+            }
+
+            pxReader->xTokenType = eAzureIoTJSONTokenNUMBER;
+            pxReader->pucToken = pucBuffer + ulStart;
+            pxReader->ulTokenLength = pxReader->ulPosition - ulStart;
+
+            return eAzureIoTSuccess;
+    }
+
+    pxReader->pucToken = pucBuffer + ulStart;
+    pxReader->ulTokenLength = 1;
+    pxReader->ulPosition++;
+
+    return eAzureIoTSuccess;
+}
+/*-----------------------------------------------------------*/
+
+AzureIoTResult_t AzureIoTJSONReader_SkipChildren( AzureIoTJSONReader_t * pxReader )
+{
+    AzureIoTResult_t xResult = eAzureIoTSuccess;
+    uint32_t ulDepth;
+
+    if( pxReader->xTokenType == eAzureIoTJSONTokenPROPERTY_NAME )
+    {
+        xResult = AzureIoTJSONReader_NextToken( pxReader );
+    }
+
+    if( ( xResult == eAzureIoTSuccess ) &&
+        ( ( pxReader->xTokenType == eAzureIoTJSONTokenBEGIN_OBJECT ) ||
+          ( pxReader->xTokenType == eAzureIoTJSONTokenBEGIN_ARRAY ) ) )
+    {
+        ulDepth = pxReader->ulDepth - 1;
+
+        do
+        {
+            xResult = AzureIoTJSONReader_NextToken( pxReader );
+        } while( ( xResult == eAzureIoTSuccess ) && ( pxReader->ulDepth > ulDepth ) );
+    }
+
+    return xResult;
+}
+/*-----------------------------------------------------------*/
+
+AzureIoTResult_t AzureIoTJSONReader_GetTokenBool( AzureIoTJSONReader_t * pxReader,
+                                                  bool * pxValue )
+{
+    if( ( pxReader->xTokenType != eAzureIoTJSONTokenTRUE ) && ( pxReader->xTokenType != eAzureIoTJSONTokenFALSE ) )
+    {
+        return eAzureIoTErrorUnexpectedChar;
+    }
+
+    *pxValue = ( pxReader->xTokenType == eAzureIoTJSONTokenTRUE );
+
+    return eAzureIoTSuccess;
+}
+/*-----------------------------------------------------------*/
+
+AzureIoTResult_t AzureIoTJSONReader_GetTokenInt32( AzureIoTJSONReader_t * pxReader,
+                                                   int32_t * plValue )
+{
+    char cText[ jsonreaderMAX_NUMBER_TEXT ];
+    char * pcEnd;
+    long long llValue;
+
+    if( !prvNumberText( pxReader, cText ) )
+    {
+        return eAzureIoTErrorUnexpectedChar;
+    }
+
+    llValue = strtoll( cText, &pcEnd, 10 );
+
+    if( ( *pcEnd != '\0' ) || ( llValue < INT32_MIN ) || ( llValue > INT32_MAX ) )
+    {
+        return eAzureIoTErrorUnexpectedChar;
+    }
+
+    *plValue = ( int32_t ) llValue;
+
+    return eAzureIoTSuccess;
+}
+/*-----------------------------------------------------------*/
+
+AzureIoTResult_t AzureIoTJSONReader_GetTokenUInt32( AzureIoTJSONReader_t * pxReader,
+                                                    uint32_t * pulValue )
+{
+    char cText[ jsonreaderMAX_NUMBER_TEXT ];
+    char * pcEnd;
+    unsigned long long ullValue;
+
+    if( !prvNumberText( pxReader, cText ) || ( cText[ 0 ] == '-' ) )
+    {
+        return eAzureIoTErrorUnexpectedChar;
+    }
+
+    ullValue = strtoull( cText, &pcEnd, 10 );
+
+    if( ( *pcEnd != '\0' ) || ( ullValue > UINT32_MAX ) )
+    {
+        return eAzureIoTErrorUnexpectedChar;
+    }
+
+    *pulValue = ( uint32_t ) ullValue;
+
+    return eAzureIoTSuccess;
+}
+/*-----------------------------------------------------------*/
+
+AzureIoTResult_t AzureIoTJSONReader_GetTokenDouble( AzureIoTJSONReader_t * pxReader,
+                                                    double * pxValue )
+{
+    char cText[ jsonreaderMAX_NUMBER_TEXT ];
+    char * pcEnd;
+    double xValue;
+
+    if( !prvNumberText( pxReader, cText ) )
+    {
+        return eAzureIoTErrorUnexpectedChar;
+    }
+
+    xValue = strtod( cText, &pcEnd );
+
+    if( *pcEnd != '\0' )
+    {
+        return eAzureIoTErrorUnexpectedChar;
+    }
+
+    *pxValue = xValue;
+
+    return eAzureIoTSuccess;
+}
+/*-----------------------------------------------------------*/
+
+AzureIoTResult_t AzureIoTJSONReader_GetTokenString( AzureIoTJSONReader_t * pxReader,
+                                                    uint8_t * pucBuffer,
+                                                    uint32_t ulBufferSize,
+                                                    uint32_t * pusBytesCopied )
+{
+    if( ( pxReader->xTokenType != eAzureIoTJSONTokenSTRING ) &&
+        ( pxReader->xTokenType != eAzureIoTJSONTokenPROPERTY_NAME ) )
+    {
+        return eAzureIoTErrorUnexpectedChar;
+    }
+
+    if( pxReader->ulTokenLength > ulBufferSize )
+    {
+        return eAzureIoTErrorOutOfMemory;
+    }
+
+    memcpy( pucBuffer, pxReader->pucToken, pxReader->ulTokenLength );
+    *pusBytesCopied = pxReader->ulTokenLength;
+
+    return eAzureIoTSuccess;
+}
+/*-----------------------------------------------------------*/
+
+bool AzureIoTJSONReader_TokenIsTextEqual( AzureIoTJSONReader_t * pxReader,
+                                          const uint8_t * pucExpectedText,
+                                          uint32_t ulExpectedTextLength )
+{
+    return ( ( pxReader->xTokenType == eAzureIoTJSONTokenSTRING ) ||
+             ( pxReader->xTokenType == eAzureIoTJSONTokenPROPERTY_NAME ) ) &&
+           ( pxReader->ulTokenLength == ulExpectedTextLength ) &&
+           ( memcmp( pxReader->pucToken, pucExpectedText, ulExpectedTextLength ) == 0 );
+}
+/*-----------------------------------------------------------*/
+
+AzureIoTResult_t AzureIoTJSONReader_TokenType( AzureIoTJSONReader_t * pxReader,
+                                               AzureIoTJSONTokenType_t * pxTokenType )
+{
+    *pxTokenType = pxReader->xTokenType;
+
+    return eAzureIoTSuccess;
+}
+/*-----------------------------------------------------------*/
@@ -0,0 +1,81 @@
+/* Copyright (c) Microsoft Corporation.
+ * Licensed under the MIT License. */
+
+/**
+ * @file azure_iot_json_reader.h
+ * @brief JSON reader calls the utilities use, for their host unit tests and benchmarks.
+ *
+ * A small tokenizer behind the middleware API, in place of the reader of the
+ * Azure SDK for C. It expects well formed documents: separators are skipped
+ * rather than checked, and strings are compared and copied as written,
+ * without decoding escapes.
+ */
+
+#ifndef AZURE_IOT_JSON_READER_H
+#define AZURE_IOT_JSON_READER_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "azure_iot_result.h"
+
+typedef enum AzureIoTJSONTokenType
+{
+    eAzureIoTJSONTokenNONE = 0,
+    eAzureIoTJSONTokenBEGIN_OBJECT,
+    eAzureIoTJSONTokenEND_OBJECT,
+    eAzureIoTJSONTokenBEGIN_ARRAY,
+    eAzureIoTJSONTokenEND_ARRAY,
+    eAzureIoTJSONTokenPROPERTY_NAME,
+    eAzureIoTJSONTokenSTRING,
+    eAzureIoTJSONTokenNUMBER,
+    eAzureIoTJSONTokenTRUE,
+    eAzureIoTJSONTokenFALSE,
+    eAzureIoTJSONTokenNULL
+} AzureIoTJSONTokenType_t;
+
+typedef struct AzureIoTJSONReader
+{
+    const uint8_t * pucBuffer;
+    uint32_t ulBufferLength;
+    uint32_t ulPosition;        /* Offset after the current token. */
+    AzureIoTJSONTokenType_t xTokenType;
+    const uint8_t * pucToken;   /* Text of the current token, without the quotes of strings. */
+    uint32_t ulTokenLength;
+    uint64_t ullObjectBits;     /* Bit i is set if the container at depth i + 1 is an object. */
+    uint32_t ulDepth;           /* Number of containers open, the current one included. */
+} AzureIoTJSONReader_t;
+
+AzureIoTResult_t AzureIoTJSONReader_Init( AzureIoTJSONReader_t * pxReader,
+                                          const uint8_t * pucBuffer,
+                                          uint32_t ulBufferSize );
+
+AzureIoTResult_t AzureIoTJSONReader_NextToken( AzureIoTJSONReader_t * pxReader );
+
+AzureIoTResult_t AzureIoTJSONReader_SkipChildren( AzureIoTJSONReader_t * pxReader );
+
+AzureIoTResult_t AzureIoTJSONReader_GetTokenBool( AzureIoTJSONReader_t * pxReader,
+                                                  bool * pxValue );
+
+AzureIoTResult_t AzureIoTJSONReader_GetTokenInt32( AzureIoTJSONReader_t * pxReader,
+                                                   int32_t * plValue );
+
+AzureIoTResult_t AzureIoTJSONReader_GetTokenUInt32( AzureIoTJSONReader_t * pxReader,
+                                                    uint32_t * pulValue );
+
+AzureIoTResult_t AzureIoTJSONReader_GetTokenDouble( AzureIoTJSONReader_t * pxReader,
+                                                    double * pxValue );
+
+AzureIoTResult_t AzureIoTJSONReader_GetTokenString( AzureIoTJSONReader_t * pxReader,
+                                                    uint8_t * pucBuffer,
+                                                    uint32_t ulBufferSize,
+                                                    uint32_t * pusBytesCopied );
+
+bool AzureIoTJSONReader_TokenIsTextEqual( AzureIoTJSONReader_t * pxReader,
+                                          const uint8_t * pucExpectedText,
+                                          uint32_t ulExpectedTextLength );
+
+AzureIoTResult_t AzureIoTJSONReader_TokenType( AzureIoTJSONReader_t * pxReader,
+                                               AzureIoTJSONTokenType_t * pxTokenType );
+
+#endif /* AZURE_IOT_JSON_READER_H */
@@ -0,0 +1,172 @@
+/* Copyright (c) Microsoft Corporation.
+ * Licensed under the MIT License. */
+
+#include "azure_iot_json_writer.h"
+
+#include <stdio.h>
+#include <string.h>
+
+/*-----------------------------------------------------------*/
+
+/**
+ * @brief Append text, after a comma if a value precedes it at the same level.
+ */
+static AzureIoTResult_t prvAppend( AzureIoTJSONWriter_t * pxWriter,
+                                   bool xIsValue,
+                                   const char * pcPrefix,
+                                   const uint8_t * pucText,
+                                   uint32_t ulTextLength,
+                                   const char * pcSuffix )
+{
+    uint32_t ulPrefixLength = ( uint32_t ) strlen( pcPrefix );
+    uint32_t ulSuffixLength = ( uint32_t ) strlen( pcSuffix );
+    uint32_t ulComma = ( xIsValue && pxWriter->xNeedsComma ) ? 1U : 0U;
+
+    if( ( pxWriter->ulBufferSize - pxWriter->ulBytesUsed ) < ulComma + ulPrefixLength + ulTextLength + ulSuffixLength )
+    {
+        return eAzureIoTErrorOutOfMemory;
+    }
+
+    if( ulComma > 0 )
+    {
+        pxWriter->pucBuffer[ pxWriter->ulBytesUsed++ ] = ',';
+    }
+
+    memcpy( pxWriter->pucBuffer + pxWriter->ulBytesUsed, pcPrefix, ulPrefixLength );
+    pxWriter->ulBytesUsed += ulPrefixLength;
+
+    if( ulTextLength > 0 )
+    {
+        memcpy( pxWriter->pucBuffer + pxWriter->ulBytesUsed, pucText, ulTextLength );
+        pxWriter->ulBytesUsed += ulTextLength;
+    }
+
+    memcpy( pxWriter->pucBuffer + pxWriter->ulBytesUsed, pcSuffix, ulSuffixLength );
+    pxWriter->ulBytesUsed += ulSuffixLength;
+
+    return eAzureIoTSuccess;
+}
+/*-----------------------------------------------------------*/
+
+static AzureIoTResult_t prvAppendValue( AzureIoTJSONWriter_t * pxWriter,
+                                        const char * pcText )
+{
+    AzureIoTResult_t xResult = prvAppend( pxWriter, true, "", ( const uint8_t * ) pcText, ( uint32_t ) strlen( pcText ), "" );
+
+    if( xResult == eAzureIoTSuccess )
+    {
+        pxWriter->xNeedsComma = true;
+    }
+
+    return xResult;
+}
+/*-----------------------------------------------------------*/
+
+AzureIoTResult_t AzureIoTJSONWriter_Init( AzureIoTJSONWriter_t * pxWriter,
+                                          uint8_t * pucBuffer,
+                                          uint32_t ulBufferSize )
+{
+    if( ( pxWriter == NULL ) || ( pucBuffer == NULL ) )
+    {
+        return eAzureIoTErrorInvalidArgument;
+    }
+
+    memset( pxWriter, 0, sizeof( *pxWriter ) );
+    pxWriter->pucBuffer = pucBuffer;
+    pxWriter->ulBufferSize = ulBufferSize;
+
+    return eAzureIoTSuccess;
+}
+/*-----------------------------------------------------------*/
+
+int32_t AzureIoTJSONWriter_GetBytesUsed( AzureIoTJSONWriter_t * pxWriter )
+{
+    return ( int32_t ) pxWriter->ulBytesUsed;
+}
+/*-----------------------------------------------------------*/
+
+AzureIoTResult_t AzureIoTJSONWriter_AppendBeginObject( AzureIoTJSONWriter_t * pxWriter )
+{
+    AzureIoTResult_t xResult = prvAppend( pxWriter, true, "{", NULL, 0, "" );
+
+    if( xResult == eAzureIoTSuccess )
+    {
+        pxWriter->xNeedsComma = false;
+    }
+
+    return xResult;
+}
+/*-----------------------------------------------------------*/
+
+AzureIoTResult_t AzureIoTJSONWriter_AppendEndObject( AzureIoTJSONWriter_t * pxWriter )
+{
+    AzureIoTResult_t xResult = prvAppend( pxWriter, false, "}", NULL, 0, "" );
+
+    if( xResult == eAzureIoTSuccess )
+    {
+        pxWriter->xNeedsComma = true;
+    }
+
+    return xResult;
+}
+/*-----------------------------------------------------------*/
+
+AzureIoTResult_t AzureIoTJSONWriter_AppendPropertyName( AzureIoTJSONWriter_t * pxWriter,
+                                                        const uint8_t * pucPropertyName,
+                                                        uint32_t ulPropertyNameLength )
+{
+    AzureIoTResult_t xResult = prvAppend( pxWriter, true, "\"", pucPropertyName, ulPropertyNameLength, "\":" );
+
+    if( xResult == eAzureIoTSuccess )
+    {
+        pxWriter->xNeedsComma = false;
+    }
+
+    return xResult;
+}
+/*-----------------------------------------------------------*/
+
+AzureIoTResult_t AzureIoTJSONWriter_AppendString( AzureIoTJSONWriter_t * pxWriter,
+                                                  const uint8_t * pucValue,
+                                                  uint32_t ulValueLength )
+{
+    AzureIoTResult_t xResult = prvAppend( pxWriter, true, "\"", pucValue, ulValueLength, "\"" );
+
+    if( xResult == eAzureIoTSuccess )
+    {
+        pxWriter->xNeedsComma = true;
+    }
+
+    return xResult;
+}
+/*-----------------------------------------------------------*/
+
+AzureIoTResult_t AzureIoTJSONWriter_AppendInt32( AzureIoTJSONWriter_t * pxWriter,
+                                                 int32_t lValue )
+{
+    char cText[ 12 ];
+
+    ( void ) snprintf( cText, sizeof( cText ), "%ld", ( long ) lValue );
+
+    return prvAppendValue( pxWriter, cText );
+}
+/*-----------------------------------------------------------*/
+
+AzureIoTResult_t AzureIoTJSONWriter_AppendDouble( AzureIoTJSONWriter_t * pxWriter,
+                                                  double xValue,
+                                                  uint16_t usFractionalDigits )
+{
+    char cText[ 48 ];
+
+    ( void ) snprintf( cText, sizeof( cText ), "%.*f", ( int ) usFractionalDigits, xValue );
+
+    return prvAppendValue( pxWriter, cText );
+}
+/*-----------------------------------------------------------*/
+
+AzureIoTResult_t AzureIoTJSONWriter_AppendBool( AzureIoTJSONWriter_t * pxWriter,
+                                                bool xValue )
+{
+    return prvAppendValue( pxWriter, xValue ? "true" : "false" );
+}
+/*-----------------------------------------------------------*/
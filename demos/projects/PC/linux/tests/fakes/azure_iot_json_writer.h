@@ -0,0 +1,56 @@
+/* Copyright (c) Microsoft Corporation.
+ * Licensed under the MIT License. */
+
+/**
+ * @file azure_iot_json_writer.h
+ * @brief JSON writer calls the utilities use, for their host unit tests and benchmarks.
+ *
+ * Writes compact JSON behind the middleware API, in place of the writer of
+ * the Azure SDK for C. Strings are written as given, without escaping.
+ */
+
+#ifndef AZURE_IOT_JSON_WRITER_H
+#define AZURE_IOT_JSON_WRITER_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "azure_iot_result.h"
+
+typedef struct AzureIoTJSONWriter
+{
+    uint8_t * pucBuffer;
+    uint32_t ulBufferSize;
+    uint32_t ulBytesUsed;
+    bool xNeedsComma; /* A value was written at the current level. */
+} AzureIoTJSONWriter_t;
+
+AzureIoTResult_t AzureIoTJSONWriter_Init( AzureIoTJSONWriter_t * pxWriter,
+                                          uint8_t * pucBuffer,
+                                          uint32_t ulBufferSize );
+
+int32_t AzureIoTJSONWriter_GetBytesUsed( AzureIoTJSONWriter_t * pxWriter );
+
+AzureIoTResult_t AzureIoTJSONWriter_AppendBeginObject( AzureIoTJSONWriter_t * pxWriter );
+
+AzureIoTResult_t AzureIoTJSONWriter_AppendEndObject( AzureIoTJSONWriter_t * pxWriter );
+
+AzureIoTResult_t AzureIoTJSONWriter_AppendPropertyName( AzureIoTJSONWriter_t * pxWriter,
+                                                        const uint8_t * pucPropertyName,
+                                                        uint32_t ulPropertyNameLength );
+
+AzureIoTResult_t AzureIoTJSONWriter_AppendString( AzureIoTJSONWriter_t * pxWriter,
+                                                  const uint8_t * pucValue,
+                                                  uint32_t ulValueLength );
+
+AzureIoTResult_t AzureIoTJSONWriter_AppendInt32( AzureIoTJSONWriter_t * pxWriter,
+                                                 int32_t lValue );
+
+AzureIoTResult_t AzureIoTJSONWriter_AppendDouble( AzureIoTJSONWriter_t * pxWriter,
+                                                  double xValue,
+                                                  uint16_t usFractionalDigits );
+
+AzureIoTResult_t AzureIoTJSONWriter_AppendBool( AzureIoTJSONWriter_t * pxWriter,
+                                                bool xValue );
+
+#endif /* AZURE_IOT_JSON_WRITER_H */
@@ -0,0 +1,19 @@
+/* Copyright (c) Microsoft Corporation.
+ * Licensed under the MIT License. */
+
+/**
+ * @file demo_config.h
+ * @brief Demo configuration the utilities use, for their host unit tests.
+ *
+ * Logging is compiled out, so the tests only print their failed checks.
+ */
+
+#ifndef DEMO_CONFIG_H
+#define DEMO_CONFIG_H
+
+#define LogError( message )
+#define LogWarn( message )
+#define LogInfo( message )
+#define LogDebug( message )
+
+#endif /* DEMO_CONFIG_H */
@@ -0,0 +1,20 @@
+/* Copyright (c) Microsoft Corporation.
+ * Licensed under the MIT License. */
+
+/**
+ * @file task.h
+ * @brief Task functions the utilities use, for their host unit tests.
+ *
+ * A test that needs them defines them, to control the time the utilities see.
+ */
+
+#ifndef INC_TASK_H
+#define INC_TASK_H
+
+#include "FreeRTOS.h"
+
+TickType_t xTaskGetTickCount( void );
+
+void vTaskDelay( TickType_t xTicksToDelay );
+
+#endif /* INC_TASK_H */
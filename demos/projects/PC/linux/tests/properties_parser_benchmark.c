@@ -0,0 +1,337 @@
+/* Copyright (c) Microsoft Corporation.
+ * Licensed under the MIT License. */
+
+/**
+ * @file properties_parser_benchmark.c
+ * @brief Parse throughput of the single pass properties parser, against two passes.
+ *
+ * Generates twin documents from 16 to 1024 writable properties, spread over
+ * the root interface and three components, both as GET responses holding
+ * reported properties after the desired ones, and as writable property
+ * patches. Each is parsed as the samples did before, reading `$version`
+ * with AzureIoTHubClientProperties_GetPropertiesVersion() and then walking
+ * the properties again with AzureIoTHubClientProperties_GetNextComponentProperty(),
+ * and with PropertiesParser_Parse(). Both must find the same version,
+ * properties and values. The JSON reader is the tokenizer of the test fakes,
+ * so the times compare the number of scans rather than the SDK reader.
+ *
+ * Usage: properties_parser_benchmark [documents]
+ */
+
+#include <stdbool.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "properties_parser.h"
+
+#include "FreeRTOS.h"
+
+#include "unit_test.h"
+
+/*-----------------------------------------------------------*/
+
+#define benchmarkDOCUMENT_SIZE    ( 128U * 1024U )
+#define benchmarkVERSION          ( 4242U )
+
+static const AzureIoTHubClientComponent_t xClientComponents[] =
+{
+    { ( const uint8_t * ) "thermostat1",       sizeof( "thermostat1" ) - 1       },
+    { ( const uint8_t * ) "thermostat2",       sizeof( "thermostat2" ) - 1       },
+    { ( const uint8_t * ) "deviceInformation", sizeof( "deviceInformation" ) - 1 }
+};
+
+static const PropertiesParserComponent_t xParserComponents[] =
+{
+    { ( const uint8_t * ) "thermostat1",       sizeof( "thermostat1" ) - 1       },
+    { ( const uint8_t * ) "thermostat2",       sizeof( "thermostat2" ) - 1       },
+    { ( const uint8_t * ) "deviceInformation", sizeof( "deviceInformation" ) - 1 }
+};
+
+#define benchmarkCOMPONENT_COUNT    ( sizeof( xClientComponents ) / sizeof( xClientComponents[ 0 ] ) )
+
+static char cDocument[ benchmarkDOCUMENT_SIZE ];
+static AzureIoTHubClient_t xClient;
+
+/**
+ * @brief What a parse found, to compare the two ways.
+ */
+typedef struct BenchmarkTally
+{
+    uint32_t ulProperties;
+    uint32_t ulComponentProperties;
+    double xSum; /* Of the numeric values. */
+} BenchmarkTally_t;
+/*-----------------------------------------------------------*/
+
+static uint64_t prvGetTimeNs( void )
+{
+    struct timespec xNow;
+
+    ( void ) clock_gettime( CLOCK_MONOTONIC, &xNow );
+
+    return ( ( uint64_t ) xNow.tv_sec * 1000000000U ) + ( uint64_t ) xNow.tv_nsec;
+}
+/*-----------------------------------------------------------*/
+
+/**
+ * @brief Append the properties of one section, numbers, strings and objects, then its `$version`.
+ */
+static uint32_t prvWriteSection( uint32_t ulLength,
+                                 uint32_t ulPropertyCount,
+                                 const char * pcPrefix )
+{
+    uint32_t ulComponent;
+    uint32_t ulIndex;
+    uint32_t ulWritten;
+
+    ulLength += ( uint32_t ) snprintf( cDocument + ulLength, benchmarkDOCUMENT_SIZE - ulLength, "{" );
+
+    /* Root properties first, then a quarter of them in each component. */
+    for( ulComponent = 0; ulComponent <= benchmarkCOMPONENT_COUNT; ulComponent++ )
+    {
+        if( ulComponent > 0 )
+        {
+            ulLength += ( uint32_t ) snprintf( cDocument + ulLength, benchmarkDOCUMENT_SIZE - ulLength,
+                                               "\"%.*s\":{\"__t\":\"c\",",
+                                               ( int ) xClientComponents[ ulComponent - 1 ].ulComponentNameLength,
+                                               xClientComponents[ ulComponent - 1 ].pucComponentName );
+        }
+
+        for( ulIndex = ulComponent; ulIndex < ulPropertyCount; ulIndex += benchmarkCOMPONENT_COUNT + 1 )
+        {
+            switch( ulIndex % 3 )
+            {
+                case 0:
+                    ulWritten = ( uint32_t ) snprintf( cDocument + ulLength, benchmarkDOCUMENT_SIZE - ulLength,
+                                                       "\"%s%u\":%u.25,", pcPrefix, ulIndex, ulIndex );
+                    break;
+
+                case 1:
+                    ulWritten = ( uint32_t ) snprintf( cDocument + ulLength, benchmarkDOCUMENT_SIZE - ulLength,
+                                                       "\"%s%u\":\"setting value %u\",", pcPrefix, ulIndex, ulIndex );
+                    break;
+
+                default:
+                    ulWritten = ( uint32_t ) snprintf( cDocument + ulLength, benchmarkDOCUMENT_SIZE - ulLength,
+                                                       "\"%s%u\":{\"mode\":\"auto\",\"steps\":[1,2,{\"at\":%u}]},",
+                                                       pcPrefix, ulIndex, ulIndex );
+                    break;
+            }
+
+            ulLength += ulWritten;
+        }
+
+        if( ulComponent > 0 )
+        {
+            /* Replace the trailing comma by the end of the component. */
+            ulLength--;
+            ulLength += ( uint32_t ) snprintf( cDocument + ulLength, benchmarkDOCUMENT_SIZE - ulLength, "}," );
+        }
+    }
+
+    ulLength += ( uint32_t ) snprintf( cDocument + ulLength, benchmarkDOCUMENT_SIZE - ulLength,
+                                       "\"$version\":%u}", benchmarkVERSION );
+    configASSERT( ulLength < benchmarkDOCUMENT_SIZE );
+
+    return ulLength;
+}
+/*-----------------------------------------------------------*/
+
+static uint32_t prvWriteDocument( uint32_t ulPropertyCount,
+                                  AzureIoTHubPropertiesMessageType_t xMessageType )
+{
+    uint32_t ulLength = 0;
+
+    if( xMessageType == eAzureIoTHubPropertiesWritablePropertyMessage )
+    {
+        return prvWriteSection( 0, ulPropertyCount, "desired" );
+    }
+
+    ulLength += ( uint32_t ) snprintf( cDocument, benchmarkDOCUMENT_SIZE, "{\"desired\":" );
+    ulLength = prvWriteSection( ulLength, ulPropertyCount, "desired" );
+    ulLength += ( uint32_t ) snprintf( cDocument + ulLength, benchmarkDOCUMENT_SIZE - ulLength, ",\"reported\":" );
+    ulLength = prvWriteSection( ulLength, ulPropertyCount, "reported" );
+    ulLength += ( uint32_t ) snprintf( cDocument + ulLength, benchmarkDOCUMENT_SIZE - ulLength, "}" );
+    configASSERT( ulLength < benchmarkDOCUMENT_SIZE );
+
+    return ulLength;
+}
+/*-----------------------------------------------------------*/
+
+/**
+ * @brief Count the property under the reader and add its value if it is a number,
+ * leaving the reader on the last token of the value.
+ */
+static AzureIoTResult_t prvTallyProperty( AzureIoTJSONReader_t * pxReader,
+                                          uint32_t ulComponentNameLength,
+                                          BenchmarkTally_t * pxTally )
+{
+    AzureIoTResult_t xResult = AzureIoTJSONReader_NextToken( pxReader );
+    AzureIoTJSONTokenType_t xTokenType;
+    double xValue;
+
+    pxTally->ulProperties++;
+    pxTally->ulComponentProperties += ( ulComponentNameLength > 0 ) ? 1 : 0;
+
+    if( ( xResult == eAzureIoTSuccess ) &&
+        ( AzureIoTJSONReader_TokenType( pxReader, &xTokenType ) == eAzureIoTSuccess ) &&
+        ( xTokenType == eAzureIoTJSONTokenNUMBER ) )
+    {
+        xResult = AzureIoTJSONReader_GetTokenDouble( pxReader, &xValue );
+        pxTally->xSum += xValue;
+    }
+    else if( xResult == eAzureIoTSuccess )
+    {
+        xResult = AzureIoTJSONReader_SkipChildren( pxReader );
+    }
+
+    return xResult;
+}
+/*-----------------------------------------------------------*/
+
+/**
+ * @brief The parse of the samples before the single pass parser.
+ */
+static AzureIoTResult_t prvParseTwoPasses( const uint8_t * pucDocument,
+                                           uint32_t ulLength,
+                                           AzureIoTHubPropertiesMessageType_t xMessageType,
+                                           uint32_t * pulVersion,
+                                           BenchmarkTally_t * pxTally )
+{
+    AzureIoTJSONReader_t xReader;
+    AzureIoTResult_t xResult;
+    const uint8_t * pucComponentName = NULL;
+    uint32_t ulComponentNameLength = 0;
+
+    ( void ) AzureIoTJSONReader_Init( &xReader, pucDocument, ulLength );
+    xResult = AzureIoTHubClientProperties_GetPropertiesVersion( &xClient, &xReader, xMessageType, pulVersion );
+
+    if( xResult != eAzureIoTSuccess )
+    {
+        return xResult;
+    }
+
+    ( void ) AzureIoTJSONReader_Init( &xReader, pucDocument, ulLength );
+
+    while( ( xResult = AzureIoTHubClientProperties_GetNextComponentProperty( &xClient, &xReader, xMessageType,
+                                                                             eAzureIoTHubClientPropertyWritable,
+                                                                             &pucComponentName,
+                                                                             &ulComponentNameLength ) ) == eAzureIoTSuccess )
+    {
+        if( ( ( xResult = prvTallyProperty( &xReader, ulComponentNameLength, pxTally ) ) != eAzureIoTSuccess ) ||
+            ( ( xResult = AzureIoTJSONReader_NextToken( &xReader ) ) != eAzureIoTSuccess ) )
+        {
+            return xResult;
+        }
+    }
+
+    return ( xResult == eAzureIoTErrorEndOfProperties ) ? eAzureIoTSuccess : xResult;
+}
+/*-----------------------------------------------------------*/
+
+static AzureIoTResult_t prvOnProperty( const uint8_t * pucComponentName,
+                                       uint32_t ulComponentNameLength,
+                                       AzureIoTJSONReader_t * pxReader,
+                                       void * pvContext )
+{
+    ( void ) pucComponentName;
+
+    return prvTallyProperty( pxReader, ulComponentNameLength, ( BenchmarkTally_t * ) pvContext );
+}
+/*-----------------------------------------------------------*/
+
+static void prvBenchmark( uint32_t ulPropertyCount,
+                          AzureIoTHubPropertiesMessageType_t xMessageType,
+                          uint32_t ulDocuments )
+{
+    BenchmarkTally_t xTwoPasses = { 0 };
+    BenchmarkTally_t xSinglePass = { 0 };
+    uint32_t ulLength = prvWriteDocument( ulPropertyCount, xMessageType );
+    uint32_t ulVersion = 0;
+    uint32_t ulErrors = 0;
+    uint32_t ulIndex;
+    uint64_t ullStart;
+    uint64_t ullTwoPassesNs;
+    uint64_t ullSinglePassNs;
+
+    ullStart = prvGetTimeNs();
+
+    for( ulIndex = 0; ulIndex < ulDocuments; ulIndex++ )
+    {
+        ulErrors += ( prvParseTwoPasses( ( const uint8_t * ) cDocument, ulLength, xMessageType,
+                                         &ulVersion, &xTwoPasses ) != eAzureIoTSuccess ) ? 1 : 0;
+    }
+
+    ullTwoPassesNs = prvGetTimeNs() - ullStart;
+    unittestCHECK( ulVersion == benchmarkVERSION );
+    ulVersion = 0;
+    ullStart = prvGetTimeNs();
+
+    for( ulIndex = 0; ulIndex < ulDocuments; ulIndex++ )
+    {
+        ulErrors += ( PropertiesParser_Parse( ( const uint8_t * ) cDocument, ulLength, xMessageType,
+                                              eAzureIoTHubClientPropertyWritable,
+                                              xParserComponents, benchmarkCOMPONENT_COUNT,
+                                              prvOnProperty, &xSinglePass, &ulVersion ) != eAzureIoTSuccess ) ? 1 : 0;
+    }
+
+    ullSinglePassNs = prvGetTimeNs() - ullStart;
+    unittestCHECK( ulVersion == benchmarkVERSION );
+    unittestCHECK( ulErrors == 0 );
+
+    /* Every desired property is found, with its component, and only those. */
+    unittestCHECK( xTwoPasses.ulProperties == ulPropertyCount * ulDocuments );
+    unittestCHECK( xSinglePass.ulProperties == xTwoPasses.ulProperties );
+    unittestCHECK( xTwoPasses.ulComponentProperties ==
+                   ( ulPropertyCount - ( ulPropertyCount + benchmarkCOMPONENT_COUNT ) / ( benchmarkCOMPONENT_COUNT + 1 ) ) * ulDocuments );
+    unittestCHECK( xSinglePass.ulComponentProperties == xTwoPasses.ulComponentProperties );
+    unittestCHECK( xSinglePass.xSum == xTwoPasses.xSum );
+
+    printf( "%10u %6s %8u %14.1f %14.1f %8.2f\n", ulPropertyCount,
+            ( xMessageType == eAzureIoTHubPropertiesRequestedMessage ) ? "get" : "patch", ulLength,
+            ( double ) ulLength * ulDocuments * 1000.0 / ( double ) ullTwoPassesNs,
+            ( double ) ulLength * ulDocuments * 1000.0 / ( double ) ullSinglePassNs,
+            ( double ) ullTwoPassesNs / ( double ) ullSinglePassNs );
+}
+/*-----------------------------------------------------------*/
+
+int main( int argc,
+          char ** argv )
+{
+    static const uint32_t ulPropertyCounts[] = { 16, 64, 256, 1024 };
+    uint32_t ulDocuments = ( argc > 1 ) ? ( uint32_t ) strtoul( argv[ 1 ], NULL, 10 ) : 1000U;
+    uint32_t ulIndex;
+    uint32_t ulVersion;
+    BenchmarkTally_t xTally = { 0 };
+
+    if( ulDocuments == 0 )
+    {
+        fprintf( stderr, "Usage: %s [documents]\n", argv[ 0 ] );
+
+        return 2;
+    }
+
+    xClient.pxComponentList = xClientComponents;
+    xClient.ulComponentListLength = benchmarkCOMPONENT_COUNT;
+
+    printf( "%10s %6s %8s %14s %14s %8s\n", "properties", "type", "bytes", "2 passes MB/s", "1 pass MB/s", "speedup" );
+
+    for( ulIndex = 0; ulIndex < sizeof( ulPropertyCounts ) / sizeof( ulPropertyCounts[ 0 ] ); ulIndex++ )
+    {
+        prvBenchmark( ulPropertyCounts[ ulIndex ], eAzureIoTHubPropertiesRequestedMessage, ulDocuments );
+        prvBenchmark( ulPropertyCounts[ ulIndex ], eAzureIoTHubPropertiesWritablePropertyMessage, ulDocuments );
+    }
+
+    /* A document without a version is refused by both. */
+    ( void ) strcpy( cDocument, "{\"thermostat1\":{\"__t\":\"c\",\"targetTemperature\":21}}" );
+    unittestCHECK( prvParseTwoPasses( ( const uint8_t * ) cDocument, ( uint32_t ) strlen( cDocument ),
+                                      eAzureIoTHubPropertiesWritablePropertyMessage, &ulVersion, &xTally ) != eAzureIoTSuccess );
+    unittestCHECK( PropertiesParser_Parse( ( const uint8_t * ) cDocument, ( uint32_t ) strlen( cDocument ),
+                                           eAzureIoTHubPropertiesWritablePropertyMessage, eAzureIoTHubClientPropertyWritable,
+                                           xParserComponents, benchmarkCOMPONENT_COUNT,
+                                           prvOnProperty, &xTally, &ulVersion ) == eAzureIoTErrorItemNotFound );
+
+    return UnitTest_Result();
+}
+/*-----------------------------------------------------------*/
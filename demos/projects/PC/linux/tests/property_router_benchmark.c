@@ -0,0 +1,486 @@
+/* Copyright (c) Microsoft Corporation.
+ * Licensed under the MIT License. */
+
+/**
+ * @file property_router_benchmark.c
+ * @brief Parse and dispatch throughput of the property router, from 8 to 64 properties.
+ *
+ * Built with room for 64 routes. For each table size it routes that many
+ * writable properties of the three types, spread over the root interface and
+ * three components, and generates a writable patch setting every one of them,
+ * one in eight out of range, along with properties nobody routes. The patch
+ * is handled as the samples did before, reading `$version` and then walking
+ * the properties with AzureIoTHubClientProperties_GetNextComponentProperty(),
+ * comparing each name with every property of its component and writing one
+ * acknowledgement per property, and with PropertyRouter_Process(). Both must
+ * leave the same values and acknowledge the same properties. The JSON reader
+ * and writer are those of the test fakes.
+ *
+ * Usage: property_router_benchmark [documents]
+ */
+
+#include <stdbool.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "property_router.h"
+
+#include "FreeRTOS.h"
+
+#include "unit_test.h"
+
+/*-----------------------------------------------------------*/
+
+#define benchmarkNAME_LENGTH      ( 12U )
+#define benchmarkDOCUMENT_SIZE    ( 8U * 1024U )
+#define benchmarkACK_SIZE         ( 16U * 1024U )
+#define benchmarkVERSION          ( 17U )
+
+static const char * const pcComponents[] = { NULL, "thermostat1", "thermostat2", "deviceInformation" };
+
+#define benchmarkCOMPONENT_COUNT    ( sizeof( pcComponents ) / sizeof( pcComponents[ 0 ] ) )
+
+static const AzureIoTHubClientComponent_t xClientComponents[] =
+{
+    { ( const uint8_t * ) "thermostat1",       sizeof( "thermostat1" ) - 1       },
+    { ( const uint8_t * ) "thermostat2",       sizeof( "thermostat2" ) - 1       },
+    { ( const uint8_t * ) "deviceInformation", sizeof( "deviceInformation" ) - 1 }
+};
+
+static char cPropertyNames[ propertyrouterMAX_ROUTES ][ benchmarkNAME_LENGTH ];
+static PropertyRoute_t xRoutes[ propertyrouterMAX_ROUTES ];
+
+/* The variables of the routes, and those the hand written dispatch sets. */
+static int32_t lRouterValues[ propertyrouterMAX_ROUTES ];
+static int32_t lDispatchValues[ propertyrouterMAX_ROUTES ];
+static uint32_t ulApplied;
+
+static char cDocument[ benchmarkDOCUMENT_SIZE ];
+static uint8_t ucAck[ benchmarkACK_SIZE ];
+static AzureIoTHubClient_t xClient;
+/*-----------------------------------------------------------*/
+
+static uint64_t prvGetTimeNs( void )
+{
+    struct timespec xNow;
+
+    ( void ) clock_gettime( CLOCK_MONOTONIC, &xNow );
+
+    return ( ( uint64_t ) xNow.tv_sec * 1000000000U ) + ( uint64_t ) xNow.tv_nsec;
+}
+/*-----------------------------------------------------------*/
+
+static void prvApplied( const PropertyRoute_t * pxRoute )
+{
+    ( void ) pxRoute;
+    ulApplied++;
+}
+/*-----------------------------------------------------------*/
+
+/**
+ * @brief Route @p ulIndex: an int32, double or bool, in component @p ulIndex modulo 4,
+ * accepting values from 0 to 1000.
+ */
+static void prvInitRoute( uint32_t ulIndex,
+                          int32_t * plValues )
+{
+    const char * pcComponent = pcComponents[ ulIndex % benchmarkCOMPONENT_COUNT ];
+    PropertyRoute_t * pxRoute = &xRoutes[ ulIndex ];
+
+    memset( pxRoute, 0, sizeof( *pxRoute ) );
+    pxRoute->pucComponentName = ( const uint8_t * ) pcComponent;
+    pxRoute->ulComponentNameLength = ( pcComponent != NULL ) ? ( uint32_t ) strlen( pcComponent ) : 0;
+    pxRoute->pucPropertyName = ( const uint8_t * ) cPropertyNames[ ulIndex ];
+    pxRoute->ulPropertyNameLength = ( uint32_t ) strlen( cPropertyNames[ ulIndex ] );
+    pxRoute->xMinimum = 0;
+    pxRoute->xMaximum = 1000;
+    pxRoute->xApplied = prvApplied;
+
+    /* Doubles and bools take the room of the int32 variable of their index, both are large enough. */
+    pxRoute->pvValue = &plValues[ ulIndex ];
+    pxRoute->xType = ( PropertyRouterValueType_t ) ( ulIndex % 3 );
+}
+/*-----------------------------------------------------------*/
+
+/**
+ * @brief Write a patch setting the @p ulRouteCount first routes, every eighth one out of range,
+ * with an unknown property in each component.
+ */
+static uint32_t prvWriteDocument( uint32_t ulRouteCount )
+{
+    uint32_t ulLength = 0;
+    uint32_t ulComponent;
+    uint32_t ulIndex;
+
+    ulLength += ( uint32_t ) snprintf( cDocument, benchmarkDOCUMENT_SIZE, "{" );
+
+    for( ulComponent = 0; ulComponent < benchmarkCOMPONENT_COUNT; ulComponent++ )
+    {
+        if( ulComponent > 0 )
+        {
+            ulLength += ( uint32_t ) snprintf( cDocument + ulLength, benchmarkDOCUMENT_SIZE - ulLength,
+                                               "\"%s\":{\"__t\":\"c\",", pcComponents[ ulComponent ] );
+        }
+
+        for( ulIndex = ulComponent; ulIndex < ulRouteCount; ulIndex += benchmarkCOMPONENT_COUNT )
+        {
+            switch( xRoutes[ ulIndex ].xType )
+            {
+                case ePropertyRouterValueInt32:
+                    ulLength += ( uint32_t ) snprintf( cDocument + ulLength, benchmarkDOCUMENT_SIZE - ulLength,
+                                                       "\"%s\":%u,", cPropertyNames[ ulIndex ],
+                                                       ( ulIndex % 8 == 7 ) ? 5000U : ulIndex * 10U );
+                    break;
+
+                case ePropertyRouterValueDouble:
+                    ulLength += ( uint32_t ) snprintf( cDocument + ulLength, benchmarkDOCUMENT_SIZE - ulLength,
+                                                       "\"%s\":%u.5,", cPropertyNames[ ulIndex ],
+                                                       ( ulIndex % 8 == 7 ) ? 5000U : ulIndex * 10U );
+                    break;
+
+                default:
+                    ulLength += ( uint32_t ) snprintf( cDocument + ulLength, benchmarkDOCUMENT_SIZE - ulLength,
+                                                       "\"%s\":true,", cPropertyNames[ ulIndex ] );
+                    break;
+            }
+        }
+
+        ulLength += ( uint32_t ) snprintf( cDocument + ulLength, benchmarkDOCUMENT_SIZE - ulLength,
+                                           "\"unknown%u\":{\"a\":[1,2]}%s", ulComponent,
+                                           ( ulComponent > 0 ) ? "}," : "," );
+    }
+
+    ulLength += ( uint32_t ) snprintf( cDocument + ulLength, benchmarkDOCUMENT_SIZE - ulLength,
+                                       "\"$version\":%u}", benchmarkVERSION );
+    configASSERT( ulLength < benchmarkDOCUMENT_SIZE );
+
+    return ulLength;
+}
+/*-----------------------------------------------------------*/
+
+/**
+ * @brief Acknowledge one property in its own patch, as the samples did.
+ */
+static AzureIoTResult_t prvAckOne( const PropertyRoute_t * pxRoute,
+                                   bool xAccepted,
+                                   uint32_t ulVersion,
+                                   uint32_t * pulAckBytes )
+{
+    AzureIoTJSONWriter_t xWriter;
+    AzureIoTResult_t xResult;
+
+    ( void ) AzureIoTJSONWriter_Init( &xWriter, ucAck, sizeof( ucAck ) );
+    xResult = AzureIoTJSONWriter_AppendBeginObject( &xWriter );
+
+    if( ( xResult == eAzureIoTSuccess ) && ( pxRoute->ulComponentNameLength > 0 ) )
+    {
+        xResult = AzureIoTHubClientProperties_BuilderBeginComponent( &xClient, &xWriter, pxRoute->pucComponentName,
+                                                                     ( uint16_t ) pxRoute->ulComponentNameLength );
+    }
+
+    if( xResult == eAzureIoTSuccess )
+    {
+        xResult = AzureIoTHubClientProperties_BuilderBeginResponseStatus( &xClient, &xWriter, pxRoute->pucPropertyName,
+                                                                          ( uint16_t ) pxRoute->ulPropertyNameLength,
+                                                                          xAccepted ? 200 : 400, ( int32_t ) ulVersion,
+                                                                          ( const uint8_t * ) ( xAccepted ? "success" : "invalid value" ),
+                                                                          xAccepted ? 7 : 13 );
+    }
+
+    if( xResult == eAzureIoTSuccess )
+    {
+        switch( pxRoute->xType )
+        {
+            case ePropertyRouterValueInt32:
+                xResult = AzureIoTJSONWriter_AppendInt32( &xWriter, *( const int32_t * ) pxRoute->pvValue );
+                break;
+
+            case ePropertyRouterValueDouble:
+                xResult = AzureIoTJSONWriter_AppendDouble( &xWriter, *( const double * ) pxRoute->pvValue, 2 );
+                break;
+
+            default:
+                xResult = AzureIoTJSONWriter_AppendBool( &xWriter, *( const bool * ) pxRoute->pvValue );
+                break;
+        }
+    }
+
+    if( xResult == eAzureIoTSuccess )
+    {
+        xResult = AzureIoTHubClientProperties_BuilderEndResponseStatus( &xClient, &xWriter );
+    }
+
+    if( ( xResult == eAzureIoTSuccess ) && ( pxRoute->ulComponentNameLength > 0 ) )
+    {
+        xResult = AzureIoTHubClientProperties_BuilderEndComponent( &xClient, &xWriter );
+    }
+
+    if( xResult == eAzureIoTSuccess )
+    {
+        xResult = AzureIoTJSONWriter_AppendEndObject( &xWriter );
+    }
+
+    *pulAckBytes += ( uint32_t ) AzureIoTJSONWriter_GetBytesUsed( &xWriter );
+
+    return xResult;
+}
+/*-----------------------------------------------------------*/
+
+/**
+ * @brief The value of the property under the reader into the variable of a route, if valid.
+ */
+static AzureIoTResult_t prvDispatchValue( AzureIoTJSONReader_t * pxReader,
+                                          const PropertyRoute_t * pxRoute,
+                                          uint32_t ulVersion,
+                                          uint32_t * pulAckBytes )
+{
+    AzureIoTResult_t xResult = AzureIoTJSONReader_NextToken( pxReader );
+    int32_t lValue = 0;
+    double xValue = 0;
+    bool xBoolValue = false;
+    bool xAccepted;
+
+    if( xResult != eAzureIoTSuccess )
+    {
+        return xResult;
+    }
+
+    switch( pxRoute->xType )
+    {
+        case ePropertyRouterValueInt32:
+            xAccepted = ( AzureIoTJSONReader_GetTokenInt32( pxReader, &lValue ) == eAzureIoTSuccess ) &&
+                        ( lValue >= pxRoute->xMinimum ) && ( lValue <= pxRoute->xMaximum );
+
+            if( xAccepted )
+            {
+                *( int32_t * ) pxRoute->pvValue = lValue;
+            }
+
+            break;
+
+        case ePropertyRouterValueDouble:
+            xAccepted = ( AzureIoTJSONReader_GetTokenDouble( pxReader, &xValue ) == eAzureIoTSuccess ) &&
+                        ( xValue >= pxRoute->xMinimum ) && ( xValue <= pxRoute->xMaximum );
+
+            if( xAccepted )
+            {
+                *( double * ) pxRoute->pvValue = xValue;
+            }
+
+            break;
+
+        default:
+            xAccepted = ( AzureIoTJSONReader_GetTokenBool( pxReader, &xBoolValue ) == eAzureIoTSuccess );
+
+            if( xAccepted )
+            {
+                *( bool * ) pxRoute->pvValue = xBoolValue;
+            }
+
+            break;
+    }
+
+    if( xAccepted )
+    {
+        ulApplied++;
+    }
+
+    return prvAckOne( pxRoute, xAccepted, ulVersion, pulAckBytes );
+}
+/*-----------------------------------------------------------*/
+
+/**
+ * @brief The handling of the samples before the router: two passes, and the names of the
+ * component compared one after the other.
+ */
+static AzureIoTResult_t prvDispatch( const uint8_t * pucDocument,
+                                     uint32_t ulLength,
+                                     const PropertyRoute_t * pxRoutes,
+                                     uint32_t ulRouteCount,
+                                     uint32_t * pulAckBytes )
+{
+    AzureIoTJSONReader_t xReader;
+    AzureIoTResult_t xResult;
+    const uint8_t * pucComponentName = NULL;
+    uint32_t ulComponentNameLength = 0;
+    uint32_t ulVersion;
+    uint32_t ulIndex;
+
+    ( void ) AzureIoTJSONReader_Init( &xReader, pucDocument, ulLength );
+    xResult = AzureIoTHubClientProperties_GetPropertiesVersion( &xClient, &xReader,
+                                                                eAzureIoTHubPropertiesWritablePropertyMessage, &ulVersion );
+
+    if( xResult != eAzureIoTSuccess )
+    {
+        return xResult;
+    }
+
+    ( void ) AzureIoTJSONReader_Init( &xReader, pucDocument, ulLength );
+
+    while( ( xResult = AzureIoTHubClientProperties_GetNextComponentProperty( &xClient, &xReader,
+                                                                             eAzureIoTHubPropertiesWritablePropertyMessage,
+                                                                             eAzureIoTHubClientPropertyWritable,
+                                                                             &pucComponentName,
+                                                                             &ulComponentNameLength ) ) == eAzureIoTSuccess )
+    {
+        for( ulIndex = 0; ulIndex < ulRouteCount; ulIndex++ )
+        {
+            if( ( pxRoutes[ ulIndex ].ulComponentNameLength == ulComponentNameLength ) &&
+                ( ( ulComponentNameLength == 0 ) ||
+                  ( memcmp( pxRoutes[ ulIndex ].pucComponentName, pucComponentName, ulComponentNameLength ) == 0 ) ) &&
+                AzureIoTJSONReader_TokenIsTextEqual( &xReader, pxRoutes[ ulIndex ].pucPropertyName,
+                                                     pxRoutes[ ulIndex ].ulPropertyNameLength ) )
+            {
+                break;
+            }
+        }
+
+        if( ulIndex < ulRouteCount )
+        {
+            xResult = prvDispatchValue( &xReader, &pxRoutes[ ulIndex ], ulVersion, pulAckBytes );
+        }
+        else
+        {
+            xResult = PropertiesParser_SkipValue( &xReader );
+        }
+
+        if( ( xResult != eAzureIoTSuccess ) ||
+            ( ( xResult = AzureIoTJSONReader_NextToken( &xReader ) ) != eAzureIoTSuccess ) )
+        {
+            return xResult;
+        }
+    }
+
+    return ( xResult == eAzureIoTErrorEndOfProperties ) ? eAzureIoTSuccess : xResult;
+}
+/*-----------------------------------------------------------*/
+
+static uint32_t prvCountText( const uint8_t * pucText,
+                              uint32_t ulLength,
+                              const char * pcPattern )
+{
+    uint32_t ulPatternLength = ( uint32_t ) strlen( pcPattern );
+    uint32_t ulCount = 0;
+    uint32_t ulIndex;
+
+    for( ulIndex = 0; ulIndex + ulPatternLength <= ulLength; ulIndex++ )
+    {
+        ulCount += ( memcmp( pucText + ulIndex, pcPattern, ulPatternLength ) == 0 ) ? 1 : 0;
+    }
+
+    return ulCount;
+}
+/*-----------------------------------------------------------*/
+
+static void prvBenchmark( uint32_t ulRouteCount,
+                          uint32_t ulDocuments )
+{
+    static PropertyRouter_t xRouter;
+    static PropertyRoute_t xDispatchRoutes[ propertyrouterMAX_ROUTES ];
+    AzureIoTHubClientPropertiesResponse_t xMessage;
+    uint32_t ulLength;
+    uint32_t ulIndex;
+    uint32_t ulAckLength = 0;
+    uint32_t ulAckBytes = 0;
+    uint32_t ulErrors = 0;
+    uint32_t ulRejected = 0;
+    uint32_t ulDispatchApplied;
+    uint64_t ullStart;
+    uint64_t ullRouterNs;
+    uint64_t ullDispatchNs;
+
+    for( ulIndex = 0; ulIndex < ulRouteCount; ulIndex++ )
+    {
+        prvInitRoute( ulIndex, lDispatchValues );
+        xDispatchRoutes[ ulIndex ] = xRoutes[ ulIndex ];
+        prvInitRoute( ulIndex, lRouterValues );
+        ulRejected += ( ( ulIndex % 8 == 7 ) && ( xRoutes[ ulIndex ].xType != ePropertyRouterValueBool ) ) ? 1 : 0;
+    }
+
+    memset( lRouterValues, 0, sizeof( lRouterValues ) );
+    memset( lDispatchValues, 0, sizeof( lDispatchValues ) );
+    unittestCHECK( PropertyRouter_Init( &xRouter, xRoutes, ulRouteCount ) == eAzureIoTSuccess );
+
+    ulLength = prvWriteDocument( ulRouteCount );
+    xMessage.pvMessagePayload = cDocument;
+    xMessage.ulPayloadLength = ulLength;
+    xMessage.xMessageType = eAzureIoTHubPropertiesWritablePropertyMessage;
+    xMessage.ulRequestID = 0;
+
+    ulApplied = 0;
+    ullStart = prvGetTimeNs();
+
+    for( ulIndex = 0; ulIndex < ulDocuments; ulIndex++ )
+    {
+        ulErrors += ( prvDispatch( ( const uint8_t * ) cDocument, ulLength, xDispatchRoutes, ulRouteCount,
+                                   &ulAckBytes ) != eAzureIoTSuccess ) ? 1 : 0;
+    }
+
+    ullDispatchNs = prvGetTimeNs() - ullStart;
+    ulDispatchApplied = ulApplied;
+    ulApplied = 0;
+    ullStart = prvGetTimeNs();
+
+    for( ulIndex = 0; ulIndex < ulDocuments; ulIndex++ )
+    {
+        ulErrors += ( PropertyRouter_Process( &xRouter, &xClient, &xMessage, ucAck, sizeof( ucAck ),
+                                              &ulAckLength ) != eAzureIoTSuccess ) ? 1 : 0;
+    }
+
+    ullRouterNs = prvGetTimeNs() - ullStart;
+
+    /* Both apply the same values, and acknowledge every routed property, in one patch for the router. */
+    unittestCHECK( ulErrors == 0 );
+    unittestCHECK( ulApplied == ( ulRouteCount - ulRejected ) * ulDocuments );
+    unittestCHECK( ulDispatchApplied == ulApplied );
+    unittestCHECK( memcmp( lRouterValues, lDispatchValues, sizeof( lRouterValues ) ) == 0 );
+    unittestCHECK( prvCountText( ucAck, ulAckLength, "\"ac\":200" ) == ulRouteCount - ulRejected );
+    unittestCHECK( prvCountText( ucAck, ulAckLength, "\"ac\":400" ) == ulRejected );
+    unittestCHECK( prvCountText( ucAck, ulAckLength, "\"__t\":\"c\"" ) ==
+                   ( ( ulRouteCount < benchmarkCOMPONENT_COUNT ) ? ulRouteCount - 1 : benchmarkCOMPONENT_COUNT - 1 ) );
+
+    printf( "%10u %8u %14.2f %14.2f %10u %10u\n", ulRouteCount, ulLength,
+            ( double ) ullDispatchNs / ulDocuments / 1000.0, ( double ) ullRouterNs / ulDocuments / 1000.0,
+            ulAckBytes / ulDocuments, ulAckLength );
+}
+/*-----------------------------------------------------------*/
+
+int main( int argc,
+          char ** argv )
+{
+    static const uint32_t ulRouteCounts[] = { 8, 16, 32, propertyrouterMAX_ROUTES };
+    static PropertyRouter_t xRouter;
+    uint32_t ulDocuments = ( argc > 1 ) ? ( uint32_t ) strtoul( argv[ 1 ], NULL, 10 ) : 10000U;
+    uint32_t ulIndex;
+
+    if( ulDocuments == 0 )
+    {
+        fprintf( stderr, "Usage: %s [documents]\n", argv[ 0 ] );
+
+        return 2;
+    }
+
+    xClient.pxComponentList = xClientComponents;
+    xClient.ulComponentListLength = benchmarkCOMPONENT_COUNT - 1;
+
+    for( ulIndex = 0; ulIndex < propertyrouterMAX_ROUTES; ulIndex++ )
+    {
+        ( void ) snprintf( cPropertyNames[ ulIndex ], benchmarkNAME_LENGTH, "setting%02u", ulIndex );
+    }
+
+    printf( "%10s %8s %14s %14s %10s %10s\n", "properties", "bytes", "dispatch (us)", "router (us)",
+            "acks (B)", "patch (B)" );
+
+    for( ulIndex = 0; ulIndex < sizeof( ulRouteCounts ) / sizeof( ulRouteCounts[ 0 ] ); ulIndex++ )
+    {
+        prvBenchmark( ulRouteCounts[ ulIndex ], ulDocuments );
+    }
+
+    /* A property routed twice is refused. */
+    xRoutes[ 1 ] = xRoutes[ 0 ];
+    unittestCHECK( PropertyRouter_Init( &xRouter, xRoutes, 2 ) == eAzureIoTErrorFailed );
+
+    return UnitTest_Result();
+}
+/*-----------------------------------------------------------*/
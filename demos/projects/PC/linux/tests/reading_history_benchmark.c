@@ -0,0 +1,190 @@
+/* Copyright (c) Microsoft Corporation.
+ * Licensed under the MIT License. */
+
+/**
+ * @file reading_history_benchmark.c
+ * @brief Query time of the reading history with 100000 readings retained.
+ *
+ * Built with room for 100000 readings. It adds two and a half times as many,
+ * one a second, so the ring has wrapped and the windows cross its end, then
+ * times the queries of windows of random length against a scan of the same
+ * readings, and checks that both agree.
+ *
+ * Usage: reading_history_benchmark [queries]
+ */
+
+#include <stdbool.h>
+#include <stdlib.h>
+#include <time.h>
+
+#include "reading_history.h"
+
+#include "unit_test.h"
+
+/*-----------------------------------------------------------*/
+
+#define benchmarkREADINGS    ( readinghistoryCAPACITY * 5U / 2U )
+
+static ReadingHistory_t xHistory;
+/*-----------------------------------------------------------*/
+
+static uint64_t prvGetTimeNs( void )
+{
+    struct timespec xNow;
+
+    ( void ) clock_gettime( CLOCK_MONOTONIC, &xNow );
+
+    return ( ( uint64_t ) xNow.tv_sec * 1000000000U ) + ( uint64_t ) xNow.tv_nsec;
+}
+/*-----------------------------------------------------------*/
+
+/**
+ * @brief The statistics of a window from a scan of the ring, for comparison.
+ */
+static bool prvScan( uint64_t ullSince,
+                     ReadingHistoryStats_t * pxStats )
+{
+    const ReadingHistoryNode_t * pxLeaf;
+    uint32_t ulIndex;
+    uint32_t ulSlot;
+    double xSum = 0.0;
+
+    pxStats->ulCount = 0;
+
+    for( ulIndex = 0; ulIndex < xHistory.ulCount; ulIndex++ )
+    {
+        ulSlot = ( xHistory.ulOldest + ulIndex ) % readinghistoryCAPACITY;
+
+        if( xHistory.ullTimes[ ulSlot ] < ullSince )
+        {
+            continue;
+        }
+
+        pxLeaf = &xHistory.xNodes[ readinghistoryCAPACITY + ulSlot ];
+
+        if( pxStats->ulCount == 0 )
+        {
+            pxStats->xMinimum = pxLeaf->xMinimum;
+            pxStats->xMaximum = pxLeaf->xMaximum;
+            pxStats->ullStartTime = xHistory.ullTimes[ ulSlot ];
+        }
+        else if( pxLeaf->xMinimum < pxStats->xMinimum )
+        {
+            pxStats->xMinimum = pxLeaf->xMinimum;
+        }
+        else if( pxLeaf->xMaximum > pxStats->xMaximum )
+        {
+            pxStats->xMaximum = pxLeaf->xMaximum;
+        }
+
+        pxStats->ullEndTime = xHistory.ullTimes[ ulSlot ];
+        xSum += pxLeaf->xSum;
+        pxStats->ulCount++;
+    }
+
+    pxStats->xAverage = ( pxStats->ulCount > 0 ) ? xSum / pxStats->ulCount : 0.0;
+
+    return pxStats->ulCount > 0;
+}
+/*-----------------------------------------------------------*/
+
+int main( int argc,
+          char ** argv )
+{
+    ReadingHistoryStats_t xStats;
+    ReadingHistoryStats_t xExpected;
+    uint32_t ulQueries = ( argc > 1 ) ? ( uint32_t ) strtoul( argv[ 1 ], NULL, 10 ) : 100000U;
+    uint32_t ulScans;
+    uint32_t ulIndex;
+    uint32_t ulFound = 0;
+    uint32_t ulMismatches = 0;
+    uint64_t * pullSince;
+    uint64_t ullStart;
+    uint64_t ullAddNs;
+    uint64_t ullQueryNs;
+    uint64_t ullScanNs;
+
+    if( ulQueries == 0 )
+    {
+        fprintf( stderr, "Usage: %s [queries]\n", argv[ 0 ] );
+
+        return 2;
+    }
+
+    /* The scans take long enough that a few hundred give a stable time. */
+    ulScans = ( ulQueries < 500U ) ? ulQueries : 500U;
+    pullSince = malloc( ulQueries * sizeof( *pullSince ) );
+
+    if( pullSince == NULL )
+    {
+        return 2;
+    }
+
+    ReadingHistory_Init( &xHistory );
+    srand( 11 );
+
+    ullStart = prvGetTimeNs();
+
+    for( ulIndex = 0; ulIndex < benchmarkREADINGS; ulIndex++ )
+    {
+        ReadingHistory_Add( &xHistory, ulIndex, 20.0 + ( double ) ( rand() % 1001 ) / 100.0 );
+    }
+
+    ullAddNs = prvGetTimeNs() - ullStart;
+    unittestCHECK( xHistory.ulCount == readinghistoryCAPACITY );
+
+    /* Windows from empty to the whole history. */
+    for( ulIndex = 0; ulIndex < ulQueries; ulIndex++ )
+    {
+        pullSince[ ulIndex ] = benchmarkREADINGS - ( uint64_t ) ( ( ( uint32_t ) rand() << 8 ) ^ ( uint32_t ) rand() ) %
+                               ( readinghistoryCAPACITY + 2U );
+    }
+
+    ullStart = prvGetTimeNs();
+
+    for( ulIndex = 0; ulIndex < ulQueries; ulIndex++ )
+    {
+        ulFound += ReadingHistory_Query( &xHistory, pullSince[ ulIndex ], &xStats ) ? 1 : 0;
+    }
+
+    ullQueryNs = prvGetTimeNs() - ullStart;
+    ullStart = prvGetTimeNs();
+
+    for( ulIndex = 0; ulIndex < ulScans; ulIndex++ )
+    {
+        ulFound += prvScan( pullSince[ ulIndex ], &xExpected ) ? 1 : 0;
+    }
+
+    ullScanNs = prvGetTimeNs() - ullStart;
+
+    for( ulIndex = 0; ulIndex < ulScans; ulIndex++ )
+    {
+        if( prvScan( pullSince[ ulIndex ], &xExpected ) !=
+            ReadingHistory_Query( &xHistory, pullSince[ ulIndex ], &xStats ) )
+        {
+            ulMismatches++;
+        }
+        else if( ( xExpected.ulCount > 0 ) &&
+                 ( ( xStats.ulCount != xExpected.ulCount ) ||
+                   ( xStats.xMinimum != xExpected.xMinimum ) || ( xStats.xMaximum != xExpected.xMaximum ) ||
+                   ( fabs( xStats.xAverage - xExpected.xAverage ) > 1e-9 ) ||
+                   ( xStats.ullStartTime != xExpected.ullStartTime ) ||
+                   ( xStats.ullEndTime != xExpected.ullEndTime ) ) )
+        {
+            ulMismatches++;
+        }
+    }
+
+    unittestCHECK( ulFound > 0 );
+    unittestCHECK( ulMismatches == 0 );
+
+    printf( "%10s %14s %14s %14s\n", "retained", "add (ns)", "query (ns)", "scan (ns)" );
+    printf( "%10u %14.1f %14.1f %14.1f\n", ( unsigned ) readinghistoryCAPACITY,
+            ( double ) ullAddNs / benchmarkREADINGS, ( double ) ullQueryNs / ulQueries,
+            ( double ) ullScanNs / ulScans );
+
+    free( pullSince );
+
+    return UnitTest_Result();
+}
+/*-----------------------------------------------------------*/
@@ -0,0 +1,126 @@
+/* Copyright (c) Microsoft Corporation.
+ * Licensed under the MIT License. */
+
+#include "backoff_policy.h"
+
+#include "FreeRTOS.h"
+
+#include "unit_test.h"
+
+/*-----------------------------------------------------------*/
+
+static void prvTestFullJitter( void )
+{
+    BackoffPolicy_t xPolicy;
+    uint32_t ulAttempt;
+    uint32_t ulDelay;
+
+    BackoffPolicy_Init( &xPolicy, eBackoffPolicyFullJitter, 100, 1000 );
+
+    /* The largest random number gives the ceiling: 100, 200, 400, 800, then the cap. */
+    unittestCHECK( BackoffPolicy_NextDelay( &xPolicy, 100 ) == 100 );
+    unittestCHECK( BackoffPolicy_NextDelay( &xPolicy, 200 ) == 200 );
+    unittestCHECK( BackoffPolicy_NextDelay( &xPolicy, 400 ) == 400 );
+    unittestCHECK( BackoffPolicy_NextDelay( &xPolicy, 800 ) == 800 );
+    unittestCHECK( BackoffPolicy_NextDelay( &xPolicy, 1000 ) == 1000 );
+    unittestCHECK( BackoffPolicy_NextDelay( &xPolicy, 0 ) == 0 );
+
+    for( ulAttempt = 0; ulAttempt < 1000; ulAttempt++ )
+    {
+        ulDelay = BackoffPolicy_NextDelay( &xPolicy, configRAND32() );
+        unittestCHECK( ulDelay <= 1000 );
+    }
+
+    /* Back to the base once the operation succeeded. */
+    BackoffPolicy_Reset( &xPolicy );
+    unittestCHECK( BackoffPolicy_NextDelay( &xPolicy, UINT32_MAX ) <= 100 );
+}
+/*-----------------------------------------------------------*/
+
+static void prvTestEqualJitter( void )
+{
+    BackoffPolicy_t xPolicy;
+    uint32_t ulAttempt;
+    uint32_t ulDelay;
+
+    BackoffPolicy_Init( &xPolicy, eBackoffPolicyEqualJitter, 100, 1000 );
+
+    /* Half of the ceiling is kept. */
+    unittestCHECK( BackoffPolicy_NextDelay( &xPolicy, 0 ) == 50 );
+    unittestCHECK( BackoffPolicy_NextDelay( &xPolicy, 0 ) == 100 );
+    unittestCHECK( BackoffPolicy_NextDelay( &xPolicy, 200 ) == 400 );
+
+    for( ulAttempt = 0; ulAttempt < 1000; ulAttempt++ )
+    {
+        ulDelay = BackoffPolicy_NextDelay( &xPolicy, configRAND32() );
+        unittestCHECK( ( ulDelay >= 500 ) && ( ulDelay <= 1000 ) );
+    }
+}
+/*-----------------------------------------------------------*/
+
+static void prvTestDecorrelatedJitter( void )
+{
+    BackoffPolicy_t xPolicy;
+    uint32_t ulPrevious = 100;
+    uint32_t ulAttempt;
+    uint32_t ulDelay;
+
+    BackoffPolicy_Init( &xPolicy, eBackoffPolicyDecorrelatedJitter, 100, 10000 );
+
+    /* Between the base and three times the previous delay, within the cap. */
+    for( ulAttempt = 0; ulAttempt < 1000; ulAttempt++ )
+    {
+        ulDelay = BackoffPolicy_NextDelay( &xPolicy, configRAND32() );
+        unittestCHECK( ( ulDelay >= 100 ) && ( ulDelay <= ulPrevious * 3 ) && ( ulDelay <= 10000 ) );
+        ulPrevious = ulDelay;
+    }
+
+    /* A cap close to UINT32_MAX does not overflow: the delays grow to it and stay there. */
+    BackoffPolicy_Init( &xPolicy, eBackoffPolicyDecorrelatedJitter, 1, UINT32_MAX - 1 );
+    ulPrevious = 1;
+
+    for( ulAttempt = 0; ulAttempt < 64; ulAttempt++ )
+    {
+        /* The largest delay below the ceiling, three times the previous one or the cap. */
+        ulDelay = BackoffPolicy_NextDelay( &xPolicy, ( ulPrevious > ( UINT32_MAX - 1 ) / 3 ) ?
+                                                     UINT32_MAX - 2 : ulPrevious * 3 - 1 );
+        unittestCHECK( ulDelay >= ulPrevious );
+        ulPrevious = ulDelay;
+    }
+
+    unittestCHECK( ulDelay == UINT32_MAX - 1 );
+}
+/*-----------------------------------------------------------*/
+
+static void prvTestRetryAfter( void )
+{
+    BackoffPolicy_t xPolicy;
+
+    BackoffPolicy_Init( &xPolicy, eBackoffPolicyFullJitter, 100, 1000 );
+
+    /* A floor on the next delay only, above the cap if need be. */
+    BackoffPolicy_SetRetryAfter( &xPolicy, 5000 );
+    unittestCHECK( BackoffPolicy_NextDelay( &xPolicy, 0 ) == 5000 );
+    unittestCHECK( BackoffPolicy_NextDelay( &xPolicy, 0 ) == 0 );
+
+    /* A longer jittered delay wins. */
+    BackoffPolicy_SetRetryAfter( &xPolicy, 10 );
+    unittestCHECK( BackoffPolicy_NextDelay( &xPolicy, 300 ) == 300 );
+
+    /* Reset drops the hint. */
+    BackoffPolicy_SetRetryAfter( &xPolicy, 5000 );
+    BackoffPolicy_Reset( &xPolicy );
+    unittestCHECK( BackoffPolicy_NextDelay( &xPolicy, 0 ) == 0 );
+}
+/*-----------------------------------------------------------*/
+
+int main( void )
+{
+    prvTestFullJitter();
+    prvTestEqualJitter();
+    prvTestDecorrelatedJitter();
+    prvTestRetryAfter();
+
+    return UnitTest_Result();
+}
+/*-----------------------------------------------------------*/
@@ -0,0 +1,232 @@
+/* Copyright (c) Microsoft Corporation.
+ * Licensed under the MIT License. */
+
+#include <string.h>
+
+#include "cbor_writer.h"
+
+#include "unit_test.h"
+
+/*-----------------------------------------------------------*/
+
+static uint8_t ucBuffer[ 64 ];
+static CBORWriter_t xWriter;
+/*-----------------------------------------------------------*/
+
+/**
+ * @brief Start a new encoding.
+ */
+static CBORWriter_t * prvReset( void )
+{
+    unittestCHECK( CBORWriter_Init( &xWriter, ucBuffer, sizeof( ucBuffer ) ) == eAzureIoTSuccess );
+
+    return &xWriter;
+}
+/*-----------------------------------------------------------*/
+
+/**
+ * @brief Whether the encoding is the expected one, given in hexadecimal.
+ */
+static bool prvEncoded( const char * pcHex )
+{
+    uint32_t ulIndex;
+    unsigned int uByte;
+
+    if( CBORWriter_GetBytesUsed( &xWriter ) * 2 != strlen( pcHex ) )
+    {
+        return false;
+    }
+
+    for( ulIndex = 0; ulIndex < CBORWriter_GetBytesUsed( &xWriter ); ulIndex++ )
+    {
+        if( ( sscanf( &pcHex[ ulIndex * 2 ], "%2x", &uByte ) != 1 ) || ( ucBuffer[ ulIndex ] != uByte ) )
+        {
+            return false;
+        }
+    }
+
+    return true;
+}
+/*-----------------------------------------------------------*/
+
+/* Examples of RFC 8949, appendix A. */
+static void prvTestIntegers( void )
+{
+    CBORWriter_AppendUnsigned( prvReset(), 0 );
+    unittestCHECK( prvEncoded( "00" ) );
+    CBORWriter_AppendUnsigned( prvReset(), 23 );
+    unittestCHECK( prvEncoded( "17" ) );
+    CBORWriter_AppendUnsigned( prvReset(), 24 );
+    unittestCHECK( prvEncoded( "1818" ) );
+    CBORWriter_AppendUnsigned( prvReset(), 1000 );
+    unittestCHECK( prvEncoded( "1903e8" ) );
+    CBORWriter_AppendUnsigned( prvReset(), 1000000 );
+    unittestCHECK( prvEncoded( "1a000f4240" ) );
+    CBORWriter_AppendUnsigned( prvReset(), 1000000000000ULL );
+    unittestCHECK( prvEncoded( "1b000000e8d4a51000" ) );
+    CBORWriter_AppendUnsigned( prvReset(), UINT64_MAX );
+    unittestCHECK( prvEncoded( "1bffffffffffffffff" ) );
+
+    CBORWriter_AppendInt( prvReset(), 10 );
+    unittestCHECK( prvEncoded( "0a" ) );
+    CBORWriter_AppendInt( prvReset(), -1 );
+    unittestCHECK( prvEncoded( "20" ) );
+    CBORWriter_AppendInt( prvReset(), -100 );
+    unittestCHECK( prvEncoded( "3863" ) );
+    CBORWriter_AppendInt( prvReset(), -1000 );
+    unittestCHECK( prvEncoded( "3903e7" ) );
+    CBORWriter_AppendInt( prvReset(), INT64_MIN );
+    unittestCHECK( prvEncoded( "3b7fffffffffffffff" ) );
+}
+/*-----------------------------------------------------------*/
+
+static void prvTestFloatingPoint( void )
+{
+    CBORWriter_AppendHalf( prvReset(), 0.0f );
+    unittestCHECK( prvEncoded( "f90000" ) );
+    CBORWriter_AppendHalf( prvReset(), -0.0f );
+    unittestCHECK( prvEncoded( "f98000" ) );
+    CBORWriter_AppendHalf( prvReset(), 1.5f );
+    unittestCHECK( prvEncoded( "f93e00" ) );
+    CBORWriter_AppendHalf( prvReset(), 65504.0f );
+    unittestCHECK( prvEncoded( "f97bff" ) );
+    CBORWriter_AppendHalf( prvReset(), 5.960464477539063e-8f );
+    unittestCHECK( prvEncoded( "f90001" ) );
+    CBORWriter_AppendHalf( prvReset(), -4.0f );
+    unittestCHECK( prvEncoded( "f9c400" ) );
+    CBORWriter_AppendHalf( prvReset(), INFINITY );
+    unittestCHECK( prvEncoded( "f97c00" ) );
+
+    CBORWriter_AppendFloat( prvReset(), 100000.0f );
+    unittestCHECK( prvEncoded( "fa47c35000" ) );
+    CBORWriter_AppendFloat( prvReset(), 3.4028234663852886e+38f );
+    unittestCHECK( prvEncoded( "fa7f7fffff" ) );
+
+    CBORWriter_AppendDouble( prvReset(), 1.1 );
+    unittestCHECK( prvEncoded( "fb3ff199999999999a" ) );
+    CBORWriter_AppendDouble( prvReset(), -4.1 );
+    unittestCHECK( prvEncoded( "fbc010666666666666" ) );
+
+    /* The shortest of the three holding the value exactly. */
+    CBORWriter_AppendFloatingPoint( prvReset(), 21.5 );
+    unittestCHECK( prvEncoded( "f94d60" ) );
+    CBORWriter_AppendFloatingPoint( prvReset(), 100000.0 );
+    unittestCHECK( prvEncoded( "fa47c35000" ) );
+    CBORWriter_AppendFloatingPoint( prvReset(), 1.0e+300 );
+    unittestCHECK( prvEncoded( "fb7e37e43c8800759c" ) );
+    CBORWriter_AppendFloatingPoint( prvReset(), 0.1 );
+    unittestCHECK( CBORWriter_GetBytesUsed( &xWriter ) == 9 );
+    CBORWriter_AppendFloatingPoint( prvReset(), -INFINITY );
+    unittestCHECK( prvEncoded( "f9fc00" ) );
+}
+/*-----------------------------------------------------------*/
+
+static void prvTestSimpleValuesAndStrings( void )
+{
+    prvReset();
+    CBORWriter_AppendBool( &xWriter, false );
+    CBORWriter_AppendBool( &xWriter, true );
+    CBORWriter_AppendNull( &xWriter );
+    unittestCHECK( prvEncoded( "f4f5f6" ) );
+
+    prvReset();
+    CBORWriter_AppendText( &xWriter, ( const uint8_t * ) "", 0 );
+    CBORWriter_AppendText( &xWriter, ( const uint8_t * ) "IETF", 4 );
+    CBORWriter_AppendText( &xWriter, ( const uint8_t * ) "\xc3\xbc", 2 );
+    unittestCHECK( prvEncoded( "60644945544662c3bc" ) );
+
+    CBORWriter_AppendBytes( prvReset(), ( const uint8_t * ) "\x01\x02\x03\x04", 4 );
+    unittestCHECK( prvEncoded( "4401020304" ) );
+
+    prvReset();
+    CBORWriter_AppendTag( &xWriter, 1 );
+    CBORWriter_AppendUnsigned( &xWriter, 1363896240 );
+    unittestCHECK( prvEncoded( "c11a514b67b0" ) );
+
+    unittestCHECK( CBORWriter_AppendText( prvReset(), NULL, 1 ) == eAzureIoTErrorInvalidArgument );
+    unittestCHECK( CBORWriter_AppendBytes( prvReset(), NULL, 1 ) == eAzureIoTErrorInvalidArgument );
+}
+/*-----------------------------------------------------------*/
+
+static void prvTestContainers( void )
+{
+    /* {"a": 1, "b": [2, 3]} */
+    prvReset();
+    unittestCHECK( CBORWriter_AppendBeginMap( &xWriter, 2 ) == eAzureIoTSuccess );
+    CBORWriter_AppendText( &xWriter, ( const uint8_t * ) "a", 1 );
+    CBORWriter_AppendUnsigned( &xWriter, 1 );
+    CBORWriter_AppendText( &xWriter, ( const uint8_t * ) "b", 1 );
+    unittestCHECK( CBORWriter_AppendBeginArray( &xWriter, 2 ) == eAzureIoTSuccess );
+    CBORWriter_AppendUnsigned( &xWriter, 2 );
+    CBORWriter_AppendUnsigned( &xWriter, 3 );
+    unittestCHECK( CBORWriter_AppendEndArray( &xWriter ) == eAzureIoTSuccess );
+    unittestCHECK( CBORWriter_AppendEndMap( &xWriter ) == eAzureIoTSuccess );
+    unittestCHECK( prvEncoded( "a26161016162820203" ) );
+
+    /* [_ 1, [2, 3], [_ 4, 5]] */
+    prvReset();
+    CBORWriter_AppendBeginArray( &xWriter, cborwriterINDEFINITE_LENGTH );
+    CBORWriter_AppendUnsigned( &xWriter, 1 );
+    CBORWriter_AppendBeginArray( &xWriter, 2 );
+    CBORWriter_AppendUnsigned( &xWriter, 2 );
+    CBORWriter_AppendUnsigned( &xWriter, 3 );
+    CBORWriter_AppendEndArray( &xWriter );
+    CBORWriter_AppendBeginArray( &xWriter, cborwriterINDEFINITE_LENGTH );
+    CBORWriter_AppendUnsigned( &xWriter, 4 );
+    CBORWriter_AppendUnsigned( &xWriter, 5 );
+    CBORWriter_AppendEndArray( &xWriter );
+    CBORWriter_AppendEndArray( &xWriter );
+    unittestCHECK( prvEncoded( "9f018202039f0405ffff" ) );
+
+    /* {_ "a": 1, "b": [_ 2, 3]} */
+    prvReset();
+    CBORWriter_AppendBeginMap( &xWriter, cborwriterINDEFINITE_LENGTH );
+    CBORWriter_AppendText( &xWriter, ( const uint8_t * ) "a", 1 );
+    CBORWriter_AppendUnsigned( &xWriter, 1 );
+    CBORWriter_AppendText( &xWriter, ( const uint8_t * ) "b", 1 );
+    CBORWriter_AppendBeginArray( &xWriter, cborwriterINDEFINITE_LENGTH );
+    CBORWriter_AppendUnsigned( &xWriter, 2 );
+    CBORWriter_AppendUnsigned( &xWriter, 3 );
+    CBORWriter_AppendEndArray( &xWriter );
+    CBORWriter_AppendEndMap( &xWriter );
+    unittestCHECK( prvEncoded( "bf61610161629f0203ffff" ) );
+}
+/*-----------------------------------------------------------*/
+
+static void prvTestLimits( void )
+{
+    uint32_t ulDepth;
+
+    /* Closing what was not opened, and nesting too deep. */
+    unittestCHECK( CBORWriter_AppendEndMap( prvReset() ) == eAzureIoTErrorInvalidArgument );
+
+    for( ulDepth = 0; ulDepth < cborwriterMAX_NESTING; ulDepth++ )
+    {
+        unittestCHECK( CBORWriter_AppendBeginArray( &xWriter, 1 ) == eAzureIoTSuccess );
+    }
+
+    unittestCHECK( CBORWriter_AppendBeginArray( &xWriter, 1 ) == eAzureIoTErrorInvalidArgument );
+    unittestCHECK( CBORWriter_GetBytesUsed( &xWriter ) == cborwriterMAX_NESTING );
+
+    /* A failed call leaves the output unchanged. */
+    unittestCHECK( CBORWriter_Init( &xWriter, ucBuffer, 4 ) == eAzureIoTSuccess );
+    unittestCHECK( CBORWriter_AppendUnsigned( &xWriter, 1000 ) == eAzureIoTSuccess );
+    unittestCHECK( CBORWriter_AppendText( &xWriter, ( const uint8_t * ) "IETF", 4 ) == eAzureIoTErrorOutOfMemory );
+    unittestCHECK( CBORWriter_AppendDouble( &xWriter, 1.1 ) == eAzureIoTErrorOutOfMemory );
+    unittestCHECK( CBORWriter_AppendBeginArray( &xWriter, cborwriterINDEFINITE_LENGTH ) == eAzureIoTSuccess );
+    unittestCHECK( CBORWriter_AppendEndArray( &xWriter ) == eAzureIoTErrorOutOfMemory );
+    unittestCHECK( prvEncoded( "1903e89f" ) );
+}
+/*-----------------------------------------------------------*/
+
+int main( void )
+{
+    prvTestIntegers();
+    prvTestFloatingPoint();
+    prvTestSimpleValuesAndStrings();
+    prvTestContainers();
+    prvTestLimits();
+
+    return UnitTest_Result();
+}
+/*-----------------------------------------------------------*/
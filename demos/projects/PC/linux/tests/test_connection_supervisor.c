@@ -0,0 +1,138 @@
+/* Copyright (c) Microsoft Corporation.
+ * Licensed under the MIT License. */
+
+#include "connection_supervisor.h"
+
+#include "unit_test.h"
+
+/*-----------------------------------------------------------*/
+
+static void prvTestClassify( void )
+{
+    /* Only a refusal by the service is an auth failure. */
+    unittestCHECK( ConnectionSupervisor_Classify( eConnectionSupervisorStageConnect, eAzureIoTErrorServerError ) == eConnectionSupervisorErrorAuth );
+    unittestCHECK( ConnectionSupervisor_Classify( eConnectionSupervisorStageProvision, eAzureIoTErrorServerError ) == eConnectionSupervisorErrorAuth );
+
+    /* CONNACK timeouts and network errors while connecting are transient. */
+    unittestCHECK( ConnectionSupervisor_Classify( eConnectionSupervisorStageConnect, eAzureIoTErrorFailed ) == eConnectionSupervisorErrorTransient );
+    unittestCHECK( ConnectionSupervisor_Classify( eConnectionSupervisorStageConnect, eAzureIoTErrorPending ) == eConnectionSupervisorErrorTransient );
+    unittestCHECK( ConnectionSupervisor_Classify( eConnectionSupervisorStageProvision, eAzureIoTErrorFailed ) == eConnectionSupervisorErrorTransient );
+    unittestCHECK( ConnectionSupervisor_Classify( eConnectionSupervisorStageTransport, eAzureIoTErrorServerError ) == eConnectionSupervisorErrorTransient );
+    unittestCHECK( ConnectionSupervisor_Classify( eConnectionSupervisorStagePublish, eAzureIoTErrorPublishFailed ) == eConnectionSupervisorErrorTransient );
+    unittestCHECK( ConnectionSupervisor_Classify( eConnectionSupervisorStageProcessLoop, eAzureIoTErrorServerError ) == eConnectionSupervisorErrorTransient );
+
+    /* Configuration errors fail at any stage. */
+    unittestCHECK( ConnectionSupervisor_Classify( eConnectionSupervisorStageConnect, eAzureIoTErrorInvalidArgument ) == eConnectionSupervisorErrorFatal );
+    unittestCHECK( ConnectionSupervisor_Classify( eConnectionSupervisorStageSubscribe, eAzureIoTErrorOutOfMemory ) == eConnectionSupervisorErrorFatal );
+    unittestCHECK( ConnectionSupervisor_Classify( eConnectionSupervisorStageTransport, eAzureIoTErrorInitFailed ) == eConnectionSupervisorErrorFatal );
+}
+/*-----------------------------------------------------------*/
+
+static void prvTestConnectTimeoutsReconnect( void )
+{
+    ConnectionSupervisor_t xSupervisor;
+    uint32_t ulIndex;
+
+    ConnectionSupervisor_Init( &xSupervisor, true );
+
+    /* However many, timeouts never send the device back to provisioning. */
+    for( ulIndex = 0; ulIndex < 10; ulIndex++ )
+    {
+        unittestCHECK( ConnectionSupervisor_ReportFailure( &xSupervisor, eConnectionSupervisorStageConnect,
+                                                           eAzureIoTErrorFailed, ulIndex * 1000 ) == eConnectionSupervisorActionReconnect );
+    }
+
+    unittestCHECK( xSupervisor.xOutageClass == eConnectionSupervisorErrorTransient );
+    unittestCHECK( xSupervisor.ulAuthFailureCount == 0 );
+}
+/*-----------------------------------------------------------*/
+
+static void prvTestRefusalsReprovision( void )
+{
+    ConnectionSupervisor_t xSupervisor;
+
+    ConnectionSupervisor_Init( &xSupervisor, true );
+
+    /* A timeout, then refusals: the refusals alone count towards provisioning again. */
+    unittestCHECK( ConnectionSupervisor_ReportFailure( &xSupervisor, eConnectionSupervisorStageConnect,
+                                                       eAzureIoTErrorFailed, 0 ) == eConnectionSupervisorActionReconnect );
+    unittestCHECK( ConnectionSupervisor_ReportFailure( &xSupervisor, eConnectionSupervisorStageConnect,
+                                                       eAzureIoTErrorServerError, 1000 ) == eConnectionSupervisorActionReconnect );
+    unittestCHECK( xSupervisor.xOutageClass == eConnectionSupervisorErrorAuth );
+    unittestCHECK( ConnectionSupervisor_ReportFailure( &xSupervisor, eConnectionSupervisorStageConnect,
+                                                       eAzureIoTErrorServerError, 2000 ) == eConnectionSupervisorActionReprovision );
+
+    /* Without the Provisioning service, refusals only reconnect. */
+    ConnectionSupervisor_Init( &xSupervisor, false );
+    unittestCHECK( ConnectionSupervisor_ReportFailure( &xSupervisor, eConnectionSupervisorStageConnect,
+                                                       eAzureIoTErrorServerError, 0 ) == eConnectionSupervisorActionReconnect );
+    unittestCHECK( ConnectionSupervisor_ReportFailure( &xSupervisor, eConnectionSupervisorStageConnect,
+                                                       eAzureIoTErrorServerError, 0 ) == eConnectionSupervisorActionReconnect );
+}
+/*-----------------------------------------------------------*/
+
+static void prvTestRetriesAndHalt( void )
+{
+    ConnectionSupervisor_t xSupervisor;
+
+    ConnectionSupervisor_Init( &xSupervisor, true );
+
+    /* A failed publish is retried once, then the connection is replaced. */
+    unittestCHECK( ConnectionSupervisor_ReportFailure( &xSupervisor, eConnectionSupervisorStagePublish,
+                                                       eAzureIoTErrorPublishFailed, 0 ) == eConnectionSupervisorActionRetry );
+    unittestCHECK( ConnectionSupervisor_ReportFailure( &xSupervisor, eConnectionSupervisorStagePublish,
+                                                       eAzureIoTErrorPublishFailed, 0 ) == eConnectionSupervisorActionReconnect );
+    unittestCHECK( ConnectionSupervisor_ReportFailure( &xSupervisor, eConnectionSupervisorStageProcessLoop,
+                                                       eAzureIoTErrorFailed, 0 ) == eConnectionSupervisorActionReconnect );
+
+    /* A failed registration registers again, a configuration error stops. */
+    unittestCHECK( ConnectionSupervisor_ReportFailure( &xSupervisor, eConnectionSupervisorStageProvision,
+                                                       eAzureIoTErrorFailed, 0 ) == eConnectionSupervisorActionReprovision );
+    unittestCHECK( ConnectionSupervisor_ReportFailure( &xSupervisor, eConnectionSupervisorStageConnect,
+                                                       eAzureIoTErrorInvalidArgument, 0 ) == eConnectionSupervisorActionHalt );
+    unittestCHECK( xSupervisor.xOutageClass == eConnectionSupervisorErrorFatal );
+}
+/*-----------------------------------------------------------*/
+
+static void prvTestTimeToRecover( void )
+{
+    ConnectionSupervisor_t xSupervisor;
+    const ConnectionSupervisorMetrics_t * pxMetrics;
+
+    ConnectionSupervisor_Init( &xSupervisor, true );
+
+    /* Recovering without an outage is not counted. */
+    ConnectionSupervisor_ReportRecovered( &xSupervisor, 500 );
+    unittestCHECK( ConnectionSupervisor_GetMeanTimeToRecover( &xSupervisor, eConnectionSupervisorErrorTransient ) == 0 );
+
+    /* An outage lasts from its first failure, and counts in its worst class. */
+    ( void ) ConnectionSupervisor_ReportFailure( &xSupervisor, eConnectionSupervisorStageProcessLoop, eAzureIoTErrorFailed, 1000 );
+    ( void ) ConnectionSupervisor_ReportFailure( &xSupervisor, eConnectionSupervisorStageConnect, eAzureIoTErrorFailed, 2000 );
+    ConnectionSupervisor_ReportRecovered( &xSupervisor, 4000 );
+    ( void ) ConnectionSupervisor_ReportFailure( &xSupervisor, eConnectionSupervisorStageConnect, eAzureIoTErrorFailed, 10000 );
+    ConnectionSupervisor_ReportRecovered( &xSupervisor, 11000 );
+
+    pxMetrics = ConnectionSupervisor_GetMetrics( &xSupervisor, eConnectionSupervisorErrorTransient );
+    unittestCHECK( pxMetrics->ulRecoveryCount == 2 );
+    unittestCHECK( pxMetrics->ulMaxTimeToRecoverMs == 3000 );
+    unittestCHECK( ConnectionSupervisor_GetMeanTimeToRecover( &xSupervisor, eConnectionSupervisorErrorTransient ) == 2000 );
+
+    ( void ) ConnectionSupervisor_ReportFailure( &xSupervisor, eConnectionSupervisorStageConnect, eAzureIoTErrorFailed, 20000 );
+    ( void ) ConnectionSupervisor_ReportFailure( &xSupervisor, eConnectionSupervisorStageConnect, eAzureIoTErrorServerError, 21000 );
+    ConnectionSupervisor_ReportRecovered( &xSupervisor, 25000 );
+    unittestCHECK( ConnectionSupervisor_GetMeanTimeToRecover( &xSupervisor, eConnectionSupervisorErrorAuth ) == 5000 );
+    unittestCHECK( ConnectionSupervisor_GetMetrics( &xSupervisor, eConnectionSupervisorErrorTransient )->ulRecoveryCount == 2 );
+}
+/*-----------------------------------------------------------*/
+
+int main( void )
+{
+    prvTestClassify();
+    prvTestConnectTimeoutsReconnect();
+    prvTestRefusalsReprovision();
+    prvTestRetriesAndHalt();
+    prvTestTimeToRecover();
+
+    return UnitTest_Result();
+}
+/*-----------------------------------------------------------*/
@@ -0,0 +1,85 @@
+/* Copyright (c) Microsoft Corporation.
+ * Licensed under the MIT License. */
+
+#include "deadline_scheduler.h"
+
+#include "FreeRTOS.h"
+#include "task.h"
+
+#include "unit_test.h"
+
+/*-----------------------------------------------------------*/
+
+static TickType_t xTickCount;
+/*-----------------------------------------------------------*/
+
+TickType_t xTaskGetTickCount( void )
+{
+    return xTickCount;
+}
+/*-----------------------------------------------------------*/
+
+static void prvTestDeadlines( void )
+{
+    DeadlineSchedulerEntry_t xEntries[ 3 ];
+    DeadlineScheduler_t xScheduler;
+
+    DeadlineScheduler_Init( &xScheduler, xEntries, 3 );
+    unittestCHECK( DeadlineScheduler_TimeToNext( &xScheduler, 0, 5000 ) == 5000 );
+    unittestCHECK( !DeadlineScheduler_Due( &xScheduler, 0, 1000000 ) );
+
+    /* Entry 0 every 100 from 100, entry 1 once at 250. */
+    DeadlineScheduler_Arm( &xScheduler, 0, 100, 100 );
+    DeadlineScheduler_Arm( &xScheduler, 1, 250, 0 );
+    unittestCHECK( DeadlineScheduler_TimeToNext( &xScheduler, 0, 5000 ) == 100 );
+    unittestCHECK( DeadlineScheduler_TimeToNext( &xScheduler, 0, 50 ) == 50 );
+
+    unittestCHECK( !DeadlineScheduler_Due( &xScheduler, 0, 99 ) );
+    unittestCHECK( DeadlineScheduler_Due( &xScheduler, 0, 100 ) );
+    unittestCHECK( !DeadlineScheduler_Due( &xScheduler, 0, 100 ) );
+    unittestCHECK( DeadlineScheduler_TimeToNext( &xScheduler, 120, 5000 ) == 80 );
+
+    /* Missed deadlines run once, keeping the phase. */
+    unittestCHECK( DeadlineScheduler_TimeToNext( &xScheduler, 470, 5000 ) == 0 );
+    unittestCHECK( DeadlineScheduler_Due( &xScheduler, 0, 470 ) );
+    unittestCHECK( !DeadlineScheduler_Due( &xScheduler, 0, 499 ) );
+    unittestCHECK( DeadlineScheduler_Due( &xScheduler, 0, 500 ) );
+
+    /* A single deadline disarms itself. */
+    unittestCHECK( DeadlineScheduler_Due( &xScheduler, 1, 470 ) );
+    unittestCHECK( !DeadlineScheduler_Due( &xScheduler, 1, 1000 ) );
+
+    DeadlineScheduler_Disarm( &xScheduler, 0 );
+    unittestCHECK( DeadlineScheduler_TimeToNext( &xScheduler, 500, 5000 ) == 5000 );
+    unittestCHECK( !DeadlineScheduler_Due( &xScheduler, 0, 1000 ) );
+}
+/*-----------------------------------------------------------*/
+
+static void prvTestTime( void )
+{
+    const uint64_t ullWrap = ( uint64_t ) UINT32_MAX + 1;
+    uint64_t ullStart;
+
+    /* One tick per millisecond. */
+    configASSERT( configTICK_RATE_HZ == 1000 );
+
+    xTickCount = 1000;
+    ullStart = DeadlineScheduler_GetTimeMs();
+    unittestCHECK( ullStart == 1000 );
+
+    /* Time keeps going forward when the tick count wraps around. */
+    xTickCount = ( TickType_t ) ( ullWrap - 500 );
+    unittestCHECK( DeadlineScheduler_GetTimeMs() - ullStart == ullWrap - 1500 );
+    xTickCount = 500;
+    unittestCHECK( DeadlineScheduler_GetTimeMs() - ullStart == ullWrap - 500 );
+}
+/*-----------------------------------------------------------*/
+
+int main( void )
+{
+    prvTestDeadlines();
+    prvTestTime();
+
+    return UnitTest_Result();
+}
+/*-----------------------------------------------------------*/
@@ -0,0 +1,145 @@
+/* Copyright (c) Microsoft Corporation.
+ * Licensed under the MIT License. */
+
+#include <stdbool.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "double_format.h"
+
+#include "unit_test.h"
+
+/* Random values checked against printf, for each number of digits. */
+#define testRANDOM_VALUES    ( 20000U )
+
+/*-----------------------------------------------------------*/
+
+/**
+ * @brief Whether DoubleFormat_Fixed() writes what printf writes.
+ */
+static bool prvMatchesPrintf( double xValue,
+                              uint32_t ulFractionalDigits )
+{
+    uint8_t ucBuffer[ doubleformatMAX_LENGTH ];
+    char cExpected[ 64 ];
+    uint32_t ulLength;
+    bool xMatches;
+
+    ulLength = DoubleFormat_Fixed( xValue, ulFractionalDigits, ucBuffer, sizeof( ucBuffer ) );
+    ( void ) snprintf( cExpected, sizeof( cExpected ), "%.*f", ( int ) ulFractionalDigits, xValue );
+    xMatches = ( ulLength == strlen( cExpected ) ) && ( memcmp( ucBuffer, cExpected, ulLength ) == 0 );
+
+    if( !xMatches )
+    {
+        fprintf( stderr, "%.17g at %u digits: \"%.*s\" instead of \"%s\"\n",
+                 xValue, ulFractionalDigits, ( int ) ulLength, ( const char * ) ucBuffer, cExpected );
+    }
+
+    return xMatches;
+}
+/*-----------------------------------------------------------*/
+
+/**
+ * @brief A random double of any magnitude below 2^53, with all its bits random.
+ */
+static double prvRandomValue( void )
+{
+    uint64_t ullBits = 0;
+    double xValue;
+    uint32_t ulIndex;
+
+    for( ulIndex = 0; ulIndex < 4; ulIndex++ )
+    {
+        ullBits = ( ullBits << 16 ) ^ ( uint64_t ) ( rand() & 0xFFFF );
+    }
+
+    /* Exponents from 2^-40 to 2^52. */
+    ullBits &= ( 1ULL << 52 ) - 1U;
+    ullBits |= ( uint64_t ) ( 1023 - 40 + ( rand() % 93 ) ) << 52;
+    memcpy( &xValue, &ullBits, sizeof( xValue ) );
+
+    return ( ( rand() & 1 ) != 0 ) ? -xValue : xValue;
+}
+/*-----------------------------------------------------------*/
+
+static void prvTestPrintfParity( void )
+{
+    static const double xValues[] =
+    {
+        0.0, -0.0, 1.0, -1.0, 0.5, 1.5, 2.5, -2.5, 0.125, 0.375, -0.001, -0.004999, 0.005, 0.015, 0.045,
+        1.005, 2.675, 9.995, 99.995, 0.1, 0.7, 1e-10, 123456.789, 1e15 + 0.5, 4503599627370495.5,
+        9007199254740991.0, -9007199254740991.0, 0.99999999995, 999999999.9999999
+    };
+    uint32_t ulDigits;
+    uint32_t ulIndex;
+
+    for( ulDigits = 0; ulDigits <= doubleformatMAX_FRACTIONAL_DIGITS; ulDigits++ )
+    {
+        for( ulIndex = 0; ulIndex < sizeof( xValues ) / sizeof( xValues[ 0 ] ); ulIndex++ )
+        {
+            unittestCHECK( prvMatchesPrintf( xValues[ ulIndex ], ulDigits ) );
+        }
+    }
+
+    srand( 1 );
+
+    for( ulIndex = 0; ulIndex < testRANDOM_VALUES; ulIndex++ )
+    {
+        unittestCHECK( prvMatchesPrintf( prvRandomValue(), ulIndex % ( doubleformatMAX_FRACTIONAL_DIGITS + 1 ) ) );
+    }
+}
+/*-----------------------------------------------------------*/
+
+static void prvTestRoundTrip( void )
+{
+    uint8_t ucBuffer[ doubleformatMAX_LENGTH + 1 ];
+    double xValue;
+    double xParsed;
+    uint32_t ulLength;
+    uint32_t ulIndex;
+
+    srand( 2 );
+
+    /* Parsed back, the text is within half a unit of its last digit. */
+    for( ulIndex = 0; ulIndex < testRANDOM_VALUES; ulIndex++ )
+    {
+        xValue = prvRandomValue() / 1e6;
+        ulLength = DoubleFormat_Fixed( xValue, doubleformatMAX_FRACTIONAL_DIGITS, ucBuffer, doubleformatMAX_LENGTH );
+        unittestCHECK( ulLength > 0 );
+        ucBuffer[ ulLength ] = '\0';
+        xParsed = strtod( ( const char * ) ucBuffer, NULL );
+        unittestCHECK( fabs( xParsed - xValue ) <= 0.5e-9 * ( 1.0 + 1e-9 ) + fabs( xValue ) * 1e-15 );
+    }
+}
+/*-----------------------------------------------------------*/
+
+static void prvTestRejected( void )
+{
+    uint8_t ucBuffer[ doubleformatMAX_LENGTH ];
+
+    unittestCHECK( DoubleFormat_Fixed( NAN, 2, ucBuffer, sizeof( ucBuffer ) ) == 0 );
+    unittestCHECK( DoubleFormat_Fixed( INFINITY, 2, ucBuffer, sizeof( ucBuffer ) ) == 0 );
+    unittestCHECK( DoubleFormat_Fixed( -INFINITY, 2, ucBuffer, sizeof( ucBuffer ) ) == 0 );
+    unittestCHECK( DoubleFormat_Fixed( 9007199254740992.0, 0, ucBuffer, sizeof( ucBuffer ) ) == 0 );
+    unittestCHECK( DoubleFormat_Fixed( -1e300, 0, ucBuffer, sizeof( ucBuffer ) ) == 0 );
+    unittestCHECK( DoubleFormat_Fixed( 1.0, doubleformatMAX_FRACTIONAL_DIGITS + 1, ucBuffer, sizeof( ucBuffer ) ) == 0 );
+
+    /* The largest value fits in the documented length, and not in less. */
+    unittestCHECK( DoubleFormat_Fixed( -9007199254740991.0, doubleformatMAX_FRACTIONAL_DIGITS,
+                                       ucBuffer, doubleformatMAX_LENGTH ) == doubleformatMAX_LENGTH );
+    unittestCHECK( DoubleFormat_Fixed( -9007199254740991.0, doubleformatMAX_FRACTIONAL_DIGITS,
+                                       ucBuffer, doubleformatMAX_LENGTH - 1 ) == 0 );
+    unittestCHECK( DoubleFormat_Fixed( -0.001, 2, ucBuffer, 4 ) == 0 );
+    unittestCHECK( DoubleFormat_Fixed( -0.001, 2, ucBuffer, 5 ) == 5 );
+}
+/*-----------------------------------------------------------*/
+
+int main( void )
+{
+    prvTestPrintfParity();
+    prvTestRoundTrip();
+    prvTestRejected();
+
+    return UnitTest_Result();
+}
+/*-----------------------------------------------------------*/
@@ -0,0 +1,113 @@
+/* Copyright (c) Microsoft Corporation.
+ * Licensed under the MIT License. */
+
+#include "endpoint_selector.h"
+
+#include "unit_test.h"
+
+/*-----------------------------------------------------------*/
+
+static void prvInit( EndpointSelector_t * pxSelector,
+                     EndpointSelectorEntry_t * pxEntries )
+{
+    pxEntries[ 0 ].pucHostName = ( const uint8_t * ) "primary";
+    pxEntries[ 0 ].ulHostNameLength = 7;
+    pxEntries[ 1 ].pucHostName = ( const uint8_t * ) "secondary";
+    pxEntries[ 1 ].ulHostNameLength = 9;
+    EndpointSelector_Init( pxSelector, pxEntries, 2 );
+}
+/*-----------------------------------------------------------*/
+
+static void prvTestFailover( void )
+{
+    EndpointSelector_t xSelector;
+    EndpointSelectorEntry_t xEntries[ 2 ];
+    uint32_t ulIndex;
+
+    prvInit( &xSelector, xEntries );
+    unittestCHECK( EndpointSelector_Select( &xSelector ) == &xEntries[ 0 ] );
+
+    /* A failure below the threshold keeps the endpoint. */
+    EndpointSelector_ReportConnection( &xSelector, false );
+    unittestCHECK( EndpointSelector_Select( &xSelector ) == &xEntries[ 0 ] );
+
+    EndpointSelector_ReportConnection( &xSelector, false );
+    unittestCHECK( EndpointSelector_Select( &xSelector ) == &xEntries[ 1 ] );
+    unittestCHECK( xSelector.ulFailoverCount == 1 );
+
+    /* When every endpoint fails, the device does not take turns between them. */
+    for( ulIndex = 0; ulIndex < 2; ulIndex++ )
+    {
+        EndpointSelector_ReportConnection( &xSelector, false );
+        unittestCHECK( EndpointSelector_Select( &xSelector ) == &xEntries[ 1 ] );
+    }
+
+    /* Failing more than the other one, it moves back. */
+    EndpointSelector_ReportConnection( &xSelector, false );
+    unittestCHECK( EndpointSelector_Select( &xSelector ) == &xEntries[ 0 ] );
+    unittestCHECK( xSelector.ulFailoverCount == 2 );
+
+    /* A connection clears the failures of its endpoint. */
+    EndpointSelector_ReportConnection( &xSelector, true );
+    unittestCHECK( xEntries[ 0 ].ulConsecutiveFailures == 0 );
+    unittestCHECK( EndpointSelector_Select( &xSelector ) == &xEntries[ 0 ] );
+}
+/*-----------------------------------------------------------*/
+
+static void prvTestUnreachable( void )
+{
+    EndpointSelector_t xSelector;
+    EndpointSelectorEntry_t xEntries[ 2 ];
+
+    prvInit( &xSelector, xEntries );
+
+    /* An endpoint that does not answer its probe is not failed over to. */
+    EndpointSelector_ReportProbe( &xSelector, 1, false, 0 );
+    EndpointSelector_ReportConnection( &xSelector, false );
+    EndpointSelector_ReportConnection( &xSelector, false );
+    unittestCHECK( EndpointSelector_Select( &xSelector ) == &xEntries[ 0 ] );
+    unittestCHECK( xEntries[ 1 ].ulConsecutiveFailures == 0 );
+
+    /* Once it answers again, it is. */
+    EndpointSelector_ReportProbe( &xSelector, 1, true, 50 );
+    unittestCHECK( EndpointSelector_Select( &xSelector ) == &xEntries[ 1 ] );
+}
+/*-----------------------------------------------------------*/
+
+static void prvTestRoundTripTime( void )
+{
+    EndpointSelector_t xSelector;
+    EndpointSelectorEntry_t xEntries[ 2 ];
+
+    prvInit( &xSelector, xEntries );
+
+    /* Without a measure of the current endpoint, the device stays. */
+    EndpointSelector_ReportProbe( &xSelector, 1, true, 20 );
+    unittestCHECK( EndpointSelector_Select( &xSelector ) == &xEntries[ 0 ] );
+
+    /* Faster by less than the hysteresis, it stays as well. */
+    EndpointSelector_ReportProbe( &xSelector, 0, true, 20 + endpointselectorRTT_HYSTERESIS_MS );
+    unittestCHECK( EndpointSelector_Select( &xSelector ) == &xEntries[ 0 ] );
+
+    /* Measures are smoothed: one slow probe moves the time by an eighth. */
+    EndpointSelector_ReportProbe( &xSelector, 0, true, 20 + endpointselectorRTT_HYSTERESIS_MS + 800 );
+    unittestCHECK( xEntries[ 0 ].ulSmoothedRttMs == 20 + endpointselectorRTT_HYSTERESIS_MS + 100 );
+    unittestCHECK( EndpointSelector_Select( &xSelector ) == &xEntries[ 1 ] );
+    unittestCHECK( xSelector.ulFailoverCount == 1 );
+
+    /* A failed probe keeps the measure. */
+    EndpointSelector_ReportProbe( &xSelector, 0, false, 0 );
+    unittestCHECK( xEntries[ 0 ].xUnreachable );
+    unittestCHECK( xEntries[ 0 ].ulSmoothedRttMs == 20 + endpointselectorRTT_HYSTERESIS_MS + 100 );
+}
+/*-----------------------------------------------------------*/
+
+int main( void )
+{
+    prvTestFailover();
+    prvTestUnreachable();
+    prvTestRoundTripTime();
+
+    return UnitTest_Result();
+}
+/*-----------------------------------------------------------*/
@@ -0,0 +1,172 @@
+/* Copyright (c) Microsoft Corporation.
+ * Licensed under the MIT License. */
+
+#include <string.h>
+
+#include "gorilla_series.h"
+
+#include "unit_test.h"
+
+/*-----------------------------------------------------------*/
+
+#define testSIGNAL_COUNT    ( 3U )
+#define testRECORD_COUNT    ( 50U )
+
+static uint8_t ucSeries[ gorillaseriesHEADER_LENGTH + testRECORD_COUNT * gorillaseriesRECORD_MAX_LENGTH( testSIGNAL_COUNT ) ];
+/*-----------------------------------------------------------*/
+
+/**
+ * @brief Values of a record: a steady one, a slow ramp, and one that jumps around.
+ */
+static void prvValues( uint32_t ulRecord,
+                       double * pxValues )
+{
+    const double xSpecial[] = { 0.0, -0.0, 1e308, -1e-308, INFINITY, NAN };
+
+    pxValues[ 0 ] = 21.5;
+    pxValues[ 1 ] = 1000.0 + 0.25 * ulRecord;
+    pxValues[ 2 ] = ( ulRecord < 6 ) ? xSpecial[ ulRecord ] : ( ulRecord * 7919 ) % 1000 / 3.0;
+}
+/*-----------------------------------------------------------*/
+
+static void prvTestRoundTrip( void )
+{
+    GorillaSeriesSignal_t xSignals[ testSIGNAL_COUNT ];
+    GorillaSeriesEncoder_t xEncoder;
+    GorillaSeriesDecoder_t xDecoder;
+    double xValues[ testSIGNAL_COUNT ];
+    double xDecoded[ testSIGNAL_COUNT ];
+    uint64_t ullTime;
+    uint32_t ulRecord;
+
+    unittestCHECK( GorillaSeries_EncoderInit( &xEncoder, xSignals, testSIGNAL_COUNT, ucSeries, sizeof( ucSeries ) ) );
+
+    for( ulRecord = 0; ulRecord < testRECORD_COUNT; ulRecord++ )
+    {
+        prvValues( ulRecord, xValues );
+
+        /* A regular period, with jitter now and then and a long gap. */
+        ullTime = 1700000000000ULL + ulRecord * 1000U + ( ( ulRecord % 10 == 3 ) ? 7 : 0 ) +
+                  ( ( ulRecord >= 40 ) ? 3600000U : 0 );
+        unittestCHECK( GorillaSeries_Append( &xEncoder, ullTime, xValues ) );
+    }
+
+    unittestCHECK( GorillaSeries_RecordCount( &xEncoder ) == testRECORD_COUNT );
+    unittestCHECK( ucSeries[ 0 ] == gorillaseriesVERSION );
+    unittestCHECK( ucSeries[ 1 ] == testSIGNAL_COUNT );
+
+    unittestCHECK( GorillaSeries_DecoderInit( &xDecoder, xSignals, testSIGNAL_COUNT,
+                                              ucSeries, GorillaSeries_Length( &xEncoder ) ) );
+
+    for( ulRecord = 0; ulRecord < testRECORD_COUNT; ulRecord++ )
+    {
+        prvValues( ulRecord, xValues );
+        ullTime = 1700000000000ULL + ulRecord * 1000U + ( ( ulRecord % 10 == 3 ) ? 7 : 0 ) +
+                  ( ( ulRecord >= 40 ) ? 3600000U : 0 );
+
+        unittestCHECK( GorillaSeries_Next( &xDecoder, &ullTime, xDecoded ) );
+        unittestCHECK( ullTime == 1700000000000ULL + ulRecord * 1000U + ( ( ulRecord % 10 == 3 ) ? 7 : 0 ) +
+                       ( ( ulRecord >= 40 ) ? 3600000U : 0 ) );
+
+        /* Bit for bit, NaN and the sign of zero included. */
+        unittestCHECK( memcmp( xDecoded, xValues, sizeof( xValues ) ) == 0 );
+    }
+
+    unittestCHECK( !GorillaSeries_Next( &xDecoder, &ullTime, xDecoded ) );
+}
+/*-----------------------------------------------------------*/
+
+static void prvTestSteadySeries( void )
+{
+    GorillaSeriesSignal_t xSignals[ testSIGNAL_COUNT ];
+    GorillaSeriesEncoder_t xEncoder;
+    const double xValues[ testSIGNAL_COUNT ] = { 1.0, 2.0, 3.0 };
+    uint32_t ulRecord;
+
+    unittestCHECK( GorillaSeries_EncoderInit( &xEncoder, xSignals, testSIGNAL_COUNT, ucSeries, sizeof( ucSeries ) ) );
+
+    for( ulRecord = 0; ulRecord < testRECORD_COUNT; ulRecord++ )
+    {
+        unittestCHECK( GorillaSeries_Append( &xEncoder, ulRecord * 60U, xValues ) );
+    }
+
+    /* The second record sets the period, every later one costs one bit per field. */
+    unittestCHECK( GorillaSeries_Length( &xEncoder ) <=
+                   gorillaseriesHEADER_LENGTH + 32U + gorillaseriesRECORD_MAX_LENGTH( testSIGNAL_COUNT ) +
+                   ( ( testRECORD_COUNT - 2U ) * ( 1U + testSIGNAL_COUNT ) + 7U ) / 8U );
+}
+/*-----------------------------------------------------------*/
+
+static void prvTestFullBuffer( void )
+{
+    GorillaSeriesSignal_t xSignals[ 1 ];
+    GorillaSeriesEncoder_t xEncoder;
+    GorillaSeriesDecoder_t xDecoder;
+    uint8_t ucSmall[ gorillaseriesHEADER_LENGTH + 48U ];
+    double xValue = 0.0;
+    uint64_t ullTime = 0;
+    uint32_t ulLength = 0;
+    uint32_t ulRecords = 0;
+
+    unittestCHECK( !GorillaSeries_EncoderInit( &xEncoder, xSignals, 0, ucSmall, sizeof( ucSmall ) ) );
+    unittestCHECK( !GorillaSeries_EncoderInit( &xEncoder, xSignals, 1, ucSmall, gorillaseriesHEADER_LENGTH - 1 ) );
+    unittestCHECK( GorillaSeries_EncoderInit( &xEncoder, xSignals, 1, ucSmall, sizeof( ucSmall ) ) );
+
+    /* Values that change every time fill the buffer, the record that does not fit leaves it as it was. */
+    while( GorillaSeries_Append( &xEncoder, ullTime, &xValue ) )
+    {
+        ulLength = GorillaSeries_Length( &xEncoder );
+        ulRecords++;
+        ullTime += 1 + ulRecords * ulRecords;
+        xValue = xValue * -1.7 + 0.3;
+    }
+
+    unittestCHECK( ulRecords > 1 );
+    unittestCHECK( GorillaSeries_Length( &xEncoder ) == ulLength );
+    unittestCHECK( GorillaSeries_RecordCount( &xEncoder ) == ulRecords );
+
+    unittestCHECK( GorillaSeries_DecoderInit( &xDecoder, xSignals, 1, ucSmall, ulLength ) );
+
+    while( GorillaSeries_Next( &xDecoder, &ullTime, &xValue ) )
+    {
+        ulRecords--;
+    }
+
+    unittestCHECK( ulRecords == 0 );
+}
+/*-----------------------------------------------------------*/
+
+static void prvTestInvalidSeries( void )
+{
+    GorillaSeriesSignal_t xSignals[ testSIGNAL_COUNT ];
+    GorillaSeriesEncoder_t xEncoder;
+    GorillaSeriesDecoder_t xDecoder;
+    double xValues[ testSIGNAL_COUNT ] = { 0 };
+    uint64_t ullTime;
+
+    unittestCHECK( GorillaSeries_EncoderInit( &xEncoder, xSignals, testSIGNAL_COUNT, ucSeries, sizeof( ucSeries ) ) );
+    unittestCHECK( GorillaSeries_Append( &xEncoder, 0, xValues ) );
+    unittestCHECK( GorillaSeries_Append( &xEncoder, 10, xValues ) );
+
+    /* More signals than the decoder has room for, truncated header and record. */
+    unittestCHECK( !GorillaSeries_DecoderInit( &xDecoder, xSignals, testSIGNAL_COUNT - 1, ucSeries, GorillaSeries_Length( &xEncoder ) ) );
+    unittestCHECK( !GorillaSeries_DecoderInit( &xDecoder, xSignals, testSIGNAL_COUNT, ucSeries, gorillaseriesHEADER_LENGTH - 1 ) );
+    unittestCHECK( GorillaSeries_DecoderInit( &xDecoder, xSignals, testSIGNAL_COUNT, ucSeries, gorillaseriesHEADER_LENGTH + 8 ) );
+    unittestCHECK( !GorillaSeries_Next( &xDecoder, &ullTime, xValues ) );
+
+    /* Unknown version. */
+    ucSeries[ 0 ] = gorillaseriesVERSION + 1;
+    unittestCHECK( !GorillaSeries_DecoderInit( &xDecoder, xSignals, testSIGNAL_COUNT, ucSeries, GorillaSeries_Length( &xEncoder ) ) );
+}
+/*-----------------------------------------------------------*/
+
+int main( void )
+{
+    prvTestRoundTrip();
+    prvTestSteadySeries();
+    prvTestFullBuffer();
+    prvTestInvalidSeries();
+
+    return UnitTest_Result();
+}
+/*-----------------------------------------------------------*/
@@ -0,0 +1,154 @@
+/* Copyright (c) Microsoft Corporation.
+ * Licensed under the MIT License. */
+
+#include <stdbool.h>
+#include <string.h>
+
+#include "iso8601_time.h"
+
+#include "unit_test.h"
+
+/*-----------------------------------------------------------*/
+
+static bool prvFormatIs( uint64_t ullUnixTime,
+                         const char * pcExpected )
+{
+    uint8_t ucBuffer[ iso8601timeLENGTH ];
+
+    return ( Iso8601Time_Format( ullUnixTime, ucBuffer, sizeof( ucBuffer ) ) == iso8601timeLENGTH ) &&
+           ( memcmp( ucBuffer, pcExpected, iso8601timeLENGTH ) == 0 );
+}
+/*-----------------------------------------------------------*/
+
+static bool prvParse( const char * pcText,
+                      uint64_t * pullUnixTime )
+{
+    return Iso8601Time_Parse( ( const uint8_t * ) pcText, ( uint32_t ) strlen( pcText ), pullUnixTime );
+}
+/*-----------------------------------------------------------*/
+
+static bool prvParseIs( const char * pcText,
+                        uint64_t ullExpected )
+{
+    uint64_t ullUnixTime = ~ullExpected;
+
+    return prvParse( pcText, &ullUnixTime ) && ( ullUnixTime == ullExpected );
+}
+/*-----------------------------------------------------------*/
+
+static void prvTestFormat( void )
+{
+    uint8_t ucBuffer[ iso8601timeLENGTH ];
+
+    unittestCHECK( prvFormatIs( 0, "1970-01-01T00:00:00Z" ) );
+    unittestCHECK( prvFormatIs( 951782400, "2000-02-29T00:00:00Z" ) );
+    unittestCHECK( prvFormatIs( 1234567890, "2009-02-13T23:31:30Z" ) );
+    unittestCHECK( prvFormatIs( 4107542399ULL, "2100-02-28T23:59:59Z" ) );
+    unittestCHECK( prvFormatIs( 4107542400ULL, "2100-03-01T00:00:00Z" ) );
+    unittestCHECK( prvFormatIs( 253402300799ULL, "9999-12-31T23:59:59Z" ) );
+
+    /* Year 10000 needs 5 digits. */
+    unittestCHECK( Iso8601Time_Format( 253402300800ULL, ucBuffer, sizeof( ucBuffer ) ) == 0 );
+    unittestCHECK( Iso8601Time_Format( 0, ucBuffer, iso8601timeLENGTH - 1 ) == 0 );
+}
+/*-----------------------------------------------------------*/
+
+static void prvTestParse( void )
+{
+    uint64_t ullUnixTime;
+
+    unittestCHECK( prvParseIs( "2009-02-13T23:31:30Z", 1234567890 ) );
+    unittestCHECK( prvParseIs( "2009-02-13t23:31:30z", 1234567890 ) );
+    unittestCHECK( prvParseIs( "2009-02-13T23:31:30", 1234567890 ) );
+    unittestCHECK( prvParseIs( "2009-02-13T23:31:30.999Z", 1234567890 ) );
+    unittestCHECK( prvParseIs( "2009-02-13T23:31:30.", 1234567890 ) );
+    unittestCHECK( prvParseIs( "2009-02-14T01:01:30+01:30", 1234567890 ) );
+    unittestCHECK( prvParseIs( "2009-02-13T18:31:30.5-05:00", 1234567890 ) );
+    unittestCHECK( prvParseIs( "2000-02-29T00:00:00Z", 951782400 ) );
+    unittestCHECK( prvParseIs( "1970-01-01T01:00:00+01:00", 0 ) );
+
+    /* Calendar and clock ranges. */
+    unittestCHECK( !prvParse( "2001-02-29T00:00:00Z", &ullUnixTime ) );
+    unittestCHECK( !prvParse( "2100-02-29T00:00:00Z", &ullUnixTime ) );
+    unittestCHECK( !prvParse( "2000-02-30T00:00:00Z", &ullUnixTime ) );
+    unittestCHECK( !prvParse( "2000-04-31T00:00:00Z", &ullUnixTime ) );
+    unittestCHECK( !prvParse( "2000-00-10T00:00:00Z", &ullUnixTime ) );
+    unittestCHECK( !prvParse( "2000-13-10T00:00:00Z", &ullUnixTime ) );
+    unittestCHECK( !prvParse( "2000-01-00T00:00:00Z", &ullUnixTime ) );
+    unittestCHECK( !prvParse( "2000-01-01T24:00:00Z", &ullUnixTime ) );
+    unittestCHECK( !prvParse( "2000-01-01T00:60:00Z", &ullUnixTime ) );
+    unittestCHECK( !prvParse( "2016-12-31T23:59:60Z", &ullUnixTime ) );
+    unittestCHECK( !prvParse( "2000-01-01T00:00:00+24:00", &ullUnixTime ) );
+
+    /* Syntax. */
+    unittestCHECK( !prvParse( "2000-01-01T00:00:0", &ullUnixTime ) );
+    unittestCHECK( !prvParse( "2000-01-01 00:00:00Z", &ullUnixTime ) );
+    unittestCHECK( !prvParse( "2000/01/01T00:00:00Z", &ullUnixTime ) );
+    unittestCHECK( !prvParse( "2000-01-01T00:00:0aZ", &ullUnixTime ) );
+    unittestCHECK( !prvParse( "2000-01-01T00:00:00ZZ", &ullUnixTime ) );
+    unittestCHECK( !prvParse( "2000-01-01T00:00:00+01", &ullUnixTime ) );
+    unittestCHECK( !prvParse( "2000-01-01T00:00:00+0100", &ullUnixTime ) );
+    unittestCHECK( !prvParse( "2000-01-01T00:00:00+01:00Z", &ullUnixTime ) );
+    unittestCHECK( !prvParse( "2000-01-01T00:00:00,5Z", &ullUnixTime ) );
+
+    /* Before the epoch, directly or through the offset. */
+    unittestCHECK( !prvParse( "1969-12-31T23:59:59Z", &ullUnixTime ) );
+    unittestCHECK( !prvParse( "1970-01-01T00:30:00+01:00", &ullUnixTime ) );
+}
+/*-----------------------------------------------------------*/
+
+/**
+ * @brief Every day from 1970 to 2400, against a day by day count of the calendar.
+ */
+static void prvTestEveryDay( void )
+{
+    static const uint32_t ulDaysInMonth[ 12 ] = { 31, 28, 31, 30, 31, 30, 31, 31, 30, 31, 30, 31 };
+    char cExpected[ iso8601timeLENGTH + 1 ];
+    uint64_t ullDays = 0;
+    uint64_t ullSecond;
+    uint64_t ullUnixTime;
+    uint32_t ulFailures = 0;
+    uint32_t ulYear;
+    uint32_t ulMonth;
+    uint32_t ulDay;
+    uint32_t ulLength;
+    bool xLeap;
+
+    for( ulYear = 1970; ulYear < 2400; ulYear++ )
+    {
+        xLeap = ( ( ulYear % 4 ) == 0 ) && ( ( ( ulYear % 100 ) != 0 ) || ( ( ulYear % 400 ) == 0 ) );
+
+        for( ulMonth = 1; ulMonth <= 12; ulMonth++ )
+        {
+            ulLength = ulDaysInMonth[ ulMonth - 1 ] + ( ( ( ulMonth == 2 ) && xLeap ) ? 1 : 0 );
+
+            for( ulDay = 1; ulDay <= ulLength; ulDay++, ullDays++ )
+            {
+                /* A time of day that moves with the date, to cover the clock fields too. */
+                ullSecond = ( ullDays * 7919U ) % 86400U;
+                ( void ) snprintf( cExpected, sizeof( cExpected ), "%04u-%02u-%02uT%02u:%02u:%02uZ",
+                                   ulYear, ulMonth, ulDay, ( unsigned ) ( ullSecond / 3600 ),
+                                   ( unsigned ) ( ( ullSecond / 60 ) % 60 ), ( unsigned ) ( ullSecond % 60 ) );
+
+                if( !prvFormatIs( ullDays * 86400U + ullSecond, cExpected ) ||
+                    !prvParse( cExpected, &ullUnixTime ) || ( ullUnixTime != ullDays * 86400U + ullSecond ) )
+                {
+                    ulFailures++;
+                }
+            }
+        }
+    }
+
+    unittestCHECK( ulFailures == 0 );
+}
+/*-----------------------------------------------------------*/
+
+int main( void )
+{
+    prvTestFormat();
+    prvTestParse();
+    prvTestEveryDay();
+
+    return UnitTest_Result();
+}
+/*-----------------------------------------------------------*/
@@ -0,0 +1,304 @@
+/* Copyright (c) Microsoft Corporation.
+ * Licensed under the MIT License. */
+
+#include <stdbool.h>
+#include <string.h>
+
+#include "payload_compression.h"
+
+#include "unit_test.h"
+
+/*-----------------------------------------------------------*/
+
+/**
+ * @brief Reader of the bits of a compressed payload, least significant first.
+ */
+typedef struct BitReader
+{
+    const uint8_t * pucInput;
+    uint32_t ulLength;
+    uint32_t ulBitOffset;
+    bool xUnderflow;
+} BitReader_t;
+
+static PayloadCompressionContext_t xContext;
+static uint8_t ucInput[ 4096 ];
+static uint8_t ucCompressed[ 4096 ];
+static uint8_t ucInflated[ 4096 ];
+/*-----------------------------------------------------------*/
+
+static uint32_t prvGetBits( BitReader_t * pxReader,
+                            uint32_t ulCount )
+{
+    uint32_t ulBits = 0;
+    uint32_t ulIndex;
+
+    for( ulIndex = 0; ulIndex < ulCount; ulIndex++, pxReader->ulBitOffset++ )
+    {
+        if( ( pxReader->ulBitOffset / 8 ) >= pxReader->ulLength )
+        {
+            pxReader->xUnderflow = true;
+
+            return 0;
+        }
+
+        ulBits |= ( ( pxReader->pucInput[ pxReader->ulBitOffset / 8 ] >> ( pxReader->ulBitOffset % 8 ) ) & 1U ) << ulIndex;
+    }
+
+    return ulBits;
+}
+/*-----------------------------------------------------------*/
+
+/**
+ * @brief Read a Huffman code, most significant bit first.
+ */
+static uint32_t prvGetCode( BitReader_t * pxReader,
+                            uint32_t ulCount )
+{
+    uint32_t ulCode = 0;
+
+    while( ulCount-- > 0 )
+    {
+        ulCode = ( ulCode << 1 ) | prvGetBits( pxReader, 1 );
+    }
+
+    return ulCode;
+}
+/*-----------------------------------------------------------*/
+
+/**
+ * @brief Read a symbol of the fixed literal/length code.
+ */
+static uint32_t prvGetSymbol( BitReader_t * pxReader )
+{
+    uint32_t ulCode = prvGetCode( pxReader, 7 );
+
+    if( ulCode <= 0x17 )
+    {
+        return 256 + ulCode;
+    }
+
+    ulCode = ( ulCode << 1 ) | prvGetCode( pxReader, 1 );
+
+    if( ( ulCode >= 0x30 ) && ( ulCode <= 0xBF ) )
+    {
+        return ulCode - 0x30;
+    }
+
+    if( ( ulCode >= 0xC0 ) && ( ulCode <= 0xC7 ) )
+    {
+        return 280 + ( ulCode - 0xC0 );
+    }
+
+    ulCode = ( ulCode << 1 ) | prvGetCode( pxReader, 1 );
+
+    return 144 + ( ulCode - 0x190 );
+}
+/*-----------------------------------------------------------*/
+
+/**
+ * @brief Inflate a zlib stream made of blocks with the fixed Huffman codes, as
+ *  the compressor writes them, checking the header and the checksum.
+ *
+ * @return Length of the payload, or UINT32_MAX if the stream is invalid.
+ */
+static uint32_t prvInflate( const uint8_t * pucInput,
+                            uint32_t ulLength,
+                            uint8_t * pucOutput,
+                            uint32_t ulOutputSize )
+{
+    static const uint16_t usLengthBase[] =
+    {
+        3,  4,  5,  6,  7,  8,  9,  10, 11,  13,  15,  17,  19,  23, 27,
+        31, 35, 43, 51, 59, 67, 83, 99, 115, 131, 163, 195, 227, 258
+    };
+    static const uint8_t ucLengthExtra[] =
+    {
+        0, 0, 0, 0, 0, 0, 0, 0, 1, 1, 1, 1, 2, 2, 2, 2, 3, 3, 3, 3, 4, 4, 4, 4, 5, 5, 5, 5, 0
+    };
+    static const uint16_t usDistanceBase[] =
+    {
+        1,   2,   3,   4,   5,   7,    9,    13,   17,   25,   33,   49,   65,    97,    129,
+        193, 257, 385, 513, 769, 1025, 1537, 2049, 3073, 4097, 6145, 8193, 12289, 16385, 24577
+    };
+    static const uint8_t ucDistanceExtra[] =
+    {
+        0, 0, 0, 0, 1, 1, 2, 2, 3, 3, 4, 4, 5, 5, 6, 6, 7, 7, 8, 8, 9, 9, 10, 10, 11, 11, 12, 12, 13, 13
+    };
+    BitReader_t xReader = { pucInput, ulLength, 16, false };
+    uint32_t ulOutput = 0;
+    uint32_t ulSymbol;
+    uint32_t ulMatchLength;
+    uint32_t ulDistance;
+    uint32_t ulA = 1;
+    uint32_t ulB = 0;
+    uint32_t ulIndex;
+    bool xFinal;
+
+    /* Deflate with a window of at most 32 KiB, no dictionary, and a valid check. */
+    if( ( ulLength < 6 ) || ( ( pucInput[ 0 ] & 0x0F ) != 8 ) || ( ( pucInput[ 0 ] >> 4 ) > 7 ) ||
+        ( ( pucInput[ 1 ] & 0x20 ) != 0 ) || ( ( ( pucInput[ 0 ] << 8 ) | pucInput[ 1 ] ) % 31 != 0 ) )
+    {
+        return UINT32_MAX;
+    }
+
+    xReader.ulLength = ulLength - 4;
+
+    do
+    {
+        xFinal = prvGetBits( &xReader, 1 ) != 0;
+
+        if( prvGetBits( &xReader, 2 ) != 1 )
+        {
+            return UINT32_MAX;
+        }
+
+        while( !xReader.xUnderflow && ( ( ulSymbol = prvGetSymbol( &xReader ) ) != 256 ) )
+        {
+            if( ulSymbol < 256 )
+            {
+                if( ulOutput == ulOutputSize )
+                {
+                    return UINT32_MAX;
+                }
+
+                pucOutput[ ulOutput++ ] = ( uint8_t ) ulSymbol;
+                continue;
+            }
+
+            if( ( ulSymbol > 285 ) )
+            {
+                return UINT32_MAX;
+            }
+
+            ulMatchLength = usLengthBase[ ulSymbol - 257 ] + prvGetBits( &xReader, ucLengthExtra[ ulSymbol - 257 ] );
+            ulSymbol = prvGetCode( &xReader, 5 );
+
+            if( ulSymbol > 29 )
+            {
+                return UINT32_MAX;
+            }
+
+            ulDistance = usDistanceBase[ ulSymbol ] + prvGetBits( &xReader, ucDistanceExtra[ ulSymbol ] );
+
+            if( ( ulDistance > ulOutput ) || ( ulMatchLength > ulOutputSize - ulOutput ) )
+            {
+                return UINT32_MAX;
+            }
+
+            for( ; ulMatchLength > 0; ulMatchLength--, ulOutput++ )
+            {
+                pucOutput[ ulOutput ] = pucOutput[ ulOutput - ulDistance ];
+            }
+        }
+    } while( !xFinal && !xReader.xUnderflow );
+
+    /* Nothing but padding and the checksum may follow. */
+    if( xReader.xUnderflow || ( ( xReader.ulBitOffset + 7 ) / 8 != ulLength - 4 ) )
+    {
+        return UINT32_MAX;
+    }
+
+    for( ulIndex = 0; ulIndex < ulOutput; ulIndex++ )
+    {
+        ulA = ( ulA + pucOutput[ ulIndex ] ) % 65521U;
+        ulB = ( ulB + ulA ) % 65521U;
+    }
+
+    if( ( ( ulB << 16 ) | ulA ) != ( ( ( uint32_t ) pucInput[ ulLength - 4 ] << 24 ) | ( ( uint32_t ) pucInput[ ulLength - 3 ] << 16 ) |
+                                     ( ( uint32_t ) pucInput[ ulLength - 2 ] << 8 ) | pucInput[ ulLength - 1 ] ) )
+    {
+        return UINT32_MAX;
+    }
+
+    return ulOutput;
+}
+/*-----------------------------------------------------------*/
+
+/**
+ * @brief Compress a payload and check it inflates back to itself.
+ *
+ * @return Length of the compressed payload, 0 if it was not compressed.
+ */
+static uint32_t prvRoundTrip( const uint8_t * pucPayload,
+                              uint32_t ulPayloadLength )
+{
+    uint32_t ulCompressedLength;
+
+    ulCompressedLength = PayloadCompression_Deflate( &xContext, pucPayload, ulPayloadLength,
+                                                     ucCompressed, sizeof( ucCompressed ) );
+
+    if( ulCompressedLength > 0 )
+    {
+        unittestCHECK( ulCompressedLength < ulPayloadLength );
+        unittestCHECK( prvInflate( ucCompressed, ulCompressedLength, ucInflated, sizeof( ucInflated ) ) == ulPayloadLength );
+        unittestCHECK( memcmp( ucInflated, pucPayload, ulPayloadLength ) == 0 );
+    }
+
+    return ulCompressedLength;
+}
+/*-----------------------------------------------------------*/
+
+static void prvTestTelemetry( void )
+{
+    uint32_t ulLength = 0;
+    uint32_t ulIndex;
+
+    /* A batch of readings, repetitive like JSON telemetry. */
+    ucInput[ ulLength++ ] = '[';
+
+    for( ulIndex = 0; ulIndex < 60; ulIndex++ )
+    {
+        ulLength += ( uint32_t ) snprintf( ( char * ) &ucInput[ ulLength ], sizeof( ucInput ) - ulLength,
+                                           "%s{\"temperature\":%u.%u,\"humidity\":%u}",
+                                           ( ulIndex > 0 ) ? "," : "", 20 + ulIndex % 3, ulIndex % 10, 40 + ulIndex % 7 );
+    }
+
+    ucInput[ ulLength++ ] = ']';
+
+    /* Well under half, with matches at every distance the window allows. */
+    unittestCHECK( prvRoundTrip( ucInput, ulLength ) * 2 < ulLength );
+}
+/*-----------------------------------------------------------*/
+
+static void prvTestLongRuns( void )
+{
+    /* Runs longer than the longest match, and a match overlapping itself. */
+    memset( ucInput, 'a', 1000 );
+    unittestCHECK( prvRoundTrip( ucInput, 1000 ) > 0 );
+
+    memcpy( ucInput, "abcabcabcabcabcabcabcabcabcabcabcabcabcabcabcx", 46 );
+    unittestCHECK( prvRoundTrip( ucInput, 46 ) > 0 );
+}
+/*-----------------------------------------------------------*/
+
+static void prvTestNotCompressed( void )
+{
+    uint32_t ulIndex;
+
+    /* Too short, random, or not fitting the output: left as it is. */
+    unittestCHECK( PayloadCompression_Deflate( &xContext, ( const uint8_t * ) "{}", 2, ucCompressed, sizeof( ucCompressed ) ) == 0 );
+
+    for( ulIndex = 0; ulIndex < 256; ulIndex++ )
+    {
+        ucInput[ ulIndex ] = ( uint8_t ) ( ulIndex * 167 + 13 );
+    }
+
+    unittestCHECK( PayloadCompression_Deflate( &xContext, ucInput, 256, ucCompressed, sizeof( ucCompressed ) ) == 0 );
+
+    memset( ucInput, 'a', 1000 );
+    unittestCHECK( PayloadCompression_Deflate( &xContext, ucInput, 1000, ucCompressed, 4 ) == 0 );
+    unittestCHECK( PayloadCompression_Deflate( &xContext, ucInput, payloadcompressionMAX_INPUT_LENGTH + 1,
+                                               ucCompressed, sizeof( ucCompressed ) ) == 0 );
+}
+/*-----------------------------------------------------------*/
+
+int main( void )
+{
+    prvTestTelemetry();
+    prvTestLongRuns();
+    prvTestNotCompressed();
+
+    return UnitTest_Result();
+}
+/*-----------------------------------------------------------*/
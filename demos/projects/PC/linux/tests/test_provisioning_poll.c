@@ -0,0 +1,233 @@
+/* Copyright (c) Microsoft Corporation.
+ * Licensed under the MIT License. */
+
+#include <stdbool.h>
+#include <stdlib.h>
+
+#include "provisioning_poll.h"
+
+/* Kernel includes. */
+#include "FreeRTOS.h"
+#include "task.h"
+
+#include "unit_test.h"
+
+/*-----------------------------------------------------------*/
+
+#define testREGISTER_TIMEOUT_MS    ( 3000U )
+#define testJITTER_FLOOR_MS        ( 2000U )
+#define testJITTER_CEILING_MS      ( 20000U )
+#define testTIMEOUT_MS             ( 60000U )
+#define testRESPONSE_MS            ( 200U )
+
+/**
+ * @brief Device Provisioning Service, as a Provisioning client sees it.
+ *
+ * Each query is answered after testRESPONSE_MS. The registration stays
+ * assigning for ulQueriesToAssign queries, each answered with the retry-after
+ * ulRetryAfterMs, 0 for none. Like the middleware, a call to register does
+ * not query before the retry-after elapses, and waits for it within its
+ * timeout.
+ */
+typedef struct DpsEmulator
+{
+    uint32_t ulQueriesToAssign;
+    uint32_t ulRetryAfterMs;
+    AzureIoTResult_t xFinalResult;
+    uint32_t ulQueries;
+    uint32_t ulRetryAfterDeadlineMs;
+    uint32_t ulLastWaitMs;
+} DpsEmulator_t;
+
+/* Virtual time in milliseconds, moved by the emulator and by the waits. */
+static TickType_t xTickCount;
+static uint32_t ulWaitCount;
+static uint32_t ulWaitedMs[ 64 ];
+/*-----------------------------------------------------------*/
+
+TickType_t xTaskGetTickCount( void )
+{
+    return xTickCount;
+}
+/*-----------------------------------------------------------*/
+
+void vTaskDelay( TickType_t xTicksToDelay )
+{
+    if( ulWaitCount < sizeof( ulWaitedMs ) / sizeof( ulWaitedMs[ 0 ] ) )
+    {
+        ulWaitedMs[ ulWaitCount ] = xTicksToDelay;
+    }
+
+    ulWaitCount++;
+    xTickCount += xTicksToDelay;
+}
+/*-----------------------------------------------------------*/
+
+static AzureIoTResult_t prvEmulatorRegister( void * pvContext,
+                                             uint32_t ulTimeoutMs )
+{
+    DpsEmulator_t * pxDps = ( DpsEmulator_t * ) pvContext;
+    uint32_t ulWaitMs = 0;
+
+    if( pxDps->ulRetryAfterDeadlineMs > xTickCount )
+    {
+        ulWaitMs = pxDps->ulRetryAfterDeadlineMs - xTickCount;
+    }
+
+    if( ulWaitMs >= ulTimeoutMs )
+    {
+        xTickCount += ulTimeoutMs;
+
+        return eAzureIoTErrorPending;
+    }
+
+    xTickCount += ulWaitMs + testRESPONSE_MS;
+    pxDps->ulQueries++;
+
+    if( pxDps->ulQueries >= pxDps->ulQueriesToAssign )
+    {
+        return pxDps->xFinalResult;
+    }
+
+    pxDps->ulRetryAfterDeadlineMs = xTickCount + pxDps->ulRetryAfterMs;
+
+    return eAzureIoTErrorPending;
+}
+/*-----------------------------------------------------------*/
+
+static uint32_t prvEmulatorRetryAfter( void * pvContext )
+{
+    DpsEmulator_t * pxDps = ( DpsEmulator_t * ) pvContext;
+
+    return ( pxDps->ulRetryAfterDeadlineMs > xTickCount ) ? ( pxDps->ulRetryAfterDeadlineMs - xTickCount ) : 0;
+}
+/*-----------------------------------------------------------*/
+
+static AzureIoTResult_t prvRegister( DpsEmulator_t * pxDps,
+                                     ProvisioningPollStats_t * pxStats )
+{
+    ProvisioningPollConfig_t xConfig;
+
+    xConfig.ulRegisterTimeoutMs = testREGISTER_TIMEOUT_MS;
+    xConfig.ulJitterFloorMs = testJITTER_FLOOR_MS;
+    xConfig.ulJitterCeilingMs = testJITTER_CEILING_MS;
+    xConfig.ulTimeoutMs = testTIMEOUT_MS;
+    pxDps->ulQueries = 0;
+    pxDps->ulRetryAfterDeadlineMs = 0;
+    ulWaitCount = 0;
+
+    return ProvisioningPoll_Register( &xConfig, prvEmulatorRegister, prvEmulatorRetryAfter, pxDps, pxStats );
+}
+/*-----------------------------------------------------------*/
+
+static void prvTestFollowsRetryAfter( void )
+{
+    DpsEmulator_t xDps = { 4, 5000, eAzureIoTSuccess };
+    ProvisioningPollStats_t xStats;
+    uint32_t ulIndex;
+
+    /* Each wait is the retry-after, so every call queries at once and none is wasted. */
+    unittestCHECK( prvRegister( &xDps, &xStats ) == eAzureIoTSuccess );
+    unittestCHECK( xDps.ulQueries == 4 );
+    unittestCHECK( xStats.ulRegisterCalls == 4 );
+    unittestCHECK( xStats.ulRetryAfterWaits == 3 );
+    unittestCHECK( xStats.ulJitterWaits == 0 );
+    unittestCHECK( ulWaitCount == 3 );
+
+    for( ulIndex = 0; ulIndex < 3; ulIndex++ )
+    {
+        unittestCHECK( ulWaitedMs[ ulIndex ] == 5000 );
+    }
+
+    unittestCHECK( xStats.ulElapsedMs == ( 4 * testRESPONSE_MS ) + ( 3 * 5000 ) );
+}
+/*-----------------------------------------------------------*/
+
+static void prvTestShortRetryAfter( void )
+{
+    DpsEmulator_t xDps = { 6, 1000, eAzureIoTSuccess };
+    ProvisioningPollStats_t xStats;
+
+    /* A retry-after below the jitter floor is not stretched to it. */
+    unittestCHECK( prvRegister( &xDps, &xStats ) == eAzureIoTSuccess );
+    unittestCHECK( xStats.ulRegisterCalls == 6 );
+    unittestCHECK( xStats.ulJitterWaits == 0 );
+    unittestCHECK( xStats.ulElapsedMs == ( 6 * testRESPONSE_MS ) + ( 5 * 1000 ) );
+}
+/*-----------------------------------------------------------*/
+
+static void prvTestJitterWithoutRetryAfter( void )
+{
+    DpsEmulator_t xDps = { 5, 0, eAzureIoTSuccess };
+    ProvisioningPollStats_t xStats;
+    bool xDistinct = false;
+    uint32_t ulIndex;
+
+    srand( 7 );
+    unittestCHECK( prvRegister( &xDps, &xStats ) == eAzureIoTSuccess );
+    unittestCHECK( xStats.ulRegisterCalls == 5 );
+    unittestCHECK( xStats.ulRetryAfterWaits == 0 );
+    unittestCHECK( xStats.ulJitterWaits == 4 );
+
+    for( ulIndex = 0; ulIndex < 4; ulIndex++ )
+    {
+        unittestCHECK( ( ulWaitedMs[ ulIndex ] >= testJITTER_FLOOR_MS ) && ( ulWaitedMs[ ulIndex ] <= testJITTER_CEILING_MS ) );
+        xDistinct = xDistinct || ( ulWaitedMs[ ulIndex ] != ulWaitedMs[ 0 ] );
+    }
+
+    unittestCHECK( xDistinct );
+}
+/*-----------------------------------------------------------*/
+
+static void prvTestTimeout( void )
+{
+    DpsEmulator_t xDps = { UINT32_MAX, 7000, eAzureIoTSuccess };
+    ProvisioningPollStats_t xStats;
+    uint32_t ulIndex;
+
+    /* Still assigning at the timeout: pending, with no wait past it, and
+     * the last call to register waiting at most its own timeout. */
+    unittestCHECK( prvRegister( &xDps, &xStats ) == eAzureIoTErrorPending );
+    unittestCHECK( xStats.ulElapsedMs >= testTIMEOUT_MS );
+    unittestCHECK( xStats.ulElapsedMs <= testTIMEOUT_MS + testREGISTER_TIMEOUT_MS );
+    unittestCHECK( xStats.ulRegisterCalls == xStats.ulRetryAfterWaits + 1 );
+
+    for( ulIndex = 0; ulIndex + 1 < ulWaitCount; ulIndex++ )
+    {
+        unittestCHECK( ulWaitedMs[ ulIndex ] == 7000 );
+    }
+
+    unittestCHECK( ulWaitedMs[ ulWaitCount - 1 ] <= 7000 );
+
+    /* A retry-after beyond the timeout is clipped to it. */
+    xDps.ulRetryAfterMs = 10 * testTIMEOUT_MS;
+    unittestCHECK( prvRegister( &xDps, &xStats ) == eAzureIoTErrorPending );
+    unittestCHECK( xStats.ulRegisterCalls == 2 );
+    unittestCHECK( ulWaitCount == 1 );
+    unittestCHECK( ulWaitedMs[ 0 ] == testTIMEOUT_MS - testRESPONSE_MS );
+}
+/*-----------------------------------------------------------*/
+
+static void prvTestFailure( void )
+{
+    DpsEmulator_t xDps = { 3, 2000, eAzureIoTErrorServerError };
+    ProvisioningPollStats_t xStats;
+
+    /* A failed registration ends the poll at once. */
+    unittestCHECK( prvRegister( &xDps, &xStats ) == eAzureIoTErrorServerError );
+    unittestCHECK( xStats.ulRegisterCalls == 3 );
+    unittestCHECK( ulWaitCount == 2 );
+}
+/*-----------------------------------------------------------*/
+
+int main( void )
+{
+    prvTestFollowsRetryAfter();
+    prvTestShortRetryAfter();
+    prvTestJitterWithoutRetryAfter();
+    prvTestTimeout();
+    prvTestFailure();
+
+    return UnitTest_Result();
+}
+/*-----------------------------------------------------------*/
@@ -0,0 +1,219 @@
+/* Copyright (c) Microsoft Corporation.
+ * Licensed under the MIT License. */
+
+#include <string.h>
+
+#include "rate_governor.h"
+
+#include "unit_test.h"
+
+/* A message per second, so the budget is easy to follow. */
+#define testMESSAGES_PER_DAY    ( 24U * 60U * 60U )
+
+/*-----------------------------------------------------------*/
+
+static AzureIoTResult_t prvSubmit( RateGovernor_t * pxGovernor,
+                                   RateGovernorPriority_t xPriority,
+                                   const char * pcPayload,
+                                   uint64_t ullNowMs,
+                                   const uint8_t ** ppucMessage,
+                                   uint32_t * pulMessageLength )
+{
+    return RateGovernor_Submit( pxGovernor, xPriority, ( const uint8_t * ) pcPayload,
+                                ( uint32_t ) strlen( pcPayload ), ullNowMs, ppucMessage, pulMessageLength );
+}
+/*-----------------------------------------------------------*/
+
+static bool prvIsMessage( const uint8_t * pucMessage,
+                          uint32_t ulMessageLength,
+                          const char * pcExpected )
+{
+    return ( pucMessage != NULL ) && ( ulMessageLength == strlen( pcExpected ) ) &&
+           ( memcmp( pucMessage, pcExpected, ulMessageLength ) == 0 );
+}
+/*-----------------------------------------------------------*/
+
+static void prvTestArrayBatching( void )
+{
+    RateGovernor_t xGovernor;
+    uint8_t ucBuffer[ 64 ];
+    const uint8_t * pucMessage;
+    uint32_t ulMessageLength;
+
+    RateGovernor_Init( &xGovernor, eRateGovernorBatchArray, testMESSAGES_PER_DAY, 1, ucBuffer, sizeof( ucBuffer ), 0 );
+    unittestCHECK( RateGovernor_TimeToFlush( &xGovernor, 0 ) == UINT32_MAX );
+
+    /* Within budget, the payload is sent as it is. */
+    unittestCHECK( prvSubmit( &xGovernor, eRateGovernorPriorityRoutine, "{\"t\":1}", 0, &pucMessage, &ulMessageLength ) == eAzureIoTSuccess );
+    unittestCHECK( prvIsMessage( pucMessage, ulMessageLength, "{\"t\":1}" ) );
+
+    /* Then the payloads are batched until the next token. */
+    unittestCHECK( prvSubmit( &xGovernor, eRateGovernorPriorityRoutine, "{\"t\":2}", 100, &pucMessage, &ulMessageLength ) == eAzureIoTSuccess );
+    unittestCHECK( pucMessage == NULL );
+    unittestCHECK( prvSubmit( &xGovernor, eRateGovernorPriorityRoutine, "{\"t\":3}", 200, &pucMessage, &ulMessageLength ) == eAzureIoTSuccess );
+    unittestCHECK( pucMessage == NULL );
+    unittestCHECK( xGovernor.ulBatchCount == 2 );
+    unittestCHECK( RateGovernor_TimeToFlush( &xGovernor, 200 ) == 800 );
+    unittestCHECK( !RateGovernor_Flush( &xGovernor, 999, &pucMessage, &ulMessageLength ) );
+
+    unittestCHECK( RateGovernor_Flush( &xGovernor, 1000, &pucMessage, &ulMessageLength ) );
+    unittestCHECK( prvIsMessage( pucMessage, ulMessageLength, "[{\"t\":2},{\"t\":3}]" ) );
+    unittestCHECK( xGovernor.ulBatchedCount == 2 );
+    unittestCHECK( RateGovernor_TimeToFlush( &xGovernor, 1000 ) == UINT32_MAX );
+    unittestCHECK( !RateGovernor_Flush( &xGovernor, 5000, &pucMessage, &ulMessageLength ) );
+
+    /* A payload that finds a token goes out with the batch it joined. */
+    unittestCHECK( prvSubmit( &xGovernor, eRateGovernorPriorityRoutine, "{\"t\":4}", 1500, &pucMessage, &ulMessageLength ) == eAzureIoTSuccess );
+    unittestCHECK( pucMessage == NULL );
+    unittestCHECK( prvSubmit( &xGovernor, eRateGovernorPriorityRoutine, "{\"t\":5}", 2000, &pucMessage, &ulMessageLength ) == eAzureIoTSuccess );
+    unittestCHECK( prvIsMessage( pucMessage, ulMessageLength, "[{\"t\":4},{\"t\":5}]" ) );
+    unittestCHECK( xGovernor.ulBatchedCount == 4 );
+    unittestCHECK( xGovernor.ulUrgentCount == 0 );
+}
+/*-----------------------------------------------------------*/
+
+static void prvTestObjectMerge( void )
+{
+    RateGovernor_t xGovernor;
+    uint8_t ucBuffer[ 128 ];
+    const uint8_t * pucMessage;
+    uint32_t ulMessageLength;
+
+    RateGovernor_Init( &xGovernor, eRateGovernorBatchObject, testMESSAGES_PER_DAY, 1, ucBuffer, sizeof( ucBuffer ), 0 );
+    unittestCHECK( prvSubmit( &xGovernor, eRateGovernorPriorityRoutine, "{\"a\":0}", 0, &pucMessage, &ulMessageLength ) == eAzureIoTSuccess );
+    unittestCHECK( prvIsMessage( pucMessage, ulMessageLength, "{\"a\":0}" ) );
+
+    /* A later property replaces an earlier one, components merge member by
+     * member, and separators within strings are not mistaken for members. */
+    unittestCHECK( prvSubmit( &xGovernor, eRateGovernorPriorityRoutine, "{\"a\":1,\"c\":{\"x\":1,\"y\":[1,2]},\"s\":\"}\"}", 0, &pucMessage, &ulMessageLength ) == eAzureIoTSuccess );
+    unittestCHECK( pucMessage == NULL );
+    unittestCHECK( prvSubmit( &xGovernor, eRateGovernorPriorityRoutine, "{\"c\":{\"y\":3,\"z\":\"},\\\"{\"},\"a\":2}", 0, &pucMessage, &ulMessageLength ) == eAzureIoTSuccess );
+    unittestCHECK( prvSubmit( &xGovernor, eRateGovernorPriorityRoutine, "{\"b\":true,\"s\":{\"k\":\"v\"}}", 0, &pucMessage, &ulMessageLength ) == eAzureIoTSuccess );
+    unittestCHECK( xGovernor.ulBatchCount == 3 );
+
+    unittestCHECK( RateGovernor_Flush( &xGovernor, 1000, &pucMessage, &ulMessageLength ) );
+    unittestCHECK( prvIsMessage( pucMessage, ulMessageLength,
+                                 "{\"a\":2,\"c\":{\"x\":1,\"y\":3,\"z\":\"},\\\"{\"},\"s\":{\"k\":\"v\"},\"b\":true}" ) );
+    unittestCHECK( xGovernor.ulBatchedCount == 3 );
+}
+/*-----------------------------------------------------------*/
+
+/**
+ * @brief Truncated members, in the batch or the patch, are never scanned past.
+ */
+static void prvTestMalformedMerge( void )
+{
+    RateGovernor_t xGovernor;
+    uint8_t ucBuffer[ 48 ];
+    const uint8_t * pucMessage;
+    uint32_t ulMessageLength;
+    uint32_t ulIndex;
+    bool xGuardIntact = true;
+
+    /* Only the first 32 bytes are given, and nothing in the buffer closes an object. */
+    memset( ucBuffer, 'x', sizeof( ucBuffer ) );
+    RateGovernor_Init( &xGovernor, eRateGovernorBatchObject, testMESSAGES_PER_DAY, 1, ucBuffer, 32, 0 );
+    unittestCHECK( prvSubmit( &xGovernor, eRateGovernorPriorityRoutine, "{\"a\":0}", 0, &pucMessage, &ulMessageLength ) == eAzureIoTSuccess );
+
+    /* The string of the first patch of the batch runs into its end. */
+    unittestCHECK( prvSubmit( &xGovernor, eRateGovernorPriorityRoutine, "{\"a\":\"x}", 0, &pucMessage, &ulMessageLength ) == eAzureIoTSuccess );
+    unittestCHECK( prvSubmit( &xGovernor, eRateGovernorPriorityRoutine, "{\"b\":1}", 0, &pucMessage, &ulMessageLength ) == eAzureIoTSuccess );
+    unittestCHECK( xGovernor.ulBatchLength <= 32 );
+
+    for( ulIndex = 32; ulIndex < sizeof( ucBuffer ); ulIndex++ )
+    {
+        xGuardIntact = xGuardIntact && ( ucBuffer[ ulIndex ] == 'x' );
+    }
+
+    unittestCHECK( xGuardIntact );
+    unittestCHECK( RateGovernor_Flush( &xGovernor, 1000, &pucMessage, &ulMessageLength ) );
+
+    /* A truncated member of a patch is dropped, the members before it are merged. */
+    unittestCHECK( prvSubmit( &xGovernor, eRateGovernorPriorityRoutine, "{\"a\":1}", 1000, &pucMessage, &ulMessageLength ) == eAzureIoTSuccess );
+    unittestCHECK( pucMessage == NULL );
+    unittestCHECK( prvSubmit( &xGovernor, eRateGovernorPriorityRoutine, "{\"a\":2,\"b}", 1000, &pucMessage, &ulMessageLength ) == eAzureIoTSuccess );
+    unittestCHECK( RateGovernor_Flush( &xGovernor, 2000, &pucMessage, &ulMessageLength ) );
+    unittestCHECK( prvIsMessage( pucMessage, ulMessageLength, "{\"a\":2}" ) );
+}
+/*-----------------------------------------------------------*/
+
+static void prvTestUrgent( void )
+{
+    RateGovernor_t xGovernor;
+    uint8_t ucBuffer[ 64 ];
+    const uint8_t * pucMessage;
+    uint32_t ulMessageLength;
+
+    RateGovernor_Init( &xGovernor, eRateGovernorBatchArray, testMESSAGES_PER_DAY, 1, ucBuffer, sizeof( ucBuffer ), 0 );
+
+    /* Without a batch, an urgent payload is sent as it is, borrowing. */
+    unittestCHECK( prvSubmit( &xGovernor, eRateGovernorPriorityRoutine, "{\"r\":1}", 0, &pucMessage, &ulMessageLength ) == eAzureIoTSuccess );
+    unittestCHECK( prvSubmit( &xGovernor, eRateGovernorPriorityUrgent, "{\"u\":1}", 0, &pucMessage, &ulMessageLength ) == eAzureIoTSuccess );
+    unittestCHECK( prvIsMessage( pucMessage, ulMessageLength, "{\"u\":1}" ) );
+    unittestCHECK( xGovernor.ulUrgentCount == 1 );
+
+    /* The routine payloads after it wait for the debt to be repaid. */
+    unittestCHECK( prvSubmit( &xGovernor, eRateGovernorPriorityRoutine, "{\"r\":2}", 1000, &pucMessage, &ulMessageLength ) == eAzureIoTSuccess );
+    unittestCHECK( pucMessage == NULL );
+    unittestCHECK( RateGovernor_TimeToFlush( &xGovernor, 1000 ) == 1000 );
+
+    /* With a batch, the urgent payload takes it along, after its payloads. */
+    unittestCHECK( prvSubmit( &xGovernor, eRateGovernorPriorityUrgent, "{\"u\":2}", 1000, &pucMessage, &ulMessageLength ) == eAzureIoTSuccess );
+    unittestCHECK( prvIsMessage( pucMessage, ulMessageLength, "[{\"r\":2},{\"u\":2}]" ) );
+    unittestCHECK( xGovernor.ulUrgentCount == 2 );
+    unittestCHECK( xGovernor.ulBatchCount == 0 );
+    unittestCHECK( RateGovernor_TimeToFlush( &xGovernor, 1000 ) == UINT32_MAX );
+
+    /* Messages sent outside of the governor borrow as well. */
+    RateGovernor_Charge( &xGovernor, 1000 );
+    unittestCHECK( xGovernor.ulUrgentCount == 3 );
+    unittestCHECK( prvSubmit( &xGovernor, eRateGovernorPriorityRoutine, "{\"r\":3}", 1000, &pucMessage, &ulMessageLength ) == eAzureIoTSuccess );
+    unittestCHECK( RateGovernor_TimeToFlush( &xGovernor, 1000 ) == 3000 );
+}
+/*-----------------------------------------------------------*/
+
+static void prvTestFullBatch( void )
+{
+    RateGovernor_t xGovernor;
+    uint8_t ucBuffer[ 20 ];
+    const uint8_t * pucMessage;
+    uint32_t ulMessageLength;
+
+    RateGovernor_Init( &xGovernor, eRateGovernorBatchArray, testMESSAGES_PER_DAY, 1, ucBuffer, sizeof( ucBuffer ), 0 );
+    unittestCHECK( prvSubmit( &xGovernor, eRateGovernorPriorityRoutine, "{\"r\":1}", 0, &pucMessage, &ulMessageLength ) == eAzureIoTSuccess );
+    unittestCHECK( prvSubmit( &xGovernor, eRateGovernorPriorityRoutine, "{\"r\":2}", 0, &pucMessage, &ulMessageLength ) == eAzureIoTSuccess );
+    unittestCHECK( prvSubmit( &xGovernor, eRateGovernorPriorityRoutine, "{\"r\":3}", 0, &pucMessage, &ulMessageLength ) == eAzureIoTSuccess );
+
+    /* A payload that does not fit is neither sent nor batched, the batch is kept. */
+    unittestCHECK( prvSubmit( &xGovernor, eRateGovernorPriorityRoutine, "{\"r\":4}", 0, &pucMessage, &ulMessageLength ) == eAzureIoTErrorOutOfMemory );
+    unittestCHECK( xGovernor.ulBatchCount == 2 );
+
+    /* An urgent payload that does not fit flushes the batch ahead of it, and
+     * is to be submitted again. */
+    unittestCHECK( prvSubmit( &xGovernor, eRateGovernorPriorityUrgent, "{\"u\":1}", 0, &pucMessage, &ulMessageLength ) == eAzureIoTErrorOutOfMemory );
+    unittestCHECK( prvIsMessage( pucMessage, ulMessageLength, "[{\"r\":2},{\"r\":3}]" ) );
+    unittestCHECK( xGovernor.ulUrgentCount == 0 );
+    unittestCHECK( prvSubmit( &xGovernor, eRateGovernorPriorityUrgent, "{\"u\":1}", 0, &pucMessage, &ulMessageLength ) == eAzureIoTSuccess );
+    unittestCHECK( prvIsMessage( pucMessage, ulMessageLength, "{\"u\":1}" ) );
+    unittestCHECK( xGovernor.ulUrgentCount == 1 );
+    unittestCHECK( xGovernor.ulBatchedCount == 2 );
+
+    /* An object patch larger than the buffer is refused as well. */
+    RateGovernor_Init( &xGovernor, eRateGovernorBatchObject, testMESSAGES_PER_DAY, 1, ucBuffer, sizeof( ucBuffer ), 0 );
+    unittestCHECK( prvSubmit( &xGovernor, eRateGovernorPriorityRoutine, "{\"a\":1}", 0, &pucMessage, &ulMessageLength ) == eAzureIoTSuccess );
+    unittestCHECK( prvSubmit( &xGovernor, eRateGovernorPriorityRoutine, "{\"a\":\"0123456789abcdef\"}", 0, &pucMessage, &ulMessageLength ) == eAzureIoTErrorOutOfMemory );
+    unittestCHECK( xGovernor.ulBatchCount == 0 );
+}
+/*-----------------------------------------------------------*/
+
+int main( void )
+{
+    prvTestArrayBatching();
+    prvTestObjectMerge();
+    prvTestMalformedMerge();
+    prvTestUrgent();
+    prvTestFullBatch();
+
+    return UnitTest_Result();
+}
+/*-----------------------------------------------------------*/
@@ -0,0 +1,175 @@
+/* Copyright (c) Microsoft Corporation.
+ * Licensed under the MIT License. */
+
+#include <stdbool.h>
+#include <stdlib.h>
+
+#include "reading_history.h"
+
+#include "unit_test.h"
+
+/*-----------------------------------------------------------*/
+
+#define testREADINGS    ( 5U * readinghistoryCAPACITY + 7U )
+
+/* Every reading added, to compute the statistics of a window directly. */
+static uint64_t ullReferenceTimes[ testREADINGS ];
+static double xReferenceValues[ testREADINGS ];
+static uint32_t ulReferenceCount;
+/*-----------------------------------------------------------*/
+
+static void prvAdd( ReadingHistory_t * pxHistory,
+                    uint64_t ullTime,
+                    double xValue )
+{
+    ReadingHistory_Add( pxHistory, ullTime, xValue );
+
+    if( ( ulReferenceCount > 0 ) && ( ullTime < ullReferenceTimes[ ulReferenceCount - 1 ] ) )
+    {
+        ullTime = ullReferenceTimes[ ulReferenceCount - 1 ];
+    }
+
+    ullReferenceTimes[ ulReferenceCount ] = ullTime;
+    xReferenceValues[ ulReferenceCount ] = xValue;
+    ulReferenceCount++;
+}
+/*-----------------------------------------------------------*/
+
+/**
+ * @brief Check a query against a scan of the readings retained.
+ */
+static bool prvQueryMatches( const ReadingHistory_t * pxHistory,
+                             uint64_t ullSince )
+{
+    ReadingHistoryStats_t xStats;
+    uint32_t ulFirst = ( ulReferenceCount > readinghistoryCAPACITY ) ? ulReferenceCount - readinghistoryCAPACITY : 0;
+    uint32_t ulIndex;
+    uint32_t ulCount = 0;
+    double xMinimum = 0.0;
+    double xMaximum = 0.0;
+    double xSum = 0.0;
+    bool xFound;
+
+    while( ( ulFirst < ulReferenceCount ) && ( ullReferenceTimes[ ulFirst ] < ullSince ) )
+    {
+        ulFirst++;
+    }
+
+    for( ulIndex = ulFirst; ulIndex < ulReferenceCount; ulIndex++ )
+    {
+        if( ( ulCount == 0 ) || ( xReferenceValues[ ulIndex ] < xMinimum ) )
+        {
+            xMinimum = xReferenceValues[ ulIndex ];
+        }
+
+        if( ( ulCount == 0 ) || ( xReferenceValues[ ulIndex ] > xMaximum ) )
+        {
+            xMaximum = xReferenceValues[ ulIndex ];
+        }
+
+        xSum += xReferenceValues[ ulIndex ];
+        ulCount++;
+    }
+
+    xFound = ReadingHistory_Query( pxHistory, ullSince, &xStats );
+
+    if( ulCount == 0 )
+    {
+        return !xFound;
+    }
+
+    return xFound && ( xStats.ulCount == ulCount ) &&
+           ( xStats.xMinimum == xMinimum ) && ( xStats.xMaximum == xMaximum ) &&
+           ( fabs( xStats.xAverage - xSum / ulCount ) <= 1e-9 ) &&
+           ( xStats.ullStartTime == ullReferenceTimes[ ulFirst ] ) &&
+           ( xStats.ullEndTime == ullReferenceTimes[ ulReferenceCount - 1 ] );
+}
+/*-----------------------------------------------------------*/
+
+static void prvTestWindows( void )
+{
+    static ReadingHistory_t xHistory;
+    ReadingHistoryStats_t xStats;
+
+    ReadingHistory_Init( &xHistory );
+    ulReferenceCount = 0;
+
+    unittestCHECK( !ReadingHistory_Query( &xHistory, 0, &xStats ) );
+
+    prvAdd( &xHistory, 100, 21.5 );
+    unittestCHECK( ReadingHistory_Query( &xHistory, 0, &xStats ) );
+    unittestCHECK( xStats.ulCount == 1 );
+    unittestCHECK( xStats.xMinimum == 21.5 );
+    unittestCHECK( xStats.xMaximum == 21.5 );
+    unittestCHECK( xStats.xAverage == 21.5 );
+    unittestCHECK( xStats.ullStartTime == 100 );
+    unittestCHECK( xStats.ullEndTime == 100 );
+    unittestCHECK( ReadingHistory_Query( &xHistory, 100, &xStats ) );
+    unittestCHECK( !ReadingHistory_Query( &xHistory, 101, &xStats ) );
+
+    prvAdd( &xHistory, 110, 18.0 );
+    prvAdd( &xHistory, 110, 25.0 );
+    prvAdd( &xHistory, 120, 19.0 );
+
+    /* Readings of the same time are all in the window that starts at it. */
+    unittestCHECK( ReadingHistory_Query( &xHistory, 101, &xStats ) );
+    unittestCHECK( xStats.ulCount == 3 );
+    unittestCHECK( xStats.xMinimum == 18.0 );
+    unittestCHECK( xStats.xMaximum == 25.0 );
+    unittestCHECK_NEAR( xStats.xAverage, 62.0 / 3, 1e-12 );
+    unittestCHECK( xStats.ullStartTime == 110 );
+    unittestCHECK( xStats.ullEndTime == 120 );
+
+    /* An earlier time is taken as the time of the last reading. */
+    prvAdd( &xHistory, 50, -3.0 );
+    unittestCHECK( ReadingHistory_Query( &xHistory, 120, &xStats ) );
+    unittestCHECK( xStats.ulCount == 2 );
+    unittestCHECK( xStats.xMinimum == -3.0 );
+    unittestCHECK( xStats.ullEndTime == 120 );
+    unittestCHECK( prvQueryMatches( &xHistory, 0 ) );
+}
+/*-----------------------------------------------------------*/
+
+/**
+ * @brief Random readings over several turns of the ring, every window checked after each.
+ */
+static void prvTestRing( void )
+{
+    static ReadingHistory_t xHistory;
+    uint64_t ullTime = 1000;
+    uint64_t ullSince;
+    uint32_t ulFailures = 0;
+    uint32_t ulIndex;
+
+    ReadingHistory_Init( &xHistory );
+    ulReferenceCount = 0;
+    srand( 7 );
+
+    for( ulIndex = 0; ulIndex < testREADINGS; ulIndex++ )
+    {
+        /* Gaps of 0 to 4 seconds, so some readings share a time. */
+        ullTime += ( uint64_t ) ( rand() % 5 );
+        prvAdd( &xHistory, ullTime, ( double ) ( rand() % 2001 - 1000 ) / 10.0 );
+
+        for( ullSince = 990; ullSince <= ullTime + 1; ullSince += 1 + ( ullTime - 990 ) / 64 )
+        {
+            ulFailures += prvQueryMatches( &xHistory, ullSince ) ? 0 : 1;
+        }
+
+        ulFailures += prvQueryMatches( &xHistory, ullTime ) ? 0 : 1;
+        ulFailures += prvQueryMatches( &xHistory, ullTime + 1 ) ? 0 : 1;
+    }
+
+    unittestCHECK( xHistory.ulCount == readinghistoryCAPACITY );
+    unittestCHECK( ulFailures == 0 );
+}
+/*-----------------------------------------------------------*/
+
+int main( void )
+{
+    prvTestWindows();
+    prvTestRing();
+
+    return UnitTest_Result();
+}
+/*-----------------------------------------------------------*/
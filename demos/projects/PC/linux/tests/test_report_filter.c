@@ -0,0 +1,83 @@
+/* Copyright (c) Microsoft Corporation.
+ * Licensed under the MIT License. */
+
+#include "report_filter.h"
+
+#include "unit_test.h"
+
+/*-----------------------------------------------------------*/
+
+static void prvTestDeadband( void )
+{
+    /* Field 0: 0.5 absolute. Field 1: 10% relative, at least 0.1. Field 2: any change. */
+    const ReportFilterRule_t xRules[] =
+    {
+        { 0.5, 0.0, 0, 0 },
+        { 0.1, 0.1, 0, 0 },
+        { 0.0, 0.0, 0, 0 }
+    };
+    ReportFilterField_t xFields[ 3 ];
+    ReportFilter_t xFilter;
+
+    ReportFilter_Init( &xFilter, xRules, xFields, 3 );
+
+    /* The first value is always reported. */
+    unittestCHECK( ReportFilter_Update( &xFilter, 0, 0, 20.0 ) );
+    unittestCHECK( !ReportFilter_Update( &xFilter, 0, 1, 20.4 ) );
+    unittestCHECK( !ReportFilter_Update( &xFilter, 0, 2, 19.5 ) );
+    unittestCHECK( ReportFilter_Update( &xFilter, 0, 3, 20.6 ) );
+
+    /* Measured from the value last reported, not the last one seen. */
+    unittestCHECK( !ReportFilter_Update( &xFilter, 0, 4, 21.0 ) );
+    unittestCHECK( ReportFilter_Update( &xFilter, 0, 5, 20.0 ) );
+
+    /* 10% of 100 is 10, 10% of 0.5 is below the 0.1 floor. */
+    unittestCHECK( ReportFilter_Update( &xFilter, 1, 0, 100.0 ) );
+    unittestCHECK( !ReportFilter_Update( &xFilter, 1, 1, 109.0 ) );
+    unittestCHECK( !ReportFilter_Update( &xFilter, 1, 2, 91.0 ) );
+    unittestCHECK( ReportFilter_Update( &xFilter, 1, 3, 111.0 ) );
+    unittestCHECK( ReportFilter_Update( &xFilter, 1, 4, 0.5 ) );
+    unittestCHECK( !ReportFilter_Update( &xFilter, 1, 5, 0.55 ) );
+    unittestCHECK( ReportFilter_Update( &xFilter, 1, 6, 0.65 ) );
+
+    unittestCHECK( ReportFilter_Update( &xFilter, 2, 0, 1.0 ) );
+    unittestCHECK( !ReportFilter_Update( &xFilter, 2, 1, 1.0 ) );
+    unittestCHECK( ReportFilter_Update( &xFilter, 2, 2, 1.0000001 ) );
+
+    /* A NaN is always reported, and so is the value after it. */
+    unittestCHECK( ReportFilter_Update( &xFilter, 0, 6, NAN ) );
+    unittestCHECK( ReportFilter_Update( &xFilter, 0, 7, 20.0 ) );
+}
+/*-----------------------------------------------------------*/
+
+static void prvTestIntervals( void )
+{
+    /* Any change, at most every 10, and at least every 100. */
+    const ReportFilterRule_t xRule = { 0.0, 0.0, 10, 100 };
+    ReportFilterField_t xField;
+    ReportFilter_t xFilter;
+
+    ReportFilter_Init( &xFilter, &xRule, &xField, 1 );
+
+    unittestCHECK( ReportFilter_Update( &xFilter, 0, 1000, 1.0 ) );
+    unittestCHECK( !ReportFilter_Update( &xFilter, 0, 1005, 2.0 ) );
+    unittestCHECK( ReportFilter_Update( &xFilter, 0, 1010, 2.0 ) );
+
+    /* Unchanged, until the heartbeat. */
+    unittestCHECK( !ReportFilter_Update( &xFilter, 0, 1050, 2.0 ) );
+    unittestCHECK( !ReportFilter_Update( &xFilter, 0, 1109, 2.0 ) );
+    unittestCHECK( ReportFilter_Update( &xFilter, 0, 1110, 2.0 ) );
+
+    /* A time before the last report counts as no time elapsed. */
+    unittestCHECK( !ReportFilter_Update( &xFilter, 0, 500, 3.0 ) );
+}
+/*-----------------------------------------------------------*/
+
+int main( void )
+{
+    prvTestDeadband();
+    prvTestIntervals();
+
+    return UnitTest_Result();
+}
+/*-----------------------------------------------------------*/
@@ -0,0 +1,250 @@
+/* Copyright (c) Microsoft Corporation.
+ * Licensed under the MIT License. */
+
+#include <stdbool.h>
+#include <stdio.h>
+#include <string.h>
+
+#include "sas_token_cache.h"
+
+/* Crypto helper header. */
+#include "crypto.h"
+
+#include "unit_test.h"
+
+/*-----------------------------------------------------------*/
+
+#define testHMAC_LENGTH    ( 32U )
+
+static const uint8_t ucKey[] = "device-key";
+static const uint8_t ucOtherKey[] = "other-key";
+
+/* Virtual clock, in Unix seconds. */
+static uint64_t ullNow = 1700000000U;
+
+/* Calls to the fake Crypto_HMAC(), and whether it fails. */
+static uint32_t ulHMACCalls;
+static bool xHMACFails;
+/*-----------------------------------------------------------*/
+
+uint64_t ullGetUnixTime( void )
+{
+    return ullNow;
+}
+/*-----------------------------------------------------------*/
+
+/**
+ * @brief Signature that depends on every byte of the key and the data, not a real HMAC.
+ */
+uint32_t Crypto_HMAC( const uint8_t * pucKey,
+                      uint32_t ulKeyLength,
+                      const uint8_t * pucData,
+                      uint32_t ulDataLength,
+                      uint8_t * pucOutput,
+                      uint32_t ulOutputLength,
+                      uint32_t * pulBytesCopied )
+{
+    uint32_t ulHash = 2166136261U;
+    uint32_t ulIndex;
+
+    ulHMACCalls++;
+
+    if( xHMACFails || ( ulOutputLength < testHMAC_LENGTH ) )
+    {
+        return 1;
+    }
+
+    for( ulIndex = 0; ulIndex < ulKeyLength + ulDataLength + testHMAC_LENGTH; ulIndex++ )
+    {
+        if( ulIndex < ulKeyLength )
+        {
+            ulHash ^= pucKey[ ulIndex ];
+        }
+        else if( ulIndex < ulKeyLength + ulDataLength )
+        {
+            ulHash ^= pucData[ ulIndex - ulKeyLength ];
+        }
+        else
+        {
+            pucOutput[ ulIndex - ulKeyLength - ulDataLength ] = ( uint8_t ) ( ulHash >> 24 );
+        }
+
+        ulHash *= 16777619U;
+    }
+
+    *pulBytesCopied = testHMAC_LENGTH;
+
+    return 0;
+}
+/*-----------------------------------------------------------*/
+
+/**
+ * @brief Sign a token for a connection made now, as the middleware does.
+ */
+static uint32_t prvSignToken( const uint8_t * pucSigningKey,
+                              uint32_t ulSigningKeyLength,
+                              uint8_t * pucSignature,
+                              uint64_t * pullExpiry )
+{
+    char cData[ 96 ];
+    uint32_t ulDataLength;
+    uint32_t ulLength = 0;
+
+    *pullExpiry = SASTokenCache_GetTime() + sastokencacheTOKEN_LIFETIME_SEC;
+    ulDataLength = ( uint32_t ) snprintf( cData, sizeof( cData ), "hub.azure-devices.net/devices/dev\n%llu",
+                                          ( unsigned long long ) *pullExpiry );
+
+    return ( SASTokenCache_HMAC( pucSigningKey, ulSigningKeyLength, ( const uint8_t * ) cData, ulDataLength,
+                                 pucSignature, testHMAC_LENGTH, &ulLength ) == 0 ) &&
+           ( ulLength == testHMAC_LENGTH ) ? 0 : 1;
+}
+/*-----------------------------------------------------------*/
+
+static void prvTestRetriesHitCache( void )
+{
+    uint8_t ucFirst[ testHMAC_LENGTH ];
+    uint8_t ucSignature[ testHMAC_LENGTH ];
+    uint64_t ullFirstExpiry;
+    uint64_t ullExpiry;
+    uint32_t ulRetry;
+
+    SASTokenCache_Clear();
+    ulHMACCalls = 0;
+    ullNow = 1700000000U - ( 1700000000U % sastokencacheTIME_QUANTUM_SEC );
+
+    /* Retries within a quantum sign the same expiry, once. */
+    unittestCHECK( prvSignToken( ucKey, sizeof( ucKey ) - 1, ucFirst, &ullFirstExpiry ) == 0 );
+
+    for( ulRetry = 1; ulRetry * 7U < sastokencacheTIME_QUANTUM_SEC; ulRetry++ )
+    {
+        ullNow += 7U;
+        unittestCHECK( prvSignToken( ucKey, sizeof( ucKey ) - 1, ucSignature, &ullExpiry ) == 0 );
+        unittestCHECK( ullExpiry == ullFirstExpiry );
+        unittestCHECK( memcmp( ucSignature, ucFirst, testHMAC_LENGTH ) == 0 );
+    }
+
+    unittestCHECK( ulHMACCalls == 1 );
+
+    /* The next quantum moves the expiry and signs again. */
+    ullNow += 7U;
+    unittestCHECK( prvSignToken( ucKey, sizeof( ucKey ) - 1, ucSignature, &ullExpiry ) == 0 );
+    unittestCHECK( ullExpiry == ullFirstExpiry + sastokencacheTIME_QUANTUM_SEC );
+    unittestCHECK( memcmp( ucSignature, ucFirst, testHMAC_LENGTH ) != 0 );
+    unittestCHECK( ulHMACCalls == 2 );
+}
+/*-----------------------------------------------------------*/
+
+static void prvTestRenewalBeforeExpiry( void )
+{
+    uint8_t ucSignature[ testHMAC_LENGTH ];
+    uint64_t ullIssue;
+    uint64_t ullExpiry;
+    uint64_t ullRenewal;
+    uint64_t ullEnd;
+    uint32_t ulConnections = 0;
+
+    SASTokenCache_Clear();
+    ulHMACCalls = 0;
+    ullNow = 1700000123U;
+    ullEnd = ullNow + ( 3U * 24U * 60U * 60U );
+
+    /* A device that connects, and reconnects when its token is due for renewal,
+     * at any second of a quantum, over three days. */
+    while( ullNow < ullEnd )
+    {
+        ullIssue = SASTokenCache_GetTime();
+        unittestCHECK( prvSignToken( ucKey, sizeof( ucKey ) - 1, ucSignature, &ullExpiry ) == 0 );
+        ulConnections++;
+
+        /* The clock is rounded down by less than one quantum. */
+        unittestCHECK( ( ullIssue <= ullNow ) && ( ullNow - ullIssue < sastokencacheTIME_QUANTUM_SEC ) );
+        unittestCHECK( ullExpiry - ullNow > sastokencacheTOKEN_LIFETIME_SEC - sastokencacheTIME_QUANTUM_SEC );
+
+        /* Renewal is ahead, and at least a quantum before the token lapses. */
+        ullRenewal = SASTokenCache_RenewalTime( ullIssue );
+        unittestCHECK( ullRenewal > ullNow );
+        unittestCHECK( ullRenewal + sastokencacheTIME_QUANTUM_SEC <= ullExpiry );
+
+        /* Reconnect at the renewal, a little later every time. */
+        ullNow = ullRenewal + ( ulConnections % 13U ) * 23U;
+        unittestCHECK( ullNow < ullExpiry );
+    }
+
+    /* Each renewal signs a new expiry. */
+    unittestCHECK( ulHMACCalls == ulConnections );
+    unittestCHECK( ulConnections >= ( 3U * 24U * 60U * 60U ) / sastokencacheTOKEN_LIFETIME_SEC );
+}
+/*-----------------------------------------------------------*/
+
+static void prvTestEntries( void )
+{
+    uint8_t ucSignature[ testHMAC_LENGTH ];
+    uint8_t ucOther[ testHMAC_LENGTH ];
+    uint8_t ucLongKey[ sastokencacheMAX_KEY_LENGTH + 1 ] = { 0 };
+    uint64_t ullExpiry;
+
+    SASTokenCache_Clear();
+    ulHMACCalls = 0;
+
+    /* Two keys in use, such as DPS and IoT Hub, both stay cached. */
+    unittestCHECK( prvSignToken( ucKey, sizeof( ucKey ) - 1, ucSignature, &ullExpiry ) == 0 );
+    unittestCHECK( prvSignToken( ucOtherKey, sizeof( ucOtherKey ) - 1, ucOther, &ullExpiry ) == 0 );
+    unittestCHECK( memcmp( ucSignature, ucOther, testHMAC_LENGTH ) != 0 );
+    unittestCHECK( prvSignToken( ucKey, sizeof( ucKey ) - 1, ucSignature, &ullExpiry ) == 0 );
+    unittestCHECK( prvSignToken( ucOtherKey, sizeof( ucOtherKey ) - 1, ucOther, &ullExpiry ) == 0 );
+    unittestCHECK( ulHMACCalls == 2 );
+
+    /* A third one replaces the oldest entry. */
+    unittestCHECK( prvSignToken( ucLongKey, 8, ucOther, &ullExpiry ) == 0 );
+    unittestCHECK( prvSignToken( ucOtherKey, sizeof( ucOtherKey ) - 1, ucOther, &ullExpiry ) == 0 );
+    unittestCHECK( ulHMACCalls == 3 );
+    unittestCHECK( prvSignToken( ucKey, sizeof( ucKey ) - 1, ucSignature, &ullExpiry ) == 0 );
+    unittestCHECK( ulHMACCalls == 4 );
+
+    /* Keys too long to cache are signed every time. */
+    unittestCHECK( prvSignToken( ucLongKey, sizeof( ucLongKey ), ucSignature, &ullExpiry ) == 0 );
+    unittestCHECK( prvSignToken( ucLongKey, sizeof( ucLongKey ), ucSignature, &ullExpiry ) == 0 );
+    unittestCHECK( ulHMACCalls == 6 );
+
+    /* After a clear, such as a key change, every key is signed again. */
+    SASTokenCache_Clear();
+    unittestCHECK( prvSignToken( ucKey, sizeof( ucKey ) - 1, ucSignature, &ullExpiry ) == 0 );
+    unittestCHECK( ulHMACCalls == 7 );
+}
+/*-----------------------------------------------------------*/
+
+static void prvTestFailures( void )
+{
+    uint8_t ucSignature[ testHMAC_LENGTH ];
+    uint32_t ulLength;
+    uint64_t ullExpiry;
+
+    SASTokenCache_Clear();
+    ulHMACCalls = 0;
+
+    /* A failed signature is not cached. */
+    xHMACFails = true;
+    unittestCHECK( prvSignToken( ucKey, sizeof( ucKey ) - 1, ucSignature, &ullExpiry ) != 0 );
+    xHMACFails = false;
+    unittestCHECK( prvSignToken( ucKey, sizeof( ucKey ) - 1, ucSignature, &ullExpiry ) == 0 );
+    unittestCHECK( ulHMACCalls == 2 );
+
+    /* A cached signature larger than the output is left to Crypto_HMAC() to refuse. */
+    unittestCHECK( SASTokenCache_HMAC( ucKey, sizeof( ucKey ) - 1, ( const uint8_t * ) "d", 1,
+                                       ucSignature, testHMAC_LENGTH, &ulLength ) == 0 );
+    unittestCHECK( SASTokenCache_HMAC( ucKey, sizeof( ucKey ) - 1, ( const uint8_t * ) "d", 1,
+                                       ucSignature, testHMAC_LENGTH - 1, &ulLength ) != 0 );
+    unittestCHECK( ulHMACCalls == 4 );
+}
+/*-----------------------------------------------------------*/
+
+int main( void )
+{
+    prvTestRetriesHitCache();
+    prvTestRenewalBeforeExpiry();
+    prvTestEntries();
+    prvTestFailures();
+
+    return UnitTest_Result();
+}
+/*-----------------------------------------------------------*/
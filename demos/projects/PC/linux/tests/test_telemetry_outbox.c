@@ -0,0 +1,346 @@
+/* Copyright (c) Microsoft Corporation.
+ * Licensed under the MIT License. */
+
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "telemetry_outbox.h"
+
+#include "unit_test.h"
+
+/*-----------------------------------------------------------*/
+
+/* Messages of the stress test, each with its class, creation and acknowledgement times. */
+#define testMESSAGE_COUNT    ( 40000U )
+
+/* Link of the stress test, in ticks of 10 ms. */
+#define testLINK_CAPACITY    ( 2U )   /* Messages sent per tick. */
+#define testRTT_TICKS        ( 8U )   /* From sending a message to its PUBACK. */
+#define testLINK_QUEUE       ( 1024U )
+
+/* Load and outages of the stress test. */
+#define testTICKS              ( 20000U )
+#define testROUTINE_PERCENT    ( 75U )  /* Chance of a routine message each tick. */
+#define testURGENT_PERIOD      ( 37U )  /* Ticks between two command responses. */
+#define testOUTAGE_PERIOD      ( 400U ) /* Ticks between two outages. */
+#define testOUTAGE_TICKS       ( 150U )
+
+typedef struct TestMessage
+{
+    TelemetryOutboxClass_t xClass;
+    uint32_t ulCreatedTick;
+    uint32_t ulAckedTick;
+    bool xAcked;
+} TestMessage_t;
+
+typedef struct TestPacket
+{
+    uint32_t ulMessage;
+    uint16_t usPacketID;
+    uint32_t ulAckTick; /**< Once sent. */
+} TestPacket_t;
+
+static TestMessage_t xMessages[ testMESSAGE_COUNT ];
+
+/* Packets waiting to be sent, then waiting for their PUBACK, in order. */
+static TestPacket_t xQueue[ testLINK_QUEUE ];
+static uint32_t ulQueueHead;
+static uint32_t ulQueueSent;
+static uint32_t ulQueueTail;
+
+static uint16_t usNextPacketID;
+static AzureIoTResult_t xSendResult;
+
+/* Payloads sent, for the unit tests. */
+static char cSent[ 16 ][ 8 ];
+static uint32_t ulSentCount;
+/*-----------------------------------------------------------*/
+
+AzureIoTResult_t AzureIoTHubClient_SendTelemetry( AzureIoTHubClient_t * pxAzureIoTHubClient,
+                                                  const uint8_t * pucTelemetryData,
+                                                  uint32_t ulTelemetryDataLength,
+                                                  AzureIoTMessageProperties_t * pxProperties,
+                                                  AzureIoTHubMessageQoS_t xQOS,
+                                                  uint16_t * pusTelemetryPacketID )
+{
+    TestPacket_t * pxPacket;
+    uint32_t ulMessage;
+
+    ( void ) pxAzureIoTHubClient;
+    ( void ) pxProperties;
+    unittestCHECK( xQOS == eAzureIoTHubMessageQoS1 );
+
+    if( xSendResult != eAzureIoTSuccess )
+    {
+        return xSendResult;
+    }
+
+    if( ++usNextPacketID == 0 )
+    {
+        usNextPacketID = 1;
+    }
+
+    *pusTelemetryPacketID = usNextPacketID;
+
+    if( ulSentCount < sizeof( cSent ) / sizeof( cSent[ 0 ] ) )
+    {
+        ( void ) snprintf( cSent[ ulSentCount ], sizeof( cSent[ 0 ] ), "%.*s", ( int ) ulTelemetryDataLength, pucTelemetryData );
+    }
+
+    ulSentCount++;
+
+    /* Payloads of the stress test are the index of their message. */
+    if( ( ulTelemetryDataLength == sizeof( ulMessage ) ) && ( ulQueueTail - ulQueueHead < testLINK_QUEUE ) )
+    {
+        memcpy( &ulMessage, pucTelemetryData, sizeof( ulMessage ) );
+        pxPacket = &xQueue[ ulQueueTail++ % testLINK_QUEUE ];
+        pxPacket->ulMessage = ulMessage;
+        pxPacket->usPacketID = usNextPacketID;
+    }
+
+    return eAzureIoTSuccess;
+}
+/*-----------------------------------------------------------*/
+
+static AzureIoTResult_t prvAdd( TelemetryOutbox_t * pxOutbox,
+                                TelemetryOutboxClass_t xClass,
+                                uint16_t usPacketID,
+                                const char * pcPayload )
+{
+    return TelemetryOutbox_Add( pxOutbox, xClass, usPacketID, ( const uint8_t * ) pcPayload, strlen( pcPayload ), NULL );
+}
+/*-----------------------------------------------------------*/
+
+static void prvTestClassLimits( void )
+{
+    static TelemetryOutbox_t xOutbox;
+    static uint8_t ucLarge[ telemetryoutboxSLOT_SIZE + 1 ];
+    uint32_t ulIndex;
+
+    TelemetryOutbox_Init( &xOutbox );
+
+    /* Routine messages stop short of the last slot. */
+    for( ulIndex = 0; ulIndex < telemetryoutboxROUTINE_SLOT_LIMIT; ulIndex++ )
+    {
+        unittestCHECK( prvAdd( &xOutbox, eTelemetryOutboxClassRoutine, ( uint16_t ) ( ulIndex + 1 ), "r" ) == eAzureIoTSuccess );
+    }
+
+    unittestCHECK( prvAdd( &xOutbox, eTelemetryOutboxClassRoutine, 10, "r" ) == eAzureIoTErrorOutOfMemory );
+    unittestCHECK( TelemetryOutbox_GetClassCount( &xOutbox, eTelemetryOutboxClassRoutine ) == telemetryoutboxROUTINE_SLOT_LIMIT );
+
+    /* Which is left for an urgent one. */
+    unittestCHECK( prvAdd( &xOutbox, eTelemetryOutboxClassUrgent, 20, "u" ) == eAzureIoTSuccess );
+    unittestCHECK( prvAdd( &xOutbox, eTelemetryOutboxClassUrgent, 21, "u" ) == eAzureIoTErrorOutOfMemory );
+    unittestCHECK( TelemetryOutbox_GetPendingCount( &xOutbox ) == telemetryoutboxSLOT_COUNT );
+    unittestCHECK( TelemetryOutbox_GetClassCount( &xOutbox, eTelemetryOutboxClassUrgent ) == 1 );
+
+    /* An acknowledged routine message frees a slot, for either class. */
+    TelemetryOutbox_Acknowledge( &xOutbox, 1 );
+    TelemetryOutbox_Acknowledge( &xOutbox, 99 );
+    unittestCHECK( TelemetryOutbox_GetPendingCount( &xOutbox ) == telemetryoutboxSLOT_COUNT - 1 );
+    unittestCHECK( prvAdd( &xOutbox, eTelemetryOutboxClassUrgent, 21, "u" ) == eAzureIoTSuccess );
+    unittestCHECK( TelemetryOutbox_GetClassCount( &xOutbox, eTelemetryOutboxClassUrgent ) == 2 );
+
+    /* A payload larger than a slot is never kept. */
+    TelemetryOutbox_Init( &xOutbox );
+    unittestCHECK( TelemetryOutbox_Add( &xOutbox, eTelemetryOutboxClassUrgent, 1, ucLarge, sizeof( ucLarge ), NULL ) == eAzureIoTErrorOutOfMemory );
+    unittestCHECK( TelemetryOutbox_GetPendingCount( &xOutbox ) == 0 );
+}
+/*-----------------------------------------------------------*/
+
+static void prvTestResendOrder( void )
+{
+    static TelemetryOutbox_t xOutbox;
+    AzureIoTHubClient_t xClient;
+
+    TelemetryOutbox_Init( &xOutbox );
+    xSendResult = eAzureIoTSuccess;
+    usNextPacketID = 100;
+
+    /* A freed slot is reused by a newer message, which is still sent after the older ones. */
+    unittestCHECK( prvAdd( &xOutbox, eTelemetryOutboxClassRoutine, 1, "r1" ) == eAzureIoTSuccess );
+    unittestCHECK( prvAdd( &xOutbox, eTelemetryOutboxClassUrgent, 2, "u1" ) == eAzureIoTSuccess );
+    unittestCHECK( prvAdd( &xOutbox, eTelemetryOutboxClassRoutine, 3, "r2" ) == eAzureIoTSuccess );
+    TelemetryOutbox_Acknowledge( &xOutbox, 1 );
+    unittestCHECK( prvAdd( &xOutbox, eTelemetryOutboxClassUrgent, 4, "u2" ) == eAzureIoTSuccess );
+    TelemetryOutbox_Acknowledge( &xOutbox, 2 );
+    unittestCHECK( prvAdd( &xOutbox, eTelemetryOutboxClassRoutine, 5, "r3" ) == eAzureIoTSuccess );
+
+    ulSentCount = 0;
+    unittestCHECK( TelemetryOutbox_Resend( &xOutbox, &xClient ) == eAzureIoTSuccess );
+    unittestCHECK( ulSentCount == 3 );
+    unittestCHECK( strcmp( cSent[ 0 ], "u2" ) == 0 );
+    unittestCHECK( strcmp( cSent[ 1 ], "r2" ) == 0 );
+    unittestCHECK( strcmp( cSent[ 2 ], "r3" ) == 0 );
+
+    /* The messages are now known by their new packet IDs. */
+    TelemetryOutbox_Acknowledge( &xOutbox, 4 );
+    unittestCHECK( TelemetryOutbox_GetPendingCount( &xOutbox ) == 3 );
+    TelemetryOutbox_Acknowledge( &xOutbox, 101 );
+    unittestCHECK( TelemetryOutbox_GetClassCount( &xOutbox, eTelemetryOutboxClassUrgent ) == 0 );
+
+    /* A failed send stops the resend, and the messages stay kept. */
+    xSendResult = eAzureIoTErrorPublishFailed;
+    unittestCHECK( TelemetryOutbox_Resend( &xOutbox, &xClient ) == eAzureIoTErrorPublishFailed );
+    unittestCHECK( TelemetryOutbox_GetPendingCount( &xOutbox ) == 2 );
+    xSendResult = eAzureIoTSuccess;
+}
+/*-----------------------------------------------------------*/
+
+/**
+ * @brief Device flooding a slow link with telemetry, with command responses
+ * among it, and reconnecting after regular outages.
+ *
+ * Every message is sent once connected, and kept in the outbox if its class
+ * has a slot left. An outage loses the messages not acknowledged yet; those
+ * kept are sent again after it.
+ *
+ * @param[in] xUseClasses Whether command responses are kept as urgent, or as routine like the telemetry.
+ * @param[out] pulUrgentLost Command responses never acknowledged.
+ * @param[out] pulUrgentMaxTicks Longest time to acknowledge a command response.
+ * @param[out] pulRoutineLost Telemetry messages never acknowledged.
+ */
+static void prvStress( bool xUseClasses,
+                       uint32_t * pulUrgentLost,
+                       uint32_t * pulUrgentMaxTicks,
+                       uint32_t * pulRoutineLost )
+{
+    static TelemetryOutbox_t xOutbox;
+    AzureIoTHubClient_t xClient;
+    TestMessage_t * pxMessage;
+    TestPacket_t * pxPacket;
+    uint32_t ulMessageCount = 0;
+    uint32_t ulTick;
+    uint32_t ulSent;
+    uint32_t ulIndex;
+    uint16_t usPacketID;
+    bool xConnected = true;
+    bool xUrgent;
+
+    TelemetryOutbox_Init( &xOutbox );
+    ulQueueHead = ulQueueSent = ulQueueTail = 0;
+    xSendResult = eAzureIoTSuccess;
+    srand( 11 );
+
+    /* The last ticks produce nothing, to drain what is left. */
+    for( ulTick = 0; ulTick < testTICKS + testOUTAGE_PERIOD; ulTick++ )
+    {
+        if( ( ulTick % testOUTAGE_PERIOD ) == testOUTAGE_PERIOD - testOUTAGE_TICKS )
+        {
+            /* Whatever was in flight is lost with the connection. */
+            xConnected = false;
+            ulQueueHead = ulQueueSent = ulQueueTail;
+        }
+        else if( !xConnected && ( ( ulTick % testOUTAGE_PERIOD ) == 0 ) )
+        {
+            xConnected = true;
+            unittestCHECK( TelemetryOutbox_Resend( &xOutbox, &xClient ) == eAzureIoTSuccess );
+        }
+
+        if( !xConnected )
+        {
+            continue;
+        }
+
+        /* PUBACKs of the packets sent one round trip ago. */
+        while( ( ulQueueHead != ulQueueSent ) && ( xQueue[ ulQueueHead % testLINK_QUEUE ].ulAckTick <= ulTick ) )
+        {
+            pxPacket = &xQueue[ ulQueueHead++ % testLINK_QUEUE ];
+            pxMessage = &xMessages[ pxPacket->ulMessage ];
+            TelemetryOutbox_Acknowledge( &xOutbox, pxPacket->usPacketID );
+
+            if( !pxMessage->xAcked )
+            {
+                pxMessage->xAcked = true;
+                pxMessage->ulAckedTick = ulTick;
+            }
+        }
+
+        /* New messages, but none in the last ticks. */
+        for( ulIndex = 0; ( ulTick < testTICKS ) && ( ulIndex < 2 ) && ( ulMessageCount < testMESSAGE_COUNT ); ulIndex++ )
+        {
+            xUrgent = ( ulIndex == 1 );
+
+            if( xUrgent ? ( ( ulTick % testURGENT_PERIOD ) != 0 ) : ( ( uint32_t ) ( rand() % 100 ) >= testROUTINE_PERCENT ) )
+            {
+                continue;
+            }
+
+            pxMessage = &xMessages[ ulMessageCount ];
+            pxMessage->xClass = xUrgent ? eTelemetryOutboxClassUrgent : eTelemetryOutboxClassRoutine;
+            pxMessage->ulCreatedTick = ulTick;
+            pxMessage->xAcked = false;
+
+            unittestCHECK( AzureIoTHubClient_SendTelemetry( &xClient, ( const uint8_t * ) &ulMessageCount, sizeof( ulMessageCount ),
+                                                            NULL, eAzureIoTHubMessageQoS1, &usPacketID ) == eAzureIoTSuccess );
+            ( void ) TelemetryOutbox_Add( &xOutbox,
+                                          xUseClasses ? pxMessage->xClass : eTelemetryOutboxClassRoutine,
+                                          usPacketID, ( const uint8_t * ) &ulMessageCount, sizeof( ulMessageCount ), NULL );
+            ulMessageCount++;
+        }
+
+        /* The link sends a few packets each tick, in order. */
+        for( ulSent = 0; ( ulSent < testLINK_CAPACITY ) && ( ulQueueSent != ulQueueTail ); ulSent++ )
+        {
+            xQueue[ ulQueueSent++ % testLINK_QUEUE ].ulAckTick = ulTick + testRTT_TICKS;
+        }
+    }
+
+    *pulUrgentLost = 0;
+    *pulUrgentMaxTicks = 0;
+    *pulRoutineLost = 0;
+
+    for( ulIndex = 0; ulIndex < ulMessageCount; ulIndex++ )
+    {
+        pxMessage = &xMessages[ ulIndex ];
+
+        if( pxMessage->xClass == eTelemetryOutboxClassRoutine )
+        {
+            *pulRoutineLost += pxMessage->xAcked ? 0 : 1;
+        }
+        else if( !pxMessage->xAcked )
+        {
+            ( *pulUrgentLost )++;
+        }
+        else if( pxMessage->ulAckedTick - pxMessage->ulCreatedTick > *pulUrgentMaxTicks )
+        {
+            *pulUrgentMaxTicks = pxMessage->ulAckedTick - pxMessage->ulCreatedTick;
+        }
+    }
+}
+/*-----------------------------------------------------------*/
+
+static void prvTestStress( void )
+{
+    uint32_t ulUrgentLost;
+    uint32_t ulUrgentMaxTicks;
+    uint32_t ulRoutineLost;
+
+    printf( "%-22s %14s %18s %14s\n", "command responses", "lost", "max latency (ms)", "telemetry lost" );
+
+    prvStress( false, &ulUrgentLost, &ulUrgentMaxTicks, &ulRoutineLost );
+    printf( "%-22s %14u %18u %14u\n", "kept as routine", ulUrgentLost, ulUrgentMaxTicks * 10U, ulRoutineLost );
+
+    prvStress( true, &ulUrgentLost, &ulUrgentMaxTicks, &ulRoutineLost );
+    printf( "%-22s %14u %18u %14u\n", "kept as urgent", ulUrgentLost, ulUrgentMaxTicks * 10U, ulRoutineLost );
+
+    /* Routine telemetry overflows its slots and loses messages to the
+     * outages, but no command response is lost, and each is acknowledged
+     * within an outage and two round trips: one before it, one after. */
+    unittestCHECK( ulRoutineLost > 0 );
+    unittestCHECK( ulUrgentLost == 0 );
+    unittestCHECK( ulUrgentMaxTicks <= testOUTAGE_TICKS + ( 2U * testRTT_TICKS ) + 1U );
+}
+/*-----------------------------------------------------------*/
+
+int main( void )
+{
+    prvTestClassLimits();
+    prvTestResendOrder();
+    prvTestStress();
+
+    return UnitTest_Result();
+}
+/*-----------------------------------------------------------*/
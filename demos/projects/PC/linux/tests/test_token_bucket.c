@@ -0,0 +1,71 @@
+/* Copyright (c) Microsoft Corporation.
+ * Licensed under the MIT License. */
+
+#include "token_bucket.h"
+
+#include "unit_test.h"
+
+/*-----------------------------------------------------------*/
+
+static void prvTestBurstAndRate( void )
+{
+    TokenBucket_t xBucket;
+
+    /* 3 back to back, then one per second. */
+    TokenBucket_Init( &xBucket, 3, 1000, 10000 );
+
+    unittestCHECK( TokenBucket_TryTake( &xBucket, 10000 ) );
+    unittestCHECK( TokenBucket_TryTake( &xBucket, 10000 ) );
+    unittestCHECK( TokenBucket_TryTake( &xBucket, 10000 ) );
+    unittestCHECK( !TokenBucket_TryTake( &xBucket, 10000 ) );
+    unittestCHECK( TokenBucket_TimeToToken( &xBucket, 10000 ) == 1000 );
+    unittestCHECK( TokenBucket_TimeToToken( &xBucket, 10400 ) == 600 );
+
+    unittestCHECK( !TokenBucket_TryTake( &xBucket, 10999 ) );
+    unittestCHECK( TokenBucket_TryTake( &xBucket, 11000 ) );
+    unittestCHECK( !TokenBucket_TryTake( &xBucket, 11000 ) );
+
+    /* The remainder of an interval is kept: 2.5 intervals give 2 tokens and half of the next. */
+    unittestCHECK( TokenBucket_TryTake( &xBucket, 13500 ) );
+    unittestCHECK( TokenBucket_TryTake( &xBucket, 13500 ) );
+    unittestCHECK( !TokenBucket_TryTake( &xBucket, 13500 ) );
+    unittestCHECK( TokenBucket_TimeToToken( &xBucket, 13500 ) == 500 );
+
+    /* A long idle time fills the bucket up to its capacity only. */
+    unittestCHECK( TokenBucket_TimeToToken( &xBucket, 100000 ) == 0 );
+    unittestCHECK( TokenBucket_TryTake( &xBucket, 100000 ) );
+    unittestCHECK( TokenBucket_TryTake( &xBucket, 100000 ) );
+    unittestCHECK( TokenBucket_TryTake( &xBucket, 100000 ) );
+    unittestCHECK( !TokenBucket_TryTake( &xBucket, 100000 ) );
+}
+/*-----------------------------------------------------------*/
+
+static void prvTestBorrow( void )
+{
+    TokenBucket_t xBucket;
+
+    TokenBucket_Init( &xBucket, 1, 1000, 0 );
+
+    /* The first takes the token, the next two borrow. */
+    TokenBucket_Borrow( &xBucket, 0 );
+    TokenBucket_Borrow( &xBucket, 0 );
+    TokenBucket_Borrow( &xBucket, 0 );
+    unittestCHECK( xBucket.ulDebt == 2 );
+
+    /* The tokens of the next two intervals repay the debt. */
+    unittestCHECK( TokenBucket_TimeToToken( &xBucket, 0 ) == 3000 );
+    unittestCHECK( !TokenBucket_TryTake( &xBucket, 2000 ) );
+    unittestCHECK( TokenBucket_TimeToToken( &xBucket, 2000 ) == 1000 );
+    unittestCHECK( TokenBucket_TryTake( &xBucket, 3000 ) );
+    unittestCHECK( xBucket.ulDebt == 0 );
+}
+/*-----------------------------------------------------------*/
+
+int main( void )
+{
+    prvTestBurstAndRate();
+    prvTestBorrow();
+
+    return UnitTest_Result();
+}
+/*-----------------------------------------------------------*/
@@ -0,0 +1,142 @@
+/* Copyright (c) Microsoft Corporation.
+ * Licensed under the MIT License. */
+
+#include "window_aggregator.h"
+
+#include "unit_test.h"
+
+/*-----------------------------------------------------------*/
+
+static void prvTestStats( void )
+{
+    WindowAggregatorStats_t xAll, xFirst, xSecond;
+    double xValues[] = { 4.0, 1.0, 3.0, 2.0 };
+    uint32_t ulIndex;
+
+    WindowAggregator_StatsReset( &xAll );
+    WindowAggregator_StatsReset( &xFirst );
+    WindowAggregator_StatsReset( &xSecond );
+    unittestCHECK( WindowAggregator_StatsVariance( &xAll ) == 0.0 );
+
+    for( ulIndex = 0; ulIndex < 4; ulIndex++ )
+    {
+        WindowAggregator_StatsAdd( &xAll, xValues[ ulIndex ] );
+        WindowAggregator_StatsAdd( ( ulIndex < 2 ) ? &xFirst : &xSecond, xValues[ ulIndex ] );
+    }
+
+    unittestCHECK( xAll.ulCount == 4 );
+    unittestCHECK( xAll.xMinimum == 1.0 );
+    unittestCHECK( xAll.xMaximum == 4.0 );
+    unittestCHECK( xAll.xLast == 2.0 );
+    unittestCHECK_NEAR( xAll.xMean, 2.5, 1e-12 );
+    unittestCHECK_NEAR( WindowAggregator_StatsVariance( &xAll ), 5.0 / 3.0, 1e-12 );
+
+    /* Merging the halves gives the statistics of the whole. */
+    WindowAggregator_StatsMerge( &xFirst, &xSecond );
+    unittestCHECK( xFirst.ulCount == 4 );
+    unittestCHECK( xFirst.xMinimum == 1.0 );
+    unittestCHECK( xFirst.xMaximum == 4.0 );
+    unittestCHECK( xFirst.xLast == 2.0 );
+    unittestCHECK_NEAR( xFirst.xMean, 2.5, 1e-12 );
+    unittestCHECK_NEAR( WindowAggregator_StatsVariance( &xFirst ), 5.0 / 3.0, 1e-12 );
+}
+/*-----------------------------------------------------------*/
+
+static void prvTestLargeOffset( void )
+{
+    WindowAggregatorStats_t xStats;
+
+    /* The sum of squares would lose the variance to cancellation. */
+    WindowAggregator_StatsReset( &xStats );
+    WindowAggregator_StatsAdd( &xStats, 1e9 + 4.0 );
+    WindowAggregator_StatsAdd( &xStats, 1e9 + 7.0 );
+    WindowAggregator_StatsAdd( &xStats, 1e9 + 13.0 );
+    WindowAggregator_StatsAdd( &xStats, 1e9 + 16.0 );
+
+    unittestCHECK_NEAR( WindowAggregator_StatsVariance( &xStats ), 30.0, 1e-6 );
+}
+/*-----------------------------------------------------------*/
+
+static void prvTestInit( void )
+{
+    WindowAggregator_t xAggregator;
+    WindowAggregatorStats_t xPanes[ 6 ];
+
+    unittestCHECK( !WindowAggregator_Init( &xAggregator, xPanes, 0, 3, 30 ) );
+    unittestCHECK( !WindowAggregator_Init( &xAggregator, xPanes, 2, 0, 30 ) );
+    unittestCHECK( !WindowAggregator_Init( &xAggregator, xPanes, 2, 3, 31 ) );
+    unittestCHECK( WindowAggregator_Init( &xAggregator, xPanes, 2, 3, 30 ) );
+}
+/*-----------------------------------------------------------*/
+
+static void prvTestTumbling( void )
+{
+    WindowAggregator_t xAggregator;
+    WindowAggregatorStats_t xPanes[ 2 ];
+    WindowAggregatorStats_t xClosed[ 2 ];
+
+    unittestCHECK( WindowAggregator_Init( &xAggregator, xPanes, 2, 1, 10 ) );
+
+    unittestCHECK( !WindowAggregator_Advance( &xAggregator, 0, xClosed ) );
+    WindowAggregator_Add( &xAggregator, 0, 1.0 );
+    unittestCHECK( !WindowAggregator_Advance( &xAggregator, 9, xClosed ) );
+    WindowAggregator_Add( &xAggregator, 0, 3.0 );
+    WindowAggregator_Add( &xAggregator, 1, -1.0 );
+
+    unittestCHECK( WindowAggregator_Advance( &xAggregator, 10, xClosed ) );
+    unittestCHECK( xClosed[ 0 ].ulCount == 2 );
+    unittestCHECK_NEAR( xClosed[ 0 ].xMean, 2.0, 1e-12 );
+    unittestCHECK( xClosed[ 1 ].ulCount == 1 );
+    unittestCHECK( xClosed[ 1 ].xLast == -1.0 );
+
+    /* A window without samples is not reported, and a time in the past stays in the current pane. */
+    unittestCHECK( !WindowAggregator_Advance( &xAggregator, 25, xClosed ) );
+    WindowAggregator_Add( &xAggregator, 0, 5.0 );
+    unittestCHECK( !WindowAggregator_Advance( &xAggregator, 5, xClosed ) );
+    unittestCHECK( WindowAggregator_Advance( &xAggregator, 30, NULL ) );
+}
+/*-----------------------------------------------------------*/
+
+static void prvTestSliding( void )
+{
+    WindowAggregator_t xAggregator;
+    WindowAggregatorStats_t xPanes[ 3 ];
+    WindowAggregatorStats_t xClosed;
+    WindowAggregatorStats_t xStats;
+    uint64_t ullTime;
+
+    /* Windows of 30 sliding by panes of 10, one sample per pane: 0, 1, 2, 3. */
+    unittestCHECK( WindowAggregator_Init( &xAggregator, xPanes, 1, 3, 30 ) );
+
+    for( ullTime = 0; ullTime < 40; ullTime += 10 )
+    {
+        ( void ) WindowAggregator_Advance( &xAggregator, ullTime, &xClosed );
+        WindowAggregator_Add( &xAggregator, 0, ( double ) ( ullTime / 10 ) );
+    }
+
+    /* The window in progress holds the last three panes. */
+    WindowAggregator_Get( &xAggregator, 0, &xStats );
+    unittestCHECK( xStats.ulCount == 3 );
+    unittestCHECK( xStats.xMinimum == 1.0 );
+    unittestCHECK( xStats.xMaximum == 3.0 );
+    unittestCHECK( xStats.xLast == 3.0 );
+
+    /* Skipping past every pane reports the window that ended first, and leaves the next one empty. */
+    unittestCHECK( WindowAggregator_Advance( &xAggregator, 100, &xClosed ) );
+    unittestCHECK( xClosed.ulCount == 3 );
+    WindowAggregator_Get( &xAggregator, 0, &xStats );
+    unittestCHECK( xStats.ulCount == 0 );
+}
+/*-----------------------------------------------------------*/
+
+int main( void )
+{
+    prvTestStats();
+    prvTestLargeOffset();
+    prvTestInit();
+    prvTestTumbling();
+    prvTestSliding();
+
+    return UnitTest_Result();
+}
+/*-----------------------------------------------------------*/
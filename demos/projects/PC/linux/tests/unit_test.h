@@ -0,0 +1,54 @@
+/* Copyright (c) Microsoft Corporation.
+ * Licensed under the MIT License. */
+
+/**
+ * @file unit_test.h
+ * @brief Checks of the host unit tests.
+ *
+ * A failed check prints its location and the test goes on, so one run
+ * reports every failure. main() returns UnitTest_Result().
+ */
+
+#ifndef UNIT_TEST_H
+#define UNIT_TEST_H
+
+#include <math.h>
+#include <stdint.h>
+#include <stdio.h>
+
+static uint32_t ulUnitTestFailures;
+
+/**
+ * @brief Check a condition.
+ */
+#define unittestCHECK( x )                                                         \
+    do {                                                                           \
+        if( !( x ) )                                                               \
+        {                                                                          \
+            fprintf( stderr, "%s:%d: check failed: %s\n", __FILE__, __LINE__, #x ); \
+            ulUnitTestFailures++;                                                  \
+        }                                                                          \
+    } while( 0 )
+
+/**
+ * @brief Check that two doubles differ by at most a tolerance.
+ */
+#define unittestCHECK_NEAR( xActual, xExpected, xTolerance ) \
+    unittestCHECK( fabs( ( double ) ( xActual ) - ( double ) ( xExpected ) ) <= ( xTolerance ) )
+
+/**
+ * @brief Exit status of the test: 0 if every check passed.
+ */
+static inline int UnitTest_Result( void )
+{
+    if( ulUnitTestFailures > 0 )
+    {
+        fprintf( stderr, "%u checks failed\n", ( unsigned ) ulUnitTestFailures );
+
+        return 1;
+    }
+
+    return 0;
+}
+
+#endif /* UNIT_TEST_H */
@@ -87,6 +87,20 @@ extern void vLoggingPrintf( const char * pcFormatString,
  */
 #define democonfigREGISTRATION_ID           "<YOUR REGISTRATION ID HERE>"
 
+/**
+ * @brief Cache the IoT Hub and device ID assigned by the provisioning service (PnP sample).
+ *
+ * @note The entry is kept in democonfigDPS_CACHE_FILE and reused on the next
+ * run. If the cached IoT Hub rejects the device, the device is provisioned again.
+ * To always provision on start up undef this macro.
+ */
+#define democonfigENABLE_DPS_CACHE
+
+/**
+ * @brief File holding the provisioning cache entry.
+ */
+#define democonfigDPS_CACHE_FILE            "azure_iot_dps_cache.bin"
+
 #endif // democonfigENABLE_DPS_SAMPLE
 
 /**
@@ -107,6 +121,13 @@ extern void vLoggingPrintf( const char * pcFormatString,
  */
 #define democonfigHOSTNAME                  "<YOUR IOT HUB HOSTNAME HERE>"
 
+/**
+ * @brief Hostname of a geo-secondary IoT Hub the device is also registered with,
+ * connected to when the IoT Hub above keeps failing or answers much slower.
+ *
+ */
+// #define democonfigHOSTNAME_SECONDARY     "<YOUR SECONDARY IOT HUB HOSTNAME HERE>"
+
 /**
  * @brief Device symmetric key
  *
@@ -487,4 +508,38 @@ static unsigned char root_cert_array[] = {
  */
 #define democonfigIOTHUB_PORT          ( 8883 )
 
+/**
+ * @brief Send the PnP thermostat telemetry as binary series of this many readings,
+ * with the content type application/x-gorilla-series, instead of one JSON
+ * message per reading. tools/gorilla_decode.py decodes them.
+ */
+// #define democonfigTELEMETRY_SERIES_LENGTH   ( 60 )
+
+/**
+ * @brief Compress PnP telemetry payloads of at least this many bytes, sent with
+ * the content encoding deflate when they get shorter. Payloads that set their
+ * own message properties are sent as they are.
+ */
+// #define democonfigTELEMETRY_COMPRESSION_THRESHOLD   ( 128 )
+
+/**
+ * @brief Encode the PnP thermostat telemetry in CBOR, sent with the content
+ * type application/cbor, instead of JSON. Series, when enabled, take precedence.
+ */
+// #define democonfigTELEMETRY_CBOR
+
+/**
+ * @brief Keep the MQTT session and its subscriptions across reconnects,
+ * rather than unsubscribing before each disconnect, and send again the
+ * telemetry the IoT Hub had not acknowledged.
+ */
+// #define democonfigPERSISTENT_SESSION
+
+/**
+ * @brief Messages per day the device may send to the IoT Hub, its share of the
+ * quota of the IoT Hub tier. Telemetry and reported properties beyond it are
+ * batched. Defaults to one S1 unit for this device alone.
+ */
+// #define democonfigHUB_DAILY_MESSAGE_QUOTA    ( rategovernorDAILY_QUOTA_S1 / 100U )
+
 #endif /* DEMO_CONFIG_H */
@@ -24,6 +24,10 @@
 /* Demo Specific configs. */
 #include "demo_config.h"
 
+#ifdef democonfigENABLE_DPS_CACHE
+    #include "provisioning_cache.h"
+#endif
+
 #define mainHOST_NAME           "RTOSDemo"
 #define mainDEVICE_NICK_NAME    "windows_demo"
 
@@ -372,6 +376,54 @@ uint64_t ullGetUnixTime( void )
 }
 /*-----------------------------------------------------------*/
 
+#ifdef democonfigENABLE_DPS_CACHE
+
+uint32_t ulProvisioningCacheRead( uint8_t * pucBuffer,
+                                  uint32_t ulBufferLength )
+{
+    FILE * file;
+    size_t read_len;
+
+    file = fopen( democonfigDPS_CACHE_FILE, "rb" );
+
+    if( file == NULL )
+    {
+        return 1;
+    }
+
+    read_len = fread( pucBuffer, 1, ulBufferLength, file );
+    fclose( file );
+
+    return read_len == ulBufferLength ? 0 : 1;
+}
+/*-----------------------------------------------------------*/
+
+uint32_t ulProvisioningCacheWrite( const uint8_t * pucBuffer,
+                                   uint32_t ulBufferLength )
+{
+    FILE * file;
+    size_t write_len;
+
+    file = fopen( democonfigDPS_CACHE_FILE, "wb" );
+
+    if( file == NULL )
+    {
+        return 1;
+    }
+
+    write_len = fwrite( pucBuffer, 1, ulBufferLength, file );
+
+    if( fclose( file ) != 0 )
+    {
+        return 1;
+    }
+
+    return write_len == ulBufferLength ? 0 : 1;
+}
+/*-----------------------------------------------------------*/
+
+#endif /* democonfigENABLE_DPS_CACHE */
+
 /**
  * @brief Function to generate a random number.
  *
@@ -284,12 +284,51 @@ BaseType_t Sockets_Close( SocketHandle xSocket )
 }
 /*-----------------------------------------------------------*/
 
+/**
+ * @brief Connect a socket to an address, through the WiFi module.
+ */
+static BaseType_t prvConnect( uint32_t ulSocketNumber,
+                              uint32_t ulIPAddres,
+                              uint16_t usPort )
+{
+    STSecureSocket_t * pxSecureSocket = &( xSockets[ ulSocketNumber ] );
+    int32_t lRetVal;
+
+    if ( xSemaphoreTake( xWifiSemaphoreHandle, xSemaphoreWaitTicks ) != pdTRUE )
+    {
+        lRetVal = SOCKETS_SOCKET_ERROR;
+    }
+    else
+    {
+        /* Start the client connection. */
+        if( WIFI_OpenClientConnection( ulSocketNumber, WIFI_TCP_PROTOCOL,
+                                       NULL, (uint8_t *)&ulIPAddres, usPort, 0 ) == WIFI_STATUS_OK )
+        {
+            /* Successful connection is established. */
+            lRetVal = SOCKETS_ERROR_NONE;
+
+            /* Mark that the socket is connected. */
+            pxSecureSocket->ulFlags |= stsecuresocketsSOCKET_IS_CONNECTED_FLAG;
+        }
+        else
+        {
+            /* Connection failed. */
+            lRetVal = SOCKETS_SOCKET_ERROR;
+        }
+
+        /* Return the semaphore. */
+        ( void ) xSemaphoreGive( xWifiSemaphoreHandle );
+    }
+
+    return lRetVal;
+}
+/*-----------------------------------------------------------*/
+
 BaseType_t Sockets_Connect( SocketHandle xSocket,
                             const char * pcHostName,
                             uint16_t usPort )
 {
     uint32_t ulSocketNumber = ( uint32_t ) xSocket;
-    STSecureSocket_t * pxSecureSocket;
     int32_t lRetVal = SOCKETS_ERROR_NONE;
     uint32_t ulIPAddres = 0;
 
@@ -297,42 +336,48 @@ BaseType_t Sockets_Connect( SocketHandle xSocket,
     {
         lRetVal = SOCKETS_ENOMEM;
     }
+    else if( ( ulIPAddres = prvGetHostByName( pcHostName ) ) == 0 )
+    {
+        lRetVal = SOCKETS_SOCKET_ERROR;
+    }
     else
     {
-        pxSecureSocket = &( xSockets[ ulSocketNumber ] );
+        lRetVal = prvConnect( ulSocketNumber, ulIPAddres, usPort );
+    }
+    
+    return lRetVal;
+}
+/*-----------------------------------------------------------*/
 
-        if( ( ulIPAddres = prvGetHostByName( pcHostName ) ) == 0 )
-        {
-            lRetVal = SOCKETS_SOCKET_ERROR;
-        }
-        else if ( xSemaphoreTake( xWifiSemaphoreHandle, xSemaphoreWaitTicks ) != pdTRUE )
-        {
-            lRetVal = SOCKETS_SOCKET_ERROR;
-        }
-        else
-        {
-            /* Start the client connection. */
-            if( WIFI_OpenClientConnection( ulSocketNumber, WIFI_TCP_PROTOCOL,
-                                           NULL, (uint8_t *)&ulIPAddres, usPort, 0 ) == WIFI_STATUS_OK )
-            {
-                /* Successful connection is established. */
-                lRetVal = SOCKETS_ERROR_NONE;
+BaseType_t Sockets_Probe( SocketHandle xSocket,
+                          const char * pcHostName,
+                          uint16_t usPort,
+                          uint32_t ulTimeoutMs,
+                          uint32_t * pulConnectTimeMs )
+{
+    uint32_t ulSocketNumber = ( uint32_t ) xSocket;
+    uint32_t ulIPAddres = 0;
+    TickType_t xStart;
+    BaseType_t xRetVal;
 
-                /* Mark that the socket is connected. */
-                pxSecureSocket->ulFlags |= stsecuresocketsSOCKET_IS_CONNECTED_FLAG;
-            }
-            else
-            {
-                /* Connection failed. */
-                lRetVal = SOCKETS_SOCKET_ERROR;
-            }
+    /* The module connects within its own timeout, it takes none from the host. */
+    ( void ) ulTimeoutMs;
 
-            /* Return the semaphore. */
-            ( void ) xSemaphoreGive( xWifiSemaphoreHandle );
-        }
+    if ( prvIsValidSocket( ulSocketNumber ) ==  pdFALSE )
+    {
+        return SOCKETS_ENOMEM;
     }
-    
-    return lRetVal;
+
+    if( ( ulIPAddres = prvGetHostByName( pcHostName ) ) == 0 )
+    {
+        return SOCKETS_SOCKET_ERROR;
+    }
+
+    xStart = xTaskGetTickCount();
+    xRetVal = prvConnect( ulSocketNumber, ulIPAddres, usPort );
+    *pulConnectTimeMs = ( uint32_t ) ( ( xTaskGetTickCount() - xStart ) * portTICK_PERIOD_MS );
+
+    return xRetVal;
 }
 /*-----------------------------------------------------------*/
 
@@ -479,6 +524,18 @@ BaseType_t Sockets_Recv( SocketHandle xSocket,
 }
 /*-----------------------------------------------------------*/
 
+BaseType_t Sockets_WaitForData( SocketHandle xSocket,
+                                uint32_t ulTimeoutMs )
+{
+    ( void ) xSocket;
+    ( void ) ulTimeoutMs;
+
+    /* The WiFi module can only be polled by receiving, which consumes the
+     * data, so let Sockets_Recv() and its timeout do the waiting. */
+    return 1;
+}
+/*-----------------------------------------------------------*/
+
 BaseType_t Sockets_Send( SocketHandle xSocket,
                          const uint8_t * pucData,
                          size_t xDataLength )
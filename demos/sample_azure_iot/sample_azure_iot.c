@@ -25,6 +25,12 @@
 /* Crypto helper header. */
 #include "crypto.h"
 
+/* SAS token reuse and renewal. */
+#include "sas_token_cache.h"
+
+/* Main loop deadlines. */
+#include "deadline_scheduler.h"
+
 /*-----------------------------------------------------------*/
 
 /* Compile time error for undefined configs. */
@@ -89,18 +95,15 @@
 #define sampleazureiotDELAY_BETWEEN_DEMO_ITERATIONS_TICKS     ( pdMS_TO_TICKS( 5000U ) )
 
 /**
- * @brief Timeout for MQTT_ProcessLoop in milliseconds.
+ * @brief Time in milliseconds between two telemetry messages.
  */
-#define sampleazureiotPROCESS_LOOP_TIMEOUT_MS                 ( 500U )
+#define sampleazureiotTELEMETRY_INTERVAL_MS                   ( 2000U )
 
 /**
- * @brief Delay (in ticks) between consecutive cycles of MQTT publish operations in a
- * demo iteration.
- *
- * Note that the process loop also has a timeout, so the total time between
- * publishes is the sum of the two delays.
+ * @brief Time in milliseconds between two runs of the MQTT process loop while
+ * no data is received, for it to send a PINGREQ in time.
  */
-#define sampleazureiotDELAY_BETWEEN_PUBLISHES_TICKS           ( pdMS_TO_TICKS( 2000U ) )
+#define sampleazureiotKEEP_ALIVE_INTERVAL_MS                  ( azureiotconfigKEEP_ALIVE_TIMEOUT_SECONDS * 1000U / 4U )
 
 /**
  * @brief Transport timeout in milliseconds for transport send and receive.
@@ -118,6 +121,17 @@
 #define sampleazureiotSUBSCRIBE_TIMEOUT                       ( 10 * 1000U )
 /*-----------------------------------------------------------*/
 
+/**
+ * @brief Work of the main loop, by index of its deadline.
+ */
+typedef enum SampleDeadline
+{
+    eSampleDeadlineTelemetry = 0,
+    eSampleDeadlineKeepAlive,
+    eSampleDeadlineCount
+} SampleDeadline_t;
+/*-----------------------------------------------------------*/
+
 /**
  * @brief Unix time.
  *
@@ -303,6 +317,10 @@ static void prvAzureDemoTask( void * pvParameters )
     AzureIoTHubClientOptions_t xHubOptions = { 0 };
     AzureIoTMessageProperties_t xPropertyBag;
     bool xSessionPresent;
+    DeadlineSchedulerEntry_t xDeadlines[ eSampleDeadlineCount ];
+    DeadlineScheduler_t xScheduler;
+    uint64_t ullWait;
+    int32_t lDataReady;
 
     #ifdef democonfigENABLE_DPS_SAMPLE
         uint8_t * pucIotHubHostname = NULL;
@@ -337,6 +355,18 @@ static void prvAzureDemoTask( void * pvParameters )
 
     xNetworkContext.pParams = &xTlsTransportParams;
 
+    /* Create a bag of properties for the telemetry, once: every message
+     * carries the same properties, and sending leaves the bag as it is.
+     * AzureIoTHubClient_SendTelemetry() formats the topic with these
+     * properties on each call, and the middleware has no way to publish a
+     * topic formatted in advance, so the bag is all a message can prepare. */
+    xResult = AzureIoTMessage_PropertiesInit( &xPropertyBag, ucPropertyBuffer, 0, sizeof( ucPropertyBuffer ) );
+    configASSERT( xResult == eAzureIoTSuccess );
+
+    xResult = AzureIoTMessage_PropertiesAppend( &xPropertyBag, ( uint8_t * ) "name", sizeof( "name" ) - 1,
+                                                ( uint8_t * ) "value", sizeof( "value" ) - 1 );
+    configASSERT( xResult == eAzureIoTSuccess );
+
     for( ; ; )
     {
         /* Attempt to establish TLS session with IoT Hub. If connection fails,
@@ -367,7 +397,7 @@ static void prvAzureDemoTask( void * pvParameters )
                                           pucIotHubDeviceId, pulIothubDeviceIdLength,
                                           &xHubOptions,
                                           ucMQTTMessageBuffer, sizeof( ucMQTTMessageBuffer ),
-                                          ullGetUnixTime,
+                                          SASTokenCache_GetTime,
                                           &xTransport );
         configASSERT( xResult == eAzureIoTSuccess );
 
@@ -375,7 +405,7 @@ static void prvAzureDemoTask( void * pvParameters )
             xResult = AzureIoTHubClient_SetSymmetricKey( &xAzureIoTHubClient,
                                                          ( const uint8_t * ) democonfigDEVICE_SYMMETRIC_KEY,
                                                          sizeof( democonfigDEVICE_SYMMETRIC_KEY ) - 1,
-                                                         Crypto_HMAC );
+                                                         SASTokenCache_HMAC );
             configASSERT( xResult == eAzureIoTSuccess );
         #endif /* democonfigDEVICE_SYMMETRIC_KEY */
 
@@ -388,6 +418,13 @@ static void prvAzureDemoTask( void * pvParameters )
                                              sampleazureiotCONNACK_RECV_TIMEOUT_MS );
         configASSERT( xResult == eAzureIoTSuccess );
 
+        #ifdef democonfigPERSISTENT_SESSION
+            /* The subscriptions of a resumed session are already in place at the
+             * IoT Hub, but subscribing again is what registers the callbacks of
+             * this client, so it is done either way. */
+            LogInfo( ( "MQTT session %s.\r\n", xSessionPresent ? "resumed" : "started" ) );
+        #endif /* democonfigPERSISTENT_SESSION */
+
         xResult = AzureIoTHubClient_SubscribeCloudToDeviceMessage( &xAzureIoTHubClient, prvHandleCloudMessage,
                                                                    &xAzureIoTHubClient, sampleazureiotSUBSCRIBE_TIMEOUT );
         configASSERT( xResult == eAzureIoTSuccess );
@@ -404,53 +441,73 @@ static void prvAzureDemoTask( void * pvParameters )
         xResult = AzureIoTHubClient_RequestPropertiesAsync( &xAzureIoTHubClient );
         configASSERT( xResult == eAzureIoTSuccess );
 
-        /* Create a bag of properties for the telemetry */
-        xResult = AzureIoTMessage_PropertiesInit( &xPropertyBag, ucPropertyBuffer, 0, sizeof( ucPropertyBuffer ) );
-        configASSERT( xResult == eAzureIoTSuccess );
+        DeadlineScheduler_Init( &xScheduler, xDeadlines, eSampleDeadlineCount );
+        DeadlineScheduler_Arm( &xScheduler, eSampleDeadlineTelemetry,
+                               DeadlineScheduler_GetTimeMs(), sampleazureiotTELEMETRY_INTERVAL_MS );
+        DeadlineScheduler_Arm( &xScheduler, eSampleDeadlineKeepAlive,
+                               DeadlineScheduler_GetTimeMs() + sampleazureiotKEEP_ALIVE_INTERVAL_MS,
+                               sampleazureiotKEEP_ALIVE_INTERVAL_MS );
 
-        xResult = AzureIoTMessage_PropertiesAppend( &xPropertyBag, ( uint8_t * ) "name", sizeof( "name" ) - 1,
-                                                    ( uint8_t * ) "value", sizeof( "value" ) - 1 );
-        configASSERT( xResult == eAzureIoTSuccess );
+        /* Publish messages with QoS1, send and process Keep alive messages.
+         * Each pass runs the work that is due, then sleeps until the next
+         * deadline or until the IoT Hub sends something, whichever comes first.
+         * The connection is left idle for one interval after the last message. */
+        lPublishCount = 0;
 
-        /* Publish messages with QoS1, send and process Keep alive messages. */
-        for( lPublishCount = 0; lPublishCount < lMaxPublishCount; lPublishCount++ )
+        for( ; ; )
         {
-            ulScratchBufferLength = snprintf( ( char * ) ucScratchBuffer, sizeof( ucScratchBuffer ),
-                                              sampleazureiotMESSAGE, lPublishCount );
-            xResult = AzureIoTHubClient_SendTelemetry( &xAzureIoTHubClient,
-                                                       ucScratchBuffer, ulScratchBufferLength,
-                                                       &xPropertyBag, eAzureIoTHubMessageQoS1, NULL );
-            configASSERT( xResult == eAzureIoTSuccess );
-
-            LogInfo( ( "Attempt to receive publish message from IoT Hub.\r\n" ) );
-            xResult = AzureIoTHubClient_ProcessLoop( &xAzureIoTHubClient,
-                                                     sampleazureiotPROCESS_LOOP_TIMEOUT_MS );
-            configASSERT( xResult == eAzureIoTSuccess );
-
-            if( lPublishCount % 2 == 0 )
+            if( DeadlineScheduler_Due( &xScheduler, eSampleDeadlineTelemetry, DeadlineScheduler_GetTimeMs() ) )
             {
-                /* Send reported property every other cycle */
+                if( lPublishCount == lMaxPublishCount )
+                {
+                    break;
+                }
+
                 ulScratchBufferLength = snprintf( ( char * ) ucScratchBuffer, sizeof( ucScratchBuffer ),
-                                                  sampleazureiotPROPERTY, lPublishCount / 2 + 1 );
-                xResult = AzureIoTHubClient_SendPropertiesReported( &xAzureIoTHubClient,
-                                                                    ucScratchBuffer, ulScratchBufferLength,
-                                                                    NULL );
+                                                  sampleazureiotMESSAGE, lPublishCount );
+                xResult = AzureIoTHubClient_SendTelemetry( &xAzureIoTHubClient,
+                                                           ucScratchBuffer, ulScratchBufferLength,
+                                                           &xPropertyBag, eAzureIoTHubMessageQoS1, NULL );
                 configASSERT( xResult == eAzureIoTSuccess );
+
+                if( lPublishCount % 2 == 0 )
+                {
+                    /* Send reported property every other cycle */
+                    ulScratchBufferLength = snprintf( ( char * ) ucScratchBuffer, sizeof( ucScratchBuffer ),
+                                                      sampleazureiotPROPERTY, lPublishCount / 2 + 1 );
+                    xResult = AzureIoTHubClient_SendPropertiesReported( &xAzureIoTHubClient,
+                                                                        ucScratchBuffer, ulScratchBufferLength,
+                                                                        NULL );
+                    configASSERT( xResult == eAzureIoTSuccess );
+                }
+
+                lPublishCount++;
             }
 
-            /* Leave Connection Idle for some time. */
-            LogInfo( ( "Keeping Connection Idle...\r\n\r\n" ) );
-            vTaskDelay( sampleazureiotDELAY_BETWEEN_PUBLISHES_TICKS );
+            ullWait = DeadlineScheduler_TimeToNext( &xScheduler, DeadlineScheduler_GetTimeMs(),
+                                                    sampleazureiotKEEP_ALIVE_INTERVAL_MS );
+            lDataReady = TLS_Socket_WaitForData( &xNetworkContext, ( uint32_t ) ullWait );
+
+            /* Errors are left to the process loop to report. */
+            if( ( lDataReady != 0 ) ||
+                DeadlineScheduler_Due( &xScheduler, eSampleDeadlineKeepAlive, DeadlineScheduler_GetTimeMs() ) )
+            {
+                LogInfo( ( "Attempt to receive publish message from IoT Hub.\r\n" ) );
+                xResult = AzureIoTHubClient_ProcessLoop( &xAzureIoTHubClient, 0 );
+                configASSERT( xResult == eAzureIoTSuccess );
+            }
         }
 
-        xResult = AzureIoTHubClient_UnsubscribeProperties( &xAzureIoTHubClient );
-        configASSERT( xResult == eAzureIoTSuccess );
+        #ifndef democonfigPERSISTENT_SESSION
+            xResult = AzureIoTHubClient_UnsubscribeProperties( &xAzureIoTHubClient );
+            configASSERT( xResult == eAzureIoTSuccess );
 
-        xResult = AzureIoTHubClient_UnsubscribeCommand( &xAzureIoTHubClient );
-        configASSERT( xResult == eAzureIoTSuccess );
+            xResult = AzureIoTHubClient_UnsubscribeCommand( &xAzureIoTHubClient );
+            configASSERT( xResult == eAzureIoTSuccess );
 
-        xResult = AzureIoTHubClient_UnsubscribeCloudToDeviceMessage( &xAzureIoTHubClient );
-        configASSERT( xResult == eAzureIoTSuccess );
+            xResult = AzureIoTHubClient_UnsubscribeCloudToDeviceMessage( &xAzureIoTHubClient );
+            configASSERT( xResult == eAzureIoTSuccess );
+        #endif /* democonfigPERSISTENT_SESSION */
 
         /* Send an MQTT Disconnect packet over the already connected TLS over
          * TCP connection. There is no corresponding response for the disconnect
@@ -27,6 +27,21 @@
 /* Crypto helper header. */
 #include "crypto.h"
 
+/* Command dispatch table. */
+#include "command_dispatcher.h"
+
+/* Writable properties routing table. */
+#include "property_router.h"
+
+/* Serializers generated from the Device Information model. */
+#include "device_information_model.h"
+
+/* Main loop deadlines. */
+#include "deadline_scheduler.h"
+
+/* Outbound message budgets. */
+#include "rate_governor.h"
+
 /* Demo specific configs. */
 #include "demo_config.h"
 
@@ -103,6 +118,31 @@
  * @brief Wait timeout for subscribe to finish.
  */
 #define sampleazureiotgsgSUBSCRIBE_TIMEOUT                       ( 10 * 1000U )
+
+/**
+ * @brief Time in milliseconds between two runs of the MQTT process loop while
+ * no data is received, for it to send a PINGREQ in time.
+ */
+#define sampleazureiotgsgKEEP_ALIVE_INTERVAL_MS                  ( azureiotconfigKEEP_ALIVE_TIMEOUT_SECONDS * 1000U / 4U )
+
+/**
+ * @brief Messages per day the device may send, its share of the quota of the
+ * IoT Hub tier. Defaults to one S1 unit for this device alone.
+ */
+#ifdef democonfigHUB_DAILY_MESSAGE_QUOTA
+    #define sampleazureiotgsgDAILY_MESSAGE_QUOTA                 democonfigHUB_DAILY_MESSAGE_QUOTA
+#else
+    #define sampleazureiotgsgDAILY_MESSAGE_QUOTA                 rategovernorDAILY_QUOTA_S1
+#endif
+
+/**
+ * @brief Budgets of telemetry and reported properties, three quarters and a
+ * quarter of the daily quota, and the messages of each that may go back to back.
+ */
+#define sampleazureiotgsgTELEMETRY_DAILY_QUOTA                   ( sampleazureiotgsgDAILY_MESSAGE_QUOTA / 4U * 3U )
+#define sampleazureiotgsgPROPERTIES_DAILY_QUOTA                  ( sampleazureiotgsgDAILY_MESSAGE_QUOTA / 4U )
+#define sampleazureiotgsgTELEMETRY_BURST                         ( 10U )
+#define sampleazureiotgsgPROPERTIES_BURST                        ( 5U )
 /*-----------------------------------------------------------*/
 
 #define sampleazureiotgsgTELEMETRY_INTERVAL_PROPERTY             ( "telemetryInterval" )
@@ -110,14 +150,6 @@
 #define sampleazureiotgsgSET_LED_STATE_COMMAND                   ( "setLedState" )
 
 #define sampleazureiotgsgDEVICE_INFORMATION_NAME                 ( "deviceInformation" )
-#define sampleazureiotgsgMANUFACTURER_PROPERTY_NAME              ( "manufacturer" )
-#define sampleazureiotgsgMODEL_PROPERTY_NAME                     ( "model" )
-#define sampleazureiotgsgSOFTWARE_VERSION_PROPERTY_NAME          ( "swVersion" )
-#define sampleazureiotgsgOS_NAME_PROPERTY_NAME                   ( "osName" )
-#define sampleazureiotgsgPROCESSOR_ARCHITECTURE_PROPERTY_NAME    ( "processorArchitecture" )
-#define sampleazureiotgsgPROCESSOR_MANUFACTURER_PROPERTY_NAME    ( "processorManufacturer" )
-#define sampleazureiotgsgTOTAL_STORAGE_PROPERTY_NAME             ( "totalStorage" )
-#define sampleazureiotgsgTOTAL_MEMORY_PROPERTY_NAME              ( "totalMemory" )
 
 #define sampleazureiotgsgTRUE                                    ( "true" )
 /*-----------------------------------------------------------*/
@@ -145,11 +177,50 @@ static uint8_t ucScratchBuffer[ 128 ];
 /* Property buffer */
 static uint8_t ucPropertyPayloadBuffer[ 400 ];
 
+/* Budgets of outbound messages, and what waits for them */
+static RateGovernor_t xTelemetryGovernor;
+static RateGovernor_t xPropertiesGovernor;
+static uint8_t ucTelemetryBatchBuffer[ 512 ];
+static uint8_t ucPropertiesBatchBuffer[ 400 ];
+
 /* Device properties */
 static int32_t lTelemetryInterval = 5;
 static bool xLedState = false;
 
+/* The LED state a command changed, reported once the command is responded to. */
+static bool xLedStateReportPending = false;
+
 static AzureIoTHubClient_t xAzureIoTHubClient;
+
+/* Handlers of the commands of the device. */
+static CommandDispatcher_t xCommandDispatcher;
+
+/* Writable properties of the device. */
+static void prvOnTelemetryIntervalApplied( const PropertyRoute_t * pxRoute );
+
+static const PropertyRoute_t xPropertyRoutes[] =
+{
+    {
+        NULL, 0,
+        propertyrouterNAME( sampleazureiotgsgTELEMETRY_INTERVAL_PROPERTY ),
+        ePropertyRouterValueInt32, &lTelemetryInterval,
+        1, INT32_MAX,
+        prvOnTelemetryIntervalApplied
+    }
+};
+
+static PropertyRouter_t xPropertyRouter;
+
+/* Work of the main loop, by index of its deadline. */
+typedef enum SampleDeadline
+{
+    eSampleDeadlineTelemetry = 0,
+    eSampleDeadlineKeepAlive,
+    eSampleDeadlineCount
+} SampleDeadline_t;
+
+static DeadlineSchedulerEntry_t xDeadlines[ eSampleDeadlineCount ];
+static DeadlineScheduler_t xScheduler;
 /*-----------------------------------------------------------*/
 
 /**
@@ -166,7 +237,114 @@ uint64_t ullGetUnixTime( void );
 static uint8_t ucMQTTMessageBuffer[ democonfigNETWORK_BUFFER_SIZE ];
 /*-----------------------------------------------------------*/
 
-static void prvReportLedState()
+/**
+ * @brief Send telemetry within its budget, batching it while the budget is spent.
+ */
+static AzureIoTResult_t prvSendTelemetry( const uint8_t * pucPayload,
+                                          uint32_t ulPayloadLength )
+{
+    const uint8_t * pucMessage;
+    uint32_t ulMessageLength;
+    AzureIoTResult_t xResult;
+
+    xResult = RateGovernor_Submit( &xTelemetryGovernor, eRateGovernorPriorityRoutine, pucPayload, ulPayloadLength,
+                                   DeadlineScheduler_GetTimeMs(), &pucMessage, &ulMessageLength );
+
+    if( ( xResult != eAzureIoTSuccess ) || ( pucMessage == NULL ) )
+    {
+        return xResult;
+    }
+
+    return AzureIoTHubClient_SendTelemetry( &xAzureIoTHubClient, pucMessage, ulMessageLength,
+                                            NULL, eAzureIoTHubMessageQoS1, NULL );
+}
+/*-----------------------------------------------------------*/
+
+/**
+ * @brief Send a reported properties patch within its budget, merging it with
+ *  the next ones while the budget is spent. Urgent patches, answering the
+ *  cloud, go out now with the merged ones.
+ */
+static AzureIoTResult_t prvSendReportedProperties( RateGovernorPriority_t xPriority,
+                                                   const uint8_t * pucPatch,
+                                                   uint32_t ulPatchLength )
+{
+    const uint8_t * pucMessage;
+    uint32_t ulMessageLength;
+    AzureIoTResult_t xResult;
+
+    xResult = RateGovernor_Submit( &xPropertiesGovernor, xPriority, pucPatch, ulPatchLength,
+                                   DeadlineScheduler_GetTimeMs(), &pucMessage, &ulMessageLength );
+
+    if( ( xResult == eAzureIoTErrorOutOfMemory ) && ( xPriority == eRateGovernorPriorityUrgent ) )
+    {
+        /* The merged patches go out first, then the urgent one on its own. */
+        xResult = AzureIoTHubClient_SendPropertiesReported( &xAzureIoTHubClient, pucMessage, ulMessageLength, NULL );
+
+        if( xResult != eAzureIoTSuccess )
+        {
+            return xResult;
+        }
+
+        xResult = RateGovernor_Submit( &xPropertiesGovernor, xPriority, pucPatch, ulPatchLength,
+                                       DeadlineScheduler_GetTimeMs(), &pucMessage, &ulMessageLength );
+    }
+
+    if( ( xResult != eAzureIoTSuccess ) || ( pucMessage == NULL ) )
+    {
+        return xResult;
+    }
+
+    return AzureIoTHubClient_SendPropertiesReported( &xAzureIoTHubClient, pucMessage, ulMessageLength, NULL );
+}
+/*-----------------------------------------------------------*/
+
+/**
+ * @brief Send the batches the budgets allow again.
+ *
+ * @return Time in milliseconds until the next batch can be sent, UINT32_MAX if none waits.
+ */
+static uint32_t prvFlushBatches( void )
+{
+    const uint8_t * pucMessage;
+    uint32_t ulMessageLength;
+    uint32_t ulPropertiesWait;
+    uint32_t ulTelemetryWait;
+    AzureIoTResult_t xResult;
+
+    if( RateGovernor_Flush( &xTelemetryGovernor, DeadlineScheduler_GetTimeMs(), &pucMessage, &ulMessageLength ) )
+    {
+        xResult = AzureIoTHubClient_SendTelemetry( &xAzureIoTHubClient, pucMessage, ulMessageLength,
+                                                   NULL, eAzureIoTHubMessageQoS1, NULL );
+        configASSERT( xResult == eAzureIoTSuccess );
+
+        LogInfo( ( "Sent a telemetry batch, %u readings batched and %u urgent messages so far.",
+                   ( unsigned ) xTelemetryGovernor.ulBatchedCount, ( unsigned ) xTelemetryGovernor.ulUrgentCount ) );
+    }
+
+    if( RateGovernor_Flush( &xPropertiesGovernor, DeadlineScheduler_GetTimeMs(), &pucMessage, &ulMessageLength ) )
+    {
+        xResult = AzureIoTHubClient_SendPropertiesReported( &xAzureIoTHubClient, pucMessage, ulMessageLength, NULL );
+
+        if( xResult != eAzureIoTSuccess )
+        {
+            LogError( ( "There was an error sending the reported properties: 0x%08x", xResult ) );
+        }
+        else
+        {
+            LogInfo( ( "Sent a reported properties batch, %u patches batched and %u urgent messages so far.",
+                       ( unsigned ) xPropertiesGovernor.ulBatchedCount, ( unsigned ) xPropertiesGovernor.ulUrgentCount ) );
+        }
+    }
+
+    ulTelemetryWait = RateGovernor_TimeToFlush( &xTelemetryGovernor, DeadlineScheduler_GetTimeMs() );
+    ulPropertiesWait = RateGovernor_TimeToFlush( &xPropertiesGovernor, DeadlineScheduler_GetTimeMs() );
+
+    return ( ulTelemetryWait < ulPropertiesWait ) ? ulTelemetryWait : ulPropertiesWait;
+}
+/*-----------------------------------------------------------*/
+
+static void prvReportLedState( RateGovernorPriority_t xPriority )
 {
     AzureIoTResult_t xResult;
     AzureIoTJSONWriter_t xWriter;
@@ -197,7 +375,7 @@ static void prvReportLedState()
         return;
     }
 
-    xResult = AzureIoTHubClient_SendPropertiesReported( &xAzureIoTHubClient, ucPropertyPayloadBuffer, lBytesWritten, NULL );
+    xResult = prvSendReportedProperties( xPriority, ucPropertyPayloadBuffer, lBytesWritten );
 
     if( xResult != eAzureIoTSuccess )
     {
@@ -247,7 +425,9 @@ static void prvReportTelemetryInterval( uint32_t ulVersion )
     else
     {
         LogDebug( ( "Sending acknowledged writable property. Payload: %.*s", lBytesWritten, ucPropertyPayloadBuffer ) );
-        xResult = AzureIoTHubClient_SendPropertiesReported( &xAzureIoTHubClient, ucPropertyPayloadBuffer, lBytesWritten, NULL );
+        /* Acknowledging a desired version answers the cloud, reporting the initial value does not. */
+        xResult = prvSendReportedProperties( ( ulVersion > 0 ) ? eRateGovernorPriorityUrgent : eRateGovernorPriorityRoutine,
+                                             ucPropertyPayloadBuffer, lBytesWritten );
 
         if( xResult != eAzureIoTSuccess )
         {
@@ -262,6 +442,22 @@ static void prvReportDeviceInfo()
     AzureIoTResult_t xResult;
     AzureIoTJSONWriter_t xWriter;
     int32_t lBytesWritten;
+    DeviceInformationReportedProperties_t xDeviceInformation;
+
+    xDeviceInformation.pucManufacturer = ( const uint8_t * ) pcManufacturerPropertyValue;
+    xDeviceInformation.ulManufacturerLength = strlen( pcManufacturerPropertyValue );
+    xDeviceInformation.pucModel = ( const uint8_t * ) pcModelPropertyValue;
+    xDeviceInformation.ulModelLength = strlen( pcModelPropertyValue );
+    xDeviceInformation.pucSwVersion = ( const uint8_t * ) pcSoftwareVersionPropertyValue;
+    xDeviceInformation.ulSwVersionLength = strlen( pcSoftwareVersionPropertyValue );
+    xDeviceInformation.pucOsName = ( const uint8_t * ) pcOsNamePropertyValue;
+    xDeviceInformation.ulOsNameLength = strlen( pcOsNamePropertyValue );
+    xDeviceInformation.pucProcessorArchitecture = ( const uint8_t * ) pcProcessorArchitecturePropertyValue;
+    xDeviceInformation.ulProcessorArchitectureLength = strlen( pcProcessorArchitecturePropertyValue );
+    xDeviceInformation.pucProcessorManufacturer = ( const uint8_t * ) pcProcessorManufacturerPropertyValue;
+    xDeviceInformation.ulProcessorManufacturerLength = strlen( pcProcessorManufacturerPropertyValue );
+    xDeviceInformation.xTotalStorage = xTotalStoragePropertyValue;
+    xDeviceInformation.xTotalMemory = xTotalMemoryPropertyValue;
 
     /* Update reported property */
     xResult = AzureIoTJSONWriter_Init( &xWriter, ucPropertyPayloadBuffer, sizeof( ucPropertyPayloadBuffer ) );
@@ -270,39 +466,10 @@ static void prvReportDeviceInfo()
     xResult = AzureIoTJSONWriter_AppendBeginObject( &xWriter );
     configASSERT( xResult == eAzureIoTSuccess );
 
-    xResult = AzureIoTHubClientProperties_BuilderBeginComponent( &xAzureIoTHubClient, &xWriter, ( const uint8_t * ) sampleazureiotgsgDEVICE_INFORMATION_NAME, strlen( sampleazureiotgsgDEVICE_INFORMATION_NAME ) );
+    xResult = AzureIoTHubClientProperties_BuilderBeginComponent( &xAzureIoTHubClient, &xWriter, ( const uint8_t * ) sampleazureiotgsgDEVICE_INFORMATION_NAME, sizeof( sampleazureiotgsgDEVICE_INFORMATION_NAME ) - 1 );
     configASSERT( xResult == eAzureIoTSuccess );
 
-    xResult = AzureIoTJSONWriter_AppendPropertyWithStringValue( &xWriter, ( uint8_t * ) sampleazureiotgsgMANUFACTURER_PROPERTY_NAME, sizeof( sampleazureiotgsgMANUFACTURER_PROPERTY_NAME ) - 1,
-                                                                ( uint8_t * ) pcManufacturerPropertyValue, strlen( pcManufacturerPropertyValue ) );
-    configASSERT( xResult == eAzureIoTSuccess );
-
-    xResult = AzureIoTJSONWriter_AppendPropertyWithStringValue( &xWriter, ( uint8_t * ) sampleazureiotgsgMODEL_PROPERTY_NAME, sizeof( sampleazureiotgsgMODEL_PROPERTY_NAME ) - 1,
-                                                                ( uint8_t * ) pcModelPropertyValue, strlen( pcModelPropertyValue ) );
-    configASSERT( xResult == eAzureIoTSuccess );
-
-    xResult = AzureIoTJSONWriter_AppendPropertyWithStringValue( &xWriter, ( uint8_t * ) sampleazureiotgsgSOFTWARE_VERSION_PROPERTY_NAME, sizeof( sampleazureiotgsgSOFTWARE_VERSION_PROPERTY_NAME ) - 1,
-                                                                ( uint8_t * ) pcSoftwareVersionPropertyValue, strlen( pcSoftwareVersionPropertyValue ) );
-    configASSERT( xResult == eAzureIoTSuccess );
-
-    xResult = AzureIoTJSONWriter_AppendPropertyWithStringValue( &xWriter, ( uint8_t * ) sampleazureiotgsgOS_NAME_PROPERTY_NAME, sizeof( sampleazureiotgsgOS_NAME_PROPERTY_NAME ) - 1,
-                                                                ( uint8_t * ) pcOsNamePropertyValue, strlen( pcOsNamePropertyValue ) );
-    configASSERT( xResult == eAzureIoTSuccess );
-
-    xResult = AzureIoTJSONWriter_AppendPropertyWithStringValue( &xWriter, ( uint8_t * ) sampleazureiotgsgPROCESSOR_ARCHITECTURE_PROPERTY_NAME, sizeof( sampleazureiotgsgPROCESSOR_ARCHITECTURE_PROPERTY_NAME ) - 1,
-                                                                ( uint8_t * ) pcProcessorArchitecturePropertyValue, strlen( pcProcessorArchitecturePropertyValue ) );
-    configASSERT( xResult == eAzureIoTSuccess );
-
-    xResult = AzureIoTJSONWriter_AppendPropertyWithStringValue( &xWriter, ( uint8_t * ) sampleazureiotgsgPROCESSOR_MANUFACTURER_PROPERTY_NAME, sizeof( sampleazureiotgsgPROCESSOR_MANUFACTURER_PROPERTY_NAME ) - 1,
-                                                                ( uint8_t * ) pcProcessorManufacturerPropertyValue, strlen( pcProcessorManufacturerPropertyValue ) );
-    configASSERT( xResult == eAzureIoTSuccess );
-
-    xResult = AzureIoTJSONWriter_AppendPropertyWithDoubleValue( &xWriter, ( uint8_t * ) sampleazureiotgsgTOTAL_STORAGE_PROPERTY_NAME, sizeof( sampleazureiotgsgTOTAL_STORAGE_PROPERTY_NAME ) - 1,
-                                                                xTotalStoragePropertyValue, 0 );
-    configASSERT( xResult == eAzureIoTSuccess );
-
-    xResult = AzureIoTJSONWriter_AppendPropertyWithDoubleValue( &xWriter, ( uint8_t * ) sampleazureiotgsgTOTAL_MEMORY_PROPERTY_NAME, sizeof( sampleazureiotgsgTOTAL_MEMORY_PROPERTY_NAME ) - 1,
-                                                                xTotalMemoryPropertyValue, 0 );
+    xResult = DeviceInformation_AppendReportedProperties( &xWriter, &xDeviceInformation );
     configASSERT( xResult == eAzureIoTSuccess );
 
     xResult = AzureIoTHubClientProperties_BuilderEndComponent( &xAzureIoTHubClient, &xWriter );
@@ -319,7 +486,7 @@ static void prvReportDeviceInfo()
         return;
     }
 
-    xResult = AzureIoTHubClient_SendPropertiesReported( &xAzureIoTHubClient, ucPropertyPayloadBuffer, lBytesWritten, NULL );
+    xResult = prvSendReportedProperties( eRateGovernorPriorityRoutine, ucPropertyPayloadBuffer, lBytesWritten );
 
     if( xResult != eAzureIoTSuccess )
     {
@@ -336,6 +503,26 @@ static void prvInvokeSetLedStateCommand( const void * pvMessagePayload,
 }
 /*-----------------------------------------------------------*/
 
+static uint32_t prvSetLedStateCommand( const AzureIoTHubClientCommandRequest_t * pxMessage,
+                                       uint8_t * pucResponsePayload,
+                                       uint32_t ulResponsePayloadSize,
+                                       uint32_t * pulResponsePayloadLength,
+                                       void * pvContext )
+{
+    ( void ) pucResponsePayload;
+    ( void ) ulResponsePayloadSize;
+    ( void ) pulResponsePayloadLength;
+    ( void ) pvContext;
+
+    prvInvokeSetLedStateCommand( pxMessage->pvMessagePayload, pxMessage->ulPayloadLength );
+
+    /* Update the associated reported property, after the response */
+    xLedStateReportPending = true;
+
+    return 200;
+}
+/*-----------------------------------------------------------*/
+
 /**
  * @brief Command message callback handler
  */
@@ -343,131 +530,81 @@ static void prvHandleCommand( AzureIoTHubClientCommandRequest_t * pxMessage,
                               void * pvContext )
 {
     AzureIoTHubClient_t * pxHandle = ( AzureIoTHubClient_t * ) pvContext;
+    uint32_t ulResponseStatus;
+    uint32_t ulResponsePayloadLength;
 
     LogInfo( ( "Received direct command: %.*s", pxMessage->usCommandNameLength, pxMessage->pucCommandName ) );
 
-    if( strncmp( sampleazureiotgsgSET_LED_STATE_COMMAND, ( const char * ) pxMessage->pucCommandName, strlen( sampleazureiotgsgSET_LED_STATE_COMMAND ) ) == 0 )
+    if( CommandDispatcher_Dispatch( &xCommandDispatcher, pxMessage, NULL, 0,
+                                    &ulResponseStatus, &ulResponsePayloadLength ) != eAzureIoTSuccess )
     {
-        prvInvokeSetLedStateCommand( pxMessage->pvMessagePayload, pxMessage->ulPayloadLength );
-
-        if( AzureIoTHubClient_SendCommandResponse( pxHandle, pxMessage, 200, NULL, 0 ) != eAzureIoTSuccess )
-        {
-            LogInfo( ( "Error sending command response" ) );
-        }
+        LogInfo( ( "Received command is not for this device" ) );
 
-        /* Update the associated reported property */
-        prvReportLedState();
+        ulResponseStatus = 404;
     }
-    else
+
+    /* The response is never held back by the budget, only counted in it. */
+    RateGovernor_Charge( &xPropertiesGovernor, DeadlineScheduler_GetTimeMs() );
+
+    if( AzureIoTHubClient_SendCommandResponse( pxHandle, pxMessage, ulResponseStatus, NULL, 0 ) != eAzureIoTSuccess )
     {
-        LogInfo( ( "Received command is not for this device" ) );
+        LogError( ( "Error sending command response" ) );
+    }
 
-        if( AzureIoTHubClient_SendCommandResponse( pxHandle, pxMessage, 404, NULL, 0 ) != eAzureIoTSuccess )
-        {
-            LogError( ( "Error sending command response" ) );
-        }
+    if( xLedStateReportPending )
+    {
+        xLedStateReportPending = false;
+        prvReportLedState( eRateGovernorPriorityUrgent );
     }
 }
 /*-----------------------------------------------------------*/
 
-static void prvSkipPropertyAndValue( AzureIoTJSONReader_t * pxReader )
+static void prvOnTelemetryIntervalApplied( const PropertyRoute_t * pxRoute )
 {
-    AzureIoTResult_t xResult;
+    ( void ) pxRoute;
 
-    xResult = AzureIoTJSONReader_NextToken( pxReader );
-    configASSERT( xResult == eAzureIoTSuccess );
-
-    xResult = AzureIoTJSONReader_SkipChildren( pxReader );
-    configASSERT( xResult == eAzureIoTSuccess );
+    LogInfo( ( "TelemetryInterval Property received: %d.", lTelemetryInterval ) );
 
-    xResult = AzureIoTJSONReader_NextToken( pxReader );
-    configASSERT( xResult == eAzureIoTSuccess );
+    /* Count the new interval from now. */
+    DeadlineScheduler_Arm( &xScheduler, eSampleDeadlineTelemetry,
+                           DeadlineScheduler_GetTimeMs() + ( uint64_t ) lTelemetryInterval * 1000U,
+                           ( uint64_t ) lTelemetryInterval * 1000U );
 }
 /*-----------------------------------------------------------*/
 
 /**
  * @brief Properties callback handler
+ *
+ * Applies the writable properties through the routing table and reports
+ * all their acknowledgements in one patch.
  */
-static AzureIoTResult_t prvProcessProperties( AzureIoTHubClientPropertiesResponse_t * pxMessage,
-                                              AzureIoTHubClientPropertyType_t xPropertyType )
+static AzureIoTResult_t prvProcessProperties( AzureIoTHubClientPropertiesResponse_t * pxMessage )
 {
     AzureIoTResult_t xResult;
-    AzureIoTJSONReader_t xReader;
-    const uint8_t * pucComponentName = NULL;
-    uint32_t ulComponentNameLength = 0;
-    uint32_t ulVersion;
-    int32_t lNewTelemetryInterval;
+    uint32_t ulAckLength;
 
-    xResult = AzureIoTJSONReader_Init( &xReader, pxMessage->pvMessagePayload, pxMessage->ulPayloadLength );
-    configASSERT( xResult == eAzureIoTSuccess );
-
-    xResult = AzureIoTHubClientProperties_GetPropertiesVersion( &xAzureIoTHubClient, &xReader, pxMessage->xMessageType, &ulVersion );
+    xResult = PropertyRouter_Process( &xPropertyRouter, &xAzureIoTHubClient, pxMessage,
+                                      ucPropertyPayloadBuffer, sizeof( ucPropertyPayloadBuffer ),
+                                      &ulAckLength );
 
     if( xResult != eAzureIoTSuccess )
     {
-        LogError( ( "Error getting the property version" ) );
+        LogError( ( "There was an error parsing the properties: 0x%08x", xResult ) );
     }
     else
     {
-        /* Reset JSON reader to the beginning */
-        xResult = AzureIoTJSONReader_Init( &xReader, pxMessage->pvMessagePayload, pxMessage->ulPayloadLength );
-        configASSERT( xResult == eAzureIoTSuccess );
+        LogInfo( ( "Successfully parsed properties" ) );
 
-        while( ( xResult = AzureIoTHubClientProperties_GetNextComponentProperty( &xAzureIoTHubClient, &xReader,
-                                                                                 pxMessage->xMessageType, xPropertyType,
-                                                                                 &pucComponentName, &ulComponentNameLength ) ) == eAzureIoTSuccess )
+        if( ulAckLength > 0 )
         {
-            if( ulComponentNameLength > 0 )
-            {
-                LogInfo( ( "Unknown component name received %s", pucComponentName ) );
-
-                /* Unknown component name arrived (there are none for this device).
-                 * We have to skip over the property and value to continue iterating */
-                prvSkipPropertyAndValue( &xReader );
-            }
-            else if( AzureIoTJSONReader_TokenIsTextEqual( &xReader,
-                                                          ( uint8_t * ) sampleazureiotgsgTELEMETRY_INTERVAL_PROPERTY,
-                                                          sizeof( sampleazureiotgsgTELEMETRY_INTERVAL_PROPERTY ) - 1 ) )
-            {
-                xResult = AzureIoTJSONReader_NextToken( &xReader );
-                configASSERT( xResult == eAzureIoTSuccess );
-
-                /* Get telemetry interval */
-                xResult = AzureIoTJSONReader_GetTokenInt32( &xReader, &lNewTelemetryInterval );
+            LogDebug( ( "Sending acknowledged writable properties. Payload: %.*s", ulAckLength, ucPropertyPayloadBuffer ) );
+            xResult = prvSendReportedProperties( eRateGovernorPriorityUrgent, ucPropertyPayloadBuffer, ulAckLength );
 
-                if( xResult != eAzureIoTSuccess )
-                {
-                    LogError( ( "Error getting the property: result 0x%08x", xResult ) );
-                    break;
-                }
-
-                xResult = AzureIoTJSONReader_NextToken( &xReader );
-                configASSERT( xResult == eAzureIoTSuccess );
-
-                /* Update the property and report back */
-                lTelemetryInterval = lNewTelemetryInterval;
-                prvReportTelemetryInterval( ulVersion );
-
-                LogInfo( ( "TelemetryInterval Property received: %d.", lTelemetryInterval ) );
-            }
-            else
+            if( xResult != eAzureIoTSuccess )
             {
-                LogInfo( ( "Unknown property arrived: skipping over it." ) );
-
-                /* Unknown property arrived. We have to skip over the property and value to continue iterating. */
-                prvSkipPropertyAndValue( &xReader );
+                LogError( ( "There was an error sending the reported properties: 0x%08x", xResult ) );
             }
         }
-
-        if( xResult != eAzureIoTErrorEndOfProperties )
-        {
-            LogError( ( "There was an error parsing the properties: 0x%08x", xResult ) );
-        }
-        else
-        {
-            LogInfo( ( "Successfully parsed properties" ) );
-            xResult = eAzureIoTSuccess;
-        }
     }
 
     return xResult;
@@ -493,7 +630,7 @@ static void prvHandleProperties( AzureIoTHubClientPropertiesResponse_t * pxMessa
         case eAzureIoTHubPropertiesRequestedMessage:
             LogInfo( ( "Device property document GET received" ) );
 
-            xResult = prvProcessProperties( pxMessage, eAzureIoTHubClientPropertyWritable );
+            xResult = prvProcessProperties( pxMessage );
 
             if( xResult != eAzureIoTSuccess )
             {
@@ -505,7 +642,7 @@ static void prvHandleProperties( AzureIoTHubClientPropertiesResponse_t * pxMessa
         case eAzureIoTHubPropertiesWritablePropertyMessage:
             LogInfo( ( "Device writeable property received" ) );
 
-            xResult = prvProcessProperties( pxMessage, eAzureIoTHubClientPropertyWritable );
+            xResult = prvProcessProperties( pxMessage );
 
             if( xResult != eAzureIoTSuccess )
             {
@@ -764,7 +901,9 @@ static void prvAzureDemoTask( void * pvParameters )
     uint32_t ulStatus;
     AzureIoTHubClientOptions_t xHubOptions = { 0 };
     bool xSessionPresent;
-    uint64_t lastTelemetryTime;
+    uint64_t ullWait;
+    uint32_t ulFlushWait;
+    int32_t lDataReady;
 
     #ifdef democonfigENABLE_DPS_SAMPLE
         uint8_t * pucIotHubHostname = NULL;
@@ -850,10 +989,21 @@ static void prvAzureDemoTask( void * pvParameters )
                                          sampleazureiotgsgCONNACK_RECV_TIMEOUT_MS );
     configASSERT( xResult == eAzureIoTSuccess );
 
+    CommandDispatcher_Init( &xCommandDispatcher );
+
+    xResult = CommandDispatcher_Register( &xCommandDispatcher, NULL, 0,
+                                          ( const uint8_t * ) sampleazureiotgsgSET_LED_STATE_COMMAND,
+                                          sizeof( sampleazureiotgsgSET_LED_STATE_COMMAND ) - 1,
+                                          prvSetLedStateCommand, NULL );
+    configASSERT( xResult == eAzureIoTSuccess );
+
     xResult = AzureIoTHubClient_SubscribeCommand( &xAzureIoTHubClient, prvHandleCommand,
                                                   &xAzureIoTHubClient, sampleazureiotgsgSUBSCRIBE_TIMEOUT );
     configASSERT( xResult == eAzureIoTSuccess );
 
+    xResult = PropertyRouter_Init( &xPropertyRouter, xPropertyRoutes, sizeof( xPropertyRoutes ) / sizeof( xPropertyRoutes[ 0 ] ) );
+    configASSERT( xResult == eAzureIoTSuccess );
+
     xResult = AzureIoTHubClient_SubscribeProperties( &xAzureIoTHubClient, prvHandleProperties,
                                                      &xAzureIoTHubClient, sampleazureiotgsgSUBSCRIBE_TIMEOUT );
     configASSERT( xResult == eAzureIoTSuccess );
@@ -862,38 +1012,63 @@ static void prvAzureDemoTask( void * pvParameters )
     xResult = AzureIoTHubClient_RequestPropertiesAsync( &xAzureIoTHubClient );
     configASSERT( xResult == eAzureIoTSuccess );
 
-    lastTelemetryTime = ullGetUnixTime();
+    DeadlineScheduler_Init( &xScheduler, xDeadlines, eSampleDeadlineCount );
+    DeadlineScheduler_Arm( &xScheduler, eSampleDeadlineTelemetry,
+                           DeadlineScheduler_GetTimeMs() + ( uint64_t ) lTelemetryInterval * 1000U,
+                           ( uint64_t ) lTelemetryInterval * 1000U );
+    DeadlineScheduler_Arm( &xScheduler, eSampleDeadlineKeepAlive,
+                           DeadlineScheduler_GetTimeMs() + sampleazureiotgsgKEEP_ALIVE_INTERVAL_MS,
+                           sampleazureiotgsgKEEP_ALIVE_INTERVAL_MS );
+
+    RateGovernor_Init( &xTelemetryGovernor, eRateGovernorBatchArray,
+                       sampleazureiotgsgTELEMETRY_DAILY_QUOTA, sampleazureiotgsgTELEMETRY_BURST,
+                       ucTelemetryBatchBuffer, sizeof( ucTelemetryBatchBuffer ), DeadlineScheduler_GetTimeMs() );
+    RateGovernor_Init( &xPropertiesGovernor, eRateGovernorBatchObject,
+                       sampleazureiotgsgPROPERTIES_DAILY_QUOTA, sampleazureiotgsgPROPERTIES_BURST,
+                       ucPropertiesBatchBuffer, sizeof( ucPropertiesBatchBuffer ), DeadlineScheduler_GetTimeMs() );
 
     /* Report properties */
-    prvReportLedState();
+    prvReportLedState( eRateGovernorPriorityRoutine );
     prvReportTelemetryInterval( 0 );
     prvReportDeviceInfo();
 
-    /* Loop forever */
+    /* Loop forever, sleeping until the next deadline or until the IoT Hub
+     * sends something, whichever comes first. */
     while( true )
     {
-        uint64_t currentTime = ullGetUnixTime();
-
-        if( currentTime > ( lastTelemetryTime + lTelemetryInterval ) )
+        if( DeadlineScheduler_Due( &xScheduler, eSampleDeadlineTelemetry, DeadlineScheduler_GetTimeMs() ) )
         {
-            /* Advance the time */
-            while( currentTime > ( lastTelemetryTime + lTelemetryInterval ) )
+            ulScratchBufferLength = ulCreateTelemetry( ucScratchBuffer, sizeof( ucScratchBuffer ) - 1 );
+
+            xResult = prvSendTelemetry( ucScratchBuffer, ulScratchBufferLength );
+
+            if( xResult == eAzureIoTErrorOutOfMemory )
             {
-                lastTelemetryTime += lTelemetryInterval;
+                LogWarn( ( "Telemetry budget spent and batch full, reading skipped." ) );
             }
+            else
+            {
+                configASSERT( xResult == eAzureIoTSuccess );
+            }
+        }
 
-            ulScratchBufferLength = ulCreateTelemetry( ucScratchBuffer, sizeof( ucScratchBuffer ) - 1 );
+        ulFlushWait = prvFlushBatches();
+        ullWait = DeadlineScheduler_TimeToNext( &xScheduler, DeadlineScheduler_GetTimeMs(),
+                                                sampleazureiotgsgKEEP_ALIVE_INTERVAL_MS );
 
-            xResult = AzureIoTHubClient_SendTelemetry( &xAzureIoTHubClient,
-                                                       ucScratchBuffer, ulScratchBufferLength,
-                                                       NULL, eAzureIoTHubMessageQoS1, NULL );
-            configASSERT( xResult == eAzureIoTSuccess );
+        if( ulFlushWait < ullWait )
+        {
+            ullWait = ulFlushWait;
         }
+        lDataReady = TLS_Socket_WaitForData( &xNetworkContext, ( uint32_t ) ullWait );
 
-        /* :TODO: the processloop runs for 10 seconds */
-        xResult = AzureIoTHubClient_ProcessLoop( &xAzureIoTHubClient, 0 );
-
-        configASSERT( xResult == eAzureIoTSuccess );
+        /* Errors are left to the process loop to report. */
+        if( ( lDataReady != 0 ) ||
+            DeadlineScheduler_Due( &xScheduler, eSampleDeadlineKeepAlive, DeadlineScheduler_GetTimeMs() ) )
+        {
+            xResult = AzureIoTHubClient_ProcessLoop( &xAzureIoTHubClient, 0 );
+            configASSERT( xResult == eAzureIoTSuccess );
+        }
     }
 }
 /*-----------------------------------------------------------*/
@@ -0,0 +1,655 @@
+/* Copyright (c) Microsoft Corporation.
+ * Licensed under the MIT License. */
+
+/**
+ * @file sample_azure_iot_loadgen.c
+ * @brief Runs many simulated devices in a single process, for load testing.
+ *
+ * Every device has its own IoT Hub client, TLS connection, credentials and
+ * telemetry schedule, and runs in its own task. A reporting task prints the
+ * aggregate connect and publish rates, latency percentiles, and the memory and
+ * CPU used per device.
+ *
+ * The per device keys are derived from democonfigDEVICE_SYMMETRIC_KEY the same
+ * way the Provisioning service derives keys for a group enrollment, so the
+ * devices can also target a real IoT Hub. For load tests a local MQTT broker
+ * accepting TLS connections on democonfigIOTHUB_PORT is enough.
+ *
+ * This sample uses host APIs (getrusage) and only builds for the Linux port.
+ */
+
+/* Standard includes. */
+#include <string.h>
+#include <stdio.h>
+#include <sys/resource.h>
+
+/* Kernel includes. */
+#include "FreeRTOS.h"
+#include "task.h"
+
+/* Azure Provisioning/IoT Hub library includes */
+#include "azure_iot_hub_client.h"
+
+/* Transport interface implementation include header for TLS. */
+#include "transport_tls_socket.h"
+
+/* Crypto helper header. */
+#include "crypto.h"
+
+/* Key derivation. */
+#include "mbedtls/base64.h"
+
+/* Demo Specific configs. */
+#include "demo_config.h"
+
+/*-----------------------------------------------------------*/
+
+/* Compile time error for undefined configs. */
+#ifndef democonfigHOSTNAME
+    #error "Define the config democonfigHOSTNAME by following the instructions in file demo_config.h."
+#endif
+
+#ifndef democonfigROOT_CA_PEM
+    #error "Please define Root CA certificate of the IoT Hub(democonfigROOT_CA_PEM) in demo_config.h."
+#endif
+
+#ifndef democonfigDEVICE_SYMMETRIC_KEY
+    #error "The load generator derives per device keys from democonfigDEVICE_SYMMETRIC_KEY, define it in demo_config.h."
+#endif
+/*-----------------------------------------------------------*/
+
+/**
+ * @brief Number of simulated devices.
+ */
+#ifndef democonfigLOADGEN_DEVICE_COUNT
+    #define democonfigLOADGEN_DEVICE_COUNT                ( 100U )
+#endif
+
+/**
+ * @brief Interval between telemetry messages of one device, in milliseconds.
+ */
+#ifndef democonfigLOADGEN_TELEMETRY_INTERVAL_MS
+    #define democonfigLOADGEN_TELEMETRY_INTERVAL_MS       ( 1000U )
+#endif
+
+/**
+ * @brief Number of telemetry messages a device sends before reconnecting.
+ *
+ * 0 keeps every connection open for the whole run.
+ */
+#ifndef democonfigLOADGEN_PUBLISHES_PER_CONNECTION
+    #define democonfigLOADGEN_PUBLISHES_PER_CONNECTION    ( 60U )
+#endif
+
+/**
+ * @brief Delay between the start of two consecutive devices, in milliseconds.
+ */
+#ifndef democonfigLOADGEN_START_STAGGER_MS
+    #define democonfigLOADGEN_START_STAGGER_MS            ( 20U )
+#endif
+
+/**
+ * @brief Interval between two reports, in milliseconds.
+ */
+#ifndef democonfigLOADGEN_REPORT_INTERVAL_MS
+    #define democonfigLOADGEN_REPORT_INTERVAL_MS          ( 10 * 1000U )
+#endif
+
+/**
+ * @brief Root CA of the endpoint, override to point at a local broker.
+ */
+#ifndef democonfigLOADGEN_ROOT_CA_PEM
+    #define democonfigLOADGEN_ROOT_CA_PEM                 democonfigROOT_CA_PEM
+#endif
+
+/**
+ * @brief Size of the MQTT buffer of each device. Telemetry only needs a small one.
+ */
+#ifndef democonfigLOADGEN_NETWORK_BUFFER_SIZE
+    #define democonfigLOADGEN_NETWORK_BUFFER_SIZE         ( 1024U )
+#endif
+
+/**
+ * @brief Timeout for receiving CONNACK packet in milliseconds.
+ */
+#define sampleazureiotCONNACK_RECV_TIMEOUT_MS             ( 10 * 1000U )
+
+/**
+ * @brief Transport timeout in milliseconds for transport send and receive.
+ */
+#define sampleazureiotTRANSPORT_SEND_RECV_TIMEOUT_MS      ( 2000U )
+
+/**
+ * @brief Timeout for AzureIoTHubClient_ProcessLoop in milliseconds.
+ */
+#define sampleazureiotPROCESS_LOOP_TIMEOUT_MS             ( 10U )
+
+/**
+ * @brief Delay before a device retries a failed connection, in milliseconds.
+ */
+#define sampleazureiotRECONNECT_DELAY_MS                  ( 2000U )
+
+/**
+ * @brief Histogram resolution: each power of two is split in this many buckets.
+ */
+#define sampleazureiotHISTOGRAM_SUB_BUCKETS               ( 16U )
+
+/**
+ * @brief Histogram size, covering latencies up to about 17 minutes.
+ */
+#define sampleazureiotHISTOGRAM_BUCKETS                   ( sampleazureiotHISTOGRAM_SUB_BUCKETS * 17U )
+/*-----------------------------------------------------------*/
+
+/**
+ * @brief Unix time.
+ *
+ * @return Time in seconds.
+ */
+uint64_t ullGetUnixTime( void );
+/*-----------------------------------------------------------*/
+
+/* Each compilation unit must define the NetworkContext struct. */
+struct NetworkContext
+{
+    TlsTransportParams_t * pParams;
+};
+
+/**
+ * @brief State of one simulated device.
+ */
+typedef struct LoadGenDevice
+{
+    uint32_t ulIndex;
+    char cDeviceId[ 64 ];
+    uint32_t ulDeviceIdLength;
+    uint8_t ucKey[ 64 ];
+    size_t xKeyLength;
+    uint32_t ulTelemetryIntervalMs;
+    uint32_t ulSequence;
+    AzureIoTHubClient_t xClient;
+    AzureIoTTransportInterface_t xTransport;
+    NetworkContext_t xNetworkContext;
+    TlsTransportParams_t xTlsTransportParams;
+    uint8_t ucTelemetry[ 96 ];
+    uint8_t ucMQTTMessageBuffer[ democonfigLOADGEN_NETWORK_BUFFER_SIZE ];
+} LoadGenDevice_t;
+
+/**
+ * @brief Latency histogram, in milliseconds.
+ */
+typedef struct LoadGenHistogram
+{
+    uint32_t ulCount;
+    uint32_t ulMax;
+    uint32_t ulBuckets[ sampleazureiotHISTOGRAM_BUCKETS ];
+} LoadGenHistogram_t;
+
+/**
+ * @brief Counters shared by all devices and reset at every report.
+ */
+typedef struct LoadGenStats
+{
+    uint32_t ulConnects;
+    uint32_t ulConnectFailures;
+    uint32_t ulDisconnects;
+    uint32_t ulPublishes;
+    uint32_t ulPublishFailures;
+    LoadGenHistogram_t xConnectLatency;
+    LoadGenHistogram_t xPublishLatency;
+} LoadGenStats_t;
+/*-----------------------------------------------------------*/
+
+static LoadGenDevice_t xLoadGenDevices[ democonfigLOADGEN_DEVICE_COUNT ];
+
+static LoadGenStats_t xLoadGenStats;
+
+/* Copy taken by the reporting task, kept static to spare its stack. */
+static LoadGenStats_t xLoadGenReport;
+
+static NetworkCredentials_t xLoadGenNetworkCredentials;
+
+/* Devices currently connected. */
+static uint32_t ulLoadGenConnectedDevices = 0;
+/*-----------------------------------------------------------*/
+
+static uint32_t prvHistogramBucket( uint32_t ulValue )
+{
+    uint32_t ulShift = 0;
+    uint32_t ulBucket;
+
+    if( ulValue < sampleazureiotHISTOGRAM_SUB_BUCKETS )
+    {
+        return ulValue;
+    }
+
+    while( ( ulValue >> ulShift ) >= ( 2 * sampleazureiotHISTOGRAM_SUB_BUCKETS ) )
+    {
+        ulShift++;
+    }
+
+    ulBucket = ( sampleazureiotHISTOGRAM_SUB_BUCKETS * ( ulShift + 1 ) ) +
+               ( ( ulValue >> ulShift ) - sampleazureiotHISTOGRAM_SUB_BUCKETS );
+
+    return ulBucket < sampleazureiotHISTOGRAM_BUCKETS ? ulBucket : sampleazureiotHISTOGRAM_BUCKETS - 1;
+}
+/*-----------------------------------------------------------*/
+
+/**
+ * @brief Smallest value falling in @p ulBucket.
+ */
+static uint32_t prvHistogramBucketValue( uint32_t ulBucket )
+{
+    uint32_t ulShift;
+
+    if( ulBucket < sampleazureiotHISTOGRAM_SUB_BUCKETS )
+    {
+        return ulBucket;
+    }
+
+    ulShift = ( ulBucket / sampleazureiotHISTOGRAM_SUB_BUCKETS ) - 1;
+
+    return ( sampleazureiotHISTOGRAM_SUB_BUCKETS + ( ulBucket % sampleazureiotHISTOGRAM_SUB_BUCKETS ) ) << ulShift;
+}
+/*-----------------------------------------------------------*/
+
+static void prvHistogramRecord( LoadGenHistogram_t * pxHistogram,
+                                uint32_t ulValue )
+{
+    pxHistogram->ulBuckets[ prvHistogramBucket( ulValue ) ]++;
+    pxHistogram->ulCount++;
+
+    if( ulValue > pxHistogram->ulMax )
+    {
+        pxHistogram->ulMax = ulValue;
+    }
+}
+/*-----------------------------------------------------------*/
+
+static uint32_t prvHistogramPercentile( const LoadGenHistogram_t * pxHistogram,
+                                        uint32_t ulPercentile )
+{
+    uint32_t ulTarget = ( uint32_t ) ( ( ( uint64_t ) pxHistogram->ulCount * ulPercentile + 99 ) / 100 );
+    uint32_t ulSeen = 0;
+    uint32_t ulBucket;
+
+    for( ulBucket = 0; ulBucket < sampleazureiotHISTOGRAM_BUCKETS; ulBucket++ )
+    {
+        ulSeen += pxHistogram->ulBuckets[ ulBucket ];
+
+        if( ( ulSeen > 0 ) && ( ulSeen >= ulTarget ) )
+        {
+            return prvHistogramBucketValue( ulBucket );
+        }
+    }
+
+    return 0;
+}
+/*-----------------------------------------------------------*/
+
+static uint32_t prvTicksToMs( TickType_t xTicks )
+{
+    return ( uint32_t ) xTicks * portTICK_PERIOD_MS;
+}
+/*-----------------------------------------------------------*/
+
+/**
+ * @brief Derive the key of a device from the group key, as DPS does for group enrollments:
+ *  base64( HMAC-SHA256( base64decode( group key ), device ID ) ).
+ */
+static uint32_t prvDeriveDeviceKey( LoadGenDevice_t * pxDevice )
+{
+    uint8_t ucGroupKey[ 64 ];
+    size_t xGroupKeyLength;
+    uint8_t ucHMAC[ 32 ];
+    uint32_t ulHMACLength;
+
+    if( mbedtls_base64_decode( ucGroupKey, sizeof( ucGroupKey ), &xGroupKeyLength,
+                               ( const unsigned char * ) democonfigDEVICE_SYMMETRIC_KEY,
+                               sizeof( democonfigDEVICE_SYMMETRIC_KEY ) - 1 ) != 0 )
+    {
+        LogError( ( "democonfigDEVICE_SYMMETRIC_KEY is not a valid base64 key" ) );
+        return 1;
+    }
+
+    if( Crypto_HMAC( ucGroupKey, ( uint32_t ) xGroupKeyLength,
+                     ( const uint8_t * ) pxDevice->cDeviceId, pxDevice->ulDeviceIdLength,
+                     ucHMAC, sizeof( ucHMAC ), &ulHMACLength ) != 0 )
+    {
+        LogError( ( "Failed to derive the key of %s", pxDevice->cDeviceId ) );
+        return 1;
+    }
+
+    if( mbedtls_base64_encode( pxDevice->ucKey, sizeof( pxDevice->ucKey ), &pxDevice->xKeyLength,
+                               ucHMAC, ulHMACLength ) != 0 )
+    {
+        LogError( ( "Failed to encode the key of %s", pxDevice->cDeviceId ) );
+        return 1;
+    }
+
+    return 0;
+}
+/*-----------------------------------------------------------*/
+
+/**
+ * @brief Open the TLS and MQTT connection of a device.
+ */
+static uint32_t prvDeviceConnect( LoadGenDevice_t * pxDevice )
+{
+    AzureIoTHubClientOptions_t xHubOptions = { 0 };
+    AzureIoTResult_t xResult;
+    TlsTransportStatus_t xNetworkStatus;
+    bool xSessionPresent;
+
+    xNetworkStatus = TLS_Socket_Connect( &pxDevice->xNetworkContext,
+                                         democonfigHOSTNAME, democonfigIOTHUB_PORT,
+                                         &xLoadGenNetworkCredentials,
+                                         sampleazureiotTRANSPORT_SEND_RECV_TIMEOUT_MS,
+                                         sampleazureiotTRANSPORT_SEND_RECV_TIMEOUT_MS );
+
+    if( xNetworkStatus != eTLSTransportSuccess )
+    {
+        LogDebug( ( "%s: TLS connection failed [%d]", pxDevice->cDeviceId, xNetworkStatus ) );
+        return 1;
+    }
+
+    pxDevice->xTransport.pxNetworkContext = &pxDevice->xNetworkContext;
+    pxDevice->xTransport.xSend = TLS_Socket_Send;
+    pxDevice->xTransport.xRecv = TLS_Socket_Recv;
+
+    if( ( xResult = AzureIoTHubClient_OptionsInit( &xHubOptions ) ) != eAzureIoTSuccess )
+    {
+        LogError( ( "%s: failed to initialize options: result 0x%08x", pxDevice->cDeviceId, xResult ) );
+    }
+    else if( ( xResult = AzureIoTHubClient_Init( &pxDevice->xClient,
+                                                 ( const uint8_t * ) democonfigHOSTNAME, sizeof( democonfigHOSTNAME ) - 1,
+                                                 ( const uint8_t * ) pxDevice->cDeviceId, pxDevice->ulDeviceIdLength,
+                                                 &xHubOptions,
+                                                 pxDevice->ucMQTTMessageBuffer, sizeof( pxDevice->ucMQTTMessageBuffer ),
+                                                 ullGetUnixTime,
+                                                 &pxDevice->xTransport ) ) != eAzureIoTSuccess )
+    {
+        LogError( ( "%s: failed to initialize the client: result 0x%08x", pxDevice->cDeviceId, xResult ) );
+    }
+    else if( ( xResult = AzureIoTHubClient_SetSymmetricKey( &pxDevice->xClient,
+                                                            pxDevice->ucKey, ( uint32_t ) pxDevice->xKeyLength,
+                                                            Crypto_HMAC ) ) != eAzureIoTSuccess )
+    {
+        LogError( ( "%s: failed to set the key: result 0x%08x", pxDevice->cDeviceId, xResult ) );
+    }
+    else if( ( xResult = AzureIoTHubClient_Connect( &pxDevice->xClient,
+                                                    false, &xSessionPresent,
+                                                    sampleazureiotCONNACK_RECV_TIMEOUT_MS ) ) != eAzureIoTSuccess )
+    {
+        LogDebug( ( "%s: MQTT connection failed: result 0x%08x", pxDevice->cDeviceId, xResult ) );
+    }
+
+    if( xResult != eAzureIoTSuccess )
+    {
+        TLS_Socket_Disconnect( &pxDevice->xNetworkContext );
+        return 1;
+    }
+
+    return 0;
+}
+/*-----------------------------------------------------------*/
+
+static void prvDeviceDisconnect( LoadGenDevice_t * pxDevice )
+{
+    ( void ) AzureIoTHubClient_Disconnect( &pxDevice->xClient );
+    TLS_Socket_Disconnect( &pxDevice->xNetworkContext );
+    AzureIoTHubClient_Deinit( &pxDevice->xClient );
+}
+/*-----------------------------------------------------------*/
+
+/**
+ * @brief Send one telemetry message and process incoming packets.
+ */
+static AzureIoTResult_t prvDevicePublish( LoadGenDevice_t * pxDevice )
+{
+    AzureIoTResult_t xResult;
+    int lLength;
+    TickType_t xStart;
+
+    lLength = snprintf( ( char * ) pxDevice->ucTelemetry, sizeof( pxDevice->ucTelemetry ),
+                        "{\"device\":%u,\"sequence\":%u}",
+                        ( unsigned int ) pxDevice->ulIndex, ( unsigned int ) pxDevice->ulSequence++ );
+
+    xStart = xTaskGetTickCount();
+    xResult = AzureIoTHubClient_SendTelemetry( &pxDevice->xClient,
+                                               pxDevice->ucTelemetry, ( uint32_t ) lLength,
+                                               NULL, eAzureIoTHubMessageQoS1, NULL );
+
+    taskENTER_CRITICAL();
+    {
+        if( xResult == eAzureIoTSuccess )
+        {
+            xLoadGenStats.ulPublishes++;
+            prvHistogramRecord( &xLoadGenStats.xPublishLatency, prvTicksToMs( xTaskGetTickCount() - xStart ) );
+        }
+        else
+        {
+            xLoadGenStats.ulPublishFailures++;
+        }
+    }
+    taskEXIT_CRITICAL();
+
+    if( xResult == eAzureIoTSuccess )
+    {
+        xResult = AzureIoTHubClient_ProcessLoop( &pxDevice->xClient, sampleazureiotPROCESS_LOOP_TIMEOUT_MS );
+    }
+
+    return xResult;
+}
+/*-----------------------------------------------------------*/
+
+/**
+ * @brief Task running one simulated device.
+ */
+static void prvDeviceTask( void * pvParameters )
+{
+    LoadGenDevice_t * pxDevice = ( LoadGenDevice_t * ) pvParameters;
+    TickType_t xStart;
+    TickType_t xLastWakeTime;
+    uint32_t ulStatus;
+    uint32_t ulPublishes;
+
+    for( ; ; )
+    {
+        xStart = xTaskGetTickCount();
+        ulStatus = prvDeviceConnect( pxDevice );
+
+        taskENTER_CRITICAL();
+        {
+            if( ulStatus == 0 )
+            {
+                xLoadGenStats.ulConnects++;
+                ulLoadGenConnectedDevices++;
+                prvHistogramRecord( &xLoadGenStats.xConnectLatency, prvTicksToMs( xTaskGetTickCount() - xStart ) );
+            }
+            else
+            {
+                xLoadGenStats.ulConnectFailures++;
+            }
+        }
+        taskEXIT_CRITICAL();
+
+        if( ulStatus != 0 )
+        {
+            vTaskDelay( pdMS_TO_TICKS( sampleazureiotRECONNECT_DELAY_MS ) );
+            continue;
+        }
+
+        xLastWakeTime = xTaskGetTickCount();
+
+        for( ulPublishes = 0;
+             ( democonfigLOADGEN_PUBLISHES_PER_CONNECTION == 0 ) || ( ulPublishes < democonfigLOADGEN_PUBLISHES_PER_CONNECTION );
+             ulPublishes++ )
+        {
+            if( prvDevicePublish( pxDevice ) != eAzureIoTSuccess )
+            {
+                LogDebug( ( "%s: publish failed, reconnecting", pxDevice->cDeviceId ) );
+                break;
+            }
+
+            vTaskDelayUntil( &xLastWakeTime, pdMS_TO_TICKS( pxDevice->ulTelemetryIntervalMs ) );
+        }
+
+        prvDeviceDisconnect( pxDevice );
+
+        taskENTER_CRITICAL();
+        {
+            xLoadGenStats.ulDisconnects++;
+            ulLoadGenConnectedDevices--;
+        }
+        taskEXIT_CRITICAL();
+    }
+}
+/*-----------------------------------------------------------*/
+
+static uint64_t prvCpuTimeUs( const struct rusage * pxUsage )
+{
+    return ( ( uint64_t ) pxUsage->ru_utime.tv_sec + ( uint64_t ) pxUsage->ru_stime.tv_sec ) * 1000000U +
+           ( uint64_t ) pxUsage->ru_utime.tv_usec + ( uint64_t ) pxUsage->ru_stime.tv_usec;
+}
+/*-----------------------------------------------------------*/
+
+static void prvPrintHistogram( const char * pcName,
+                               const LoadGenHistogram_t * pxHistogram )
+{
+    LogInfo( ( "  %s latency ms: p50 %u, p90 %u, p99 %u, max %u",
+               pcName,
+               ( unsigned int ) prvHistogramPercentile( pxHistogram, 50 ),
+               ( unsigned int ) prvHistogramPercentile( pxHistogram, 90 ),
+               ( unsigned int ) prvHistogramPercentile( pxHistogram, 99 ),
+               ( unsigned int ) pxHistogram->ulMax ) );
+}
+/*-----------------------------------------------------------*/
+
+/**
+ * @brief Task printing the aggregate statistics.
+ *
+ * @param[in] pvParameters Memory used by the process before any device started, in KB.
+ */
+static void prvReportTask( void * pvParameters )
+{
+    long lBaselineRssKB = ( long ) ( intptr_t ) pvParameters;
+    struct rusage xUsage;
+    uint64_t ullLastCpuTimeUs;
+    uint32_t ulConnectedDevices;
+    uint32_t ulIntervalSec = democonfigLOADGEN_REPORT_INTERVAL_MS / 1000U;
+    TickType_t xLastWakeTime = xTaskGetTickCount();
+
+    getrusage( RUSAGE_SELF, &xUsage );
+    ullLastCpuTimeUs = prvCpuTimeUs( &xUsage );
+
+    for( ; ; )
+    {
+        vTaskDelayUntil( &xLastWakeTime, pdMS_TO_TICKS( democonfigLOADGEN_REPORT_INTERVAL_MS ) );
+
+        taskENTER_CRITICAL();
+        {
+            xLoadGenReport = xLoadGenStats;
+            memset( &xLoadGenStats, 0, sizeof( xLoadGenStats ) );
+            ulConnectedDevices = ulLoadGenConnectedDevices;
+        }
+        taskEXIT_CRITICAL();
+
+        getrusage( RUSAGE_SELF, &xUsage );
+
+        LogInfo( ( "Load generator: %u/%u devices connected",
+                   ( unsigned int ) ulConnectedDevices, ( unsigned int ) democonfigLOADGEN_DEVICE_COUNT ) );
+        LogInfo( ( "  connects/s %u.%02u (%u failed), disconnects %u",
+                   ( unsigned int ) ( xLoadGenReport.ulConnects / ulIntervalSec ),
+                   ( unsigned int ) ( ( xLoadGenReport.ulConnects * 100U / ulIntervalSec ) % 100U ),
+                   ( unsigned int ) xLoadGenReport.ulConnectFailures,
+                   ( unsigned int ) xLoadGenReport.ulDisconnects ) );
+        LogInfo( ( "  publishes/s %u.%02u (%u failed)",
+                   ( unsigned int ) ( xLoadGenReport.ulPublishes / ulIntervalSec ),
+                   ( unsigned int ) ( ( xLoadGenReport.ulPublishes * 100U / ulIntervalSec ) % 100U ),
+                   ( unsigned int ) xLoadGenReport.ulPublishFailures ) );
+        prvPrintHistogram( "connect", &xLoadGenReport.xConnectLatency );
+        prvPrintHistogram( "publish send", &xLoadGenReport.xPublishLatency );
+
+        /* ru_maxrss is the peak resident set, in KB on Linux. */
+        LogInfo( ( "  memory per device %u bytes (%u static), CPU per device %u us/s",
+                   ( unsigned int ) ( ( ( xUsage.ru_maxrss - lBaselineRssKB ) * 1024 ) / democonfigLOADGEN_DEVICE_COUNT ),
+                   ( unsigned int ) sizeof( LoadGenDevice_t ),
+                   ( unsigned int ) ( ( prvCpuTimeUs( &xUsage ) - ullLastCpuTimeUs ) /
+                                      ( ( uint64_t ) ulIntervalSec * democonfigLOADGEN_DEVICE_COUNT ) ) ) );
+
+        ullLastCpuTimeUs = prvCpuTimeUs( &xUsage );
+    }
+}
+/*-----------------------------------------------------------*/
+
+/**
+ * @brief Start the devices, with a short delay between each to avoid
+ *  every TLS handshake happening at once.
+ */
+static void prvStartTask( void * pvParameters )
+{
+    LoadGenDevice_t * pxDevice;
+    uint32_t ulIndex;
+
+    ( void ) pvParameters;
+
+    for( ulIndex = 0; ulIndex < democonfigLOADGEN_DEVICE_COUNT; ulIndex++ )
+    {
+        pxDevice = &xLoadGenDevices[ ulIndex ];
+        pxDevice->ulIndex = ulIndex;
+        pxDevice->ulDeviceIdLength = ( uint32_t ) snprintf( pxDevice->cDeviceId, sizeof( pxDevice->cDeviceId ),
+                                                            "%s-%u", democonfigDEVICE_ID, ( unsigned int ) ulIndex );
+        pxDevice->xNetworkContext.pParams = &pxDevice->xTlsTransportParams;
+
+        /* Spread the devices over +/- 10% of the interval so they do not publish in lockstep. */
+        pxDevice->ulTelemetryIntervalMs = democonfigLOADGEN_TELEMETRY_INTERVAL_MS -
+                                          ( democonfigLOADGEN_TELEMETRY_INTERVAL_MS / 10 ) +
+                                          ( configRAND32() % ( ( democonfigLOADGEN_TELEMETRY_INTERVAL_MS / 5 ) + 1 ) );
+
+        if( ( pxDevice->ulDeviceIdLength >= sizeof( pxDevice->cDeviceId ) ) ||
+            ( prvDeriveDeviceKey( pxDevice ) != 0 ) )
+        {
+            LogError( ( "Failed to set up device %u", ( unsigned int ) ulIndex ) );
+            configASSERT( false );
+        }
+
+        if( xTaskCreate( prvDeviceTask, "LoadGenDevice",
+                         democonfigDEMO_STACKSIZE, pxDevice,
+                         tskIDLE_PRIORITY, NULL ) != pdPASS )
+        {
+            LogError( ( "Failed to create the task of device %u", ( unsigned int ) ulIndex ) );
+            break;
+        }
+
+        vTaskDelay( pdMS_TO_TICKS( democonfigLOADGEN_START_STAGGER_MS ) );
+    }
+
+    LogInfo( ( "Started %u devices", ( unsigned int ) ulIndex ) );
+    vTaskDelete( NULL );
+}
+/*-----------------------------------------------------------*/
+
+/*
+ * @brief Create the tasks of the load generator.
+ */
+void vStartDemoTask( void )
+{
+    struct rusage xUsage;
+
+    configASSERT( AzureIoT_Init() == eAzureIoTSuccess );
+
+    xLoadGenNetworkCredentials.xDisableSni = pdFALSE;
+    xLoadGenNetworkCredentials.pucRootCa = ( const unsigned char * ) democonfigLOADGEN_ROOT_CA_PEM;
+    xLoadGenNetworkCredentials.xRootCaSize = sizeof( democonfigLOADGEN_ROOT_CA_PEM );
+
+    getrusage( RUSAGE_SELF, &xUsage );
+
+    xTaskCreate( prvReportTask, "LoadGenReport",
+                 democonfigDEMO_STACKSIZE, ( void * ) ( intptr_t ) xUsage.ru_maxrss,
+                 tskIDLE_PRIORITY + 1, NULL );
+
+    xTaskCreate( prvStartTask, "LoadGenStart",
+                 democonfigDEMO_STACKSIZE, NULL,
+                 tskIDLE_PRIORITY, NULL );
+}
+/*-----------------------------------------------------------*/
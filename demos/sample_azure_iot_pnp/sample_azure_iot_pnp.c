@@ -18,15 +18,43 @@
 #include "azure_iot_json_reader.h"
 #include "azure_iot_json_writer.h"
 
-/* Exponential backoff retry include. */
-#include "backoff_algorithm.h"
+/* Backoff with jitter between retries. */
+#include "backoff_policy.h"
+#include "token_bucket.h"
 
 /* Transport interface implementation include header for TLS. */
 #include "transport_tls_socket.h"
 
+/* Sockets of the endpoint probes. */
+#include "sockets_wrapper.h"
+
 /* Crypto helper header. */
 #include "crypto.h"
 
+/* SAS token reuse and renewal. */
+#include "sas_token_cache.h"
+
+/* Provisioning result cache. */
+#include "provisioning_cache.h"
+
+/* Main loop deadlines. */
+#include "deadline_scheduler.h"
+
+/* Polling of a pending registration with the Provisioning service. */
+#include "provisioning_poll.h"
+
+/* Telemetry kept until acknowledged. */
+#include "telemetry_outbox.h"
+
+/* Recovery from failures. */
+#include "connection_supervisor.h"
+
+/* Choice between geo-redundant IoT Hubs. */
+#include "endpoint_selector.h"
+
+/* Telemetry compression. */
+#include "payload_compression.h"
+
 /* Demo Specific configs. */
 #include "demo_config.h"
 
@@ -35,6 +63,20 @@
 
 /*-----------------------------------------------------------*/
 
+/**
+ * @brief Work of the main loop, by index of its deadline.
+ */
+typedef enum SampleDeadline
+{
+    eSampleDeadlineTelemetry = 0,
+    eSampleDeadlineProperties,
+    eSampleDeadlineKeepAlive,
+    eSampleDeadlineTokenRenewal,
+    eSampleDeadlineEndpointProbe,
+    eSampleDeadlineCount
+} SampleDeadline_t;
+/*-----------------------------------------------------------*/
+
 /* Compile time error for undefined configs. */
 #if !defined( democonfigHOSTNAME ) && !defined( democonfigENABLE_DPS_SAMPLE )
     #error "Define the config democonfigHOSTNAME by following the instructions in file demo_config.h."
@@ -44,6 +86,10 @@
     #error "Define the config dps endpoint by following the instructions in file demo_config.h."
 #endif
 
+#if defined( democonfigENABLE_DPS_CACHE ) && !defined( democonfigENABLE_DPS_SAMPLE )
+    #error "democonfigENABLE_DPS_CACHE requires democonfigENABLE_DPS_SAMPLE in demo_config.h."
+#endif
+
 #ifndef democonfigROOT_CA_PEM
     #error "Please define Root CA certificate of the IoT Hub(democonfigROOT_CA_PEM) in demo_config.h."
 #endif
@@ -74,6 +120,41 @@
  */
 #define sampleazureiotRETRY_BACKOFF_BASE_MS                   ( 500U )
 
+/**
+ * @brief The base back-off delay (in milliseconds) to recover from transient failures,
+ * such as a lost connection.
+ */
+#define sampleazureiotTRANSIENT_BACKOFF_BASE_MS               ( 1000U )
+
+/**
+ * @brief The base back-off delay (in milliseconds) to recover from the IoT Hub
+ * or the Provisioning service refusing the device.
+ */
+#define sampleazureiotAUTH_BACKOFF_BASE_MS                    ( 10000U )
+
+/**
+ * @brief The maximum back-off delay (in milliseconds) between two recoveries.
+ * Long enough for a fleet to spread its reconnections after a regional outage.
+ */
+#define sampleazureiotRECOVERY_MAX_BACKOFF_DELAY_MS           ( 5U * 60U * 1000U )
+
+/**
+ * @brief Number of recoveries that may happen in a burst.
+ */
+#define sampleazureiotRETRY_BUDGET_TOKENS                     ( 10U )
+
+/**
+ * @brief Time in milliseconds to earn one more recovery once the burst is spent.
+ */
+#define sampleazureiotRETRY_BUDGET_REFILL_MS                  ( 60U * 1000U )
+
+/**
+ * @brief The least time (in milliseconds) to hold back publishes once the IoT Hub
+ * throttles the device. The IoT Hub does not tell for how long, this covers the
+ * windows its quotas are metered over.
+ */
+#define sampleazureiotTHROTTLED_RETRY_AFTER_MS                ( 10U * 1000U )
+
 /**
  * @brief Timeout for receiving CONNACK packet in milliseconds.
  */
@@ -91,18 +172,21 @@
 #define sampleazureiotDELAY_BETWEEN_DEMO_ITERATIONS_TICKS     ( pdMS_TO_TICKS( 5000U ) )
 
 /**
- * @brief Timeout for MQTT_ProcessLoop in milliseconds.
+ * @brief Time in milliseconds between two telemetry messages.
  */
-#define sampleazureiotPROCESS_LOOP_TIMEOUT_MS                 ( 500U )
+#define sampleazureiotTELEMETRY_INTERVAL_MS                   ( 2000U )
 
 /**
- * @brief Delay (in ticks) between consecutive cycles of MQTT publish operations in a
- * demo iteration.
- *
- * Note that the process loop also has a timeout, so the total time between
- * publishes is the sum of the two delays.
+ * @brief Time in milliseconds between two checks for reported properties to send,
+ * so that a property changing quickly is reported at most this often.
  */
-#define sampleazureiotDELAY_BETWEEN_PUBLISHES_TICKS           ( pdMS_TO_TICKS( 2000U ) )
+#define sampleazureiotPROPERTIES_DEBOUNCE_MS                  ( 5000U )
+
+/**
+ * @brief Time in milliseconds between two runs of the MQTT process loop while
+ * no data is received, for it to send a PINGREQ in time.
+ */
+#define sampleazureiotKEEP_ALIVE_INTERVAL_MS                  ( azureiotconfigKEEP_ALIVE_TIMEOUT_SECONDS * 1000U / 4U )
 
 /**
  * @brief Transport timeout in milliseconds for transport send and receive.
@@ -110,10 +194,56 @@
 #define sampleazureiotTRANSPORT_SEND_RECV_TIMEOUT_MS          ( 2000U )
 
 /**
- * @brief Transport timeout in milliseconds for transport send and receive.
+ * @brief Time in milliseconds each call to register with the Provisioning service
+ * waits for progress, enough for the service to answer one request.
  */
 #define sampleazureiotProvisioning_Registration_TIMEOUT_MS    ( 3 * 1000U )
 
+/**
+ * @brief Shortest and longest time in milliseconds between two calls to register
+ * while the registration is pending and the service sent no retry-after, with
+ * decorrelated jitter in between.
+ */
+#define sampleazureiotPROVISIONING_POLL_FLOOR_MS              ( 2 * 1000U )
+#define sampleazureiotPROVISIONING_POLL_CEILING_MS            ( 20 * 1000U )
+
+/**
+ * @brief Unix time in seconds until which the service asked the Provisioning
+ * client not to query the status of its registration, 0 for none.
+ *
+ * The middleware records the retry-after of the last status in its client
+ * state, without an accessor. Define this for a middleware that keeps it
+ * elsewhere.
+ */
+#ifndef sampleazureiotPROVISIONING_RETRY_AFTER
+    #define sampleazureiotPROVISIONING_RETRY_AFTER( pxClient )    ( ( pxClient )->_internal.ullRetryAfter )
+#endif
+
+/**
+ * @brief Time in milliseconds for a registration to complete, after which it is
+ * left to the next recovery.
+ */
+#define sampleazureiotPROVISIONING_TIMEOUT_MS                 ( 60 * 1000U )
+
+/**
+ * @brief Number of IoT Hub endpoints, the secondary one being optional.
+ */
+#ifdef democonfigHOSTNAME_SECONDARY
+    #define sampleazureiotENDPOINT_COUNT                      ( 2U )
+#else
+    #define sampleazureiotENDPOINT_COUNT                      ( 1U )
+#endif
+
+/**
+ * @brief Time in milliseconds between two probes of the IoT Hub endpoints.
+ */
+#define sampleazureiotENDPOINT_PROBE_INTERVAL_MS              ( 10U * 60U * 1000U )
+
+/**
+ * @brief Longest time in milliseconds the TCP connect of a probe may take.
+ */
+#define sampleazureiotENDPOINT_PROBE_TIMEOUT_MS               ( 2U * 1000U )
+
 /**
  * @brief Wait timeout for subscribe to finish.
  */
@@ -135,6 +265,14 @@ uint64_t ullGetUnixTime( void );
     static AzureIoTProvisioningClient_t xAzureIoTProvisioningClient;
 #endif /* democonfigENABLE_DPS_SAMPLE */
 
+#ifdef democonfigENABLE_DPS_CACHE
+    static ProvisioningCacheEntry_t xProvisioningCacheEntry;
+
+/* Set while the IoT Hub info in use was read from the cache rather than
+ * returned by the Provisioning service. */
+    static bool xSampleIotHubInfoFromCache = false;
+#endif /* democonfigENABLE_DPS_CACHE */
+
 /* Each compilation unit must define the NetworkContext struct. */
 struct NetworkContext
 {
@@ -143,8 +281,18 @@ struct NetworkContext
 
 AzureIoTHubClient_t xAzureIoTHubClient;
 
-/* Telemetry buffers */
-static uint8_t ucScratchBuffer[ 512 ];
+#ifdef democonfigTELEMETRY_COMPRESSION_THRESHOLD
+
+/**
+ * @brief Message properties of compressed telemetry, URL encoded.
+ */
+    #define sampleazureiotCOMPRESSED_CONTENT_TYPE    "application%2Fjson"
+
+    static PayloadCompressionContext_t xTelemetryCompressionContext;
+    static AzureIoTMessageProperties_t xCompressedTelemetryProperties;
+    static uint8_t ucCompressedTelemetryPropertiesBuffer[ 48 ];
+    static bool xCompressedTelemetryPropertiesReady = false;
+#endif /* democonfigTELEMETRY_COMPRESSION_THRESHOLD */
 
 /* Command buffers */
 static uint8_t ucCommandResponsePayloadBuffer[ 256 ];
@@ -152,6 +300,25 @@ static uint8_t ucCommandResponsePayloadBuffer[ 256 ];
 /* Reported Properties buffers */
 static uint8_t ucReportedPropertiesUpdate[ 320 ];
 static uint32_t ulReportedPropertiesUpdateLength;
+
+#ifdef democonfigPERSISTENT_SESSION
+    /* Telemetry sent and not acknowledged yet */
+    static TelemetryOutbox_t xTelemetryOutbox;
+#endif /* democonfigPERSISTENT_SESSION */
+
+/* Recovery from failures */
+static ConnectionSupervisor_t xConnectionSupervisor;
+static BackoffPolicy_t xRecoveryBackoff[ eConnectionSupervisorErrorClassCount ];
+static BackoffPolicy_t xRetryBackoff;
+static TokenBucket_t xRetryBudget;
+
+/* Publishes held back by the IoT Hub throttling the device, 0 when they are not */
+static BackoffPolicy_t xThrottleBackoff;
+static uint32_t ulThrottleDelayMs;
+
+/* IoT Hub endpoints, the first one from the configuration or the Provisioning service */
+static EndpointSelectorEntry_t xEndpoints[ sampleazureiotENDPOINT_COUNT ];
+static EndpointSelector_t xEndpointSelector;
 /*-----------------------------------------------------------*/
 
 #ifdef democonfigENABLE_DPS_SAMPLE
@@ -174,6 +341,31 @@ static uint32_t ulReportedPropertiesUpdateLength;
 
 #endif /* democonfigENABLE_DPS_SAMPLE */
 
+#ifdef democonfigENABLE_DPS_CACHE
+
+/**
+ * @brief Fingerprint of the inputs the Provisioning service result depends on.
+ */
+    static uint32_t prvProvisioningCacheFingerprint( void );
+
+/**
+ * @brief Load the IoT Hub endpoint and deviceId assigned on a previous boot.
+ *
+ * @param[out] pulIothubHostnameLength  Length of the hostname copied to ucSampleIotHubHostname
+ * @param[out] pulIothubDeviceIdLength  Length of the deviceId copied to ucSampleIotHubDeviceId
+ * @return 0 if a valid entry was found, non-zero otherwise.
+ */
+    static uint32_t prvProvisioningCacheLoad( uint32_t * pulIothubHostnameLength,
+                                              uint32_t * pulIothubDeviceIdLength );
+
+/**
+ * @brief Persist the IoT Hub endpoint and deviceId returned by the Provisioning service.
+ */
+    static void prvProvisioningCacheStore( uint32_t ulIothubHostnameLength,
+                                           uint32_t ulIothubDeviceIdLength );
+
+#endif /* democonfigENABLE_DPS_CACHE */
+
 /**
  * @brief The task used to demonstrate the Azure IoT Hub API.
  *
@@ -206,6 +398,23 @@ static uint32_t prvConnectToServerWithBackoffRetries( const char * pcHostName,
  */
 static uint8_t ucMQTTMessageBuffer[ democonfigNETWORK_BUFFER_SIZE ];
 
+/**
+ * @brief Bytes at the start of ucMQTTMessageBuffer that sending telemetry writes to.
+ *
+ * The hub client builds the topic in its working buffer, the first
+ * azureiotconfigUSERNAME_MAX + azureiotconfigPASSWORD_MAX bytes, and serializes
+ * the PUBLISH header in the network buffer after it: 5 bytes of fixed header,
+ * the topic with its 2 bytes length and 2 bytes of packet identifier. The
+ * payload is sent from where it lies, so telemetry is written in place after
+ * this space rather than in a buffer of its own.
+ */
+#define sampleazureiotWORKING_BUFFER_SIZE       ( azureiotconfigUSERNAME_MAX + azureiotconfigPASSWORD_MAX )
+#define sampleazureiotTELEMETRY_HEADER_SPACE    ( 2 * sampleazureiotWORKING_BUFFER_SIZE + 9 )
+
+#if democonfigNETWORK_BUFFER_SIZE <= sampleazureiotTELEMETRY_HEADER_SPACE
+    #error "democonfigNETWORK_BUFFER_SIZE leaves no room for telemetry."
+#endif
+
 /**
  * @brief Internal function for handling Command requests.
  *
@@ -236,6 +445,134 @@ static void prvHandleCommand( AzureIoTHubClientCommandRequest_t * pxMessage,
 }
 
 
+#ifdef democonfigTELEMETRY_COMPRESSION_THRESHOLD
+
+/**
+ * @brief Replace a telemetry payload by its compressed form, when it has no
+ *        properties of its own, is large enough and gets shorter.
+ *
+ * Command responses and reported properties are left as they are: the IoT Hub
+ * reads them as JSON, and they carry no content encoding.
+ *
+ * The compressed payload is written to @p pucOutput, which must not overlap the payload.
+ */
+    static void prvCompressTelemetry( const uint8_t ** ppucTelemetry,
+                                      uint32_t * pulTelemetryLength,
+                                      AzureIoTMessageProperties_t ** ppxTelemetryProperties,
+                                      uint8_t * pucOutput,
+                                      uint32_t ulOutputSize )
+    {
+        AzureIoTResult_t xResult;
+        uint32_t ulCompressedLength;
+
+        if( ( *ppxTelemetryProperties != NULL ) ||
+            ( *pulTelemetryLength < democonfigTELEMETRY_COMPRESSION_THRESHOLD ) )
+        {
+            return;
+        }
+
+        if( !xCompressedTelemetryPropertiesReady )
+        {
+            xResult = AzureIoTMessage_PropertiesInit( &xCompressedTelemetryProperties, ucCompressedTelemetryPropertiesBuffer,
+                                                      0, sizeof( ucCompressedTelemetryPropertiesBuffer ) );
+            configASSERT( xResult == eAzureIoTSuccess );
+
+            xResult = AzureIoTMessage_PropertiesAppend( &xCompressedTelemetryProperties,
+                                                        ( const uint8_t * ) "$.ct", sizeof( "$.ct" ) - 1,
+                                                        ( const uint8_t * ) sampleazureiotCOMPRESSED_CONTENT_TYPE,
+                                                        sizeof( sampleazureiotCOMPRESSED_CONTENT_TYPE ) - 1 );
+            configASSERT( xResult == eAzureIoTSuccess );
+
+            xResult = AzureIoTMessage_PropertiesAppend( &xCompressedTelemetryProperties,
+                                                        ( const uint8_t * ) "$.ce", sizeof( "$.ce" ) - 1,
+                                                        ( const uint8_t * ) payloadcompressionCONTENT_ENCODING,
+                                                        sizeof( payloadcompressionCONTENT_ENCODING ) - 1 );
+            configASSERT( xResult == eAzureIoTSuccess );
+
+            xCompressedTelemetryPropertiesReady = true;
+        }
+
+        ulCompressedLength = PayloadCompression_Deflate( &xTelemetryCompressionContext,
+                                                         *ppucTelemetry, *pulTelemetryLength,
+                                                         pucOutput, ulOutputSize );
+
+        if( ulCompressedLength != 0 )
+        {
+            LogInfo( ( "Telemetry compressed from %u to %u bytes.\r\n",
+                       ( unsigned ) *pulTelemetryLength, ( unsigned ) ulCompressedLength ) );
+            *ppucTelemetry = pucOutput;
+            *pulTelemetryLength = ulCompressedLength;
+            *ppxTelemetryProperties = &xCompressedTelemetryProperties;
+        }
+    }
+/*-----------------------------------------------------------*/
+#endif /* democonfigTELEMETRY_COMPRESSION_THRESHOLD */
+
+/**
+ * @brief Reserve the window of ucMQTTMessageBuffer telemetry is written to, in place.
+ *
+ * The window holds the telemetry until prvTelemetryCommit(). Nothing that
+ * receives from the IoT Hub may run in between, as packets are received in
+ * the same buffer.
+ *
+ * @param[out] pulWindowSize Size of the window.
+ * @return The start of the window.
+ */
+static uint8_t * prvTelemetryReserve( uint32_t * pulWindowSize )
+{
+    *pulWindowSize = sizeof( ucMQTTMessageBuffer ) - sampleazureiotTELEMETRY_HEADER_SPACE;
+
+    return &ucMQTTMessageBuffer[ sampleazureiotTELEMETRY_HEADER_SPACE ];
+}
+/*-----------------------------------------------------------*/
+
+/**
+ * @brief Send telemetry written in the window of prvTelemetryReserve(), without copying it.
+ */
+static AzureIoTResult_t prvTelemetryCommit( const uint8_t * pucTelemetry,
+                                            uint32_t ulTelemetryLength,
+                                            AzureIoTMessageProperties_t * pxTelemetryProperties )
+{
+    AzureIoTResult_t xResult;
+    uint16_t usPacketID;
+
+    configASSERT( ( pucTelemetry >= &ucMQTTMessageBuffer[ sampleazureiotTELEMETRY_HEADER_SPACE ] ) &&
+                  ( ulTelemetryLength <= ( uint32_t ) ( &ucMQTTMessageBuffer[ sizeof( ucMQTTMessageBuffer ) ] - pucTelemetry ) ) );
+
+    xResult = AzureIoTHubClient_SendTelemetry( &xAzureIoTHubClient,
+                                               pucTelemetry, ulTelemetryLength,
+                                               pxTelemetryProperties, eAzureIoTHubMessageQoS1, &usPacketID );
+
+    #ifdef democonfigPERSISTENT_SESSION
+        /* Keep a copy, the MQTT buffer is reused by the next message. The
+         * readings are routine: they leave a slot free for urgent messages,
+         * such as alerts, which are sent again first after a reconnect. */
+        if( ( xResult == eAzureIoTSuccess ) &&
+            ( TelemetryOutbox_Add( &xTelemetryOutbox, eTelemetryOutboxClassRoutine, usPacketID,
+                                   pucTelemetry, ulTelemetryLength,
+                                   pxTelemetryProperties ) != eAzureIoTSuccess ) )
+        {
+            LogWarn( ( "Telemetry %u not kept for retransmission, outbox full.\r\n", usPacketID ) );
+        }
+    #endif /* democonfigPERSISTENT_SESSION */
+
+    return xResult;
+}
+/*-----------------------------------------------------------*/
+
+#ifdef democonfigPERSISTENT_SESSION
+
+/**
+ * @brief Telemetry PUBACK callback, releasing the copy of the message.
+ */
+    static void prvHandleTelemetryAck( uint16_t usPacketID )
+    {
+        TelemetryOutbox_Acknowledge( &xTelemetryOutbox, usPacketID );
+    }
+/*-----------------------------------------------------------*/
+
+#endif /* democonfigPERSISTENT_SESSION */
+
 static void prvDispatchPropertiesUpdate( AzureIoTHubClientPropertiesResponse_t * pxMessage )
 {
     vHandleWritableProperties( pxMessage,
@@ -286,6 +623,21 @@ static void prvHandleProperties( AzureIoTHubClientPropertiesResponse_t * pxMessa
 
         case eAzureIoTHubPropertiesReportedResponseMessage:
             LogDebug( ( "Device reported property response received" ) );
+
+            if( ( pxMessage->xMessageStatus == eAzureIoTStatusThrottled ) ||
+                ( pxMessage->xMessageStatus == eAzureIoTStatusServiceUnavailable ) )
+            {
+                /* Wait at least the hint, longer if the IoT Hub keeps refusing. */
+                BackoffPolicy_SetRetryAfter( &xThrottleBackoff, sampleazureiotTHROTTLED_RETRY_AFTER_MS );
+                ulThrottleDelayMs = BackoffPolicy_NextDelay( &xThrottleBackoff, configRAND32() );
+                LogWarn( ( "IoT Hub throttled the device: status %u. Holding publishes for %u ms.\r\n",
+                           pxMessage->xMessageStatus, ulThrottleDelayMs ) );
+            }
+            else
+            {
+                BackoffPolicy_Reset( &xThrottleBackoff );
+            }
+
             break;
 
         default:
@@ -295,6 +647,148 @@ static void prvHandleProperties( AzureIoTHubClientPropertiesResponse_t * pxMessa
 }
 /*-----------------------------------------------------------*/
 
+/**
+ * @brief Report a failure to the supervisor, and get the recovery to perform.
+ *  The sample stops once the recovery is eConnectionSupervisorActionHalt.
+ */
+static ConnectionSupervisorAction_t prvHandleFailure( ConnectionSupervisorStage_t xStage,
+                                                      AzureIoTResult_t xResult )
+{
+    return ConnectionSupervisor_ReportFailure( &xConnectionSupervisor, xStage, xResult,
+                                               DeadlineScheduler_GetTimeMs() );
+}
+/*-----------------------------------------------------------*/
+
+/**
+ * @brief Report a failure of an operation on the connection, and wait before
+ *  doing it again when that is the recovery to perform.
+ *
+ * @return true if the operation is to be done again.
+ */
+static bool prvRetryAfterFailure( ConnectionSupervisorStage_t xStage,
+                                  AzureIoTResult_t xResult,
+                                  ConnectionSupervisorAction_t * pxAction )
+{
+    uint32_t ulDelayMs;
+
+    *pxAction = prvHandleFailure( xStage, xResult );
+
+    if( *pxAction != eConnectionSupervisorActionRetry )
+    {
+        return false;
+    }
+
+    ulDelayMs = BackoffPolicy_NextDelay( &xRetryBackoff, configRAND32() );
+    LogWarn( ( "Operation failed: result 0x%08x. Retrying in %u ms.\r\n", xResult, ulDelayMs ) );
+    vTaskDelay( pdMS_TO_TICKS( ulDelayMs ) );
+
+    return true;
+}
+/*-----------------------------------------------------------*/
+
+/**
+ * @brief Report that the sample is back to normal.
+ */
+static void prvReportRecovered( void )
+{
+    ConnectionSupervisor_ReportRecovered( &xConnectionSupervisor, DeadlineScheduler_GetTimeMs() );
+    BackoffPolicy_Reset( &xRetryBackoff );
+}
+/*-----------------------------------------------------------*/
+
+/**
+ * @brief Wait before connecting again after a failure, according to its class.
+ *
+ * Once the retry budget is spent, recoveries are paced by its refill rather
+ * than given up, so the device keeps trying at a low rate however long the
+ * outage lasts.
+ */
+static void prvBackoffBeforeConnecting( void )
+{
+    uint32_t ulIndex;
+    uint32_t ulDelayMs;
+    uint32_t ulBudgetWaitMs;
+
+    if( !xConnectionSupervisor.xRecovering )
+    {
+        for( ulIndex = 0; ulIndex < eConnectionSupervisorErrorClassCount; ulIndex++ )
+        {
+            BackoffPolicy_Reset( &xRecoveryBackoff[ ulIndex ] );
+        }
+
+        return;
+    }
+
+    ulDelayMs = BackoffPolicy_NextDelay( &xRecoveryBackoff[ xConnectionSupervisor.xOutageClass ], configRAND32() );
+    ulBudgetWaitMs = TokenBucket_TimeToToken( &xRetryBudget, DeadlineScheduler_GetTimeMs() );
+
+    if( ulBudgetWaitMs > ulDelayMs )
+    {
+        LogWarn( ( "Retry budget spent, next attempt in %u ms.\r\n", ulBudgetWaitMs ) );
+        ulDelayMs = ulBudgetWaitMs;
+    }
+    else
+    {
+        LogInfo( ( "Next attempt in %u ms.\r\n", ulDelayMs ) );
+    }
+
+    vTaskDelay( pdMS_TO_TICKS( ulDelayMs ) );
+    ( void ) TokenBucket_TryTake( &xRetryBudget, DeadlineScheduler_GetTimeMs() );
+}
+/*-----------------------------------------------------------*/
+
+#ifdef democonfigHOSTNAME_SECONDARY
+
+/**
+ * @brief Measure the TCP connect time of the IoT Hub endpoints, so the next
+ *  connection goes to the healthiest.
+ *
+ * A TCP connect takes one round trip and no memory beyond a socket, unlike a
+ * second TLS session, so the loop only waits for it, at most the probe timeout
+ * per endpoint once its name is resolved. The time measured leaves the name
+ * resolution out. The endpoint in use is skipped while connected, keeping the
+ * time measured before connecting to it.
+ *
+ * @param[in] xConnected Whether the device is connected to the current endpoint.
+ */
+    static void prvProbeEndpoints( bool xConnected )
+    {
+        SocketHandle xSocket;
+        BaseType_t xSocketStatus;
+        uint32_t ulConnectTimeMs = 0;
+        uint32_t ulIndex;
+
+        for( ulIndex = 0; ulIndex < sampleazureiotENDPOINT_COUNT; ulIndex++ )
+        {
+            if( xConnected && ( ulIndex == xEndpointSelector.ulCurrent ) )
+            {
+                continue;
+            }
+
+            if( ( xSocket = Sockets_Open() ) == SOCKETS_INVALID_SOCKET )
+            {
+                LogWarn( ( "Failed to open a socket to probe %s.", xEndpoints[ ulIndex ].pucHostName ) );
+                return;
+            }
+
+            xSocketStatus = Sockets_Probe( xSocket, ( const char * ) xEndpoints[ ulIndex ].pucHostName,
+                                           democonfigIOTHUB_PORT, sampleazureiotENDPOINT_PROBE_TIMEOUT_MS,
+                                           &ulConnectTimeMs );
+            EndpointSelector_ReportProbe( &xEndpointSelector, ulIndex, xSocketStatus == SOCKETS_ERROR_NONE,
+                                          ulConnectTimeMs );
+
+            if( xSocketStatus == SOCKETS_ERROR_NONE )
+            {
+                Sockets_Disconnect( xSocket );
+            }
+
+            ( void ) Sockets_Close( xSocket );
+        }
+    }
+/*-----------------------------------------------------------*/
+
+#endif /* democonfigHOSTNAME_SECONDARY */
+
 /**
  * @brief Setup transport credentials.
  */
@@ -322,7 +816,11 @@ static uint32_t prvSetupNetworkCredentials( NetworkCredentials_t * pxNetworkCred
  */
 static void prvAzureDemoTask( void * pvParameters )
 {
-    uint32_t ulScratchBufferLength = 0U;
+    uint8_t * pucTelemetryWindow;
+    uint32_t ulTelemetryWindowSize;
+    uint32_t ulTelemetryLength = 0U;
+    AzureIoTMessageProperties_t * pxTelemetryProperties;
+    const uint8_t * pucTelemetry;
     NetworkCredentials_t xNetworkCredentials = { 0 };
     AzureIoTTransportInterface_t xTransport;
     NetworkContext_t xNetworkContext = { 0 };
@@ -331,6 +829,17 @@ static void prvAzureDemoTask( void * pvParameters )
     uint32_t ulStatus;
     AzureIoTHubClientOptions_t xHubOptions = { 0 };
     bool xSessionPresent;
+    DeadlineSchedulerEntry_t xDeadlines[ eSampleDeadlineCount ];
+    DeadlineScheduler_t xScheduler;
+    uint64_t ullNow;
+    uint64_t ullWait;
+    int32_t lDataReady;
+    ConnectionSupervisorAction_t xAction;
+    const EndpointSelectorEntry_t * pxEndpoint;
+
+    #ifdef democonfigDEVICE_SYMMETRIC_KEY
+        uint64_t ullUnixTime;
+    #endif /* democonfigDEVICE_SYMMETRIC_KEY */
 
     #ifdef democonfigENABLE_DPS_SAMPLE
         uint8_t * pucIotHubHostname = NULL;
@@ -352,31 +861,99 @@ static void prvAzureDemoTask( void * pvParameters )
     ulStatus = prvSetupNetworkCredentials( &xNetworkCredentials );
     configASSERT( ulStatus == 0 );
 
+    xNetworkContext.pParams = &xTlsTransportParams;
+
+    #ifdef democonfigPERSISTENT_SESSION
+        TelemetryOutbox_Init( &xTelemetryOutbox );
+    #endif /* democonfigPERSISTENT_SESSION */
+
     #ifdef democonfigENABLE_DPS_SAMPLE
-        /* Run DPS.  */
-        if( ( ulStatus = prvIoTHubInfoGet( &xNetworkCredentials, &pucIotHubHostname,
-                                           &pulIothubHostnameLength, &pucIotHubDeviceId,
-                                           &pulIothubDeviceIdLength ) ) != 0 )
-        {
-            LogError( ( "Failed on sample_dps_entry!: error code = 0x%08x\r\n", ulStatus ) );
-            return;
-        }
+        ConnectionSupervisor_Init( &xConnectionSupervisor, true );
+
+        /* Run DPS before the first connection. */
+        xAction = eConnectionSupervisorActionReprovision;
+    #else
+        ConnectionSupervisor_Init( &xConnectionSupervisor, false );
+        xAction = eConnectionSupervisorActionReconnect;
     #endif /* democonfigENABLE_DPS_SAMPLE */
 
-    xNetworkContext.pParams = &xTlsTransportParams;
+    /* Each class of failure backs off on its own, a device refused by the
+     * IoT Hub has no reason to retry as early as one that lost its network. */
+    BackoffPolicy_Init( &xRecoveryBackoff[ eConnectionSupervisorErrorTransient ], eBackoffPolicyDecorrelatedJitter,
+                        sampleazureiotTRANSIENT_BACKOFF_BASE_MS, sampleazureiotRECOVERY_MAX_BACKOFF_DELAY_MS );
+    BackoffPolicy_Init( &xRecoveryBackoff[ eConnectionSupervisorErrorAuth ], eBackoffPolicyFullJitter,
+                        sampleazureiotAUTH_BACKOFF_BASE_MS, sampleazureiotRECOVERY_MAX_BACKOFF_DELAY_MS );
+    BackoffPolicy_Init( &xRecoveryBackoff[ eConnectionSupervisorErrorFatal ], eBackoffPolicyFullJitter,
+                        sampleazureiotAUTH_BACKOFF_BASE_MS, sampleazureiotRECOVERY_MAX_BACKOFF_DELAY_MS );
+    BackoffPolicy_Init( &xRetryBackoff, eBackoffPolicyDecorrelatedJitter,
+                        sampleazureiotRETRY_BACKOFF_BASE_MS, sampleazureiotRETRY_MAX_BACKOFF_DELAY_MS );
+    TokenBucket_Init( &xRetryBudget, sampleazureiotRETRY_BUDGET_TOKENS,
+                      sampleazureiotRETRY_BUDGET_REFILL_MS, DeadlineScheduler_GetTimeMs() );
+    BackoffPolicy_Init( &xThrottleBackoff, eBackoffPolicyDecorrelatedJitter,
+                        sampleazureiotRETRY_BACKOFF_BASE_MS, sampleazureiotRECOVERY_MAX_BACKOFF_DELAY_MS );
+
+    #ifdef democonfigHOSTNAME_SECONDARY
+        xEndpoints[ 1 ].pucHostName = ( const uint8_t * ) democonfigHOSTNAME_SECONDARY;
+        xEndpoints[ 1 ].ulHostNameLength = sizeof( democonfigHOSTNAME_SECONDARY ) - 1;
+    #endif /* democonfigHOSTNAME_SECONDARY */
+
+    EndpointSelector_Init( &xEndpointSelector, xEndpoints, sampleazureiotENDPOINT_COUNT );
 
     for( ; ; )
     {
+        if( xAction == eConnectionSupervisorActionHalt )
+        {
+            LogError( ( "Failure that no recovery can fix, stopping the sample.\r\n" ) );
+            break;
+        }
+
+        prvBackoffBeforeConnecting();
+
+        #ifdef democonfigENABLE_DPS_SAMPLE
+            if( xAction == eConnectionSupervisorActionReprovision )
+            {
+                if( ( ulStatus = prvIoTHubInfoGet( &xNetworkCredentials, &pucIotHubHostname,
+                                                   &pulIothubHostnameLength, &pucIotHubDeviceId,
+                                                   &pulIothubDeviceIdLength ) ) != 0 )
+                {
+                    LogError( ( "Failed on sample_dps_entry!: error code = 0x%08x\r\n", ulStatus ) );
+                    xAction = prvHandleFailure( eConnectionSupervisorStageProvision, ( AzureIoTResult_t ) ulStatus );
+                    continue;
+                }
+            }
+        #endif /* democonfigENABLE_DPS_SAMPLE */
+
+        /* The primary IoT Hub changes with each provisioning. */
+        xEndpoints[ 0 ].pucHostName = pucIotHubHostname;
+        xEndpoints[ 0 ].ulHostNameLength = pulIothubHostnameLength;
+
+        #ifdef democonfigHOSTNAME_SECONDARY
+            /* Measure every endpoint before the first connection, the probes
+             * of the loop then skip the one in use. */
+            if( !xEndpoints[ xEndpointSelector.ulCurrent ].xProbed )
+            {
+                prvProbeEndpoints( false );
+            }
+        #endif /* democonfigHOSTNAME_SECONDARY */
+
+        pxEndpoint = EndpointSelector_Select( &xEndpointSelector );
+
         /* Attempt to establish TLS session with IoT Hub. If connection fails,
          * retry after a timeout. Timeout value will be exponentially increased
          * until  the maximum number of attempts are reached or the maximum timeout
          * value is reached. The function returns a failure status if the TCP
          * connection cannot be established to the IoT Hub after the configured
          * number of attempts. */
-        ulStatus = prvConnectToServerWithBackoffRetries( ( const char * ) pucIotHubHostname,
+        ulStatus = prvConnectToServerWithBackoffRetries( ( const char * ) pxEndpoint->pucHostName,
                                                          democonfigIOTHUB_PORT,
                                                          &xNetworkCredentials, &xNetworkContext );
-        configASSERT( ulStatus == 0 );
+
+        if( ulStatus != 0 )
+        {
+            EndpointSelector_ReportConnection( &xEndpointSelector, false );
+            xAction = prvHandleFailure( eConnectionSupervisorStageTransport, eAzureIoTErrorFailed );
+            continue;
+        }
 
         /* Fill in Transport Interface send and receive function pointers. */
         xTransport.pxNetworkContext = &xNetworkContext;
@@ -392,12 +969,16 @@ static void prvAzureDemoTask( void * pvParameters )
         xHubOptions.pucModelID = ( const uint8_t * ) sampleazureiotMODEL_ID;
         xHubOptions.ulModelIDLength = sizeof( sampleazureiotMODEL_ID ) - 1;
 
+        #ifdef democonfigPERSISTENT_SESSION
+            xHubOptions.xTelemetryCallback = prvHandleTelemetryAck;
+        #endif /* democonfigPERSISTENT_SESSION */
+
         xResult = AzureIoTHubClient_Init( &xAzureIoTHubClient,
-                                          pucIotHubHostname, pulIothubHostnameLength,
+                                          pxEndpoint->pucHostName, pxEndpoint->ulHostNameLength,
                                           pucIotHubDeviceId, pulIothubDeviceIdLength,
                                           &xHubOptions,
                                           ucMQTTMessageBuffer, sizeof( ucMQTTMessageBuffer ),
-                                          ullGetUnixTime,
+                                          SASTokenCache_GetTime,
                                           &xTransport );
         configASSERT( xResult == eAzureIoTSuccess );
 
@@ -405,90 +986,279 @@ static void prvAzureDemoTask( void * pvParameters )
             xResult = AzureIoTHubClient_SetSymmetricKey( &xAzureIoTHubClient,
                                                          ( const uint8_t * ) democonfigDEVICE_SYMMETRIC_KEY,
                                                          sizeof( democonfigDEVICE_SYMMETRIC_KEY ) - 1,
-                                                         Crypto_HMAC );
+                                                         SASTokenCache_HMAC );
             configASSERT( xResult == eAzureIoTSuccess );
         #endif /* democonfigDEVICE_SYMMETRIC_KEY */
 
         /* Sends an MQTT Connect packet over the already established TLS connection,
          * and waits for connection acknowledgment (CONNACK) packet. */
-        LogInfo( ( "Creating an MQTT connection to %s.\r\n", pucIotHubHostname ) );
+        LogInfo( ( "Creating an MQTT connection to %s.\r\n", pxEndpoint->pucHostName ) );
 
         xResult = AzureIoTHubClient_Connect( &xAzureIoTHubClient,
                                              false, &xSessionPresent,
                                              sampleazureiotCONNACK_RECV_TIMEOUT_MS );
-        configASSERT( xResult == eAzureIoTSuccess );
+        EndpointSelector_ReportConnection( &xEndpointSelector, xResult == eAzureIoTSuccess );
 
-        xResult = AzureIoTHubClient_SubscribeCommand( &xAzureIoTHubClient, prvHandleCommand,
-                                                      &xAzureIoTHubClient, sampleazureiotSUBSCRIBE_TIMEOUT );
-        configASSERT( xResult == eAzureIoTSuccess );
-
-        xResult = AzureIoTHubClient_SubscribeProperties( &xAzureIoTHubClient, prvHandleProperties,
-                                                         &xAzureIoTHubClient, sampleazureiotSUBSCRIBE_TIMEOUT );
-        configASSERT( xResult == eAzureIoTSuccess );
+        if( xResult != eAzureIoTSuccess )
+        {
+            TLS_Socket_Disconnect( &xNetworkContext );
+            xAction = prvHandleFailure( eConnectionSupervisorStageConnect, xResult );
+
+            #ifdef democonfigENABLE_DPS_CACHE
+                /* The device may have been moved to another IoT Hub or disabled
+                 * since it was provisioned. When the cached IoT Hub refuses it,
+                 * ask the Provisioning service again without waiting for more
+                 * refusals. Other failures keep the recovery of the supervisor. */
+                if( xSampleIotHubInfoFromCache &&
+                    ( xAction == eConnectionSupervisorActionReconnect ) &&
+                    ( ConnectionSupervisor_Classify( eConnectionSupervisorStageConnect, xResult ) == eConnectionSupervisorErrorAuth ) )
+                {
+                    LogWarn( ( "Cached IoT Hub refused the connection: result 0x%08x. Provisioning again.\r\n", xResult ) );
+                    xAction = eConnectionSupervisorActionReprovision;
+                }
+            #endif /* democonfigENABLE_DPS_CACHE */
+
+            continue;
+        }
 
+        #ifdef democonfigPERSISTENT_SESSION
+            /* The subscriptions of a resumed session are already in place at the
+             * IoT Hub, but subscribing again is what registers the callbacks of
+             * this client, so it is done either way. */
+            LogInfo( ( "MQTT session %s.\r\n", xSessionPresent ? "resumed" : "started" ) );
+        #endif /* democonfigPERSISTENT_SESSION */
+
+        if( ( ( xResult = AzureIoTHubClient_SubscribeCommand( &xAzureIoTHubClient, prvHandleCommand,
+                                                              &xAzureIoTHubClient, sampleazureiotSUBSCRIBE_TIMEOUT ) ) != eAzureIoTSuccess ) ||
+            ( ( xResult = AzureIoTHubClient_SubscribeProperties( &xAzureIoTHubClient, prvHandleProperties,
+                                                                 &xAzureIoTHubClient, sampleazureiotSUBSCRIBE_TIMEOUT ) ) != eAzureIoTSuccess ) )
+        {
+            xAction = prvHandleFailure( eConnectionSupervisorStageSubscribe, xResult );
+        }
         /* Get property document after initial connection */
-        xResult = AzureIoTHubClient_RequestPropertiesAsync( &xAzureIoTHubClient );
-        configASSERT( xResult == eAzureIoTSuccess );
-
-        /* Publish messages with QoS1, send and process Keep alive messages. */
-        for( ; ; )
+        else if( ( xResult = AzureIoTHubClient_RequestPropertiesAsync( &xAzureIoTHubClient ) ) != eAzureIoTSuccess )
         {
-            /* Hook for sending Telemetry */
-            if( ( ulCreateTelemetry( ucScratchBuffer, sizeof( ucScratchBuffer ), &ulScratchBufferLength ) == 0 ) &&
-                ( ulScratchBufferLength > 0 ) )
+            xAction = prvHandleFailure( eConnectionSupervisorStagePublish, xResult );
+        }
+
+        #ifdef democonfigPERSISTENT_SESSION
+            /* Send again what the previous connection left unacknowledged. */
+            else if( TelemetryOutbox_GetPendingCount( &xTelemetryOutbox ) > 0 )
             {
-                xResult = AzureIoTHubClient_SendTelemetry( &xAzureIoTHubClient,
-                                                           ucScratchBuffer, ulScratchBufferLength,
-                                                           NULL, eAzureIoTHubMessageQoS1, NULL );
-                configASSERT( xResult == eAzureIoTSuccess );
+                LogInfo( ( "Sending %u unacknowledged telemetry messages again.\r\n",
+                           TelemetryOutbox_GetPendingCount( &xTelemetryOutbox ) ) );
+
+                if( ( xResult = TelemetryOutbox_Resend( &xTelemetryOutbox, &xAzureIoTHubClient ) ) != eAzureIoTSuccess )
+                {
+                    xAction = prvHandleFailure( eConnectionSupervisorStagePublish, xResult );
+                }
             }
+        #endif /* democonfigPERSISTENT_SESSION */
+
+        if( xResult == eAzureIoTSuccess )
+        {
+            prvReportRecovered();
+
+            /* Connected, so a later loss of the connection, or the token
+             * renewal, only needs a new connection to the same IoT Hub. */
+            xAction = eConnectionSupervisorActionReconnect;
+        }
 
-            /* Hook for sending update to reported properties */
-            ulReportedPropertiesUpdateLength = ulCreateReportedPropertiesUpdate( ucReportedPropertiesUpdate, sizeof( ucReportedPropertiesUpdate ) );
+        ullNow = DeadlineScheduler_GetTimeMs();
+        DeadlineScheduler_Init( &xScheduler, xDeadlines, eSampleDeadlineCount );
+        DeadlineScheduler_Arm( &xScheduler, eSampleDeadlineTelemetry, ullNow, sampleazureiotTELEMETRY_INTERVAL_MS );
+        DeadlineScheduler_Arm( &xScheduler, eSampleDeadlineProperties, ullNow, sampleazureiotPROPERTIES_DEBOUNCE_MS );
+        DeadlineScheduler_Arm( &xScheduler, eSampleDeadlineKeepAlive,
+                               ullNow + sampleazureiotKEEP_ALIVE_INTERVAL_MS, sampleazureiotKEEP_ALIVE_INTERVAL_MS );
 
-            if( ulReportedPropertiesUpdateLength > 0 )
+        #ifdef democonfigDEVICE_SYMMETRIC_KEY
+            /* The token used by this connection is issued no earlier than now. */
+            ullUnixTime = SASTokenCache_GetTime();
+            DeadlineScheduler_Arm( &xScheduler, eSampleDeadlineTokenRenewal,
+                                   ullNow + ( SASTokenCache_RenewalTime( ullUnixTime ) - ullUnixTime ) * 1000U, 0 );
+        #endif /* democonfigDEVICE_SYMMETRIC_KEY */
+
+        #ifdef democonfigHOSTNAME_SECONDARY
+            DeadlineScheduler_Arm( &xScheduler, eSampleDeadlineEndpointProbe,
+                                   ullNow + sampleazureiotENDPOINT_PROBE_INTERVAL_MS, sampleazureiotENDPOINT_PROBE_INTERVAL_MS );
+        #endif /* democonfigHOSTNAME_SECONDARY */
+
+        /* Publish messages with QoS1, send and process Keep alive messages.
+         * Each pass runs the work that is due, then sleeps until the next
+         * deadline or until the IoT Hub sends something, whichever comes first.
+         * A failure leaves the loop with its result, the token renewal with success. */
+        while( xResult == eAzureIoTSuccess )
+        {
+            ullNow = DeadlineScheduler_GetTimeMs();
+
+            #ifdef democonfigDEVICE_SYMMETRIC_KEY
+                /* Reconnect with a new SAS token before the current one expires,
+                 * rather than having the IoT Hub drop the connection. */
+                if( DeadlineScheduler_Due( &xScheduler, eSampleDeadlineTokenRenewal, ullNow ) )
+                {
+                    LogInfo( ( "SAS token renewal due, reconnecting.\r\n" ) );
+                    break;
+                }
+            #endif /* democonfigDEVICE_SYMMETRIC_KEY */
+
+            #ifdef democonfigHOSTNAME_SECONDARY
+                if( DeadlineScheduler_Due( &xScheduler, eSampleDeadlineEndpointProbe, ullNow ) )
+                {
+                    prvProbeEndpoints( true );
+                }
+            #endif /* democonfigHOSTNAME_SECONDARY */
+
+            if( DeadlineScheduler_Due( &xScheduler, eSampleDeadlineTelemetry, ullNow ) )
             {
-                xResult = AzureIoTHubClient_SendPropertiesReported( &xAzureIoTHubClient, ucReportedPropertiesUpdate, ulReportedPropertiesUpdateLength, NULL );
-                configASSERT( xResult == eAzureIoTSuccess );
+                /* Hook for sending Telemetry, written straight into the MQTT buffer */
+                pucTelemetryWindow = prvTelemetryReserve( &ulTelemetryWindowSize );
+
+                #ifdef democonfigTELEMETRY_COMPRESSION_THRESHOLD
+                    /* Write the telemetry in the upper half of the window, leaving the
+                     * lower half for its compressed form. */
+                    ulTelemetryWindowSize /= 2;
+                    pucTelemetryWindow += ulTelemetryWindowSize;
+                #endif /* democonfigTELEMETRY_COMPRESSION_THRESHOLD */
+
+                if( ( ulCreateTelemetry( pucTelemetryWindow, ulTelemetryWindowSize, &ulTelemetryLength, &pxTelemetryProperties ) == 0 ) &&
+                    ( ulTelemetryLength > 0 ) )
+                {
+                    pucTelemetry = pucTelemetryWindow;
+
+                    #ifdef democonfigTELEMETRY_COMPRESSION_THRESHOLD
+                        prvCompressTelemetry( &pucTelemetry, &ulTelemetryLength, &pxTelemetryProperties,
+                                              pucTelemetryWindow - ulTelemetryWindowSize,
+                                              ulTelemetryWindowSize );
+                    #endif /* democonfigTELEMETRY_COMPRESSION_THRESHOLD */
+
+                    /* The telemetry stays in the MQTT buffer, so it can be sent again as it is. */
+                    do
+                    {
+                        xResult = prvTelemetryCommit( pucTelemetry, ulTelemetryLength, pxTelemetryProperties );
+                    } while( ( xResult != eAzureIoTSuccess ) &&
+                             prvRetryAfterFailure( eConnectionSupervisorStagePublish, xResult, &xAction ) );
+
+                    if( xResult != eAzureIoTSuccess )
+                    {
+                        break;
+                    }
+
+                    prvReportRecovered();
+                }
             }
 
-            LogInfo( ( "Attempt to receive publish message from IoT Hub.\r\n" ) );
-            xResult = AzureIoTHubClient_ProcessLoop( &xAzureIoTHubClient,
-                                                     sampleazureiotPROCESS_LOOP_TIMEOUT_MS );
-            configASSERT( xResult == eAzureIoTSuccess );
-
-            /* Leave Connection Idle for some time. */
-            LogInfo( ( "Keeping Connection Idle...\r\n\r\n" ) );
-            vTaskDelay( sampleazureiotDELAY_BETWEEN_PUBLISHES_TICKS );
-        }
+            if( DeadlineScheduler_Due( &xScheduler, eSampleDeadlineProperties, ullNow ) )
+            {
+                /* Hook for sending update to reported properties */
+                ulReportedPropertiesUpdateLength = ulCreateReportedPropertiesUpdate( ucReportedPropertiesUpdate, sizeof( ucReportedPropertiesUpdate ) );
+
+                if( ulReportedPropertiesUpdateLength > 0 )
+                {
+                    do
+                    {
+                        xResult = AzureIoTHubClient_SendPropertiesReported( &xAzureIoTHubClient, ucReportedPropertiesUpdate, ulReportedPropertiesUpdateLength, NULL );
+                    } while( ( xResult != eAzureIoTSuccess ) &&
+                             prvRetryAfterFailure( eConnectionSupervisorStagePublish, xResult, &xAction ) );
+
+                    if( xResult != eAzureIoTSuccess )
+                    {
+                        break;
+                    }
+
+                    prvReportRecovered();
+                }
+            }
 
-        xResult = AzureIoTHubClient_UnsubscribeProperties( &xAzureIoTHubClient );
-        configASSERT( xResult == eAzureIoTSuccess );
+            /* Sleep until the next deadline, unless data arrives first. */
+            ullWait = DeadlineScheduler_TimeToNext( &xScheduler, DeadlineScheduler_GetTimeMs(),
+                                                    sampleazureiotKEEP_ALIVE_INTERVAL_MS );
+            lDataReady = TLS_Socket_WaitForData( &xNetworkContext, ( uint32_t ) ullWait );
 
-        xResult = AzureIoTHubClient_UnsubscribeCommand( &xAzureIoTHubClient );
-        configASSERT( xResult == eAzureIoTSuccess );
+            /* Errors are left to the process loop to report. */
+            if( ( lDataReady != 0 ) ||
+                DeadlineScheduler_Due( &xScheduler, eSampleDeadlineKeepAlive, DeadlineScheduler_GetTimeMs() ) )
+            {
+                if( ( xResult = AzureIoTHubClient_ProcessLoop( &xAzureIoTHubClient, 0 ) ) != eAzureIoTSuccess )
+                {
+                    xAction = prvHandleFailure( eConnectionSupervisorStageProcessLoop, xResult );
+                }
+                else if( ulThrottleDelayMs > 0 )
+                {
+                    /* Move the publishes after the throttling, keeping their periods. */
+                    ullNow = DeadlineScheduler_GetTimeMs();
+                    DeadlineScheduler_Arm( &xScheduler, eSampleDeadlineTelemetry,
+                                           ullNow + ulThrottleDelayMs, sampleazureiotTELEMETRY_INTERVAL_MS );
+                    DeadlineScheduler_Arm( &xScheduler, eSampleDeadlineProperties,
+                                           ullNow + ulThrottleDelayMs, sampleazureiotPROPERTIES_DEBOUNCE_MS );
+                    ulThrottleDelayMs = 0;
+                }
+            }
+        }
 
-        /* Send an MQTT Disconnect packet over the already connected TLS over
-         * TCP connection. There is no corresponding response for the disconnect
-         * packet. After sending disconnect, client must close the network
-         * connection. */
-        xResult = AzureIoTHubClient_Disconnect( &xAzureIoTHubClient );
-        configASSERT( xResult == eAzureIoTSuccess );
+        /* A connection that failed is only closed, there is no point in
+         * unsubscribing or sending an MQTT Disconnect packet over it. */
+        if( xResult == eAzureIoTSuccess )
+        {
+            #ifndef democonfigPERSISTENT_SESSION
+                ( void ) AzureIoTHubClient_UnsubscribeProperties( &xAzureIoTHubClient );
+                ( void ) AzureIoTHubClient_UnsubscribeCommand( &xAzureIoTHubClient );
+            #endif /* democonfigPERSISTENT_SESSION */
+
+            /* Send an MQTT Disconnect packet over the already connected TLS over
+             * TCP connection. There is no corresponding response for the disconnect
+             * packet. After sending disconnect, client must close the network
+             * connection. */
+            ( void ) AzureIoTHubClient_Disconnect( &xAzureIoTHubClient );
+        }
 
         /* Close the network connection.  */
         TLS_Socket_Disconnect( &xNetworkContext );
 
-        /* Wait for some time between two iterations to ensure that we do not
-         * bombard the IoT Hub. */
-        LogInfo( ( "Demo completed successfully.\r\n" ) );
-        LogInfo( ( "Short delay before starting the next iteration.... \r\n\r\n" ) );
-        vTaskDelay( sampleazureiotDELAY_BETWEEN_DEMO_ITERATIONS_TICKS );
+        if( xResult == eAzureIoTSuccess )
+        {
+            /* Wait for some time between two iterations to ensure that we do not
+             * bombard the IoT Hub. */
+            LogInfo( ( "Demo completed successfully.\r\n" ) );
+            LogInfo( ( "Short delay before starting the next iteration.... \r\n\r\n" ) );
+            vTaskDelay( sampleazureiotDELAY_BETWEEN_DEMO_ITERATIONS_TICKS );
+        }
     }
+
+    vTaskDelete( NULL );
 }
 /*-----------------------------------------------------------*/
 
 #ifdef democonfigENABLE_DPS_SAMPLE
 
+/**
+ * @brief Register function of the registration poll.
+ */
+    static AzureIoTResult_t prvProvisioningRegister( void * pvContext,
+                                                     uint32_t ulTimeoutMs )
+    {
+        return AzureIoTProvisioningClient_Register( ( AzureIoTProvisioningClient_t * ) pvContext, ulTimeoutMs );
+    }
+/*-----------------------------------------------------------*/
+
+/**
+ * @brief Retry-after function of the registration poll.
+ */
+    static uint32_t prvProvisioningRetryAfter( void * pvContext )
+    {
+        uint64_t ullRetryAfter = sampleazureiotPROVISIONING_RETRY_AFTER( ( AzureIoTProvisioningClient_t * ) pvContext );
+        uint64_t ullNow = ullGetUnixTime();
+
+        if( ullRetryAfter <= ullNow )
+        {
+            return 0;
+        }
+
+        /* The poll clips the delay to the registration timeout. */
+        return ( ullRetryAfter - ullNow < UINT32_MAX / 1000U ) ?
+               ( uint32_t ) ( ( ullRetryAfter - ullNow ) * 1000U ) : UINT32_MAX;
+    }
+/*-----------------------------------------------------------*/
+
 /**
  * @brief Get IoT Hub endpoint and device Id info, when Provisioning service is used.
  *   This function will block for Provisioning service for result or return failure.
@@ -506,13 +1276,39 @@ static void prvAzureDemoTask( void * pvParameters )
         uint32_t ucSamplepIothubHostnameLength = sizeof( ucSampleIotHubHostname );
         uint32_t ucSamplepIothubDeviceIdLength = sizeof( ucSampleIotHubDeviceId );
         uint32_t ulStatus;
+        ProvisioningPollConfig_t xPollConfig;
+        ProvisioningPollStats_t xPollStats;
+
+        #ifdef democonfigENABLE_DPS_CACHE
+
+            /* Skip the cache when the IoT Hub it pointed to has just refused the device. */
+            if( !xSampleIotHubInfoFromCache &&
+                ( prvProvisioningCacheLoad( &ucSamplepIothubHostnameLength, &ucSamplepIothubDeviceIdLength ) == 0 ) )
+            {
+                LogInfo( ( "Using cached IoT Hub name and Device ID" ) );
+                xSampleIotHubInfoFromCache = true;
+
+                *ppucIothubHostname = ucSampleIotHubHostname;
+                *pulIothubHostnameLength = ucSamplepIothubHostnameLength;
+                *ppucIothubDeviceId = ucSampleIotHubDeviceId;
+                *pulIothubDeviceIdLength = ucSamplepIothubDeviceIdLength;
+
+                return 0;
+            }
+
+            xSampleIotHubInfoFromCache = false;
+        #endif /* democonfigENABLE_DPS_CACHE */
 
         /* Set the pParams member of the network context with desired transport. */
         xNetworkContext.pParams = &xTlsTransportParams;
 
         ulStatus = prvConnectToServerWithBackoffRetries( democonfigENDPOINT, democonfigIOTHUB_PORT,
                                                          pXNetworkCredentials, &xNetworkContext );
-        configASSERT( ulStatus == 0 );
+
+        if( ulStatus != 0 )
+        {
+            return eAzureIoTErrorFailed;
+        }
 
         /* Fill in Transport Interface send and receive function pointers. */
         xTransport.pxNetworkContext = &xNetworkContext;
@@ -562,33 +1358,47 @@ static void prvAzureDemoTask( void * pvParameters )
                                                                      sizeof( sampleazureiotPROVISIONING_PAYLOAD ) - 1 );
         configASSERT( xResult == eAzureIoTSuccess );
 
-        do
-        {
-            xResult = AzureIoTProvisioningClient_Register( &xAzureIoTProvisioningClient,
-                                                           sampleazureiotProvisioning_Registration_TIMEOUT_MS );
-        } while( xResult == eAzureIoTErrorPending );
+        xPollConfig.ulRegisterTimeoutMs = sampleazureiotProvisioning_Registration_TIMEOUT_MS;
+        xPollConfig.ulJitterFloorMs = sampleazureiotPROVISIONING_POLL_FLOOR_MS;
+        xPollConfig.ulJitterCeilingMs = sampleazureiotPROVISIONING_POLL_CEILING_MS;
+        xPollConfig.ulTimeoutMs = sampleazureiotPROVISIONING_TIMEOUT_MS;
+
+        /* A registration still pending at the timeout is reported as pending,
+         * a transient failure, rather than waited for forever. */
+        xResult = ProvisioningPoll_Register( &xPollConfig, prvProvisioningRegister, prvProvisioningRetryAfter,
+                                             &xAzureIoTProvisioningClient, &xPollStats );
+
+        LogInfo( ( "Registration ended after %u ms, %u calls to register, %u retry-after and %u jittered waits: result 0x%08x",
+                   xPollStats.ulElapsedMs, xPollStats.ulRegisterCalls, xPollStats.ulRetryAfterWaits,
+                   xPollStats.ulJitterWaits, xResult ) );
 
         if( xResult == eAzureIoTSuccess )
         {
             LogInfo( ( "Successfully acquired IoT Hub name and Device ID" ) );
+
+            xResult = AzureIoTProvisioningClient_GetDeviceAndHub( &xAzureIoTProvisioningClient,
+                                                                  ucSampleIotHubHostname, &ucSamplepIothubHostnameLength,
+                                                                  ucSampleIotHubDeviceId, &ucSamplepIothubDeviceIdLength );
         }
         else
         {
             LogInfo( ( "Error geting IoT Hub name and Device ID: 0x%08x", xResult ) );
         }
 
-        configASSERT( xResult == eAzureIoTSuccess );
-
-        xResult = AzureIoTProvisioningClient_GetDeviceAndHub( &xAzureIoTProvisioningClient,
-                                                              ucSampleIotHubHostname, &ucSamplepIothubHostnameLength,
-                                                              ucSampleIotHubDeviceId, &ucSamplepIothubDeviceIdLength );
-        configASSERT( xResult == eAzureIoTSuccess );
-
         AzureIoTProvisioningClient_Deinit( &xAzureIoTProvisioningClient );
 
         /* Close the network connection.  */
         TLS_Socket_Disconnect( &xNetworkContext );
 
+        if( xResult != eAzureIoTSuccess )
+        {
+            return xResult;
+        }
+
+        #ifdef democonfigENABLE_DPS_CACHE
+            prvProvisioningCacheStore( ucSamplepIothubHostnameLength, ucSamplepIothubDeviceIdLength );
+        #endif /* democonfigENABLE_DPS_CACHE */
+
         *ppucIothubHostname = ucSampleIotHubHostname;
         *pulIothubHostnameLength = ucSamplepIothubHostnameLength;
         *ppucIothubDeviceId = ucSampleIotHubDeviceId;
@@ -600,6 +1410,99 @@ static void prvAzureDemoTask( void * pvParameters )
 #endif /* democonfigENABLE_DPS_SAMPLE */
 /*-----------------------------------------------------------*/
 
+#ifdef democonfigENABLE_DPS_CACHE
+
+/**
+ * @brief Fold every input of the registration into a fingerprint, so that a
+ *  cached result is dropped as soon as any of them changes.
+ */
+    static uint32_t prvProvisioningCacheFingerprint( void )
+    {
+        uint32_t ulFingerprint = provisioningcacheFINGERPRINT_SEED;
+
+        ulFingerprint = ProvisioningCache_Fingerprint( ulFingerprint,
+                                                       ( const uint8_t * ) democonfigENDPOINT,
+                                                       sizeof( democonfigENDPOINT ) - 1 );
+        ulFingerprint = ProvisioningCache_Fingerprint( ulFingerprint,
+                                                       ( const uint8_t * ) democonfigID_SCOPE,
+                                                       sizeof( democonfigID_SCOPE ) - 1 );
+
+        /* With an HSM the registration ID is bound to the device itself. */
+        #ifndef democonfigUSE_HSM
+            ulFingerprint = ProvisioningCache_Fingerprint( ulFingerprint,
+                                                           ( const uint8_t * ) democonfigREGISTRATION_ID,
+                                                           sizeof( democonfigREGISTRATION_ID ) - 1 );
+        #endif
+
+        ulFingerprint = ProvisioningCache_Fingerprint( ulFingerprint,
+                                                       ( const uint8_t * ) sampleazureiotPROVISIONING_PAYLOAD,
+                                                       sizeof( sampleazureiotPROVISIONING_PAYLOAD ) - 1 );
+
+        #ifdef democonfigDEVICE_SYMMETRIC_KEY
+            ulFingerprint = ProvisioningCache_Fingerprint( ulFingerprint,
+                                                           ( const uint8_t * ) democonfigDEVICE_SYMMETRIC_KEY,
+                                                           sizeof( democonfigDEVICE_SYMMETRIC_KEY ) - 1 );
+        #else
+            ulFingerprint = ProvisioningCache_Fingerprint( ulFingerprint,
+                                                           ( const uint8_t * ) democonfigCLIENT_CERTIFICATE_PEM,
+                                                           sizeof( democonfigCLIENT_CERTIFICATE_PEM ) - 1 );
+        #endif /* democonfigDEVICE_SYMMETRIC_KEY */
+
+        return ulFingerprint;
+    }
+/*-----------------------------------------------------------*/
+
+    static uint32_t prvProvisioningCacheLoad( uint32_t * pulIothubHostnameLength,
+                                              uint32_t * pulIothubDeviceIdLength )
+    {
+        if( ulProvisioningCacheRead( ( uint8_t * ) &xProvisioningCacheEntry, sizeof( xProvisioningCacheEntry ) ) != 0 )
+        {
+            LogInfo( ( "No cached IoT Hub name and Device ID" ) );
+            return 1;
+        }
+
+        if( ( ProvisioningCache_EntryValidate( &xProvisioningCacheEntry, prvProvisioningCacheFingerprint() ) != 0 ) ||
+            ( xProvisioningCacheEntry.ulHostnameLength >= sizeof( ucSampleIotHubHostname ) ) ||
+            ( xProvisioningCacheEntry.ulDeviceIdLength >= sizeof( ucSampleIotHubDeviceId ) ) )
+        {
+            LogInfo( ( "Cached IoT Hub name and Device ID do not match the current configuration" ) );
+            return 1;
+        }
+
+        memset( ucSampleIotHubHostname, 0, sizeof( ucSampleIotHubHostname ) );
+        memcpy( ucSampleIotHubHostname, xProvisioningCacheEntry.ucHostname, xProvisioningCacheEntry.ulHostnameLength );
+        memset( ucSampleIotHubDeviceId, 0, sizeof( ucSampleIotHubDeviceId ) );
+        memcpy( ucSampleIotHubDeviceId, xProvisioningCacheEntry.ucDeviceId, xProvisioningCacheEntry.ulDeviceIdLength );
+
+        *pulIothubHostnameLength = xProvisioningCacheEntry.ulHostnameLength;
+        *pulIothubDeviceIdLength = xProvisioningCacheEntry.ulDeviceIdLength;
+
+        return 0;
+    }
+/*-----------------------------------------------------------*/
+
+    static void prvProvisioningCacheStore( uint32_t ulIothubHostnameLength,
+                                           uint32_t ulIothubDeviceIdLength )
+    {
+        if( ProvisioningCache_EntryInit( &xProvisioningCacheEntry, prvProvisioningCacheFingerprint(),
+                                         ucSampleIotHubHostname, ulIothubHostnameLength,
+                                         ucSampleIotHubDeviceId, ulIothubDeviceIdLength ) != 0 )
+        {
+            LogWarn( ( "IoT Hub name and Device ID are too long to be cached" ) );
+        }
+        else if( ulProvisioningCacheWrite( ( const uint8_t * ) &xProvisioningCacheEntry, sizeof( xProvisioningCacheEntry ) ) != 0 )
+        {
+            LogWarn( ( "Failed to cache IoT Hub name and Device ID" ) );
+        }
+        else
+        {
+            LogInfo( ( "Cached IoT Hub name and Device ID" ) );
+        }
+    }
+
+#endif /* democonfigENABLE_DPS_CACHE */
+/*-----------------------------------------------------------*/
+
 /**
  * @brief Connect to server with backoff retries.
  */
@@ -609,18 +1512,17 @@ static uint32_t prvConnectToServerWithBackoffRetries( const char * pcHostName,
                                                       NetworkContext_t * pxNetworkContext )
 {
     TlsTransportStatus_t xNetworkStatus;
-    BackoffAlgorithmStatus_t xBackoffAlgStatus = BackoffAlgorithmSuccess;
-    BackoffAlgorithmContext_t xReconnectParams;
-    uint16_t usNextRetryBackOff = 0U;
+    BackoffPolicy_t xReconnectBackoff;
+    uint32_t ulAttempt = 1;
+    uint32_t ulNextRetryBackOff;
 
-    /* Initialize reconnect attempts and interval. */
-    BackoffAlgorithm_InitializeParams( &xReconnectParams,
-                                       sampleazureiotRETRY_BACKOFF_BASE_MS,
-                                       sampleazureiotRETRY_MAX_BACKOFF_DELAY_MS,
-                                       sampleazureiotRETRY_MAX_ATTEMPTS );
+    /* Initialize reconnect interval. */
+    BackoffPolicy_Init( &xReconnectBackoff, eBackoffPolicyDecorrelatedJitter,
+                        sampleazureiotRETRY_BACKOFF_BASE_MS,
+                        sampleazureiotRETRY_MAX_BACKOFF_DELAY_MS );
 
     /* Attempt to connect to IoT Hub. If connection fails, retry after
-     * a timeout. Timeout value will exponentially increase till maximum
+     * a timeout. Timeout value will grow with decorrelated jitter till maximum
      * attempts are reached.
      */
     do
@@ -635,26 +1537,25 @@ static uint32_t prvConnectToServerWithBackoffRetries( const char * pcHostName,
 
         if( xNetworkStatus != eTLSTransportSuccess )
         {
+            if( ulAttempt >= sampleazureiotRETRY_MAX_ATTEMPTS )
+            {
+                LogError( ( "Connection to the IoT Hub failed, all attempts exhausted." ) );
+                break;
+            }
+
             /* Generate a random number and calculate backoff value (in milliseconds) for
              * the next connection retry.
              * Note: It is recommended to seed the random number generator with a device-specific
              * entropy source so that possibility of multiple devices retrying failed network operations
              * at similar intervals can be avoided. */
-            xBackoffAlgStatus = BackoffAlgorithm_GetNextBackoff( &xReconnectParams, configRAND32(), &usNextRetryBackOff );
-
-            if( xBackoffAlgStatus == BackoffAlgorithmRetriesExhausted )
-            {
-                LogError( ( "Connection to the IoT Hub failed, all attempts exhausted." ) );
-            }
-            else if( xBackoffAlgStatus == BackoffAlgorithmSuccess )
-            {
-                LogWarn( ( "Connection to the IoT Hub failed [%d]. "
-                           "Retrying connection with backoff and jitter [%d]ms.",
-                           xNetworkStatus, usNextRetryBackOff ) );
-                vTaskDelay( pdMS_TO_TICKS( usNextRetryBackOff ) );
-            }
+            ulNextRetryBackOff = BackoffPolicy_NextDelay( &xReconnectBackoff, configRAND32() );
+            LogWarn( ( "Connection to the IoT Hub failed [%d]. "
+                       "Retrying connection with backoff and jitter [%u]ms.",
+                       xNetworkStatus, ulNextRetryBackOff ) );
+            vTaskDelay( pdMS_TO_TICKS( ulNextRetryBackOff ) );
+            ulAttempt++;
         }
-    } while( ( xNetworkStatus != eTLSTransportSuccess ) && ( xBackoffAlgStatus == BackoffAlgorithmSuccess ) );
+    } while( xNetworkStatus != eTLSTransportSuccess );
 
     return xNetworkStatus == eTLSTransportSuccess ? 0 : 1;
 }
@@ -33,12 +33,14 @@ extern AzureIoTHubClient_t xAzureIoTHubClient;
  * @param[out]  pucTelemetryData        Pointer to uint8_t* that will contain the Telemetry payload.
  * @param[in]   ulTelemetryDataSize     Size of `pucTelemetryData`
  * @param[out]  pulTelemetryDataLength  The number of bytes written in `pucTelemetryData`
+ * @param[out]  ppxTelemetryProperties  Properties to send with the Telemetry, such as its content type, or NULL.
  * 
  * @return uint32_t Zero if successful, non-zero if any failure occurs.
  */
 uint32_t ulCreateTelemetry( uint8_t * pucTelemetryData,
                             uint32_t ulTelemetryDataSize,
-                            uint32_t * pulTelemetryDataLength );
+                            uint32_t * pulTelemetryDataLength,
+                            AzureIoTMessageProperties_t ** ppxTelemetryProperties );
 
 /**
  * @brief Provides the payload to be sent as reported properties update to the Azure IoT Hub.
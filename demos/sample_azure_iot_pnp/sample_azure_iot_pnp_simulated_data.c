@@ -11,6 +11,34 @@
 #include "azure_iot_json_reader.h"
 #include "azure_iot_json_writer.h"
 
+/* Single pass properties parser */
+#include "properties_parser.h"
+
+/* printf free formatting of telemetry values */
+#include "double_format.h"
+
+/* Command dispatch table */
+#include "command_dispatcher.h"
+
+/* Serializers generated from the Thermostat model */
+#include "thermostat_model.h"
+
+/* Temperature history and its timestamps */
+#include "reading_history.h"
+#include "iso8601_time.h"
+
+/* Running temperature statistics */
+#include "window_aggregator.h"
+
+/* Report-on-change telemetry */
+#include "report_filter.h"
+
+/* Binary telemetry series */
+#include "gorilla_series.h"
+
+/* CBOR telemetry */
+#include "cbor_writer.h"
+
 /* FreeRTOS */
 /* This task provides taskDISABLE_INTERRUPTS, used by configASSERT */
 #include "FreeRTOS.h"
@@ -27,14 +55,7 @@
 /**
  * @brief Command values
  */
-#define sampleazureiotCOMMAND_MAX_MIN_REPORT              "getMaxMinReport"
-#define sampleazureiotCOMMAND_MAX_TEMP                    "maxTemp"
-#define sampleazureiotCOMMAND_MIN_TEMP                    "minTemp"
-#define sampleazureiotCOMMAND_TEMP_VERSION                "avgTemp"
-#define sampleazureiotCOMMAND_START_TIME                  "startTime"
-#define sampleazureiotCOMMAND_END_TIME                    "endTime"
 #define sampleazureiotCOMMAND_EMPTY_PAYLOAD               "{}"
-#define sampleazureiotCOMMAND_FAKE_END_TIME               "2023-01-10T10:00:00Z"
 
 /**
  * @brief Device values
@@ -48,40 +69,104 @@
  */
 #define sampleazureiotPROPERTY_STATUS_SUCCESS             200
 #define sampleazureiotPROPERTY_SUCCESS                    "success"
-#define sampleazureiotPROPERTY_TARGET_TEMPERATURE_TEXT    "targetTemperature"
-#define sampleazureiotPROPERTY_MAX_TEMPERATURE_TEXT       "maxTempSinceLastReboot"
 
 /**
- * @brief Telemetry values
+ *@brief The Telemetry message published in this example, around the formatted temperature.
  */
-#define sampleazureiotTELEMETRY_NAME                      "temperature"
+#define sampleazureiotMESSAGE_PREFIX                      "{\"" thermostatTEMPERATURE_NAME "\":"
+#define sampleazureiotMESSAGE_SUFFIX                      "}"
 
 /**
- *@brief The Telemetry message published in this example.
+ * @brief Telemetry report rule: the temperature is sent when it moves by more than
+ *        the dead-band, and at least once per heartbeat, in seconds.
  */
-#define sampleazureiotMESSAGE                             "{\"" sampleazureiotTELEMETRY_NAME "\":%0.2f}"
+#define sampleazureiotTELEMETRY_DEADBAND_CELSIUS          0.1
+#define sampleazureiotTELEMETRY_HEARTBEAT_SECS            60
 
 
 /* Device values */
 static double xDeviceCurrentTemperature = sampleazureiotDEFAULT_START_TEMP_CELSIUS;
-static double xDeviceMaximumTemperature = sampleazureiotDEFAULT_START_TEMP_CELSIUS;
-static double xDeviceMinimumTemperature = sampleazureiotDEFAULT_START_TEMP_CELSIUS;
-static double xDeviceTemperatureSummation = sampleazureiotDEFAULT_START_TEMP_CELSIUS;
-static uint32_t ulDeviceTemperatureCount = sampleazureiotDEFAULT_START_TEMP_COUNT;
-static double xDeviceAverageTemperature = sampleazureiotDEFAULT_START_TEMP_CELSIUS;
+static WindowAggregatorStats_t xDeviceTemperatureStats =
+{
+    .ulCount = sampleazureiotDEFAULT_START_TEMP_COUNT,
+    .xMinimum = sampleazureiotDEFAULT_START_TEMP_CELSIUS,
+    .xMaximum = sampleazureiotDEFAULT_START_TEMP_CELSIUS,
+    .xMean = sampleazureiotDEFAULT_START_TEMP_CELSIUS,
+    .xM2 = 0.0,
+    .xLast = sampleazureiotDEFAULT_START_TEMP_CELSIUS
+};
+
+/* Temperatures sampled for telemetry, zero initialized as an empty history */
+static ReadingHistory_t xTemperatureHistory;
+
+/* Last temperature sent as telemetry */
+static const ReportFilterRule_t xTemperatureReportRule =
+{
+    sampleazureiotTELEMETRY_DEADBAND_CELSIUS, 0.0, 0, sampleazureiotTELEMETRY_HEARTBEAT_SECS
+};
+static ReportFilterField_t xTemperatureReport;
+static ReportFilter_t xTemperatureFilter;
+static bool xTemperatureFilterReady = false;
+
+#ifdef democonfigTELEMETRY_SERIES_LENGTH
+
+/**
+ * @brief Message properties of a temperature series, URL encoded.
+ */
+    #define sampleazureiotSERIES_CONTENT_TYPE        "application%2Fx-gorilla-series"
+    #define sampleazureiotSERIES_CONTENT_ENCODING    "identity"
+
+/* Temperatures not sent yet, as a series of democonfigTELEMETRY_SERIES_LENGTH readings */
+    static GorillaSeriesSignal_t xTemperatureSeriesSignal;
+    static GorillaSeriesEncoder_t xTemperatureSeries;
+    static uint8_t ucTemperatureSeriesBuffer[ gorillaseriesHEADER_LENGTH +
+                                              gorillaseriesRECORD_MAX_LENGTH( 1 ) * democonfigTELEMETRY_SERIES_LENGTH ];
+    static AzureIoTMessageProperties_t xTemperatureSeriesProperties;
+    static uint8_t ucTemperatureSeriesPropertiesBuffer[ 64 ];
+    static bool xTemperatureSeriesReady = false;
+#endif /* democonfigTELEMETRY_SERIES_LENGTH */
+
+#if defined( democonfigTELEMETRY_CBOR ) && !defined( democonfigTELEMETRY_SERIES_LENGTH )
+
+/**
+ * @brief Message property of CBOR telemetry, URL encoded.
+ */
+    #define sampleazureiotCBOR_CONTENT_TYPE    "application%2Fcbor"
+
+    static AzureIoTMessageProperties_t xCborTelemetryProperties;
+    static uint8_t ucCborTelemetryPropertiesBuffer[ 32 ];
+    static bool xCborTelemetryPropertiesReady = false;
+#endif /* democonfigTELEMETRY_CBOR && !democonfigTELEMETRY_SERIES_LENGTH */
 
 /* Command buffers */
-static uint8_t ucCommandStartTimeValueBuffer[ 32 ];
+static uint8_t ucCommandStartTimeValueBuffer[ 48 ];
+static uint8_t ucCommandEndTimeValueBuffer[ iso8601timeLENGTH ];
 /*-----------------------------------------------------------*/
 
 /**
- * @brief Generate max min payload.
+ * @brief Unix time.
+ *
+ * @return Time in seconds.
+ */
+uint64_t ullGetUnixTime( void );
+/*-----------------------------------------------------------*/
+
+/**
+ * @brief Generate max min payload from the temperatures sent since the requested time.
+ *
+ * When no temperature was sent since then, the current temperature is reported for the whole window.
  */
 static AzureIoTResult_t prvInvokeMaxMinCommand( AzureIoTJSONReader_t * pxReader,
-                                                AzureIoTJSONWriter_t * pxWriter )
+                                                uint8_t * pucResponsePayload,
+                                                uint32_t ulResponsePayloadSize,
+                                                uint32_t * pulResponsePayloadLength )
 {
     AzureIoTResult_t xResult;
-    uint32_t ulSinceTimeLength;
+    ThermostatGetMaxMinReportResponse_t xResponse;
+    ReadingHistoryStats_t xStats;
+    uint64_t ullSince;
+    uint64_t ullNow = ullGetUnixTime();
+    uint32_t ulSinceLength;
 
     /* Get the start time */
     if( ( xResult = AzureIoTJSONReader_NextToken( pxReader ) )
@@ -92,78 +177,53 @@ static AzureIoTResult_t prvInvokeMaxMinCommand( AzureIoTJSONReader_t * pxReader,
     else if( ( xResult = AzureIoTJSONReader_GetTokenString( pxReader,
                                                             ucCommandStartTimeValueBuffer,
                                                             sizeof( ucCommandStartTimeValueBuffer ),
-                                                            &ulSinceTimeLength ) )
+                                                            &ulSinceLength ) )
              != eAzureIoTSuccess )
     {
         LogError( ( "Error getting token string: result 0x%08x", xResult ) );
     }
-    else if( ( xResult = AzureIoTJSONWriter_AppendBeginObject( pxWriter ) )
-             != eAzureIoTSuccess )
+    else if( !Iso8601Time_Parse( ucCommandStartTimeValueBuffer, ulSinceLength, &ullSince ) )
     {
-        LogError( ( "Error appending begin object: result 0x%08x", xResult ) );
+        LogError( ( "Invalid start time: %.*s", ulSinceLength, ucCommandStartTimeValueBuffer ) );
+        xResult = eAzureIoTErrorInvalidArgument;
     }
-    else if( ( xResult = AzureIoTJSONWriter_AppendPropertyWithDoubleValue( pxWriter, ( const uint8_t * ) sampleazureiotCOMMAND_MAX_TEMP,
-                                                                           sizeof( sampleazureiotCOMMAND_MAX_TEMP ) - 1,
-                                                                           xDeviceMaximumTemperature, sampleazureiotDOUBLE_DECIMAL_PLACE_DIGITS ) )
-             != eAzureIoTSuccess )
-    {
-        LogError( ( "Error appending max temp: result 0x%08x", xResult ) );
-    }
-    else if( ( xResult = AzureIoTJSONWriter_AppendPropertyWithDoubleValue( pxWriter, ( const uint8_t * ) sampleazureiotCOMMAND_MIN_TEMP,
-                                                                           sizeof( sampleazureiotCOMMAND_MIN_TEMP ) - 1,
-                                                                           xDeviceMinimumTemperature, sampleazureiotDOUBLE_DECIMAL_PLACE_DIGITS ) )
-             != eAzureIoTSuccess )
-    {
-        LogError( ( "Error appending min temp: result 0x%08x", xResult ) );
-    }
-    else if( ( xResult = AzureIoTJSONWriter_AppendPropertyWithDoubleValue( pxWriter, ( const uint8_t * ) sampleazureiotCOMMAND_TEMP_VERSION,
-                                                                           sizeof( sampleazureiotCOMMAND_TEMP_VERSION ) - 1,
-                                                                           xDeviceAverageTemperature, sampleazureiotDOUBLE_DECIMAL_PLACE_DIGITS ) )
-             != eAzureIoTSuccess )
-    {
-        LogError( ( "Error appending average temp: result 0x%08x", xResult ) );
-    }
-    else if( ( xResult = AzureIoTJSONWriter_AppendPropertyWithStringValue( pxWriter, ( const uint8_t * ) sampleazureiotCOMMAND_START_TIME,
-                                                                           sizeof( sampleazureiotCOMMAND_START_TIME ) - 1,
-                                                                           ucCommandStartTimeValueBuffer, ulSinceTimeLength ) )
-             != eAzureIoTSuccess )
-    {
-        LogError( ( "Error appending start time: result 0x%08x", xResult ) );
-    }
-    /* Faking the end time to simplify dependencies on <time.h> */
-    else if( ( xResult = AzureIoTJSONWriter_AppendPropertyWithStringValue( pxWriter, ( const uint8_t * ) sampleazureiotCOMMAND_END_TIME,
-                                                                           sizeof( sampleazureiotCOMMAND_END_TIME ) - 1,
-                                                                           ( const uint8_t * ) sampleazureiotCOMMAND_FAKE_END_TIME,
-                                                                           sizeof( sampleazureiotCOMMAND_FAKE_END_TIME ) - 1 ) )
-             != eAzureIoTSuccess )
-    {
-        LogError( ( "Error appending end time: result 0x%08x", xResult ) );
-    }
-    else if( ( xResult = AzureIoTJSONWriter_AppendEndObject( pxWriter ) )
-             != eAzureIoTSuccess )
+    else
     {
-        LogError( ( "Error appending end object: result 0x%08x", xResult ) );
+        if( ReadingHistory_Query( &xTemperatureHistory, ullSince, &xStats ) )
+        {
+            xResponse.xMaxTemp = xStats.xMaximum;
+            xResponse.xMinTemp = xStats.xMinimum;
+            xResponse.xAvgTemp = xStats.xAverage;
+            ullSince = xStats.ullStartTime;
+        }
+        else
+        {
+            xResponse.xMaxTemp = xDeviceCurrentTemperature;
+            xResponse.xMinTemp = xDeviceCurrentTemperature;
+            xResponse.xAvgTemp = xDeviceCurrentTemperature;
+        }
+
+        xResponse.pucStartTime = ucCommandStartTimeValueBuffer;
+        xResponse.ulStartTimeLength = Iso8601Time_Format( ullSince, ucCommandStartTimeValueBuffer,
+                                                          sizeof( ucCommandStartTimeValueBuffer ) );
+        xResponse.pucEndTime = ucCommandEndTimeValueBuffer;
+        xResponse.ulEndTimeLength = Iso8601Time_Format( ullNow, ucCommandEndTimeValueBuffer,
+                                                        sizeof( ucCommandEndTimeValueBuffer ) );
+
+        if( ( xResult = Thermostat_SerializeGetMaxMinReportResponse( &xResponse,
+                                                                     pucResponsePayload,
+                                                                     ulResponsePayloadSize,
+                                                                     pulResponsePayloadLength ) )
+            != eAzureIoTSuccess )
+        {
+            LogError( ( "Error writing the max min report: result 0x%08x", xResult ) );
+        }
     }
 
     return xResult;
 }
 /*-----------------------------------------------------------*/
 
-static void prvSkipPropertyAndValue( AzureIoTJSONReader_t * pxReader )
-{
-    AzureIoTResult_t xResult;
-
-    xResult = AzureIoTJSONReader_NextToken( pxReader );
-    configASSERT( xResult == eAzureIoTSuccess );
-
-    xResult = AzureIoTJSONReader_SkipChildren( pxReader );
-    configASSERT( xResult == eAzureIoTSuccess );
-
-    xResult = AzureIoTJSONReader_NextToken( pxReader );
-    configASSERT( xResult == eAzureIoTSuccess );
-}
-/*-----------------------------------------------------------*/
-
 /**
  * @brief Update local device temperature values based on new requested temperature.
  */
@@ -171,30 +231,17 @@ static void prvUpdateLocalProperties( double xNewTemperatureValue,
                                       uint32_t ulPropertyVersion,
                                       bool * pxOutMaxTempChanged )
 {
-    *pxOutMaxTempChanged = false;
+    *pxOutMaxTempChanged = ( xNewTemperatureValue > xDeviceTemperatureStats.xMaximum );
     xDeviceCurrentTemperature = xNewTemperatureValue;
 
-    /* Update maximum or minimum temperatures. */
-    if( xDeviceCurrentTemperature > xDeviceMaximumTemperature )
-    {
-        xDeviceMaximumTemperature = xDeviceCurrentTemperature;
-        *pxOutMaxTempChanged = true;
-    }
-    else if( xDeviceCurrentTemperature < xDeviceMinimumTemperature )
-    {
-        xDeviceMinimumTemperature = xDeviceCurrentTemperature;
-    }
-
-    /* Calculate the new average temperature. */
-    ulDeviceTemperatureCount++;
-    xDeviceTemperatureSummation += xDeviceCurrentTemperature;
-    xDeviceAverageTemperature = xDeviceTemperatureSummation / ulDeviceTemperatureCount;
+    /* Update maximum, minimum and average temperatures. */
+    WindowAggregator_StatsAdd( &xDeviceTemperatureStats, xDeviceCurrentTemperature );
 
     LogInfo( ( "Client updated desired temperature variables locally." ) );
     LogInfo( ( "Current Temperature: %2f", xDeviceCurrentTemperature ) );
-    LogInfo( ( "Maximum Temperature: %2f", xDeviceMaximumTemperature ) );
-    LogInfo( ( "Minimum Temperature: %2f", xDeviceMinimumTemperature ) );
-    LogInfo( ( "Average Temperature: %2f", xDeviceAverageTemperature ) );
+    LogInfo( ( "Maximum Temperature: %2f", xDeviceTemperatureStats.xMaximum ) );
+    LogInfo( ( "Minimum Temperature: %2f", xDeviceTemperatureStats.xMinimum ) );
+    LogInfo( ( "Average Temperature: %2f", xDeviceTemperatureStats.xMean ) );
 }
 /*-----------------------------------------------------------*/
 
@@ -208,6 +255,9 @@ static uint32_t prvGetNewMaxTemp( double xUpdatedTemperature,
     AzureIoTResult_t xResult;
     AzureIoTJSONWriter_t xWriter;
     int32_t lBytesWritten;
+    ThermostatReportedProperties_t xProperties;
+
+    xProperties.xMaxTempSinceLastReboot = xUpdatedTemperature;
 
     /* Initialize the JSON writer with the buffer to which we will write the payload with the new temperature. */
     xResult = AzureIoTJSONWriter_Init( &xWriter, ucReportedPropertyPayloadBuffer, ulReportedPropertyPayloadBufferSize );
@@ -216,11 +266,7 @@ static uint32_t prvGetNewMaxTemp( double xUpdatedTemperature,
     xResult = AzureIoTJSONWriter_AppendBeginObject( &xWriter );
     configASSERT( xResult == eAzureIoTSuccess );
 
-    xResult = AzureIoTJSONWriter_AppendPropertyName( &xWriter, ( const uint8_t * ) sampleazureiotPROPERTY_MAX_TEMPERATURE_TEXT,
-                                                     sizeof( sampleazureiotPROPERTY_MAX_TEMPERATURE_TEXT ) - 1 );
-    configASSERT( xResult == eAzureIoTSuccess );
-
-    xResult = AzureIoTJSONWriter_AppendDouble( &xWriter, xUpdatedTemperature, sampleazureiotDOUBLE_DECIMAL_PLACE_DIGITS );
+    xResult = Thermostat_AppendReportedProperties( &xWriter, &xProperties );
     configASSERT( xResult == eAzureIoTSuccess );
 
     xResult = AzureIoTJSONWriter_AppendEndObject( &xWriter );
@@ -255,8 +301,8 @@ static uint32_t prvGenerateAckForIncomingTemperature( double xUpdatedTemperature
 
     xResult = AzureIoTHubClientProperties_BuilderBeginResponseStatus( &xAzureIoTHubClient,
                                                                       &xWriter,
-                                                                      ( const uint8_t * ) sampleazureiotPROPERTY_TARGET_TEMPERATURE_TEXT,
-                                                                      sizeof( sampleazureiotPROPERTY_TARGET_TEMPERATURE_TEXT ) - 1,
+                                                                      ( const uint8_t * ) thermostatTARGET_TEMPERATURE_NAME,
+                                                                      sizeof( thermostatTARGET_TEMPERATURE_NAME ) - 1,
                                                                       sampleazureiotPROPERTY_STATUS_SUCCESS,
                                                                       ulVersion,
                                                                       ( const uint8_t * ) sampleazureiotPROPERTY_SUCCESS,
@@ -280,85 +326,69 @@ static uint32_t prvGenerateAckForIncomingTemperature( double xUpdatedTemperature
 }
 /*-----------------------------------------------------------*/
 
+/**
+ * @brief Called by the properties parser for every property in the document.
+ */
+static AzureIoTResult_t prvOnProperty( const uint8_t * pucComponentName,
+                                       uint32_t ulComponentNameLength,
+                                       AzureIoTJSONReader_t * pxReader,
+                                       void * pvContext )
+{
+    ThermostatWritableProperties_t * pxOutProperties = ( ThermostatWritableProperties_t * ) pvContext;
+    uint32_t ulFlags = 0;
+    AzureIoTResult_t xResult;
+
+    if( ulComponentNameLength > 0 )
+    {
+        LogInfo( ( "Unknown component name received: %.*s", ulComponentNameLength, pucComponentName ) );
+
+        /* Unknown component name arrived (there are none for this device). */
+        xResult = PropertiesParser_SkipValue( pxReader );
+    }
+    /* Get desired temperature */
+    else if( ( xResult = Thermostat_ParseWritableProperty( pxReader, pxOutProperties, &ulFlags ) ) == eAzureIoTErrorItemNotFound )
+    {
+        LogInfo( ( "Unknown property arrived: skipping over it." ) );
+
+        /* Unknown property arrived. We have to skip over the property and value to continue iterating. */
+        xResult = PropertiesParser_SkipValue( pxReader );
+    }
+    else if( xResult != eAzureIoTSuccess )
+    {
+        LogError( ( "Error getting the desired temperature: result 0x%08x", xResult ) );
+    }
+
+    return xResult;
+}
+/*-----------------------------------------------------------*/
+
 /**
  * @brief Properties callback handler
+ *
+ * The version and the properties are read in a single pass over the document.
  */
 static AzureIoTResult_t prvProcessProperties( AzureIoTHubClientPropertiesResponse_t * pxMessage,
                                               AzureIoTHubClientPropertyType_t xPropertyType,
-                                              double * pxOutTemperature,
+                                              ThermostatWritableProperties_t * pxOutProperties,
                                               uint32_t * ulOutVersion )
 {
     AzureIoTResult_t xResult;
-    AzureIoTJSONReader_t xReader;
-    const uint8_t * pucComponentName = NULL;
-    uint32_t ulComponentNameLength = 0;
 
-    *pxOutTemperature = 0.0;
-
-    xResult = AzureIoTJSONReader_Init( &xReader, pxMessage->pvMessagePayload, pxMessage->ulPayloadLength );
-    configASSERT( xResult == eAzureIoTSuccess );
+    pxOutProperties->xTargetTemperature = 0.0;
 
-    xResult = AzureIoTHubClientProperties_GetPropertiesVersion( &xAzureIoTHubClient, &xReader, pxMessage->xMessageType, ulOutVersion );
+    xResult = PropertiesParser_Parse( pxMessage->pvMessagePayload, pxMessage->ulPayloadLength,
+                                      pxMessage->xMessageType, xPropertyType,
+                                      NULL, 0,
+                                      prvOnProperty, pxOutProperties,
+                                      ulOutVersion );
 
     if( xResult != eAzureIoTSuccess )
     {
-        LogError( ( "Error getting the property version: result 0x%08x", xResult ) );
+        LogError( ( "There was an error parsing the properties: result 0x%08x", xResult ) );
     }
     else
     {
-        /* Reset JSON reader to the beginning */
-        xResult = AzureIoTJSONReader_Init( &xReader, pxMessage->pvMessagePayload, pxMessage->ulPayloadLength );
-        configASSERT( xResult == eAzureIoTSuccess );
-
-        while( ( xResult = AzureIoTHubClientProperties_GetNextComponentProperty( &xAzureIoTHubClient, &xReader,
-                                                                                 pxMessage->xMessageType, xPropertyType,
-                                                                                 &pucComponentName, &ulComponentNameLength ) ) == eAzureIoTSuccess )
-        {
-            if( ulComponentNameLength > 0 )
-            {
-                LogInfo( ( "Unknown component name received" ) );
-
-                /* Unknown component name arrived (there are none for this device).
-                 * We have to skip over the property and value to continue iterating */
-                prvSkipPropertyAndValue( &xReader );
-            }
-            else if( AzureIoTJSONReader_TokenIsTextEqual( &xReader,
-                                                          ( const uint8_t * ) sampleazureiotPROPERTY_TARGET_TEMPERATURE_TEXT,
-                                                          sizeof( sampleazureiotPROPERTY_TARGET_TEMPERATURE_TEXT ) - 1 ) )
-            {
-                xResult = AzureIoTJSONReader_NextToken( &xReader );
-                configASSERT( xResult == eAzureIoTSuccess );
-
-                /* Get desired temperature */
-                xResult = AzureIoTJSONReader_GetTokenDouble( &xReader, pxOutTemperature );
-
-                if( xResult != eAzureIoTSuccess )
-                {
-                    LogError( ( "Error getting the property version: result 0x%08x", xResult ) );
-                    break;
-                }
-
-                xResult = AzureIoTJSONReader_NextToken( &xReader );
-                configASSERT( xResult == eAzureIoTSuccess );
-            }
-            else
-            {
-                LogInfo( ( "Unknown property arrived: skipping over it." ) );
-
-                /* Unknown property arrived. We have to skip over the property and value to continue iterating. */
-                prvSkipPropertyAndValue( &xReader );
-            }
-        }
-
-        if( xResult != eAzureIoTErrorEndOfProperties )
-        {
-            LogError( ( "There was an error parsing the properties: result 0x%08x", xResult ) );
-        }
-        else
-        {
-            LogInfo( ( "Successfully parsed properties" ) );
-            xResult = eAzureIoTSuccess;
-        }
+        LogInfo( ( "Successfully parsed properties" ) );
     }
 
     return xResult;
@@ -374,17 +404,17 @@ void vHandleWritableProperties( AzureIoTHubClientPropertiesResponse_t * pxMessag
                                 uint32_t * pulWritablePropertyResponseBufferLength )
 {
     AzureIoTResult_t xResult;
-    double xIncomingTemperature;
+    ThermostatWritableProperties_t xIncomingProperties;
     uint32_t ulVersion;
     bool xWasMaxTemperatureChanged = false;
 
-    xResult = prvProcessProperties( pxMessage, eAzureIoTHubClientPropertyWritable, &xIncomingTemperature, &ulVersion );
+    xResult = prvProcessProperties( pxMessage, eAzureIoTHubClientPropertyWritable, &xIncomingProperties, &ulVersion );
 
     if( xResult == eAzureIoTSuccess )
     {
-        prvUpdateLocalProperties( xIncomingTemperature, ulVersion, &xWasMaxTemperatureChanged );
+        prvUpdateLocalProperties( xIncomingProperties.xTargetTemperature, ulVersion, &xWasMaxTemperatureChanged );
         *pulWritablePropertyResponseBufferLength = prvGenerateAckForIncomingTemperature(
-            xIncomingTemperature,
+            xIncomingProperties.xTargetTemperature,
             ulVersion,
             pucWritablePropertyResponseBuffer,
             ulWritablePropertyResponseBufferSize );
@@ -397,58 +427,88 @@ void vHandleWritableProperties( AzureIoTHubClientPropertiesResponse_t * pxMessag
 /*-----------------------------------------------------------*/
 
 /**
- * @brief Command message callback handler
+ * @brief Handler of the max min report command.
  */
-uint32_t ulHandleCommand( AzureIoTHubClientCommandRequest_t * pxMessage,
-                          uint32_t * pulResponseStatus,
-                          uint8_t * pucCommandResponsePayloadBuffer,
-                          uint32_t ulCommandResponsePayloadBufferSize )
+static uint32_t prvHandleMaxMinReportCommand( const AzureIoTHubClientCommandRequest_t * pxMessage,
+                                              uint8_t * pucResponsePayload,
+                                              uint32_t ulResponsePayloadSize,
+                                              uint32_t * pulResponsePayloadLength,
+                                              void * pvContext )
 {
     AzureIoTResult_t xResult;
     AzureIoTJSONReader_t xReader;
-    AzureIoTJSONWriter_t xWriter;
-    int32_t lCommandNameLength;
-    int32_t ulCommandResponsePayloadLength;
+    uint32_t ulResponseStatus;
 
-    LogInfo( ( "Command payload : %.*s \r\n",
-               pxMessage->ulPayloadLength,
-               ( const char * ) pxMessage->pvMessagePayload ) );
+    ( void ) pvContext;
+
+    /*Initialize the reader from which we pull the "since". */
+    xResult = AzureIoTJSONReader_Init( &xReader, pxMessage->pvMessagePayload, pxMessage->ulPayloadLength );
+    configASSERT( xResult == eAzureIoTSuccess );
 
-    lCommandNameLength = sizeof( sampleazureiotCOMMAND_MAX_MIN_REPORT ) - 1;
+    /* Read the "since" value and use it to construct the response payload. */
+    xResult = prvInvokeMaxMinCommand( &xReader, pucResponsePayload, ulResponsePayloadSize, pulResponsePayloadLength );
 
-    if( ( lCommandNameLength == pxMessage->usCommandNameLength ) &&
-        ( strncmp( sampleazureiotCOMMAND_MAX_MIN_REPORT, ( const char * ) pxMessage->pucCommandName, lCommandNameLength ) == 0 ) )
+    if( xResult == eAzureIoTSuccess )
     {
-        /* Is for max min report */
+        ulResponseStatus = AZ_IOT_STATUS_OK;
+    }
+    else
+    {
+        LogError( ( "Error generating command payload: result 0x%08x", xResult ) );
 
-        /*Initialize the reader from which we pull the "since". */
-        xResult = AzureIoTJSONReader_Init( &xReader, pxMessage->pvMessagePayload, pxMessage->ulPayloadLength );
-        configASSERT( xResult == eAzureIoTSuccess );
+        ulResponseStatus = ( xResult == eAzureIoTErrorInvalidArgument ) ? AZ_IOT_STATUS_BAD_REQUEST : 501;
+        *pulResponsePayloadLength = sizeof( sampleazureiotCOMMAND_EMPTY_PAYLOAD ) - 1;
+        configASSERT( ulResponsePayloadSize >= *pulResponsePayloadLength );
+        ( void ) memcpy( pucResponsePayload, sampleazureiotCOMMAND_EMPTY_PAYLOAD, *pulResponsePayloadLength );
+    }
 
-        /* Initialize the JSON writer with a buffer to which we will write the response payload. */
-        xResult = AzureIoTJSONWriter_Init( &xWriter, pucCommandResponsePayloadBuffer, ulCommandResponsePayloadBufferSize );
-        configASSERT( xResult == eAzureIoTSuccess );
+    return ulResponseStatus;
+}
+/*-----------------------------------------------------------*/
 
-        /* Read from the writer the "since" value and use it to construct the response payload in the writer. */
-        xResult = prvInvokeMaxMinCommand( &xReader, &xWriter );
+/**
+ * @brief Dispatcher of the commands of the device, registered on first use.
+ */
+static CommandDispatcher_t * prvGetCommandDispatcher( void )
+{
+    static CommandDispatcher_t xCommandDispatcher;
+    static bool xCommandDispatcherReady = false;
+    AzureIoTResult_t xResult;
 
-        if( xResult == eAzureIoTSuccess )
-        {
-            ulCommandResponsePayloadLength = AzureIoTJSONWriter_GetBytesUsed( &xWriter );
+    if( !xCommandDispatcherReady )
+    {
+        CommandDispatcher_Init( &xCommandDispatcher );
 
-            *pulResponseStatus = AZ_IOT_STATUS_OK;
-        }
-        else
-        {
-            LogError( ( "Error generating command payload: result 0x%08x", xResult ) );
+        xResult = CommandDispatcher_Register( &xCommandDispatcher, NULL, 0,
+                                              ( const uint8_t * ) thermostatGET_MAX_MIN_REPORT_NAME,
+                                              sizeof( thermostatGET_MAX_MIN_REPORT_NAME ) - 1,
+                                              prvHandleMaxMinReportCommand, NULL );
+        configASSERT( xResult == eAzureIoTSuccess );
 
-            *pulResponseStatus = 501;
-            ulCommandResponsePayloadLength = sizeof( sampleazureiotCOMMAND_EMPTY_PAYLOAD ) - 1;
-            configASSERT( ulCommandResponsePayloadBufferSize >= ulCommandResponsePayloadLength );
-            ( void ) memcpy( pucCommandResponsePayloadBuffer, sampleazureiotCOMMAND_EMPTY_PAYLOAD, ulCommandResponsePayloadLength );
-        }
+        xCommandDispatcherReady = true;
     }
-    else
+
+    return &xCommandDispatcher;
+}
+/*-----------------------------------------------------------*/
+
+/**
+ * @brief Command message callback handler
+ */
+uint32_t ulHandleCommand( AzureIoTHubClientCommandRequest_t * pxMessage,
+                          uint32_t * pulResponseStatus,
+                          uint8_t * pucCommandResponsePayloadBuffer,
+                          uint32_t ulCommandResponsePayloadBufferSize )
+{
+    uint32_t ulCommandResponsePayloadLength;
+
+    LogInfo( ( "Command payload : %.*s \r\n",
+               pxMessage->ulPayloadLength,
+               ( const char * ) pxMessage->pvMessagePayload ) );
+
+    if( CommandDispatcher_Dispatch( prvGetCommandDispatcher(), pxMessage,
+                                    pucCommandResponsePayloadBuffer, ulCommandResponsePayloadBufferSize,
+                                    pulResponseStatus, &ulCommandResponsePayloadLength ) != eAzureIoTSuccess )
     {
         /* Not for max min report (not for this device) */
         LogInfo( ( "Received command is not for this device: %.*s",
@@ -465,27 +525,203 @@ uint32_t ulHandleCommand( AzureIoTHubClientCommandRequest_t * pxMessage,
 }
 /*-----------------------------------------------------------*/
 
+#ifdef democonfigTELEMETRY_SERIES_LENGTH
+
+/**
+ * @brief Add the current temperature to the series, and provide the series once complete.
+ */
+    static uint32_t prvAppendTelemetrySeries( uint64_t ullTime,
+                                              uint8_t * pucTelemetryData,
+                                              uint32_t ulTelemetryDataSize,
+                                              uint32_t * pulTelemetryDataLength,
+                                              AzureIoTMessageProperties_t ** ppxTelemetryProperties )
+    {
+        AzureIoTResult_t xResult;
+        bool xSuccess;
+        uint32_t ulLength;
+
+        if( !xTemperatureSeriesReady )
+        {
+            xResult = AzureIoTMessage_PropertiesInit( &xTemperatureSeriesProperties, ucTemperatureSeriesPropertiesBuffer,
+                                                      0, sizeof( ucTemperatureSeriesPropertiesBuffer ) );
+            configASSERT( xResult == eAzureIoTSuccess );
+
+            xResult = AzureIoTMessage_PropertiesAppend( &xTemperatureSeriesProperties,
+                                                        ( const uint8_t * ) "$.ct", sizeof( "$.ct" ) - 1,
+                                                        ( const uint8_t * ) sampleazureiotSERIES_CONTENT_TYPE,
+                                                        sizeof( sampleazureiotSERIES_CONTENT_TYPE ) - 1 );
+            configASSERT( xResult == eAzureIoTSuccess );
+
+            xResult = AzureIoTMessage_PropertiesAppend( &xTemperatureSeriesProperties,
+                                                        ( const uint8_t * ) "$.ce", sizeof( "$.ce" ) - 1,
+                                                        ( const uint8_t * ) sampleazureiotSERIES_CONTENT_ENCODING,
+                                                        sizeof( sampleazureiotSERIES_CONTENT_ENCODING ) - 1 );
+            configASSERT( xResult == eAzureIoTSuccess );
+
+            xSuccess = GorillaSeries_EncoderInit( &xTemperatureSeries, &xTemperatureSeriesSignal, 1,
+                                                  ucTemperatureSeriesBuffer, sizeof( ucTemperatureSeriesBuffer ) );
+            configASSERT( xSuccess );
+
+            xTemperatureSeriesReady = true;
+        }
+
+        *pulTelemetryDataLength = 0;
+
+        /* The buffer is sized for a complete series, so every reading fits. */
+        xSuccess = GorillaSeries_Append( &xTemperatureSeries, ullTime, &xDeviceCurrentTemperature );
+        configASSERT( xSuccess );
+
+        if( GorillaSeries_RecordCount( &xTemperatureSeries ) < democonfigTELEMETRY_SERIES_LENGTH )
+        {
+            return 0;
+        }
+
+        ulLength = GorillaSeries_Length( &xTemperatureSeries );
+
+        if( ulLength <= ulTelemetryDataSize )
+        {
+            ( void ) memcpy( pucTelemetryData, ucTemperatureSeriesBuffer, ulLength );
+            *pulTelemetryDataLength = ulLength;
+            *ppxTelemetryProperties = &xTemperatureSeriesProperties;
+        }
+
+        /* Start the next series, even if this one could not be provided. */
+        xSuccess = GorillaSeries_EncoderInit( &xTemperatureSeries, &xTemperatureSeriesSignal, 1,
+                                              ucTemperatureSeriesBuffer, sizeof( ucTemperatureSeriesBuffer ) );
+        configASSERT( xSuccess );
+
+        return ( *pulTelemetryDataLength != 0 ) ? 0 : 1;
+    }
+/*-----------------------------------------------------------*/
+#endif /* democonfigTELEMETRY_SERIES_LENGTH */
+
+#if defined( democonfigTELEMETRY_CBOR ) && !defined( democonfigTELEMETRY_SERIES_LENGTH )
+
+/**
+ * @brief Write the current temperature as a CBOR map, the same shape as the JSON message.
+ *
+ * The temperature is sent as a single precision float, which holds the
+ * hundredths the JSON message carries in 5 bytes.
+ */
+    static uint32_t prvCreateCborTelemetry( uint8_t * pucTelemetryData,
+                                            uint32_t ulTelemetryDataSize,
+                                            uint32_t * pulTelemetryDataLength,
+                                            AzureIoTMessageProperties_t ** ppxTelemetryProperties )
+    {
+        AzureIoTResult_t xResult;
+        CBORWriter_t xWriter;
+
+        if( !xCborTelemetryPropertiesReady )
+        {
+            xResult = AzureIoTMessage_PropertiesInit( &xCborTelemetryProperties, ucCborTelemetryPropertiesBuffer,
+                                                      0, sizeof( ucCborTelemetryPropertiesBuffer ) );
+            configASSERT( xResult == eAzureIoTSuccess );
+
+            xResult = AzureIoTMessage_PropertiesAppend( &xCborTelemetryProperties,
+                                                        ( const uint8_t * ) "$.ct", sizeof( "$.ct" ) - 1,
+                                                        ( const uint8_t * ) sampleazureiotCBOR_CONTENT_TYPE,
+                                                        sizeof( sampleazureiotCBOR_CONTENT_TYPE ) - 1 );
+            configASSERT( xResult == eAzureIoTSuccess );
+
+            xCborTelemetryPropertiesReady = true;
+        }
+
+        if( ( CBORWriter_Init( &xWriter, pucTelemetryData, ulTelemetryDataSize ) != eAzureIoTSuccess ) ||
+            ( CBORWriter_AppendBeginMap( &xWriter, 1 ) != eAzureIoTSuccess ) ||
+            ( CBORWriter_AppendText( &xWriter, ( const uint8_t * ) thermostatTEMPERATURE_NAME,
+                                     sizeof( thermostatTEMPERATURE_NAME ) - 1 ) != eAzureIoTSuccess ) ||
+            ( CBORWriter_AppendFloat( &xWriter, ( float ) xDeviceCurrentTemperature ) != eAzureIoTSuccess ) ||
+            ( CBORWriter_AppendEndMap( &xWriter ) != eAzureIoTSuccess ) )
+        {
+            return 1;
+        }
+
+        *pulTelemetryDataLength = CBORWriter_GetBytesUsed( &xWriter );
+        *ppxTelemetryProperties = &xCborTelemetryProperties;
+
+        return 0;
+    }
+/*-----------------------------------------------------------*/
+#endif /* democonfigTELEMETRY_CBOR && !democonfigTELEMETRY_SERIES_LENGTH */
+
+#if !defined( democonfigTELEMETRY_SERIES_LENGTH ) && !defined( democonfigTELEMETRY_CBOR )
+
+/**
+ * @brief Write the current temperature as a JSON message.
+ */
+    static uint32_t prvCreateJsonTelemetry( uint8_t * pucTelemetryData,
+                                            uint32_t ulTelemetryDataSize,
+                                            uint32_t * pulTelemetryDataLength )
+    {
+        uint32_t ulLength = sizeof( sampleazureiotMESSAGE_PREFIX ) - 1;
+        uint32_t ulValueLength;
+
+        if( ulTelemetryDataSize <= ulLength )
+        {
+            return 1;
+        }
+
+        ( void ) memcpy( pucTelemetryData, sampleazureiotMESSAGE_PREFIX, ulLength );
+
+        ulValueLength = DoubleFormat_Fixed( xDeviceCurrentTemperature, sampleazureiotDOUBLE_DECIMAL_PLACE_DIGITS,
+                                            pucTelemetryData + ulLength, ulTelemetryDataSize - ulLength );
+        ulLength += ulValueLength;
+
+        /* Keep room for the NULL terminator snprintf used to write. */
+        if( ( ulValueLength == 0 ) ||
+            ( ( ulTelemetryDataSize - ulLength ) <= ( sizeof( sampleazureiotMESSAGE_SUFFIX ) - 1 ) ) )
+        {
+            return 1;
+        }
+
+        ( void ) memcpy( pucTelemetryData + ulLength, sampleazureiotMESSAGE_SUFFIX, sizeof( sampleazureiotMESSAGE_SUFFIX ) );
+        *pulTelemetryDataLength = ulLength + sizeof( sampleazureiotMESSAGE_SUFFIX ) - 1;
+
+        return 0;
+    }
+/*-----------------------------------------------------------*/
+#endif /* !democonfigTELEMETRY_SERIES_LENGTH && !democonfigTELEMETRY_CBOR */
+
 /**
  * @brief Implements the sample interface for generating Telemetry payload.
+ *
+ * The payload is empty when the temperature is within the dead-band of the one last sent.
+ * Readings that pass the dead-band, or are due for a heartbeat, are then encoded:
+ * with democonfigTELEMETRY_SERIES_LENGTH defined, into a series whose payload
+ * is empty until the series is complete; with democonfigTELEMETRY_CBOR defined,
+ * in CBOR; otherwise in JSON.
  */
 uint32_t ulCreateTelemetry( uint8_t * pucTelemetryData,
                             uint32_t ulTelemetryDataSize,
-                            uint32_t * ulTelemetryDataLength )
+                            uint32_t * ulTelemetryDataLength,
+                            AzureIoTMessageProperties_t ** ppxTelemetryProperties )
 {
-    int result = snprintf( ( char * ) pucTelemetryData, ulTelemetryDataSize,
-                           sampleazureiotMESSAGE, xDeviceCurrentTemperature );
+    uint64_t ullNow = ullGetUnixTime();
 
-    if( ( result >= 0 ) && ( result < ulTelemetryDataSize ) )
+    ReadingHistory_Add( &xTemperatureHistory, ullNow, xDeviceCurrentTemperature );
+    *ppxTelemetryProperties = NULL;
+    *ulTelemetryDataLength = 0;
+
+    if( !xTemperatureFilterReady )
     {
-        *ulTelemetryDataLength = result;
-        result = 0;
+        ReportFilter_Init( &xTemperatureFilter, &xTemperatureReportRule, &xTemperatureReport, 1 );
+        xTemperatureFilterReady = true;
     }
-    else
+
+    if( !ReportFilter_Update( &xTemperatureFilter, 0, ullNow, xDeviceCurrentTemperature ) )
     {
-        result = 1;
+        return 0;
     }
 
-    return result;
+    #if defined( democonfigTELEMETRY_SERIES_LENGTH )
+        return prvAppendTelemetrySeries( ullNow, pucTelemetryData, ulTelemetryDataSize,
+                                         ulTelemetryDataLength, ppxTelemetryProperties );
+    #elif defined( democonfigTELEMETRY_CBOR )
+        return prvCreateCborTelemetry( pucTelemetryData, ulTelemetryDataSize,
+                                       ulTelemetryDataLength, ppxTelemetryProperties );
+    #else
+        return prvCreateJsonTelemetry( pucTelemetryData, ulTelemetryDataSize, ulTelemetryDataLength );
+    #endif
 }
 /*-----------------------------------------------------------*/
 
@@ -0,0 +1,525 @@
+#!/usr/bin/env python3
+# Copyright (c) Microsoft Corporation. All rights reserved.
+# SPDX-License-Identifier: MIT
+
+"""Generate C serializers from a DTDL v2 interface.
+
+For an interface such as dtmi:com:example:Thermostat;1 this writes
+thermostat_model.h and thermostat_model.c, holding:
+
+- the model id and the name of every telemetry, property, command and
+  command response field as string literals, so their lengths are sizeof
+  constants;
+- one struct per group of values (telemetry, reported properties, writable
+  properties, command responses);
+- serialize functions made of straight-line AzureIoTJSONWriter calls, and a
+  parse function for writable properties;
+- the worst-case size of every serialized payload, counting what the JSON
+  writer asks to be free before each append, so a buffer of that size can
+  never run out of space.
+
+Contents whose schema is not a primitive supported by the middleware JSON
+writer and reader are skipped with a warning.
+
+The path of the generated source is printed on stdout.
+
+Usage: dtdl_codegen.py <model.json> <output directory>
+"""
+
+import json
+import os
+import re
+import sys
+
+# Space the JSON writer requires before appending a value, from az_json_writer.c.
+MAX_SIZE_FOR_WRITING_DOUBLE = 24
+MAX_SIZE_FOR_INT32 = 11
+MAX_EXPANSION_FACTOR_WHILE_ESCAPING = 6
+
+STRING_SCHEMAS = ("string", "dateTime", "date", "time", "duration")
+
+
+class Field:
+    """A named primitive value of the model."""
+
+    def __init__(self, name, schema):
+        self.name = name
+        self.schema = "double" if schema == "float" else schema
+        self.is_string = self.schema in STRING_SCHEMAS
+
+    @property
+    def upper(self):
+        return re.sub(r"(?<=[a-z0-9])([A-Z])", r"_\1", self.name).upper()
+
+    @property
+    def pascal(self):
+        return self.name[0].upper() + self.name[1:]
+
+    def member(self, writable):
+        """C declaration(s) of the struct member(s) holding the value."""
+        if self.is_string:
+            if writable:
+                return ["uint8_t uc%s[ {prefix}STRING_MAX_LENGTH ];" % self.pascal,
+                        "uint32_t ul%sLength;" % self.pascal]
+
+            return ["const uint8_t * puc%s;" % self.pascal,
+                    "uint32_t ul%sLength;" % self.pascal]
+
+        return {
+            "double": ["double x%s;" % self.pascal],
+            "integer": ["int32_t l%s;" % self.pascal],
+            "boolean": ["bool x%s;" % self.pascal],
+        }[self.schema]
+
+    def value_demand(self):
+        """Space the writer asks for to append the value, None for strings."""
+        if self.is_string:
+            return None
+
+        return str({
+            "double": MAX_SIZE_FOR_WRITING_DOUBLE,
+            "integer": MAX_SIZE_FOR_INT32,
+            "boolean": len("false"),
+        }[self.schema])
+
+    def name_demand(self):
+        """Space the writer asks for to append the name: comma, quotes, colon."""
+        return MAX_EXPANSION_FACTOR_WHILE_ESCAPING * len(self.name) + 4
+
+    def append(self, pointer):
+        """C statement appending the value, read through @p pointer."""
+        if self.is_string:
+            return ("AzureIoTJSONWriter_AppendString( pxWriter, %s->puc%s, %s->ul%sLength );"
+                    % (pointer, self.pascal, pointer, self.pascal))
+
+        return {
+            "double": "AzureIoTJSONWriter_AppendDouble( pxWriter, %s->x%s, {prefix}DOUBLE_FRACTIONAL_DIGITS );",
+            "integer": "AzureIoTJSONWriter_AppendInt32( pxWriter, %s->l%s );",
+            "boolean": "AzureIoTJSONWriter_AppendBool( pxWriter, %s->x%s );",
+        }[self.schema] % (pointer, self.pascal)
+
+    def read(self):
+        """C statement reading the value into pxProperties."""
+        if self.is_string:
+            return ("AzureIoTJSONReader_GetTokenString( pxReader, pxProperties->uc%s, "
+                    "sizeof( pxProperties->uc%s ), &pxProperties->ul%sLength );"
+                    % (self.pascal, self.pascal, self.pascal))
+
+        return {
+            "double": "AzureIoTJSONReader_GetTokenDouble( pxReader, &pxProperties->x%s );",
+            "integer": "AzureIoTJSONReader_GetTokenInt32( pxReader, &pxProperties->l%s );",
+            "boolean": "AzureIoTJSONReader_GetTokenBool( pxReader, &pxProperties->x%s );",
+        }[self.schema] % self.pascal
+
+
+class Model:
+    """The parts of a DTDL interface the generator knows how to serialize."""
+
+    def __init__(self, path):
+        with open(path, encoding="utf-8") as model_file:
+            document = json.load(model_file)
+
+        self.source = os.path.basename(path)
+        self.id = document["@id"]
+        self.name = re.match(r"dtmi:(?:[A-Za-z0-9_]+:)*([A-Za-z0-9_]+);\d+$", self.id).group(1)
+        self.prefix = self.name.lower()
+        self.file = re.sub(r"(?<=[a-z0-9])([A-Z])", r"_\1", self.name).lower() + "_model"
+        self.telemetry = []
+        self.reported = []
+        self.writable = []
+        self.commands = []
+
+        for content in document.get("contents", []):
+            types = content["@type"]
+            types = [types] if isinstance(types, str) else types
+
+            if "Command" in types:
+                self.commands.append(self._command(content))
+            elif self._supported(content):
+                field = Field(content["name"], content["schema"])
+
+                if "Telemetry" in types:
+                    self.telemetry.append(field)
+                elif content.get("writable", False):
+                    self.writable.append(field)
+                else:
+                    self.reported.append(field)
+
+    def _supported(self, content):
+        schema = content.get("schema")
+
+        if isinstance(schema, str) and (schema in ("double", "float", "integer", "boolean") or
+                                        schema in STRING_SCHEMAS):
+            return True
+
+        print("%s: skipping '%s', schema %s is not supported" %
+              (self.source, content.get("name"), json.dumps(schema)), file=sys.stderr)
+
+        return False
+
+    def _command(self, content):
+        fields = []
+        response = content.get("response")
+
+        if response is not None and isinstance(response["schema"], dict) and \
+                response["schema"].get("@type") == "Object":
+            fields = [Field(field["name"], field["schema"])
+                      for field in response["schema"]["fields"] if self._supported(field)]
+        elif response is not None:
+            print("%s: no serializer for the response of '%s', only objects are supported" %
+                  (self.source, content["name"]), file=sys.stderr)
+
+        command = Field(content["name"], "string")
+        command.fields = fields
+
+        return command
+
+
+def comment(lines, text):
+    lines.append("/**")
+    lines.extend((" * " + line).rstrip() for line in text.split("\n"))
+    lines.append(" */")
+
+
+def define(name, value):
+    return "#define %s%s( %s )" % (name, " " * max(1, 56 - len(name)), value) \
+        if not value.startswith("\"") else "#define %s%s%s" % (name, " " * max(1, 56 - len(name)), value)
+
+
+def demand(fields, object_braces):
+    """Sum of what the writer asks to be free for every append, as a C expression."""
+    constant = 2 if object_braces else 0
+    strings = 0
+
+    for field in fields:
+        constant += field.name_demand()
+
+        if field.is_string:
+            strings += 1
+        else:
+            constant += int(field.value_demand())
+
+    if strings == 0:
+        return "%dU" % constant
+
+    return "%dU + %d * ( %d * {prefix}STRING_MAX_LENGTH + 2U )" % (
+        constant, strings, MAX_EXPANSION_FACTOR_WHILE_ESCAPING)
+
+
+def signature(returns, name, parameters):
+    head = "%s %s( " % (returns, name)
+    indent = " " * len(head)
+
+    return head + (",\n" + indent).join(parameters) + " )"
+
+
+def statements(lines, calls):
+    """Chain of writer calls, each run only if the previous ones succeeded."""
+    for index, call in enumerate(calls):
+        if index == 0:
+            lines.append("    xResult = %s" % call)
+        else:
+            lines.extend(["",
+                          "    if( xResult == eAzureIoTSuccess )",
+                          "    {",
+                          "        xResult = %s" % call,
+                          "    }"])
+
+
+def name_arguments(model, field, prefix=""):
+    macro = "%s%s%s_NAME" % (model.prefix, prefix, field.upper)
+
+    return "( const uint8_t * ) %s, sizeof( %s ) - 1" % (macro, macro)
+
+
+def string_checks(lines, model, fields, pointer):
+    strings = [field for field in fields if field.is_string]
+
+    if strings:
+        lines.append("    if( %s )" % (" ||\n        ".join(
+            "( %s->ul%sLength > %sSTRING_MAX_LENGTH )" % (pointer, field.pascal, model.prefix)
+            for field in strings)))
+        lines.extend(["    {", "        return eAzureIoTErrorInvalidArgument;", "    }", ""])
+
+
+def object_body(model, fields, pointer, prefix=""):
+    calls = []
+
+    for field in fields:
+        calls.append("AzureIoTJSONWriter_AppendPropertyName( pxWriter, %s );" %
+                     name_arguments(model, field, prefix))
+        calls.append(field.append(pointer).replace("{prefix}", model.prefix))
+
+    return calls
+
+
+def header(model):
+    guard = model.file.upper() + "_H"
+    lines = ["/* Copyright (c) Microsoft Corporation.",
+             " * Licensed under the MIT License. */",
+             ""]
+
+    comment(lines, "@file %s.h\n@brief Serializers of %s.\n\n"
+                   "Generated by tools/dtdl_codegen.py from %s, do not edit." %
+            (model.file, model.id, model.source))
+
+    lines += ["",
+              "#ifndef " + guard,
+              "#define " + guard,
+              "",
+              "#include <stdbool.h>",
+              "#include <stdint.h>",
+              "",
+              "#include \"azure_iot_json_reader.h\"",
+              "#include \"azure_iot_json_writer.h\"",
+              ""]
+
+    comment(lines, "@brief Model id of the interface.")
+    lines += [define(model.prefix + "MODEL_ID", "\"%s\"" % model.id), ""]
+
+    comment(lines, "@brief Longest string value, without the escaping.")
+    lines += ["#ifndef %sSTRING_MAX_LENGTH" % model.prefix,
+              "    " + define(model.prefix + "STRING_MAX_LENGTH", "64U"),
+              "#endif",
+              ""]
+
+    comment(lines, "@brief Digits after the decimal point of double values.")
+    lines += ["#ifndef %sDOUBLE_FRACTIONAL_DIGITS" % model.prefix,
+              "    " + define(model.prefix + "DOUBLE_FRACTIONAL_DIGITS", "2U"),
+              "#endif",
+              ""]
+
+    comment(lines, "@brief Names of the telemetry, properties and commands.")
+
+    for field in model.telemetry + model.reported + model.writable + model.commands:
+        lines.append(define("%s%s_NAME" % (model.prefix, field.upper), "\"%s\"" % field.name))
+
+    for command in model.commands:
+        for field in command.fields:
+            lines.append(define("%s%s_%s_NAME" % (model.prefix, command.upper, field.upper),
+                                "\"%s\"" % field.name))
+
+    lines.append("")
+
+    def struct(type_name, brief, fields, writable):
+        comment(lines, "@brief " + brief)
+        lines.append("typedef struct %s" % type_name)
+        lines.append("{")
+
+        for field in fields:
+            for member in field.member(writable):
+                lines.append("    " + member.replace("{prefix}", model.prefix))
+
+        lines.extend(["} %s_t;" % type_name, ""])
+
+    if model.telemetry:
+        struct(model.name + "Telemetry", "Telemetry of the interface, sent in one message.",
+               model.telemetry, False)
+        comment(lines, "@brief Size of a buffer always large enough for the telemetry message.")
+        lines += [define(model.prefix + "TELEMETRY_MAX_LENGTH", demand(model.telemetry, True)
+                         .replace("{prefix}", model.prefix)), ""]
+
+    if model.reported:
+        struct(model.name + "ReportedProperties", "Read-only properties of the interface.",
+               model.reported, False)
+        comment(lines, "@brief Space the reported properties take in a document, at most.")
+        lines += [define(model.prefix + "REPORTED_PROPERTIES_MAX_LENGTH", demand(model.reported, False)
+                         .replace("{prefix}", model.prefix)), ""]
+
+    if model.writable:
+        struct(model.name + "WritableProperties", "Writable properties of the interface.",
+               model.writable, True)
+        comment(lines, "@brief Flags of the writable properties, set by %s_ParseWritableProperty()."
+                % model.name)
+
+        for index, field in enumerate(model.writable):
+            lines.append(define("%s%s_FLAG" % (model.prefix, field.upper), "1U << %d" % index))
+
+        lines.append("")
+
+    for command in model.commands:
+        if command.fields:
+            struct("%s%sResponse" % (model.name, command.pascal),
+                   "Response payload of the %s command." % command.name, command.fields, False)
+            comment(lines, "@brief Size of a buffer always large enough for the %s response."
+                    % command.name)
+            lines += [define("%s%s_RESPONSE_MAX_LENGTH" % (model.prefix, command.upper),
+                             demand(command.fields, True).replace("{prefix}", model.prefix)), ""]
+
+    for prototype, doc in prototypes(model):
+        comment(lines, doc)
+        lines += [prototype + ";", ""]
+
+    lines += ["#endif /* %s */" % guard]
+
+    return "\n".join(lines) + "\n"
+
+
+def prototypes(model):
+    result = []
+
+    if model.telemetry:
+        result.append((signature("AzureIoTResult_t", model.name + "_SerializeTelemetry",
+                                 ["const %sTelemetry_t * pxTelemetry" % model.name,
+                                  "uint8_t * pucBuffer",
+                                  "uint32_t ulBufferSize",
+                                  "uint32_t * pulLength"]),
+                       "@brief Write the telemetry message.\n\n"
+                       "@param[in] pxTelemetry The telemetry.\n"
+                       "@param[out] pucBuffer Buffer receiving the message, #%sTELEMETRY_MAX_LENGTH long\n"
+                       "            is always enough.\n"
+                       "@param[in] ulBufferSize Size of @p pucBuffer.\n"
+                       "@param[out] pulLength Length of the message.\n"
+                       "@return An #AzureIoTResult_t with the result of the operation." % model.prefix))
+
+    if model.reported:
+        result.append((signature("AzureIoTResult_t", model.name + "_AppendReportedProperties",
+                                 ["AzureIoTJSONWriter_t * pxWriter",
+                                  "const %sReportedProperties_t * pxProperties" % model.name]),
+                       "@brief Append the read-only properties to the object, or component, open in a writer.\n\n"
+                       "@param[in] pxWriter The writer.\n"
+                       "@param[in] pxProperties The properties.\n"
+                       "@return An #AzureIoTResult_t with the result of the operation."))
+
+    if model.writable:
+        result.append((signature("AzureIoTResult_t", model.name + "_ParseWritableProperty",
+                                 ["AzureIoTJSONReader_t * pxReader",
+                                  "%sWritableProperties_t * pxProperties" % model.name,
+                                  "uint32_t * pulFlags"]),
+                       "@brief Read the value of a writable property.\n\n"
+                       "@param[in] pxReader Reader on the property name, left on the value when it is read.\n"
+                       "@param[out] pxProperties The properties, only the one read is written.\n"
+                       "@param[in,out] pulFlags The flag of the property read is set.\n"
+                       "@return An #AzureIoTResult_t with the result of the operation.\n"
+                       "        - `eAzureIoTErrorItemNotFound` if the name is not a writable property\n"
+                       "          of the interface, the reader is left on the name."))
+
+    for command in model.commands:
+        if command.fields:
+            result.append((signature("AzureIoTResult_t",
+                                     "%s_Serialize%sResponse" % (model.name, command.pascal),
+                                     ["const %s%sResponse_t * pxResponse" % (model.name, command.pascal),
+                                      "uint8_t * pucBuffer",
+                                      "uint32_t ulBufferSize",
+                                      "uint32_t * pulLength"]),
+                           "@brief Write the response payload of the %s command.\n\n"
+                           "@param[in] pxResponse The response.\n"
+                           "@param[out] pucBuffer Buffer receiving the payload, #%s%s_RESPONSE_MAX_LENGTH\n"
+                           "            long is always enough.\n"
+                           "@param[in] ulBufferSize Size of @p pucBuffer.\n"
+                           "@param[out] pulLength Length of the payload.\n"
+                           "@return An #AzureIoTResult_t with the result of the operation."
+                           % (command.name, model.prefix, command.upper)))
+
+    return result
+
+
+def serialize_object(lines, model, fields, pointer, prefix=""):
+    lines += ["    AzureIoTResult_t xResult;",
+              "    AzureIoTJSONWriter_t xWriter;",
+              "    AzureIoTJSONWriter_t * pxWriter = &xWriter;",
+              ""]
+    string_checks(lines, model, fields, pointer)
+    statements(lines, ["AzureIoTJSONWriter_Init( pxWriter, pucBuffer, ulBufferSize );",
+                       "AzureIoTJSONWriter_AppendBeginObject( pxWriter );"] +
+               object_body(model, fields, pointer, prefix) +
+               ["AzureIoTJSONWriter_AppendEndObject( pxWriter );"])
+    lines += ["",
+              "    if( xResult == eAzureIoTSuccess )",
+              "    {",
+              "        *pulLength = ( uint32_t ) AzureIoTJSONWriter_GetBytesUsed( pxWriter );",
+              "    }",
+              "",
+              "    return xResult;"]
+
+
+def source(model):
+    lines = ["/* Copyright (c) Microsoft Corporation.",
+             " * Licensed under the MIT License. */",
+             "",
+             "/* Generated by tools/dtdl_codegen.py from %s, do not edit. */" % model.source,
+             "",
+             "#include \"%s.h\"" % model.file,
+             "",
+             "/*-----------------------------------------------------------*/"]
+    bodies = []
+
+    if model.telemetry:
+        body = []
+        serialize_object(body, model, model.telemetry, "pxTelemetry")
+        bodies.append(body)
+
+    if model.reported:
+        body = ["    AzureIoTResult_t xResult;", ""]
+        string_checks(body, model, model.reported, "pxProperties")
+        statements(body, object_body(model, model.reported, "pxProperties"))
+        body += ["", "    return xResult;"]
+        bodies.append(body)
+
+    if model.writable:
+        body = ["    AzureIoTResult_t xResult;", ""]
+
+        for field in model.writable:
+            body += ["    if( AzureIoTJSONReader_TokenIsTextEqual( pxReader, %s ) )" %
+                     name_arguments(model, field),
+                     "    {",
+                     "        xResult = AzureIoTJSONReader_NextToken( pxReader );",
+                     "",
+                     "        if( xResult == eAzureIoTSuccess )",
+                     "        {",
+                     "            xResult = %s" % field.read(),
+                     "        }",
+                     "",
+                     "        if( xResult == eAzureIoTSuccess )",
+                     "        {",
+                     "            *pulFlags |= %s%s_FLAG;" % (model.prefix, field.upper),
+                     "        }",
+                     "",
+                     "        return xResult;",
+                     "    }",
+                     ""]
+
+        body += ["    return eAzureIoTErrorItemNotFound;"]
+        bodies.append(body)
+
+    for command in model.commands:
+        if command.fields:
+            body = []
+            serialize_object(body, model, command.fields, "pxResponse", command.upper + "_")
+            bodies.append(body)
+
+    for (prototype, _), body in zip(prototypes(model), bodies):
+        lines += ["", prototype, "{"] + body + ["}", "/*-----------------------------------------------------------*/"]
+
+    return "\n".join(lines) + "\n"
+
+
+def write_if_changed(path, text):
+    """Leave unchanged outputs alone, so their dependents are not rebuilt."""
+    if os.path.exists(path):
+        with open(path, encoding="utf-8") as existing:
+            if existing.read() == text:
+                return
+
+    with open(path, "w", encoding="utf-8", newline="\n") as output:
+        output.write(text)
+
+
+def main(argv):
+    if len(argv) != 3:
+        print(__doc__.strip().split("\n")[-1], file=sys.stderr)
+        return 2
+
+    model = Model(argv[1])
+    os.makedirs(argv[2], exist_ok=True)
+    write_if_changed(os.path.join(argv[2], model.file + ".h"), header(model))
+    write_if_changed(os.path.join(argv[2], model.file + ".c"), source(model))
+
+    # The build picks the generated source up from here.
+    print(os.path.join(argv[2], model.file + ".c").replace(os.sep, "/"))
+
+    return 0
+
+
+if __name__ == "__main__":
+    sys.exit(main(sys.argv))
@@ -0,0 +1,127 @@
+#!/usr/bin/env python3
+# Copyright (c) Microsoft Corporation. All rights reserved.
+# SPDX-License-Identifier: MIT
+
+"""Decode a Gorilla series written by demos/common/utilities/gorilla_series.c.
+
+Devices send a series as a telemetry message with the content type
+application/x-gorilla-series. The layout is described in gorilla_series.h.
+This decoder is the reference for cloud-side consumers. It prints one CSV
+line per record: the timestamp, then the value of each signal.
+
+Usage: gorilla_decode.py <series file, or - for stdin>
+"""
+
+import struct
+import sys
+
+VERSION = 1
+HEADER_LENGTH = 4
+
+# Width and offset of the delta of delta, by number of leading ones of its prefix.
+DELTA_OF_DELTA = {1: (7, 63), 2: (9, 255), 3: (12, 2047), 4: (64, 0)}
+
+
+class BitReader:
+    def __init__(self, data, offset):
+        self.data = data
+        self.offset = offset
+
+    def read(self, count):
+        if self.offset + count > len(self.data) * 8:
+            raise ValueError("series truncated at bit %d" % self.offset)
+
+        value = 0
+
+        for _ in range(count):
+            byte = self.data[self.offset // 8]
+            value = (value << 1) | ((byte >> (7 - self.offset % 8)) & 1)
+            self.offset += 1
+
+        return value
+
+
+def signed64(value):
+    return value - (1 << 64) if value & (1 << 63) else value
+
+
+def to_double(bits):
+    return struct.unpack(">d", struct.pack(">Q", bits))[0]
+
+
+def decode(data):
+    """Return the list of (timestamp, [values]) records of a series."""
+    if len(data) < HEADER_LENGTH or data[0] != VERSION or data[1] == 0:
+        raise ValueError("not a version %d series" % VERSION)
+
+    signal_count = data[1]
+    record_count = (data[2] << 8) | data[3]
+    reader = BitReader(data, HEADER_LENGTH * 8)
+    last_bits = [0] * signal_count
+    windows = [None] * signal_count
+    records = []
+    time = 0
+    delta = 0
+
+    for index in range(record_count):
+        if index == 0:
+            time = reader.read(64)
+        else:
+            ones = 0
+
+            while ones < 4 and reader.read(1) == 1:
+                ones += 1
+
+            if ones > 0:
+                width, offset = DELTA_OF_DELTA[ones]
+                value = reader.read(width)
+                delta += signed64(value) if width == 64 else value - offset
+
+            time = (time + delta) & ((1 << 64) - 1)
+
+        values = []
+
+        for signal in range(signal_count):
+            if index == 0:
+                last_bits[signal] = reader.read(64)
+            elif reader.read(1) == 1:
+                if reader.read(1) == 1:
+                    leading = reader.read(5)
+                    meaningful = reader.read(6) or 64
+
+                    if leading + meaningful > 64:
+                        raise ValueError("invalid value window")
+
+                    windows[signal] = (leading, meaningful)
+                elif windows[signal] is None:
+                    raise ValueError("value reuses a window before any was set")
+
+                leading, meaningful = windows[signal]
+                last_bits[signal] ^= reader.read(meaningful) << (64 - leading - meaningful)
+
+            values.append(to_double(last_bits[signal]))
+
+        records.append((time, values))
+
+    return records
+
+
+def main(argv):
+    if len(argv) != 2:
+        print(__doc__.strip().split("\n")[-1], file=sys.stderr)
+        return 2
+
+    if argv[1] == "-":
+        data = sys.stdin.buffer.read()
+    else:
+        with open(argv[1], "rb") as file:
+            data = file.read()
+
+    for time, values in decode(data):
+        print(",".join([str(time)] + [repr(value) for value in values]))
+
+    return 0
+
+
+if __name__ == "__main__":
+    sys.exit(main(sys.argv))